@@ -86,6 +86,8 @@
 #define INCLUDE_RTC
 
 #define INCLUDE_SIGNALS
+#define LPC24_SIGNALS_CAPTURE_PINS { /*TIMER0*/{ PIN(1, 26), PF(3) }, { PIN(1, 27), PF(3) }, /*TIMER1*/{ PIN(1, 18), PF(3) }, { PIN(1, 19), PF(3) }, /*TIMER2*/{ PIN(0, 4), PF(3) }, { PIN(0, 5), PF(3) }, /*TIMER3*/{ PIN(0, 23), PF(3) }, { PIN(0, 24), PF(3) } }
+#define LPC24_SIGNALS_GENERATOR_PINS { /*TIMER0*/{ PIN(1, 28), PF(3) }, { PIN(1, 29), PF(3) }, /*TIMER1*/{ PIN(1, 22), PF(3) }, { PIN(1, 25), PF(3) }, /*TIMER2*/{ PIN(0, 6), PF(3) }, { PIN(0, 7), PF(3) }, /*TIMER3*/{ PIN(0, 10), PF(3) }, { PIN(0, 11), PF(3) } }
 
 #define INCLUDE_SPI
 #define TOTAL_SPI_CONTROLLERS 2
@@ -122,6 +124,7 @@
 #define LPC24_USB_ENDPOINT0_SIZE 64
 #define LPC24_USB_ENDPOINT_COUNT 16
 #define LPC24_USB_PIPE_COUNT 16
+#define USB_CDC_NOTIFICATION_ENDPOINT 4
 
 #define LPC2468_PARTID                      0x1600FF35
 
@@ -67,6 +67,9 @@
 #define LPC17_DEPLOYMENT_SPI_PORT 1
 #define LPC17_DEPLOYMENT_SPI_ENABLE_PIN PIN(4,27)
 
+#define INCLUDE_ENCODER
+#define LPC17_ENCODER_PINS { /*PHA*/{ PIN(1, 20), PF(3) }, /*PHB*/{ PIN(1, 23), PF(3) }, /*IDX*/{ PIN(1, 24), PF(3) } }
+
 #define INCLUDE_GPIO
 #define LPC17_GPIO_PINS {/*      0          1          2          3          4          5          6          7          8          9          10         11         12         13         14         15         16         17         18         19         20         21         22         23         24         25         26         27         28         29         30         31      */\
                          /*P0x*/ DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), NO_INIT(), NO_INIT(), NO_INIT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(),\
@@ -98,6 +101,8 @@
                       }
 
 #define INCLUDE_SIGNALS
+#define LPC17_SIGNALS_CAPTURE_PINS { /*TIMER0*/{ PIN(1, 26), PF(3) }, { PIN(1, 27), PF(3) }, /*TIMER1*/{ PIN(1, 18), PF(3) }, { PIN(1, 19), PF(3) }, /*TIMER2*/{ PIN(0, 4), PF(3) }, { PIN(0, 5), PF(3) }, /*TIMER3*/{ PIN(0, 23), PF(3) }, { PIN(0, 24), PF(3) } }
+#define LPC17_SIGNALS_GENERATOR_PINS { /*TIMER0*/{ PIN(1, 28), PF(3) }, { PIN(1, 29), PF(3) }, /*TIMER1*/{ PIN(1, 22), PF(3) }, { PIN(1, 25), PF(3) }, /*TIMER2*/{ PIN(0, 6), PF(3) }, { PIN(0, 7), PF(3) }, /*TIMER3*/{ PIN(0, 10), PF(3) }, { PIN(0, 11), PF(3) } }
 
 #define INCLUDE_SPI
 #define TOTAL_SPI_CONTROLLERS 3
@@ -137,6 +142,7 @@
 #define LPC17_USB_ENDPOINT0_SIZE 64
 #define LPC17_USB_ENDPOINT_COUNT 16
 #define LPC17_USB_PIPE_COUNT 16
+#define USB_CDC_NOTIFICATION_ENDPOINT 4
  
 #define LPC17_USBHOST_PINS {/*          DP                      DM                 \
                           /*USBH0*/{ { PIN(0, 29), PF(1) }, { PIN(0, 30), PF(1) } }\
@@ -88,6 +88,7 @@
                      }
 
 #define INCLUDE_SIGNALS
+#define AT91SAM9X35_SIGNALS_CAPTURE_PINS { { PIN_NONE, PS_NONE }, { PIN(A, 22), PS(A) }, { PIN(A, 23), PS(A) } }
 
 #define INCLUDE_SPI
 #define TOTAL_SPI_CONTROLLERS 2
@@ -123,6 +124,7 @@
 #define AT91SAM9X35_USB_PIPE_COUNT 16
 
 #define INCLUDE_DISPLAY
+#define AT91SAM9X35_DISPLAY_BUFFER_COUNT 2
 #define AT91SAM9X35_DISPLAY_CONTROLLER_RED_PINS   { { PIN(C,0), PS(A) }, { PIN(C,1), PS(A) }, { PIN(C,2), PS(A) }, { PIN(C,3), PS(A) }, { PIN(C,4), PS(A) } }
 #define AT91SAM9X35_DISPLAY_CONTROLLER_GREEN_PINS { { PIN(C,5), PS(A) }, { PIN(C,6), PS(A) }, { PIN(C,7), PS(A) }, { PIN(C,8), PS(A) }, { PIN(C,9), PS(A) }, { PIN(C,10), PS(A) } }
 #define AT91SAM9X35_DISPLAY_CONTROLLER_BLUE_PINS  { { PIN(C,11), PS(A) }, { PIN(C,12), PS(A) }, { PIN(C,13), PS(A) }, { PIN(C,14), PS(A) }, { PIN(C,15), PS(A) } }
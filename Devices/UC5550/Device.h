@@ -64,6 +64,8 @@
 
 #define INCLUDE_DEPLOYMENT
 
+#define INCLUDE_ENCODER
+
 #define INCLUDE_GPIO
 #define STM32F7_GPIO_PINS {/*      0          1          2          3          4          5          6          7          8          9          10         11         12         13         14         15      */\
                            /*PAx*/ DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(), DEFAULT(),\
@@ -159,6 +161,7 @@
                          }
 
 #define INCLUDE_DISPLAY
+#define STM32F7_DISPLAY_BUFFER_COUNT 2
 #define STM32F7_DISPLAY_CONTROLLER_RED_PINS   { { PIN(J, 2) , AF(14) }, { PIN(J, 3), AF(14) }, { PIN(J, 4), AF(14) }, { PIN(J, 5), AF(14) }, { PIN(J, 6), AF(14) }  }
 #define STM32F7_DISPLAY_CONTROLLER_GREEN_PINS { { PIN(J, 9) , AF(14) }, { PIN(J, 10), AF(14)}, { PIN(J, 11), AF(14)}, { PIN(K, 0), AF(14) }, { PIN(K, 1), AF(14) }, { PIN(K, 2), AF(14) }  }
 #define STM32F7_DISPLAY_CONTROLLER_BLUE_PINS  { { PIN(J, 15), AF(14) }, { PIN(K, 3), AF(14) }, { PIN(K, 4), AF(14) }, { PIN(K, 5), AF(14) }, { PIN(K, 6), AF(14) }  }
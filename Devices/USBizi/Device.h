@@ -80,6 +80,8 @@
 #define LPC24_PWM_PINS  { { PIN(1, 18), PF(2) }, { PIN(1, 20), PF(2) }, { PIN(1, 21), PF(2) }, { PIN(2, 3), PF(1) }, { PIN(2, 4), PF(1) }, { PIN(2, 5), PF(1) } }
 
 #define INCLUDE_SIGNALS
+#define LPC24_SIGNALS_CAPTURE_PINS { /*TIMER0*/{ PIN(1, 26), PF(3) }, { PIN(1, 27), PF(3) }, /*TIMER1*/{ PIN(1, 18), PF(3) }, { PIN(1, 19), PF(3) }, /*TIMER2*/{ PIN(0, 4), PF(3) }, { PIN(0, 5), PF(3) }, /*TIMER3*/{ PIN(0, 23), PF(3) }, { PIN(0, 24), PF(3) } }
+#define LPC24_SIGNALS_GENERATOR_PINS { /*TIMER0*/{ PIN(1, 28), PF(3) }, { PIN(1, 29), PF(3) }, /*TIMER1*/{ PIN(1, 22), PF(3) }, { PIN(1, 25), PF(3) }, /*TIMER2*/{ PIN(0, 6), PF(3) }, { PIN(0, 7), PF(3) }, /*TIMER3*/{ PIN(0, 10), PF(3) }, { PIN(0, 11), PF(3) } }
 
 #define INCLUDE_SPI
 #define TOTAL_SPI_CONTROLLERS 2
@@ -115,8 +117,9 @@
 #define LPC24_USB_PACKET_FIFO_COUNT 16
 #define LPC24_USB_ENDPOINT_SIZE 64
 #define LPC24_USB_ENDPOINT0_SIZE 64
-#define LPC24_USB_ENDPOINT_COUNT 4
+#define LPC24_USB_ENDPOINT_COUNT 5
 #define LPC24_USB_PIPE_COUNT 4
+#define USB_CDC_NOTIFICATION_ENDPOINT 4
 
 #define LPC2387_PARTID_1                    0x1700FF35
 #define LPC2387_PARTID_2                    0x1800F935
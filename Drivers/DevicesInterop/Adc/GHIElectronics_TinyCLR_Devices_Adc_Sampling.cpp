@@ -0,0 +1,77 @@
+#include "GHIElectronics_TinyCLR_Devices_Adc_Sampling.h"
+
+struct TinyCLR_Adc_SamplingApiEntry {
+    const TinyCLR_Adc_Controller* Controller;
+    const TinyCLR_Adc_SamplingApi* SamplingApi;
+};
+
+static TinyCLR_Adc_SamplingApiEntry adcSamplingApis[TINYCLR_ADC_SAMPLING_API_MAX_CONTROLLERS];
+
+bool TinyCLR_Adc_SetSamplingApi(const TinyCLR_Adc_Controller* controller, const TinyCLR_Adc_SamplingApi* samplingApi) {
+    for (auto i = 0; i < TINYCLR_ADC_SAMPLING_API_MAX_CONTROLLERS; i++) {
+        if (adcSamplingApis[i].Controller == controller || adcSamplingApis[i].Controller == nullptr) {
+            adcSamplingApis[i].Controller = controller;
+            adcSamplingApis[i].SamplingApi = samplingApi;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const TinyCLR_Adc_SamplingApi* TinyCLR_Adc_GetSamplingApi(const TinyCLR_Adc_Controller* controller) {
+    for (auto i = 0; i < TINYCLR_ADC_SAMPLING_API_MAX_CONTROLLERS; i++)
+        if (adcSamplingApis[i].Controller == controller)
+            return adcSamplingApis[i].SamplingApi;
+
+    return nullptr;
+}
+
+bool TinyCLR_Adc_IsSamplingValid(const TinyCLR_Adc_SamplingPolicy& policy) {
+    if (policy.SampleCount == 0 || policy.SampleCount > TINYCLR_ADC_SAMPLING_MAX_COUNT)
+        return false;
+
+    return policy.Filter == TinyCLR_Adc_SamplingFilter::Mean || policy.Filter == TinyCLR_Adc_SamplingFilter::Median || policy.Filter == TinyCLR_Adc_SamplingFilter::Decimate;
+}
+
+uint32_t TinyCLR_Adc_GetSamplingExtraBits(const TinyCLR_Adc_SamplingPolicy& policy) {
+    if (policy.Filter != TinyCLR_Adc_SamplingFilter::Decimate)
+        return 0;
+
+    // white noise averages down by the square root of the count
+    auto bits = 0U;
+
+    while ((4U << (2 * bits)) <= policy.SampleCount)
+        bits++;
+
+    return bits;
+}
+
+int32_t TinyCLR_Adc_FilterSamples(const TinyCLR_Adc_SamplingPolicy& policy, uint16_t* samples, size_t count) {
+    if (count == 0)
+        return 0;
+
+    if (policy.Filter == TinyCLR_Adc_SamplingFilter::Median) {
+        for (size_t i = 1; i < count; i++) {
+            auto sample = samples[i];
+            auto j = i;
+
+            for (; j > 0 && samples[j - 1] > sample; j--)
+                samples[j] = samples[j - 1];
+
+            samples[j] = sample;
+        }
+
+        return (count & 1) ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2] + 1) / 2;
+    }
+
+    uint32_t sum = 0;
+
+    for (size_t i = 0; i < count; i++)
+        sum += samples[i];
+
+    sum <<= TinyCLR_Adc_GetSamplingExtraBits(policy);
+
+    return static_cast<int32_t>((sum + count / 2) / count);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <TinyCLR.h>
+
+#define TINYCLR_ADC_SAMPLING_API_MAX_CONTROLLERS 4
+#define TINYCLR_ADC_SAMPLING_MAX_COUNT 256
+
+enum class TinyCLR_Adc_SamplingFilter : uint32_t {
+    Mean = 0,
+    Median = 1,
+    Decimate = 2,
+};
+
+// How a read of one channel samples it. SampleTime is the target's own sample time selection,
+// the SMPR code on STM32. Decimate keeps the sum of SampleCount samples scaled to one extra bit
+// of resolution per factor of four, Mean and Median stay at the converter's resolution.
+struct TinyCLR_Adc_SamplingPolicy {
+    uint32_t SampleTime;
+    uint32_t SampleCount;
+    TinyCLR_Adc_SamplingFilter Filter;
+};
+
+// Per channel sampling a target registers next to its AdcController. The controller's
+// GetResolutionInBits and GetMaxValue follow the most precise policy of the open channels and
+// every read is scaled to it. They change whenever a channel opens, closes or gets a new policy,
+// so they are only meaningful once every channel in use is open and set up, and a value read
+// before such a change is on the old scale.
+struct TinyCLR_Adc_SamplingApi {
+    TinyCLR_Result(*SetSampling)(const TinyCLR_Adc_Controller* self, uint32_t channel, const TinyCLR_Adc_SamplingPolicy& policy);
+    TinyCLR_Result(*GetSampling)(const TinyCLR_Adc_Controller* self, uint32_t channel, TinyCLR_Adc_SamplingPolicy& policy);
+};
+
+bool TinyCLR_Adc_SetSamplingApi(const TinyCLR_Adc_Controller* controller, const TinyCLR_Adc_SamplingApi* samplingApi);
+const TinyCLR_Adc_SamplingApi* TinyCLR_Adc_GetSamplingApi(const TinyCLR_Adc_Controller* controller);
+
+bool TinyCLR_Adc_IsSamplingValid(const TinyCLR_Adc_SamplingPolicy& policy);
+uint32_t TinyCLR_Adc_GetSamplingExtraBits(const TinyCLR_Adc_SamplingPolicy& policy);
+
+// Reduces count samples to one value at the converter's resolution plus the policy's extra bits.
+// Median sorts samples in place.
+int32_t TinyCLR_Adc_FilterSamples(const TinyCLR_Adc_SamplingPolicy& policy, uint16_t* samples, size_t count);
@@ -0,0 +1,191 @@
+#include "GHIElectronics_TinyCLR_Devices_Adc_Stream.h"
+
+// Cache line size of the targets with a data cache, the ring never shares a line the CPU writes
+#define ADC_STREAM_BUFFER_ALIGNMENT 32
+
+struct TinyCLR_Adc_StreamApiEntry {
+    const TinyCLR_Adc_Controller* Controller;
+    const TinyCLR_Adc_StreamApi* StreamApi;
+
+    void* Memory;
+    TinyCLR_Adc_StreamRing Ring;
+};
+
+static TinyCLR_Adc_StreamApiEntry adcStreamApis[TINYCLR_ADC_STREAM_API_MAX_CONTROLLERS];
+
+static TinyCLR_Adc_StreamApiEntry* TinyCLR_Adc_GetStreamEntry(const TinyCLR_Adc_Controller* controller) {
+    for (auto i = 0; i < TINYCLR_ADC_STREAM_API_MAX_CONTROLLERS; i++)
+        if (adcStreamApis[i].Controller == controller && adcStreamApis[i].StreamApi != nullptr)
+            return &adcStreamApis[i];
+
+    return nullptr;
+}
+
+bool TinyCLR_Adc_SetStreamApi(const TinyCLR_Adc_Controller* controller, const TinyCLR_Adc_StreamApi* streamApi) {
+    for (auto i = 0; i < TINYCLR_ADC_STREAM_API_MAX_CONTROLLERS; i++) {
+        if (adcStreamApis[i].Controller == controller || adcStreamApis[i].Controller == nullptr) {
+            adcStreamApis[i].Controller = controller;
+            adcStreamApis[i].StreamApi = streamApi;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const TinyCLR_Adc_StreamApi* TinyCLR_Adc_GetStreamApi(const TinyCLR_Adc_Controller* controller) {
+    auto entry = TinyCLR_Adc_GetStreamEntry(controller);
+
+    return entry != nullptr ? entry->StreamApi : nullptr;
+}
+
+void TinyCLR_Adc_StreamRing_Initialize(TinyCLR_Adc_StreamRing& ring, const uint16_t* buffer, size_t length, size_t channelCount) {
+    ring.Buffer = buffer;
+    ring.Length = length;
+    ring.ChannelCount = channelCount;
+    ring.Read = 0;
+}
+
+static uint64_t TinyCLR_Adc_StreamRing_GetOldest(const TinyCLR_Adc_StreamRing& ring, uint64_t written) {
+    auto half = ring.Length / 2;
+
+    return written > half ? written - half : 0;
+}
+
+size_t TinyCLR_Adc_StreamRing_GetAvailable(const TinyCLR_Adc_StreamRing& ring, uint64_t written, bool& overrun) {
+    auto oldest = TinyCLR_Adc_StreamRing_GetOldest(ring, written);
+    auto from = ring.Read;
+
+    overrun = from < oldest;
+
+    if (overrun)
+        from = oldest;
+
+    return written > from ? static_cast<size_t>((written - from) / ring.ChannelCount) : 0;
+}
+
+size_t TinyCLR_Adc_StreamRing_Read(TinyCLR_Adc_StreamRing& ring, uint64_t written, uint32_t decimation, int32_t* values, size_t sets, bool& overrun) {
+    auto available = TinyCLR_Adc_StreamRing_GetAvailable(ring, written, overrun);
+
+    if (overrun)
+        ring.Read = TinyCLR_Adc_StreamRing_GetOldest(ring, written);
+
+    if (decimation == 0)
+        decimation = 1;
+
+    auto count = available / decimation;
+
+    if (count > sets)
+        count = sets;
+
+    for (size_t s = 0; s < count; s++) {
+        for (size_t c = 0; c < ring.ChannelCount; c++) {
+            uint32_t sum = 0;
+
+            for (size_t d = 0; d < decimation; d++)
+                sum += ring.Buffer[(ring.Read + (s * decimation + d) * ring.ChannelCount + c) % ring.Length];
+
+            values[s * ring.ChannelCount + c] = static_cast<int32_t>((sum + decimation / 2) / decimation);
+        }
+    }
+
+    ring.Read += static_cast<uint64_t>(count) * decimation * ring.ChannelCount;
+
+    return count;
+}
+
+bool TinyCLR_Adc_StreamRing_IsOverwritten(const TinyCLR_Adc_StreamRing& ring, uint64_t position, uint64_t written) {
+    auto half = ring.Length / 2;
+
+    // the hardware starts on the half holding position again once it is two halves past it
+    return written >= (position / half + 2) * half;
+}
+
+TinyCLR_Result TinyCLR_Adc_StartStream(const TinyCLR_Adc_Controller* controller, const uint32_t* channels, size_t channelCount, uint32_t frequency, size_t setsPerHalf, TinyCLR_Adc_StreamHandler handler) {
+    extern const TinyCLR_Api_Manager* apiManager;
+
+    auto entry = TinyCLR_Adc_GetStreamEntry(controller);
+
+    if (entry == nullptr)
+        return TinyCLR_Result::NotSupported;
+
+    if (channels == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (channelCount == 0 || channelCount > TINYCLR_ADC_STREAM_MAX_CHANNELS || setsPerHalf == 0 || frequency == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (entry->Memory != nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
+
+    if (memoryManager == nullptr)
+        return TinyCLR_Result::NotAvailable;
+
+    auto length = 2 * setsPerHalf * channelCount;
+    auto memory = memoryManager->Allocate(memoryManager, length * sizeof(uint16_t) + 2 * ADC_STREAM_BUFFER_ALIGNMENT);
+
+    if (memory == nullptr)
+        return TinyCLR_Result::OutOfMemory;
+
+    auto buffer = reinterpret_cast<uint16_t*>((reinterpret_cast<size_t>(memory) + ADC_STREAM_BUFFER_ALIGNMENT) & ~(ADC_STREAM_BUFFER_ALIGNMENT - 1));
+
+    TinyCLR_Adc_StreamRing_Initialize(entry->Ring, buffer, length, channelCount);
+
+    auto result = entry->StreamApi->Start(controller, channels, channelCount, frequency, buffer, length, handler);
+
+    if (result != TinyCLR_Result::Success) {
+        memoryManager->Free(memoryManager, memory);
+
+        return result;
+    }
+
+    entry->Memory = memory;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_Adc_ReadStream(const TinyCLR_Adc_Controller* controller, uint32_t decimation, int32_t* values, size_t sets, size_t& read, bool& overrun) {
+    auto entry = TinyCLR_Adc_GetStreamEntry(controller);
+
+    read = 0;
+    overrun = false;
+
+    if (entry == nullptr || entry->Memory == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (values == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    auto& ring = entry->Ring;
+
+    read = TinyCLR_Adc_StreamRing_Read(ring, entry->StreamApi->GetWritten(controller), decimation, values, sets, overrun);
+
+    // the copy raced the hardware into the half it came from
+    if (read > 0 && TinyCLR_Adc_StreamRing_IsOverwritten(ring, ring.Read - static_cast<uint64_t>(read) * (decimation > 0 ? decimation : 1) * ring.ChannelCount, entry->StreamApi->GetWritten(controller)))
+        overrun = true;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_Adc_StopStream(const TinyCLR_Adc_Controller* controller) {
+    extern const TinyCLR_Api_Manager* apiManager;
+
+    auto entry = TinyCLR_Adc_GetStreamEntry(controller);
+
+    if (entry == nullptr || entry->Memory == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto result = entry->StreamApi->Stop(controller);
+
+    auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
+
+    if (memoryManager != nullptr)
+        memoryManager->Free(memoryManager, entry->Memory);
+
+    entry->Memory = nullptr;
+
+    return result;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <TinyCLR.h>
+
+#define TINYCLR_ADC_STREAM_API_MAX_CONTROLLERS 4
+#define TINYCLR_ADC_STREAM_MAX_CHANNELS 16
+
+typedef void(*TinyCLR_Adc_StreamHandler)(const TinyCLR_Adc_Controller* self, uint64_t written, uint64_t timestamp);
+
+// Continuous conversions a target registers next to its AdcController. Start converts the channelCount
+// open channels in order once per 1 / frequency and stores the sets into buffer, a ring of length samples
+// the hardware keeps rewriting; length is a multiple of 2 * channelCount. Every time half of the ring fills,
+// GetWritten, the samples stored since Start, moves on by length / 2 and handler, when not null, is called
+// from a task. ReadChannel and CloseChannel return Busy until Stop.
+struct TinyCLR_Adc_StreamApi {
+    TinyCLR_Result(*Start)(const TinyCLR_Adc_Controller* self, const uint32_t* channels, size_t channelCount, uint32_t frequency, uint16_t* buffer, size_t length, TinyCLR_Adc_StreamHandler handler);
+    uint64_t(*GetWritten)(const TinyCLR_Adc_Controller* self);
+    TinyCLR_Result(*Stop)(const TinyCLR_Adc_Controller* self);
+};
+
+bool TinyCLR_Adc_SetStreamApi(const TinyCLR_Adc_Controller* controller, const TinyCLR_Adc_StreamApi* streamApi);
+const TinyCLR_Adc_StreamApi* TinyCLR_Adc_GetStreamApi(const TinyCLR_Adc_Controller* controller);
+
+// Reader side of a stream ring. Only the half the hardware finished last is stable, a reader that fell
+// further behind skips to it and reports an overrun. Read is the sample position consumed so far.
+struct TinyCLR_Adc_StreamRing {
+    const uint16_t* Buffer;
+    size_t Length;
+    size_t ChannelCount;
+
+    uint64_t Read;
+};
+
+void TinyCLR_Adc_StreamRing_Initialize(TinyCLR_Adc_StreamRing& ring, const uint16_t* buffer, size_t length, size_t channelCount);
+size_t TinyCLR_Adc_StreamRing_GetAvailable(const TinyCLR_Adc_StreamRing& ring, uint64_t written, bool& overrun);
+
+// Reads up to sets sample sets into values, one value per channel each, every one the rounded mean of
+// decimation consecutive sets. A decimation dividing length / (2 * channelCount) never loses a partial group.
+size_t TinyCLR_Adc_StreamRing_Read(TinyCLR_Adc_StreamRing& ring, uint64_t written, uint32_t decimation, int32_t* values, size_t sets, bool& overrun);
+
+// Whether the sample at position had been rewritten by the time written was reached
+bool TinyCLR_Adc_StreamRing_IsOverwritten(const TinyCLR_Adc_StreamRing& ring, uint64_t position, uint64_t written);
+
+// Streams into a ring of 2 * setsPerHalf sets owned here. ReadStream takes the sets ready since the last call.
+// Streaming is for native code only, there is no managed API or event: handler, when not null, is called from a
+// task with the samples written so far on every half, a consumer without one polls ReadStream.
+TinyCLR_Result TinyCLR_Adc_StartStream(const TinyCLR_Adc_Controller* controller, const uint32_t* channels, size_t channelCount, uint32_t frequency, size_t setsPerHalf, TinyCLR_Adc_StreamHandler handler);
+TinyCLR_Result TinyCLR_Adc_ReadStream(const TinyCLR_Adc_Controller* controller, uint32_t decimation, int32_t* values, size_t sets, size_t& read, bool& overrun);
+TinyCLR_Result TinyCLR_Adc_StopStream(const TinyCLR_Adc_Controller* controller);
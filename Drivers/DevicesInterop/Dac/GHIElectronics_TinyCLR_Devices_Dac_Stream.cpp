@@ -0,0 +1,280 @@
+#include "GHIElectronics_TinyCLR_Devices_Dac_Stream.h"
+
+// Cache line size of the targets with a data cache, the ring never shares a line the CPU writes
+#define DAC_STREAM_BUFFER_ALIGNMENT 32
+#define DAC_STREAM_IDLE_BLOCK 16
+
+struct TinyCLR_Dac_StreamApiEntry {
+    const TinyCLR_Dac_Controller* Controller;
+    const TinyCLR_Dac_StreamApi* StreamApi;
+
+    void* Memory[TINYCLR_DAC_STREAM_MAX_CHANNELS];
+    TinyCLR_Dac_StreamQueue Queue[TINYCLR_DAC_STREAM_MAX_CHANNELS];
+};
+
+static TinyCLR_Dac_StreamApiEntry dacStreamApis[TINYCLR_DAC_STREAM_API_MAX_CONTROLLERS];
+
+static TinyCLR_Dac_StreamApiEntry* TinyCLR_Dac_GetStreamEntry(const TinyCLR_Dac_Controller* controller) {
+    for (auto i = 0; i < TINYCLR_DAC_STREAM_API_MAX_CONTROLLERS; i++)
+        if (dacStreamApis[i].Controller == controller && dacStreamApis[i].StreamApi != nullptr)
+            return &dacStreamApis[i];
+
+    return nullptr;
+}
+
+bool TinyCLR_Dac_SetStreamApi(const TinyCLR_Dac_Controller* controller, const TinyCLR_Dac_StreamApi* streamApi) {
+    for (auto i = 0; i < TINYCLR_DAC_STREAM_API_MAX_CONTROLLERS; i++) {
+        if (dacStreamApis[i].Controller == controller || dacStreamApis[i].Controller == nullptr) {
+            dacStreamApis[i].Controller = controller;
+            dacStreamApis[i].StreamApi = streamApi;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const TinyCLR_Dac_StreamApi* TinyCLR_Dac_GetStreamApi(const TinyCLR_Dac_Controller* controller) {
+    auto entry = TinyCLR_Dac_GetStreamEntry(controller);
+
+    return entry != nullptr ? entry->StreamApi : nullptr;
+}
+
+static void TinyCLR_Dac_StreamQueue_Store(TinyCLR_Dac_StreamQueue& queue, uint64_t position, const int32_t* values, size_t count) {
+    while (count > 0) {
+        auto index = static_cast<size_t>(position % queue.Length);
+        auto chunk = queue.Length - index;
+
+        if (chunk > count)
+            chunk = count;
+
+        queue.Encode(queue.Controller, queue.Channel, values, queue.Buffer + index, chunk);
+
+        position += chunk;
+        values += chunk;
+        count -= chunk;
+    }
+}
+
+static void TinyCLR_Dac_StreamQueue_StoreIdle(TinyCLR_Dac_StreamQueue& queue, uint64_t from, uint64_t to) {
+    int32_t idle[DAC_STREAM_IDLE_BLOCK];
+
+    for (auto i = 0; i < DAC_STREAM_IDLE_BLOCK; i++)
+        idle[i] = queue.Idle;
+
+    while (from < to) {
+        auto count = to - from > DAC_STREAM_IDLE_BLOCK ? DAC_STREAM_IDLE_BLOCK : static_cast<size_t>(to - from);
+
+        TinyCLR_Dac_StreamQueue_Store(queue, from, idle, count);
+
+        from += count;
+    }
+}
+
+void TinyCLR_Dac_StreamQueue_Initialize(TinyCLR_Dac_StreamQueue& queue, const TinyCLR_Dac_Controller* controller, uint32_t channel, TinyCLR_Dac_StreamEncoder encode, uint32_t* buffer, size_t length, int32_t idle, bool looped) {
+    queue.Buffer = buffer;
+    queue.Length = length;
+    queue.Controller = controller;
+    queue.Channel = channel;
+    queue.Encode = encode;
+    queue.Idle = idle;
+    queue.Looped = looped;
+    queue.Queued = 0;
+    queue.Underruns = 0;
+
+    TinyCLR_Dac_StreamQueue_StoreIdle(queue, 0, length);
+
+    queue.Filled = length;
+}
+
+size_t TinyCLR_Dac_StreamQueue_GetFree(const TinyCLR_Dac_StreamQueue& queue, uint64_t played) {
+    auto end = played + queue.Length;
+
+    if (queue.Looped || queue.Queued >= end)
+        return 0;
+
+    return static_cast<size_t>(end - queue.Queued);
+}
+
+size_t TinyCLR_Dac_StreamQueue_Write(TinyCLR_Dac_StreamQueue& queue, uint64_t played, const int32_t* values, size_t count) {
+    auto free = TinyCLR_Dac_StreamQueue_GetFree(queue, played);
+
+    if (count > free)
+        count = free;
+
+    TinyCLR_Dac_StreamQueue_Store(queue, queue.Queued, values, count);
+
+    queue.Queued += count;
+
+    return count;
+}
+
+bool TinyCLR_Dac_StreamQueue_Update(TinyCLR_Dac_StreamQueue& queue, uint64_t played) {
+    if (queue.Looped)
+        return false;
+
+    auto playing = played + queue.Length / 2;
+    auto underrun = queue.Queued < playing;
+
+    if (underrun) {
+        queue.Underruns++;
+        queue.Queued = playing;
+    }
+
+    // the halves played since the last update come around again, they play idle unless written first
+    auto from = queue.Filled > queue.Queued ? queue.Filled : queue.Queued;
+    auto to = played + queue.Length;
+
+    if (from < to) {
+        TinyCLR_Dac_StreamQueue_StoreIdle(queue, from, to);
+
+        queue.Filled = to;
+    }
+
+    return underrun;
+}
+
+static void TinyCLR_Dac_StreamBufferEmpty(const TinyCLR_Dac_Controller* self, uint32_t channel, uint64_t played, uint64_t timestamp) {
+    extern const TinyCLR_Api_Manager* apiManager;
+    auto entry = TinyCLR_Dac_GetStreamEntry(self);
+
+    if (entry == nullptr || entry->Memory[channel] == nullptr)
+        return;
+
+    auto& queue = entry->Queue[channel];
+
+    TinyCLR_Dac_StreamQueue_Update(queue, played);
+
+    auto interopManager = reinterpret_cast<const TinyCLR_Interop_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::InteropManager));
+
+    if (interopManager != nullptr)
+        interopManager->RaiseEvent(interopManager, "GHIElectronics.TinyCLR.NativeEventNames.Dac.StreamBufferEmpty", self->ApiInfo->Name, channel, TinyCLR_Dac_StreamQueue_GetFree(queue, played), 0, 0, timestamp);
+}
+
+TinyCLR_Result TinyCLR_Dac_StartStream(const TinyCLR_Dac_Controller* controller, uint32_t channel, uint32_t frequency, const int32_t* values, size_t count, size_t samplesPerHalf, int32_t idle, bool looped, size_t& written) {
+    extern const TinyCLR_Api_Manager* apiManager;
+
+    auto entry = TinyCLR_Dac_GetStreamEntry(controller);
+
+    written = 0;
+
+    if (entry == nullptr)
+        return TinyCLR_Result::NotSupported;
+
+    if (values == nullptr && count > 0)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (channel >= TINYCLR_DAC_STREAM_MAX_CHANNELS || frequency == 0 || (looped ? count == 0 : samplesPerHalf == 0))
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (entry->Memory[channel] != nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
+
+    if (memoryManager == nullptr)
+        return TinyCLR_Result::NotAvailable;
+
+    // the hardware reports halves, an odd pattern is stored twice to split evenly
+    auto length = looped ? ((count & 1) ? 2 * count : count) : 2 * samplesPerHalf;
+    auto memory = memoryManager->Allocate(memoryManager, length * sizeof(uint32_t) + 2 * DAC_STREAM_BUFFER_ALIGNMENT);
+
+    if (memory == nullptr)
+        return TinyCLR_Result::OutOfMemory;
+
+    auto buffer = reinterpret_cast<uint32_t*>((reinterpret_cast<size_t>(memory) + DAC_STREAM_BUFFER_ALIGNMENT) & ~(DAC_STREAM_BUFFER_ALIGNMENT - 1));
+    auto& queue = entry->Queue[channel];
+
+    TinyCLR_Dac_StreamQueue_Initialize(queue, controller, channel, entry->StreamApi->Encode, buffer, length, idle, looped);
+
+    if (looped) {
+        for (size_t i = 0; i < length; i += count)
+            TinyCLR_Dac_StreamQueue_Store(queue, i, values, count);
+
+        queue.Queued = length;
+        written = count;
+    }
+    else {
+        written = TinyCLR_Dac_StreamQueue_Write(queue, 0, values, count);
+    }
+
+    auto result = entry->StreamApi->Start(controller, channel, frequency, buffer, length, looped ? nullptr : &TinyCLR_Dac_StreamBufferEmpty);
+
+    if (result != TinyCLR_Result::Success) {
+        memoryManager->Free(memoryManager, memory);
+
+        written = 0;
+
+        return result;
+    }
+
+    entry->Memory[channel] = memory;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_Dac_WriteStream(const TinyCLR_Dac_Controller* controller, uint32_t channel, const int32_t* values, size_t count, size_t& written) {
+    auto entry = TinyCLR_Dac_GetStreamEntry(controller);
+
+    written = 0;
+
+    if (entry == nullptr || channel >= TINYCLR_DAC_STREAM_MAX_CHANNELS || entry->Memory[channel] == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (values == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    auto& queue = entry->Queue[channel];
+
+    if (queue.Looped)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto played = entry->StreamApi->GetPlayed(controller, channel);
+
+    TinyCLR_Dac_StreamQueue_Update(queue, played);
+
+    written = TinyCLR_Dac_StreamQueue_Write(queue, played, values, count);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_Dac_GetStreamState(const TinyCLR_Dac_Controller* controller, uint32_t channel, size_t& free, uint64_t& underruns) {
+    auto entry = TinyCLR_Dac_GetStreamEntry(controller);
+
+    free = 0;
+    underruns = 0;
+
+    if (entry == nullptr || channel >= TINYCLR_DAC_STREAM_MAX_CHANNELS || entry->Memory[channel] == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto& queue = entry->Queue[channel];
+    auto played = entry->StreamApi->GetPlayed(controller, channel);
+
+    TinyCLR_Dac_StreamQueue_Update(queue, played);
+
+    free = TinyCLR_Dac_StreamQueue_GetFree(queue, played);
+    underruns = queue.Underruns;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_Dac_StopStream(const TinyCLR_Dac_Controller* controller, uint32_t channel) {
+    extern const TinyCLR_Api_Manager* apiManager;
+
+    auto entry = TinyCLR_Dac_GetStreamEntry(controller);
+
+    if (entry == nullptr || channel >= TINYCLR_DAC_STREAM_MAX_CHANNELS || entry->Memory[channel] == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto result = entry->StreamApi->Stop(controller, channel);
+
+    auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
+
+    if (memoryManager != nullptr)
+        memoryManager->Free(memoryManager, entry->Memory[channel]);
+
+    entry->Memory[channel] = nullptr;
+
+    return result;
+}
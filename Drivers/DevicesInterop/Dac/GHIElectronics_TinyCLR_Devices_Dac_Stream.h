@@ -0,0 +1,64 @@
+#pragma once
+
+#include <TinyCLR.h>
+
+#define TINYCLR_DAC_STREAM_API_MAX_CONTROLLERS 4
+#define TINYCLR_DAC_STREAM_MAX_CHANNELS 2
+
+typedef void(*TinyCLR_Dac_StreamHandler)(const TinyCLR_Dac_Controller* self, uint32_t channel, uint64_t played, uint64_t timestamp);
+
+// Timed output a target registers next to its DacController. Start clocks the words of buffer, a ring of
+// length words the hardware replays until Stop, out to the open channel once per 1 / frequency. Every time
+// half of the ring has played, GetPlayed, the words played since Start, moves on by length / 2 and handler,
+// when there is one, is called from a task. Encode converts values in the controller's range to the words
+// the ring holds and makes them visible to the hardware. WriteValue and CloseChannel return Busy until Stop.
+struct TinyCLR_Dac_StreamApi {
+    TinyCLR_Result(*Start)(const TinyCLR_Dac_Controller* self, uint32_t channel, uint32_t frequency, const uint32_t* buffer, size_t length, TinyCLR_Dac_StreamHandler handler);
+    uint64_t(*GetPlayed)(const TinyCLR_Dac_Controller* self, uint32_t channel);
+    TinyCLR_Result(*Stop)(const TinyCLR_Dac_Controller* self, uint32_t channel);
+    void(*Encode)(const TinyCLR_Dac_Controller* self, uint32_t channel, const int32_t* values, uint32_t* words, size_t count);
+};
+
+bool TinyCLR_Dac_SetStreamApi(const TinyCLR_Dac_Controller* controller, const TinyCLR_Dac_StreamApi* streamApi);
+const TinyCLR_Dac_StreamApi* TinyCLR_Dac_GetStreamApi(const TinyCLR_Dac_Controller* controller);
+
+typedef void(*TinyCLR_Dac_StreamEncoder)(const TinyCLR_Dac_Controller* self, uint32_t channel, const int32_t* values, uint32_t* words, size_t count);
+
+// Writer side of a stream ring. Queued is the position the written values reach, Filled the position the
+// ring holds values or the idle value up to. The half playing is never written: a refill that arrives after
+// its half started counts an underrun, the half plays idle and writing resumes at the next one. A looped
+// queue keeps the values it was started with.
+struct TinyCLR_Dac_StreamQueue {
+    uint32_t* Buffer;
+    size_t Length;
+
+    const TinyCLR_Dac_Controller* Controller;
+    uint32_t Channel;
+    TinyCLR_Dac_StreamEncoder Encode;
+
+    int32_t Idle;
+    bool Looped;
+
+    uint64_t Queued;
+    uint64_t Filled;
+    uint64_t Underruns;
+};
+
+// Fills the whole ring with idle
+void TinyCLR_Dac_StreamQueue_Initialize(TinyCLR_Dac_StreamQueue& queue, const TinyCLR_Dac_Controller* controller, uint32_t channel, TinyCLR_Dac_StreamEncoder encode, uint32_t* buffer, size_t length, int32_t idle, bool looped);
+size_t TinyCLR_Dac_StreamQueue_GetFree(const TinyCLR_Dac_StreamQueue& queue, uint64_t played);
+
+// Queues up to count values behind the ones already queued and returns how many fit
+size_t TinyCLR_Dac_StreamQueue_Write(TinyCLR_Dac_StreamQueue& queue, uint64_t played, const int32_t* values, size_t count);
+
+// Catches the queue up with the hardware at played, a multiple of length / 2. Returns whether the half now
+// playing had underrun.
+bool TinyCLR_Dac_StreamQueue_Update(TinyCLR_Dac_StreamQueue& queue, uint64_t played);
+
+// Plays values at frequency from a ring owned here. A looped stream replays the count values until stopped.
+// Otherwise the ring holds two halves of samplesPerHalf values, written takes how many of values were queued
+// and Dac.StreamBufferEmpty is raised with the channel and the free values every time a half played.
+TinyCLR_Result TinyCLR_Dac_StartStream(const TinyCLR_Dac_Controller* controller, uint32_t channel, uint32_t frequency, const int32_t* values, size_t count, size_t samplesPerHalf, int32_t idle, bool looped, size_t& written);
+TinyCLR_Result TinyCLR_Dac_WriteStream(const TinyCLR_Dac_Controller* controller, uint32_t channel, const int32_t* values, size_t count, size_t& written);
+TinyCLR_Result TinyCLR_Dac_GetStreamState(const TinyCLR_Dac_Controller* controller, uint32_t channel, size_t& free, uint64_t& underruns);
+TinyCLR_Result TinyCLR_Dac_StopStream(const TinyCLR_Dac_Controller* controller, uint32_t channel);
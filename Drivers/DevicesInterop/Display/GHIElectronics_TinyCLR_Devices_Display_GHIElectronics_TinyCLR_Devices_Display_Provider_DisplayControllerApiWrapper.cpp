@@ -2,6 +2,15 @@
 #include "../GHIElectronics_TinyCLR_InteropUtil.h"
 #include "../Spi/GHIElectronics_TinyCLR_Devices_Spi.h"
 #include "../I2c/GHIElectronics_TinyCLR_Devices_I2c.h"
+#include "../../Display/Display.h"
+
+void TinyCLR_Display_FrameCompleteIsr(const TinyCLR_Display_Controller* self, uint64_t timestamp) {
+    extern const TinyCLR_Api_Manager* apiManager;
+    auto interopManager = reinterpret_cast<const TinyCLR_Interop_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::InteropManager));
+
+    if (interopManager != nullptr)
+        interopManager->RaiseEvent(interopManager, "GHIElectronics.TinyCLR.NativeEventNames.Display.FrameComplete", self->ApiInfo->Name, 0, 0, 0, 0, timestamp);
+}
 
 TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::Enable___VOID(const TinyCLR_Interop_MethodData md) {
     auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
@@ -123,12 +132,19 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_Tin
 TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::Acquire___VOID(const TinyCLR_Interop_MethodData md) {
     auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
 
-    return api->Acquire(api);
+    auto res = api->Acquire(api);
+
+    if (res == TinyCLR_Result::Success)
+        Display_SetFrameCompleteHandler(TinyCLR_Display_FrameCompleteIsr);
+
+    return res;
 }
 
 TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::Release___VOID(const TinyCLR_Interop_MethodData md) {
     auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
 
+    Display_SetFrameCompleteHandler(nullptr);
+
     return api->Release(api);
 }
 
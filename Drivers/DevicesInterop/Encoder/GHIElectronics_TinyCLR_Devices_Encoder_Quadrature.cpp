@@ -0,0 +1,235 @@
+#include "GHIElectronics_TinyCLR_Devices_Encoder_Quadrature.h"
+
+struct TinyCLR_Encoder_Velocity {
+    uint64_t Period;
+
+    int64_t Position;
+    uint64_t Timestamp;
+
+    double Value;
+};
+
+struct TinyCLR_Encoder_ControllerApiEntry {
+    const TinyCLR_Gpio_Controller* Controller;
+    const TinyCLR_Encoder_ControllerApi* ControllerApi;
+
+    TinyCLR_Encoder_Velocity Velocity[TINYCLR_ENCODER_MAX_ENCODERS];
+};
+
+static TinyCLR_Encoder_ControllerApiEntry encoderControllerApis[TINYCLR_ENCODER_API_MAX_CONTROLLERS];
+
+void TinyCLR_Encoder_Counter_Initialize(TinyCLR_Encoder_Counter& counter, uint32_t mask) {
+    counter.Mask = mask;
+    counter.Last = 0;
+    counter.Position = 0;
+    counter.IndexCount = 0;
+    counter.IndexPosition = 0;
+    counter.IndexTimestamp = 0;
+}
+
+static int64_t TinyCLR_Encoder_Counter_GetPosition(const TinyCLR_Encoder_Counter& counter, uint32_t raw) {
+    auto delta = (raw - counter.Last) & counter.Mask;
+
+    // a distance of half the counter or more is a move backwards
+    if (delta > (counter.Mask >> 1))
+        return counter.Position - static_cast<int64_t>(counter.Mask - delta) - 1;
+
+    return counter.Position + delta;
+}
+
+int64_t TinyCLR_Encoder_Counter_Update(TinyCLR_Encoder_Counter& counter, uint32_t raw) {
+    counter.Position = TinyCLR_Encoder_Counter_GetPosition(counter, raw);
+    counter.Last = raw & counter.Mask;
+
+    return counter.Position;
+}
+
+void TinyCLR_Encoder_Counter_SetPosition(TinyCLR_Encoder_Counter& counter, uint32_t raw, int64_t position) {
+    auto offset = position - TinyCLR_Encoder_Counter_GetPosition(counter, raw);
+
+    counter.Position += offset;
+    counter.IndexPosition += offset;
+}
+
+void TinyCLR_Encoder_Counter_LatchIndex(TinyCLR_Encoder_Counter& counter, uint32_t raw, uint64_t timestamp) {
+    counter.IndexPosition = TinyCLR_Encoder_Counter_GetPosition(counter, raw);
+    counter.IndexTimestamp = timestamp;
+    counter.IndexCount++;
+}
+
+uint32_t TinyCLR_Encoder_Counter_GetPoint(const TinyCLR_Encoder_Counter& counter, uint32_t point) {
+    auto range = static_cast<uint64_t>(counter.Mask) + 1;
+
+    return static_cast<uint32_t>(range * point / TINYCLR_ENCODER_COUNTER_POINTS);
+}
+
+uint32_t TinyCLR_Encoder_Counter_GetArmedPoints(const TinyCLR_Encoder_Counter& counter, uint32_t raw) {
+    auto range = static_cast<uint64_t>(counter.Mask) + 1;
+
+    // raw * points / range rounded, the values just below the wrap are nearest to point 0
+    auto nearest = static_cast<uint32_t>((static_cast<uint64_t>(raw & counter.Mask) * TINYCLR_ENCODER_COUNTER_POINTS * 2 + range) / (2 * range)) % TINYCLR_ENCODER_COUNTER_POINTS;
+
+    return ((1 << TINYCLR_ENCODER_COUNTER_POINTS) - 1) & ~(1 << nearest);
+}
+
+static TinyCLR_Encoder_ControllerApiEntry* TinyCLR_Encoder_GetControllerEntry(const TinyCLR_Gpio_Controller* controller) {
+    for (auto i = 0; i < TINYCLR_ENCODER_API_MAX_CONTROLLERS; i++)
+        if (encoderControllerApis[i].Controller == controller && encoderControllerApis[i].ControllerApi != nullptr)
+            return &encoderControllerApis[i];
+
+    return nullptr;
+}
+
+bool TinyCLR_Encoder_SetControllerApi(const TinyCLR_Gpio_Controller* controller, const TinyCLR_Encoder_ControllerApi* controllerApi) {
+    for (auto i = 0; i < TINYCLR_ENCODER_API_MAX_CONTROLLERS; i++) {
+        if (encoderControllerApis[i].Controller == controller || encoderControllerApis[i].Controller == nullptr) {
+            encoderControllerApis[i].Controller = controller;
+            encoderControllerApis[i].ControllerApi = controllerApi;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const TinyCLR_Encoder_ControllerApi* TinyCLR_Encoder_GetControllerApi(const TinyCLR_Gpio_Controller* controller) {
+    auto entry = TinyCLR_Encoder_GetControllerEntry(controller);
+
+    return entry != nullptr ? entry->ControllerApi : nullptr;
+}
+
+static TinyCLR_Result TinyCLR_Encoder_GetEntry(const TinyCLR_Gpio_Controller* controller, uint32_t encoder, TinyCLR_Encoder_ControllerApiEntry*& entry) {
+    entry = TinyCLR_Encoder_GetControllerEntry(controller);
+
+    if (entry == nullptr)
+        return TinyCLR_Result::NotSupported;
+
+    if (encoder >= TINYCLR_ENCODER_MAX_ENCODERS || encoder >= entry->ControllerApi->GetEncoderCount(controller))
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_Encoder_Open(const TinyCLR_Gpio_Controller* controller, uint32_t encoder, const TinyCLR_Encoder_Settings& settings) {
+    TinyCLR_Encoder_ControllerApiEntry* entry;
+    TinyCLR_Encoder_Counter counter;
+
+    auto result = TinyCLR_Encoder_GetEntry(controller, encoder, entry);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    result = entry->ControllerApi->Open(controller, encoder, settings);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    auto& velocity = entry->Velocity[encoder];
+
+    velocity.Period = settings.VelocityPeriod;
+    velocity.Value = 0;
+
+    entry->ControllerApi->Read(controller, encoder, counter, velocity.Timestamp);
+
+    velocity.Position = counter.Position;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_Encoder_Close(const TinyCLR_Gpio_Controller* controller, uint32_t encoder) {
+    TinyCLR_Encoder_ControllerApiEntry* entry;
+
+    auto result = TinyCLR_Encoder_GetEntry(controller, encoder, entry);
+
+    return result == TinyCLR_Result::Success ? entry->ControllerApi->Close(controller, encoder) : result;
+}
+
+TinyCLR_Result TinyCLR_Encoder_GetPosition(const TinyCLR_Gpio_Controller* controller, uint32_t encoder, int64_t& position) {
+    TinyCLR_Encoder_ControllerApiEntry* entry;
+    TinyCLR_Encoder_Counter counter;
+    uint64_t timestamp;
+
+    auto result = TinyCLR_Encoder_GetEntry(controller, encoder, entry);
+
+    if (result == TinyCLR_Result::Success)
+        result = entry->ControllerApi->Read(controller, encoder, counter, timestamp);
+
+    position = result == TinyCLR_Result::Success ? counter.Position : 0;
+
+    return result;
+}
+
+TinyCLR_Result TinyCLR_Encoder_SetPosition(const TinyCLR_Gpio_Controller* controller, uint32_t encoder, int64_t position) {
+    TinyCLR_Encoder_ControllerApiEntry* entry;
+    TinyCLR_Encoder_Counter counter;
+    uint64_t timestamp;
+
+    auto result = TinyCLR_Encoder_GetEntry(controller, encoder, entry);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    result = entry->ControllerApi->Read(controller, encoder, counter, timestamp);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    // the window carries on in the new origin
+    entry->Velocity[encoder].Position += position - counter.Position;
+
+    return entry->ControllerApi->SetPosition(controller, encoder, position);
+}
+
+TinyCLR_Result TinyCLR_Encoder_GetVelocity(const TinyCLR_Gpio_Controller* controller, uint32_t encoder, double& velocity) {
+    TinyCLR_Encoder_ControllerApiEntry* entry;
+    TinyCLR_Encoder_Counter counter;
+    uint64_t timestamp;
+
+    velocity = 0;
+
+    auto result = TinyCLR_Encoder_GetEntry(controller, encoder, entry);
+
+    if (result == TinyCLR_Result::Success)
+        result = entry->ControllerApi->Read(controller, encoder, counter, timestamp);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    auto& window = entry->Velocity[encoder];
+    auto elapsed = timestamp - window.Timestamp;
+
+    if (elapsed > 0 && elapsed >= window.Period) {
+        window.Value = static_cast<double>(counter.Position - window.Position) * TINYCLR_ENCODER_TICKS_PER_SECOND / elapsed;
+        window.Position = counter.Position;
+        window.Timestamp = timestamp;
+    }
+
+    velocity = window.Value;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_Encoder_GetIndex(const TinyCLR_Gpio_Controller* controller, uint32_t encoder, uint64_t& count, int64_t& position, uint64_t& timestamp) {
+    TinyCLR_Encoder_ControllerApiEntry* entry;
+    TinyCLR_Encoder_Counter counter;
+    uint64_t now;
+
+    count = 0;
+    position = 0;
+    timestamp = 0;
+
+    auto result = TinyCLR_Encoder_GetEntry(controller, encoder, entry);
+
+    if (result == TinyCLR_Result::Success)
+        result = entry->ControllerApi->Read(controller, encoder, counter, now);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    count = counter.IndexCount;
+    position = counter.IndexPosition;
+    timestamp = counter.IndexTimestamp;
+
+    return TinyCLR_Result::Success;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <TinyCLR.h>
+
+#define TINYCLR_ENCODER_API_MAX_CONTROLLERS 4
+#define TINYCLR_ENCODER_MAX_ENCODERS 8
+#define TINYCLR_ENCODER_COUNTER_POINTS 3
+#define TINYCLR_ENCODER_NO_INDEX 0xFFFFFFFF
+
+// System time runs in ticks of 100ns
+#define TINYCLR_ENCODER_TICKS_PER_SECOND 10000000
+
+struct TinyCLR_Encoder_Settings {
+    uint32_t IndexPin;          // TINYCLR_ENCODER_NO_INDEX without an index
+    uint32_t FilterTime;        // nanoseconds an input must hold a level before it counts
+    uint64_t VelocityPeriod;    // system time the velocity is averaged over at least
+    bool Reversed;              // counts down while A leads B
+};
+
+// Hardware counter of Mask + 1 values widened to 64 bits. Update adds the distance moved since the sample
+// before, so samples must come less than half the counter apart. Targets sample at three compare points a
+// third of the counter apart and arm only the two the counter isn't nearest to: an input resting on a point
+// doesn't interrupt and consecutive samples are a third of the counter apart. Only the compare interrupts
+// sample, SetPosition and LatchIndex work from the last sample and reads update a copy, since a sample
+// taken between two points could be further than half the counter from the next one.
+struct TinyCLR_Encoder_Counter {
+    uint32_t Mask;
+    uint32_t Last;
+    int64_t Position;
+
+    uint64_t IndexCount;
+    int64_t IndexPosition;
+    uint64_t IndexTimestamp;
+};
+
+void TinyCLR_Encoder_Counter_Initialize(TinyCLR_Encoder_Counter& counter, uint32_t mask);
+int64_t TinyCLR_Encoder_Counter_Update(TinyCLR_Encoder_Counter& counter, uint32_t raw);
+void TinyCLR_Encoder_Counter_SetPosition(TinyCLR_Encoder_Counter& counter, uint32_t raw, int64_t position);
+void TinyCLR_Encoder_Counter_LatchIndex(TinyCLR_Encoder_Counter& counter, uint32_t raw, uint64_t timestamp);
+
+// Raw value of compare point, point 0 being the wrap from Mask to 0
+uint32_t TinyCLR_Encoder_Counter_GetPoint(const TinyCLR_Encoder_Counter& counter, uint32_t point);
+
+// Bit per point to arm after sampling raw, all but the nearest one
+uint32_t TinyCLR_Encoder_Counter_GetArmedPoints(const TinyCLR_Encoder_Counter& counter, uint32_t raw);
+
+// Quadrature decoding a target registers next to its GpioController. Open routes the A and B inputs of
+// encoder to a counter that counts every edge of both, four per cycle, through the longest input filter
+// the hardware has that doesn't exceed FilterTime. The index pin, when the target can take it, latches the
+// position on every rising edge. Read samples the counter into a copy of its state with the system time
+// of the sample. The hardware counts on its own, the CPU only runs at the compare points and the index.
+struct TinyCLR_Encoder_ControllerApi {
+    uint32_t(*GetEncoderCount)(const TinyCLR_Gpio_Controller* self);
+    TinyCLR_Result(*Open)(const TinyCLR_Gpio_Controller* self, uint32_t encoder, const TinyCLR_Encoder_Settings& settings);
+    TinyCLR_Result(*Close)(const TinyCLR_Gpio_Controller* self, uint32_t encoder);
+    TinyCLR_Result(*Read)(const TinyCLR_Gpio_Controller* self, uint32_t encoder, TinyCLR_Encoder_Counter& counter, uint64_t& timestamp);
+    TinyCLR_Result(*SetPosition)(const TinyCLR_Gpio_Controller* self, uint32_t encoder, int64_t position);
+};
+
+bool TinyCLR_Encoder_SetControllerApi(const TinyCLR_Gpio_Controller* controller, const TinyCLR_Encoder_ControllerApi* controllerApi);
+const TinyCLR_Encoder_ControllerApi* TinyCLR_Encoder_GetControllerApi(const TinyCLR_Gpio_Controller* controller);
+
+TinyCLR_Result TinyCLR_Encoder_Open(const TinyCLR_Gpio_Controller* controller, uint32_t encoder, const TinyCLR_Encoder_Settings& settings);
+TinyCLR_Result TinyCLR_Encoder_Close(const TinyCLR_Gpio_Controller* controller, uint32_t encoder);
+TinyCLR_Result TinyCLR_Encoder_GetPosition(const TinyCLR_Gpio_Controller* controller, uint32_t encoder, int64_t& position);
+TinyCLR_Result TinyCLR_Encoder_SetPosition(const TinyCLR_Gpio_Controller* controller, uint32_t encoder, int64_t position);
+
+// Counts per second between the last two reads at least VelocityPeriod apart, the earlier one being Open
+TinyCLR_Result TinyCLR_Encoder_GetVelocity(const TinyCLR_Gpio_Controller* controller, uint32_t encoder, double& velocity);
+
+// Rising index edges since Open and the position and system time of the last one
+TinyCLR_Result TinyCLR_Encoder_GetIndex(const TinyCLR_Gpio_Controller* controller, uint32_t encoder, uint64_t& count, int64_t& position, uint64_t& timestamp);
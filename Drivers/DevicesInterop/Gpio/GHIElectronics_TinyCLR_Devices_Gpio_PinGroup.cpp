@@ -0,0 +1,229 @@
+#include "GHIElectronics_TinyCLR_Devices_Gpio_PinGroup.h"
+
+struct TinyCLR_Gpio_PortApiEntry {
+    const TinyCLR_Gpio_Controller* Controller;
+    const TinyCLR_Gpio_PortApi* PortApi;
+};
+
+static TinyCLR_Gpio_PortApiEntry gpioPortApis[TINYCLR_GPIO_PORT_API_MAX_CONTROLLERS];
+
+bool TinyCLR_Gpio_SetPortApi(const TinyCLR_Gpio_Controller* controller, const TinyCLR_Gpio_PortApi* portApi) {
+    for (auto i = 0; i < TINYCLR_GPIO_PORT_API_MAX_CONTROLLERS; i++) {
+        if (gpioPortApis[i].Controller == controller || gpioPortApis[i].Controller == nullptr) {
+            gpioPortApis[i].Controller = controller;
+            gpioPortApis[i].PortApi = portApi;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const TinyCLR_Gpio_PortApi* TinyCLR_Gpio_GetPortApi(const TinyCLR_Gpio_Controller* controller) {
+    for (auto i = 0; i < TINYCLR_GPIO_PORT_API_MAX_CONTROLLERS; i++)
+        if (gpioPortApis[i].Controller == controller)
+            return gpioPortApis[i].PortApi;
+
+    return nullptr;
+}
+
+static void TinyCLR_Gpio_PinGroup_ClosePins(const TinyCLR_Gpio_Controller* controller, const uint32_t* pins, uint32_t count) {
+    for (auto i = 0; i < count; i++)
+        controller->ClosePin(controller, pins[i]);
+}
+
+// Opens and configures one pin, closing it again if it can't be driven in the group's mode
+static TinyCLR_Result TinyCLR_Gpio_PinGroup_OpenPin(const TinyCLR_Gpio_Controller* controller, uint32_t pin, TinyCLR_Gpio_PinDriveMode driveMode) {
+    auto result = controller->OpenPin(controller, pin);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    if (!controller->IsDriveModeSupported(controller, pin, driveMode))
+        result = TinyCLR_Result::NotSupported;
+    else
+        result = controller->SetDriveMode(controller, pin, driveMode);
+
+    if (result == TinyCLR_Result::Success && controller->GetDriveMode(controller, pin) != driveMode)
+        result = TinyCLR_Result::InvalidOperation;
+
+    if (result != TinyCLR_Result::Success)
+        controller->ClosePin(controller, pin);
+
+    return result;
+}
+
+TinyCLR_Result TinyCLR_Gpio_PinGroup_Initialize(TinyCLR_Gpio_PinGroup& group, const TinyCLR_Gpio_Controller* controller, const uint32_t* pins, uint32_t count, TinyCLR_Gpio_PinDriveMode driveMode) {
+    if (controller == nullptr || pins == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (count == 0 || count > TINYCLR_GPIO_PIN_GROUP_MAX_PINS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    // Port writes only reach outputs, an input group would fail every Write
+    if (driveMode < TinyCLR_Gpio_PinDriveMode::Output)
+        return TinyCLR_Result::ArgumentInvalid;
+
+    for (auto i = 0; i < count; i++)
+        for (auto j = 0; j < i; j++)
+            if (pins[j] == pins[i])
+                return TinyCLR_Result::ArgumentInvalid;
+
+    group.PinCount = 0;
+
+    for (auto i = 0; i < count; i++) {
+        auto result = TinyCLR_Gpio_PinGroup_OpenPin(controller, pins[i], driveMode);
+
+        if (result != TinyCLR_Result::Success) {
+            TinyCLR_Gpio_PinGroup_ClosePins(controller, pins, i);
+
+            return result;
+        }
+    }
+
+    group.Controller = controller;
+    group.PortApi = TinyCLR_Gpio_GetPortApi(controller);
+    group.DriveMode = driveMode;
+    group.PinCount = count;
+    group.RunCount = 0;
+    group.PortCount = 0;
+
+    for (auto i = 0; i < count; i++)
+        group.Pins[i] = pins[i];
+
+    // Without port access every Read and Write goes pin by pin through the controller
+    if (group.PortApi == nullptr)
+        return TinyCLR_Result::Success;
+
+    for (auto i = 0; i < count; i++) {
+        auto port = pins[i] / group.PortApi->PinsPerPort;
+        auto bit = pins[i] % group.PortApi->PinsPerPort;
+
+        if (port >= group.PortApi->PortCount) {
+            TinyCLR_Gpio_PinGroup_Uninitialize(group);
+
+            return TinyCLR_Result::ArgumentOutOfRange;
+        }
+
+        auto slot = 0;
+
+        while (slot < group.PortCount && group.Ports[slot].Port != port)
+            slot++;
+
+        if (slot == group.PortCount) {
+            group.Ports[slot].Port = port;
+            group.Ports[slot].Mask = 0;
+            group.PortCount++;
+        }
+
+        group.Ports[slot].Mask |= (1u << bit);
+
+        if (group.RunCount > 0) {
+            auto& run = group.Runs[group.RunCount - 1];
+
+            if (run.Slot == slot && run.GroupBit + run.Length == i && run.PortBit + run.Length == bit && run.Length < 32) {
+                run.Mask |= (1u << run.Length);
+                run.Length++;
+
+                continue;
+            }
+        }
+
+        auto& run = group.Runs[group.RunCount++];
+
+        run.Slot = slot;
+        run.GroupBit = i;
+        run.PortBit = bit;
+        run.Length = 1;
+        run.Mask = 1;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_Gpio_PinGroup_Uninitialize(TinyCLR_Gpio_PinGroup& group) {
+    if (group.PinCount == 0)
+        return TinyCLR_Result::InvalidOperation;
+
+    TinyCLR_Gpio_PinGroup_ClosePins(group.Controller, group.Pins, group.PinCount);
+
+    group.PinCount = 0;
+    group.RunCount = 0;
+    group.PortCount = 0;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_Gpio_PinGroup_Read(const TinyCLR_Gpio_PinGroup& group, uint32_t& value) {
+    value = 0;
+
+    if (group.PinCount == 0)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (group.PortApi == nullptr) {
+        for (auto i = 0; i < group.PinCount; i++) {
+            TinyCLR_Gpio_PinValue pinValue;
+
+            auto result = group.Controller->Read(group.Controller, group.Pins[i], pinValue);
+
+            if (result != TinyCLR_Result::Success)
+                return result;
+
+            if (pinValue == TinyCLR_Gpio_PinValue::High)
+                value |= (1u << i);
+        }
+
+        return TinyCLR_Result::Success;
+    }
+
+    uint32_t portValues[TINYCLR_GPIO_PIN_GROUP_MAX_PINS];
+
+    for (auto i = 0; i < group.PortCount; i++) {
+        auto result = group.PortApi->ReadPort(group.Controller, group.Ports[i].Port, group.Ports[i].Mask, portValues[i]);
+
+        if (result != TinyCLR_Result::Success)
+            return result;
+    }
+
+    for (auto i = 0; i < group.RunCount; i++) {
+        auto& run = group.Runs[i];
+
+        value |= ((portValues[run.Slot] >> run.PortBit) & run.Mask) << run.GroupBit;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_Gpio_PinGroup_Write(const TinyCLR_Gpio_PinGroup& group, uint32_t value) {
+    if (group.PinCount == 0)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (group.PortApi == nullptr) {
+        for (auto i = 0; i < group.PinCount; i++) {
+            auto result = group.Controller->Write(group.Controller, group.Pins[i], (value & (1u << i)) ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low);
+
+            if (result != TinyCLR_Result::Success)
+                return result;
+        }
+
+        return TinyCLR_Result::Success;
+    }
+
+    uint32_t portValues[TINYCLR_GPIO_PIN_GROUP_MAX_PINS] = { 0 };
+
+    for (auto i = 0; i < group.RunCount; i++) {
+        auto& run = group.Runs[i];
+
+        portValues[run.Slot] |= ((value >> run.GroupBit) & run.Mask) << run.PortBit;
+    }
+
+    for (auto i = 0; i < group.PortCount; i++) {
+        auto result = group.PortApi->WritePort(group.Controller, group.Ports[i].Port, group.Ports[i].Mask, portValues[i]);
+
+        if (result != TinyCLR_Result::Success)
+            return result;
+    }
+
+    return TinyCLR_Result::Success;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <TinyCLR.h>
+
+#define TINYCLR_GPIO_PIN_GROUP_MAX_PINS 32
+#define TINYCLR_GPIO_PORT_API_MAX_CONTROLLERS 4
+
+// Port wide access a target registers next to its GpioController. Only the pins set in mask are
+// read or driven, pin n of a port is bit n and a port holds PinsPerPort pins.
+struct TinyCLR_Gpio_PortApi {
+    uint32_t PinsPerPort;
+    uint32_t PortCount;
+    TinyCLR_Result(*ReadPort)(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t& value);
+    TinyCLR_Result(*WritePort)(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t value);
+};
+
+bool TinyCLR_Gpio_SetPortApi(const TinyCLR_Gpio_Controller* controller, const TinyCLR_Gpio_PortApi* portApi);
+const TinyCLR_Gpio_PortApi* TinyCLR_Gpio_GetPortApi(const TinyCLR_Gpio_Controller* controller);
+
+struct TinyCLR_Gpio_PinGroupRun {
+    uint8_t Slot;
+    uint8_t GroupBit;
+    uint8_t PortBit;
+    uint8_t Length;
+    uint32_t Mask;
+};
+
+struct TinyCLR_Gpio_PinGroupPort {
+    uint32_t Port;
+    uint32_t Mask;
+};
+
+// Bit n of a group value is Pins[n]. Consecutive pins of the same port collapse into one run, so
+// a bus wired to adjacent pins costs a shift and a single port access per Read or Write. The group
+// opens its pins and drives them in one of the output modes until it is uninitialized.
+struct TinyCLR_Gpio_PinGroup {
+    const TinyCLR_Gpio_Controller* Controller;
+    const TinyCLR_Gpio_PortApi* PortApi;
+    TinyCLR_Gpio_PinDriveMode DriveMode;
+
+    uint32_t PinCount;
+    uint32_t Pins[TINYCLR_GPIO_PIN_GROUP_MAX_PINS];
+
+    uint32_t RunCount;
+    TinyCLR_Gpio_PinGroupRun Runs[TINYCLR_GPIO_PIN_GROUP_MAX_PINS];
+
+    uint32_t PortCount;
+    TinyCLR_Gpio_PinGroupPort Ports[TINYCLR_GPIO_PIN_GROUP_MAX_PINS];
+};
+
+TinyCLR_Result TinyCLR_Gpio_PinGroup_Initialize(TinyCLR_Gpio_PinGroup& group, const TinyCLR_Gpio_Controller* controller, const uint32_t* pins, uint32_t count, TinyCLR_Gpio_PinDriveMode driveMode);
+TinyCLR_Result TinyCLR_Gpio_PinGroup_Uninitialize(TinyCLR_Gpio_PinGroup& group);
+TinyCLR_Result TinyCLR_Gpio_PinGroup_Read(const TinyCLR_Gpio_PinGroup& group, uint32_t& value);
+TinyCLR_Result TinyCLR_Gpio_PinGroup_Write(const TinyCLR_Gpio_PinGroup& group, uint32_t value);
@@ -0,0 +1,129 @@
+#include "GHIElectronics_TinyCLR_Devices_Pwm_Burst.h"
+
+struct TinyCLR_Pwm_BurstApiEntry {
+    const TinyCLR_Pwm_Controller* Controller;
+    const TinyCLR_Pwm_BurstApi* BurstApi;
+
+    uint32_t* Pulses;
+    size_t PulseCapacity;
+};
+
+static TinyCLR_Pwm_BurstApiEntry pwmBurstApis[TINYCLR_PWM_BURST_API_MAX_CONTROLLERS];
+
+static TinyCLR_Pwm_BurstApiEntry* TinyCLR_Pwm_GetBurstEntry(const TinyCLR_Pwm_Controller* controller) {
+    for (auto i = 0; i < TINYCLR_PWM_BURST_API_MAX_CONTROLLERS; i++)
+        if (pwmBurstApis[i].Controller == controller && pwmBurstApis[i].BurstApi != nullptr)
+            return &pwmBurstApis[i];
+
+    return nullptr;
+}
+
+bool TinyCLR_Pwm_SetBurstApi(const TinyCLR_Pwm_Controller* controller, const TinyCLR_Pwm_BurstApi* burstApi) {
+    for (auto i = 0; i < TINYCLR_PWM_BURST_API_MAX_CONTROLLERS; i++) {
+        if (pwmBurstApis[i].Controller == controller || pwmBurstApis[i].Controller == nullptr) {
+            pwmBurstApis[i].Controller = controller;
+            pwmBurstApis[i].BurstApi = burstApi;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const TinyCLR_Pwm_BurstApi* TinyCLR_Pwm_GetBurstApi(const TinyCLR_Pwm_Controller* controller) {
+    auto entry = TinyCLR_Pwm_GetBurstEntry(controller);
+
+    return entry != nullptr ? entry->BurstApi : nullptr;
+}
+
+TinyCLR_Result TinyCLR_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* controller, const uint32_t* channels, const double* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count) {
+    if (channels == nullptr || dutyCycles == nullptr || polarities == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    auto burstApi = TinyCLR_Pwm_GetBurstApi(controller);
+
+    if (burstApi != nullptr)
+        return burstApi->SetPulseParameters(controller, channels, dutyCycles, polarities, count);
+
+    for (size_t i = 0; i < count; i++) {
+        auto result = controller->SetPulseParameters(controller, channels[i], dutyCycles[i], polarities[i]);
+
+        if (result != TinyCLR_Result::Success)
+            return result;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+static void TinyCLR_Pwm_BurstCompleted(const TinyCLR_Pwm_Controller* self, uint64_t timestamp) {
+    extern const TinyCLR_Api_Manager* apiManager;
+
+    auto interopManager = reinterpret_cast<const TinyCLR_Interop_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::InteropManager));
+
+    if (interopManager != nullptr)
+        interopManager->RaiseEvent(interopManager, "GHIElectronics.TinyCLR.NativeEventNames.Pwm.BurstCompleted", self->ApiInfo->Name, 0, 0, 0, 0, timestamp);
+}
+
+static uint32_t* TinyCLR_Pwm_GetBurstPulses(TinyCLR_Pwm_BurstApiEntry& entry, size_t count) {
+    extern const TinyCLR_Api_Manager* apiManager;
+
+    if (entry.PulseCapacity >= count)
+        return entry.Pulses;
+
+    auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
+
+    if (memoryManager == nullptr)
+        return nullptr;
+
+    if (entry.Pulses != nullptr)
+        memoryManager->Free(memoryManager, entry.Pulses);
+
+    entry.PulseCapacity = 0;
+    entry.Pulses = reinterpret_cast<uint32_t*>(memoryManager->Allocate(memoryManager, count * sizeof(uint32_t)));
+
+    if (entry.Pulses != nullptr)
+        entry.PulseCapacity = count;
+
+    return entry.Pulses;
+}
+
+TinyCLR_Result TinyCLR_Pwm_StartBurst(const TinyCLR_Pwm_Controller* controller, uint32_t firstChannel, uint32_t channelCount, const double* dutyCycles, size_t sets, bool looped) {
+    auto entry = TinyCLR_Pwm_GetBurstEntry(controller);
+
+    if (entry == nullptr)
+        return TinyCLR_Result::NotSupported;
+
+    if (dutyCycles == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (channelCount == 0 || sets == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    // the table is only rewritten while the hardware doesn't read it
+    if (entry->BurstApi->IsBurstActive(controller))
+        return TinyCLR_Result::Busy;
+
+    auto pulses = TinyCLR_Pwm_GetBurstPulses(*entry, sets * channelCount);
+
+    if (pulses == nullptr)
+        return TinyCLR_Result::OutOfMemory;
+
+    for (uint32_t c = 0; c < channelCount; c++) {
+        auto result = entry->BurstApi->EncodeBurst(controller, firstChannel + c, dutyCycles + c, pulses + c, sets, channelCount);
+
+        if (result != TinyCLR_Result::Success)
+            return result;
+    }
+
+    return entry->BurstApi->StartBurst(controller, firstChannel, channelCount, pulses, sets, looped, looped ? nullptr : &TinyCLR_Pwm_BurstCompleted);
+}
+
+TinyCLR_Result TinyCLR_Pwm_StopBurst(const TinyCLR_Pwm_Controller* controller) {
+    auto entry = TinyCLR_Pwm_GetBurstEntry(controller);
+
+    if (entry == nullptr || !entry->BurstApi->IsBurstActive(controller))
+        return TinyCLR_Result::InvalidOperation;
+
+    return entry->BurstApi->StopBurst(controller);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <TinyCLR.h>
+
+#define TINYCLR_PWM_BURST_API_MAX_CONTROLLERS 4
+
+typedef void(*TinyCLR_Pwm_BurstCompletedHandler)(const TinyCLR_Pwm_Controller* self, uint64_t timestamp);
+
+// Multi channel output a target registers next to its PwmController. SetPulseParameters applies count
+// channel settings, and the frequency from the last SetDesiredFrequency, together at one period boundary.
+// StartBurst loads channelCount consecutive channels from firstChannel with the next of sets groups of
+// pulses once per period, replays them while looped and otherwise leaves the channels at the last group and
+// calls completed from the interrupt. Pulses are the target's compare values made by EncodeBurst for the
+// current frequency and polarity and must stay valid until IsBurstActive turns false. SetPulseParameters and
+// SetDesiredFrequency return Busy while a burst runs.
+struct TinyCLR_Pwm_BurstApi {
+    TinyCLR_Result(*SetPulseParameters)(const TinyCLR_Pwm_Controller* self, const uint32_t* channels, const double* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count);
+    TinyCLR_Result(*EncodeBurst)(const TinyCLR_Pwm_Controller* self, uint32_t channel, const double* dutyCycles, uint32_t* pulses, size_t count, size_t stride);
+    TinyCLR_Result(*StartBurst)(const TinyCLR_Pwm_Controller* self, uint32_t firstChannel, uint32_t channelCount, const uint32_t* pulses, size_t sets, bool looped, TinyCLR_Pwm_BurstCompletedHandler completed);
+    bool(*IsBurstActive)(const TinyCLR_Pwm_Controller* self);
+    TinyCLR_Result(*StopBurst)(const TinyCLR_Pwm_Controller* self);
+};
+
+bool TinyCLR_Pwm_SetBurstApi(const TinyCLR_Pwm_Controller* controller, const TinyCLR_Pwm_BurstApi* burstApi);
+const TinyCLR_Pwm_BurstApi* TinyCLR_Pwm_GetBurstApi(const TinyCLR_Pwm_Controller* controller);
+
+// Sets several channels of a controller at once, one by one through the controller when it has no burst API
+TinyCLR_Result TinyCLR_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* controller, const uint32_t* channels, const double* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count);
+
+// Plays sets groups of channelCount duty cycles, group n holding the channels from firstChannel in order,
+// from a pulse table kept per controller and grown from the memory manager. Pwm.BurstCompleted is raised
+// when a burst that isn't looped has loaded its last group.
+TinyCLR_Result TinyCLR_Pwm_StartBurst(const TinyCLR_Pwm_Controller* controller, uint32_t firstChannel, uint32_t channelCount, const double* dutyCycles, size_t sets, bool looped);
+TinyCLR_Result TinyCLR_Pwm_StopBurst(const TinyCLR_Pwm_Controller* controller);
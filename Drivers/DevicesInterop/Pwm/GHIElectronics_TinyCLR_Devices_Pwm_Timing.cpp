@@ -0,0 +1,108 @@
+#include "GHIElectronics_TinyCLR_Devices_Pwm_Timing.h"
+
+// The frequency of counts n misses by |clock - frequency * n| / n, in millihertz with clock scaled to match
+static uint64_t TinyCLR_Pwm_GetError(uint64_t clock, uint64_t frequency, uint64_t counts) {
+    auto product = frequency * counts;
+
+    return product > clock ? product - clock : clock - product;
+}
+
+static bool TinyCLR_Pwm_IsNearer(uint64_t clock, uint64_t frequency, uint64_t counts, uint64_t than) {
+    return TinyCLR_Pwm_GetError(clock, frequency, counts) * than < TinyCLR_Pwm_GetError(clock, frequency, than) * counts;
+}
+
+void TinyCLR_Pwm_SolveTiming(const TinyCLR_Pwm_Counter& counter, uint64_t frequency, uint32_t& prescaler, uint32_t& period) {
+    auto maxPrescaler = counter.MaxPrescaler;
+
+    if (counter.PowerOfTwoPrescaler)
+        while (maxPrescaler & (maxPrescaler - 1))
+            maxPrescaler &= maxPrescaler - 1;
+
+    prescaler = maxPrescaler;
+    period = counter.MaxPeriod;
+
+    if (frequency == 0)
+        return;
+
+    auto clock = static_cast<uint64_t>(counter.ClockHz) * TINYCLR_PWM_FREQUENCY_SCALE;
+    auto floor = clock / frequency;
+
+    if (floor >= static_cast<uint64_t>(maxPrescaler) * counter.MaxPeriod)
+        return;
+
+    prescaler = 1;
+    period = counter.MinPeriod;
+
+    if (floor < counter.MinPeriod)
+        return;
+
+    // no pair gets nearer than the better of the counts either side of the frequency
+    auto ideal = TinyCLR_Pwm_IsNearer(clock, frequency, floor + 1, floor) ? floor + 1 : floor;
+
+    auto first = static_cast<uint32_t>(floor / (static_cast<uint64_t>(counter.MaxPeriod) + 1) + 1);
+    auto candidate = counter.PowerOfTwoPrescaler ? 1U : first;
+
+    while (candidate < first)
+        candidate <<= 1;
+
+    uint64_t best = 0;
+
+    for (auto i = 0; i < TINYCLR_PWM_TIMING_MAX_PRESCALERS && candidate <= maxPrescaler && best != ideal; i++) {
+        auto below = floor / candidate;
+
+        for (auto p = below; p <= below + 1; p++) {
+            if (p < counter.MinPeriod || p > counter.MaxPeriod)
+                continue;
+
+            auto counts = candidate * p;
+
+            if (best == 0 || TinyCLR_Pwm_IsNearer(clock, frequency, counts, best)) {
+                best = counts;
+                prescaler = candidate;
+                period = static_cast<uint32_t>(p);
+            }
+        }
+
+        candidate = counter.PowerOfTwoPrescaler ? candidate << 1 : candidate + 1;
+    }
+}
+
+uint64_t TinyCLR_Pwm_GetFrequency(const TinyCLR_Pwm_Counter& counter, uint32_t prescaler, uint32_t period) {
+    auto counts = static_cast<uint64_t>(prescaler) * period;
+
+    if (counts == 0)
+        return 0;
+
+    return (static_cast<uint64_t>(counter.ClockHz) * TINYCLR_PWM_FREQUENCY_SCALE + counts / 2) / counts;
+}
+
+uint32_t TinyCLR_Pwm_GetPulse(uint32_t period, uint32_t dutyCycle) {
+    if (dutyCycle >= TINYCLR_PWM_DUTY_CYCLE_SCALE)
+        return period;
+
+    // period * dutyCycle / (64 * 15625), the division by 15625 done long hand in 16 bit digits so each step
+    // is a 32 bit division by a constant
+    auto product = (static_cast<uint64_t>(period) * dutyCycle) >> 6;
+    auto upper = static_cast<uint32_t>(product >> 16);
+    auto lower = (upper % 15625 << 16) | static_cast<uint32_t>(product & 0xFFFF);
+
+    return (upper / 15625 << 16) | lower / 15625;
+}
+
+uint64_t TinyCLR_Pwm_FromFrequency(double frequency) {
+    return frequency > 0.0 ? static_cast<uint64_t>(frequency * TINYCLR_PWM_FREQUENCY_SCALE + 0.5) : 0;
+}
+
+double TinyCLR_Pwm_ToFrequency(uint64_t frequency) {
+    return static_cast<double>(frequency) / TINYCLR_PWM_FREQUENCY_SCALE;
+}
+
+uint32_t TinyCLR_Pwm_FromDutyCycle(double dutyCycle) {
+    if (dutyCycle <= 0.0)
+        return 0;
+
+    if (dutyCycle >= 1.0)
+        return TINYCLR_PWM_DUTY_CYCLE_SCALE;
+
+    return static_cast<uint32_t>(dutyCycle * TINYCLR_PWM_DUTY_CYCLE_SCALE + 0.5);
+}
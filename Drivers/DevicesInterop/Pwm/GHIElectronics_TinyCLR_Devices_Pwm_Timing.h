@@ -0,0 +1,34 @@
+#pragma once
+
+#include <TinyCLR.h>
+
+#define TINYCLR_PWM_FREQUENCY_SCALE 1000 // frequencies in millihertz
+#define TINYCLR_PWM_DUTY_CYCLE_SCALE 1000000 // duty cycles in parts per million
+#define TINYCLR_PWM_TIMING_MAX_PRESCALERS 64
+
+// Counter behind a PWM controller. It counts at ClockHz / prescaler and a period lasts period counts, prescaler
+// being 1 to MaxPrescaler, only powers of two when PowerOfTwoPrescaler, and period MinPeriod to MaxPeriod. The
+// target turns the pair into its registers.
+struct TinyCLR_Pwm_Counter {
+    uint32_t ClockHz;
+    uint32_t MaxPrescaler;
+    bool PowerOfTwoPrescaler;
+    uint32_t MinPeriod;
+    uint32_t MaxPeriod;
+};
+
+// Prescaler and period whose frequency is nearest frequency, in millihertz, out of the pairs of the smallest
+// TINYCLR_PWM_TIMING_MAX_PRESCALERS prescalers a period fits. Among equally near pairs the smallest prescaler,
+// the finest duty cycle steps, wins. A frequency beyond the counter gets its shortest or longest period.
+void TinyCLR_Pwm_SolveTiming(const TinyCLR_Pwm_Counter& counter, uint64_t frequency, uint32_t& prescaler, uint32_t& period);
+
+// Frequency of a pair in millihertz, rounded to nearest
+uint64_t TinyCLR_Pwm_GetFrequency(const TinyCLR_Pwm_Counter& counter, uint32_t prescaler, uint32_t period);
+
+// Counts of a period a duty cycle in parts per million is active for, rounded down
+uint32_t TinyCLR_Pwm_GetPulse(uint32_t period, uint32_t dutyCycle);
+
+// The controller API works in double, these are the only conversions to and from it
+uint64_t TinyCLR_Pwm_FromFrequency(double frequency);
+double TinyCLR_Pwm_ToFrequency(uint64_t frequency);
+uint32_t TinyCLR_Pwm_FromDutyCycle(double dutyCycle);
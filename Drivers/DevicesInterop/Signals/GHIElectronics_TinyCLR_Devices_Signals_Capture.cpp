@@ -0,0 +1,58 @@
+#include <string.h>
+
+#include "GHIElectronics_TinyCLR_Devices_Signals_Capture.h"
+
+struct TinyCLR_Signals_CaptureApiEntry {
+    const TinyCLR_Gpio_Controller* Controller;
+    const TinyCLR_Signals_CaptureApi* CaptureApi;
+};
+
+static TinyCLR_Signals_CaptureApiEntry signalsCaptureApis[TINYCLR_SIGNALS_CAPTURE_API_MAX_CONTROLLERS];
+
+bool TinyCLR_Signals_SetCaptureApi(const TinyCLR_Gpio_Controller* controller, const TinyCLR_Signals_CaptureApi* captureApi) {
+    for (auto i = 0; i < TINYCLR_SIGNALS_CAPTURE_API_MAX_CONTROLLERS; i++) {
+        if (signalsCaptureApis[i].Controller == controller || signalsCaptureApis[i].Controller == nullptr) {
+            signalsCaptureApis[i].Controller = controller;
+            signalsCaptureApis[i].CaptureApi = captureApi;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const TinyCLR_Signals_CaptureApi* TinyCLR_Signals_GetCaptureApi(const TinyCLR_Gpio_Controller* controller) {
+    for (auto i = 0; i < TINYCLR_SIGNALS_CAPTURE_API_MAX_CONTROLLERS; i++)
+        if (signalsCaptureApis[i].Controller == controller)
+            return signalsCaptureApis[i].CaptureApi;
+
+    return nullptr;
+}
+
+uint64_t TinyCLR_Signals_GetCaptureDivider(uint64_t timeout, uint32_t clock, uint32_t counterBits) {
+    auto microseconds = timeout / 10 + 1;
+
+    if (microseconds > 0xFFFFFFFF || counterBits == 0 || counterBits > 32)
+        return 0;
+
+    auto ticks = microseconds * clock / 1000000;
+
+    return ticks / (1ULL << counterBits) + 1;
+}
+
+void TinyCLR_Signals_WidenCaptureTimestamps(TinyCLR_Interop_ClrObjectReference* arr, int32_t count, int32_t skip, uint64_t frequency) {
+    auto timestamps = reinterpret_cast<const uint8_t*>(arr);
+
+    for (auto i = count - 1; i >= 0; i--) {
+        uint32_t start = 0, end;
+
+        memcpy(&end, timestamps + (i + skip) * sizeof(uint32_t), sizeof(uint32_t));
+
+        if (i + skip > 0)
+            memcpy(&start, timestamps + (i + skip - 1) * sizeof(uint32_t), sizeof(uint32_t));
+
+        //Since TimeSpan and DateTime are stored inline, not as a proper object
+        arr[i].b = static_cast<uint64_t>(end - start) * 10000000 / frequency;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <TinyCLR.h>
+
+#define TINYCLR_SIGNALS_CAPTURE_API_MAX_CONTROLLERS 4
+
+typedef void(*TinyCLR_Signals_CaptureCompletedHandler)(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timestamp);
+
+// Edge timestamping a target registers next to its GpioController. Start arms a timer input capture
+// on pin that stores up to count edges, both directions, in ticks of frequency counted from zero at
+// Start, and calls completed from the interrupt that stores the last of them. The target picks its
+// tick rate so the counter doesn't wrap within timeout, in system time units. Pins without a capture
+// channel, or a channel already in use, return NotSupported.
+struct TinyCLR_Signals_CaptureApi {
+    TinyCLR_Result(*Start)(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timeout, uint32_t* timestamps, size_t count, uint64_t& frequency, TinyCLR_Signals_CaptureCompletedHandler completed);
+    size_t(*GetCount)(const TinyCLR_Gpio_Controller* self);
+    size_t(*Stop)(const TinyCLR_Gpio_Controller* self);
+};
+
+bool TinyCLR_Signals_SetCaptureApi(const TinyCLR_Gpio_Controller* controller, const TinyCLR_Signals_CaptureApi* captureApi);
+const TinyCLR_Signals_CaptureApi* TinyCLR_Signals_GetCaptureApi(const TinyCLR_Gpio_Controller* controller);
+
+// Smallest clock divider that keeps timeout within a counter of counterBits when counting at clock,
+// zero when no divider does.
+uint64_t TinyCLR_Signals_GetCaptureDivider(uint64_t timeout, uint32_t clock, uint32_t counterBits);
+
+// Turns the 32 bit timestamps Start stored at the front of arr into the durations between them in system time
+// units, the first skip timestamps only starting the first duration. Widened in place from the back, each 64 bit
+// entry only covers timestamps already read.
+void TinyCLR_Signals_WidenCaptureTimestamps(TinyCLR_Interop_ClrObjectReference* arr, int32_t count, int32_t skip, uint64_t frequency);
@@ -1,4 +1,51 @@
 #include "GHIElectronics_TinyCLR_Devices_Signals.h"
+#include "GHIElectronics_TinyCLR_Devices_Signals_Capture.h"
+
+static volatile bool signalCaptureCompleted;
+
+static void SignalCapture_Completed(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timestamp) {
+    signalCaptureCompleted = true;
+}
+
+// Times the edges with the target's input capture when the pin has one. The 32 bit timestamps land in
+// the front half of the TimeSpan array and are widened in place from the back, so no buffer is needed.
+static bool SignalCapture_ReadHardware(const TinyCLR_Gpio_Controller* gpio, uint32_t pin, bool waitForInitial, TinyCLR_Gpio_PinValue initialState, TinyCLR_Gpio_PinValue& currentState, TinyCLR_Interop_ClrObjectReference* arr, int32_t len, uint64_t timeout, const TinyCLR_NativeTime_Controller* time, const TinyCLR_Interrupt_Controller* interrupt, int32_t& count) {
+    auto captureApi = TinyCLR_Signals_GetCaptureApi(gpio);
+
+    if (captureApi == nullptr || len <= 0)
+        return false;
+
+    gpio->Read(gpio, pin, currentState);
+
+    // Waiting for the initial state takes one more edge, the one that reaches it
+    auto skip = (waitForInitial && currentState != initialState) ? 1 : 0;
+    auto total = static_cast<size_t>(len + skip);
+    uint64_t frequency;
+
+    signalCaptureCompleted = false;
+
+    if (captureApi->Start(gpio, pin, timeout, reinterpret_cast<uint32_t*>(arr), total, frequency, &SignalCapture_Completed) != TinyCLR_Result::Success)
+        return false;
+
+    auto endTime = time->GetNativeTime(time) + time->ConvertSystemTimeToNativeTime(time, timeout);
+
+    // Sleep until the last edge's interrupt, any other interrupt (the system timer's among them) only checks the timeout.
+    // Interrupts stay masked from the check to the sleep, which they still end, so a completion in between isn't missed.
+    interrupt->Disable();
+
+    while (!signalCaptureCompleted && time->GetNativeTime(time) < endTime)
+        interrupt->WaitForInterrupt();
+
+    interrupt->Enable();
+
+    auto captured = static_cast<int32_t>(captureApi->Stop(gpio));
+
+    count = captured > skip ? captured - skip : 0;
+
+    TinyCLR_Signals_WidenCaptureTimestamps(arr, count, skip, frequency);
+
+    return true;
+}
 
 TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Signals_GHIElectronics_TinyCLR_Devices_Signals_SignalCapture::Read___I4__BYREF_GHIElectronicsTinyCLRDevicesGpioGHIElectronicsTinyCLRDevicesGpioGpioPinValue__SZARRAY_mscorlibSystemTimeSpan__I4__I4(const TinyCLR_Interop_MethodData md) {
     TinyCLR_Interop_ClrValue ret, initialArg, arrArg, offsetArg, countArg, apiFld, pinFld, disableFld, timeoutFld;
@@ -28,6 +75,15 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Signals_GHIElectronics_Tin
     auto currentState = TinyCLR_Gpio_PinValue::Low;
     auto nextState = TinyCLR_Gpio_PinValue::Low;
 
+    int32_t count = 0;
+
+    if (SignalCapture_ReadHardware(gpio, pin, false, currentState, currentState, arr, len, timeout, time, interrupt, count)) {
+        initialArg.Data.Numeric->I4 = static_cast<int32_t>(currentState);
+        ret.Data.Numeric->I4 = count;
+
+        return TinyCLR_Result::Success;
+    }
+
     if (disableInterrupts)
         interrupt->Disable();
 
@@ -37,7 +93,6 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Signals_GHIElectronics_Tin
 
     nextState = currentState == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinValue::Low : TinyCLR_Gpio_PinValue::High;
 
-    int32_t count = 0;
     auto currentTime = time->GetNativeTime(time);
     auto lastTime = currentTime;
     auto endTime = currentTime + time->ConvertSystemTimeToNativeTime(time, timeout);
@@ -96,6 +151,13 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Signals_GHIElectronics_Tin
     auto nextState = static_cast<TinyCLR_Gpio_PinValue>(initialArg.Data.Numeric->I4);
 
     int32_t count = 0;
+
+    if (SignalCapture_ReadHardware(gpio, pin, true, nextState, currentState, arr, len, timeout, time, interrupt, count)) {
+        ret.Data.Numeric->I4 = count;
+
+        return TinyCLR_Result::Success;
+    }
+
     auto currentTime = time->GetNativeTime(time);
     auto lastTime = currentTime;
     auto endTime = currentTime + time->ConvertSystemTimeToNativeTime(time, timeout);
@@ -1,4 +1,50 @@
 #include "GHIElectronics_TinyCLR_Devices_Signals.h"
+#include "GHIElectronics_TinyCLR_Devices_Signals_Generator.h"
+
+static void SignalGenerator_WriteCompleted(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timestamp) {
+    extern const TinyCLR_Api_Manager* apiManager;
+    auto interopManager = reinterpret_cast<const TinyCLR_Interop_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::InteropManager));
+
+    if (interopManager != nullptr)
+        interopManager->RaiseEvent(interopManager, "GHIElectronics.TinyCLR.NativeEventNames.Signals.WriteCompleted", self->ApiInfo->Name, (uint64_t)pin, 0, 0, 0, timestamp);
+}
+
+// Hands the waveform to a timer compare channel when the pin has one and returns once it is running,
+// WriteCompleted is raised when the pin is back at idle. Anything it can't time falls back to the loop.
+static bool SignalGenerator_WriteHardware(const TinyCLR_Gpio_Controller* gpio, uint32_t pin, TinyCLR_Gpio_PinValue idleState, const TinyCLR_Interop_ClrObjectReference* arr, int32_t len, uint32_t carrierFrequency, uint64_t carrierTicks, const TinyCLR_Interrupt_Controller* interrupt) {
+    auto generatorApi = TinyCLR_Signals_GetGeneratorApi(gpio);
+
+    if (generatorApi == nullptr || len <= 0 || (carrierFrequency > 0 && carrierTicks == 0))
+        return false;
+
+    // The edge table is still in use by the previous waveform, its completion interrupt ends the sleep. Interrupts stay
+    // masked from the check to the sleep, which they still end, so a completion in between isn't missed.
+    interrupt->Disable();
+
+    while (generatorApi->IsActive(gpio))
+        interrupt->WaitForInterrupt();
+
+    interrupt->Enable();
+
+    for (auto i = 0; i < len; i++)
+        if (arr[i].b <= carrierTicks)
+            return false;
+
+    uint32_t clock, counterBits, divider;
+
+    if (generatorApi->GetTiming(gpio, pin, clock, counterBits) != TinyCLR_Result::Success)
+        return false;
+
+    auto count = TinyCLR_Signals_CompileEdges(arr, len, idleState, carrierFrequency, clock, counterBits, divider, nullptr);
+    auto edges = count > 0 ? TinyCLR_Signals_GetGeneratorEdges(gpio, count) : nullptr;
+
+    if (edges == nullptr)
+        return false;
+
+    TinyCLR_Signals_CompileEdges(arr, len, idleState, carrierFrequency, clock, counterBits, divider, edges);
+
+    return generatorApi->Start(gpio, pin, idleState, divider, edges, count, &SignalGenerator_WriteCompleted) == TinyCLR_Result::Success;
+}
 
 TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Signals_GHIElectronics_TinyCLR_Devices_Signals_SignalGenerator::Write___VOID__SZARRAY_mscorlibSystemTimeSpan__I4__I4(const TinyCLR_Interop_MethodData md) {
     TinyCLR_Interop_ClrValue arrArg, offsetArg, countArg, apiFld, pinFld, idleFld, disableFld, generateFld, freqFld;
@@ -34,12 +80,16 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Signals_GHIElectronics_Tin
 
     gpio->Write(gpio, pin, idleState);
 
+    if (generateCarrierFrequency && (carrierFrequency > 0))
+        carrierTicks = (1000000 / 2 / carrierFrequency) * 10;
+
+    if (SignalGenerator_WriteHardware(gpio, pin, idleState, arr, len, generateCarrierFrequency ? carrierFrequency : 0, carrierTicks, interrupt))
+        return TinyCLR_Result::Success;
+
     if (disableInterrupts)
         interrupt->Disable();
 
     if (generateCarrierFrequency && (carrierFrequency > 0)) {
-        carrierTicks = (1000000 / 2 / carrierFrequency) * 10;
-
         if (carrierTicks == 0) {
             error = TinyCLR_Result::ArgumentInvalid;
 
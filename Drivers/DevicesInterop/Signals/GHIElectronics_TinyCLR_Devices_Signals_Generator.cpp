@@ -0,0 +1,152 @@
+#include "GHIElectronics_TinyCLR_Devices_Signals_Generator.h"
+
+#define SIGNALS_SYSTEM_TIME_HZ 10000000ULL
+
+struct TinyCLR_Signals_GeneratorApiEntry {
+    const TinyCLR_Gpio_Controller* Controller;
+    const TinyCLR_Signals_GeneratorApi* GeneratorApi;
+
+    uint32_t* Edges;
+    size_t EdgeCapacity;
+};
+
+static TinyCLR_Signals_GeneratorApiEntry signalsGeneratorApis[TINYCLR_SIGNALS_GENERATOR_API_MAX_CONTROLLERS];
+
+bool TinyCLR_Signals_SetGeneratorApi(const TinyCLR_Gpio_Controller* controller, const TinyCLR_Signals_GeneratorApi* generatorApi) {
+    for (auto i = 0; i < TINYCLR_SIGNALS_GENERATOR_API_MAX_CONTROLLERS; i++) {
+        if (signalsGeneratorApis[i].Controller == controller || signalsGeneratorApis[i].Controller == nullptr) {
+            signalsGeneratorApis[i].Controller = controller;
+            signalsGeneratorApis[i].GeneratorApi = generatorApi;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const TinyCLR_Signals_GeneratorApi* TinyCLR_Signals_GetGeneratorApi(const TinyCLR_Gpio_Controller* controller) {
+    for (auto i = 0; i < TINYCLR_SIGNALS_GENERATOR_API_MAX_CONTROLLERS; i++)
+        if (signalsGeneratorApis[i].Controller == controller)
+            return signalsGeneratorApis[i].GeneratorApi;
+
+    return nullptr;
+}
+
+uint32_t* TinyCLR_Signals_GetGeneratorEdges(const TinyCLR_Gpio_Controller* controller, size_t count) {
+    extern const TinyCLR_Api_Manager* apiManager;
+
+    for (auto i = 0; i < TINYCLR_SIGNALS_GENERATOR_API_MAX_CONTROLLERS; i++) {
+        auto& entry = signalsGeneratorApis[i];
+
+        if (entry.Controller != controller)
+            continue;
+
+        if (entry.EdgeCapacity >= count)
+            return entry.Edges;
+
+        auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
+
+        if (memoryManager == nullptr)
+            return nullptr;
+
+        if (entry.Edges != nullptr)
+            memoryManager->Free(memoryManager, entry.Edges);
+
+        entry.EdgeCapacity = 0;
+        entry.Edges = reinterpret_cast<uint32_t*>(memoryManager->Allocate(memoryManager, count * sizeof(uint32_t)));
+
+        if (entry.Edges != nullptr)
+            entry.EdgeCapacity = count;
+
+        return entry.Edges;
+    }
+
+    return nullptr;
+}
+
+struct TinyCLR_Signals_EdgeCompiler {
+    uint32_t* Edges;
+    size_t Count;
+
+    uint64_t LastTick;
+    uint64_t MaxTick;
+    TinyCLR_Gpio_PinValue Level;
+};
+
+// One tick of lead in keeps the first edge off the counter's reset value
+static bool TinyCLR_Signals_AddEdge(TinyCLR_Signals_EdgeCompiler& compiler, uint64_t tick, TinyCLR_Gpio_PinValue level) {
+    if (level == compiler.Level)
+        return true;
+
+    tick++;
+
+    if (tick <= compiler.LastTick || tick > compiler.MaxTick)
+        return false;
+
+    if (compiler.Edges != nullptr)
+        compiler.Edges[compiler.Count] = static_cast<uint32_t>(tick);
+
+    compiler.Count++;
+    compiler.LastTick = tick;
+    compiler.Level = level;
+
+    return true;
+}
+
+size_t TinyCLR_Signals_CompileEdges(const TinyCLR_Interop_ClrObjectReference* durations, size_t count, TinyCLR_Gpio_PinValue idleState, uint32_t carrierFrequency, uint32_t clock, uint32_t counterBits, uint32_t& divider, uint32_t* edges) {
+    if (count == 0 || clock == 0 || counterBits < 2 || counterBits > 32)
+        return 0;
+
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        total += durations[i].b;
+
+        if (total > 0xFFFFFFFFFFFFFFFFULL / clock)
+            return 0;
+    }
+
+    // Ticks at full clock of the whole waveform, rounded up, plus the lead in tick
+    auto maxTick = (1ULL << counterBits) - 1;
+    auto fullTicks = (total * clock + SIGNALS_SYSTEM_TIME_HZ - 1) / SIGNALS_SYSTEM_TIME_HZ + 1;
+    auto smallest = fullTicks / maxTick + 1;
+
+    if (smallest > 0xFFFFFFFF)
+        return 0;
+
+    divider = static_cast<uint32_t>(smallest);
+
+    auto scale = divider * SIGNALS_SYSTEM_TIME_HZ;
+    auto halfPeriod = 2ULL * carrierFrequency * divider;
+
+    TinyCLR_Signals_EdgeCompiler compiler = { edges, 0, 0, maxTick, idleState };
+
+    auto next = idleState;
+    uint64_t time = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        auto start = (time * clock + scale / 2) / scale;
+
+        next = next == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinValue::Low : TinyCLR_Gpio_PinValue::High;
+
+        if (next != idleState && carrierFrequency > 0) {
+            // Whole half periods that fit, each placed from the start of the mark so the carrier doesn't drift
+            auto halfPeriods = durations[i].b * 2 * carrierFrequency / SIGNALS_SYSTEM_TIME_HZ;
+
+            for (auto k = 0ULL; k < halfPeriods; k++)
+                if (!TinyCLR_Signals_AddEdge(compiler, start + (k * clock + halfPeriod / 2) / halfPeriod, (k % 2 == 0) ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low))
+                    return 0;
+        }
+        else if (!TinyCLR_Signals_AddEdge(compiler, start, next)) {
+            return 0;
+        }
+
+        time += durations[i].b;
+    }
+
+    if (!TinyCLR_Signals_AddEdge(compiler, (time * clock + scale / 2) / scale, idleState))
+        return 0;
+
+    return compiler.Count;
+}
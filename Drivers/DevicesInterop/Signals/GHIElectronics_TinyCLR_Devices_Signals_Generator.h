@@ -0,0 +1,33 @@
+#pragma once
+
+#include <TinyCLR.h>
+
+#define TINYCLR_SIGNALS_GENERATOR_API_MAX_CONTROLLERS 4
+
+typedef void(*TinyCLR_Signals_GeneratorCompletedHandler)(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timestamp);
+
+// Waveform output a target registers next to its GpioController. GetTiming reports the clock and
+// counter width of the timer channel behind pin. Start drives pin from idleState and toggles it
+// when a counter counting clock / divider from zero reaches each of the count edges, then hands the
+// pin back to the GPIO driver at idleState and calls completed from the interrupt. edges must stay
+// valid until IsActive turns false. Pins without a compare channel, or a channel already in use,
+// return NotSupported.
+struct TinyCLR_Signals_GeneratorApi {
+    TinyCLR_Result(*GetTiming)(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint32_t& clock, uint32_t& counterBits);
+    TinyCLR_Result(*Start)(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinValue idleState, uint32_t divider, const uint32_t* edges, size_t count, TinyCLR_Signals_GeneratorCompletedHandler completed);
+    bool(*IsActive)(const TinyCLR_Gpio_Controller* self);
+};
+
+bool TinyCLR_Signals_SetGeneratorApi(const TinyCLR_Gpio_Controller* controller, const TinyCLR_Signals_GeneratorApi* generatorApi);
+const TinyCLR_Signals_GeneratorApi* TinyCLR_Signals_GetGeneratorApi(const TinyCLR_Gpio_Controller* controller);
+
+// Edge table kept per controller for Start, grown from the memory manager. Only valid to call
+// while the controller's generator isn't active. nullptr when out of memory.
+uint32_t* TinyCLR_Signals_GetGeneratorEdges(const TinyCLR_Gpio_Controller* controller, size_t count);
+
+// Compiles SignalGenerator durations, in system time units, into compare values of a counter of
+// counterBits counting clock / divider: the pin toggles from idleState at each edge and is back at
+// idleState after the last one. With a carrierFrequency, the durations away from idle become a square
+// wave starting High like the software generator. divider is the smallest that fits the whole waveform.
+// edges may be nullptr to only count them. Zero when the waveform can't be timed by such a counter.
+size_t TinyCLR_Signals_CompileEdges(const TinyCLR_Interop_ClrObjectReference* durations, size_t count, TinyCLR_Gpio_PinValue idleState, uint32_t carrierFrequency, uint32_t clock, uint32_t counterBits, uint32_t& divider, uint32_t* edges);
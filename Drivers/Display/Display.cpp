@@ -0,0 +1,683 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include "Display.h"
+#include <Device.h>
+
+// 16x16 RGB565 pixels touch 16 source lines of 32 bytes each, which fits the smallest data cache we run on.
+#ifndef DISPLAY_ROTATION_TILE_SIZE
+#define DISPLAY_ROTATION_TILE_SIZE 16
+#endif
+
+#define __min(a,b)  (((a) < (b)) ? (a) : (b))
+
+// Writes count pixels to a destination row, walking the source by step pixels per destination pixel.
+// Pixels are stored in pairs as one 32 bit little endian word once the destination is word aligned.
+static inline void Display_WriteRgb565Row(uint16_t* destination, const uint16_t* source, int32_t step, int32_t count) {
+    if (count > 0 && (reinterpret_cast<uintptr_t>(destination) & 2)) {
+        *destination++ = *source;
+        source += step;
+        count--;
+    }
+
+    auto destination32 = reinterpret_cast<uint32_t*>(destination);
+
+    if (step == -1 && (reinterpret_cast<uintptr_t>(source - 1) & 3) == 0) {
+        // Reversed row with a word aligned source: load two pixels at once and swap the halves.
+        while (count >= 2) {
+            auto pair = *reinterpret_cast<const uint32_t*>(source - 1);
+
+            *destination32++ = (pair >> 16) | (pair << 16);
+            source -= 2;
+            count -= 2;
+        }
+    }
+    else {
+        while (count >= 2) {
+            *destination32++ = static_cast<uint32_t>(source[0]) | (static_cast<uint32_t>(source[step]) << 16);
+            source += step * 2;
+            count -= 2;
+        }
+    }
+
+    if (count > 0)
+        *reinterpret_cast<uint16_t*>(destination32) = *source;
+}
+
+void Display_RotateRgb565Cw90(const uint16_t* source, int32_t sourceStride, uint16_t* destination, int32_t destinationStride, int32_t width, int32_t height) {
+    // destination[row][column] = source[height - 1 - column][row]
+    for (auto row = 0; row < width; row += DISPLAY_ROTATION_TILE_SIZE) {
+        auto rows = __min(DISPLAY_ROTATION_TILE_SIZE, width - row);
+
+        for (auto column = 0; column < height; column += DISPLAY_ROTATION_TILE_SIZE) {
+            auto columns = __min(DISPLAY_ROTATION_TILE_SIZE, height - column);
+
+            for (auto r = row; r < row + rows; r++)
+                Display_WriteRgb565Row(destination + r * destinationStride + column, source + (height - 1 - column) * sourceStride + r, -sourceStride, columns);
+        }
+    }
+}
+
+void Display_RotateRgb565Ccw90(const uint16_t* source, int32_t sourceStride, uint16_t* destination, int32_t destinationStride, int32_t width, int32_t height) {
+    // destination[row][column] = source[column][width - 1 - row]
+    for (auto row = 0; row < width; row += DISPLAY_ROTATION_TILE_SIZE) {
+        auto rows = __min(DISPLAY_ROTATION_TILE_SIZE, width - row);
+
+        for (auto column = 0; column < height; column += DISPLAY_ROTATION_TILE_SIZE) {
+            auto columns = __min(DISPLAY_ROTATION_TILE_SIZE, height - column);
+
+            for (auto r = row; r < row + rows; r++)
+                Display_WriteRgb565Row(destination + r * destinationStride + column, source + column * sourceStride + (width - 1 - r), sourceStride, columns);
+        }
+    }
+}
+
+void Display_RotateRgb565180(const uint16_t* source, int32_t sourceStride, uint16_t* destination, int32_t destinationStride, int32_t width, int32_t height) {
+    // destination[row][column] = source[height - 1 - row][width - 1 - column], rows are already sequential so no tiling is needed.
+    for (auto row = 0; row < height; row++)
+        Display_WriteRgb565Row(destination + row * destinationStride, source + (height - 1 - row) * sourceStride + (width - 1), -1, width);
+}
+
+#ifndef DISPLAY_DAMAGE_TRACKING_DEFAULT
+#define DISPLAY_DAMAGE_TRACKING_DEFAULT false
+#endif
+
+#ifndef DISPLAY_DAMAGE_MAX_BANDS
+#define DISPLAY_DAMAGE_MAX_BANDS 16
+#endif
+
+static bool display_DamageTracking = DISPLAY_DAMAGE_TRACKING_DEFAULT;
+static Display_DamageStatistics display_DamageStatistics;
+static Display_DirtyBand display_DirtyBands[DISPLAY_DAMAGE_MAX_BANDS];
+static int32_t display_DirtyBandCount;
+
+void Display_SetDamageTracking(bool enable) {
+    display_DamageTracking = enable;
+
+    memset(&display_DamageStatistics, 0, sizeof(display_DamageStatistics));
+
+    display_DirtyBandCount = 0;
+}
+
+bool Display_IsDamageTrackingEnabled() {
+    return display_DamageTracking;
+}
+
+void Display_GetDamageStatistics(Display_DamageStatistics& statistics) {
+    statistics = display_DamageStatistics;
+}
+
+int32_t Display_GetDirtyBands(Display_DirtyBand* bands, int32_t count) {
+    for (auto i = 0; i < count && i < display_DirtyBandCount; i++)
+        bands[i] = display_DirtyBands[i];
+
+    return display_DirtyBandCount;
+}
+
+// Returns the index of the first pixel that differs, or count if the rows match.
+static int32_t Display_FindFirstDifference(const uint16_t* a, const uint16_t* b, int32_t count) {
+    auto i = 0;
+
+    if (((reinterpret_cast<uintptr_t>(a) ^ reinterpret_cast<uintptr_t>(b)) & 2) == 0) {
+        if ((reinterpret_cast<uintptr_t>(a) & 2) && count > 0) {
+            if (a[0] != b[0])
+                return 0;
+
+            i++;
+        }
+
+        auto a32 = reinterpret_cast<const uint32_t*>(a + i);
+        auto b32 = reinterpret_cast<const uint32_t*>(b + i);
+
+        while (i + 2 <= count && *a32 == *b32) {
+            a32++;
+            b32++;
+            i += 2;
+        }
+    }
+
+    while (i < count && a[i] == b[i])
+        i++;
+
+    return i;
+}
+
+// Returns the index of the last pixel that differs, or first - 1 if none from first on do.
+static int32_t Display_FindLastDifference(const uint16_t* a, const uint16_t* b, int32_t first, int32_t count) {
+    auto i = count - 1;
+
+    if (((reinterpret_cast<uintptr_t>(a) ^ reinterpret_cast<uintptr_t>(b)) & 2) == 0) {
+        if ((reinterpret_cast<uintptr_t>(a + i) & 2) == 0 && i >= first) {
+            if (a[i] != b[i])
+                return i;
+
+            i--;
+        }
+
+        while (i - 1 >= first && *reinterpret_cast<const uint32_t*>(a + i - 1) == *reinterpret_cast<const uint32_t*>(b + i - 1))
+            i -= 2;
+    }
+
+    while (i >= first && a[i] == b[i])
+        i--;
+
+    return i;
+}
+
+bool Display_CopyChangedRgb565(const uint16_t* source, int32_t sourceStride, uint16_t* destination, int32_t destinationStride, int32_t width, int32_t height) {
+    auto& statistics = display_DamageStatistics;
+    auto inBand = false;
+
+    statistics.Frames++;
+    statistics.UnchangedPixels = 0;
+    statistics.CopiedPixels = 0;
+    statistics.ChangedRows = 0;
+    statistics.Bands = 0;
+    statistics.DirtyLeft = width;
+    statistics.DirtyTop = height;
+    statistics.DirtyRight = 0;
+    statistics.DirtyBottom = 0;
+
+    display_DirtyBandCount = 0;
+
+    for (auto row = 0; row < height; row++, source += sourceStride, destination += destinationStride) {
+        auto first = Display_FindFirstDifference(source, destination, width);
+
+        if (first == width) {
+            statistics.UnchangedPixels += width;
+            inBand = false;
+
+            continue;
+        }
+
+        auto last = Display_FindLastDifference(source, destination, first, width);
+        auto count = last - first + 1;
+
+        memcpy(destination + first, source + first, count * sizeof(uint16_t));
+
+        statistics.UnchangedPixels += width - count;
+        statistics.CopiedPixels += count;
+        statistics.ChangedRows++;
+
+        if (!inBand) {
+            statistics.Bands++;
+            inBand = true;
+
+            if (display_DirtyBandCount < DISPLAY_DAMAGE_MAX_BANDS)
+                display_DirtyBands[display_DirtyBandCount++] = { first, row, last + 1, row + 1 };
+        }
+
+        auto& band = display_DirtyBands[display_DirtyBandCount - 1];
+
+        band.Left = __min(band.Left, first);
+        band.Right = band.Right > last + 1 ? band.Right : last + 1;
+        band.Bottom = row + 1;
+
+        statistics.DirtyLeft = __min(statistics.DirtyLeft, first);
+        statistics.DirtyRight = statistics.DirtyRight > last + 1 ? statistics.DirtyRight : last + 1;
+        statistics.DirtyTop = __min(statistics.DirtyTop, row);
+        statistics.DirtyBottom = row + 1;
+    }
+
+    if (statistics.ChangedRows == 0) {
+        statistics.DirtyLeft = 0;
+        statistics.DirtyTop = 0;
+    }
+
+    return statistics.ChangedRows != 0;
+}
+
+static bool display_FlipDeferred = false;
+
+void Display_SetFlipDeferred(bool defer) {
+    display_FlipDeferred = defer;
+}
+
+bool Display_IsFlipDeferred() {
+    return display_FlipDeferred;
+}
+
+static Display_FrameCompleteHandler display_FrameCompleteHandler = nullptr;
+
+void Display_SetFrameCompleteHandler(Display_FrameCompleteHandler handler) {
+    display_FrameCompleteHandler = handler;
+}
+
+void Display_RaiseFrameComplete(const TinyCLR_Display_Controller* self, uint64_t timestamp) {
+    auto handler = display_FrameCompleteHandler;
+
+    if (handler != nullptr)
+        handler(self, timestamp);
+}
+
+#ifndef DISPLAY_CONVERSION_BAND_PIXELS
+#define DISPLAY_CONVERSION_BAND_PIXELS 1024
+#endif
+
+static uint16_t display_ConversionBand[DISPLAY_CONVERSION_BAND_PIXELS];
+
+// Stores count RGB565 pixels produced by convert(i), in pairs once the destination is word aligned.
+template<typename T> static inline void Display_StoreRgb565Row(uint16_t* destination, int32_t count, T convert) {
+    auto i = 0;
+
+    if (count > 0 && (reinterpret_cast<uintptr_t>(destination) & 2))
+        destination[i++] = convert(0);
+
+    auto destination32 = reinterpret_cast<uint32_t*>(destination + i);
+
+    for (; i + 2 <= count; i += 2)
+        *destination32++ = convert(i) | (static_cast<uint32_t>(convert(i + 1)) << 16);
+
+    if (i < count)
+        destination[i] = convert(i);
+}
+
+static inline uint32_t Display_Rgb565ToRgb888(uint32_t p) {
+    auto r = (p >> 11) & 0x1F;
+    auto g = (p >> 5) & 0x3F;
+    auto b = p & 0x1F;
+
+    return (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+}
+
+static inline uint16_t Display_Rgb888ToRgb565(uint32_t p) {
+    return static_cast<uint16_t>(((p >> 8) & 0xF800) | ((p >> 5) & 0x07E0) | ((p >> 3) & 0x001F));
+}
+
+void Display_ConvertRgb565ToRgb888(const uint16_t* source, uint8_t* destination, int32_t count) {
+    auto i = 0;
+
+    if ((reinterpret_cast<uintptr_t>(destination) & 3) == 0) {
+        // Four pixels fill exactly three words.
+        auto destination32 = reinterpret_cast<uint32_t*>(destination);
+
+        for (; i + 4 <= count; i += 4) {
+            auto c0 = Display_Rgb565ToRgb888(source[i + 0]);
+            auto c1 = Display_Rgb565ToRgb888(source[i + 1]);
+            auto c2 = Display_Rgb565ToRgb888(source[i + 2]);
+            auto c3 = Display_Rgb565ToRgb888(source[i + 3]);
+
+            *destination32++ = c0 | (c1 << 24);
+            *destination32++ = (c1 >> 8) | (c2 << 16);
+            *destination32++ = (c2 >> 16) | (c3 << 8);
+        }
+    }
+
+    for (; i < count; i++) {
+        auto c = Display_Rgb565ToRgb888(source[i]);
+
+        destination[i * 3 + 0] = c & 0xFF;
+        destination[i * 3 + 1] = (c >> 8) & 0xFF;
+        destination[i * 3 + 2] = (c >> 16) & 0xFF;
+    }
+}
+
+void Display_ConvertRgb888ToRgb565(const uint8_t* source, uint16_t* destination, int32_t count) {
+    auto i = 0;
+
+    if ((reinterpret_cast<uintptr_t>(source) & 3) == 0 && (reinterpret_cast<uintptr_t>(destination) & 3) == 0) {
+        auto source32 = reinterpret_cast<const uint32_t*>(source);
+        auto destination32 = reinterpret_cast<uint32_t*>(destination);
+
+        for (; i + 4 <= count; i += 4) {
+            auto w0 = *source32++;
+            auto w1 = *source32++;
+            auto w2 = *source32++;
+
+            *destination32++ = Display_Rgb888ToRgb565(w0) | (static_cast<uint32_t>(Display_Rgb888ToRgb565((w0 >> 24) | (w1 << 8))) << 16);
+            *destination32++ = Display_Rgb888ToRgb565((w1 >> 16) | (w2 << 16)) | (static_cast<uint32_t>(Display_Rgb888ToRgb565(w2 >> 8)) << 16);
+        }
+    }
+
+    for (; i < count; i++)
+        destination[i] = Display_Rgb888ToRgb565(source[i * 3] | (source[i * 3 + 1] << 8) | (source[i * 3 + 2] << 16));
+}
+
+void Display_ConvertArgb8888ToRgb565(const uint32_t* source, uint16_t* destination, int32_t count, bool dither, int32_t x, int32_t y) {
+    if (!dither) {
+        Display_StoreRgb565Row(destination, count, [source](int32_t i) { return Display_Rgb888ToRgb565(source[i]); });
+
+        return;
+    }
+
+    // 4x4 Bayer thresholds, scaled per channel to the bits that RGB565 drops.
+    static const uint8_t bayer[4][4] = { { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+
+    auto thresholds = bayer[y & 3];
+
+    Display_StoreRgb565Row(destination, count, [source, thresholds, x](int32_t i) {
+        auto p = source[i];
+        auto d = thresholds[(x + i) & 3];
+        auto r = ((p >> 16) & 0xFF) + (d >> 1);
+        auto g = ((p >> 8) & 0xFF) + (d >> 2);
+        auto b = (p & 0xFF) + (d >> 1);
+
+        r = r > 0xFF ? 0xFF : r;
+        g = g > 0xFF ? 0xFF : g;
+        b = b > 0xFF ? 0xFF : b;
+
+        return static_cast<uint16_t>(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+    });
+}
+
+void Display_ConvertL8ToRgb565(const uint8_t* source, uint16_t* destination, int32_t count, const uint16_t* palette) {
+    Display_StoreRgb565Row(destination, count, [source, palette](int32_t i) { return palette[source[i]]; });
+}
+
+// Dither is anchored at column x and row y of the screen so that bands drawn separately line up.
+static void Display_ConvertRowsToRgb565(Display_PixelFormat format, const uint8_t* source, int32_t sourceStride, const uint16_t* palette, bool dither, uint16_t* destination, int32_t destinationStride, int32_t width, int32_t height, int32_t x, int32_t y) {
+    for (auto row = 0; row < height; row++, source += sourceStride, destination += destinationStride) {
+        switch (format) {
+        case Display_PixelFormat::Rgb565:
+            memcpy(destination, source, width * sizeof(uint16_t));
+            break;
+
+        case Display_PixelFormat::Rgb888:
+            Display_ConvertRgb888ToRgb565(source, destination, width);
+            break;
+
+        case Display_PixelFormat::Argb8888:
+            Display_ConvertArgb8888ToRgb565(reinterpret_cast<const uint32_t*>(source), destination, width, dither, x, y + row);
+            break;
+
+        case Display_PixelFormat::L8:
+            Display_ConvertL8ToRgb565(source, destination, width, palette);
+            break;
+        }
+    }
+}
+
+static int32_t Display_GetBytesPerPixel(Display_PixelFormat format) {
+    switch (format) {
+    case Display_PixelFormat::Rgb565: return 2;
+    case Display_PixelFormat::Rgb888: return 3;
+    case Display_PixelFormat::Argb8888: return 4;
+    case Display_PixelFormat::L8: return 1;
+    }
+
+    return 0;
+}
+
+bool Display_ConvertToRgb565(Display_PixelFormat format, const uint8_t* source, int32_t sourceStride, const uint16_t* palette, bool dither, uint16_t* destination, int32_t destinationStride, int32_t width, int32_t height) {
+    if (Display_GetBytesPerPixel(format) == 0 || (format == Display_PixelFormat::L8 && palette == nullptr))
+        return false;
+
+    Display_ConvertRowsToRgb565(format, source, sourceStride, palette, dither, destination, destinationStride, width, height, 0, 0);
+
+    return true;
+}
+
+TinyCLR_Result Display_DrawConvertedBuffer(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint32_t width, uint32_t height, Display_PixelFormat format, const uint8_t* data, const uint16_t* palette, bool dither) {
+    auto bytesPerPixel = Display_GetBytesPerPixel(format);
+
+    if (bytesPerPixel == 0 || (format == Display_PixelFormat::L8 && palette == nullptr))
+        return TinyCLR_Result::ArgumentInvalid;
+
+    if (format == Display_PixelFormat::Rgb565 || width == 0 || height == 0)
+        return self->DrawBuffer(self, x, y, width, height, data);
+
+    auto sourceStride = static_cast<int32_t>(width) * bytesPerPixel;
+    auto memoryManager = apiManager != nullptr ? reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager)) : nullptr;
+    auto buffer = memoryManager != nullptr ? reinterpret_cast<uint16_t*>(memoryManager->Allocate(memoryManager, width * height * sizeof(uint16_t))) : nullptr;
+
+    if (buffer != nullptr) {
+        Display_ConvertRowsToRgb565(format, data, sourceStride, palette, dither, buffer, width, width, height, x, y);
+
+        auto result = self->DrawBuffer(self, x, y, width, height, reinterpret_cast<const uint8_t*>(buffer));
+
+        memoryManager->Free(memoryManager, buffer);
+
+        return result;
+    }
+
+    if (width > DISPLAY_CONVERSION_BAND_PIXELS)
+        return TinyCLR_Result::OutOfMemory;
+
+    auto bandRows = DISPLAY_CONVERSION_BAND_PIXELS / width;
+
+    for (auto row = 0U; row < height; row += bandRows) {
+        auto rows = __min(bandRows, height - row);
+
+        Display_ConvertRowsToRgb565(format, data + row * sourceStride, sourceStride, palette, dither, display_ConversionBand, width, width, rows, x, y + row);
+
+        Display_SetFlipDeferred(row + rows < height);
+
+        auto result = self->DrawBuffer(self, x, y + row, width, rows, reinterpret_cast<const uint8_t*>(display_ConversionBand));
+
+        if (result != TinyCLR_Result::Success) {
+            Display_SetFlipDeferred(false);
+
+            return result;
+        }
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+// Pixels are read as ARGB8888 the way the DMA2D pixel format converter expands them, the low bits repeat the high ones.
+uint32_t Display_GetColorModeBytesPerPixel(uint32_t colorMode) {
+    switch (colorMode) {
+    case DISPLAY_COLOR_MODE_ARGB8888:
+        return 4;
+
+    case DISPLAY_COLOR_MODE_RGB888:
+        return 3;
+
+    case DISPLAY_COLOR_MODE_RGB565:
+    case DISPLAY_COLOR_MODE_ARGB1555:
+    case DISPLAY_COLOR_MODE_ARGB4444:
+    case DISPLAY_COLOR_MODE_AL88:
+        return 2;
+    }
+
+    return 1;
+}
+
+static uint32_t Display_ReadPixel(const uint8_t* p, uint32_t colorMode) {
+    uint32_t v, r, g, b;
+
+    switch (colorMode) {
+    case DISPLAY_COLOR_MODE_ARGB8888:
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+
+    case DISPLAY_COLOR_MODE_RGB888:
+        return p[0] | (p[1] << 8) | (p[2] << 16) | 0xFF000000;
+
+    case DISPLAY_COLOR_MODE_RGB565:
+        v = p[0] | (p[1] << 8);
+        r = (v >> 11) & 0x1F;
+        g = (v >> 5) & 0x3F;
+        b = v & 0x1F;
+
+        return 0xFF000000 | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+
+    case DISPLAY_COLOR_MODE_ARGB1555:
+        v = p[0] | (p[1] << 8);
+        r = (v >> 10) & 0x1F;
+        g = (v >> 5) & 0x1F;
+        b = v & 0x1F;
+
+        return ((v & 0x8000) ? 0xFF000000 : 0) | (((r << 3) | (r >> 2)) << 16) | (((g << 3) | (g >> 2)) << 8) | ((b << 3) | (b >> 2));
+
+    case DISPLAY_COLOR_MODE_ARGB4444:
+        v = p[0] | (p[1] << 8);
+
+        return (((v >> 12) & 0xF) * 0x11000000) | (((v >> 8) & 0xF) * 0x110000) | (((v >> 4) & 0xF) * 0x1100) | ((v & 0xF) * 0x11);
+    }
+
+    return 0;
+}
+
+static void Display_WritePixel(uint8_t* p, uint32_t colorMode, uint32_t argb) {
+    uint32_t v;
+
+    switch (colorMode) {
+    case DISPLAY_COLOR_MODE_ARGB8888:
+        p[3] = (argb >> 24) & 0xFF;
+        // fall through
+    case DISPLAY_COLOR_MODE_RGB888:
+        p[0] = argb & 0xFF;
+        p[1] = (argb >> 8) & 0xFF;
+        p[2] = (argb >> 16) & 0xFF;
+        return;
+
+    case DISPLAY_COLOR_MODE_RGB565:
+        v = ((argb >> 8) & 0xF800) | ((argb >> 5) & 0x07E0) | ((argb >> 3) & 0x001F);
+        break;
+
+    case DISPLAY_COLOR_MODE_ARGB1555:
+        v = ((argb >> 16) & 0x8000) | ((argb >> 9) & 0x7C00) | ((argb >> 6) & 0x03E0) | ((argb >> 3) & 0x001F);
+        break;
+
+    case DISPLAY_COLOR_MODE_ARGB4444:
+        v = ((argb >> 16) & 0xF000) | ((argb >> 12) & 0x0F00) | ((argb >> 8) & 0x00F0) | ((argb >> 4) & 0x000F);
+        break;
+
+    default:
+        return;
+    }
+
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+bool Display_IsDirectColorMode(uint32_t colorMode) {
+    return colorMode <= DISPLAY_COLOR_MODE_ARGB4444;
+}
+
+void Display_CopyRectangle(const void* source, void* destination, uint32_t width, uint32_t height, uint32_t sourceOffset, uint32_t destinationOffset, uint32_t colorMode) {
+    auto bytesPerPixel = Display_GetColorModeBytesPerPixel(colorMode);
+    auto from = reinterpret_cast<const uint8_t*>(source);
+    auto to = reinterpret_cast<uint8_t*>(destination);
+
+    if (sourceOffset == 0 && destinationOffset == 0) {
+        memcpy(to, from, width * height * bytesPerPixel);
+
+        return;
+    }
+
+    for (auto y = 0U; y < height; y++) {
+        memcpy(to, from, width * bytesPerPixel);
+
+        from += (width + sourceOffset) * bytesPerPixel;
+        to += (width + destinationOffset) * bytesPerPixel;
+    }
+}
+
+void Display_FillRectangle(void* destination, uint32_t width, uint32_t height, uint32_t destinationOffset, uint32_t colorMode, uint32_t color) {
+    auto bytesPerPixel = Display_GetColorModeBytesPerPixel(colorMode);
+    auto to = reinterpret_cast<uint8_t*>(destination);
+
+    for (auto y = 0U; y < height; y++) {
+        switch (bytesPerPixel) {
+        case 1:
+            memset(to, color & 0xFF, width);
+            break;
+
+        case 2:
+            if ((color & 0xFF) == ((color >> 8) & 0xFF)) {
+                memset(to, color & 0xFF, width * 2);
+            }
+            else {
+                for (auto x = 0U; x < width; x++) {
+                    to[x * 2 + 0] = color & 0xFF;
+                    to[x * 2 + 1] = (color >> 8) & 0xFF;
+                }
+            }
+
+            break;
+
+        default:
+            for (auto x = 0U; x < width; x++) {
+                for (auto i = 0U; i < bytesPerPixel; i++)
+                    to[x * bytesPerPixel + i] = (color >> (i * 8)) & 0xFF;
+            }
+
+            break;
+        }
+
+        to += (width + destinationOffset) * bytesPerPixel;
+    }
+}
+
+void Display_ConvertRectangle(const void* source, void* destination, uint32_t width, uint32_t height, uint32_t sourceOffset, uint32_t destinationOffset, uint32_t sourceColorMode, uint32_t destinationColorMode) {
+    if (sourceColorMode == destinationColorMode) {
+        Display_CopyRectangle(source, destination, width, height, sourceOffset, destinationOffset, sourceColorMode);
+
+        return;
+    }
+
+    if (!Display_IsDirectColorMode(sourceColorMode) || !Display_IsDirectColorMode(destinationColorMode))
+        return;
+
+    auto sourceBytesPerPixel = Display_GetColorModeBytesPerPixel(sourceColorMode);
+    auto destinationBytesPerPixel = Display_GetColorModeBytesPerPixel(destinationColorMode);
+    auto from = reinterpret_cast<const uint8_t*>(source);
+    auto to = reinterpret_cast<uint8_t*>(destination);
+
+    for (auto y = 0U; y < height; y++) {
+        for (auto x = 0U; x < width; x++) {
+            Display_WritePixel(to, destinationColorMode, Display_ReadPixel(from, sourceColorMode));
+
+            from += sourceBytesPerPixel;
+            to += destinationBytesPerPixel;
+        }
+
+        from += sourceOffset * sourceBytesPerPixel;
+        to += destinationOffset * destinationBytesPerPixel;
+    }
+}
+
+void Display_BlendRectangle(const void* foreground, void* destination, uint32_t width, uint32_t height, uint32_t foregroundOffset, uint32_t destinationOffset, uint32_t destinationColorMode, uint8_t alpha) {
+    if (!Display_IsDirectColorMode(destinationColorMode))
+        return;
+
+    auto destinationBytesPerPixel = Display_GetColorModeBytesPerPixel(destinationColorMode);
+    auto from = reinterpret_cast<const uint8_t*>(foreground);
+    auto to = reinterpret_cast<uint8_t*>(destination);
+
+    for (auto y = 0U; y < height; y++) {
+        for (auto x = 0U; x < width; x++) {
+            auto fg = Display_ReadPixel(from, DISPLAY_COLOR_MODE_ARGB8888);
+            auto fa = ((fg >> 24) * alpha) / 255;
+
+            if (fa == 0xFF) {
+                Display_WritePixel(to, destinationColorMode, fg);
+            }
+            else if (fa != 0) {
+                auto bg = Display_ReadPixel(to, destinationColorMode);
+                auto ba = bg >> 24;
+                auto ma = (fa * ba) / 255;
+                auto oa = fa + ba - ma;
+                auto out = oa << 24;
+
+                for (auto shift = 0; shift < 24; shift += 8) {
+                    auto fc = (fg >> shift) & 0xFF;
+                    auto bc = (bg >> shift) & 0xFF;
+
+                    out |= (((fc * fa) + (bc * ba) - (bc * ma)) / oa) << shift;
+                }
+
+                Display_WritePixel(to, destinationColorMode, out);
+            }
+
+            from += 4;
+            to += destinationBytesPerPixel;
+        }
+
+        from += foregroundOffset * 4;
+        to += destinationOffset * destinationBytesPerPixel;
+    }
+}
@@ -0,0 +1,107 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <TinyCLR.h>
+
+// Source and destination point at the top left pixel of their rectangle, strides are in pixels.
+// The source rectangle is width x height; the destination is height x width for the 90 degree
+// rotations and width x height for 180 degrees.
+void Display_RotateRgb565Cw90(const uint16_t* source, int32_t sourceStride, uint16_t* destination, int32_t destinationStride, int32_t width, int32_t height);
+void Display_RotateRgb565Ccw90(const uint16_t* source, int32_t sourceStride, uint16_t* destination, int32_t destinationStride, int32_t width, int32_t height);
+void Display_RotateRgb565180(const uint16_t* source, int32_t sourceStride, uint16_t* destination, int32_t destinationStride, int32_t width, int32_t height);
+
+struct Display_DamageStatistics {
+    uint32_t Frames;
+    uint32_t UnchangedPixels;
+    uint32_t CopiedPixels;
+    uint32_t ChangedRows;
+    uint32_t Bands;
+    int32_t DirtyLeft;
+    int32_t DirtyTop;
+    int32_t DirtyRight;
+    int32_t DirtyBottom;
+};
+
+// When damage tracking is enabled the display drivers compare each incoming row against the framebuffer
+// and only copy the changed span. Statistics describe the last frame drawn, except Frames which counts all
+// of them; the dirty rectangle is relative to that frame and its right and bottom edges are exclusive.
+void Display_SetDamageTracking(bool enable);
+bool Display_IsDamageTrackingEnabled();
+void Display_GetDamageStatistics(Display_DamageStatistics& statistics);
+
+// A run of consecutive changed rows of the last frame and the columns changed in it, right and bottom edges exclusive.
+struct Display_DirtyBand {
+    int32_t Left;
+    int32_t Top;
+    int32_t Right;
+    int32_t Bottom;
+};
+
+// Copies up to count bands of the last frame, top to bottom, and returns how many there are. Past
+// DISPLAY_DAMAGE_MAX_BANDS the last band stored grows over the remaining ones, so the set always covers every change.
+int32_t Display_GetDirtyBands(Display_DirtyBand* bands, int32_t count);
+bool Display_CopyChangedRgb565(const uint16_t* source, int32_t sourceStride, uint16_t* destination, int32_t destinationStride, int32_t width, int32_t height);
+
+// While the flip is deferred a double buffered DrawBuffer leaves its update in the back buffer, the next DrawBuffer
+// adds to it and the first one drawn without the deferral flips them all together.
+void Display_SetFlipDeferred(bool defer);
+bool Display_IsFlipDeferred();
+
+// Raised from the vertical blank interrupt once a double buffered frame has been flipped to the screen.
+typedef void(*Display_FrameCompleteHandler)(const TinyCLR_Display_Controller* self, uint64_t timestamp);
+
+void Display_SetFrameCompleteHandler(Display_FrameCompleteHandler handler);
+void Display_RaiseFrameComplete(const TinyCLR_Display_Controller* self, uint64_t timestamp);
+
+// Pixel formats an application can hand to Display_DrawConvertedBuffer. Rgb888 is three bytes per pixel stored
+// blue first, Argb8888 is one little endian 0xAARRGGBB word per pixel and L8 is an index into a 256 entry RGB565 palette.
+enum class Display_PixelFormat : uint32_t { Rgb565, Rgb888, Argb8888, L8 };
+
+// Row kernels, count is in pixels. Dithering applies a 4x4 ordered pattern anchored at column x and row y of the screen.
+void Display_ConvertRgb565ToRgb888(const uint16_t* source, uint8_t* destination, int32_t count);
+void Display_ConvertRgb888ToRgb565(const uint8_t* source, uint16_t* destination, int32_t count);
+void Display_ConvertArgb8888ToRgb565(const uint32_t* source, uint16_t* destination, int32_t count, bool dither, int32_t x, int32_t y);
+void Display_ConvertL8ToRgb565(const uint8_t* source, uint16_t* destination, int32_t count, const uint16_t* palette);
+
+// Converts a rectangle to RGB565. The source stride is in bytes, the destination stride in pixels.
+bool Display_ConvertToRgb565(Display_PixelFormat format, const uint8_t* source, int32_t sourceStride, const uint16_t* palette, bool dither, uint16_t* destination, int32_t destinationStride, int32_t width, int32_t height);
+
+// Converts data to RGB565 and hands it to the controller's DrawBuffer, so rotation, damage tracking and double buffering
+// all still apply. The rectangle is converted in one piece when the heap allows it and in bands of rows otherwise; the
+// bands but the last are drawn with the flip deferred, so a double buffered display shows them all at once.
+TinyCLR_Result Display_DrawConvertedBuffer(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint32_t width, uint32_t height, Display_PixelFormat format, const uint8_t* data, const uint16_t* palette, bool dither);
+
+// Color modes of the rectangle kernels, numbered like the LTDC and DMA2D color mode fields so a target hands the same
+// value to its hardware. Only the direct modes up to ARGB4444 convert and blend.
+#define DISPLAY_COLOR_MODE_ARGB8888 0
+#define DISPLAY_COLOR_MODE_RGB888 1
+#define DISPLAY_COLOR_MODE_RGB565 2
+#define DISPLAY_COLOR_MODE_ARGB1555 3
+#define DISPLAY_COLOR_MODE_ARGB4444 4
+#define DISPLAY_COLOR_MODE_L8 5
+#define DISPLAY_COLOR_MODE_AL44 6
+#define DISPLAY_COLOR_MODE_AL88 7
+
+uint32_t Display_GetColorModeBytesPerPixel(uint32_t colorMode);
+bool Display_IsDirectColorMode(uint32_t colorMode);
+
+// CPU rectangle kernels, bit for bit what the DMA2D produces for the same transfer. Offsets are the number of pixels
+// skipped at the end of each line. Blend draws an ARGB8888 foreground over the destination in place, alpha scales the
+// foreground pixel alpha and 255 leaves it untouched.
+void Display_CopyRectangle(const void* source, void* destination, uint32_t width, uint32_t height, uint32_t sourceOffset, uint32_t destinationOffset, uint32_t colorMode);
+void Display_FillRectangle(void* destination, uint32_t width, uint32_t height, uint32_t destinationOffset, uint32_t colorMode, uint32_t color);
+void Display_ConvertRectangle(const void* source, void* destination, uint32_t width, uint32_t height, uint32_t sourceOffset, uint32_t destinationOffset, uint32_t sourceColorMode, uint32_t destinationColorMode);
+void Display_BlendRectangle(const void* foreground, void* destination, uint32_t width, uint32_t height, uint32_t foregroundOffset, uint32_t destinationOffset, uint32_t destinationColorMode, uint8_t alpha);
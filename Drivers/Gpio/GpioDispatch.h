@@ -0,0 +1,50 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+// A GPIO interrupt handler reads the pending edges of a port once, acknowledges them and hands every set bit, lowest
+// pin first, to its per pin code. The cost of an edge is then the edges before it rather than the pins below it.
+
+static const uint8_t gpioDispatchDeBruijn[32] = {
+    0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+};
+
+// lowest set bit by multiplying the isolated bit into a de Bruijn sequence, value must not be zero
+static inline uint32_t GpioDispatch_LowestSetBitDeBruijn(uint32_t value) {
+    return gpioDispatchDeBruijn[static_cast<uint32_t>((value & (0 - value)) * 0x077CB531u) >> 27];
+}
+
+// ARMv5 and up count leading zeros in one instruction, ARM7TDMI has no CLZ and GCC would call a library routine
+static inline uint32_t GpioDispatch_LowestSetBit(uint32_t value) {
+#if defined(__arm__) && !defined(__ARM_FEATURE_CLZ)
+    return GpioDispatch_LowestSetBitDeBruijn(value);
+#else
+    return __builtin_ctz(value);
+#endif
+}
+
+// Calls dispatch(pin) for every bit set in pending, lowest first.
+template<typename T> static inline void GpioDispatch_Pending(uint32_t pending, T dispatch) {
+    while (pending) {
+        auto pin = GpioDispatch_LowestSetBit(pending);
+
+        pending &= pending - 1;
+
+        dispatch(pin);
+    }
+}
@@ -0,0 +1,214 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "InterruptProfiler.h"
+
+#if defined(INTERRUPT_PROFILER)
+struct InterruptProfilerFrame {
+    uint32_t vector;
+    uint32_t start;
+    uint32_t nested;
+    uint32_t reentered;
+};
+
+static InterruptProfiler_Record interruptProfilerRecords[INTERRUPT_PROFILER_VECTORS];
+static InterruptProfilerFrame interruptProfilerFrames[INTERRUPT_PROFILER_DEPTH];
+static uint32_t interruptProfilerDepth;
+static uint32_t interruptProfilerOverflow;
+static uint32_t interruptProfilerDisabledStart;
+static uint32_t interruptProfilerDisabledMax;
+static bool interruptProfilerDisabled;
+
+void InterruptProfiler_Started(uint32_t vector) {
+    auto now = InterruptProfiler_ReadCounter();
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto depth = interruptProfilerDepth;
+
+    if (depth > 0 && interruptProfilerFrames[depth - 1].vector == vector) {
+        // a handler the interrupt called started the same interrupt again
+        interruptProfilerFrames[depth - 1].reentered++;
+    }
+    else if (depth < INTERRUPT_PROFILER_DEPTH) {
+        auto frame = &interruptProfilerFrames[depth];
+
+        frame->vector = vector;
+        frame->start = now;
+        frame->nested = 0;
+        frame->reentered = 0;
+
+        interruptProfilerDepth = depth + 1;
+    }
+    else {
+        interruptProfilerOverflow++;
+    }
+}
+
+void InterruptProfiler_Ended() {
+    auto now = InterruptProfiler_ReadCounter();
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto depth = interruptProfilerDepth;
+
+    if (interruptProfilerOverflow > 0) {
+        interruptProfilerOverflow--;
+    }
+    else if (depth > 0 && interruptProfilerFrames[depth - 1].reentered > 0) {
+        interruptProfilerFrames[depth - 1].reentered--;
+    }
+    else if (depth > 0) {
+        auto frame = &interruptProfilerFrames[depth - 1];
+        auto elapsed = (now - frame->start) & INTERRUPT_PROFILER_COUNTER_MASK;
+        auto duration = elapsed - frame->nested;
+
+        if (frame->vector < INTERRUPT_PROFILER_VECTORS) {
+            auto record = &interruptProfilerRecords[frame->vector];
+
+            record->Count++;
+            record->TotalDuration += duration;
+
+            if (duration > record->MaxDuration)
+                record->MaxDuration = duration;
+        }
+
+        interruptProfilerDepth = depth - 1;
+
+        if (depth > 1)
+            interruptProfilerFrames[depth - 2].nested += elapsed;
+    }
+}
+
+void InterruptProfiler_DisabledStarted() {
+    if (!interruptProfilerDisabled) {
+        interruptProfilerDisabledStart = InterruptProfiler_ReadCounter();
+        interruptProfilerDisabled = true;
+    }
+}
+
+void InterruptProfiler_DisabledEnded() {
+    if (interruptProfilerDisabled) {
+        auto duration = (InterruptProfiler_ReadCounter() - interruptProfilerDisabledStart) & INTERRUPT_PROFILER_COUNTER_MASK;
+
+        if (duration > interruptProfilerDisabledMax)
+            interruptProfilerDisabledMax = duration;
+
+        interruptProfilerDisabled = false;
+    }
+}
+
+void InterruptProfiler_Reset() {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    for (auto i = 0; i < INTERRUPT_PROFILER_VECTORS; i++) {
+        interruptProfilerRecords[i].Count = 0;
+        interruptProfilerRecords[i].MaxDuration = 0;
+        interruptProfilerRecords[i].TotalDuration = 0;
+    }
+
+    interruptProfilerDisabledMax = 0;
+}
+
+uint32_t InterruptProfiler_GetVectorCount() {
+    return INTERRUPT_PROFILER_VECTORS;
+}
+
+uint32_t InterruptProfiler_GetCountsPerSecond() {
+    return INTERRUPT_PROFILER_COUNTS_PER_SECOND;
+}
+
+bool InterruptProfiler_GetRecord(uint32_t vector, InterruptProfiler_Record& record) {
+    if (vector >= INTERRUPT_PROFILER_VECTORS)
+        return false;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    record = interruptProfilerRecords[vector];
+
+    return true;
+}
+
+uint32_t InterruptProfiler_GetMaxDisabledDuration() {
+    return interruptProfilerDisabledMax;
+}
+
+struct InterruptProfilerWriter {
+    char* buffer;
+    size_t size;
+    size_t length;
+};
+
+static void InterruptProfiler_Write(InterruptProfilerWriter& writer, char c) {
+    if (writer.length + 1 < writer.size)
+        writer.buffer[writer.length] = c;
+
+    writer.length++;
+}
+
+static void InterruptProfiler_Write(InterruptProfilerWriter& writer, const char* text) {
+    while (*text != 0)
+        InterruptProfiler_Write(writer, *text++);
+}
+
+// right aligned in width characters, wider numbers take what they need
+static void InterruptProfiler_Write(InterruptProfilerWriter& writer, uint64_t value, size_t width) {
+    char digits[20];
+    size_t count = 0;
+
+    do {
+        digits[count++] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    for (; width > count; width--)
+        InterruptProfiler_Write(writer, ' ');
+
+    while (count > 0)
+        InterruptProfiler_Write(writer, digits[--count]);
+}
+
+// counts to a time in units per second, split so a long total doesn't overflow
+static uint64_t InterruptProfiler_ToTime(uint64_t counts, uint64_t unitsPerSecond) {
+    return counts / INTERRUPT_PROFILER_COUNTS_PER_SECOND * unitsPerSecond + counts % INTERRUPT_PROFILER_COUNTS_PER_SECOND * unitsPerSecond / INTERRUPT_PROFILER_COUNTS_PER_SECOND;
+}
+
+size_t InterruptProfiler_Format(char* buffer, size_t size) {
+    InterruptProfilerWriter writer = { buffer, size, 0 };
+    InterruptProfiler_Record record;
+
+    InterruptProfiler_Write(writer, "vector      calls    total us  average ns      max ns\n");
+
+    for (auto i = 0U; i < INTERRUPT_PROFILER_VECTORS; i++) {
+        if (!InterruptProfiler_GetRecord(i, record) || record.Count == 0)
+            continue;
+
+        InterruptProfiler_Write(writer, i, 6);
+        InterruptProfiler_Write(writer, record.Count, 11);
+        InterruptProfiler_Write(writer, InterruptProfiler_ToTime(record.TotalDuration, 1000000), 12);
+        InterruptProfiler_Write(writer, InterruptProfiler_ToTime(record.TotalDuration / record.Count, 1000000000), 12);
+        InterruptProfiler_Write(writer, InterruptProfiler_ToTime(record.MaxDuration, 1000000000), 12);
+        InterruptProfiler_Write(writer, '\n');
+    }
+
+    InterruptProfiler_Write(writer, "disabled max ns ");
+    InterruptProfiler_Write(writer, InterruptProfiler_ToTime(InterruptProfiler_GetMaxDisabledDuration(), 1000000000), 0);
+    InterruptProfiler_Write(writer, '\n');
+
+    if (size > 0)
+        buffer[writer.length < size ? writer.length : size - 1] = 0;
+
+    return writer.length;
+}
+#endif
@@ -0,0 +1,59 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <TinyCLR.h>
+#include <Device.h>
+
+// With INTERRUPT_PROFILER defined in Device.h the target reports every interrupt handler to InterruptProfiler_Started
+// and _Ended with its vector number, and every time interrupts get disabled and enabled again to
+// InterruptProfiler_DisabledStarted and _Ended. The profiler keeps the count, total and longest duration of every
+// vector and the longest time interrupts stayed disabled. The time of an interrupt that preempts another is not
+// charged to the preempted one.
+//
+// Durations are counts of a free running counter the target reads in InterruptProfiler_ReadCounter. Its header gives
+// INTERRUPT_PROFILER_VECTORS, INTERRUPT_PROFILER_COUNTS_PER_SECOND and, for a counter narrower than 32 bits,
+// INTERRUPT_PROFILER_COUNTER_MASK.
+#ifndef INTERRUPT_PROFILER_COUNTER_MASK
+#define INTERRUPT_PROFILER_COUNTER_MASK 0xFFFFFFFF
+#endif
+
+// Interrupts nested deeper than this are not timed
+#define INTERRUPT_PROFILER_DEPTH 8
+
+struct InterruptProfiler_Record {
+    uint32_t Count;
+    uint32_t MaxDuration;
+    uint64_t TotalDuration;
+};
+
+uint32_t InterruptProfiler_ReadCounter();
+
+void InterruptProfiler_Started(uint32_t vector);
+void InterruptProfiler_Ended();
+
+// called with interrupts disabled
+void InterruptProfiler_DisabledStarted();
+void InterruptProfiler_DisabledEnded();
+
+void InterruptProfiler_Reset();
+uint32_t InterruptProfiler_GetVectorCount();
+uint32_t InterruptProfiler_GetCountsPerSecond();
+bool InterruptProfiler_GetRecord(uint32_t vector, InterruptProfiler_Record& record);
+uint32_t InterruptProfiler_GetMaxDisabledDuration();
+
+// A text report of the vectors that ran and the longest time interrupts were disabled, one line each. Writes what fits
+// in the buffer and a terminating zero, returns the length of the whole report.
+size_t InterruptProfiler_Format(char* buffer, size_t size);
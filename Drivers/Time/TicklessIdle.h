@@ -0,0 +1,45 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+// Arithmetic of a tickless idle that stops the core until a wakeup timer, and measures the time stopped with a time
+// of day counter that keeps running meanwhile. Times are in 100ns ticks like native time.
+#define TICKLESS_IDLE_TICKS_PER_SECOND 10000000
+#define TICKLESS_IDLE_SECONDS_PER_DAY (24 * 60 * 60)
+
+// Wakeup timer counts for an idle period, zero when stopping does not pay off. The timer ends the stop the wakeup
+// latency before the period is over so the clocks are back in time. Longer periods are cut to the most the timer
+// counts, the core then stops again.
+static inline uint32_t TicklessIdle_GetWakeupCounts(uint64_t idleTime, uint32_t clockHz, uint32_t maxCounts, uint64_t latency, uint64_t minimumIdle) {
+    if (idleTime < minimumIdle || idleTime <= latency)
+        return 0;
+
+    idleTime -= latency;
+
+    if (idleTime > (uint64_t)maxCounts * TICKLESS_IDLE_TICKS_PER_SECOND / clockHz)
+        idleTime = (uint64_t)maxCounts * TICKLESS_IDLE_TICKS_PER_SECOND / clockHz;
+
+    return (uint32_t)(idleTime * clockHz / TICKLESS_IDLE_TICKS_PER_SECOND);
+}
+
+// Time between two readings of the time of day in subseconds, the end one may be past midnight.
+static inline uint64_t TicklessIdle_GetElapsedTime(uint32_t start, uint32_t end, uint32_t subsecondsPerSecond) {
+    auto subsecondsPerDay = TICKLESS_IDLE_SECONDS_PER_DAY * subsecondsPerSecond;
+    auto elapsed = (end + subsecondsPerDay - start) % subsecondsPerDay;
+
+    return (uint64_t)elapsed * TICKLESS_IDLE_TICKS_PER_SECOND / subsecondsPerSecond;
+}
@@ -0,0 +1,72 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+// 64 bit divisions by constant clock ratios are done as a multiply by a fixed point reciprocal and a shift. Cortex-M
+// has no 64 bit divider and ARM7/ARM9 no divider at all, so a division is a library call of hundreds of cycles. The
+// compiler works out the factors in TimeDivider_Create, they give the quotient of a division for every 64 bit
+// dividend. Divisors must be below 2^32.
+struct TimeDivider {
+    uint64_t divisor;
+    uint64_t multiplier;
+    uint32_t shift;
+    bool add;
+};
+
+static constexpr uint32_t TimeDivider_Log2(uint64_t value) {
+    return value <= 1 ? 0 : 1 + TimeDivider_Log2(value >> 1);
+}
+
+// quotient and remainder of 2^(64 + shift) / divisor, the multiplier needs 65 bits when the remainder is too big
+static constexpr TimeDivider TimeDivider_Create(uint64_t divisor, uint32_t shift, uint64_t quotient, uint64_t remainder) {
+    return (divisor - remainder) < (1ull << shift) ?
+        TimeDivider{ divisor, quotient + 1, shift, false } :
+        TimeDivider{ divisor, 2 * quotient + (2 * remainder >= divisor ? 1 : 0) + 1, shift, true };
+}
+
+// 2^(64 + shift) is divided in 32 bit digits, 2^(32 + shift) / divisor being the high one
+static constexpr TimeDivider TimeDivider_Create(uint64_t divisor, uint32_t shift) {
+    return TimeDivider_Create(divisor, shift,
+        (((1ull << (32 + shift)) / divisor) << 32) | ((((1ull << (32 + shift)) % divisor) << 32) / divisor),
+        (((1ull << (32 + shift)) % divisor) << 32) % divisor);
+}
+
+static constexpr TimeDivider TimeDivider_Create(uint64_t divisor) {
+    return divisor == 1 ? TimeDivider{ 1, 0, 0, false } :
+        (divisor & (divisor - 1)) == 0 ? TimeDivider{ divisor, 1ull << (64 - TimeDivider_Log2(divisor)), 0, false } :
+        TimeDivider_Create(divisor, TimeDivider_Log2(divisor));
+}
+
+static inline uint64_t TimeDivider_MultiplyHigh(uint64_t a, uint64_t b) {
+    uint64_t low = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+    uint64_t middle1 = (a >> 32) * (b & 0xFFFFFFFF);
+    uint64_t middle2 = (a & 0xFFFFFFFF) * (b >> 32);
+    uint64_t high = (a >> 32) * (b >> 32);
+
+    middle2 += (low >> 32) + (middle1 & 0xFFFFFFFF);
+
+    return high + (middle1 >> 32) + (middle2 >> 32);
+}
+
+static inline uint64_t TimeDivider_Divide(uint64_t value, const TimeDivider& divider) {
+    if (divider.divisor == 1)
+        return value;
+
+    auto high = TimeDivider_MultiplyHigh(value, divider.multiplier);
+
+    return divider.add ? ((((value - high) >> 1) + high) >> divider.shift) : (high >> divider.shift);
+}
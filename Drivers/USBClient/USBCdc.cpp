@@ -0,0 +1,369 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include "USBCdc.h"
+
+#define USB_CDC_COMMUNICATION_INTERFACE 0
+#define USB_CDC_DATA_INTERFACE          1
+
+#define USB_CDC_NOTIFICATION_INTERVAL 16
+#define USB_CDC_NOTIFICATION_SIZE     10
+
+#define USB_CDC_STRING_MANUFACTURER 1
+#define USB_CDC_STRING_PRODUCT      2
+#define USB_CDC_STRING_SERIAL       3
+
+struct UsbCdcState {
+    const TinyCLR_UsbClient_Controller* controller;
+
+    uint32_t dataPipe;
+    uint32_t notificationPipe;
+
+    uint8_t lineCoding[USB_CDC_LINE_CODING_SIZE];
+    uint16_t controlLineState;
+    uint16_t serialState;
+
+    TinyCLR_UsbCdc_LineStateChangedHandler lineStateChangedHandler;
+
+    TinyCLR_UsbClient_DeviceDescriptor deviceDescriptor;
+    TinyCLR_UsbClient_ConfigurationDescriptor configurationDescriptor;
+    TinyCLR_UsbClient_InterfaceDescriptor interfaceDescriptors[2];
+    TinyCLR_UsbClient_EndpointDescriptor notificationEndpointDescriptor;
+    TinyCLR_UsbClient_EndpointDescriptor dataEndpointDescriptors[2];
+    TinyCLR_UsbClient_StringDescriptor stringDescriptors[3];
+};
+
+static UsbCdcState usbCdcState;
+
+// 115200 baud, 1 stop bit, no parity, 8 data bits
+static const uint8_t usbCdcDefaultLineCoding[USB_CDC_LINE_CODING_SIZE] = { 0x00, 0xC2, 0x01, 0x00, 0x00, 0x00, 0x08 };
+
+static const uint8_t usbCdcHeaderPayload[] = { USB_CDC_HEADER_FUNCTIONAL_DESCRIPTOR, 0x10, 0x01 };
+static const uint8_t usbCdcCallManagementPayload[] = { USB_CDC_CALL_MANAGEMENT_FUNCTIONAL_DESCRIPTOR, 0x00, USB_CDC_DATA_INTERFACE };
+static const uint8_t usbCdcAcmPayload[] = { USB_CDC_ACM_FUNCTIONAL_DESCRIPTOR, 0x02 }; // line coding, control line state and serial state
+static const uint8_t usbCdcUnionPayload[] = { USB_CDC_UNION_FUNCTIONAL_DESCRIPTOR, USB_CDC_COMMUNICATION_INTERFACE, USB_CDC_DATA_INTERFACE };
+
+static const TinyCLR_UsbClient_VendorClassDescriptor usbCdcFunctionalDescriptors[] = {
+    { sizeof(usbCdcHeaderPayload), USB_CDC_CS_INTERFACE_DESCRIPTOR_TYPE, usbCdcHeaderPayload },
+    { sizeof(usbCdcCallManagementPayload), USB_CDC_CS_INTERFACE_DESCRIPTOR_TYPE, usbCdcCallManagementPayload },
+    { sizeof(usbCdcAcmPayload), USB_CDC_CS_INTERFACE_DESCRIPTOR_TYPE, usbCdcAcmPayload },
+    { sizeof(usbCdcUnionPayload), USB_CDC_CS_INTERFACE_DESCRIPTOR_TYPE, usbCdcUnionPayload },
+};
+
+static uint8_t TinyCLR_UsbCdc_AddString(UsbCdcState* state, size_t& count, uint8_t index, const wchar_t* data) {
+    if (data == nullptr)
+        return 0;
+
+    auto length = 0;
+
+    while (data[length] != 0 && length < (USB_ENDPOINT_CONTROL_BUFFER_SIZE - 2) / 2)
+        length++;
+
+    state->stringDescriptors[count].Index = index;
+    state->stringDescriptors[count].Length = length;
+    state->stringDescriptors[count].Data = data;
+
+    count++;
+
+    return index;
+}
+
+static void TinyCLR_UsbCdc_BuildDescriptors(UsbCdcState* state, const TinyCLR_UsbCdc_DeviceInfo* deviceInfo) {
+    auto notification = &state->notificationEndpointDescriptor;
+    auto dataIn = &state->dataEndpointDescriptors[0];
+    auto dataOut = &state->dataEndpointDescriptors[1];
+
+    memset(notification, 0, sizeof(TinyCLR_UsbClient_EndpointDescriptor));
+    memset(state->dataEndpointDescriptors, 0, sizeof(state->dataEndpointDescriptors));
+
+    notification->Address = USB_ENDPOINT_DIRECTION_IN | USB_CDC_NOTIFICATION_ENDPOINT;
+    notification->Attributes = USB_ENDPOINT_ATTRIBUTE_INTERRUPT;
+    notification->MaxPacketSize = TinyCLR_UsbClient_GetEndpointSize(USB_CDC_NOTIFICATION_ENDPOINT);
+    notification->Interval = USB_CDC_NOTIFICATION_INTERVAL;
+
+    dataIn->Address = USB_ENDPOINT_DIRECTION_IN | USB_CDC_DATA_IN_ENDPOINT;
+    dataIn->Attributes = USB_ENDPOINT_ATTRIBUTE_BULK;
+    dataIn->MaxPacketSize = TinyCLR_UsbClient_GetEndpointSize(USB_CDC_DATA_IN_ENDPOINT);
+
+    dataOut->Address = USB_ENDPOINT_DIRECTION_OUT | USB_CDC_DATA_OUT_ENDPOINT;
+    dataOut->Attributes = USB_ENDPOINT_ATTRIBUTE_BULK;
+    dataOut->MaxPacketSize = TinyCLR_UsbClient_GetEndpointSize(USB_CDC_DATA_OUT_ENDPOINT);
+
+    auto communication = &state->interfaceDescriptors[0];
+    auto data = &state->interfaceDescriptors[1];
+
+    memset(state->interfaceDescriptors, 0, sizeof(state->interfaceDescriptors));
+
+    communication->Number = USB_CDC_COMMUNICATION_INTERFACE;
+    communication->EndpointCount = 1;
+    communication->InterfaceClass = USB_CDC_COMMUNICATION_INTERFACE_CLASS;
+    communication->InterfaceSubClass = USB_CDC_ABSTRACT_CONTROL_MODEL;
+    communication->VendorClassDescriptorCount = sizeof(usbCdcFunctionalDescriptors) / sizeof(usbCdcFunctionalDescriptors[0]);
+    communication->VendorClassDescriptors = usbCdcFunctionalDescriptors;
+    communication->Endpoints = notification;
+
+    data->Number = USB_CDC_DATA_INTERFACE;
+    data->EndpointCount = 2;
+    data->InterfaceClass = USB_CDC_DATA_INTERFACE_CLASS;
+    data->Endpoints = state->dataEndpointDescriptors;
+
+    auto configuration = &state->configurationDescriptor;
+
+    memset(configuration, 0, sizeof(TinyCLR_UsbClient_ConfigurationDescriptor));
+
+    configuration->InterfaceCount = 2;
+    configuration->Number = 1;
+    configuration->Attributes = USB_ATTRIBUTE_BASE | USB_ATTRIBUTE_SELF_POWER;
+    configuration->MaxPower = 50; // 100mA
+    configuration->Interfaces = state->interfaceDescriptors;
+
+    auto device = &state->deviceDescriptor;
+
+    memset(device, 0, sizeof(TinyCLR_UsbClient_DeviceDescriptor));
+
+    size_t strings = 0;
+
+    device->UsbVersion = 0x0200;
+    device->ClassCode = USB_CDC_COMMUNICATION_INTERFACE_CLASS;
+    device->MaxPacketSizeEp0 = TinyCLR_UsbClient_GetEndpointSize(0);
+    device->VendorId = deviceInfo->VendorId;
+    device->ProductId = deviceInfo->ProductId;
+    device->DeviceVersion = deviceInfo->DeviceVersion;
+    device->ManufacturerIndex = TinyCLR_UsbCdc_AddString(state, strings, USB_CDC_STRING_MANUFACTURER, deviceInfo->Manufacturer);
+    device->ProductIndex = TinyCLR_UsbCdc_AddString(state, strings, USB_CDC_STRING_PRODUCT, deviceInfo->Product);
+    device->SerialNumberIndex = TinyCLR_UsbCdc_AddString(state, strings, USB_CDC_STRING_SERIAL, deviceInfo->SerialNumber);
+    device->ConfigurationCount = 1;
+    device->Configurations = configuration;
+    device->StringCount = strings;
+    device->Strings = state->stringDescriptors;
+}
+
+TinyCLR_Result TinyCLR_UsbCdc_Acquire(const TinyCLR_UsbClient_Controller* self, const TinyCLR_UsbCdc_DeviceInfo* deviceInfo) {
+    auto state = &usbCdcState;
+
+    if (deviceInfo == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (state->controller != nullptr)
+        return TinyCLR_Result::SharingViolation;
+
+    TinyCLR_UsbCdc_BuildDescriptors(state, deviceInfo);
+
+    auto result = TinyCLR_UsbClient_SetDeviceDescriptor(self, &state->deviceDescriptor);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    if ((result = TinyCLR_UsbClient_Acquire(self)) != TinyCLR_Result::Success)
+        return result;
+
+    auto usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    if (USB_CDC_DATA_IN_ENDPOINT >= usbClientState->totalEndpointsCount
+        || USB_CDC_DATA_OUT_ENDPOINT >= usbClientState->totalEndpointsCount
+        || USB_CDC_NOTIFICATION_ENDPOINT >= usbClientState->totalEndpointsCount) {
+        TinyCLR_UsbClient_Release(self);
+
+        return TinyCLR_Result::NotSupported;
+    }
+
+    // the rings are sized before the pipes allocate them, the notification ring holds a few notifications only
+    usbClientState->queueSize[USB_CDC_DATA_IN_ENDPOINT] = USB_CDC_WRITE_BUFFER_SIZE;
+    usbClientState->queueSize[USB_CDC_DATA_OUT_ENDPOINT] = USB_CDC_READ_BUFFER_SIZE;
+    usbClientState->queueSize[USB_CDC_NOTIFICATION_ENDPOINT] = usbClientState->maxEndpointsPacketSize[USB_CDC_NOTIFICATION_ENDPOINT];
+
+    if (TinyCLR_UsbClient_AllocatePipe(usbClientState, USB_CDC_DATA_IN_ENDPOINT, USB_CDC_DATA_OUT_ENDPOINT, state->dataPipe) != TinyCLR_Result::Success
+        || TinyCLR_UsbClient_AllocatePipe(usbClientState, USB_CDC_NOTIFICATION_ENDPOINT, USB_ENDPOINT_NULL, state->notificationPipe) != TinyCLR_Result::Success
+        || usbClientState->queues[USB_CDC_DATA_IN_ENDPOINT] == nullptr
+        || usbClientState->queues[USB_CDC_DATA_OUT_ENDPOINT] == nullptr
+        || usbClientState->queues[USB_CDC_NOTIFICATION_ENDPOINT] == nullptr) {
+
+        for (uint32_t pipe = 0; pipe < usbClientState->totalPipesCount; pipe++)
+            if (usbClientState->pipes[pipe].RxEP != USB_ENDPOINT_NULL || usbClientState->pipes[pipe].TxEP != USB_ENDPOINT_NULL)
+                TinyCLR_UsbClient_ClosePipe(self, pipe);
+
+        TinyCLR_UsbClient_Release(self);
+
+        return TinyCLR_Result::OutOfMemory;
+    }
+
+    // a notification either fits in the ring or is dropped
+    TinyCLR_UsbClient_SetWriteTimeout(self, state->notificationPipe, USB_WRITE_TIMEOUT_NONE);
+
+    memcpy(state->lineCoding, usbCdcDefaultLineCoding, USB_CDC_LINE_CODING_SIZE);
+
+    state->controlLineState = 0;
+    state->serialState = 0;
+    state->controller = self;
+
+    usbClientState->classRequestHandler = &TinyCLR_UsbCdc_ProcessClassRequest;
+
+    // all pipes exist now, so the controller can be started with every endpoint configured
+    if (usbClientState->currentState == USB_DEVICE_STATE_UNINITIALIZED)
+        TinyCLR_UsbClient_Initialize(usbClientState);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_UsbCdc_Release(const TinyCLR_UsbClient_Controller* self) {
+    auto state = &usbCdcState;
+
+    if (state->controller != self)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    usbClientState->classRequestHandler = nullptr;
+
+    TinyCLR_UsbClient_ClosePipe(self, state->notificationPipe);
+    TinyCLR_UsbClient_ClosePipe(self, state->dataPipe);
+
+    state->controller = nullptr;
+    state->lineStateChangedHandler = nullptr;
+
+    return TinyCLR_UsbClient_Release(self);
+}
+
+TinyCLR_Result TinyCLR_UsbCdc_Write(const TinyCLR_UsbClient_Controller* self, const uint8_t* data, size_t& length) {
+    if (usbCdcState.controller != self)
+        return TinyCLR_Result::InvalidOperation;
+
+    return TinyCLR_UsbClient_WritePipe(self, usbCdcState.dataPipe, data, length);
+}
+
+TinyCLR_Result TinyCLR_UsbCdc_Read(const TinyCLR_UsbClient_Controller* self, uint8_t* data, size_t& length) {
+    if (usbCdcState.controller != self)
+        return TinyCLR_Result::InvalidOperation;
+
+    return TinyCLR_UsbClient_ReadPipe(self, usbCdcState.dataPipe, data, length);
+}
+
+TinyCLR_Result TinyCLR_UsbCdc_Flush(const TinyCLR_UsbClient_Controller* self) {
+    if (usbCdcState.controller != self)
+        return TinyCLR_Result::InvalidOperation;
+
+    return TinyCLR_UsbClient_FlushPipe(self, usbCdcState.dataPipe);
+}
+
+TinyCLR_Result TinyCLR_UsbCdc_GetDataPipe(const TinyCLR_UsbClient_Controller* self, uint32_t& pipe) {
+    if (usbCdcState.controller != self)
+        return TinyCLR_Result::InvalidOperation;
+
+    pipe = usbCdcState.dataPipe;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_UsbCdc_GetLineCoding(const TinyCLR_UsbClient_Controller* self, TinyCLR_UsbCdc_LineCoding& lineCoding) {
+    auto state = &usbCdcState;
+
+    if (state->controller != self)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    lineCoding.BaudRate = state->lineCoding[0] | (state->lineCoding[1] << 8) | (state->lineCoding[2] << 16) | (state->lineCoding[3] << 24);
+    lineCoding.StopBits = state->lineCoding[4];
+    lineCoding.Parity = state->lineCoding[5];
+    lineCoding.DataBits = state->lineCoding[6];
+
+    return TinyCLR_Result::Success;
+}
+
+uint16_t TinyCLR_UsbCdc_GetControlLineState(const TinyCLR_UsbClient_Controller* self) {
+    return usbCdcState.controller == self ? usbCdcState.controlLineState : 0;
+}
+
+TinyCLR_Result TinyCLR_UsbCdc_SetSerialState(const TinyCLR_UsbClient_Controller* self, uint16_t serialState) {
+    auto state = &usbCdcState;
+
+    if (state->controller != self)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    state->serialState = serialState;
+
+    // the host only learns the state from notifications, there is nobody to tell before it configured the device
+    if (usbClientState->deviceState != USB_DEVICE_STATE_CONFIGURED)
+        return TinyCLR_Result::Success;
+
+    uint8_t notification[USB_CDC_NOTIFICATION_SIZE] = {
+        USB_REQUEST_TYPE_IN | USB_REQUEST_TYPE_CLASS | USB_REQUEST_TYPE_INTERFACE, USB_CDC_SERIAL_STATE_NOTIFICATION,
+        0x00, 0x00,
+        USB_CDC_COMMUNICATION_INTERFACE, 0x00,
+        0x02, 0x00,
+        static_cast<uint8_t>(serialState), static_cast<uint8_t>(serialState >> 8)
+    };
+
+    if (TinyCLR_UsbClient_GetWriteBufferSize(self, state->notificationPipe) - TinyCLR_UsbClient_GetBytesToWrite(self, state->notificationPipe) < USB_CDC_NOTIFICATION_SIZE)
+        return TinyCLR_Result::Busy;
+
+    size_t length = USB_CDC_NOTIFICATION_SIZE;
+
+    return TinyCLR_UsbClient_WritePipe(self, state->notificationPipe, notification, length);
+}
+
+TinyCLR_Result TinyCLR_UsbCdc_SetLineStateChangedHandler(const TinyCLR_UsbClient_Controller* self, TinyCLR_UsbCdc_LineStateChangedHandler handler) {
+    if (usbCdcState.controller != self)
+        return TinyCLR_Result::InvalidOperation;
+
+    usbCdcState.lineStateChangedHandler = handler;
+
+    return TinyCLR_Result::Success;
+}
+
+// Runs from the USB interrupt. Only class requests to the communication interface are taken, everything else
+// still goes to the managed vendor and class handler.
+bool TinyCLR_UsbCdc_ProcessClassRequest(UsbClientState* usbClientState, const TinyCLR_UsbClient_SetupPacket* setup, const uint8_t* data, const uint8_t*& responsePayload, size_t& responsePayloadLength) {
+    auto state = &usbCdcState;
+
+    if ((setup->RequestType & (USB_REQUEST_TYPE_CLASS | USB_REQUEST_TYPE_VENDOR)) != USB_REQUEST_TYPE_CLASS
+        || USB_SETUP_RECIPIENT(setup->RequestType) != USB_SETUP_RECIPIENT_INTERFACE
+        || (setup->Index & 0xFF) != USB_CDC_COMMUNICATION_INTERFACE)
+        return false;
+
+    switch (setup->Request) {
+    case USB_CDC_SET_LINE_CODING:
+        if (data == nullptr || setup->Length < USB_CDC_LINE_CODING_SIZE)
+            return false;
+
+        memcpy(state->lineCoding, data, USB_CDC_LINE_CODING_SIZE);
+
+        break;
+
+    case USB_CDC_GET_LINE_CODING:
+        responsePayload = state->lineCoding;
+        responsePayloadLength = USB_CDC_LINE_CODING_SIZE;
+
+        return true;
+
+    case USB_CDC_SET_CONTROL_LINE_STATE:
+        state->controlLineState = setup->Value & (USB_CDC_CONTROL_LINE_DTR | USB_CDC_CONTROL_LINE_RTS);
+
+        break;
+
+    case USB_CDC_SEND_BREAK:
+        return true;
+
+    default:
+        return false;
+    }
+
+    if (state->lineStateChangedHandler != nullptr)
+        state->lineStateChangedHandler(state->controller, TinyCLR_UsbClient_Now());
+
+    return true;
+}
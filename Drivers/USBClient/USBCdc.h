@@ -0,0 +1,108 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "USBClient.h"
+
+// CDC class codes
+#define USB_CDC_COMMUNICATION_INTERFACE_CLASS 0x02
+#define USB_CDC_ABSTRACT_CONTROL_MODEL        0x02
+#define USB_CDC_DATA_INTERFACE_CLASS          0x0A
+
+#define USB_CDC_CS_INTERFACE_DESCRIPTOR_TYPE  0x24
+
+#define USB_CDC_HEADER_FUNCTIONAL_DESCRIPTOR          0x00
+#define USB_CDC_CALL_MANAGEMENT_FUNCTIONAL_DESCRIPTOR 0x01
+#define USB_CDC_ACM_FUNCTIONAL_DESCRIPTOR             0x02
+#define USB_CDC_UNION_FUNCTIONAL_DESCRIPTOR           0x06
+
+// CDC class requests
+#define USB_CDC_SET_LINE_CODING        0x20
+#define USB_CDC_GET_LINE_CODING        0x21
+#define USB_CDC_SET_CONTROL_LINE_STATE 0x22
+#define USB_CDC_SEND_BREAK             0x23
+
+#define USB_CDC_SERIAL_STATE_NOTIFICATION 0x20
+
+#define USB_CDC_LINE_CODING_SIZE 7
+
+// SET_CONTROL_LINE_STATE bits
+#define USB_CDC_CONTROL_LINE_DTR 0x0001
+#define USB_CDC_CONTROL_LINE_RTS 0x0002
+
+// SERIAL_STATE bits
+#define USB_CDC_SERIAL_STATE_DCD     0x0001
+#define USB_CDC_SERIAL_STATE_DSR     0x0002
+#define USB_CDC_SERIAL_STATE_BREAK   0x0004
+#define USB_CDC_SERIAL_STATE_RING    0x0008
+#define USB_CDC_SERIAL_STATE_FRAMING 0x0010
+#define USB_CDC_SERIAL_STATE_PARITY  0x0020
+#define USB_CDC_SERIAL_STATE_OVERRUN 0x0040
+
+// Endpoints of the function, a board overrides them in Device.h when the controller fixes endpoint types by number
+#ifndef USB_CDC_DATA_IN_ENDPOINT
+#define USB_CDC_DATA_IN_ENDPOINT 1
+#endif
+
+#ifndef USB_CDC_DATA_OUT_ENDPOINT
+#define USB_CDC_DATA_OUT_ENDPOINT 2
+#endif
+
+#ifndef USB_CDC_NOTIFICATION_ENDPOINT
+#define USB_CDC_NOTIFICATION_ENDPOINT 3
+#endif
+
+// Ring sizes of the bulk pipe in bytes
+#ifndef USB_CDC_WRITE_BUFFER_SIZE
+#define USB_CDC_WRITE_BUFFER_SIZE 4096
+#endif
+
+#ifndef USB_CDC_READ_BUFFER_SIZE
+#define USB_CDC_READ_BUFFER_SIZE 4096
+#endif
+
+struct TinyCLR_UsbCdc_LineCoding {
+    uint32_t BaudRate;
+    uint8_t StopBits;
+    uint8_t Parity;
+    uint8_t DataBits;
+};
+
+// Strings are optional and must stay valid until the function is released.
+struct TinyCLR_UsbCdc_DeviceInfo {
+    uint16_t VendorId;
+    uint16_t ProductId;
+    uint16_t DeviceVersion;
+    const wchar_t* Manufacturer;
+    const wchar_t* Product;
+    const wchar_t* SerialNumber;
+};
+
+// Raised from the USB interrupt when the host changes the line coding or the control line state.
+typedef void(*TinyCLR_UsbCdc_LineStateChangedHandler)(const TinyCLR_UsbClient_Controller* self, uint64_t timestamp);
+
+// The function takes the whole controller: it sets the device descriptor, acquires the controller and opens its pipes.
+TinyCLR_Result TinyCLR_UsbCdc_Acquire(const TinyCLR_UsbClient_Controller* self, const TinyCLR_UsbCdc_DeviceInfo* deviceInfo);
+TinyCLR_Result TinyCLR_UsbCdc_Release(const TinyCLR_UsbClient_Controller* self);
+TinyCLR_Result TinyCLR_UsbCdc_Write(const TinyCLR_UsbClient_Controller* self, const uint8_t* data, size_t& length);
+TinyCLR_Result TinyCLR_UsbCdc_Read(const TinyCLR_UsbClient_Controller* self, uint8_t* data, size_t& length);
+TinyCLR_Result TinyCLR_UsbCdc_Flush(const TinyCLR_UsbClient_Controller* self);
+TinyCLR_Result TinyCLR_UsbCdc_GetDataPipe(const TinyCLR_UsbClient_Controller* self, uint32_t& pipe);
+TinyCLR_Result TinyCLR_UsbCdc_GetLineCoding(const TinyCLR_UsbClient_Controller* self, TinyCLR_UsbCdc_LineCoding& lineCoding);
+uint16_t TinyCLR_UsbCdc_GetControlLineState(const TinyCLR_UsbClient_Controller* self);
+TinyCLR_Result TinyCLR_UsbCdc_SetSerialState(const TinyCLR_UsbClient_Controller* self, uint16_t serialState);
+TinyCLR_Result TinyCLR_UsbCdc_SetLineStateChangedHandler(const TinyCLR_UsbClient_Controller* self, TinyCLR_UsbCdc_LineStateChangedHandler handler);
+
+bool TinyCLR_UsbCdc_ProcessClassRequest(UsbClientState* usbClientState, const TinyCLR_UsbClient_SetupPacket* setup, const uint8_t* data, const uint8_t*& responsePayload, size_t& responsePayloadLength);
@@ -37,7 +37,7 @@ void TinyCLR_UsbClient_SetEvent(UsbClientState *usbClientState, uint32_t event)
 
     usbClientState->event |= event;
 
-    if (old_event != usbClientState->event) {
+    if (old_event != usbClientState->event && TinyCLR_UsbClient_SetDataReceivedEvent != nullptr) {
         TinyCLR_UsbClient_SetDataReceivedEvent(nullptr, TinyCLR_UsbClient_Now());
     }
 }
@@ -56,8 +56,10 @@ void TinyCLR_UsbClient_ClearQueues(UsbClientState *usbClientState, bool ClrRxQue
         TinyCLR_UsbClient_InterfaceDescriptor* ifcx = (TinyCLR_UsbClient_InterfaceDescriptor*)&usbClientState->deviceDescriptor.Configurations->Interfaces[ifc];
 
         if (ClrRxQueue) {
-            for (auto endpoint = 0; endpoint < ifcx->EndpointCount; endpoint++) {
-                if (usbClientState->queues[endpoint] == nullptr || usbClientState->isTxQueue[endpoint])
+            for (auto i = 0; i < ifcx->EndpointCount; i++) {
+                auto endpoint = ifcx->Endpoints[i].Address & 0x0F;
+
+                if (endpoint >= usbClientState->totalEndpointsCount || usbClientState->queues[endpoint] == nullptr || usbClientState->isTxQueue[endpoint])
                     continue;
 
                 TinyCLR_UsbClient_ClearEndpoints(usbClientState, endpoint);
@@ -68,8 +70,10 @@ void TinyCLR_UsbClient_ClearQueues(UsbClientState *usbClientState, bool ClrRxQue
         }
 
         if (ClrTxQueue) {
-            for (auto endpoint = 0; endpoint < ifcx->EndpointCount; endpoint++) {
-                if (usbClientState->queues[endpoint] && usbClientState->isTxQueue[endpoint])
+            for (auto i = 0; i < ifcx->EndpointCount; i++) {
+                auto endpoint = ifcx->Endpoints[i].Address & 0x0F;
+
+                if (endpoint < usbClientState->totalEndpointsCount && usbClientState->queues[endpoint] && usbClientState->isTxQueue[endpoint])
                     TinyCLR_UsbClient_ClearEndpoints(usbClientState, endpoint);
             }
         }
@@ -353,162 +357,168 @@ uint8_t TinyCLR_UsbClient_HandleSetAddress(UsbClientState* usbClientState, TinyC
     return USB_STATE_ADDRESS;
 }
 
-uint8_t TinyCLR_UsbClient_HandleConfigurationRequests(UsbClientState* usbClientState, TinyCLR_UsbClient_SetupPacket* Setup) {
-    const uint8_t* header;
-    uint8_t       type;
-    uint8_t       DescriptorIndex;
-    int32_t offset = 0;
+// Writes one descriptor as the host sees it, length and type first. Only counts the bytes when buffer is nullptr.
+static void TinyCLR_UsbClient_SerializeDescriptor(uint8_t* buffer, size_t& size, uint8_t type, const void* data, size_t length) {
+    if (buffer != nullptr) {
+        buffer[size + 0] = 2 + length;
+        buffer[size + 1] = type;
 
-    auto controllerIndex = usbClientState->controllerIndex;
+        memcpy(&buffer[size + 2], data, length);
+    }
 
-    /* this request is valid regardless of device state */
-    type = ((Setup->Value & 0xFF00) >> 8);
-    DescriptorIndex = (Setup->Value & 0x00FF);
-    usbClientState->expected = Setup->Length;
+    size += 2 + length;
+}
 
-    if (usbClientState->expected == 0) {
-        // just return an empty Status packet
-        usbClientState->residualCount = 0;
-        usbClientState->dataCallback = TinyCLR_UsbClient_DataCallback;
-        return USB_STATE_DATA;
-    }
+static void TinyCLR_UsbClient_SerializeVendorClassDescriptors(uint8_t* buffer, size_t& size, const TinyCLR_UsbClient_VendorClassDescriptor* vendors, size_t count) {
+    for (auto i = 0; i < count; i++)
+        TinyCLR_UsbClient_SerializeDescriptor(buffer, size, vendors[i].Type, vendors[i].Payload, vendors[i].Length);
+}
 
-    // The very first GET_DESCRIPTOR command out of reset should always return at most maxEndpointsPacketSize[0] bytes.
-    // After that, you can return as many as the host has asked.
-    if (usbClientState->deviceState <= USB_DEVICE_STATE_DEFAULT) {
-        if (usbClientState->firstGetDescriptor) {
-            usbClientState->firstGetDescriptor = false;
+// The configuration descriptor is followed by its class descriptors and by every interface, each interface by its
+// class descriptors and endpoints, each endpoint by its class descriptors.
+static size_t TinyCLR_UsbClient_SerializeConfiguration(uint8_t* buffer, const TinyCLR_UsbClient_ConfigurationDescriptor* configuration) {
+    size_t size = 0;
 
-            usbClientState->expected = __min(usbClientState->expected, usbClientState->maxEndpointsPacketSize[0]);
+    TinyCLR_UsbClient_SerializeDescriptor(buffer, size, USB_CONFIGURATION_DESCRIPTOR_TYPE, configuration, USB_CONFIGURATION_DESCRIPTOR_STRUCTURE_SIZE);
+    TinyCLR_UsbClient_SerializeVendorClassDescriptors(buffer, size, configuration->VendorClassDescriptors, configuration->VendorClassDescriptorCount);
+
+    for (auto i = 0; i < configuration->InterfaceCount; i++) {
+        auto ifc = &configuration->Interfaces[i];
+
+        TinyCLR_UsbClient_SerializeDescriptor(buffer, size, USB_INTERFACE_DESCRIPTOR_TYPE, ifc, USB_INTERFACE_DESCRIPTOR_STRUCTURE_SIZE);
+        TinyCLR_UsbClient_SerializeVendorClassDescriptors(buffer, size, ifc->VendorClassDescriptors, ifc->VendorClassDescriptorCount);
+
+        for (auto endpoint = 0; endpoint < ifc->EndpointCount; endpoint++) {
+            auto ep = &ifc->Endpoints[endpoint];
+
+            TinyCLR_UsbClient_SerializeDescriptor(buffer, size, USB_ENDPOINT_DESCRIPTOR_TYPE, ep, USB_ENDPOINT_DESCRIPTOR_STRUCTURE_SIZE);
+            TinyCLR_UsbClient_SerializeVendorClassDescriptors(buffer, size, ep->VendorClassDescriptors, ep->VendorClassDescriptorCount);
         }
     }
 
-    usbClientState->residualData = nullptr;
-    usbClientState->residualCount = 0;
+    if (buffer != nullptr) {
+        buffer[2] = (size >> 0) & 0xFF;
+        buffer[3] = (size >> 8) & 0xFF;
+    }
 
-    if (Setup->Request == USB_GET_DESCRIPTOR) {
-        switch (type) {
-        case USB_DEVICE_DESCRIPTOR_TYPE:
-            header = TinyCLR_UsbClient_FindRecord(usbClientState, USB_DEVICE_DESCRIPTOR_TYPE, Setup);
-            if (header) {
-                auto size = 0;
-                usbClientState->controlEndpointBuffer[1] = USB_DEVICE_DESCRIPTOR_TYPE;
+    return size;
+}
 
-                size += 2;
+// Serializes the device, configuration and string descriptors once into one allocation, so GET_DESCRIPTOR only points
+// the data stage at them. String descriptors are found through a table indexed by the descriptor index that follows
+// the descriptors, the first string with an index wins as before.
+static uint8_t* TinyCLR_UsbClient_SerializeDescriptors(UsbClientState* usbClientState, const TinyCLR_Memory_Manager* memoryManager) {
+    auto descriptor = &usbClientState->deviceDescriptor;
 
-                memcpy(reinterpret_cast<uint8_t*>(&usbClientState->controlEndpointBuffer[size]), header, USB_DEVICE_DESCRIPTOR_STRUCTURE_SIZE);
+    size_t size = 0;
+    size_t configurationSize = 0;
+    size_t stringCount = 0;
 
-                size += USB_DEVICE_DESCRIPTOR_STRUCTURE_SIZE;
+    TinyCLR_UsbClient_SerializeDescriptor(nullptr, size, USB_DEVICE_DESCRIPTOR_TYPE, descriptor, USB_DEVICE_DESCRIPTOR_STRUCTURE_SIZE);
 
-                usbClientState->controlEndpointBuffer[0] = size;
+    if (descriptor->Configurations != nullptr)
+        configurationSize = TinyCLR_UsbClient_SerializeConfiguration(nullptr, descriptor->Configurations);
 
-                // ready to send
-                usbClientState->residualData = usbClientState->controlEndpointBuffer;
-                usbClientState->residualCount = __min(usbClientState->expected, size);
-            }
+    size += configurationSize;
 
-            break;
+    for (auto i = 0; i < descriptor->StringCount; i++) {
+        size += 2 + descriptor->Strings[i].Length * 2;
 
-        case USB_CONFIGURATION_DESCRIPTOR_TYPE:
-            header = TinyCLR_UsbClient_FindRecord(usbClientState, USB_CONFIGURATION_DESCRIPTOR_TYPE, Setup);
+        if (descriptor->Strings[i].Index >= stringCount)
+            stringCount = descriptor->Strings[i].Index + 1;
+    }
 
-            if (header) {
+    size = (size + 3) & ~3;
 
-                usbClientState->controlEndpointBuffer[0] = (2 + USB_CONFIGURATION_DESCRIPTOR_STRUCTURE_SIZE);
-                usbClientState->controlEndpointBuffer[1] = USB_CONFIGURATION_DESCRIPTOR_TYPE;
+    auto data = reinterpret_cast<uint8_t*>(memoryManager->Allocate(memoryManager, size + stringCount * sizeof(USB_DESCRIPTOR_RECORD)));
 
-                auto size = 2;
+    if (data == nullptr)
+        return nullptr;
 
-                // Parse configuration
-                memcpy(reinterpret_cast<uint8_t*>(&usbClientState->controlEndpointBuffer[size]), header, USB_CONFIGURATION_DESCRIPTOR_STRUCTURE_SIZE);
-                size += USB_CONFIGURATION_DESCRIPTOR_STRUCTURE_SIZE;
+    auto strings = reinterpret_cast<USB_DESCRIPTOR_RECORD*>(data + size);
 
-                // Parse Vendor Class Descriptor
-                for (auto vendor_id = 0; vendor_id < usbClientState->deviceDescriptor.Configurations->VendorClassDescriptorCount; vendor_id++) {
-                    auto vendor = (TinyCLR_UsbClient_VendorClassDescriptor*)&usbClientState->deviceDescriptor.Configurations->VendorClassDescriptors[vendor_id];
+    memset(reinterpret_cast<uint8_t*>(strings), 0x00, stringCount * sizeof(USB_DESCRIPTOR_RECORD));
 
-                    usbClientState->controlEndpointBuffer[size + 0] = 2 + vendor->Length;
-                    usbClientState->controlEndpointBuffer[size + 1] = vendor->Type;
+    size = 0;
 
-                    size += 2;
-                    memcpy(reinterpret_cast<uint8_t*>(&usbClientState->controlEndpointBuffer[size]), vendor->Payload, vendor->Length);
-                    size += vendor->Length;
-                }
+    TinyCLR_UsbClient_SerializeDescriptor(data, size, USB_DEVICE_DESCRIPTOR_TYPE, descriptor, USB_DEVICE_DESCRIPTOR_STRUCTURE_SIZE);
 
-                // Parse interfaces
-                for (auto interface_id = 0; interface_id < usbClientState->deviceDescriptor.Configurations->InterfaceCount; interface_id++) {
-                    auto interface_size_index = size;
+    if (descriptor->Configurations != nullptr)
+        size += TinyCLR_UsbClient_SerializeConfiguration(data + size, descriptor->Configurations);
 
-                    usbClientState->controlEndpointBuffer[size + 0] = 2 + USB_INTERFACE_DESCRIPTOR_STRUCTURE_SIZE;
-                    usbClientState->controlEndpointBuffer[size + 1] = USB_INTERFACE_DESCRIPTOR_TYPE;
+    for (auto i = 0; i < descriptor->StringCount; i++) {
+        auto str = &descriptor->Strings[i];
+        auto record = &strings[str->Index];
+        auto offset = size;
 
-                    size += 2;
-                    memcpy(reinterpret_cast<uint8_t*>(&usbClientState->controlEndpointBuffer[size]), reinterpret_cast<uint8_t*>(const_cast<TinyCLR_UsbClient_InterfaceDescriptor*>(&usbClientState->deviceDescriptor.Configurations->Interfaces[interface_id])), USB_INTERFACE_DESCRIPTOR_STRUCTURE_SIZE);
-                    size += USB_INTERFACE_DESCRIPTOR_STRUCTURE_SIZE;
+        TinyCLR_UsbClient_SerializeDescriptor(data, size, USB_STRING_DESCRIPTOR_TYPE, str->Data, str->Length * 2);
 
-                    auto ifc = (TinyCLR_UsbClient_InterfaceDescriptor*)&usbClientState->deviceDescriptor.Configurations->Interfaces[interface_id];
+        if (record->Size == 0) {
+            record->Offset = offset;
+            record->Size = size - offset;
+        }
+    }
 
-                    // Parse Vendor Class Descriptor
-                    for (auto vendor_id = 0; vendor_id < ifc->VendorClassDescriptorCount; vendor_id++) {
-                        auto vendor = (TinyCLR_UsbClient_VendorClassDescriptor*)&ifc->VendorClassDescriptors[vendor_id];
+    usbClientState->configurationDescriptorSize = configurationSize;
+    usbClientState->stringDescriptors = strings;
+    usbClientState->stringDescriptorCount = stringCount;
 
-                        usbClientState->controlEndpointBuffer[size + 0] = 2 + vendor->Length;
-                        usbClientState->controlEndpointBuffer[size + 1] = vendor->Type;
+    return data;
+}
 
-                        size += 2;
-                        memcpy(reinterpret_cast<uint8_t*>(&usbClientState->controlEndpointBuffer[size]), vendor->Payload, vendor->Length);
-                        size += vendor->Length;
-                    }
+uint8_t TinyCLR_UsbClient_HandleConfigurationRequests(UsbClientState* usbClientState, TinyCLR_UsbClient_SetupPacket* Setup) {
+    uint8_t       type;
+    uint8_t       DescriptorIndex;
 
-                    // Parse Endpoints
-                    for (auto endpoint = 0; endpoint < ifc->EndpointCount; endpoint++) {
-                        auto ep = (TinyCLR_UsbClient_EndpointDescriptor*)&ifc->Endpoints[endpoint];
+    auto controllerIndex = usbClientState->controllerIndex;
 
-                        usbClientState->controlEndpointBuffer[size + 0] = USB_ENDPOINT_DESCRIPTOR_STRUCTURE_SIZE + 2;
-                        usbClientState->controlEndpointBuffer[size + 1] = USB_ENDPOINT_DESCRIPTOR_TYPE;
+    /* this request is valid regardless of device state */
+    type = ((Setup->Value & 0xFF00) >> 8);
+    DescriptorIndex = (Setup->Value & 0x00FF);
+    usbClientState->expected = Setup->Length;
 
-                        size += 2;
-                        memcpy(reinterpret_cast<uint8_t*>(&usbClientState->controlEndpointBuffer[size]), reinterpret_cast<uint8_t*>(ep), USB_ENDPOINT_DESCRIPTOR_STRUCTURE_SIZE);
-                        size += USB_ENDPOINT_DESCRIPTOR_STRUCTURE_SIZE;
+    if (usbClientState->expected == 0) {
+        // just return an empty Status packet
+        usbClientState->residualCount = 0;
+        usbClientState->dataCallback = TinyCLR_UsbClient_DataCallback;
+        return USB_STATE_DATA;
+    }
 
-                        // Parse Vendor Class Descriptor
-                        for (auto vendor_id = 0; vendor_id < ep->VendorClassDescriptorCount; vendor_id++) {
-                            auto vendor = (TinyCLR_UsbClient_VendorClassDescriptor*)&ep->VendorClassDescriptors[vendor_id];
+    // The very first GET_DESCRIPTOR command out of reset should always return at most maxEndpointsPacketSize[0] bytes.
+    // After that, you can return as many as the host has asked.
+    if (usbClientState->deviceState <= USB_DEVICE_STATE_DEFAULT) {
+        if (usbClientState->firstGetDescriptor) {
+            usbClientState->firstGetDescriptor = false;
 
-                            usbClientState->controlEndpointBuffer[size + 0] = 2 + vendor->Length;
-                            usbClientState->controlEndpointBuffer[size + 1] = vendor->Type;
+            usbClientState->expected = __min(usbClientState->expected, usbClientState->maxEndpointsPacketSize[0]);
+        }
+    }
 
-                            size += 2;
-                            memcpy(reinterpret_cast<uint8_t*>(&usbClientState->controlEndpointBuffer[size]), vendor->Payload, vendor->Length);
-                            size += vendor->Length;
-                        }
-                    }
-                }
+    usbClientState->residualData = nullptr;
+    usbClientState->residualCount = 0;
 
-                // Update size
-                usbClientState->controlEndpointBuffer[2] = (size >> 0) & 0xFF;
-                usbClientState->controlEndpointBuffer[3] = (size >> 8) & 0xFF;
+    if (Setup->Request == USB_GET_DESCRIPTOR) {
+        switch (type) {
+        case USB_DEVICE_DESCRIPTOR_TYPE:
+            usbClientState->residualData = usbClientState->descriptorData;
+            usbClientState->residualCount = __min(usbClientState->expected, USB_DEVICE_DESCRIPTOR_SIZE);
 
-                // ready to send
-                usbClientState->residualData = usbClientState->controlEndpointBuffer;
-                usbClientState->residualCount = __min(usbClientState->expected, size);
-            }
             break;
 
-        case USB_STRING_DESCRIPTOR_TYPE:
-
-            if (nullptr != (header = TinyCLR_UsbClient_FindRecord(usbClientState, USB_STRING_DESCRIPTOR_TYPE, Setup))) {
-                TinyCLR_UsbClient_StringDescriptor* str = (TinyCLR_UsbClient_StringDescriptor*)header;
-
-                auto size = 2 + str->Length * 2;
+        case USB_CONFIGURATION_DESCRIPTOR_TYPE:
+            if (usbClientState->configurationDescriptorSize != 0) {
+                usbClientState->residualData = usbClientState->descriptorData + USB_DEVICE_DESCRIPTOR_SIZE;
+                usbClientState->residualCount = __min(usbClientState->expected, usbClientState->configurationDescriptorSize);
+            }
 
-                usbClientState->controlEndpointBuffer[0] = size;
-                usbClientState->controlEndpointBuffer[1] = USB_STRING_DESCRIPTOR_TYPE;
+            break;
 
-                memcpy(reinterpret_cast<uint8_t*>(&usbClientState->controlEndpointBuffer[2]), reinterpret_cast<uint8_t*>(const_cast<wchar_t*>(str->Data)), str->Length * 2);
+        case USB_STRING_DESCRIPTOR_TYPE:
+            if (DescriptorIndex < usbClientState->stringDescriptorCount && usbClientState->stringDescriptors[DescriptorIndex].Size != 0) {
+                auto record = &usbClientState->stringDescriptors[DescriptorIndex];
 
-                usbClientState->residualData = usbClientState->controlEndpointBuffer;
-                usbClientState->residualCount = __min(usbClientState->expected, size);
+                usbClientState->residualData = usbClientState->descriptorData + record->Offset;
+                usbClientState->residualCount = __min(usbClientState->expected, record->Size);
             }
 
             break;
@@ -531,27 +541,53 @@ uint8_t TinyCLR_UsbClient_HandleConfigurationRequests(UsbClientState* usbClientS
             break;
         }
     }
-    else {
-        if (Setup->RequestType & (USB_REQUEST_TYPE_VENDOR | USB_REQUEST_TYPE_CLASS)) {
-            const uint8_t* responsePayload;
 
-            size_t responsePayloadLength = 0;
+    // If the request was not recognized, the generic types should be searched
+    if (usbClientState->residualData == nullptr) {
+        return USB_STATE_STALL;
+    }
 
-            if (TinyCLR_UsbClient_ProcessVendorClassRequestEvent != nullptr) {
-                if (TinyCLR_UsbClient_ProcessVendorClassRequestEvent(&usbClientControllers[controllerIndex], Setup, responsePayload, responsePayloadLength, TinyCLR_UsbClient_Now()) == TinyCLR_Result::Success) {
-                    memcpy(usbClientState->controlEndpointBuffer, reinterpret_cast<uint8_t*>(const_cast<uint8_t*>(responsePayload)), responsePayloadLength);
+    usbClientState->dataCallback = TinyCLR_UsbClient_DataCallback;
 
-                    usbClientState->residualData = usbClientState->controlEndpointBuffer;
-                    usbClientState->residualCount = __min(usbClientState->expected, responsePayloadLength);
-                }
-            }
+    return USB_STATE_DATA;
+}
 
-        }
+// Class and vendor requests go to the class function built into the firmware first and to the managed handler after
+// that. Data is the data stage of a control write, requests without data for the host only get the status stage.
+uint8_t TinyCLR_UsbClient_HandleClassRequest(UsbClientState* usbClientState, TinyCLR_UsbClient_SetupPacket* Setup, const uint8_t* data) {
+    const uint8_t* responsePayload = nullptr;
+
+    size_t responsePayloadLength = 0;
+
+    auto controllerIndex = usbClientState->controllerIndex;
+    auto handled = false;
+
+    if (usbClientState->classRequestHandler != nullptr)
+        handled = usbClientState->classRequestHandler(usbClientState, Setup, data, responsePayload, responsePayloadLength);
+
+    if (!handled && TinyCLR_UsbClient_ProcessVendorClassRequestEvent != nullptr)
+        handled = TinyCLR_UsbClient_ProcessVendorClassRequestEvent(&usbClientControllers[controllerIndex], Setup, responsePayload, responsePayloadLength, TinyCLR_UsbClient_Now()) == TinyCLR_Result::Success;
+
+    usbClientState->residualData = usbClientState->controlEndpointBuffer;
+    usbClientState->residualCount = 0;
+
+    if ((Setup->RequestType & USB_REQUEST_TYPE_IN) == 0 || Setup->Length == 0) {
+        // requests without a data stage are acknowledged even when nobody knew them, as they always were
+        if (!handled && Setup->Length != 0)
+            return USB_STATE_STALL;
+
+        usbClientState->expected = 0;
     }
+    else {
+        if (!handled)
+            return USB_STATE_STALL;
 
-    // If the request was not recognized, the generic types should be searched
-    if (usbClientState->residualData == nullptr) {
-        return USB_STATE_STALL;
+        responsePayloadLength = __min(responsePayloadLength, USB_ENDPOINT_CONTROL_BUFFER_SIZE);
+
+        memcpy(usbClientState->controlEndpointBuffer, reinterpret_cast<uint8_t*>(const_cast<uint8_t*>(responsePayload)), responsePayloadLength);
+
+        usbClientState->expected = Setup->Length;
+        usbClientState->residualCount = __min(usbClientState->expected, responsePayloadLength);
     }
 
     usbClientState->dataCallback = TinyCLR_UsbClient_DataCallback;
@@ -662,6 +698,26 @@ uint8_t TinyCLR_UsbClient_ControlCallback(UsbClientState* usbClientState) {
 
     Setup = (TinyCLR_UsbClient_SetupPacket*)usbClientState->ptrData;
 
+    // a new setup packet ends any control write the host gave up on
+    usbClientState->controlOutPending = false;
+
+    if (Setup->RequestType & (USB_REQUEST_TYPE_VENDOR | USB_REQUEST_TYPE_CLASS)) {
+        if ((Setup->RequestType & USB_REQUEST_TYPE_IN) == 0 && Setup->Length > 0) {
+            if (Setup->Length > USB_CONTROL_OUT_DATA_SIZE)
+                return USB_STATE_STALL;
+
+            // collect the data stage first, the request is handled once all of it arrived
+            memcpy(reinterpret_cast<uint8_t*>(&usbClientState->controlOutSetup), reinterpret_cast<uint8_t*>(Setup), sizeof(TinyCLR_UsbClient_SetupPacket));
+
+            usbClientState->controlOutCount = 0;
+            usbClientState->controlOutPending = true;
+
+            return USB_STATE_DONE;
+        }
+
+        return TinyCLR_UsbClient_HandleClassRequest(usbClientState, Setup, nullptr);
+    }
+
     switch (Setup->Request) {
     case USB_GET_STATUS:
         return TinyCLR_UsbClient_HandleGetStatus(usbClientState, Setup);
@@ -682,10 +738,38 @@ uint8_t TinyCLR_UsbClient_ControlCallback(UsbClientState* usbClientState) {
     return USB_STATE_STALL;
 }
 
-USB_PACKET64* TinyCLR_UsbClient_RxEnqueue(UsbClientState* usbClientState, int32_t endpoint, bool& disableRx) {
-    USB_PACKET64* packet;
+// The controller drivers call this for every packet with data the host sends in the data stage of a control transfer
+uint8_t TinyCLR_UsbClient_ControlOutCallback(UsbClientState* usbClientState) {
+    if (!usbClientState->controlOutPending)
+        return USB_STATE_STALL;
+
+    auto setup = &usbClientState->controlOutSetup;
+    auto length = __min(usbClientState->dataSize, setup->Length - usbClientState->controlOutCount);
+
+    memcpy(&usbClientState->controlOutData[usbClientState->controlOutCount], usbClientState->ptrData, length);
+
+    usbClientState->controlOutCount += length;
+
+    if (usbClientState->controlOutCount < setup->Length) {
+        // only a short packet ends the data stage early
+        if (usbClientState->dataSize == usbClientState->maxEndpointsPacketSize[0])
+            return USB_STATE_DONE;
+
+        usbClientState->controlOutPending = false;
+
+        return USB_STATE_STALL;
+    }
+
+    usbClientState->controlOutPending = false;
+
+    return TinyCLR_UsbClient_HandleClassRequest(usbClientState, setup, usbClientState->controlOutData);
+}
+
+uint8_t* TinyCLR_UsbClient_RxEnqueue(UsbClientState* usbClientState, int32_t endpoint, bool& disableRx) {
+    auto buffer = usbClientState->queues[endpoint];
+    auto maxPacketSize = usbClientState->maxEndpointsPacketSize[endpoint];
 
-    if (usbClientState->fifoPacketCount[endpoint] == usbClientState->maxFifoPacketCount[endpoint]) {
+    if (buffer == nullptr || buffer->Size - buffer->Count < maxPacketSize) {
         disableRx = true;
 
         return nullptr;
@@ -693,43 +777,167 @@ USB_PACKET64* TinyCLR_UsbClient_RxEnqueue(UsbClientState* usbClientState, int32_
 
     disableRx = false;
 
-    packet = &usbClientState->queues[endpoint][usbClientState->fifoPacketIn[endpoint]];
+    // the packet is read straight into the ring when it fits without wrapping
+    if (buffer->In + maxPacketSize <= buffer->Size && (buffer->In & 3) == 0)
+        return &buffer->Data[buffer->In];
 
-    usbClientState->fifoPacketIn[endpoint]++;
-    usbClientState->fifoPacketCount[endpoint]++;
+    return reinterpret_cast<uint8_t*>(buffer->Staging);
+}
 
-    if (usbClientState->fifoPacketIn[endpoint] == usbClientState->maxFifoPacketCount[endpoint])
-        usbClientState->fifoPacketIn[endpoint] = 0;
+void TinyCLR_UsbClient_RxCommit(UsbClientState* usbClientState, int32_t endpoint, uint32_t size) {
+    auto buffer = usbClientState->queues[endpoint];
+    auto maxPacketSize = usbClientState->maxEndpointsPacketSize[endpoint];
 
-    TinyCLR_UsbClient_SetEvent(usbClientState, 1 << endpoint);
+    if (size > maxPacketSize)
+        size = maxPacketSize;
+
+    if (!(buffer->In + maxPacketSize <= buffer->Size && (buffer->In & 3) == 0)) {
+        auto first = __min(size, buffer->Size - buffer->In);
+
+        memcpy(&buffer->Data[buffer->In], buffer->Staging, first);
+        memcpy(buffer->Data, reinterpret_cast<uint8_t*>(buffer->Staging) + first, size - first);
+    }
+
+    buffer->In += size;
+
+    if (buffer->In >= buffer->Size)
+        buffer->In -= buffer->Size;
 
-    return packet;
+    buffer->Count += size;
+
+    TinyCLR_UsbClient_SetEvent(usbClientState, 1 << endpoint);
 }
 
-USB_PACKET64* TinyCLR_UsbClient_TxDequeue(UsbClientState* usbClientState, int32_t endpoint) {
-    USB_PACKET64* packet;
+uint8_t* TinyCLR_UsbClient_TxDequeue(UsbClientState* usbClientState, int32_t endpoint, uint32_t& size) {
+    auto buffer = usbClientState->queues[endpoint];
+    auto maxPacketSize = usbClientState->maxEndpointsPacketSize[endpoint];
 
-    if (usbClientState->fifoPacketCount[endpoint] == 0) {
+    if (buffer == nullptr || buffer->TransferCount == 0)
         return nullptr;
+
+    auto remaining = buffer->Transfers[buffer->TransferOut];
+
+    // the write being copied in can only send full packets, its end is not known yet
+    if (remaining < maxPacketSize && buffer->TransferOpen && buffer->TransferCount == 1)
+        return nullptr;
+
+    size = __min(remaining, maxPacketSize);
+
+    uint8_t* data;
+
+    if (buffer->Out + size <= buffer->Size && (buffer->Out & 3) == 0) {
+        data = &buffer->Data[buffer->Out];
+    }
+    else {
+        auto first = __min(size, buffer->Size - buffer->Out);
+
+        data = reinterpret_cast<uint8_t*>(buffer->Staging);
+
+        memcpy(data, &buffer->Data[buffer->Out], first);
+        memcpy(data + first, buffer->Data, size - first);
+    }
+
+    buffer->Out += size;
+
+    if (buffer->Out >= buffer->Size)
+        buffer->Out -= buffer->Size;
+
+    buffer->Count -= size;
+
+    // a short packet, zero length included, ends the write
+    if (size < maxPacketSize) {
+        buffer->TransferCount--;
+        buffer->TransferOut++;
+
+        if (buffer->TransferOut == USB_ENDPOINT_TRANSFER_COUNT)
+            buffer->TransferOut = 0;
     }
+    else {
+        buffer->Transfers[buffer->TransferOut] = remaining - size;
+    }
+
+    return data;
+}
+
+// Size of the packet TxDequeue returns after index others, -1 when it is not queued yet.
+int32_t TinyCLR_UsbClient_TxPeek(UsbClientState* usbClientState, int32_t endpoint, int32_t index) {
+    auto buffer = usbClientState->queues[endpoint];
+    auto maxPacketSize = usbClientState->maxEndpointsPacketSize[endpoint];
+
+    if (buffer == nullptr)
+        return -1;
+
+    for (auto i = 0, transfer = static_cast<int32_t>(buffer->TransferOut); i < buffer->TransferCount; i++) {
+        auto remaining = buffer->Transfers[transfer];
+        auto fullPackets = static_cast<int32_t>(remaining / maxPacketSize);
+        auto packets = (buffer->TransferOpen && i == buffer->TransferCount - 1) ? fullPackets : fullPackets + 1;
+
+        if (index < packets)
+            return index < fullPackets ? maxPacketSize : remaining - fullPackets * maxPacketSize;
+
+        index -= packets;
+
+        if (++transfer == USB_ENDPOINT_TRANSFER_COUNT)
+            transfer = 0;
+    }
+
+    return -1;
+}
+
+// Picks how many queued packets go out in one IN transfer: full size packets up to maxPackets, ended by the
+// first short packet. A zero length packet is always sent as a transfer of its own so the host still sees
+// the end of a transfer that was an exact multiple of the packet size.
+uint32_t TinyCLR_UsbClient_GetTxPacketCount(UsbClientState* usbClientState, int32_t endpoint, uint32_t maxPackets, uint32_t& size) {
+    auto maxPacketSize = usbClientState->maxEndpointsPacketSize[endpoint];
+    uint32_t packets = 0;
+
+    size = 0;
 
-    packet = &usbClientState->queues[endpoint][usbClientState->fifoPacketOut[endpoint]];
+    while (packets < maxPackets) {
+        auto packetSize = TinyCLR_UsbClient_TxPeek(usbClientState, endpoint, packets);
+
+        if (packetSize < 0 || (packetSize == 0 && packets > 0))
+            break;
 
-    usbClientState->fifoPacketCount[endpoint]--;
-    usbClientState->fifoPacketOut[endpoint]++;
+        packets++;
+        size += packetSize;
 
-    if (usbClientState->fifoPacketOut[endpoint] == usbClientState->maxFifoPacketCount[endpoint])
-        usbClientState->fifoPacketOut[endpoint] = 0;
+        if (packetSize < maxPacketSize)
+            break;
+    }
 
-    return packet;
+    return packets;
 }
 
 void TinyCLR_UsbClient_ClearEndpoints(UsbClientState* usbClientState, int32_t endpoint) {
-    usbClientState->fifoPacketIn[endpoint] = usbClientState->fifoPacketOut[endpoint] = usbClientState->fifoPacketCount[endpoint] = 0;
+    auto buffer = usbClientState->queues[endpoint];
+
+    if (buffer == nullptr)
+        return;
+
+    buffer->In = buffer->Out = buffer->Count = 0;
+    buffer->TransferIn = buffer->TransferOut = buffer->TransferCount = 0;
+    buffer->TransferOpen = false;
+    buffer->Generation++;
 }
 
 bool TinyCLR_UsbClient_CanReceivePackage(UsbClientState* usbClientState, int32_t endpoint) {
-    return usbClientState->fifoPacketCount[endpoint] < usbClientState->maxFifoPacketCount[endpoint];
+    auto buffer = usbClientState->queues[endpoint];
+
+    return buffer != nullptr && buffer->Size - buffer->Count >= usbClientState->maxEndpointsPacketSize[endpoint];
+}
+
+static USB_ENDPOINT_BUFFER* TinyCLR_UsbClient_AllocateBuffer(const TinyCLR_Memory_Manager* memoryManager, uint32_t size) {
+    auto buffer = reinterpret_cast<USB_ENDPOINT_BUFFER*>(memoryManager->Allocate(memoryManager, sizeof(USB_ENDPOINT_BUFFER) + size));
+
+    if (buffer != nullptr) {
+        memset(reinterpret_cast<uint8_t*>(buffer), 0x00, sizeof(USB_ENDPOINT_BUFFER));
+
+        buffer->Data = reinterpret_cast<uint8_t*>(buffer + 1);
+        buffer->Size = size;
+    }
+
+    return buffer;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////
@@ -817,60 +1025,44 @@ TinyCLR_Result TinyCLR_UsbClient_Acquire(const TinyCLR_UsbClient_Controller* sel
         if (apiManager != nullptr) {
             auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
 
-            usbClientState->queues = reinterpret_cast<USB_PACKET64**>(memoryManager->Allocate(memoryManager, usbClientState->totalEndpointsCount * sizeof(uint32_t)));
-            usbClientState->currentPacketOffset = reinterpret_cast<uint8_t*>(memoryManager->Allocate(memoryManager, usbClientState->totalEndpointsCount * sizeof(uint8_t)));
+            usbClientState->queues = reinterpret_cast<USB_ENDPOINT_BUFFER**>(memoryManager->Allocate(memoryManager, usbClientState->totalEndpointsCount * sizeof(USB_ENDPOINT_BUFFER*)));
+            usbClientState->queueSize = reinterpret_cast<uint32_t*>(memoryManager->Allocate(memoryManager, usbClientState->totalEndpointsCount * sizeof(uint32_t)));
             usbClientState->isTxQueue = reinterpret_cast<bool*>(memoryManager->Allocate(memoryManager, usbClientState->totalEndpointsCount * sizeof(bool)));
 
-            usbClientState->fifoPacketIn = reinterpret_cast<uint8_t*>(memoryManager->Allocate(memoryManager, usbClientState->totalEndpointsCount * sizeof(uint8_t)));
-            usbClientState->fifoPacketOut = reinterpret_cast<uint8_t*>(memoryManager->Allocate(memoryManager, usbClientState->totalEndpointsCount * sizeof(uint8_t)));
-            usbClientState->fifoPacketCount = reinterpret_cast<uint8_t*>(memoryManager->Allocate(memoryManager, usbClientState->totalEndpointsCount * sizeof(uint8_t)));
-            usbClientState->maxFifoPacketCount = reinterpret_cast<uint8_t*>(memoryManager->Allocate(memoryManager, usbClientState->totalEndpointsCount * sizeof(uint8_t)));
-
             usbClientState->pipes = reinterpret_cast<USB_PIPE_MAP*>(memoryManager->Allocate(memoryManager, usbClientState->totalPipesCount * sizeof(USB_PIPE_MAP)));
 
             usbClientState->controlEndpointBuffer = reinterpret_cast<uint8_t*>(memoryManager->Allocate(memoryManager, USB_ENDPOINT_CONTROL_BUFFER_SIZE));
+            usbClientState->descriptorData = TinyCLR_UsbClient_SerializeDescriptors(usbClientState, memoryManager);
 
             usbClientState->endpointStatus = reinterpret_cast<uint16_t*>(memoryManager->Allocate(memoryManager, usbClientState->totalEndpointsCount * sizeof(uint16_t)));
             usbClientState->maxEndpointsPacketSize = reinterpret_cast<uint8_t*>(memoryManager->Allocate(memoryManager, usbClientState->totalEndpointsCount * sizeof(uint8_t)));
 
             if (usbClientState->queues == nullptr
-                || usbClientState->currentPacketOffset == nullptr
+                || usbClientState->queueSize == nullptr
                 || usbClientState->isTxQueue == nullptr
-                || usbClientState->fifoPacketIn == nullptr
-                || usbClientState->fifoPacketOut == nullptr
-                || usbClientState->fifoPacketCount == nullptr
-                || usbClientState->maxFifoPacketCount == nullptr
                 || usbClientState->pipes == nullptr
                 || usbClientState->controlEndpointBuffer == nullptr
+                || usbClientState->descriptorData == nullptr
                 || usbClientState->maxEndpointsPacketSize == nullptr
                 || usbClientState->endpointStatus == nullptr) {
                 if (usbClientState->queues != nullptr)
                     memoryManager->Free(memoryManager, usbClientState->queues);
 
-                if (usbClientState->currentPacketOffset != nullptr)
-                    memoryManager->Free(memoryManager, usbClientState->currentPacketOffset);
+                if (usbClientState->queueSize != nullptr)
+                    memoryManager->Free(memoryManager, usbClientState->queueSize);
 
                 if (usbClientState->isTxQueue != nullptr)
                     memoryManager->Free(memoryManager, usbClientState->isTxQueue);
 
-                if (usbClientState->fifoPacketIn != nullptr)
-                    memoryManager->Free(memoryManager, usbClientState->fifoPacketIn);
-
-                if (usbClientState->fifoPacketOut != nullptr)
-                    memoryManager->Free(memoryManager, usbClientState->fifoPacketOut);
-
-                if (usbClientState->fifoPacketCount != nullptr)
-                    memoryManager->Free(memoryManager, usbClientState->fifoPacketCount);
-
-                if (usbClientState->maxFifoPacketCount != nullptr)
-                    memoryManager->Free(memoryManager, usbClientState->maxFifoPacketCount);
-
                 if (usbClientState->pipes != nullptr)
                     memoryManager->Free(memoryManager, usbClientState->pipes);
 
                 if (usbClientState->controlEndpointBuffer != nullptr)
                     memoryManager->Free(memoryManager, usbClientState->controlEndpointBuffer);
 
+                if (usbClientState->descriptorData != nullptr)
+                    memoryManager->Free(memoryManager, usbClientState->descriptorData);
+
                 if (usbClientState->endpointStatus != nullptr)
                     memoryManager->Free(memoryManager, usbClientState->endpointStatus);
 
@@ -881,22 +1073,18 @@ TinyCLR_Result TinyCLR_UsbClient_Acquire(const TinyCLR_UsbClient_Controller* sel
             }
 
             // Reset buffer, make sure no random value in RAM after soft reset
-            memset(reinterpret_cast<uint8_t*>(usbClientState->queues), 0x00, usbClientState->totalEndpointsCount * sizeof(uint32_t));
-            memset(reinterpret_cast<uint8_t*>(usbClientState->currentPacketOffset), 0x00, usbClientState->totalEndpointsCount * sizeof(uint8_t));
-
-            memset(reinterpret_cast<uint8_t*>(usbClientState->fifoPacketIn), 0x00, usbClientState->totalEndpointsCount * sizeof(uint8_t));
-            memset(reinterpret_cast<uint8_t*>(usbClientState->fifoPacketOut), 0x00, usbClientState->totalEndpointsCount * sizeof(uint8_t));
-            memset(reinterpret_cast<uint8_t*>(usbClientState->fifoPacketCount), 0x00, usbClientState->totalEndpointsCount * sizeof(uint8_t));
-            memset(reinterpret_cast<uint8_t*>(usbClientState->maxFifoPacketCount), 0x00, usbClientState->totalEndpointsCount * sizeof(uint8_t));
+            memset(reinterpret_cast<uint8_t*>(usbClientState->queues), 0x00, usbClientState->totalEndpointsCount * sizeof(USB_ENDPOINT_BUFFER*));
+            memset(reinterpret_cast<uint8_t*>(usbClientState->queueSize), 0x00, usbClientState->totalEndpointsCount * sizeof(uint32_t));
 
             for (auto i = 0; i < usbClientState->totalPipesCount; i++) {
                 usbClientState->pipes[i].RxEP = USB_ENDPOINT_NULL;
                 usbClientState->pipes[i].TxEP = USB_ENDPOINT_NULL;
+                usbClientState->pipes[i].WriteTimeout = USB_WRITE_TIMEOUT_DEFAULT;
             }
 
             for (auto i = 0; i < usbClientState->totalEndpointsCount; i++) {
                 usbClientState->maxEndpointsPacketSize[i] = TinyCLR_UsbClient_GetEndpointSize(i);
-                usbClientState->maxFifoPacketCount[i] = usbClientState->maxFifoPacketCountDefault;
+                usbClientState->queueSize[i] = usbClientState->maxFifoPacketCountDefault * usbClientState->maxEndpointsPacketSize[i];
             }
 
             usbClientState->initialized = true;
@@ -938,17 +1126,13 @@ TinyCLR_Result TinyCLR_UsbClient_Release(const TinyCLR_UsbClient_Controller* sel
                 auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
 
                 memoryManager->Free(memoryManager, usbClientState->queues);
-                memoryManager->Free(memoryManager, usbClientState->currentPacketOffset);
+                memoryManager->Free(memoryManager, usbClientState->queueSize);
                 memoryManager->Free(memoryManager, usbClientState->isTxQueue);
 
-                memoryManager->Free(memoryManager, usbClientState->fifoPacketIn);
-                memoryManager->Free(memoryManager, usbClientState->fifoPacketOut);
-                memoryManager->Free(memoryManager, usbClientState->fifoPacketCount);
-                memoryManager->Free(memoryManager, usbClientState->maxFifoPacketCount);
-
                 memoryManager->Free(memoryManager, usbClientState->pipes);
 
                 memoryManager->Free(memoryManager, usbClientState->controlEndpointBuffer);
+                memoryManager->Free(memoryManager, usbClientState->descriptorData);
                 memoryManager->Free(memoryManager, usbClientState->endpointStatus);
                 memoryManager->Free(memoryManager, usbClientState->maxEndpointsPacketSize);
             }
@@ -958,9 +1142,8 @@ TinyCLR_Result TinyCLR_UsbClient_Release(const TinyCLR_UsbClient_Controller* sel
     return TinyCLR_Result::Success;
 }
 
-TinyCLR_Result TinyCLR_UsbClient_OpenPipe(const TinyCLR_UsbClient_Controller* self, uint8_t writeEndpoint, uint8_t readEndpoint, uint32_t& pipe) {
-    UsbClientState * usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
-
+// Sets up a pipe without starting the controller, so a class function can open all of its pipes before the host sees the device
+TinyCLR_Result TinyCLR_UsbClient_AllocatePipe(UsbClientState* usbClientState, uint8_t writeEndpoint, uint8_t readEndpoint, uint32_t& pipe) {
     if (!usbClientState->initialized)
         goto pipe_error;
 
@@ -976,11 +1159,7 @@ TinyCLR_Result TinyCLR_UsbClient_OpenPipe(const TinyCLR_UsbClient_Controller* se
             auto endpoint = (i == 0) ? writeEndpoint : readEndpoint;
 
             if (memoryManager != nullptr && endpoint < usbClientState->totalEndpointsCount) {
-                usbClientState->queues[endpoint] = (USB_PACKET64*)memoryManager->Allocate(memoryManager, usbClientState->maxFifoPacketCount[endpoint] * sizeof(USB_PACKET64));
-
-                memset(reinterpret_cast<uint8_t*>(usbClientState->queues[endpoint]), 0x00, usbClientState->maxFifoPacketCount[endpoint] * sizeof(USB_PACKET64));
-
-                TinyCLR_UsbClient_ClearEndpoints(usbClientState, endpoint);
+                usbClientState->queues[endpoint] = TinyCLR_UsbClient_AllocateBuffer(memoryManager, usbClientState->queueSize[endpoint]);
             }
         }
 
@@ -996,10 +1175,7 @@ TinyCLR_Result TinyCLR_UsbClient_OpenPipe(const TinyCLR_UsbClient_Controller* se
         // All tests pass, assign the endpoints to the pipe
         usbClientState->pipes[pipe].RxEP = readEndpoint;
         usbClientState->pipes[pipe].TxEP = writeEndpoint;
-
-        if (usbClientState->currentState == USB_DEVICE_STATE_UNINITIALIZED) {
-            TinyCLR_UsbClient_Initialize(usbClientState);
-        }
+        usbClientState->pipes[pipe].WriteTimeout = USB_WRITE_TIMEOUT_DEFAULT;
 
         return TinyCLR_Result::Success;
     }
@@ -1008,6 +1184,18 @@ pipe_error:
     return TinyCLR_Result::NotAvailable;
 }
 
+TinyCLR_Result TinyCLR_UsbClient_OpenPipe(const TinyCLR_UsbClient_Controller* self, uint8_t writeEndpoint, uint8_t readEndpoint, uint32_t& pipe) {
+    UsbClientState * usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    auto result = TinyCLR_UsbClient_AllocatePipe(usbClientState, writeEndpoint, readEndpoint, pipe);
+
+    if (result == TinyCLR_Result::Success && usbClientState->currentState == USB_DEVICE_STATE_UNINITIALIZED) {
+        TinyCLR_UsbClient_Initialize(usbClientState);
+    }
+
+    return result;
+}
+
 TinyCLR_Result TinyCLR_UsbClient_ClosePipe(const TinyCLR_UsbClient_Controller* self, uint32_t pipe) {
     UsbClientState * usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
 
@@ -1041,12 +1229,21 @@ TinyCLR_Result TinyCLR_UsbClient_ClosePipe(const TinyCLR_UsbClient_Controller* s
 }
 
 TinyCLR_Result TinyCLR_UsbClient_WritePipe(const TinyCLR_UsbClient_Controller* self, uint32_t pipe, const uint8_t* data, size_t& length) {
+    if (data == nullptr || length == 0)
+        return TinyCLR_Result::NotAvailable;
+
+    return TinyCLR_UsbClient_WriteTransfer(self, pipe, data, length, true);
+}
+
+// Queues data to the transfer left open by the previous call or to a new one. Only full packets go out while the
+// transfer is open, ending it sends what is left as a short packet. Ending a transfer with nothing left in it
+// sends a zero length packet, or nothing at all when no data was queued since the last end.
+TinyCLR_Result TinyCLR_UsbClient_WriteTransfer(const TinyCLR_UsbClient_Controller* self, uint32_t pipe, const uint8_t* data, size_t& length, bool endTransfer) {
     UsbClientState * usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
 
     if (!usbClientState->initialized
         || usbClientState->deviceState != USB_DEVICE_STATE_CONFIGURED
-        || data == nullptr
-        || length == 0) {
+        || (data == nullptr && length > 0)) {
         return TinyCLR_Result::NotAvailable;
     }
 
@@ -1056,104 +1253,126 @@ TinyCLR_Result TinyCLR_UsbClient_WritePipe(const TinyCLR_UsbClient_Controller* s
         return TinyCLR_Result::NotAvailable;
     }
 
+    auto interruptController = (apiManager != nullptr) ? reinterpret_cast<const TinyCLR_Interrupt_Controller*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::InterruptController)) : nullptr;
+
     DISABLE_INTERRUPTS_SCOPED(irq);
 
+    auto buffer = usbClientState->queues[endpoint];
+    auto timeout = usbClientState->pipes[pipe].WriteTimeout;
+
     const uint8_t*      ptr = data;
     uint32_t            count = length;
-    bool                Done = false;
-    uint32_t            WaitLoopCnt = 0;
+    uint64_t            waitStart = 0;
     int32_t             totWrite = 0;
+    bool                started = false;
+    bool                waiting = false;
+    uint32_t            generation = buffer->Generation;
+
+    // a write left open by the previous call goes on
+    if (buffer->TransferOpen)
+        started = true;
+
+    // The data is queued as one write. The controller driver cuts it into packets of the maximum length
+    // for the endpoint and ends it with a shorter packet - even if the packet length must be zero for
+    // this to occur. This is done to comply with standard USB bulk-mode transfers.
+    while (count > 0) {
+        // the endpoint was cleared while interrupts were enabled
+        if (buffer->Generation != generation) {
+            started = false;
+
+            goto done_write;
+        }
 
-    // This loop packetizes the data and sends it out.  All packets sent have
-    // the maximum length for the given endpoint except for the last packet which
-    // will always have less than the maximum length - even if the packet length
-    // must be zero for this to occur.   This is done to comply with standard
-    // USB bulk-mode transfers.
-    while (!Done) {
+        uint32_t space = buffer->Size - buffer->Count;
 
-        USB_PACKET64* Packet64 = nullptr;
+        if (!started && buffer->TransferCount == USB_ENDPOINT_TRANSFER_COUNT)
+            space = 0;
 
-        if (usbClientState->fifoPacketCount[endpoint] < usbClientState->maxFifoPacketCount[endpoint]) {
-            Packet64 = &usbClientState->queues[endpoint][usbClientState->fifoPacketIn[endpoint]];
+        if (space > 0) {
+            if (!started) {
+                buffer->Transfers[buffer->TransferIn] = 0;
+                buffer->TransferOpen = true;
+                buffer->TransferCount++;
 
-            usbClientState->fifoPacketIn[endpoint]++;
-            usbClientState->fifoPacketCount[endpoint]++;
+                started = true;
+            }
 
-            if (usbClientState->fifoPacketIn[endpoint] == usbClientState->maxFifoPacketCount[endpoint])
-                usbClientState->fifoPacketIn[endpoint] = 0;
-        }
+            auto move = __min(count, space);
+            auto in = buffer->In;
+            auto first = __min(move, buffer->Size - in);
 
-        if (Packet64) {
-            uint32_t max_move;
+            buffer->In = (in + move >= buffer->Size) ? in + move - buffer->Size : in + move;
 
-            if (count > usbClientState->maxEndpointsPacketSize[endpoint])
-                max_move = usbClientState->maxEndpointsPacketSize[endpoint];
-            else
-                max_move = count;
+            // only the Tx interrupt reads the ring and it never goes past Count, copy with interrupts on
+            irq.Release();
 
-            if (max_move) {
-                memcpy(Packet64->Buffer, ptr, max_move);
-            }
+            memcpy(&buffer->Data[in], ptr, first);
+            memcpy(buffer->Data, ptr + first, move - first);
+
+            irq.Acquire();
 
-            // we are done when we send a non-full length packet
-            if (max_move < usbClientState->maxEndpointsPacketSize[endpoint]) {
-                Done = true;
+            // the endpoint was cleared while copying
+            if (buffer->Generation != generation) {
+                started = false;
+
+                goto done_write;
             }
 
-            Packet64->Size = max_move;
-            count -= max_move;
-            ptr += max_move;
+            buffer->Count += move;
+            buffer->Transfers[buffer->TransferIn] += move;
 
-            totWrite += max_move;
+            count -= move;
+            ptr += move;
 
-            WaitLoopCnt = 0;
-        }
-        if (Packet64 == nullptr) {
-            // a 64-byte USB packet takes less than 50uSec
-            // according to the timing calculations of the USB Chief
-            // this is way too short to bother with a call
-            // to WaitForEventsInternal, so just uSec delay the path
-            // here for 50uSec.
-
-            // if in ISR, return
-
-            // if more than 100*50us=5ms,still no packet avaialable, PC side go wrong,stop the loop
-            // otherwise it will spin here forever and stopwatch get kick in.
-            WaitLoopCnt++;
-            if (WaitLoopCnt > 100) {
-                // if we were unable to send any data then no one is listening so lets
-                if (count == length) {
-                    TinyCLR_UsbClient_ClearEndpoints(usbClientState, endpoint);
-                }
+            totWrite += move;
 
-                goto done_write;
-            }
+            waiting = false;
 
-            if (irq.IsDisabled()) // @todo - this really needs more checks to be totally valid
-            {
+            if (usbClientState->deviceState == USB_DEVICE_STATE_CONFIGURED) {
+                TinyCLR_UsbClient_StartOutput(usbClientState, endpoint);
+            }
+        }
+        else {
+            // can't wait for the host with interrupts disabled or when the pipe is non-blocking
+            if (timeout == USB_WRITE_TIMEOUT_NONE || irq.IsDisabled() || usbClientState->deviceState != USB_DEVICE_STATE_CONFIGURED) {
                 goto done_write;
             }
 
-            if (usbClientState->deviceState != USB_DEVICE_STATE_CONFIGURED) {
+            // system time is in 100ns ticks
+            if (!waiting) {
+                waitStart = TinyCLR_UsbClient_Now();
+                waiting = true;
+            }
+            else if (timeout != USB_WRITE_TIMEOUT_INFINITE && TinyCLR_UsbClient_Now() - waitStart >= static_cast<uint64_t>(timeout) * 10000) {
                 goto done_write;
             }
 
             TinyCLR_UsbClient_StartOutput(usbClientState, endpoint);
 
-            irq.Release();
+            // A timer interrupt ends the sleep at the deadline even when the bus stays quiet. Interrupts stay masked from
+            // the checks above until the sleep, so one raised in between wakes it instead of being missed.
+            if (timeout != USB_WRITE_TIMEOUT_INFINITE)
+                TinyCLR_UsbClient_ScheduleWakeup(waitStart + static_cast<uint64_t>(timeout) * 10000);
 
-            TinyCLR_UsbClient_Delay(50);
-
-            irq.Acquire();
+            // sleep until an interrupt, the Tx interrupt frees ring space as the host takes packets
+            if (interruptController != nullptr)
+                interruptController->WaitForInterrupt();
         }
     }
 
-    // here we have a post-condition that IRQs are disabled for all paths through conditional block above
-    if (usbClientState->deviceState == USB_DEVICE_STATE_CONFIGURED) {
-        TinyCLR_UsbClient_StartOutput(usbClientState, endpoint);
+done_write:
+    // close the write so its last packet can go out
+    if (started && endTransfer) {
+        buffer->TransferOpen = false;
+
+        if (++buffer->TransferIn == USB_ENDPOINT_TRANSFER_COUNT)
+            buffer->TransferIn = 0;
+
+        if (usbClientState->deviceState == USB_DEVICE_STATE_CONFIGURED) {
+            TinyCLR_UsbClient_StartOutput(usbClientState, endpoint);
+        }
     }
 
-done_write:
     length = totWrite;
 
     return TinyCLR_Result::Success;
@@ -1175,47 +1394,38 @@ TinyCLR_Result TinyCLR_UsbClient_ReadPipe(const TinyCLR_UsbClient_Controller* se
 
     DISABLE_INTERRUPTS_SCOPED(irq);
 
-    USB_PACKET64* Packet64 = nullptr;
-    uint8_t*        ptr = reinterpret_cast<uint8_t*>(data);
-    uint32_t        count = 0;
-    uint32_t        remain = length;
+    auto buffer = usbClientState->queues[endpoint];
 
-    while (count < length) {
-        uint32_t max_move;
+    uint32_t count = __min(length, buffer->Count);
+    uint32_t out = buffer->Out;
+    uint32_t first = __min(count, buffer->Size - out);
+    uint32_t generation = buffer->Generation;
 
-        if (usbClientState->fifoPacketCount[endpoint] > 0) {
-            Packet64 = &usbClientState->queues[endpoint][usbClientState->fifoPacketOut[endpoint]];
+    // the Rx interrupt only writes to the free part of the ring, copy with interrupts on
+    irq.Release();
 
-            usbClientState->fifoPacketCount[endpoint]--;
-            usbClientState->fifoPacketOut[endpoint]++;
-
-            if (usbClientState->fifoPacketOut[endpoint] == usbClientState->maxFifoPacketCount[endpoint]) {
-                usbClientState->fifoPacketOut[endpoint] = 0;
-            }
-        }
+    memcpy(data, &buffer->Data[out], first);
+    memcpy(data + first, buffer->Data, count - first);
 
-        if (!Packet64) {
-            TinyCLR_UsbClient_ClearEvent(usbClientState, 1 << endpoint);
-            break;
-        }
+    irq.Acquire();
 
-        max_move = Packet64->Size - usbClientState->currentPacketOffset[endpoint];
-        if (remain < max_move) max_move = remain;
+    // the endpoint was cleared while copying, the ring is empty and the copied bytes are gone with it
+    if (buffer->Generation != generation) {
+        length = 0;
 
-        memcpy(ptr, &Packet64->Buffer[usbClientState->currentPacketOffset[endpoint]], max_move);
+        return TinyCLR_Result::Success;
+    }
 
-        usbClientState->currentPacketOffset[endpoint] += max_move;
-        ptr += max_move;
-        count += max_move;
-        remain -= max_move;
+    buffer->Out = (out + count >= buffer->Size) ? out + count - buffer->Size : out + count;
+    buffer->Count -= count;
 
-        /* if we're done with this packet, move onto the next */
-        if (usbClientState->currentPacketOffset[endpoint] == Packet64->Size) {
-            usbClientState->currentPacketOffset[endpoint] = 0;
-            Packet64 = nullptr;
+    if (buffer->Count == 0) {
+        TinyCLR_UsbClient_ClearEvent(usbClientState, 1 << endpoint);
+    }
 
-            TinyCLR_UsbClient_RxEnable(usbClientState, endpoint);
-        }
+    /* there may be room for another packet now */
+    if (count > 0) {
+        TinyCLR_UsbClient_RxEnable(usbClientState, endpoint);
     }
 
     length = count;
@@ -1227,7 +1437,7 @@ TinyCLR_Result TinyCLR_UsbClient_ReadPipe(const TinyCLR_UsbClient_Controller* se
 TinyCLR_Result TinyCLR_UsbClient_FlushPipe(const TinyCLR_UsbClient_Controller* self, uint32_t pipe) {
     int32_t endpoint;
     int32_t retries = USB_FLUSH_RETRY_COUNT;
-    int32_t queueCnt;
+    uint32_t queueCnt;
     UsbClientState * usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
 
     /* not configured, no data can go in or out */
@@ -1241,17 +1451,20 @@ TinyCLR_Result TinyCLR_UsbClient_FlushPipe(const TinyCLR_UsbClient_Controller* s
         return TinyCLR_Result::NotAvailable;
     }
 
-    queueCnt = usbClientState->fifoPacketCount[endpoint];
+    auto buffer = usbClientState->queues[endpoint];
+
+    // pending zero length packets count as progress too
+    queueCnt = buffer->Count + buffer->TransferCount;
 
     // interrupts were disabled or USB interrupt was disabled for whatever reason, so force the flush
-    while (usbClientState->fifoPacketCount[endpoint] > 0 && retries > 0) {
+    while (buffer->TransferCount > 0 && retries > 0) {
         TinyCLR_UsbClient_StartOutput(usbClientState, endpoint);
 
-        TinyCLR_UsbClient_Delay(queueCnt == usbClientState->fifoPacketCount[endpoint] ? 100 : 0); // don't call Events_WaitForEventsXXX because it will turn off interrupts
+        TinyCLR_UsbClient_Delay(queueCnt == buffer->Count + buffer->TransferCount ? 100 : 0); // don't call Events_WaitForEventsXXX because it will turn off interrupts
 
-        retries = (queueCnt == usbClientState->fifoPacketCount[endpoint]) ? retries - 1 : USB_FLUSH_RETRY_COUNT;
+        retries = (queueCnt == buffer->Count + buffer->TransferCount) ? retries - 1 : USB_FLUSH_RETRY_COUNT;
 
-        queueCnt = usbClientState->fifoPacketCount[endpoint];
+        queueCnt = buffer->Count + buffer->TransferCount;
     }
 
     if (retries <= 0)
@@ -1260,6 +1473,26 @@ TinyCLR_Result TinyCLR_UsbClient_FlushPipe(const TinyCLR_UsbClient_Controller* s
     return TinyCLR_Result::Success;
 }
 
+TinyCLR_Result TinyCLR_UsbClient_SetWriteTimeout(const TinyCLR_UsbClient_Controller* self, uint32_t pipe, uint32_t timeout) {
+    UsbClientState * usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    if (!usbClientState->initialized || pipe >= usbClientState->totalPipesCount)
+        return TinyCLR_Result::NotAvailable;
+
+    usbClientState->pipes[pipe].WriteTimeout = timeout;
+
+    return TinyCLR_Result::Success;
+}
+
+uint32_t TinyCLR_UsbClient_GetWriteTimeout(const TinyCLR_UsbClient_Controller* self, uint32_t pipe) {
+    UsbClientState * usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    if (!usbClientState->initialized || pipe >= usbClientState->totalPipesCount)
+        return USB_WRITE_TIMEOUT_NONE;
+
+    return usbClientState->pipes[pipe].WriteTimeout;
+}
+
 TinyCLR_Result TinyCLR_UsbClient_SetDataReceivedHandler(const TinyCLR_UsbClient_Controller* self, TinyCLR_UsbClient_DataReceivedHandler handler) {
     TinyCLR_UsbClient_SetDataReceivedEvent = handler;
 
@@ -1297,7 +1530,10 @@ size_t TinyCLR_UsbClient_GetBytesToWrite(const TinyCLR_UsbClient_Controller* sel
 
     int32_t endpoint = usbClientState->pipes[pipe].TxEP;
 
-    return usbClientState->fifoPacketCount[endpoint];
+    if (endpoint == USB_ENDPOINT_NULL || usbClientState->queues[endpoint] == nullptr)
+        return 0;
+
+    return usbClientState->queues[endpoint]->Count;
 #else
     return 0;
 #endif
@@ -1309,7 +1545,10 @@ size_t TinyCLR_UsbClient_GetBytesToRead(const TinyCLR_UsbClient_Controller* self
 
     int32_t endpoint = usbClientState->pipes[pipe].RxEP;
 
-    return usbClientState->fifoPacketCount[endpoint];
+    if (endpoint == USB_ENDPOINT_NULL || usbClientState->queues[endpoint] == nullptr)
+        return 0;
+
+    return usbClientState->queues[endpoint]->Count;
 #else
     return 0;
 #endif
@@ -1349,7 +1588,10 @@ size_t TinyCLR_UsbClient_GetWriteBufferSize(const TinyCLR_UsbClient_Controller*
 
     int32_t endpoint = usbClientState->pipes[pipe].TxEP;
 
-    return usbClientState->maxFifoPacketCount[endpoint];
+    if (endpoint == USB_ENDPOINT_NULL)
+        return 0;
+
+    return usbClientState->queueSize[endpoint];
 #else
     return 0;
 #endif
@@ -1361,39 +1603,52 @@ size_t TinyCLR_UsbClient_GetReadBufferSize(const TinyCLR_UsbClient_Controller* s
 
     int32_t endpoint = usbClientState->pipes[pipe].RxEP;
 
-    return usbClientState->maxFifoPacketCount[endpoint];
+    if (endpoint == USB_ENDPOINT_NULL)
+        return 0;
+
+    return usbClientState->queueSize[endpoint];
 #else
     return 0;
 #endif
 }
 
-TinyCLR_Result TinyCLR_UsbClient_SetWriteBufferSize(const TinyCLR_UsbClient_Controller* self, uint32_t pipe, size_t size) {
-#if DEVICE_MEMORY_PROFILE_FACTOR > 5
-    UsbClientState * usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+// Sizes are in bytes and must hold at least one packet. Queued data is dropped when the ring is reallocated.
+static TinyCLR_Result TinyCLR_UsbClient_SetBufferSize(UsbClientState* usbClientState, int32_t endpoint, size_t size) {
+    if (endpoint == USB_ENDPOINT_NULL)
+        return TinyCLR_Result::NotAvailable;
 
-    int32_t endpoint = usbClientState->pipes[pipe].TxEP;
+    if (size < usbClientState->maxEndpointsPacketSize[endpoint])
+        return TinyCLR_Result::ArgumentOutOfRange;
 
-    if (usbClientState->maxFifoPacketCount[endpoint] != size) {
-        usbClientState->maxFifoPacketCount[endpoint] = size;
+    if (usbClientState->queueSize[endpoint] == size)
+        return TinyCLR_Result::Success;
 
-        if (apiManager != nullptr) {
-            auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
+    if (usbClientState->queues[endpoint] != nullptr && apiManager != nullptr) {
+        auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
 
-            if (usbClientState->queues[endpoint] != nullptr) {
-                // free if allocated
-                memoryManager->Free(memoryManager, usbClientState->queues[endpoint]);
-            }
+        auto buffer = TinyCLR_UsbClient_AllocateBuffer(memoryManager, size);
 
-            // relocated
-            usbClientState->queues[endpoint] = (USB_PACKET64*)memoryManager->Allocate(memoryManager, usbClientState->maxFifoPacketCount[endpoint] * sizeof(USB_PACKET64));
+        if (buffer == nullptr)
+            return TinyCLR_Result::OutOfMemory;
 
-            memset(reinterpret_cast<uint8_t*>(usbClientState->queues[endpoint]), 0x00, usbClientState->maxFifoPacketCount[endpoint] * sizeof(USB_PACKET64));
+        DISABLE_INTERRUPTS_SCOPED(irq);
 
-            TinyCLR_UsbClient_ClearEndpoints(usbClientState, endpoint);
-        }
+        // relocated
+        memoryManager->Free(memoryManager, usbClientState->queues[endpoint]);
+
+        usbClientState->queues[endpoint] = buffer;
     }
 
+    usbClientState->queueSize[endpoint] = size;
+
     return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_UsbClient_SetWriteBufferSize(const TinyCLR_UsbClient_Controller* self, uint32_t pipe, size_t size) {
+#if DEVICE_MEMORY_PROFILE_FACTOR > 5
+    UsbClientState * usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    return TinyCLR_UsbClient_SetBufferSize(usbClientState, usbClientState->pipes[pipe].TxEP, size);
 #else
     return TinyCLR_Result::NotSupported;
 #endif
@@ -1403,29 +1658,12 @@ TinyCLR_Result TinyCLR_UsbClient_SetReadBufferSize(const TinyCLR_UsbClient_Contr
 #if DEVICE_MEMORY_PROFILE_FACTOR > 5
     UsbClientState * usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
 
-    int32_t endpoint = usbClientState->pipes[pipe].RxEP;
-
-    if (usbClientState->maxFifoPacketCount[endpoint] != size) {
-        usbClientState->maxFifoPacketCount[endpoint] = size;
+    auto result = TinyCLR_UsbClient_SetBufferSize(usbClientState, usbClientState->pipes[pipe].RxEP, size);
 
-        if (apiManager != nullptr) {
-            auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
+    if (result == TinyCLR_Result::Success)
+        TinyCLR_UsbClient_RxEnable(usbClientState, usbClientState->pipes[pipe].RxEP);
 
-            if (usbClientState->queues[endpoint] != nullptr) {
-                // free if allocated
-                memoryManager->Free(memoryManager, usbClientState->queues[endpoint]);
-            }
-
-            // relocated
-            usbClientState->queues[endpoint] = (USB_PACKET64*)memoryManager->Allocate(memoryManager, usbClientState->maxFifoPacketCount[endpoint] * sizeof(USB_PACKET64));
-
-            memset(reinterpret_cast<uint8_t*>(usbClientState->queues[endpoint]), 0x00, usbClientState->maxFifoPacketCount[endpoint] * sizeof(USB_PACKET64));
-
-            TinyCLR_UsbClient_ClearEndpoints(usbClientState, endpoint);
-        }
-    }
-
-    return TinyCLR_Result::Success;
+    return result;
 #else
     return TinyCLR_Result::NotSupported;
 #endif
@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#pragma once
+
 #include <string.h>
 #include <TinyCLR.h>
 #include <Device.h>
@@ -112,17 +114,65 @@
 #define USB_CONFIGURATION_DESCRIPTOR_STRUCTURE_SIZE 7
 #define USB_DEVICE_DESCRIPTOR_STRUCTURE_SIZE        16
 
+#define USB_DEVICE_DESCRIPTOR_SIZE (2 + USB_DEVICE_DESCRIPTOR_STRUCTURE_SIZE)
+
 // This size must be large than WinUsb xproperty os size (0x8E)
 #define USB_ENDPOINT_CONTROL_BUFFER_SIZE 256
 
-struct USB_PACKET64 {
+// Largest packet of a full speed bulk or interrupt endpoint
+#define USB_MAX_PACKET_SIZE 64
+
+// Writes that can be queued on a Tx endpoint at the same time
+#define USB_ENDPOINT_TRANSFER_COUNT 16
+
+// Byte ring behind one pipe endpoint, the data follows the structure in the same allocation.
+// A Tx ring also keeps the bytes left of every queued write so the controller drivers can still end
+// each write with a short or zero length packet. Packets that wrap around the end of the ring or do not
+// start on a word boundary go through Staging, so the drivers always see a contiguous aligned packet.
+struct USB_ENDPOINT_BUFFER {
+    uint8_t* Data;
     uint32_t Size;
-    uint8_t Buffer[64];
+    uint32_t In;
+    uint32_t Out;
+    uint32_t Count;
+    uint32_t Generation;
+
+    uint32_t Transfers[USB_ENDPOINT_TRANSFER_COUNT];
+    uint8_t TransferIn;
+    uint8_t TransferOut;
+    uint8_t TransferCount;
+    bool TransferOpen;
+
+    uint32_t Staging[USB_MAX_PACKET_SIZE / 4];
+};
+
+// Write timeouts are in milliseconds and count from the last time the write made progress.
+// USB_WRITE_TIMEOUT_NONE returns at once with what fit in the ring, USB_WRITE_TIMEOUT_INFINITE waits for the host.
+#define USB_WRITE_TIMEOUT_NONE 0
+#define USB_WRITE_TIMEOUT_INFINITE 0xFFFFFFFF
+
+#ifndef USB_WRITE_TIMEOUT_DEFAULT
+#define USB_WRITE_TIMEOUT_DEFAULT 5
+#endif
+
+// Largest data stage of a class or vendor control write the stack collects
+#define USB_CONTROL_OUT_DATA_SIZE 64
+
+// Class functions built into the firmware see class and vendor requests before the managed handler does.
+// Data holds the data stage of a control write and is nullptr for every other request. Returning false
+// passes the request on to the handler set with SetVendorClassRequestHandler.
+typedef bool(*USB_CLASS_REQUEST_HANDLER)(UsbClientState* usbClientState, const TinyCLR_UsbClient_SetupPacket* setup, const uint8_t* data, const uint8_t*& responsePayload, size_t& responsePayloadLength);
+
+// Where a serialized descriptor starts in the descriptor data and how many bytes the host gets
+struct USB_DESCRIPTOR_RECORD {
+    uint32_t Offset;
+    uint16_t Size;
 };
 
 struct USB_PIPE_MAP {
     uint8_t RxEP;
     uint8_t TxEP;
+    uint32_t WriteTimeout;
 };
 
 struct UsbClientState {
@@ -134,8 +184,8 @@ struct UsbClientState {
     TinyCLR_UsbClient_DeviceDescriptor deviceDescriptor;
 
     /* queues & maxPacketSize must be initialized by the HAL */
-    USB_PACKET64** queues;
-    uint8_t* currentPacketOffset;
+    USB_ENDPOINT_BUFFER** queues;
+    uint32_t* queueSize;
     bool* isTxQueue;
 
     /* Arbitrarily as many pipes as endpoints since that is the maximum number of pipes
@@ -170,14 +220,26 @@ struct UsbClientState {
     uint16_t residualCount;
     uint16_t expected;
 
-    uint8_t* fifoPacketIn;
-    uint8_t* fifoPacketOut;
-    uint8_t* fifoPacketCount;
-    uint8_t* maxFifoPacketCount;
+    /* data stage of a class or vendor control write, handled once all of it arrived */
+    TinyCLR_UsbClient_SetupPacket controlOutSetup;
+    uint8_t controlOutData[USB_CONTROL_OUT_DATA_SIZE];
+    uint16_t controlOutCount;
+    bool controlOutPending;
+
+    USB_CLASS_REQUEST_HANDLER classRequestHandler;
+
+    /* default queue size, in packets of the endpoint's max packet size */
     uint8_t maxFifoPacketCountDefault;
 
     uint8_t* controlEndpointBuffer;
 
+    /* descriptors as the host gets them, serialized at acquire: the device descriptor,
+       the configuration descriptor and then the string descriptors, found by index */
+    uint8_t* descriptorData;
+    uint16_t configurationDescriptorSize;
+    USB_DESCRIPTOR_RECORD* stringDescriptors;
+    uint16_t stringDescriptorCount;
+
     bool tableInitialized;
 
     uint16_t initializeCount;
@@ -190,10 +252,14 @@ void TinyCLR_UsbClient_Reset(int32_t controller);
 TinyCLR_Result TinyCLR_UsbClient_Acquire(const TinyCLR_UsbClient_Controller* self);
 TinyCLR_Result TinyCLR_UsbClient_Release(const TinyCLR_UsbClient_Controller* self);
 TinyCLR_Result TinyCLR_UsbClient_OpenPipe(const TinyCLR_UsbClient_Controller* self, uint8_t writeEndpoint, uint8_t readEndpoint, uint32_t& pipe);
+TinyCLR_Result TinyCLR_UsbClient_AllocatePipe(UsbClientState* usbClientState, uint8_t writeEndpoint, uint8_t readEndpoint, uint32_t& pipe);
 TinyCLR_Result TinyCLR_UsbClient_ClosePipe(const TinyCLR_UsbClient_Controller* self, uint32_t pipe);
 TinyCLR_Result TinyCLR_UsbClient_WritePipe(const TinyCLR_UsbClient_Controller* self, uint32_t pipe, const uint8_t* data, size_t& length);
+TinyCLR_Result TinyCLR_UsbClient_WriteTransfer(const TinyCLR_UsbClient_Controller* self, uint32_t pipe, const uint8_t* data, size_t& length, bool endTransfer);
 TinyCLR_Result TinyCLR_UsbClient_ReadPipe(const TinyCLR_UsbClient_Controller* self, uint32_t pipe, uint8_t* data, size_t& length);
 TinyCLR_Result TinyCLR_UsbClient_FlushPipe(const TinyCLR_UsbClient_Controller* self, uint32_t pipe);
+TinyCLR_Result TinyCLR_UsbClient_SetWriteTimeout(const TinyCLR_UsbClient_Controller* self, uint32_t pipe, uint32_t timeout);
+uint32_t TinyCLR_UsbClient_GetWriteTimeout(const TinyCLR_UsbClient_Controller* self, uint32_t pipe);
 TinyCLR_Result TinyCLR_UsbClient_SetDataReceivedHandler(const TinyCLR_UsbClient_Controller* self, TinyCLR_UsbClient_DataReceivedHandler handler);
 TinyCLR_Result TinyCLR_UsbClient_SetDeviceDescriptor(const TinyCLR_UsbClient_Controller* self, const TinyCLR_UsbClient_DeviceDescriptor* descriptor);
 TinyCLR_Result TinyCLR_UsbClient_SetVendorClassRequestHandler(const TinyCLR_UsbClient_Controller* self, TinyCLR_UsbClient_RequestHandler handler);
@@ -211,10 +277,12 @@ TinyCLR_Result TinyCLR_UsbClient_SetReadBufferSize(const TinyCLR_UsbClient_Contr
 
 bool TinyCLR_UsbClient_Initialize(UsbClientState* usbClientState);
 bool TinyCLR_UsbClient_Uninitialize(UsbClientState* usbClientState);
+void TinyCLR_UsbClient_ClearEndpoints(UsbClientState* usbClientState, int32_t endpoint);
 bool TinyCLR_UsbClient_StartOutput(UsbClientState* usbClientState, int32_t endpoint);
 bool TinyCLR_UsbClient_RxEnable(UsbClientState* usbClientState, int32_t endpoint);
 void TinyCLR_UsbClient_Delay(uint64_t microseconds);
 uint64_t TinyCLR_UsbClient_Now();
+void TinyCLR_UsbClient_ScheduleWakeup(uint64_t time);
 TinyCLR_Result TinyCLR_UsbClient_GetControllerCount(const TinyCLR_UsbClient_Controller* self, int32_t& count);
 
 void TinyCLR_UsbClient_InitializeConfiguration(UsbClientState *usbClientState);
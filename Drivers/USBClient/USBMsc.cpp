@@ -0,0 +1,513 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include "USBMsc.h"
+
+#define USB_MSC_INTERFACE 0
+
+#define USB_MSC_STRING_MANUFACTURER 1
+#define USB_MSC_STRING_PRODUCT      2
+#define USB_MSC_STRING_SERIAL       3
+
+#define USB_MSC_STAGE_COMMAND  0
+#define USB_MSC_STAGE_DATA_IN  1
+#define USB_MSC_STAGE_DATA_OUT 2
+#define USB_MSC_STAGE_STATUS   3
+
+struct UsbMscState {
+    const TinyCLR_UsbClient_Controller* controller;
+
+    uint32_t pipe;
+
+    uint8_t* buffer;
+    uint32_t bufferOffset;
+    uint32_t bufferCount;
+
+    uint8_t stage;
+    volatile bool reset;
+
+    // the command being processed: the host moves hostLength bytes, of which the first dataLength are real data
+    // and the rest are padding the device sends or data it throws away
+    uint8_t commandBlock[USB_MSC_CBW_SIZE];
+    uint32_t commandBlockCount;
+    uint32_t tag;
+    uint32_t hostLength;
+    uint32_t dataLength;
+    uint32_t transferred;
+    uint8_t status;
+
+    uint8_t statusBlock[USB_MSC_CSW_SIZE];
+    uint32_t statusBlockCount;
+
+    uint8_t maxLun;
+
+    UsbMscScsiState scsi;
+
+    TinyCLR_UsbClient_DeviceDescriptor deviceDescriptor;
+    TinyCLR_UsbClient_ConfigurationDescriptor configurationDescriptor;
+    TinyCLR_UsbClient_InterfaceDescriptor interfaceDescriptor;
+    TinyCLR_UsbClient_EndpointDescriptor endpointDescriptors[2];
+    TinyCLR_UsbClient_StringDescriptor stringDescriptors[3];
+};
+
+static UsbMscState usbMscState;
+
+static uint8_t TinyCLR_UsbMsc_AddString(UsbMscState* state, size_t& count, uint8_t index, const wchar_t* data) {
+    if (data == nullptr)
+        return 0;
+
+    auto length = 0;
+
+    while (data[length] != 0 && length < (USB_ENDPOINT_CONTROL_BUFFER_SIZE - 2) / 2)
+        length++;
+
+    state->stringDescriptors[count].Index = index;
+    state->stringDescriptors[count].Length = length;
+    state->stringDescriptors[count].Data = data;
+
+    count++;
+
+    return index;
+}
+
+static void TinyCLR_UsbMsc_BuildDescriptors(UsbMscState* state, const TinyCLR_UsbMsc_DeviceInfo* deviceInfo) {
+    auto dataIn = &state->endpointDescriptors[0];
+    auto dataOut = &state->endpointDescriptors[1];
+
+    memset(state->endpointDescriptors, 0, sizeof(state->endpointDescriptors));
+
+    dataIn->Address = USB_ENDPOINT_DIRECTION_IN | USB_MSC_DATA_IN_ENDPOINT;
+    dataIn->Attributes = USB_ENDPOINT_ATTRIBUTE_BULK;
+    dataIn->MaxPacketSize = TinyCLR_UsbClient_GetEndpointSize(USB_MSC_DATA_IN_ENDPOINT);
+
+    dataOut->Address = USB_ENDPOINT_DIRECTION_OUT | USB_MSC_DATA_OUT_ENDPOINT;
+    dataOut->Attributes = USB_ENDPOINT_ATTRIBUTE_BULK;
+    dataOut->MaxPacketSize = TinyCLR_UsbClient_GetEndpointSize(USB_MSC_DATA_OUT_ENDPOINT);
+
+    auto storage = &state->interfaceDescriptor;
+
+    memset(storage, 0, sizeof(TinyCLR_UsbClient_InterfaceDescriptor));
+
+    storage->Number = USB_MSC_INTERFACE;
+    storage->EndpointCount = 2;
+    storage->InterfaceClass = USB_MSC_INTERFACE_CLASS;
+    storage->InterfaceSubClass = USB_MSC_SCSI_TRANSPARENT;
+    storage->InterfaceProtocol = USB_MSC_BULK_ONLY_TRANSPORT;
+    storage->Endpoints = state->endpointDescriptors;
+
+    auto configuration = &state->configurationDescriptor;
+
+    memset(configuration, 0, sizeof(TinyCLR_UsbClient_ConfigurationDescriptor));
+
+    configuration->InterfaceCount = 1;
+    configuration->Number = 1;
+    configuration->Attributes = USB_ATTRIBUTE_BASE | USB_ATTRIBUTE_SELF_POWER;
+    configuration->MaxPower = 50; // 100mA
+    configuration->Interfaces = storage;
+
+    auto device = &state->deviceDescriptor;
+
+    memset(device, 0, sizeof(TinyCLR_UsbClient_DeviceDescriptor));
+
+    size_t strings = 0;
+
+    // the class is given by the interface
+    device->UsbVersion = 0x0200;
+    device->MaxPacketSizeEp0 = TinyCLR_UsbClient_GetEndpointSize(0);
+    device->VendorId = deviceInfo->VendorId;
+    device->ProductId = deviceInfo->ProductId;
+    device->DeviceVersion = deviceInfo->DeviceVersion;
+    device->ManufacturerIndex = TinyCLR_UsbMsc_AddString(state, strings, USB_MSC_STRING_MANUFACTURER, deviceInfo->Manufacturer);
+    device->ProductIndex = TinyCLR_UsbMsc_AddString(state, strings, USB_MSC_STRING_PRODUCT, deviceInfo->Product);
+    device->SerialNumberIndex = TinyCLR_UsbMsc_AddString(state, strings, USB_MSC_STRING_SERIAL, deviceInfo->SerialNumber);
+    device->ConfigurationCount = 1;
+    device->Configurations = configuration;
+    device->StringCount = strings;
+    device->Strings = state->stringDescriptors;
+}
+
+TinyCLR_Result TinyCLR_UsbMsc_Acquire(const TinyCLR_UsbClient_Controller* self, const TinyCLR_Storage_Controller* storage, const TinyCLR_UsbMsc_DeviceInfo* deviceInfo) {
+    auto state = &usbMscState;
+
+    if (storage == nullptr || deviceInfo == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (state->controller != nullptr)
+        return TinyCLR_Result::SharingViolation;
+
+    auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
+
+    state->buffer = reinterpret_cast<uint8_t*>(memoryManager->Allocate(memoryManager, USB_MSC_BUFFER_SIZE));
+
+    if (state->buffer == nullptr)
+        return TinyCLR_Result::OutOfMemory;
+
+    TinyCLR_UsbMsc_BuildDescriptors(state, deviceInfo);
+
+    auto result = TinyCLR_UsbClient_SetDeviceDescriptor(self, &state->deviceDescriptor);
+
+    if (result == TinyCLR_Result::Success)
+        result = TinyCLR_UsbClient_Acquire(self);
+
+    if (result != TinyCLR_Result::Success) {
+        memoryManager->Free(memoryManager, state->buffer);
+
+        state->buffer = nullptr;
+
+        return result;
+    }
+
+    auto usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    if (USB_MSC_DATA_IN_ENDPOINT >= usbClientState->totalEndpointsCount || USB_MSC_DATA_OUT_ENDPOINT >= usbClientState->totalEndpointsCount)
+        result = TinyCLR_Result::NotSupported;
+
+    if (result == TinyCLR_Result::Success) {
+        usbClientState->queueSize[USB_MSC_DATA_IN_ENDPOINT] = USB_MSC_WRITE_BUFFER_SIZE;
+        usbClientState->queueSize[USB_MSC_DATA_OUT_ENDPOINT] = USB_MSC_READ_BUFFER_SIZE;
+
+        if (TinyCLR_UsbClient_AllocatePipe(usbClientState, USB_MSC_DATA_IN_ENDPOINT, USB_MSC_DATA_OUT_ENDPOINT, state->pipe) != TinyCLR_Result::Success
+            || usbClientState->queues[USB_MSC_DATA_IN_ENDPOINT] == nullptr
+            || usbClientState->queues[USB_MSC_DATA_OUT_ENDPOINT] == nullptr) {
+
+            for (uint32_t pipe = 0; pipe < usbClientState->totalPipesCount; pipe++)
+                if (usbClientState->pipes[pipe].RxEP != USB_ENDPOINT_NULL || usbClientState->pipes[pipe].TxEP != USB_ENDPOINT_NULL)
+                    TinyCLR_UsbClient_ClosePipe(self, pipe);
+
+            result = TinyCLR_Result::OutOfMemory;
+        }
+    }
+
+    if (result != TinyCLR_Result::Success) {
+        TinyCLR_UsbClient_Release(self);
+
+        memoryManager->Free(memoryManager, state->buffer);
+
+        state->buffer = nullptr;
+
+        return result;
+    }
+
+    // Process never waits on the host, it goes on with whatever fit in the ring the next time
+    TinyCLR_UsbClient_SetWriteTimeout(self, state->pipe, USB_WRITE_TIMEOUT_NONE);
+
+    TinyCLR_UsbMsc_ScsiInitialize(&state->scsi, storage);
+    TinyCLR_UsbMsc_ScsiSetInquiry(&state->scsi, deviceInfo->Manufacturer, deviceInfo->Product, deviceInfo->DeviceVersion);
+
+    state->stage = USB_MSC_STAGE_COMMAND;
+    state->commandBlockCount = 0;
+    state->reset = false;
+    state->maxLun = 0;
+    state->controller = self;
+
+    usbClientState->classRequestHandler = &TinyCLR_UsbMsc_ProcessClassRequest;
+
+    if (usbClientState->currentState == USB_DEVICE_STATE_UNINITIALIZED)
+        TinyCLR_UsbClient_Initialize(usbClientState);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result TinyCLR_UsbMsc_Release(const TinyCLR_UsbClient_Controller* self) {
+    auto state = &usbMscState;
+
+    if (state->controller != self)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+    auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
+
+    usbClientState->classRequestHandler = nullptr;
+
+    TinyCLR_UsbClient_ClosePipe(self, state->pipe);
+
+    memoryManager->Free(memoryManager, state->buffer);
+
+    state->buffer = nullptr;
+    state->controller = nullptr;
+
+    return TinyCLR_UsbClient_Release(self);
+}
+
+TinyCLR_Result TinyCLR_UsbMsc_MediumChanged(const TinyCLR_UsbClient_Controller* self) {
+    auto state = &usbMscState;
+
+    if (state->controller != self)
+        return TinyCLR_Result::InvalidOperation;
+
+    // picked up by the next command, so it never changes the geometry under a transfer
+    state->scsi.mediumChanged = true;
+    state->scsi.present = false;
+
+    return TinyCLR_Result::Success;
+}
+
+static void TinyCLR_UsbMsc_StartStatus(UsbMscState* state) {
+    auto csw = state->statusBlock;
+    auto residue = state->hostLength - state->dataLength;
+
+    csw[0] = static_cast<uint8_t>(USB_MSC_CSW_SIGNATURE);
+    csw[1] = static_cast<uint8_t>(USB_MSC_CSW_SIGNATURE >> 8);
+    csw[2] = static_cast<uint8_t>(USB_MSC_CSW_SIGNATURE >> 16);
+    csw[3] = static_cast<uint8_t>(USB_MSC_CSW_SIGNATURE >> 24);
+    csw[4] = static_cast<uint8_t>(state->tag);
+    csw[5] = static_cast<uint8_t>(state->tag >> 8);
+    csw[6] = static_cast<uint8_t>(state->tag >> 16);
+    csw[7] = static_cast<uint8_t>(state->tag >> 24);
+    csw[8] = static_cast<uint8_t>(residue);
+    csw[9] = static_cast<uint8_t>(residue >> 8);
+    csw[10] = static_cast<uint8_t>(residue >> 16);
+    csw[11] = static_cast<uint8_t>(residue >> 24);
+    csw[12] = state->status;
+
+    state->statusBlockCount = 0;
+    state->stage = USB_MSC_STAGE_STATUS;
+}
+
+static void TinyCLR_UsbMsc_StartCommand(UsbMscState* state) {
+    auto cbw = state->commandBlock;
+
+    state->commandBlockCount = 0;
+
+    auto signature = cbw[0] | (cbw[1] << 8) | (cbw[2] << 16) | (static_cast<uint32_t>(cbw[3]) << 24);
+    auto lun = cbw[13] & 0x0F;
+    auto commandLength = cbw[14] & 0x1F;
+
+    // Without a way to stall the bulk endpoints a command block that is not meaningful is dropped. The host
+    // times out on it and does a reset recovery, which starts over from a clean pipe.
+    if (signature != USB_MSC_CBW_SIGNATURE || lun > state->maxLun || commandLength == 0 || commandLength > 16)
+        return;
+
+    state->tag = cbw[4] | (cbw[5] << 8) | (cbw[6] << 16) | (static_cast<uint32_t>(cbw[7]) << 24);
+    state->hostLength = cbw[8] | (cbw[9] << 8) | (cbw[10] << 16) | (static_cast<uint32_t>(cbw[11]) << 24);
+    state->transferred = 0;
+    state->bufferOffset = 0;
+    state->bufferCount = 0;
+
+    auto hostDirection = state->hostLength == 0 ? USB_MSC_DIRECTION_NONE : ((cbw[12] & USB_MSC_CBW_FLAG_IN) ? USB_MSC_DIRECTION_IN : USB_MSC_DIRECTION_OUT);
+
+    state->status = TinyCLR_UsbMsc_ScsiCommand(&state->scsi, &cbw[15], commandLength, state->buffer, USB_MSC_BUFFER_SIZE);
+    state->dataLength = state->scsi.length;
+
+    // The thirteen cases of the transport: when the device wants to move more than the host expects, or in the
+    // other direction, no data is moved and the host gets a phase error once it moved its own length. When it
+    // wants less, the rest of an IN transfer is padded and the rest of an OUT transfer is thrown away.
+    if (state->scsi.direction != USB_MSC_DIRECTION_NONE && (state->scsi.direction != hostDirection || state->dataLength > state->hostLength)) {
+        state->status = USB_MSC_CSW_STATUS_PHASE;
+        state->dataLength = 0;
+    }
+
+    if (hostDirection == USB_MSC_DIRECTION_IN)
+        state->stage = USB_MSC_STAGE_DATA_IN;
+    else if (hostDirection == USB_MSC_DIRECTION_OUT)
+        state->stage = USB_MSC_STAGE_DATA_OUT;
+    else
+        TinyCLR_UsbMsc_StartStatus(state);
+}
+
+// Size of the next buffer of the data stage, whole blocks while block data is moved.
+static uint32_t TinyCLR_UsbMsc_NextChunk(UsbMscState* state) {
+    auto remaining = state->hostLength - state->transferred;
+    auto chunk = static_cast<uint32_t>(USB_MSC_BUFFER_SIZE);
+
+    if (state->scsi.blockTransfer && state->transferred < state->dataLength)
+        chunk -= chunk % state->scsi.blockSize;
+
+    return remaining < chunk ? remaining : chunk;
+}
+
+static void TinyCLR_UsbMsc_FillBuffer(UsbMscState* state) {
+    auto chunk = TinyCLR_UsbMsc_NextChunk(state);
+    uint32_t data = 0;
+
+    if (state->transferred < state->dataLength) {
+        data = __min(chunk, state->dataLength - state->transferred);
+
+        // responses of the other commands are in the buffer already
+        if (state->scsi.blockTransfer && !TinyCLR_UsbMsc_ScsiRead(&state->scsi, state->buffer, data)) {
+            state->status = USB_MSC_CSW_STATUS_FAILED;
+            state->dataLength = state->transferred;
+
+            data = 0;
+        }
+    }
+
+    memset(state->buffer + data, 0, chunk - data);
+
+    state->bufferOffset = 0;
+    state->bufferCount = chunk;
+    state->transferred += chunk;
+}
+
+static void TinyCLR_UsbMsc_DrainBuffer(UsbMscState* state) {
+    auto chunk = state->bufferCount;
+
+    if (state->transferred < state->dataLength) {
+        auto data = __min(chunk, state->dataLength - state->transferred);
+
+        if (!TinyCLR_UsbMsc_ScsiWrite(&state->scsi, state->buffer, data)) {
+            state->status = USB_MSC_CSW_STATUS_FAILED;
+            state->dataLength = state->transferred;
+        }
+    }
+
+    state->bufferOffset = 0;
+    state->bufferCount = 0;
+    state->transferred += chunk;
+}
+
+// The data stage and the status block are written to one transfer that is left open, so only full packets go out
+// until it is ended. The transfer is ended after the data when that leaves a short packet, which must not run into
+// the status block, and after the status block. A data stage of full packets needs no zero length packet: the
+// host knows its length.
+TinyCLR_Result TinyCLR_UsbMsc_Process(const TinyCLR_UsbClient_Controller* self) {
+    auto state = &usbMscState;
+
+    if (state->controller != self)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    if (usbClientState->deviceState != USB_DEVICE_STATE_CONFIGURED) {
+        state->stage = USB_MSC_STAGE_COMMAND;
+        state->commandBlockCount = 0;
+
+        return TinyCLR_Result::Success;
+    }
+
+    auto maxPacketSize = usbClientState->maxEndpointsPacketSize[USB_MSC_DATA_IN_ENDPOINT];
+
+    while (true) {
+        size_t length;
+
+        // the rings were cleared with the reset, whatever the command was doing is gone
+        if (state->reset) {
+            state->reset = false;
+            state->stage = USB_MSC_STAGE_COMMAND;
+            state->commandBlockCount = 0;
+        }
+
+        switch (state->stage) {
+        case USB_MSC_STAGE_COMMAND:
+            length = USB_MSC_CBW_SIZE - state->commandBlockCount;
+
+            if (TinyCLR_UsbClient_ReadPipe(self, state->pipe, &state->commandBlock[state->commandBlockCount], length) != TinyCLR_Result::Success || length == 0)
+                return TinyCLR_Result::Success;
+
+            state->commandBlockCount += length;
+
+            if (state->commandBlockCount == USB_MSC_CBW_SIZE)
+                TinyCLR_UsbMsc_StartCommand(state);
+
+            break;
+
+        case USB_MSC_STAGE_DATA_IN:
+            if (state->bufferOffset == state->bufferCount) {
+                if (state->transferred == state->hostLength) {
+                    if (state->hostLength % maxPacketSize != 0) {
+                        length = 0;
+
+                        TinyCLR_UsbClient_WriteTransfer(self, state->pipe, nullptr, length, true);
+                    }
+
+                    TinyCLR_UsbMsc_StartStatus(state);
+
+                    break;
+                }
+
+                TinyCLR_UsbMsc_FillBuffer(state);
+            }
+
+            length = state->bufferCount - state->bufferOffset;
+
+            if (TinyCLR_UsbClient_WriteTransfer(self, state->pipe, state->buffer + state->bufferOffset, length, false) != TinyCLR_Result::Success || length == 0)
+                return TinyCLR_Result::Success;
+
+            state->bufferOffset += length;
+
+            break;
+
+        case USB_MSC_STAGE_DATA_OUT:
+            if (state->transferred == state->hostLength) {
+                TinyCLR_UsbMsc_StartStatus(state);
+
+                break;
+            }
+
+            if (state->bufferCount == 0)
+                state->bufferCount = TinyCLR_UsbMsc_NextChunk(state);
+
+            length = state->bufferCount - state->bufferOffset;
+
+            if (TinyCLR_UsbClient_ReadPipe(self, state->pipe, state->buffer + state->bufferOffset, length) != TinyCLR_Result::Success || length == 0)
+                return TinyCLR_Result::Success;
+
+            state->bufferOffset += length;
+
+            if (state->bufferOffset == state->bufferCount)
+                TinyCLR_UsbMsc_DrainBuffer(state);
+
+            break;
+
+        case USB_MSC_STAGE_STATUS:
+            length = USB_MSC_CSW_SIZE - state->statusBlockCount;
+
+            if (TinyCLR_UsbClient_WriteTransfer(self, state->pipe, &state->statusBlock[state->statusBlockCount], length, false) != TinyCLR_Result::Success || length == 0)
+                return TinyCLR_Result::Success;
+
+            state->statusBlockCount += length;
+
+            if (state->statusBlockCount == USB_MSC_CSW_SIZE) {
+                length = 0;
+
+                TinyCLR_UsbClient_WriteTransfer(self, state->pipe, nullptr, length, true);
+
+                state->stage = USB_MSC_STAGE_COMMAND;
+            }
+
+            break;
+        }
+    }
+}
+
+// Runs from the USB interrupt, only the two bulk only transport requests to the storage interface are taken.
+bool TinyCLR_UsbMsc_ProcessClassRequest(UsbClientState* usbClientState, const TinyCLR_UsbClient_SetupPacket* setup, const uint8_t* data, const uint8_t*& responsePayload, size_t& responsePayloadLength) {
+    auto state = &usbMscState;
+
+    if ((setup->RequestType & (USB_REQUEST_TYPE_CLASS | USB_REQUEST_TYPE_VENDOR)) != USB_REQUEST_TYPE_CLASS
+        || USB_SETUP_RECIPIENT(setup->RequestType) != USB_SETUP_RECIPIENT_INTERFACE
+        || (setup->Index & 0xFF) != USB_MSC_INTERFACE)
+        return false;
+
+    switch (setup->Request) {
+    case USB_MSC_GET_MAX_LUN:
+        responsePayload = &state->maxLun;
+        responsePayloadLength = 1;
+
+        return true;
+
+    case USB_MSC_BULK_ONLY_RESET:
+        TinyCLR_UsbClient_ClearEndpoints(usbClientState, USB_MSC_DATA_IN_ENDPOINT);
+        TinyCLR_UsbClient_ClearEndpoints(usbClientState, USB_MSC_DATA_OUT_ENDPOINT);
+        TinyCLR_UsbClient_RxEnable(usbClientState, USB_MSC_DATA_OUT_ENDPOINT);
+
+        state->reset = true;
+
+        return true;
+
+    default:
+        return false;
+    }
+}
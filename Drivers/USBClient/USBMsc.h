@@ -0,0 +1,170 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "USBClient.h"
+
+// Mass storage class codes
+#define USB_MSC_INTERFACE_CLASS      0x08
+#define USB_MSC_SCSI_TRANSPARENT     0x06
+#define USB_MSC_BULK_ONLY_TRANSPORT  0x50
+
+// Bulk only transport class requests
+#define USB_MSC_GET_MAX_LUN          0xFE
+#define USB_MSC_BULK_ONLY_RESET      0xFF
+
+// Command and status wrappers
+#define USB_MSC_CBW_SIGNATURE        0x43425355
+#define USB_MSC_CSW_SIGNATURE        0x53425355
+#define USB_MSC_CBW_SIZE             31
+#define USB_MSC_CSW_SIZE             13
+#define USB_MSC_CBW_FLAG_IN          0x80
+
+#define USB_MSC_CSW_STATUS_PASSED    0x00
+#define USB_MSC_CSW_STATUS_FAILED    0x01
+#define USB_MSC_CSW_STATUS_PHASE     0x02
+
+// SCSI commands
+#define USB_MSC_SCSI_TEST_UNIT_READY                 0x00
+#define USB_MSC_SCSI_REQUEST_SENSE                   0x03
+#define USB_MSC_SCSI_INQUIRY                         0x12
+#define USB_MSC_SCSI_MODE_SELECT_6                   0x15
+#define USB_MSC_SCSI_MODE_SENSE_6                    0x1A
+#define USB_MSC_SCSI_START_STOP_UNIT                 0x1B
+#define USB_MSC_SCSI_PREVENT_ALLOW_MEDIUM_REMOVAL    0x1E
+#define USB_MSC_SCSI_READ_FORMAT_CAPACITIES          0x23
+#define USB_MSC_SCSI_READ_CAPACITY_10                0x25
+#define USB_MSC_SCSI_READ_10                         0x28
+#define USB_MSC_SCSI_WRITE_10                        0x2A
+#define USB_MSC_SCSI_VERIFY_10                       0x2F
+#define USB_MSC_SCSI_SYNCHRONIZE_CACHE_10            0x35
+#define USB_MSC_SCSI_MODE_SENSE_10                   0x5A
+
+// Sense keys and additional sense codes
+#define USB_MSC_SENSE_NONE                   0x00
+#define USB_MSC_SENSE_NOT_READY              0x02
+#define USB_MSC_SENSE_MEDIUM_ERROR           0x03
+#define USB_MSC_SENSE_ILLEGAL_REQUEST        0x05
+#define USB_MSC_SENSE_UNIT_ATTENTION         0x06
+#define USB_MSC_SENSE_DATA_PROTECT           0x07
+
+#define USB_MSC_ASC_WRITE_FAULT              0x03
+#define USB_MSC_ASC_UNRECOVERED_READ_ERROR   0x11
+#define USB_MSC_ASC_INVALID_COMMAND          0x20
+#define USB_MSC_ASC_LBA_OUT_OF_RANGE         0x21
+#define USB_MSC_ASC_INVALID_FIELD_IN_CDB     0x24
+#define USB_MSC_ASC_WRITE_PROTECTED          0x27
+#define USB_MSC_ASC_MEDIUM_CHANGED           0x28
+#define USB_MSC_ASC_MEDIUM_NOT_PRESENT       0x3A
+
+// Data stage direction of a command, seen from the host
+#define USB_MSC_DIRECTION_NONE 0
+#define USB_MSC_DIRECTION_IN   1
+#define USB_MSC_DIRECTION_OUT  2
+
+// Endpoints of the function, a board overrides them in Device.h when the controller fixes endpoint types by number
+#ifndef USB_MSC_DATA_IN_ENDPOINT
+#define USB_MSC_DATA_IN_ENDPOINT 1
+#endif
+
+#ifndef USB_MSC_DATA_OUT_ENDPOINT
+#define USB_MSC_DATA_OUT_ENDPOINT 2
+#endif
+
+// Blocks move between the storage and the pipes through this buffer, one storage call per buffer, so a bigger buffer
+// lets a multi-block capable storage driver move more sectors per command. It must hold at least one block.
+#ifndef USB_MSC_BUFFER_SIZE
+#define USB_MSC_BUFFER_SIZE 4096
+#endif
+
+// Ring sizes of the bulk pipe in bytes, a write ring of two buffers keeps the host busy while the next buffer is read
+#ifndef USB_MSC_WRITE_BUFFER_SIZE
+#define USB_MSC_WRITE_BUFFER_SIZE (2 * USB_MSC_BUFFER_SIZE)
+#endif
+
+#ifndef USB_MSC_READ_BUFFER_SIZE
+#define USB_MSC_READ_BUFFER_SIZE USB_MSC_BUFFER_SIZE
+#endif
+
+#ifndef USB_MSC_STORAGE_TIMEOUT
+#define USB_MSC_STORAGE_TIMEOUT (5 * 1000 * 10000) // ticks
+#endif
+
+// Storage without equal sized regions is exposed in blocks of this size
+#define USB_MSC_DEFAULT_BLOCK_SIZE 512
+
+#define USB_MSC_INQUIRY_VENDOR_SIZE   8
+#define USB_MSC_INQUIRY_PRODUCT_SIZE  16
+#define USB_MSC_INQUIRY_REVISION_SIZE 4
+
+// Strings are optional and must stay valid until the function is released.
+struct TinyCLR_UsbMsc_DeviceInfo {
+    uint16_t VendorId;
+    uint16_t ProductId;
+    uint16_t DeviceVersion;
+    const wchar_t* Manufacturer;
+    const wchar_t* Product;
+    const wchar_t* SerialNumber;
+};
+
+// SCSI block device on top of a storage controller. It knows nothing about USB, so it runs against any
+// TinyCLR_Storage_Controller, a RAM disk included.
+struct UsbMscScsiState {
+    const TinyCLR_Storage_Controller* storage;
+
+    uint64_t baseAddress;
+    uint32_t blockSize;
+    uint32_t blockCount;
+
+    bool present;
+    bool writeProtected;
+    bool removable;
+    bool mediumChanged;
+    bool preventRemoval;
+
+    uint8_t senseKey;
+    uint8_t additionalSenseCode;
+    uint8_t additionalSenseCodeQualifier;
+
+    char vendor[USB_MSC_INQUIRY_VENDOR_SIZE];
+    char product[USB_MSC_INQUIRY_PRODUCT_SIZE];
+    char revision[USB_MSC_INQUIRY_REVISION_SIZE];
+
+    // data stage of the current command, block commands move their blocks with ScsiRead and ScsiWrite
+    uint8_t direction;
+    bool blockTransfer;
+    uint64_t address;
+    uint32_t length;
+};
+
+// The function takes the whole controller: it sets the device descriptor, acquires the controller and opens its pipe.
+// The storage controller must be acquired and opened by the caller.
+TinyCLR_Result TinyCLR_UsbMsc_Acquire(const TinyCLR_UsbClient_Controller* self, const TinyCLR_Storage_Controller* storage, const TinyCLR_UsbMsc_DeviceInfo* deviceInfo);
+TinyCLR_Result TinyCLR_UsbMsc_Release(const TinyCLR_UsbClient_Controller* self);
+
+// Moves commands and blocks between the pipe and the storage without waiting on the host. Storage calls can take
+// milliseconds, so this runs from a thread or task and not from the USB interrupt.
+TinyCLR_Result TinyCLR_UsbMsc_Process(const TinyCLR_UsbClient_Controller* self);
+
+// Tells the host the medium changed, for storage that was swapped or written to locally.
+TinyCLR_Result TinyCLR_UsbMsc_MediumChanged(const TinyCLR_UsbClient_Controller* self);
+
+bool TinyCLR_UsbMsc_ProcessClassRequest(UsbClientState* usbClientState, const TinyCLR_UsbClient_SetupPacket* setup, const uint8_t* data, const uint8_t*& responsePayload, size_t& responsePayloadLength);
+
+void TinyCLR_UsbMsc_ScsiInitialize(UsbMscScsiState* scsi, const TinyCLR_Storage_Controller* storage);
+void TinyCLR_UsbMsc_ScsiSetInquiry(UsbMscScsiState* scsi, const wchar_t* vendor, const wchar_t* product, uint16_t revision);
+uint8_t TinyCLR_UsbMsc_ScsiCommand(UsbMscScsiState* scsi, const uint8_t* command, size_t commandLength, uint8_t* data, size_t dataSize);
+bool TinyCLR_UsbMsc_ScsiRead(UsbMscScsiState* scsi, uint8_t* data, size_t length);
+bool TinyCLR_UsbMsc_ScsiWrite(UsbMscScsiState* scsi, const uint8_t* data, size_t length);
@@ -0,0 +1,335 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include "USBMsc.h"
+
+#define USB_MSC_INQUIRY_SIZE             36
+#define USB_MSC_REQUEST_SENSE_SIZE       18
+#define USB_MSC_MODE_SENSE_6_SIZE        4
+#define USB_MSC_MODE_SENSE_10_SIZE       8
+#define USB_MSC_READ_CAPACITY_SIZE       8
+#define USB_MSC_FORMAT_CAPACITIES_SIZE   12
+
+#define USB_MSC_MODE_WRITE_PROTECT       0x80
+
+static uint32_t TinyCLR_UsbMsc_GetBigEndian32(const uint8_t* data) {
+    return (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+static uint16_t TinyCLR_UsbMsc_GetBigEndian16(const uint8_t* data) {
+    return (data[0] << 8) | data[1];
+}
+
+static void TinyCLR_UsbMsc_SetBigEndian32(uint8_t* data, uint32_t value) {
+    data[0] = value >> 24;
+    data[1] = value >> 16;
+    data[2] = value >> 8;
+    data[3] = value;
+}
+
+static void TinyCLR_UsbMsc_SetInquiryString(char* destination, size_t size, const wchar_t* source, const char* defaultValue) {
+    size_t i = 0;
+
+    if (source != nullptr) {
+        for (; i < size && source[i] != 0; i++)
+            destination[i] = (source[i] >= 0x20 && source[i] < 0x7F) ? static_cast<char>(source[i]) : '?';
+    }
+    else {
+        for (; i < size && defaultValue[i] != 0; i++)
+            destination[i] = defaultValue[i];
+    }
+
+    // fields are padded with spaces, not terminated
+    for (; i < size; i++)
+        destination[i] = ' ';
+}
+
+// Reads the geometry of the storage. Equal sized regions are the blocks, storage with regions of different sizes and
+// regions too big for the buffer is cut into default sized blocks. Storage that has to be erased before it is written
+// to is exposed read only, a block write there would take an erase of the whole region around it.
+static void TinyCLR_UsbMsc_ScsiLoadDescriptor(UsbMscScsiState* scsi) {
+    const TinyCLR_Storage_Descriptor* descriptor = nullptr;
+
+    scsi->present = false;
+    scsi->blockCount = 0;
+
+    if (scsi->storage->GetDescriptor(scsi->storage, descriptor) != TinyCLR_Result::Success || descriptor == nullptr || descriptor->RegionCount == 0 || descriptor->RegionSizes == nullptr)
+        return;
+
+    uint64_t size = 0;
+    uint32_t blockSize = USB_MSC_DEFAULT_BLOCK_SIZE;
+
+    if (descriptor->RegionsEqualSized) {
+        size = static_cast<uint64_t>(descriptor->RegionCount) * descriptor->RegionSizes[0];
+
+        if (descriptor->RegionSizes[0] > 0 && descriptor->RegionSizes[0] <= USB_MSC_BUFFER_SIZE)
+            blockSize = descriptor->RegionSizes[0];
+    }
+    else {
+        // only the regions following each other without a gap make up the disk
+        for (size_t i = 0; i < descriptor->RegionCount; i++) {
+            if (i > 0 && !descriptor->RegionsContiguous && descriptor->RegionAddresses != nullptr
+                && descriptor->RegionAddresses[i] != descriptor->RegionAddresses[0] + size)
+                break;
+
+            size += descriptor->RegionSizes[i];
+        }
+    }
+
+    auto blockCount = size / blockSize;
+
+    scsi->baseAddress = descriptor->RegionAddresses != nullptr ? descriptor->RegionAddresses[0] : 0;
+    scsi->blockSize = blockSize;
+    scsi->blockCount = blockCount > 0xFFFFFFFF ? 0xFFFFFFFF : static_cast<uint32_t>(blockCount);
+    scsi->writeProtected = descriptor->EraseBeforeWrite;
+    scsi->removable = descriptor->Removable;
+    scsi->present = scsi->blockCount > 0;
+}
+
+static uint8_t TinyCLR_UsbMsc_ScsiFail(UsbMscScsiState* scsi, uint8_t senseKey, uint8_t additionalSenseCode) {
+    scsi->senseKey = senseKey;
+    scsi->additionalSenseCode = additionalSenseCode;
+    scsi->additionalSenseCodeQualifier = 0;
+
+    scsi->direction = USB_MSC_DIRECTION_NONE;
+    scsi->blockTransfer = false;
+    scsi->length = 0;
+
+    return USB_MSC_CSW_STATUS_FAILED;
+}
+
+static uint8_t TinyCLR_UsbMsc_ScsiRespond(UsbMscScsiState* scsi, uint32_t length, uint32_t allocationLength) {
+    scsi->direction = USB_MSC_DIRECTION_IN;
+    scsi->length = length < allocationLength ? length : allocationLength;
+
+    if (scsi->length == 0)
+        scsi->direction = USB_MSC_DIRECTION_NONE;
+
+    return USB_MSC_CSW_STATUS_PASSED;
+}
+
+void TinyCLR_UsbMsc_ScsiInitialize(UsbMscScsiState* scsi, const TinyCLR_Storage_Controller* storage) {
+    memset(scsi, 0, sizeof(UsbMscScsiState));
+
+    scsi->storage = storage;
+
+    TinyCLR_UsbMsc_ScsiSetInquiry(scsi, nullptr, nullptr, 0x0100);
+    TinyCLR_UsbMsc_ScsiLoadDescriptor(scsi);
+}
+
+void TinyCLR_UsbMsc_ScsiSetInquiry(UsbMscScsiState* scsi, const wchar_t* vendor, const wchar_t* product, uint16_t revision) {
+    static const char hex[] = "0123456789ABCDEF";
+
+    TinyCLR_UsbMsc_SetInquiryString(scsi->vendor, USB_MSC_INQUIRY_VENDOR_SIZE, vendor, "TinyCLR");
+    TinyCLR_UsbMsc_SetInquiryString(scsi->product, USB_MSC_INQUIRY_PRODUCT_SIZE, product, "Mass Storage");
+
+    for (auto i = 0; i < USB_MSC_INQUIRY_REVISION_SIZE; i++)
+        scsi->revision[i] = hex[(revision >> (12 - i * 4)) & 0x0F];
+}
+
+// Decodes a command block. Responses of commands that are not block transfers are written to data, block transfers
+// only record the range, the caller moves it through ScsiRead and ScsiWrite. Returns the status for the host.
+uint8_t TinyCLR_UsbMsc_ScsiCommand(UsbMscScsiState* scsi, const uint8_t* command, size_t commandLength, uint8_t* data, size_t dataSize) {
+    scsi->direction = USB_MSC_DIRECTION_NONE;
+    scsi->blockTransfer = false;
+    scsi->length = 0;
+
+    if (commandLength < 6 || dataSize < USB_MSC_INQUIRY_SIZE)
+        return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_ILLEGAL_REQUEST, USB_MSC_ASC_INVALID_COMMAND);
+
+    auto opcode = command[0];
+
+    // a changed medium is reported once to the first command that is about the medium
+    if (scsi->mediumChanged && opcode != USB_MSC_SCSI_INQUIRY && opcode != USB_MSC_SCSI_REQUEST_SENSE) {
+        scsi->mediumChanged = false;
+
+        return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_UNIT_ATTENTION, USB_MSC_ASC_MEDIUM_CHANGED);
+    }
+
+    switch (opcode) {
+    case USB_MSC_SCSI_INQUIRY:
+        if (command[1] & 0x01) // vital product data pages
+            return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_ILLEGAL_REQUEST, USB_MSC_ASC_INVALID_FIELD_IN_CDB);
+
+        memset(data, 0, USB_MSC_INQUIRY_SIZE);
+
+        data[0] = 0x00; // direct access block device
+        data[1] = scsi->removable ? 0x80 : 0x00;
+        data[2] = 0x04; // SPC-2
+        data[3] = 0x02;
+        data[4] = USB_MSC_INQUIRY_SIZE - 5;
+
+        memcpy(&data[8], scsi->vendor, USB_MSC_INQUIRY_VENDOR_SIZE);
+        memcpy(&data[16], scsi->product, USB_MSC_INQUIRY_PRODUCT_SIZE);
+        memcpy(&data[32], scsi->revision, USB_MSC_INQUIRY_REVISION_SIZE);
+
+        return TinyCLR_UsbMsc_ScsiRespond(scsi, USB_MSC_INQUIRY_SIZE, TinyCLR_UsbMsc_GetBigEndian16(&command[3]));
+
+    case USB_MSC_SCSI_REQUEST_SENSE:
+        memset(data, 0, USB_MSC_REQUEST_SENSE_SIZE);
+
+        data[0] = 0x70; // current error, fixed format
+        data[2] = scsi->senseKey;
+        data[7] = USB_MSC_REQUEST_SENSE_SIZE - 8;
+        data[12] = scsi->additionalSenseCode;
+        data[13] = scsi->additionalSenseCodeQualifier;
+
+        scsi->senseKey = USB_MSC_SENSE_NONE;
+        scsi->additionalSenseCode = 0;
+        scsi->additionalSenseCodeQualifier = 0;
+
+        return TinyCLR_UsbMsc_ScsiRespond(scsi, USB_MSC_REQUEST_SENSE_SIZE, command[4]);
+
+    case USB_MSC_SCSI_TEST_UNIT_READY:
+        // the host polls with this, it is when a card inserted after the function started shows up
+        if (!scsi->present)
+            TinyCLR_UsbMsc_ScsiLoadDescriptor(scsi);
+
+        if (!scsi->present)
+            return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_NOT_READY, USB_MSC_ASC_MEDIUM_NOT_PRESENT);
+
+        return USB_MSC_CSW_STATUS_PASSED;
+
+    case USB_MSC_SCSI_START_STOP_UNIT:
+    case USB_MSC_SCSI_SYNCHRONIZE_CACHE_10:
+        // blocks go to the storage before the command completes, there is nothing to flush
+        return USB_MSC_CSW_STATUS_PASSED;
+
+    case USB_MSC_SCSI_PREVENT_ALLOW_MEDIUM_REMOVAL:
+        scsi->preventRemoval = (command[4] & 0x01) != 0;
+
+        return USB_MSC_CSW_STATUS_PASSED;
+
+    case USB_MSC_SCSI_MODE_SENSE_6:
+        memset(data, 0, USB_MSC_MODE_SENSE_6_SIZE);
+
+        data[0] = USB_MSC_MODE_SENSE_6_SIZE - 1;
+        data[2] = scsi->writeProtected ? USB_MSC_MODE_WRITE_PROTECT : 0x00;
+
+        return TinyCLR_UsbMsc_ScsiRespond(scsi, USB_MSC_MODE_SENSE_6_SIZE, command[4]);
+
+    case USB_MSC_SCSI_MODE_SENSE_10:
+        if (commandLength < 10)
+            return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_ILLEGAL_REQUEST, USB_MSC_ASC_INVALID_FIELD_IN_CDB);
+
+        memset(data, 0, USB_MSC_MODE_SENSE_10_SIZE);
+
+        data[1] = USB_MSC_MODE_SENSE_10_SIZE - 2;
+        data[3] = scsi->writeProtected ? USB_MSC_MODE_WRITE_PROTECT : 0x00;
+
+        return TinyCLR_UsbMsc_ScsiRespond(scsi, USB_MSC_MODE_SENSE_10_SIZE, TinyCLR_UsbMsc_GetBigEndian16(&command[7]));
+
+    case USB_MSC_SCSI_READ_FORMAT_CAPACITIES:
+        if (commandLength < 10)
+            return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_ILLEGAL_REQUEST, USB_MSC_ASC_INVALID_FIELD_IN_CDB);
+
+        memset(data, 0, USB_MSC_FORMAT_CAPACITIES_SIZE);
+
+        data[3] = 8; // one capacity descriptor
+
+        TinyCLR_UsbMsc_SetBigEndian32(&data[4], scsi->blockCount);
+        TinyCLR_UsbMsc_SetBigEndian32(&data[8], scsi->blockSize);
+
+        data[8] = scsi->present ? 0x02 : 0x03; // formatted media, or no media present
+
+        return TinyCLR_UsbMsc_ScsiRespond(scsi, USB_MSC_FORMAT_CAPACITIES_SIZE, TinyCLR_UsbMsc_GetBigEndian16(&command[7]));
+
+    case USB_MSC_SCSI_READ_CAPACITY_10:
+        if (!scsi->present)
+            return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_NOT_READY, USB_MSC_ASC_MEDIUM_NOT_PRESENT);
+
+        TinyCLR_UsbMsc_SetBigEndian32(&data[0], scsi->blockCount - 1);
+        TinyCLR_UsbMsc_SetBigEndian32(&data[4], scsi->blockSize);
+
+        return TinyCLR_UsbMsc_ScsiRespond(scsi, USB_MSC_READ_CAPACITY_SIZE, USB_MSC_READ_CAPACITY_SIZE);
+
+    case USB_MSC_SCSI_READ_10:
+    case USB_MSC_SCSI_WRITE_10:
+    case USB_MSC_SCSI_VERIFY_10: {
+        if (commandLength < 10)
+            return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_ILLEGAL_REQUEST, USB_MSC_ASC_INVALID_FIELD_IN_CDB);
+
+        if (!scsi->present)
+            return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_NOT_READY, USB_MSC_ASC_MEDIUM_NOT_PRESENT);
+
+        auto block = TinyCLR_UsbMsc_GetBigEndian32(&command[2]);
+        auto blocks = TinyCLR_UsbMsc_GetBigEndian16(&command[7]);
+
+        if (block > scsi->blockCount || blocks > scsi->blockCount - block)
+            return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_ILLEGAL_REQUEST, USB_MSC_ASC_LBA_OUT_OF_RANGE);
+
+        if (opcode == USB_MSC_SCSI_VERIFY_10) {
+            // comparing against data from the host is not supported, checking the medium has nothing to do
+            if (command[1] & 0x02)
+                return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_ILLEGAL_REQUEST, USB_MSC_ASC_INVALID_FIELD_IN_CDB);
+
+            return USB_MSC_CSW_STATUS_PASSED;
+        }
+
+        if (opcode == USB_MSC_SCSI_WRITE_10 && scsi->writeProtected)
+            return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_DATA_PROTECT, USB_MSC_ASC_WRITE_PROTECTED);
+
+        scsi->address = scsi->baseAddress + static_cast<uint64_t>(block) * scsi->blockSize;
+        scsi->length = blocks * scsi->blockSize;
+        scsi->blockTransfer = true;
+
+        if (scsi->length > 0)
+            scsi->direction = opcode == USB_MSC_SCSI_READ_10 ? USB_MSC_DIRECTION_IN : USB_MSC_DIRECTION_OUT;
+
+        return USB_MSC_CSW_STATUS_PASSED;
+    }
+
+    default:
+        return TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_ILLEGAL_REQUEST, USB_MSC_ASC_INVALID_COMMAND);
+    }
+}
+
+// Reads the next length bytes of the block transfer in one storage call, length is a whole number of blocks.
+bool TinyCLR_UsbMsc_ScsiRead(UsbMscScsiState* scsi, uint8_t* data, size_t length) {
+    if (!scsi->blockTransfer || scsi->direction != USB_MSC_DIRECTION_IN || length > scsi->length)
+        return false;
+
+    auto count = length;
+
+    if (scsi->storage->Read(scsi->storage, scsi->address, count, data, USB_MSC_STORAGE_TIMEOUT) != TinyCLR_Result::Success || count != length) {
+        TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_MEDIUM_ERROR, USB_MSC_ASC_UNRECOVERED_READ_ERROR);
+
+        return false;
+    }
+
+    scsi->address += length;
+    scsi->length -= length;
+
+    return true;
+}
+
+// Writes the next length bytes of the block transfer in one storage call, length is a whole number of blocks.
+bool TinyCLR_UsbMsc_ScsiWrite(UsbMscScsiState* scsi, const uint8_t* data, size_t length) {
+    if (!scsi->blockTransfer || scsi->direction != USB_MSC_DIRECTION_OUT || length > scsi->length)
+        return false;
+
+    auto count = length;
+
+    if (scsi->storage->Write(scsi->storage, scsi->address, count, data, USB_MSC_STORAGE_TIMEOUT) != TinyCLR_Result::Success || count != length) {
+        TinyCLR_UsbMsc_ScsiFail(scsi, USB_MSC_SENSE_MEDIUM_ERROR, USB_MSC_ASC_WRITE_FAULT);
+
+        return false;
+    }
+
+    scsi->address += length;
+    scsi->length -= length;
+
+    return true;
+}
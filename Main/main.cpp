@@ -46,6 +46,10 @@ void OnSoftReset(const TinyCLR_Api_Manager* apiManager) {
     TARGET(_Gpio_AddApi)(apiManager);
 #endif
 
+#ifdef INCLUDE_ENCODER
+    TARGET(_Encoder_AddApi)(apiManager);
+#endif
+
 #ifdef INCLUDE_I2C
     TARGET(_I2c_AddApi)(apiManager);
 #endif
@@ -66,6 +70,10 @@ void OnSoftReset(const TinyCLR_Api_Manager* apiManager) {
     TARGET(_SdCard_AddApi)(apiManager);
 #endif
 
+#ifdef INCLUDE_SIGNALS
+    TARGET(_Signals_AddApi)(apiManager);
+#endif
+
 #ifdef INCLUDE_SPI
     TARGET(_Spi_AddApi)(apiManager);
 #endif
@@ -493,6 +493,8 @@ bool AT91SAM9Rx64_Gpio_IsDriveModeSupported(const TinyCLR_Gpio_Controller* self,
 TinyCLR_Gpio_PinDriveMode AT91SAM9Rx64_Gpio_GetDriveMode(const TinyCLR_Gpio_Controller* self, uint32_t pin);
 uint64_t AT91SAM9Rx64_Gpio_GetDebounceTimeout(const TinyCLR_Gpio_Controller* self, uint32_t pin);
 uint32_t AT91SAM9Rx64_Gpio_GetPinCount(const TinyCLR_Gpio_Controller* self);
+TinyCLR_Result AT91SAM9Rx64_Gpio_ReadPort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t& value);
+TinyCLR_Result AT91SAM9Rx64_Gpio_WritePort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t value);
 TinyCLR_Result AT91SAM9Rx64_Gpio_SetPinChangedHandler(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinChangeEdge edge, TinyCLR_Gpio_PinChangedHandler handler);
 TinyCLR_Result AT91SAM9Rx64_Gpio_ClosePin(const TinyCLR_Gpio_Controller* self, uint32_t pin);
 void AT91SAM9Rx64_GpioInternal_EnableOutputPin(int32_t pin, bool initialState);
@@ -548,10 +550,19 @@ struct PwmState {
     TinyCLR_Pwm_PulsePolarity invert[MAX_PWM_PER_CONTROLLER];
     bool                            isOpened[MAX_PWM_PER_CONTROLLER];
 
-    double                          frequency;
-    double                          dutyCycle[MAX_PWM_PER_CONTROLLER];
+    uint64_t                        frequency; // millihertz
+    uint32_t                        prescaler;
+    uint32_t                        period;
+    uint32_t                        dutyCycle[MAX_PWM_PER_CONTROLLER]; // parts per million
 
     uint16_t initializeCount;
+
+    bool                            burstActive;
+    bool                            burstLooped;
+    const uint32_t*                 burstPulses;
+    size_t                          burstSets;
+    size_t                          burstNext;
+    void(*burstCompleted)(const TinyCLR_Pwm_Controller* self, uint64_t timestamp);
 };
 void AT91SAM9Rx64_Pwm_AddApi(const TinyCLR_Api_Manager* apiManager);
 void AT91SAM9Rx64_Pwm_Reset();
@@ -566,6 +577,11 @@ TinyCLR_Result AT91SAM9Rx64_Pwm_CloseChannel(const TinyCLR_Pwm_Controller* self,
 TinyCLR_Result AT91SAM9Rx64_Pwm_EnableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel);
 TinyCLR_Result AT91SAM9Rx64_Pwm_DisableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel);
 TinyCLR_Result AT91SAM9Rx64_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* self, uint32_t channel, double dutyCycle, TinyCLR_Pwm_PulsePolarity polarity);
+TinyCLR_Result AT91SAM9Rx64_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Controller* self, const uint32_t* channels, const double* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count);
+TinyCLR_Result AT91SAM9Rx64_Pwm_EncodeBurst(const TinyCLR_Pwm_Controller* self, uint32_t channel, const double* dutyCycles, uint32_t* pulses, size_t count, size_t stride);
+TinyCLR_Result AT91SAM9Rx64_Pwm_StartBurst(const TinyCLR_Pwm_Controller* self, uint32_t firstChannel, uint32_t channelCount, const uint32_t* pulses, size_t sets, bool looped, void(*completed)(const TinyCLR_Pwm_Controller* self, uint64_t timestamp));
+bool AT91SAM9Rx64_Pwm_IsBurstActive(const TinyCLR_Pwm_Controller* self);
+TinyCLR_Result AT91SAM9Rx64_Pwm_StopBurst(const TinyCLR_Pwm_Controller* self);
 double AT91SAM9Rx64_Pwm_GetMinFrequency(const TinyCLR_Pwm_Controller* self);
 double AT91SAM9Rx64_Pwm_GetMaxFrequency(const TinyCLR_Pwm_Controller* self);
 double AT91SAM9Rx64_Pwm_GetActualFrequency(const TinyCLR_Pwm_Controller* self);
@@ -595,6 +611,11 @@ TinyCLR_Result AT91SAM9Rx64_SdCard_GetDescriptor(const TinyCLR_Storage_Controlle
 
 TinyCLR_Result AT91SAM9Rx64_SdCard_Reset();
 
+////////////////////////////////////////////////////////////////////////////////
+//Signals
+////////////////////////////////////////////////////////////////////////////////
+void AT91SAM9Rx64_Signals_AddApi(const TinyCLR_Api_Manager* apiManager);
+
 //SPI
 //////////////////////////////////////////////////////////////////////////////
 // AT91SAM9Rx64_SPI
@@ -1036,6 +1057,11 @@ public:
 #define DISABLE_INTERRUPTS_SCOPED(name) AT91SAM9Rx64_DisableInterrupts_RaiiHelper name
 #define INTERRUPT_STARTED_SCOPED(name) AT91SAM9Rx64_InterruptStarted_RaiiHelper name
 
+// Interrupt profiler: AIC sources, counts of the 16 bit system timer
+#define INTERRUPT_PROFILER_VECTORS 32
+#define INTERRUPT_PROFILER_COUNTS_PER_SECOND (AT91SAM9Rx64_SYSTEM_PERIPHERAL_CLOCK_HZ / 128)
+#define INTERRUPT_PROFILER_COUNTER_MASK 0xFFFF
+
 bool AT91SAM9Rx64_InterruptInternal_Activate(uint32_t index, uint32_t* isr, void* isrParam);
 bool AT91SAM9Rx64_InterruptInternal_Deactivate(uint32_t index);
 
@@ -1313,16 +1339,17 @@ void AT91SAM9Rx64_UsbDevice_AddApi(const TinyCLR_Api_Manager* apiManager);
 void AT91SAM9Rx64_UsbDevice_Reset();
 void AT91SAM9Rx64_UsbDevice_PinConfiguration();
 
-struct USB_PACKET64;
 struct UsbClientState;
 typedef void(*USB_NEXT_CALLBACK)(UsbClientState*);
 
 void TinyCLR_UsbClient_ClearEvent(UsbClientState *usbClientState, uint32_t event);
 void TinyCLR_UsbClient_ClearEndpoints(UsbClientState *usbClientState, int32_t endpoint);
-USB_PACKET64* TinyCLR_UsbClient_RxEnqueue(UsbClientState* usbClientState, int32_t endpoint, bool& disableRx);
-USB_PACKET64* TinyCLR_UsbClient_TxDequeue(UsbClientState* usbClientState, int32_t endpoint);
+uint8_t* TinyCLR_UsbClient_RxEnqueue(UsbClientState* usbClientState, int32_t endpoint, bool& disableRx);
+void TinyCLR_UsbClient_RxCommit(UsbClientState* usbClientState, int32_t endpoint, uint32_t size);
+uint8_t* TinyCLR_UsbClient_TxDequeue(UsbClientState* usbClientState, int32_t endpoint, uint32_t& size);
 void TinyCLR_UsbClient_StateCallback(UsbClientState* usbClientState);
 uint8_t TinyCLR_UsbClient_ControlCallback(UsbClientState* usbClientState);
+uint8_t TinyCLR_UsbClient_ControlOutCallback(UsbClientState* usbClientState);
 bool TinyCLR_UsbClient_Initialize(UsbClientState* usbClientState);
 bool TinyCLR_UsbClient_Uninitialize(UsbClientState* usbClientState);
 
@@ -1353,6 +1380,7 @@ struct AT91SAM9Rx64_LCDC {
     static const    uint32_t LCDC_DMAEN = ((uint32_t)0x1 << 0); // (LCDC) DAM Enable
     static const    uint32_t LCDC_DMARST = ((uint32_t)0x1 << 1); // (LCDC) DMA Reset (WO)
     static const    uint32_t LCDC_DMABUSY = ((uint32_t)0x1 << 2); // (LCDC) DMA Reset (WO)
+    static const    uint32_t LCDC_DMAUPDT = ((uint32_t)0x1 << 3); // (LCDC) DMA Configuration Update
 
     /****/ volatile uint32_t LCDC_DMA2DCFG;   // DMA 2D addressing configuration
     static const    uint32_t LCDC_ADDRINC = ((uint32_t)0xFFFF << 0); // (LCDC) Number of 32b words that the DMA must jump when going to the next line
@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include "AT91SAM9Rx64.h"
+#include "../../Drivers/Display/Display.h"
 
 #ifdef INCLUDE_DISPLAY
 //LUT configurations
@@ -473,6 +474,20 @@ uint8_t m_AT91SAM9Rx64_Display_TextBuffer[LCD_MAX_COLUMN][LCD_MAX_ROW];
 
 AT91SAM9Rx64_LCD_Rotation m_AT91SAM9Rx64_Display_CurrentRotation = AT91SAM9Rx64_LCD_Rotation::rotateNormal_0;
 
+#ifndef AT91SAM9Rx64_DISPLAY_BUFFER_COUNT
+#define AT91SAM9Rx64_DISPLAY_BUFFER_COUNT 1
+#endif
+
+#define AT91SAM9Rx64_DISPLAY_FLIP_TIMEOUT_US 100000
+
+// With two buffers m_AT91SAM9Rx64_Display_VituralRam is the one being scanned out. DrawBuffer renders into the back buffer
+// and the LCD DMA switches to it at the start of the next frame.
+uint16_t* m_AT91SAM9Rx64_Display_BackBuffer = nullptr;
+volatile bool m_AT91SAM9Rx64_Display_FlipPending = false;
+
+// The back buffer holds updates drawn with the flip deferred on top of the front, the next flip shows them.
+bool m_AT91SAM9Rx64_Display_BackBufferAhead = false;
+
 bool AT91SAM9Rx64_Display_Initialize();
 bool AT91SAM9Rx64_Display_Uninitialize();
 bool AT91SAM9Rx64_Display_SetPinConfiguration(int32_t controllerIndex, bool enable);
@@ -495,6 +510,10 @@ uint32_t AT91SAM9Rx64_Display_GetPixelClockDivider();
 int32_t AT91SAM9Rx64_Display_GetOrientation();
 uint32_t* AT91SAM9Rx64_Display_GetFrameBuffer();
 
+void AT91SAM9Rx64_Display_CompleteFlip();
+void AT91SAM9Rx64_Display_FlipInterrupt(void* param);
+bool AT91SAM9Rx64_Display_WaitForFlip();
+
 #define TOTAL_DISPLAY_CONTROLLERS 1
 
 static TinyCLR_Display_Controller displayControllers[TOTAL_DISPLAY_CONTROLLERS];
@@ -648,6 +667,9 @@ bool AT91SAM9Rx64_Display_Initialize() {
     lcdc.LCDC_DMACON = AT91SAM9Rx64_LCDC::LCDC_DMAEN;
     lcdc.LCDC_PWRCON = AT91SAM9Rx64_LCDC::LCDC_PWR | (0x0F << 1);
 
+    if (m_AT91SAM9Rx64_Display_BackBuffer != nullptr)
+        AT91SAM9Rx64_InterruptInternal_Activate(AT91C_ID_LCDC, (uint32_t*)&AT91SAM9Rx64_Display_FlipInterrupt, 0);
+
     return true;
 }
 
@@ -657,14 +679,78 @@ bool AT91SAM9Rx64_Display_Uninitialize() {
 
     AT91SAM9Rx64_LCDC &lcdc = AT91::LCDC();
 
+    AT91SAM9Rx64_InterruptInternal_Deactivate(AT91C_ID_LCDC);
+
+    lcdc.LCDC_IDR = ~0UL;
     lcdc.LCDC_PWRCON = 0x0C;
     lcdc.LCDC_DMACON = 0;
 
+    m_AT91SAM9Rx64_Display_FlipPending = false;
     m_AT91SAM9Rx64_DisplayEnable = false;
 
     return true;
 }
 
+//====================================================
+void AT91SAM9Rx64_Display_CompleteFlip() {
+    auto front = m_AT91SAM9Rx64_Display_VituralRam;
+
+    m_AT91SAM9Rx64_Display_VituralRam = m_AT91SAM9Rx64_Display_BackBuffer;
+    m_AT91SAM9Rx64_Display_BackBuffer = front;
+    m_AT91SAM9Rx64_Display_FlipPending = false;
+}
+
+void AT91SAM9Rx64_Display_FlipInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    AT91SAM9Rx64_LCDC &lcdc = AT91::LCDC();
+
+    if (lcdc.LCDC_ISR & AT91SAM9Rx64_LCDC::LCDC_EOFI) {
+        lcdc.LCDC_IDR = AT91SAM9Rx64_LCDC::LCDC_EOFI;
+        lcdc.LCDC_ICR = AT91SAM9Rx64_LCDC::LCDC_EOFI;
+
+        if (m_AT91SAM9Rx64_Display_FlipPending) {
+            AT91SAM9Rx64_Display_CompleteFlip();
+
+            Display_RaiseFrameComplete(&displayControllers[0], AT91SAM9Rx64_Time_GetSystemTime(nullptr));
+        }
+    }
+}
+
+void AT91SAM9Rx64_Display_RequestFlip() {
+    AT91SAM9Rx64_LCDC &lcdc = AT91::LCDC();
+
+    AT91SAM9Rx64_Cache_FlushCaches();
+
+    m_AT91SAM9Rx64_Display_FlipPending = true;
+
+    // DMAUPDT latches the new base address at the end of the current frame.
+    lcdc.LCDC_BA1 = (uint32_t)m_AT91SAM9Rx64_Display_BackBuffer;
+    lcdc.LCDC_DMACON |= AT91SAM9Rx64_LCDC::LCDC_DMAUPDT;
+    lcdc.LCDC_ICR = AT91SAM9Rx64_LCDC::LCDC_EOFI;
+    lcdc.LCDC_IER = AT91SAM9Rx64_LCDC::LCDC_EOFI;
+}
+
+bool AT91SAM9Rx64_Display_WaitForFlip() {
+    for (auto i = 0; m_AT91SAM9Rx64_Display_FlipPending && i < AT91SAM9Rx64_DISPLAY_FLIP_TIMEOUT_US / 100; i++)
+        AT91SAM9Rx64_Time_Delay(nullptr, 100);
+
+    if (m_AT91SAM9Rx64_Display_FlipPending) {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        AT91SAM9Rx64_LCDC &lcdc = AT91::LCDC();
+
+        // No frame ended, the base register already holds the back buffer so take the flip as done.
+        lcdc.LCDC_IDR = AT91SAM9Rx64_LCDC::LCDC_EOFI;
+
+        AT91SAM9Rx64_Display_CompleteFlip();
+
+        return false;
+    }
+
+    return true;
+}
+
 //====================================================
 void AT91SAM9Rx64_Display_WriteFormattedChar(uint8_t c) {
     if (m_AT91SAM9Rx64_DisplayEnable == false)
@@ -934,16 +1020,15 @@ int32_t AT91SAM9Rx64_Display_GetOrientation() {
 
 void AT91SAM9Rx64_Display_BitBltEx(int32_t x, int32_t y, int32_t width, int32_t height, uint32_t data[]) {
 
-    int32_t xTo, yTo, xFrom, yFrom;
+    int32_t yTo;
     int32_t xOffset = x;
     int32_t yOffset = y;
     uint16_t *from = (uint16_t *)data;
-    uint16_t *to = (uint16_t *)m_AT91SAM9Rx64_Display_VituralRam;
+    uint16_t *to = m_AT91SAM9Rx64_Display_BackBuffer != nullptr ? m_AT91SAM9Rx64_Display_BackBuffer : m_AT91SAM9Rx64_Display_VituralRam;
 
 
     int32_t screenWidth = m_AT91SAM9Rx64_DisplayWidth;
     int32_t screenHeight = m_AT91SAM9Rx64_DisplayHeight;
-    int32_t startPx, toAddition;
 
     if (m_AT91SAM9Rx64_DisplayEnable == false)
         return;
@@ -951,7 +1036,10 @@ void AT91SAM9Rx64_Display_BitBltEx(int32_t x, int32_t y, int32_t width, int32_t
     switch (m_AT91SAM9Rx64_Display_CurrentRotation) {
     case AT91SAM9Rx64_LCD_Rotation::rotateNormal_0:
 
-        if (xOffset == 0 && yOffset == 0 &&
+        if (Display_IsDamageTrackingEnabled()) {
+            Display_CopyChangedRgb565(from, width, to + yOffset * screenWidth + xOffset, screenWidth, width, height);
+        }
+        else if (xOffset == 0 && yOffset == 0 &&
             width == screenWidth && height == screenHeight) {
             memcpy(to, from, (screenWidth*screenHeight * 2));
         }
@@ -966,70 +1054,19 @@ void AT91SAM9Rx64_Display_BitBltEx(int32_t x, int32_t y, int32_t width, int32_t
 
     case AT91SAM9Rx64_LCD_Rotation::rotateCCW_90:
 
-        startPx = yOffset * screenHeight;
-        xFrom = xOffset + width;
-        yTo = screenHeight - xOffset - width;
-        xTo = yOffset;
-        to += yTo * screenWidth + xTo;
-        toAddition = screenWidth - height;
-
-        for (; yTo < (screenHeight - xOffset); yTo++) {
-            xFrom--;
-            yFrom = startPx + xFrom;
-
-            for (xTo = yOffset; xTo < (yOffset + height); xTo++) {
-                *to++ = from[yFrom];
-                yFrom += screenHeight;
-            }
-
-            to += toAddition;
-        }
+        Display_RotateRgb565Ccw90(from + yOffset * screenHeight + xOffset, screenHeight, to + (screenHeight - xOffset - width) * screenWidth + yOffset, screenWidth, width, height);
 
         break;
 
     case AT91SAM9Rx64_LCD_Rotation::rotateCW_90:
 
-        startPx = (yOffset + height - 1) * screenHeight;
-        xFrom = xOffset;
-
-        yTo = xOffset;
-        xTo = screenWidth - yOffset - height;
-        to += yTo * screenWidth + xTo;
-        toAddition = screenWidth - height;
-
-        for (; yTo < (xOffset + width); yTo++) {
-            yFrom = startPx + xFrom;
-
-            for (xTo = screenWidth - yOffset - height; xTo < (screenWidth - yOffset); xTo++) {
-                *to++ = from[yFrom];
-                yFrom -= screenHeight;
-            }
-
-            to += toAddition;
-            xFrom++;
-        }
+        Display_RotateRgb565Cw90(from + yOffset * screenHeight + xOffset, screenHeight, to + xOffset * screenWidth + (screenWidth - yOffset - height), screenWidth, width, height);
 
         break;
 
     case AT91SAM9Rx64_LCD_Rotation::rotate_180:
 
-        xFrom = (yOffset + height - 1) * screenWidth + xOffset + width;
-
-        yTo = screenHeight - yOffset - height;
-        xTo = screenWidth - xOffset - width;
-        to += yTo * screenWidth + xTo;
-        toAddition = screenWidth - width;
-
-        for (; yTo < (screenHeight - yOffset); yTo++) {
-
-            for (xTo = screenWidth - xOffset - width; xTo < (screenWidth - xOffset); xTo++) {
-                xFrom--;
-                *to++ = from[xFrom];
-            }
-
-            to += toAddition;
-            xFrom -= toAddition;
-        }
+        Display_RotateRgb565180(from + yOffset * screenWidth + xOffset, screenWidth, to + (screenHeight - yOffset - height) * screenWidth + (screenWidth - xOffset - width), screenWidth, width, height);
 
         break;
     }
@@ -1094,6 +1131,7 @@ TinyCLR_Result AT91SAM9Rx64_Display_Release(const TinyCLR_Display_Controller* se
             memoryProvider->Free(memoryProvider, m_AT91SAM9Rx64_Display_buffer);
 
             m_AT91SAM9Rx64_Display_buffer = nullptr;
+            m_AT91SAM9Rx64_Display_BackBuffer = nullptr;
         }
     }
 
@@ -1161,9 +1199,12 @@ TinyCLR_Result AT91SAM9Rx64_Display_SetConfiguration(const TinyCLR_Display_Contr
             memoryProvider->Free(memoryProvider, m_AT91SAM9Rx64_Display_buffer);
 
             m_AT91SAM9Rx64_Display_buffer = nullptr;
+            m_AT91SAM9Rx64_Display_BackBuffer = nullptr;
         }
 
-        m_AT91SAM9Rx64_Display_buffer = (uint32_t*)memoryProvider->Allocate(memoryProvider, m_AT91SAM9Rx64_DisplayBufferSize + 8);
+        auto bufferStride = (m_AT91SAM9Rx64_DisplayBufferSize + 7) & ~7;
+
+        m_AT91SAM9Rx64_Display_buffer = (uint32_t*)memoryProvider->Allocate(memoryProvider, bufferStride * AT91SAM9Rx64_DISPLAY_BUFFER_COUNT + 8);
 
         if (m_AT91SAM9Rx64_Display_buffer == nullptr) {
             return TinyCLR_Result::OutOfMemory;
@@ -1171,6 +1212,10 @@ TinyCLR_Result AT91SAM9Rx64_Display_SetConfiguration(const TinyCLR_Display_Contr
 
         m_AT91SAM9Rx64_Display_VituralRam = (uint16_t*)((((uint32_t)m_AT91SAM9Rx64_Display_buffer) + (7)) & (~((uint32_t)(7))));
 
+        if (AT91SAM9Rx64_DISPLAY_BUFFER_COUNT > 1)
+            m_AT91SAM9Rx64_Display_BackBuffer = (uint16_t*)(((uint32_t)m_AT91SAM9Rx64_Display_VituralRam) + bufferStride);
+            m_AT91SAM9Rx64_Display_BackBufferAhead = false;
+
         // Set displayPins.enable following m_AT91SAM9Rx64_DisplayOutputEnableIsFixed
         if (displayPins.enable.number != PIN_NONE) {
             if (m_AT91SAM9Rx64_DisplayOutputEnableIsFixed) {
@@ -1218,7 +1263,27 @@ TinyCLR_Result AT91SAM9Rx64_Display_GetConfiguration(const TinyCLR_Display_Contr
 }
 
 TinyCLR_Result AT91SAM9Rx64_Display_DrawBuffer(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* data) {
+    if (m_AT91SAM9Rx64_Display_BackBuffer == nullptr || m_AT91SAM9Rx64_DisplayEnable == false) {
+        AT91SAM9Rx64_Display_BitBltEx(x, y, width, height, (uint32_t*)data);
+        return TinyCLR_Result::Success;
+    }
+
+    int32_t screenWidth, screenHeight;
+
+    AT91SAM9Rx64_Display_WaitForFlip();
+    AT91SAM9Rx64_Display_GetRotatedDimensions(&screenWidth, &screenHeight);
+
+    // The back buffer is one frame behind, a partial update has to start from what is on screen.
+    if (!m_AT91SAM9Rx64_Display_BackBufferAhead && (x != 0 || y != 0 || width != screenWidth || height != screenHeight))
+        memcpy(m_AT91SAM9Rx64_Display_BackBuffer, m_AT91SAM9Rx64_Display_VituralRam, m_AT91SAM9Rx64_DisplayBufferSize);
+
     AT91SAM9Rx64_Display_BitBltEx(x, y, width, height, (uint32_t*)data);
+
+    m_AT91SAM9Rx64_Display_BackBufferAhead = Display_IsFlipDeferred();
+
+    if (!m_AT91SAM9Rx64_Display_BackBufferAhead)
+        AT91SAM9Rx64_Display_RequestFlip();
+
     return TinyCLR_Result::Success;
 }
 
@@ -1228,6 +1293,8 @@ TinyCLR_Result AT91SAM9Rx64_Display_DrawPixel(const TinyCLR_Display_Controller*
     if (m_AT91SAM9Rx64_DisplayEnable == false || x >= m_AT91SAM9Rx64_DisplayWidth || y >= m_AT91SAM9Rx64_DisplayHeight)
         return TinyCLR_Result::InvalidOperation;
 
+    AT91SAM9Rx64_Display_WaitForFlip();
+
     loc = m_AT91SAM9Rx64_Display_VituralRam + (y *m_AT91SAM9Rx64_DisplayWidth) + (x);
 
     *loc = static_cast<uint16_t>(color & 0xFFFF);
@@ -1236,6 +1303,8 @@ TinyCLR_Result AT91SAM9Rx64_Display_DrawPixel(const TinyCLR_Display_Controller*
 }
 
 TinyCLR_Result AT91SAM9Rx64_Display_DrawString(const TinyCLR_Display_Controller* self, const char* data, size_t length) {
+    AT91SAM9Rx64_Display_WaitForFlip();
+
     for (size_t i = 0; i < length; i++)
         AT91SAM9Rx64_Display_WriteFormattedChar(data[i]);
 
@@ -1282,6 +1351,7 @@ void AT91SAM9Rx64_Display_AddApi(const TinyCLR_Api_Manager* apiManager) {
 
     displayInitializeCount = 0;
     m_AT91SAM9Rx64_Display_buffer = nullptr;
+    m_AT91SAM9Rx64_Display_BackBuffer = nullptr;
     m_AT91SAM9Rx64_DisplayEnable = false;
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::DisplayController, displayApi[0].Name);
@@ -1296,6 +1366,7 @@ void AT91SAM9Rx64_Display_Reset() {
     m_AT91SAM9Rx64_DisplayEnable = false;
     displayInitializeCount = 0;
     m_AT91SAM9Rx64_Display_buffer = nullptr;
+    m_AT91SAM9Rx64_Display_BackBuffer = nullptr;
 
     m_AT91SAM9Rx64_Display_TextRow = 0;
     m_AT91SAM9Rx64_Display_TextColumn = 0;
@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include "AT91SAM9Rx64.h"
+#include "../../Drivers/InterruptProfiler/InterruptProfiler.h"
 
 #define DISABLED_MASK 0x80
 
@@ -250,16 +251,30 @@ bool AT91SAM9Rx64_InterruptInternal_Deactivate(uint32_t Irq_Index) {
     return true;
 }
 
+#if defined(INTERRUPT_PROFILER)
+uint32_t InterruptProfiler_ReadCounter() {
+    return AT91::TIMER(0).TC_CV;
+}
+#endif
+
 AT91SAM9Rx64_InterruptStarted_RaiiHelper::AT91SAM9Rx64_InterruptStarted_RaiiHelper() { AT91SAM9Rx64_Interrupt_Started(); };
 AT91SAM9Rx64_InterruptStarted_RaiiHelper::~AT91SAM9Rx64_InterruptStarted_RaiiHelper() { AT91SAM9Rx64_Interrupt_Ended(); };
 
 AT91SAM9Rx64_DisableInterrupts_RaiiHelper::AT91SAM9Rx64_DisableInterrupts_RaiiHelper() {
     state = IRQ_LOCK_Disable_asm();
+
+#if defined(INTERRUPT_PROFILER)
+    if ((state & DISABLED_MASK) == 0)
+        InterruptProfiler_DisabledStarted();
+#endif
 }
 AT91SAM9Rx64_DisableInterrupts_RaiiHelper::~AT91SAM9Rx64_DisableInterrupts_RaiiHelper() {
     uint32_t Cp = state;
 
     if ((Cp & DISABLED_MASK) == 0) {
+#if defined(INTERRUPT_PROFILER)
+        InterruptProfiler_DisabledEnded();
+#endif
         state = IRQ_LOCK_Release_asm();
     }
 }
@@ -273,6 +288,11 @@ void AT91SAM9Rx64_DisableInterrupts_RaiiHelper::Acquire() {
 
     if ((Cp & DISABLED_MASK) == DISABLED_MASK) {
         state = IRQ_LOCK_Disable_asm();
+
+#if defined(INTERRUPT_PROFILER)
+        if ((state & DISABLED_MASK) == 0)
+            InterruptProfiler_DisabledStarted();
+#endif
     }
 }
 
@@ -280,6 +300,9 @@ void AT91SAM9Rx64_DisableInterrupts_RaiiHelper::Release() {
     uint32_t Cp = state;
 
     if ((Cp & DISABLED_MASK) == 0) {
+#if defined(INTERRUPT_PROFILER)
+        InterruptProfiler_DisabledEnded();
+#endif
         state = IRQ_LOCK_Release_asm();
     }
 }
@@ -292,11 +315,19 @@ bool AT91SAM9Rx64_Interrupt_IsDisabled() {
 }
 
 void AT91SAM9Rx64_Interrupt_Enable() {
+#if defined(INTERRUPT_PROFILER)
+    InterruptProfiler_DisabledEnded();
+#endif
     IRQ_LOCK_Release_asm();
 }
 
 void AT91SAM9Rx64_Interrupt_Disable() {
+#if defined(INTERRUPT_PROFILER)
+    if ((IRQ_LOCK_Disable_asm() & DISABLED_MASK) == 0)
+        InterruptProfiler_DisabledStarted();
+#else
     IRQ_LOCK_Disable_asm();
+#endif
 }
 
 void AT91SAM9Rx64_Interrupt_WaitForInterrupt() {
@@ -351,8 +382,16 @@ extern "C" {
             AT91SAM9Rx64_Interrupt_RemoveForcedInterrupt(index);
 
 
+#if defined(INTERRUPT_PROFILER)
+            InterruptProfiler_Started(index);
+#endif
+
             IsrVector->Handler.Execute();
 
+#if defined(INTERRUPT_PROFILER)
+            InterruptProfiler_Ended();
+#endif
+
             // Mark end of Interrupt
             aic.AIC_EOICR = 1;
         }
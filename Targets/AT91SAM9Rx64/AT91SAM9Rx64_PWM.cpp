@@ -14,6 +14,8 @@
 // limitations under the License.
 
 #include "AT91SAM9Rx64.h"
+#include "../../Drivers/DevicesInterop/Pwm/GHIElectronics_TinyCLR_Devices_Pwm_Burst.h"
+#include "../../Drivers/DevicesInterop/Pwm/GHIElectronics_TinyCLR_Devices_Pwm_Timing.h"
 
 #define PWM_MODE_REGISTER               (*(uint32_t *)(0xFFFC8000))
 #define PWM_ENABLE_REGISTER             (*(uint32_t *)(0xFFFC8004))
@@ -24,18 +26,17 @@
 #define PWM_CHANNEL_MODE_REGISTER(x)    (uint32_t *)(0xFFFC8000 + (0x200 + (x * 0x20) + 0x00))
 #define PWM_DUTY_REGISTER(x)            (uint32_t *)(0xFFFC8000 + (0x200 + (x * 0x20) + 0x04))
 #define PWM_CHANNEL_UPDATE_REGISTER(x)  (uint32_t *)(0xFFFC8000 + (0x200 + (x * 0x10) + ((x + 1) * 0x10)))
+#define PWM_PERIOD_REGISTER(x)          (uint32_t *)(0xFFFC8000 + (0x200 + (x * 0x20) + 0x08))
 
-#define PWM_MILLISECONDS                1000
-#define PWM_MICROSECONDS                1000000
-#define PWM_NANOSECONDS                 1000000000
+#define PWM_INTERUPT_STATUS_REGISTER    (*(uint32_t *)(0xFFFC801C))
+
+#define PWM_CHANNEL_UPDATE_PERIOD       (1 << 10) // CUPD holds the next period, otherwise the next duty cycle
+
+#define PWM_BURST_MAX_FREQUENCY         20000 // every period of a burst costs an interrupt
 
 #define AT91SAM9Rx64_MAX_PWM_FREQUENCY          25000000
 #define AT91SAM9Rx64_MIN_PWM_FREQUENCY          1
 
-#define PWM_MILLISECONDS  1000
-#define PWM_MICROSECONDS  1000000
-#define PWM_NANOSECONDS   1000000000
-
 const char* PwmApiNames[] = {
 #if TOTAL_PWM_CONTROLLERS > 0
 "GHIElectronics.TinyCLR.NativeApis.AT91SAM9Rx64.PwmController\\0",
@@ -56,6 +57,8 @@ static PwmState pwmStates[TOTAL_PWM_CONTROLLERS];
 static TinyCLR_Pwm_Controller pwmControllers[TOTAL_PWM_CONTROLLERS];
 static TinyCLR_Api_Info pwmApi[TOTAL_PWM_CONTROLLERS];
 
+static const TinyCLR_Pwm_BurstApi pwmBurstApi = { &AT91SAM9Rx64_Pwm_SetPulseParametersBatch, &AT91SAM9Rx64_Pwm_EncodeBurst, &AT91SAM9Rx64_Pwm_StartBurst, &AT91SAM9Rx64_Pwm_IsBurstActive, &AT91SAM9Rx64_Pwm_StopBurst };
+
 void AT91SAM9Rx64_Pwm_AddApi(const TinyCLR_Api_Manager* apiManager) {
     for (auto i = 0; i < TOTAL_PWM_CONTROLLERS; i++) {
         pwmControllers[i].ApiInfo = &pwmApi[i];
@@ -81,6 +84,8 @@ void AT91SAM9Rx64_Pwm_AddApi(const TinyCLR_Api_Manager* apiManager) {
         pwmStates[i].controllerIndex = i;
 
         apiManager->Add(apiManager, &pwmApi[i]);
+
+        TinyCLR_Pwm_SetBurstApi(&pwmControllers[i], &pwmBurstApi);
     }
 }
 static const AT91SAM9Rx64_Gpio_Pin pwmPins[TOTAL_PWM_CONTROLLERS][MAX_PWM_PER_CONTROLLER] = AT91SAM9Rx64_PWM_PINS;
@@ -108,7 +113,6 @@ TinyCLR_Result AT91SAM9Rx64_Pwm_OpenChannel(const TinyCLR_Pwm_Controller* self,
     auto controllerIndex = state->controllerIndex;
 
     PWM_ENABLE_REGISTER |= (1 << controllerIndex);
-    PWM_INTERUPT_ENABLE_REGISTER |= (1 << controllerIndex);
 
     AT91SAM9Rx64_Pwm_SetPinState(self, channel, false);
 
@@ -134,301 +138,250 @@ TinyCLR_Result AT91SAM9Rx64_Pwm_CloseChannel(const TinyCLR_Pwm_Controller* self,
     return TinyCLR_Result::Success;
 }
 
-void AT91SAM9Rx64_Pwm_GetScaleFactor(double frequency, uint32_t& period, uint32_t& scale) {
-    if (frequency >= 1000.0) {
-        period = (uint32_t)(((uint32_t)PWM_NANOSECONDS / frequency) + 0.5);
-        scale = PWM_NANOSECONDS;
-    }
-    else if (frequency >= 1.0) {
-        period = (uint32_t)(((uint32_t)PWM_MICROSECONDS / frequency) + 0.5);
-        scale = PWM_MICROSECONDS;
-    }
-    else {
-        period = (uint32_t)(((uint32_t)PWM_MILLISECONDS / frequency) + 0.5);
-        scale = PWM_MILLISECONDS;
-    }
-}
+// The channel clock is MCK divided by a power of two up to 1024, CPRD holds a 16 bit period
+static const TinyCLR_Pwm_Counter pwmCounter = { AT91SAM9Rx64_SYSTEM_PERIPHERAL_CLOCK_HZ, 1024, true, 5, 0xFFFF };
 
-double AT91SAM9Rx64_Pwm_GetMaxPeriod(uint32_t divider) {
-    switch (divider) {
-    case 1024:
-        return 503308801.0;
-    case 512:
-        return 251654401.0;
-    case 256:
-        return 125827200.0;
-    case 128:
-        return 62913600.0;
-    case 64:
-        return 31456800.0;
-    case 32:
-        return 15728400.0;
-    case 16:
-        return 7864200.0;
-    case 8:
-        return 3932100.0;
-    case 4:
-        return 1966050.0;
-    case 2:
-        return 983025.0;
-    case 1:
-        return 491513.0;
-    }
-}
+double AT91SAM9Rx64_Pwm_GetActualFrequency(const TinyCLR_Pwm_Controller* self) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-void AT91SAM9Rx64_Pwm_GetDivider(uint32_t period, uint32_t& divider, uint32_t& registerDividerFlag) {
-    if (period > 503308801) {
-        divider = 0;
-        registerDividerFlag = 0;
-    }
-    else if (period > 251654401) {
-        divider = 1024;
-        registerDividerFlag = 0xA;
-    }
-    else if (period > 125827200) {
-        divider = 512;
-        registerDividerFlag = 0x9;
-    }
-    else if (period > 62913600) {
-        divider = 256;
-        registerDividerFlag = 0x8;
-    }
-    else if (period > 31456800) {
-        divider = 128;
-        registerDividerFlag = 0x7;
-    }
-    else if (period > 15728400) {
-        divider = 64;
-        registerDividerFlag = 0x6;
-    }
-    else if (period > 7864200) {
-        divider = 32;
-        registerDividerFlag = 0x5;
-    }
-    else if (period > 3932100) {
-        divider = 16;
-        registerDividerFlag = 0x4;
-    }
-    else if (period > 1966050) {
-        divider = 8;
-        registerDividerFlag = 0x3;
-    }
-    else if (period > 983025) {
-        divider = 4;
-        registerDividerFlag = 0x2;
-    }
-    else if (period > 491513) {
-        divider = 2;
-        registerDividerFlag = 0x1;
-    }
-    else if (period >= 40) // Absoulute minimum for the PWM Counter
-    {
-        divider = 1;
-        registerDividerFlag = 0x0;
-    }
-    else {
-        divider = 0;
-        registerDividerFlag = 0;
+    if (state->frequency == 0) {
+        state->prescaler = 1;
+        state->period = 0;
+
+        return 0;
     }
+
+    TinyCLR_Pwm_SolveTiming(pwmCounter, state->frequency, state->prescaler, state->period);
+
+    return TinyCLR_Pwm_ToFrequency(TinyCLR_Pwm_GetFrequency(pwmCounter, state->prescaler, state->period));
 }
-uint32_t AT91SAM9Rx64_Pwm_GetPeriod(const TinyCLR_Pwm_Controller* self, uint32_t period, uint32_t divider) {
-    // make sure out frequency <= in frequency
-    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    double d = divider * 7.6;
-    double p = (double)period;
-    double mck_clk = (double)AT91SAM9Rx64_SYSTEM_PERIPHERAL_CLOCK_HZ;
-    double freq_out = (double)(mck_clk / (p / (d)));
-    double frequency = state->frequency;
+TinyCLR_Result AT91SAM9Rx64_Pwm_EnableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel) {
+    int32_t actualPin = AT91SAM9Rx64_Pwm_GetGpioPinForChannel(self, channel);
 
-    if ((p > 0) && (freq_out > frequency)) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-        while (freq_out > frequency) {
-            p += d;
+    AT91SAM9Rx64_GpioInternal_ConfigurePin(actualPin, AT91SAM9Rx64_Gpio_Direction::Input, state->gpioPin[channel].peripheralSelection, AT91SAM9Rx64_Gpio_ResistorMode::Inactive);
 
-            if (p >= AT91SAM9Rx64_Pwm_GetMaxPeriod(divider)) {
-                break;
-            }
+    return TinyCLR_Result::Success;
+}
 
-            freq_out = (double)(mck_clk / (p / (d)));
-        }
+TinyCLR_Result AT91SAM9Rx64_Pwm_DisableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel) {
+    int32_t actualPin = AT91SAM9Rx64_Pwm_GetGpioPinForChannel(self, channel);
 
-        // Update new period
-        period = (volatile unsigned long)p;
-    }
+    AT91SAM9Rx64_Pwm_SetPinState(self, channel, false);
 
-    return period;
+    return TinyCLR_Result::Success;
 }
 
-double AT91SAM9Rx64_Pwm_GetActualFrequency(const TinyCLR_Pwm_Controller* self) {
-    uint32_t period = 0;
-    uint32_t scale = 0;
-
-    uint32_t convertedPeriod = 0;
+uint32_t AT91SAM9Rx64_Pwm_GetChannelCount(const TinyCLR_Pwm_Controller* self) {
+    return MAX_PWM_PER_CONTROLLER;
+}
 
+uint32_t AT91SAM9Rx64_Pwm_GetGpioPinForChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel) {
     auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    double frequency = state->frequency;
+    return state->gpioPin[channel].number;
+}
 
-    AT91SAM9Rx64_Pwm_GetScaleFactor(frequency, period, scale);
+double AT91SAM9Rx64_Pwm_GetMaxFrequency(const TinyCLR_Pwm_Controller* self) {
+    return AT91SAM9Rx64_MAX_PWM_FREQUENCY;
+}
 
-    switch (scale) {
-    case PWM_MILLISECONDS:
-        convertedPeriod = (period * 1000000);
+double AT91SAM9Rx64_Pwm_GetMinFrequency(const TinyCLR_Pwm_Controller* self) {
+    return AT91SAM9Rx64_MIN_PWM_FREQUENCY;
+}
 
-        break;
+// Channel mode, period and duty cycle register values of a duty cycle in parts per million at the current frequency
+static void AT91SAM9Rx64_Pwm_GetRegisters(const TinyCLR_Pwm_Controller* self, uint32_t dutyCycle, TinyCLR_Pwm_PulsePolarity polarity, uint32_t& mode, uint32_t& periodValue, uint32_t& dutyValue) {
+    uint32_t registerDividerFlag = 0; // log2 of the prescaler
+    uint32_t pulseBeginsOnHighEdge = 1; // Default Pulse starts on High Edge.
 
-    case PWM_MICROSECONDS:
-        convertedPeriod = (period * 1000);
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-        break;
+    while ((1U << registerDividerFlag) < state->prescaler)
+        registerDividerFlag++;
 
-    case PWM_NANOSECONDS:
-        convertedPeriod = period;
+    // Flips the pulse
+    if (polarity == TinyCLR_Pwm_PulsePolarity::ActiveLow)
+        pulseBeginsOnHighEdge = 0;
+    else
+        pulseBeginsOnHighEdge = 1;
 
-        break;
-    }
+    mode = registerDividerFlag | (pulseBeginsOnHighEdge << 9) | (1 << 10);
+    periodValue = state->period;
+    dutyValue = TinyCLR_Pwm_GetPulse(state->period, dutyCycle);
+}
 
-    // make sure out frequency <= in frequency
-    uint32_t divider;
-    uint32_t registerDividerFlag;
+static TinyCLR_Result AT91SAM9Rx64_Pwm_SetPulses(const TinyCLR_Pwm_Controller* self, const uint32_t* channels, const uint32_t* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    AT91SAM9Rx64_Pwm_GetDivider(convertedPeriod, divider, registerDividerFlag);
+    if (state->burstActive)
+        return TinyCLR_Result::Busy;
 
-    if (divider > 0)
-        convertedPeriod = AT91SAM9Rx64_Pwm_GetPeriod(self, convertedPeriod, divider);
+    for (size_t i = 0; i < count; i++)
+        if (channels[i] >= MAX_PWM_PER_CONTROLLER)
+            return TinyCLR_Result::ArgumentOutOfRange;
 
-    if (convertedPeriod > 503308801)
-        convertedPeriod = 503308801; // max period
-    else if (convertedPeriod < 40)
-        convertedPeriod = 40; // min period
+    // a controller is a single PWM channel, the last setting of a channel wins
+    for (size_t i = 0; i < count; i++) {
+        uint32_t mode, periodValue, dutyValue;
 
-    switch (scale) {
-    case PWM_MILLISECONDS:
-        period = (convertedPeriod / 1000000);
+        AT91SAM9Rx64_Pwm_GetRegisters(self, dutyCycles[i], polarities[i], mode, periodValue, dutyValue);
 
-        break;
+        if (*PWM_PERIOD_REGISTER(state->controllerIndex) == periodValue) {
+            // same period, the duty cycle goes through the update register to change at the next period
+            *state->channelModeReg = mode & ~PWM_CHANNEL_UPDATE_PERIOD;
+            *state->channelUpdateReg = dutyValue;
+        }
+        else {
+            *state->channelModeReg = mode;
+            *state->channelUpdateReg = periodValue;
+            *state->dutyCycleReg = dutyValue;
+        }
 
-    case PWM_MICROSECONDS:
-        period = (convertedPeriod / 1000);
+        state->invert[channels[i]] = polarities[i];
+        state->dutyCycle[channels[i]] = dutyCycles[i];
+    }
 
-        break;
+    return TinyCLR_Result::Success;
+}
 
-    case PWM_NANOSECONDS:
-        period = convertedPeriod;
-        break;
-    }
+TinyCLR_Result AT91SAM9Rx64_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* self, uint32_t channel, double dutyCycle, TinyCLR_Pwm_PulsePolarity polarity) {
+    return AT91SAM9Rx64_Pwm_SetPulseParametersBatch(self, &channel, &dutyCycle, &polarity, 1);
+}
 
-    frequency = (double)(scale / period);
+TinyCLR_Result AT91SAM9Rx64_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Controller* self, const uint32_t* channels, const double* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count) {
+    uint32_t dutyCyclesPpm[MAX_PWM_PER_CONTROLLER];
 
-    return frequency;
+    if (count > MAX_PWM_PER_CONTROLLER)
+        return TinyCLR_Result::ArgumentOutOfRange;
 
-}
+    for (size_t i = 0; i < count; i++)
+        dutyCyclesPpm[i] = TinyCLR_Pwm_FromDutyCycle(dutyCycles[i]);
 
-TinyCLR_Result AT91SAM9Rx64_Pwm_EnableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel) {
-    int32_t actualPin = AT91SAM9Rx64_Pwm_GetGpioPinForChannel(self, channel);
+    return AT91SAM9Rx64_Pwm_SetPulses(self, channels, dutyCyclesPpm, polarities, count);
+}
 
+TinyCLR_Result AT91SAM9Rx64_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Controller* self, double& frequency) {
     auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    AT91SAM9Rx64_GpioInternal_ConfigurePin(actualPin, AT91SAM9Rx64_Gpio_Direction::Input, state->gpioPin[channel].peripheralSelection, AT91SAM9Rx64_Gpio_ResistorMode::Inactive);
+    if (state->burstActive)
+        return TinyCLR_Result::Busy;
+
+    state->frequency = TinyCLR_Pwm_FromFrequency(frequency);
+
+    // Calculate actual frequency
+    frequency = AT91SAM9Rx64_Pwm_GetActualFrequency(self);
+
+    for (uint32_t p = 0; p < MAX_PWM_PER_CONTROLLER; p++)
+        if (state->gpioPin[p].number != PIN_NONE)
+            if (AT91SAM9Rx64_Pwm_SetPulses(self, &p, &state->dutyCycle[p], &state->invert[p], 1) != TinyCLR_Result::Success)
+                return TinyCLR_Result::InvalidOperation;
+
 
     return TinyCLR_Result::Success;
 }
 
-TinyCLR_Result AT91SAM9Rx64_Pwm_DisableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel) {
-    int32_t actualPin = AT91SAM9Rx64_Pwm_GetGpioPinForChannel(self, channel);
+TinyCLR_Result AT91SAM9Rx64_Pwm_EncodeBurst(const TinyCLR_Pwm_Controller* self, uint32_t channel, const double* dutyCycles, uint32_t* pulses, size_t count, size_t stride) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    AT91SAM9Rx64_Pwm_SetPinState(self, channel, false);
+    if (channel >= MAX_PWM_PER_CONTROLLER)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t mode, periodValue;
+
+        AT91SAM9Rx64_Pwm_GetRegisters(self, TinyCLR_Pwm_FromDutyCycle(dutyCycles[i * stride]), state->invert[channel], mode, periodValue, pulses[i * stride]);
+    }
 
     return TinyCLR_Result::Success;
 }
 
-uint32_t AT91SAM9Rx64_Pwm_GetChannelCount(const TinyCLR_Pwm_Controller* self) {
-    return MAX_PWM_PER_CONTROLLER;
-}
+static void AT91SAM9Rx64_Pwm_EndBurst(PwmState* state) {
+    PWM_INTERUPT_DISABLE_REGISTER = (1 << state->controllerIndex);
 
-uint32_t AT91SAM9Rx64_Pwm_GetGpioPinForChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel) {
-    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
+    state->burstActive = false;
 
-    return state->gpioPin[channel].number;
-}
+    // every channel shares the interrupt
+    for (auto i = 0; i < TOTAL_PWM_CONTROLLERS; i++)
+        if (pwmStates[i].burstActive)
+            return;
 
-double AT91SAM9Rx64_Pwm_GetMaxFrequency(const TinyCLR_Pwm_Controller* self) {
-    return AT91SAM9Rx64_MAX_PWM_FREQUENCY;
+    AT91SAM9Rx64_InterruptInternal_Deactivate(AT91C_ID_PWMC);
 }
 
-double AT91SAM9Rx64_Pwm_GetMinFrequency(const TinyCLR_Pwm_Controller* self) {
-    return AT91SAM9Rx64_MIN_PWM_FREQUENCY;
-}
+// Each period event of a channel loads its duty cycle update register with the next value
+static void AT91SAM9Rx64_Pwm_BurstInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
 
-TinyCLR_Result AT91SAM9Rx64_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* self, uint32_t channel, double dutyCycle, TinyCLR_Pwm_PulsePolarity polarity) {
-    uint32_t period = 0;
-    uint32_t scale = 0;
+    auto status = PWM_INTERUPT_STATUS_REGISTER; // cleared by the read
 
-    uint32_t convertedPeriod = 0;
-    uint32_t convertedDuration = 0;
-    uint32_t pulseBeginsOnHighEdge = 1; // Default Pulse starts on High Edge.
+    for (auto i = 0; i < TOTAL_PWM_CONTROLLERS; i++) {
+        auto state = &pwmStates[i];
 
-    uint32_t divider = 4; // Sets the default period/duration clock divider to 4 --> (MCK / divider) // MCK = 100 MHz
-    uint32_t registerDividerFlag = 0x2; // Sets the default channel clock divider to 4 --> (MCK / divider) // MCK = 100 MHz
+        if (!state->burstActive || !(status & (1 << i)))
+            continue;
 
-    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
+        *state->channelUpdateReg = state->burstPulses[state->burstNext];
 
-    double frequency = state->frequency;
+        if (++state->burstNext < state->burstSets)
+            continue;
 
-    AT91SAM9Rx64_Pwm_GetScaleFactor(frequency, period, scale);
+        state->burstNext = 0;
 
-    switch (scale) {
-    case PWM_MILLISECONDS:
-        convertedPeriod = (period * 1000000);
-        break;
+        if (state->burstLooped)
+            continue;
 
-    case PWM_MICROSECONDS:
-        convertedPeriod = (period * 1000);
-        break;
+        AT91SAM9Rx64_Pwm_EndBurst(state);
 
-    case PWM_NANOSECONDS:
-        convertedPeriod = period;
-        break;
+        if (state->burstCompleted != nullptr)
+            state->burstCompleted(&pwmControllers[i], AT91SAM9Rx64_Time_GetSystemTime(nullptr));
     }
+}
+
+TinyCLR_Result AT91SAM9Rx64_Pwm_StartBurst(const TinyCLR_Pwm_Controller* self, uint32_t firstChannel, uint32_t channelCount, const uint32_t* pulses, size_t sets, bool looped, TinyCLR_Pwm_BurstCompletedHandler completed) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    AT91SAM9Rx64_Pwm_GetDivider(convertedPeriod, divider, registerDividerFlag);
+    if (channelCount == 0 || firstChannel + channelCount > MAX_PWM_PER_CONTROLLER || sets == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
 
-    if (divider > 0)
-        convertedPeriod = AT91SAM9Rx64_Pwm_GetPeriod(self, convertedPeriod, divider);
+    if (state->frequency > PWM_BURST_MAX_FREQUENCY * TINYCLR_PWM_FREQUENCY_SCALE)
+        return TinyCLR_Result::NotSupported;
 
-    convertedDuration = (uint32_t)(dutyCycle * convertedPeriod);
+    if (state->burstActive || state->frequency == 0 || !state->isOpened[firstChannel])
+        return TinyCLR_Result::InvalidOperation;
 
-    // Flips the pulse
-    if (polarity == TinyCLR_Pwm_PulsePolarity::ActiveLow)
-        pulseBeginsOnHighEdge = 0;
-    else
-        pulseBeginsOnHighEdge = 1;
+    // the update register carries duty cycles for the length of the burst
+    *state->channelModeReg &= ~PWM_CHANNEL_UPDATE_PERIOD;
 
-    *state->channelModeReg = (volatile unsigned long)(registerDividerFlag | (pulseBeginsOnHighEdge << 9) | (1 << 10));
-    *state->channelUpdateReg = (volatile unsigned long)(convertedPeriod / (divider * 7.5));
-    *state->dutyCycleReg = (volatile unsigned long)(convertedDuration / (divider * 7.5));
+    state->burstPulses = pulses;
+    state->burstSets = sets;
+    state->burstNext = 0;
+    state->burstLooped = looped;
+    state->burstCompleted = completed;
+    state->burstActive = true;
 
-    state->invert[channel] = polarity;
-    state->dutyCycle[channel] = dutyCycle;
+    AT91SAM9Rx64_InterruptInternal_Activate(AT91C_ID_PWMC, (uint32_t*)&AT91SAM9Rx64_Pwm_BurstInterrupt, 0);
 
-    return TinyCLR_Result::Success;
+    PWM_INTERUPT_ENABLE_REGISTER = (1 << state->controllerIndex);
 
+    return TinyCLR_Result::Success;
 }
 
-TinyCLR_Result AT91SAM9Rx64_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Controller* self, double& frequency) {
+bool AT91SAM9Rx64_Pwm_IsBurstActive(const TinyCLR_Pwm_Controller* self) {
     auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    state->frequency = frequency;
+    return state->burstActive;
+}
 
-    // Calculate actual frequency
-    frequency = AT91SAM9Rx64_Pwm_GetActualFrequency(self);
+TinyCLR_Result AT91SAM9Rx64_Pwm_StopBurst(const TinyCLR_Pwm_Controller* self) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    for (int p = 0; p < MAX_PWM_PER_CONTROLLER; p++)
-        if (state->gpioPin[p].number != PIN_NONE)
-            if (AT91SAM9Rx64_Pwm_SetPulseParameters(self, p, state->dutyCycle[p], state->invert[p]) != TinyCLR_Result::Success)
-                return TinyCLR_Result::InvalidOperation;
+    if (!state->burstActive)
+        return TinyCLR_Result::InvalidOperation;
 
+    AT91SAM9Rx64_Pwm_EndBurst(state);
 
     return TinyCLR_Result::Success;
 }
@@ -477,6 +430,9 @@ void AT91SAM9Rx64_Pwm_Reset() {
 void AT91SAM9Rx64_Pwm_ResetController(int32_t controllerIndex) {
     auto state = &pwmStates[controllerIndex];
 
+    if (state->burstActive)
+        AT91SAM9Rx64_Pwm_EndBurst(state);
+
     for (int p = 0; p < MAX_PWM_PER_CONTROLLER; p++) {
         state->gpioPin[p] = AT91SAM9Rx64_Pwm_GetPins(controllerIndex, p);
 
@@ -486,8 +442,10 @@ void AT91SAM9Rx64_Pwm_ResetController(int32_t controllerIndex) {
             state->dutyCycleReg = PWM_DUTY_REGISTER(controllerIndex);
             state->channelUpdateReg = PWM_CHANNEL_UPDATE_REGISTER(controllerIndex);
             state->invert[p] = TinyCLR_Pwm_PulsePolarity::ActiveLow;
-            state->frequency = 0.0;
-            state->dutyCycle[p] = 0.0;
+            state->frequency = 0;
+            state->prescaler = 1;
+            state->period = 0;
+            state->dutyCycle[p] = 0;
 
             if (state->isOpened[p] == true) {
                 AT91SAM9Rx64_Pwm_DisableChannel(&pwmControllers[controllerIndex], p);
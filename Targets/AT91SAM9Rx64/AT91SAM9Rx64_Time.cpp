@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include "AT91SAM9Rx64.h"
+#include "../../Drivers/Time/TimeDivider.h"
 
 #define TIMER_IDLE_VALUE  0x0000FFFFFFFFFFFFull
 
@@ -24,6 +25,10 @@
 #define SLOW_CLOCKS_TEN_MHZ_GCD             250
 #define SLOW_CLOCKS_MILLISECOND_GCD         250
 
+static constexpr TimeDivider timeTicksDivider = TimeDivider_Create(SLOW_CLOCKS_PER_SECOND / SLOW_CLOCKS_TEN_MHZ_GCD);
+static constexpr TimeDivider timeTenDivider = TimeDivider_Create(10);
+static constexpr TimeDivider timeDelayDivider = TimeDivider_Create(1000000 / CLOCK_COMMON_FACTOR);
+
 //////////////////////////////////////////////////////////////////////////////
 // TIMER state
 //
@@ -291,13 +296,13 @@ uint32_t AT91SAM9Rx64_Time_GetTicksPerSecond(const TinyCLR_NativeTime_Controller
 
 uint64_t AT91SAM9Rx64_Time_GetTimeForProcessorTicks(const TinyCLR_NativeTime_Controller* self, uint64_t ticks) {
     ticks *= (10000000 / SLOW_CLOCKS_TEN_MHZ_GCD);
-    ticks /= (SLOW_CLOCKS_PER_SECOND / SLOW_CLOCKS_TEN_MHZ_GCD);
+    ticks = TimeDivider_Divide(ticks, timeTicksDivider);
 
     return ticks;
 }
 
 uint64_t AT91SAM9Rx64_Time_GetProcessorTicksForTime(const TinyCLR_NativeTime_Controller* self, uint64_t time) {
-    return AT91SAM9Rx64_Time_MicrosecondsToTicks(self, time / 10);
+    return AT91SAM9Rx64_Time_MicrosecondsToTicks(self, TimeDivider_Divide(time, timeTenDivider));
 }
 
 uint64_t AT91SAM9Rx64_Time_GetCurrentProcessorTime() {
@@ -451,7 +456,7 @@ void AT91SAM9Rx64_Time_Delay(const TinyCLR_NativeTime_Controller* self, uint64_t
     // iterations must be signed so that negative iterations will result in the minimum delay
 
     microseconds *= ((AT91SAM9Rx64_AHB_CLOCK_HZ / 2) / CLOCK_COMMON_FACTOR);
-    microseconds /= (1000000 / CLOCK_COMMON_FACTOR);
+    microseconds = TimeDivider_Divide(microseconds, timeDelayDivider);
 
     // iterations is equal to the number of CPU instruction cycles in the required time minus
     // overhead cycles required to call this subroutine.
@@ -462,7 +467,7 @@ void AT91SAM9Rx64_Time_Delay(const TinyCLR_NativeTime_Controller* self, uint64_t
 void AT91SAM9Rx64_Time_DelayNative(const TinyCLR_NativeTime_Controller* self, uint64_t nativeTime) {
     //TODO do inline later, don't call out to Delay
 
-    auto microseconds = AT91SAM9Rx64_Time_GetTimeForProcessorTicks(self, nativeTime) / 10;
+    auto microseconds = TimeDivider_Divide(AT91SAM9Rx64_Time_GetTimeForProcessorTicks(self, nativeTime), timeTenDivider);
 
     AT91SAM9Rx64_Time_Delay(self, microseconds);
 }
@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include "AT91SAM9X35.h"
+#include "../../Drivers/Display/Display.h"
 
 #ifdef INCLUDE_DISPLAY
 
@@ -234,6 +235,17 @@ struct AT91SAM9X35_LCDC {
 #define LCDC_LCDSR_DISPSTS (0x1u << 2) /**< \brief (LCDC_LCDSR) LCD Controller DISP Signal Status */
 #define LCDC_LCDSR_PWMSTS (0x1u << 3) /**< \brief (LCDC_LCDSR) LCD Controller PWM Signal Status */
 #define LCDC_LCDSR_SIPSTS (0x1u << 4) /**< \brief (LCDC_LCDSR) Synchronization In Progress */
+/* -------- LCDC_LCDIER : (LCDC Offset: 0x0000002C) LCD Controller Interrupt Enable Register -------- */
+#define LCDC_LCDIER_BASEIE (0x1u << 8) /**< \brief (LCDC_LCDIER) Base Layer Interrupt Enable */
+/* -------- LCDC_LCDISR : (LCDC Offset: 0x00000038) LCD Controller Interrupt Status Register -------- */
+#define LCDC_LCDISR_BASE (0x1u << 8) /**< \brief (LCDC_LCDISR) Base Layer Raw Interrupt Status */
+/* -------- LCDC_BASEIER : (LCDC Offset: 0x0000004C) Base Layer Interrupt Enable Register -------- */
+#define LCDC_BASEIER_DSCR (0x1u << 3) /**< \brief (LCDC_BASEIER) Descriptor Loaded Interrupt Enable */
+/* -------- LCDC_BASEISR : (LCDC Offset: 0x00000058) Base Layer Interrupt Status Register -------- */
+#define LCDC_BASEISR_DSCR (0x1u << 3) /**< \brief (LCDC_BASEISR) Descriptor Loaded */
+/* -------- LCDC_BASECTRL : (LCDC Offset: 0x00000064) Base Layer Control Register -------- */
+#define LCDC_BASECTRL_DFETCH (0x1u << 0) /**< \brief (LCDC_BASECTRL) Transfer Descriptor Fetch Enable */
+#define LCDC_BASECTRL_DSCRIEN (0x1u << 3) /**< \brief (LCDC_BASECTRL) Descriptor Loaded Interrupt Enable */
 
 /** Frequency of the board main oscillator */
 #define BOARD_MAINOSC           12000000
@@ -740,6 +752,20 @@ uint8_t m_AT91SAM9X35_Display_TextBuffer[LCD_MAX_COLUMN][LCD_MAX_ROW];
 
 AT91SAM9X35_LCD_Rotation m_AT91SAM9X35_Display_CurrentRotation = AT91SAM9X35_LCD_Rotation::rotateNormal_0;
 
+#ifndef AT91SAM9X35_DISPLAY_BUFFER_COUNT
+#define AT91SAM9X35_DISPLAY_BUFFER_COUNT 1
+#endif
+
+#define AT91SAM9X35_DISPLAY_FLIP_TIMEOUT_US 100000
+
+// With two buffers m_AT91SAM9X35_Display_VituralRam is the one being scanned out. DrawBuffer renders into the back buffer
+// and the controller picks it up through the base layer DMA descriptor at the start of the next frame.
+uint16_t* m_AT91SAM9X35_Display_BackBuffer = nullptr;
+volatile bool m_AT91SAM9X35_Display_FlipPending = false;
+
+// The back buffer holds updates drawn with the flip deferred on top of the front, the next flip shows them.
+bool m_AT91SAM9X35_Display_BackBufferAhead = false;
+
 bool AT91SAM9X35_Display_Initialize();
 bool AT91SAM9X35_Display_Uninitialize();
 bool AT91SAM9X35_Display_SetPinConfiguration(int32_t controllerIndex, bool enable);
@@ -762,6 +788,10 @@ uint32_t AT91SAM9X35_Display_GetPixelClockDivider();
 int32_t AT91SAM9X35_Display_GetOrientation();
 uint32_t* AT91SAM9X35_Display_GetFrameBuffer();
 
+void AT91SAM9X35_Display_CompleteFlip();
+void AT91SAM9X35_Display_FlipInterrupt(void* param);
+bool AT91SAM9X35_Display_WaitForFlip();
+
 #define TOTAL_DISPLAY_CONTROLLERS 1
 
 static TinyCLR_Display_Controller displayControllers[TOTAL_DISPLAY_CONTROLLERS];
@@ -877,6 +907,12 @@ bool AT91SAM9X35_Display_Initialize() {
 
     AT91SAM9X35_Display_SetBaseLayerDMA();
 
+    if (m_AT91SAM9X35_Display_BackBuffer != nullptr) {
+        lcd->LCDC_BASEIER = LCDC_BASEIER_DSCR;
+        lcd->LCDC_LCDIER = LCDC_LCDIER_BASEIE;
+
+        AT91SAM9X35_InterruptInternal_Activate(AT91C_ID_LCDC, (uint32_t*)&AT91SAM9X35_Display_FlipInterrupt, 0);
+    }
 
     AT91SAM9X35_Display_Clear();
 
@@ -888,6 +924,13 @@ bool AT91SAM9X35_Display_Uninitialize() {
 
     AT91SAM9X35_LCDC *lcd = (AT91SAM9X35_LCDC*)AT91C_BASE_LCDC;
 
+    AT91SAM9X35_InterruptInternal_Deactivate(AT91C_ID_LCDC);
+
+    lcd->LCDC_LCDIDR = 0xFFFFFFFF;
+    lcd->LCDC_BASEIDR = 0xFFFFFFFF;
+
+    m_AT91SAM9X35_Display_FlipPending = false;
+
     lcd->LCDC_LCDEN &= ~(LCDC_LCDEN_CLKEN | LCDC_LCDEN_PWMEN);
 
     pmc.DisablePeriphClock(AT91C_ID_LCDC);
@@ -897,6 +940,63 @@ bool AT91SAM9X35_Display_Uninitialize() {
     return true;
 }
 
+//====================================================
+void AT91SAM9X35_Display_CompleteFlip() {
+    auto front = m_AT91SAM9X35_Display_VituralRam;
+
+    m_AT91SAM9X35_Display_VituralRam = m_AT91SAM9X35_Display_BackBuffer;
+    m_AT91SAM9X35_Display_BackBuffer = front;
+    m_AT91SAM9X35_Display_FlipPending = false;
+}
+
+void AT91SAM9X35_Display_FlipInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    AT91SAM9X35_LCDC *lcd = (AT91SAM9X35_LCDC*)AT91C_BASE_LCDC;
+
+    if ((lcd->LCDC_LCDISR & LCDC_LCDISR_BASE) && (lcd->LCDC_BASEISR & LCDC_BASEISR_DSCR)) {
+        // The controller just loaded the descriptor that points at the back buffer, stop asking for the interrupt.
+        baseLayer.dmaD.ctrl = LCDC_BASECTRL_DFETCH;
+
+        AT91SAM9X35_Cache_FlushCaches();
+
+        if (m_AT91SAM9X35_Display_FlipPending) {
+            AT91SAM9X35_Display_CompleteFlip();
+
+            Display_RaiseFrameComplete(&displayControllers[0], AT91SAM9X35_Time_GetSystemTime(nullptr));
+        }
+    }
+}
+
+void AT91SAM9X35_Display_RequestFlip() {
+    m_AT91SAM9X35_Display_FlipPending = true;
+
+    // The base layer descriptor links to itself, so the new address is fetched at the start of the next frame.
+    baseLayer.dmaD.addr = (uint32_t)m_AT91SAM9X35_Display_BackBuffer;
+    baseLayer.dmaD.ctrl = LCDC_BASECTRL_DFETCH | LCDC_BASECTRL_DSCRIEN;
+
+    AT91SAM9X35_Cache_FlushCaches();
+}
+
+bool AT91SAM9X35_Display_WaitForFlip() {
+    for (auto i = 0; m_AT91SAM9X35_Display_FlipPending && i < AT91SAM9X35_DISPLAY_FLIP_TIMEOUT_US / 100; i++)
+        AT91SAM9X35_Time_Delay(nullptr, 100);
+
+    if (m_AT91SAM9X35_Display_FlipPending) {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        // No frame started, the descriptor already holds the back buffer so take the flip as done.
+        baseLayer.dmaD.ctrl = LCDC_BASECTRL_DFETCH;
+
+        AT91SAM9X35_Cache_FlushCaches();
+        AT91SAM9X35_Display_CompleteFlip();
+
+        return false;
+    }
+
+    return true;
+}
+
 //====================================================
 void AT91SAM9X35_Display_WriteFormattedChar(uint8_t c) {
     if (m_AT91SAM9X35_DisplayEnable == false)
@@ -1166,16 +1266,15 @@ int32_t AT91SAM9X35_Display_GetOrientation() {
 
 void AT91SAM9X35_Display_BitBltEx(int32_t x, int32_t y, int32_t width, int32_t height, uint32_t data[]) {
 
-    int32_t xTo, yTo, xFrom, yFrom;
+    int32_t yTo;
     int32_t xOffset = x;
     int32_t yOffset = y;
     uint16_t *from = (uint16_t *)data;
-    uint16_t *to = (uint16_t *)m_AT91SAM9X35_Display_VituralRam;
+    uint16_t *to = m_AT91SAM9X35_Display_BackBuffer != nullptr ? m_AT91SAM9X35_Display_BackBuffer : m_AT91SAM9X35_Display_VituralRam;
 
 
     int32_t screenWidth = m_AT91SAM9X35_DisplayWidth;
     int32_t screenHeight = m_AT91SAM9X35_DisplayHeight;
-    int32_t startPx, toAddition;
 
     if (m_AT91SAM9X35_DisplayEnable == false)
         return;
@@ -1183,7 +1282,10 @@ void AT91SAM9X35_Display_BitBltEx(int32_t x, int32_t y, int32_t width, int32_t h
     switch (m_AT91SAM9X35_Display_CurrentRotation) {
     case AT91SAM9X35_LCD_Rotation::rotateNormal_0:
 
-        if (xOffset == 0 && yOffset == 0 &&
+        if (Display_IsDamageTrackingEnabled()) {
+            Display_CopyChangedRgb565(from, width, to + yOffset * screenWidth + xOffset, screenWidth, width, height);
+        }
+        else if (xOffset == 0 && yOffset == 0 &&
             width == screenWidth && height == screenHeight) {
             memcpy(to, from, (screenWidth*screenHeight * 2));
         }
@@ -1198,70 +1300,19 @@ void AT91SAM9X35_Display_BitBltEx(int32_t x, int32_t y, int32_t width, int32_t h
 
     case AT91SAM9X35_LCD_Rotation::rotateCCW_90:
 
-        startPx = yOffset * screenHeight;
-        xFrom = xOffset + width;
-        yTo = screenHeight - xOffset - width;
-        xTo = yOffset;
-        to += yTo * screenWidth + xTo;
-        toAddition = screenWidth - height;
-
-        for (; yTo < (screenHeight - xOffset); yTo++) {
-            xFrom--;
-            yFrom = startPx + xFrom;
-
-            for (xTo = yOffset; xTo < (yOffset + height); xTo++) {
-                *to++ = from[yFrom];
-                yFrom += screenHeight;
-            }
-
-            to += toAddition;
-        }
+        Display_RotateRgb565Ccw90(from + yOffset * screenHeight + xOffset, screenHeight, to + (screenHeight - xOffset - width) * screenWidth + yOffset, screenWidth, width, height);
 
         break;
 
     case AT91SAM9X35_LCD_Rotation::rotateCW_90:
 
-        startPx = (yOffset + height - 1) * screenHeight;
-        xFrom = xOffset;
-
-        yTo = xOffset;
-        xTo = screenWidth - yOffset - height;
-        to += yTo * screenWidth + xTo;
-        toAddition = screenWidth - height;
-
-        for (; yTo < (xOffset + width); yTo++) {
-            yFrom = startPx + xFrom;
-
-            for (xTo = screenWidth - yOffset - height; xTo < (screenWidth - yOffset); xTo++) {
-                *to++ = from[yFrom];
-                yFrom -= screenHeight;
-            }
-
-            to += toAddition;
-            xFrom++;
-        }
+        Display_RotateRgb565Cw90(from + yOffset * screenHeight + xOffset, screenHeight, to + xOffset * screenWidth + (screenWidth - yOffset - height), screenWidth, width, height);
 
         break;
 
     case AT91SAM9X35_LCD_Rotation::rotate_180:
 
-        xFrom = (yOffset + height - 1) * screenWidth + xOffset + width;
-
-        yTo = screenHeight - yOffset - height;
-        xTo = screenWidth - xOffset - width;
-        to += yTo * screenWidth + xTo;
-        toAddition = screenWidth - width;
-
-        for (; yTo < (screenHeight - yOffset); yTo++) {
-
-            for (xTo = screenWidth - xOffset - width; xTo < (screenWidth - xOffset); xTo++) {
-                xFrom--;
-                *to++ = from[xFrom];
-            }
-
-            to += toAddition;
-            xFrom -= toAddition;
-        }
+        Display_RotateRgb565180(from + yOffset * screenWidth + xOffset, screenWidth, to + (screenHeight - yOffset - height) * screenWidth + (screenWidth - xOffset - width), screenWidth, width, height);
 
         break;
     }
@@ -1326,6 +1377,7 @@ TinyCLR_Result AT91SAM9X35_Display_Release(const TinyCLR_Display_Controller* sel
             memoryProvider->Free(memoryProvider, m_AT91SAM9X35_Display_buffer);
 
             m_AT91SAM9X35_Display_buffer = nullptr;
+            m_AT91SAM9X35_Display_BackBuffer = nullptr;
         }
     }
 
@@ -1393,9 +1445,12 @@ TinyCLR_Result AT91SAM9X35_Display_SetConfiguration(const TinyCLR_Display_Contro
             memoryProvider->Free(memoryProvider, m_AT91SAM9X35_Display_buffer);
 
             m_AT91SAM9X35_Display_buffer = nullptr;
+            m_AT91SAM9X35_Display_BackBuffer = nullptr;
         }
 
-        m_AT91SAM9X35_Display_buffer = (uint32_t*)memoryProvider->Allocate(memoryProvider, m_AT91SAM9X35_DisplayBufferSize + 8);
+        auto bufferStride = (m_AT91SAM9X35_DisplayBufferSize + 7) & ~7;
+
+        m_AT91SAM9X35_Display_buffer = (uint32_t*)memoryProvider->Allocate(memoryProvider, bufferStride * AT91SAM9X35_DISPLAY_BUFFER_COUNT + 8);
 
         if (m_AT91SAM9X35_Display_buffer == nullptr) {
             return TinyCLR_Result::OutOfMemory;
@@ -1403,6 +1458,10 @@ TinyCLR_Result AT91SAM9X35_Display_SetConfiguration(const TinyCLR_Display_Contro
 
         m_AT91SAM9X35_Display_VituralRam = (uint16_t*)((((uint32_t)m_AT91SAM9X35_Display_buffer) + (7)) & (~((uint32_t)(7))));
 
+        if (AT91SAM9X35_DISPLAY_BUFFER_COUNT > 1)
+            m_AT91SAM9X35_Display_BackBuffer = (uint16_t*)(((uint32_t)m_AT91SAM9X35_Display_VituralRam) + bufferStride);
+            m_AT91SAM9X35_Display_BackBufferAhead = false;
+
         // Set displayPins.enable following m_AT91SAM9X35_DisplayOutputEnableIsFixed
         if (displayPins.enable.number != PIN_NONE) {
             if (m_AT91SAM9X35_DisplayOutputEnableIsFixed) {
@@ -1450,7 +1509,27 @@ TinyCLR_Result AT91SAM9X35_Display_GetConfiguration(const TinyCLR_Display_Contro
 }
 
 TinyCLR_Result AT91SAM9X35_Display_DrawBuffer(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* data) {
+    if (m_AT91SAM9X35_Display_BackBuffer == nullptr || m_AT91SAM9X35_DisplayEnable == false) {
+        AT91SAM9X35_Display_BitBltEx(x, y, width, height, (uint32_t*)data);
+        return TinyCLR_Result::Success;
+    }
+
+    int32_t screenWidth, screenHeight;
+
+    AT91SAM9X35_Display_WaitForFlip();
+    AT91SAM9X35_Display_GetRotatedDimensions(&screenWidth, &screenHeight);
+
+    // The back buffer is one frame behind, a partial update has to start from what is on screen.
+    if (!m_AT91SAM9X35_Display_BackBufferAhead && (x != 0 || y != 0 || width != screenWidth || height != screenHeight))
+        memcpy(m_AT91SAM9X35_Display_BackBuffer, m_AT91SAM9X35_Display_VituralRam, m_AT91SAM9X35_DisplayBufferSize);
+
     AT91SAM9X35_Display_BitBltEx(x, y, width, height, (uint32_t*)data);
+
+    m_AT91SAM9X35_Display_BackBufferAhead = Display_IsFlipDeferred();
+
+    if (!m_AT91SAM9X35_Display_BackBufferAhead)
+        AT91SAM9X35_Display_RequestFlip();
+
     return TinyCLR_Result::Success;
 }
 
@@ -1460,6 +1539,8 @@ TinyCLR_Result AT91SAM9X35_Display_DrawPixel(const TinyCLR_Display_Controller* s
     if (m_AT91SAM9X35_DisplayEnable == false || x >= m_AT91SAM9X35_DisplayWidth || y >= m_AT91SAM9X35_DisplayHeight)
         return TinyCLR_Result::InvalidOperation;
 
+    AT91SAM9X35_Display_WaitForFlip();
+
     loc = m_AT91SAM9X35_Display_VituralRam + (y *m_AT91SAM9X35_DisplayWidth) + (x);
 
     *loc = static_cast<uint16_t>(color & 0xFFFF);
@@ -1468,6 +1549,8 @@ TinyCLR_Result AT91SAM9X35_Display_DrawPixel(const TinyCLR_Display_Controller* s
 }
 
 TinyCLR_Result AT91SAM9X35_Display_DrawString(const TinyCLR_Display_Controller* self, const char* data, size_t length) {
+    AT91SAM9X35_Display_WaitForFlip();
+
     for (size_t i = 0; i < length; i++)
         AT91SAM9X35_Display_WriteFormattedChar(data[i]);
 
@@ -1514,6 +1597,7 @@ void AT91SAM9X35_Display_AddApi(const TinyCLR_Api_Manager* apiManager) {
 
     displayInitializeCount = 0;
     m_AT91SAM9X35_Display_buffer = nullptr;
+    m_AT91SAM9X35_Display_BackBuffer = nullptr;
     m_AT91SAM9X35_DisplayEnable = false;
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::DisplayController, displayApi[0].Name);
@@ -1528,6 +1612,7 @@ void AT91SAM9X35_Display_Reset() {
     m_AT91SAM9X35_DisplayEnable = false;
     displayInitializeCount = 0;
     m_AT91SAM9X35_Display_buffer = nullptr;
+    m_AT91SAM9X35_Display_BackBuffer = nullptr;
 
     m_AT91SAM9X35_Display_TextRow = 0;
     m_AT91SAM9X35_Display_TextColumn = 0;
@@ -14,6 +14,8 @@
 // limitations under the License.
 
 #include "AT91SAM9X35.h"
+#include "../../Drivers/DevicesInterop/Gpio/GHIElectronics_TinyCLR_Devices_Gpio_PinGroup.h"
+#include "../../Drivers/Gpio/GpioDispatch.h"
 
 #define PIO_PPDDR(x)	(*(volatile unsigned long *)(0xFFFFF490 + (x * 0x200))) // Pull-down Disable Resistor Register -- Write Only
 #define PIO_PPDER(x)	(*(volatile unsigned long *)(0xFFFFF494 + (x * 0x200))) // Pull-down Enable Resistor Register -- Write Only
@@ -102,11 +104,15 @@ const TinyCLR_Api_Info* AT91SAM9X35_Gpio_GetRequiredApi() {
     return &gpioApi[0];
 }
 
+static const TinyCLR_Gpio_PortApi gpioPortApi = { 32, MAX_PORT, &AT91SAM9X35_Gpio_ReadPort, &AT91SAM9X35_Gpio_WritePort };
+
 void AT91SAM9X35_Gpio_AddApi(const TinyCLR_Api_Manager* apiManager) {
     AT91SAM9X35_Gpio_EnsureTableInitialized();
 
     for (auto i = 0; i < TOTAL_GPIO_CONTROLLERS; i++) {
         apiManager->Add(apiManager, &gpioApi[i]);
+
+        TinyCLR_Gpio_SetPortApi(&gpioControllers[i], &gpioPortApi);
     }
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::GpioController, AT91SAM9X35_Gpio_GetRequiredApi()->Name);
@@ -120,53 +126,43 @@ TinyCLR_Result AT91SAM9X35_Gpio_Release(const TinyCLR_Gpio_Controller* self) {
     return TinyCLR_Result::Success;
 }
 
+static void AT91SAM9X35_Gpio_PinChanged(GpioInterruptState* interruptState, uint64_t time, uint64_t systemTime) {
+    AT91SAM9X35_Gpio_Read(interruptState->controller, interruptState->pin, interruptState->currentValue); // read value as soon as possible
+
+    auto edge = interruptState->currentValue == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinChangeEdge::RisingEdge : TinyCLR_Gpio_PinChangeEdge::FallingEdge;
+    auto expectedEdgeInterger = static_cast<uint32_t>(interruptState->edge);
+    auto currentEdgeInterger = static_cast<uint32_t>(edge);
+
+    if (interruptState->handler && ((expectedEdgeInterger & currentEdgeInterger) || (expectedEdgeInterger == 0))) {
+        auto executeIsr = (time - interruptState->lastDebounceTicks) >= gpioDebounceInTicks[interruptState->pin];
+
+        interruptState->lastDebounceTicks = time;
+
+        if (executeIsr)
+            interruptState->handler(interruptState->controller, interruptState->pin, edge, systemTime);
+    }
+}
+
 void AT91SAM9X35_Gpio_InterruptHandler(void* param) {
     INTERRUPT_STARTED_SCOPED(isr);
 
     DISABLE_INTERRUPTS_SCOPED(irq);
 
+    // One timestamp for every edge handled by this entry
+    auto time = AT91SAM9X35_Time_GetTimeForProcessorTicks(nullptr, AT91SAM9X35_Time_GetCurrentProcessorTicks(nullptr));
+    auto systemTime = AT91SAM9X35_Time_GetSystemTime(nullptr);
+
     for (auto port = 0; port < MAX_PORT; port++) {
 
         AT91SAM9X35_PIO &pioX = AT91::PIO(port);
 
-        uint32_t bitMask = 0x00000001;
-        uint32_t bitIndex = 0;
-
         uint32_t interruptsActive = pioX.PIO_ISR;
 
         interruptsActive &= pioX.PIO_IMR;
 
-        while (interruptsActive) {
-            while ((interruptsActive & bitMask) == 0) {
-                bitMask <<= 1;
-                bitIndex++;
-            }
-
-            bool executeIsr = false;
-
-            GpioInterruptState* interruptState = &gpioInterruptState[bitIndex + port * 32];
-
-            AT91SAM9X35_Gpio_Read(interruptState->controller, interruptState->pin, interruptState->currentValue); // read value as soon as possible
-
-            auto edge = interruptState->currentValue == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinChangeEdge::RisingEdge : TinyCLR_Gpio_PinChangeEdge::FallingEdge;
-            auto expectedEdgeInterger = static_cast<uint32_t>(interruptState->edge);
-            auto currentEdgeInterger = static_cast<uint32_t>(edge);
-
-            if (interruptState->handler && ((expectedEdgeInterger & currentEdgeInterger) || (expectedEdgeInterger == 0))) {
-                if (interruptState->debounce) {
-                    if ((AT91SAM9X35_Time_GetTimeForProcessorTicks(nullptr, AT91SAM9X35_Time_GetCurrentProcessorTicks(nullptr)) - interruptState->lastDebounceTicks) >= gpioDebounceInTicks[interruptState->pin]) {
-                        executeIsr = true;
-                    }
-
-                    interruptState->lastDebounceTicks = AT91SAM9X35_Time_GetTimeForProcessorTicks(nullptr, AT91SAM9X35_Time_GetCurrentProcessorTicks(nullptr));
-                }
-
-                if (executeIsr)
-                    interruptState->handler(interruptState->controller, interruptState->pin, edge, AT91SAM9X35_Time_GetSystemTime(nullptr));
-            }
-
-            interruptsActive ^= bitMask;
-        }
+        GpioDispatch_Pending(interruptsActive, [&](uint32_t bitIndex) {
+            AT91SAM9X35_Gpio_PinChanged(&gpioInterruptState[bitIndex + port * 32], time, systemTime);
+        });
     }
 }
 
@@ -223,6 +219,7 @@ bool AT91SAM9X35_GpioInternal_ClosePin(int32_t pin) {
         return false;
 
     pinReserved[pin] = false;
+    pinDriveMode[pin] = TinyCLR_Gpio_PinDriveMode::Input;
 
     // reset to default interruptState
     return AT91SAM9X35_GpioInternal_ConfigurePin(pin, AT91SAM9X35_Gpio_Direction::Input, AT91SAM9X35_Gpio_PeripheralSelection::None, AT91SAM9X35_Gpio_ResistorMode::Inactive);
@@ -411,6 +408,45 @@ TinyCLR_Result AT91SAM9X35_Gpio_Write(const TinyCLR_Gpio_Controller* self, uint3
     return TinyCLR_Result::Success;
 }
 
+TinyCLR_Result AT91SAM9X35_Gpio_ReadPort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t& value) {
+    if (port >= MAX_PORT)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    AT91SAM9X35_PIO &pioX = AT91::PIO(port);
+
+    value = pioX.PIO_PDSR & mask;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result AT91SAM9X35_Gpio_WritePort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t value) {
+    if (port >= MAX_PORT)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    // Only pins opened and driven as outputs take part, anything else in the mask fails the whole write
+    for (auto pins = mask; pins; pins &= pins - 1) {
+        auto pin = port * 32 + __builtin_ctz(pins);
+
+        if (pin >= TOTAL_GPIO_PINS || !pinReserved[pin] || pinDriveMode[pin] < TinyCLR_Gpio_PinDriveMode::Output)
+            return TinyCLR_Result::InvalidOperation;
+    }
+
+    AT91SAM9X35_PIO &pioX = AT91::PIO(port);
+
+    pioX.PIO_SODR = value & mask;
+    pioX.PIO_CODR = ~value & mask;
+
+    for (auto pins = mask; pins; pins &= pins - 1) {
+        auto bit = __builtin_ctz(pins);
+        auto pin = port * 32 + bit;
+
+        if (pin < TOTAL_GPIO_PINS)
+            previousOutputValue[pin] = (value & (1u << bit)) ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
 TinyCLR_Result AT91SAM9X35_Gpio_OpenPin(const TinyCLR_Gpio_Controller* self, uint32_t pin) {
 
     DISABLE_INTERRUPTS_SCOPED(irq);
@@ -0,0 +1,163 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "AT91SAM9X35.h"
+#include "../../Drivers/DevicesInterop/Signals/GHIElectronics_TinyCLR_Devices_Signals_Capture.h"
+
+#define SIGNALS_TOTAL_CHANNELS 3
+
+// TIMER_CLOCK1 to TIMER_CLOCK4 divide MCK by 2, 8, 32 and 128
+static const uint32_t signalsClockDividers[] = { 2, 8, 32, 128 };
+
+// Every channel shares the TC0_TC1 vector with the system timer, At91TimerDriver::ISR_TIMER forwards it here
+struct SignalsCaptureState {
+    bool isActive;
+
+    const TinyCLR_Gpio_Controller* controller;
+    uint32_t channel;
+
+    uint32_t pin;
+    TinyCLR_Gpio_PinDriveMode driveMode;
+
+    uint32_t* timestamps;
+    size_t count;
+    volatile size_t captured;
+    TinyCLR_Signals_CaptureCompletedHandler completed;
+};
+
+static SignalsCaptureState signalsCaptureState;
+
+static const TinyCLR_Signals_CaptureApi signalsCaptureApi = { &AT91SAM9X35_Signals_StartCapture, &AT91SAM9X35_Signals_GetCaptureCount, &AT91SAM9X35_Signals_StopCapture };
+
+void AT91SAM9X35_Signals_AddApi(const TinyCLR_Api_Manager* apiManager) {
+#if defined(AT91SAM9X35_SIGNALS_CAPTURE_PINS)
+    TinyCLR_Signals_SetCaptureApi(reinterpret_cast<const TinyCLR_Gpio_Controller*>(AT91SAM9X35_Gpio_GetRequiredApi()->Implementation), &signalsCaptureApi);
+#endif
+}
+
+void AT91SAM9X35_Signals_CaptureInterrupt() {
+    auto& state = signalsCaptureState;
+
+    if (!state.isActive)
+        return;
+
+    AT91SAM9X35_TC &tc = AT91::TIMER(state.channel);
+
+    if ((tc.TC_SR & AT91SAM9X35_TC::TC_LDRAS) == 0)
+        return;
+
+    auto value = tc.TC_RA;
+
+    if (state.captured < state.count)
+        state.timestamps[state.captured++] = value;
+
+    if (state.captured == state.count) {
+        tc.TC_IDR = AT91SAM9X35_TC::TC_LDRAS;
+
+        if (state.completed != nullptr)
+            state.completed(state.controller, state.pin, AT91SAM9X35_Time_GetSystemTime(nullptr));
+    }
+}
+
+TinyCLR_Result AT91SAM9X35_Signals_StartCapture(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timeout, uint32_t* timestamps, size_t count, uint64_t& frequency, TinyCLR_Signals_CaptureCompletedHandler completed) {
+#if defined(AT91SAM9X35_SIGNALS_CAPTURE_PINS)
+    static const AT91SAM9X35_Gpio_Pin capturePins[SIGNALS_TOTAL_CHANNELS] = AT91SAM9X35_SIGNALS_CAPTURE_PINS;
+
+    if (signalsCaptureState.isActive || count == 0)
+        return TinyCLR_Result::NotSupported;
+
+    for (auto channel = 0; channel < SIGNALS_TOTAL_CHANNELS; channel++) {
+        if (capturePins[channel].number != pin)
+            continue;
+
+        AT91SAM9X35_TC &tc = AT91::TIMER(channel);
+
+        // channel 0 counts native time, a channel with its clock running is taken too
+        if (channel == 0 || (tc.TC_SR & AT91SAM9X35_TC::TC_CLKSTA))
+            continue;
+
+        auto divider = TinyCLR_Signals_GetCaptureDivider(timeout, AT91SAM9X35_SYSTEM_PERIPHERAL_CLOCK_HZ, 32);
+        auto clockSelection = 0;
+
+        while (clockSelection < 4 && signalsClockDividers[clockSelection] < divider)
+            clockSelection++;
+
+        if (divider == 0 || clockSelection == 4)
+            return TinyCLR_Result::NotSupported;
+
+        auto& state = signalsCaptureState;
+
+        state.channel = channel;
+        state.controller = self;
+        state.pin = pin;
+        state.driveMode = AT91SAM9X35_Gpio_GetDriveMode(self, pin);
+        state.timestamps = timestamps;
+        state.count = count;
+        state.captured = 0;
+        state.completed = completed;
+
+        auto resistorMode = AT91SAM9X35_Gpio_ResistorMode::Inactive;
+
+        if (state.driveMode == TinyCLR_Gpio_PinDriveMode::InputPullUp)
+            resistorMode = AT91SAM9X35_Gpio_ResistorMode::PullUp;
+        else if (state.driveMode == TinyCLR_Gpio_PinDriveMode::InputPullDown)
+            resistorMode = AT91SAM9X35_Gpio_ResistorMode::PullDown;
+
+        AT91SAM9X35_GpioInternal_ConfigurePin(pin, AT91SAM9X35_Gpio_Direction::Input, capturePins[channel].peripheralSelection, resistorMode);
+
+        tc.TC_CCR = AT91SAM9X35_TC::TC_CLKDIS;
+        tc.TC_IDR = 0xFFFFFFFF;
+
+        (void)tc.TC_SR;
+
+        // capture mode, RA loads on each edge of TIOA
+        tc.TC_CMR = clockSelection | AT91SAM9X35_TC::TC_LDRA_BOTH;
+
+        state.isActive = true;
+
+        tc.TC_IER = AT91SAM9X35_TC::TC_LDRAS;
+        tc.TC_CCR = (AT91SAM9X35_TC::TC_CLKEN | AT91SAM9X35_TC::TC_SWTRG);
+
+        frequency = AT91SAM9X35_SYSTEM_PERIPHERAL_CLOCK_HZ / signalsClockDividers[clockSelection];
+
+        return TinyCLR_Result::Success;
+    }
+#endif
+
+    return TinyCLR_Result::NotSupported;
+}
+
+size_t AT91SAM9X35_Signals_GetCaptureCount(const TinyCLR_Gpio_Controller* self) {
+    return signalsCaptureState.isActive ? signalsCaptureState.captured : 0;
+}
+
+size_t AT91SAM9X35_Signals_StopCapture(const TinyCLR_Gpio_Controller* self) {
+    auto& state = signalsCaptureState;
+
+    if (!state.isActive)
+        return 0;
+
+    AT91SAM9X35_TC &tc = AT91::TIMER(state.channel);
+
+    tc.TC_IDR = 0xFFFFFFFF;
+    tc.TC_CCR = AT91SAM9X35_TC::TC_CLKDIS;
+
+    (void)tc.TC_SR;
+
+    state.isActive = false;
+
+    AT91SAM9X35_Gpio_SetDriveMode(self, state.pin, state.driveMode);
+
+    return state.captured;
+}
@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include "AT91SAM9X35.h"
+#include "../../Drivers/Time/TimeDivider.h"
 
 #define TIMER_IDLE_VALUE  0x0000FFFFFFFFFFFFull
 
@@ -24,6 +25,12 @@
 #define SLOW_CLOCKS_TEN_MHZ_GCD             2
 #define SLOW_CLOCKS_MILLISECOND_GCD         2
 
+static constexpr TimeDivider timeTicksDivider = TimeDivider_Create(SLOW_CLOCKS_PER_SECOND / SLOW_CLOCKS_TEN_MHZ_GCD);
+static constexpr TimeDivider timeTenDivider = TimeDivider_Create(10);
+static constexpr TimeDivider timeMillisecondsDivider = TimeDivider_Create(1000 / SLOW_CLOCKS_MILLISECOND_GCD);
+static constexpr TimeDivider timeMicrosecondsDivider = TimeDivider_Create(1000000);
+static constexpr TimeDivider timeDelayDivider = TimeDivider_Create(1000000 / CLOCK_COMMON_FACTOR);
+
 //////////////////////////////////////////////////////////////////////////////
 // TIMER state
 //
@@ -186,6 +193,11 @@ void At91TimerDriver::ISR_TIMER(void* param) {
     if (!(timer < At91TimerDriver::c_MaxTimer))
         return;
 
+#if defined(INCLUDE_SIGNALS)
+    // the capture channels raise the same vector
+    AT91SAM9X35_Signals_CaptureInterrupt();
+#endif
+
     // Execute the ISR for the Timer
     at91TimerDriver.m_descriptors[timer].isr.Execute();
 }
@@ -286,13 +298,13 @@ uint32_t AT91SAM9X35_Time_GetTicksPerSecond(const TinyCLR_NativeTime_Controller*
 
 uint64_t AT91SAM9X35_Time_GetTimeForProcessorTicks(const TinyCLR_NativeTime_Controller* self, uint64_t ticks) {
     ticks *= (10000000 / SLOW_CLOCKS_TEN_MHZ_GCD);
-    ticks /= (SLOW_CLOCKS_PER_SECOND / SLOW_CLOCKS_TEN_MHZ_GCD);
+    ticks = TimeDivider_Divide(ticks, timeTicksDivider);
 
     return ticks;
 }
 
 uint64_t AT91SAM9X35_Time_GetProcessorTicksForTime(const TinyCLR_NativeTime_Controller* self, uint64_t time) {
-    return AT91SAM9X35_Time_MicrosecondsToTicks(self, time / 10);
+    return AT91SAM9X35_Time_MicrosecondsToTicks(self, TimeDivider_Divide(time, timeTenDivider));
 }
 
 uint64_t AT91SAM9X35_Time_GetCurrentProcessorTime() {
@@ -301,14 +313,14 @@ uint64_t AT91SAM9X35_Time_GetCurrentProcessorTime() {
 
 uint64_t AT91SAM9X35_Time_MillisecondsToTicks(const TinyCLR_NativeTime_Controller* self, uint64_t ticks) {
     ticks *= (SLOW_CLOCKS_PER_SECOND / SLOW_CLOCKS_MILLISECOND_GCD);
-    ticks /= (1000 / SLOW_CLOCKS_MILLISECOND_GCD);
+    ticks = TimeDivider_Divide(ticks, timeMillisecondsDivider);
 
     return ticks;
 }
 
 uint64_t AT91SAM9X35_Time_MicrosecondsToTicks(const TinyCLR_NativeTime_Controller* self, uint64_t microseconds) {
 #if 1000000 <= SLOW_CLOCKS_PER_SECOND
-    return (microseconds * SLOW_CLOCKS_PER_SECOND) / 1000000;
+    return TimeDivider_Divide(microseconds * SLOW_CLOCKS_PER_SECOND, timeMicrosecondsDivider);
 #else
     return microseconds / (1000000 / SLOW_CLOCKS_PER_SECOND);
 #endif
@@ -447,7 +459,7 @@ void AT91SAM9X35_Time_Delay(const TinyCLR_NativeTime_Controller* self, uint64_t
     // iterations must be signed so that negative iterations will result in the minimum delay
 
     microseconds *= ((AT91SAM9X35_AHB_CLOCK_HZ / 2) / CLOCK_COMMON_FACTOR);
-    microseconds /= (1000000 / CLOCK_COMMON_FACTOR);
+    microseconds = TimeDivider_Divide(microseconds, timeDelayDivider);
 
     // iterations is equal to the number of CPU instruction cycles in the required time minus
     // overhead cycles required to call this subroutine.
@@ -458,7 +470,7 @@ void AT91SAM9X35_Time_Delay(const TinyCLR_NativeTime_Controller* self, uint64_t
 void AT91SAM9X35_Time_DelayNative(const TinyCLR_NativeTime_Controller* self, uint64_t nativeTime) {
     //TODO do inline later, don't call out to Delay
 
-    auto microseconds = AT91SAM9X35_Time_GetTimeForProcessorTicks(self, nativeTime) / 10;
+    auto microseconds = TimeDivider_Divide(AT91SAM9X35_Time_GetTimeForProcessorTicks(self, nativeTime), timeTenDivider);
 
     AT91SAM9X35_Time_Delay(self, microseconds);
 }
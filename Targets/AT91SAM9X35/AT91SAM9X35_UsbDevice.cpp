@@ -264,6 +264,7 @@ AT91SAM9X35_UDP_ENDPOINT_ATTRIBUTE AT91SAM9X35_UsbDevice_EndpointAttr[] =
     {AT91C_UDPHS_EPT_TYPE_CTL_EPT | AT91C_UDPHS_EPT_DIR_OUT , USB_CTRL_WMAXPACKETSIZE0_EP_WRITE, false, AT91C_UDPHS_BK_NUMBER_1},
     {0                                                      , USB_BULK_WMAXPACKETSIZE_EP_WRITE , true , AT91C_UDPHS_BK_NUMBER_2},
     {0                                                      , USB_BULK_WMAXPACKETSIZE_EP_READ  , true , AT91C_UDPHS_BK_NUMBER_2},
+    {0                                                      , USB_BULK_WMAXPACKETSIZE_EP_WRITE , true , AT91C_UDPHS_BK_NUMBER_2},
 };
 
 void AT91SAM9X35_UsbDevice_ResetEvent(UsbClientState *usbClientState) {
@@ -554,21 +555,22 @@ void AT91SAM9X35_UsbDevice_TxPacket(UsbClientState* usbClientState, int32_t endp
             return;
         }
     }
-    USB_PACKET64* Packet64;
+    uint8_t* packet;
+    uint32_t size;
 
     for (;;) {
-        Packet64 = TinyCLR_UsbClient_TxDequeue(usbClientState, endpoint);
+        packet = TinyCLR_UsbClient_TxDequeue(usbClientState, endpoint, size);
 
-        if (Packet64 == nullptr || Packet64->Size > 0) {
+        if (packet == nullptr || size > 0) {
             break;
         }
     }
 
-    if (Packet64) {
+    if (packet) {
         int32_t i;
 
-        AT91SAM9X35_UsbDevice_WriteEndPoint(endpoint, Packet64->Buffer, Packet64->Size);
-        usbDeviceControllers[usbClientState->controllerIndex].txNeedZLPS[endpoint] = (Packet64->Size == USB_BULK_WMAXPACKETSIZE_EP_WRITE);
+        AT91SAM9X35_UsbDevice_WriteEndPoint(endpoint, packet, size);
+        usbDeviceControllers[usbClientState->controllerIndex].txNeedZLPS[endpoint] = (size == USB_BULK_WMAXPACKETSIZE_EP_WRITE);
     }
     else {
         // send the zero leght packet since we landed on the FIFO boundary before
@@ -638,7 +640,9 @@ void AT91SAM9X35_UsbDevice_ConfigEndPoint() {
     struct AT91SAM9X35_UDPHS *pUdp = (struct AT91SAM9X35_UDPHS *) (AT91C_BASE_UDP);
     int32_t i;
 
-    for (i = 1; i <= 2; i++) {
+    int32_t endpointCount = sizeof(AT91SAM9X35_UsbDevice_EndpointAttr) / sizeof(AT91SAM9X35_UDP_ENDPOINT_ATTRIBUTE);
+
+    for (i = 1; i < endpointCount; i++) {
         if ((AT91SAM9X35_UsbDevice_EndpointAttr[i].Dir_Type & AT91C_UDPHS_EPT_DIR_OUT) == AT91C_UDPHS_EPT_DIR_OUT) {
             pUdp->UDPHS_EPT[i].UDPHS_EPTCTLENB = AT91C_UDPHS_EPT_ENABL | AT91C_UDPHS_RX_BK_RDY;
         }
@@ -659,10 +663,26 @@ void AT91SAM9X35_UsbDevice_EndpointIsr(UsbClientState *usbClientState, uint32_t
 
     // Control Endpoint
     if (endpoint == 0) {
-        // ugly
+        // data stage of a control write, or the status stage of a control read when empty
         if (Status & AT91C_UDPHS_RX_BK_RDY) {
+            uint32_t len = ((Status & AT91C_UDPHS_BYTE_COUNT) >> 20) & 0x7FF;
+
+            if (len > 0) {
+                usbClientState->ptrData = &usbClientState->controlEndpointBuffer[0];
+                usbClientState->dataSize = AT91SAM9X35_UsbDevice_ReadEndPoint(0, usbClientState->controlEndpointBuffer, __min(len, USB_ENDPOINT_CONTROL_BUFFER_SIZE));
+            }
+
             while (pUdp->UDPHS_EPT[0].UDPHS_EPTSTA & AT91C_UDPHS_RX_BK_RDY)
                 pUdp->UDPHS_EPT[0].UDPHS_EPTCLRSTA = AT91C_UDPHS_RX_BK_RDY;
+
+            if (len > 0) {
+                pUdp->UDPHS_EPT[0].UDPHS_EPTCTLENB = AT91C_UDPHS_TX_PK_RDY;
+
+                if (TinyCLR_UsbClient_ControlOutCallback(usbClientState) == USB_STATE_STALL)
+                    AT91SAM9X35_UsbDevice_StallEndPoint(0);
+                else
+                    AT91SAM9X35_UsbDevice_ControlNext(usbClientState);
+            }
         }
 
         // set up packet receive
@@ -770,21 +790,21 @@ void AT91SAM9X35_UsbDevice_EndpointIsr(UsbClientState *usbClientState, uint32_t
             uint8_t block = len / USB_MAX_DATA_PACKET_SIZE;
             uint8_t rest = len % USB_MAX_DATA_PACKET_SIZE;
             while (block > 0) {
-                USB_PACKET64* Packet64 = TinyCLR_UsbClient_RxEnqueue(usbClientState, endpoint, DisableRx);
+                uint8_t* packet = TinyCLR_UsbClient_RxEnqueue(usbClientState, endpoint, DisableRx);
                 if (!DisableRx) {
 
-                    memcpy(&(Packet64->Buffer[0]), pDest, USB_MAX_DATA_PACKET_SIZE);
-                    Packet64->Size = USB_MAX_DATA_PACKET_SIZE;
+                    memcpy(packet, pDest, USB_MAX_DATA_PACKET_SIZE);
+                    TinyCLR_UsbClient_RxCommit(usbClientState, endpoint, USB_MAX_DATA_PACKET_SIZE);
                     pDest += USB_MAX_DATA_PACKET_SIZE;
                     block--;
                 }
             }
             if ((rest > 0) && (block == 0)) {
-                USB_PACKET64* Packet64 = TinyCLR_UsbClient_RxEnqueue(usbClientState, endpoint, DisableRx);
+                uint8_t* packet = TinyCLR_UsbClient_RxEnqueue(usbClientState, endpoint, DisableRx);
                 if (!DisableRx) {
-                    memcpy(&(Packet64->Buffer[0]), pDest, rest);
+                    memcpy(packet, pDest, rest);
                     pDest += rest;
-                    Packet64->Size = rest;
+                    TinyCLR_UsbClient_RxCommit(usbClientState, endpoint, rest);
                 }
             }
 
@@ -968,6 +988,11 @@ uint64_t TinyCLR_UsbClient_Now() {
     return AT91SAM9X35_Time_GetSystemTime(nullptr);
 }
 
+// WaitForInterrupt only lets pending interrupts run here, it doesn't sleep and the writer sees its deadline pass
+void TinyCLR_UsbClient_ScheduleWakeup(uint64_t time) {
+
+}
+
 void TinyCLR_UsbClient_InitializeConfiguration(UsbClientState *usbClientState) {
     AT91SAM9X35_UsbDevice_InitializeConfiguration(usbClientState);
 }
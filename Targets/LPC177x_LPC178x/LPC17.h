@@ -42,6 +42,9 @@ int32_t LPC17_Adc_GetMaxValue(const TinyCLR_Adc_Controller* self);
 TinyCLR_Adc_ChannelMode LPC17_Adc_GetChannelMode(const TinyCLR_Adc_Controller* self);
 TinyCLR_Result LPC17_Adc_SetChannelMode(const TinyCLR_Adc_Controller* self, TinyCLR_Adc_ChannelMode mode);
 bool LPC17_Adc_IsChannelModeSupported(const TinyCLR_Adc_Controller* self, TinyCLR_Adc_ChannelMode mode);
+TinyCLR_Result LPC17_Adc_StartStream(const TinyCLR_Adc_Controller* self, const uint32_t* channels, size_t channelCount, uint32_t frequency, uint16_t* buffer, size_t length, void(*handler)(const TinyCLR_Adc_Controller* self, uint64_t written, uint64_t timestamp));
+uint64_t LPC17_Adc_GetStreamWritten(const TinyCLR_Adc_Controller* self);
+TinyCLR_Result LPC17_Adc_StopStream(const TinyCLR_Adc_Controller* self);
 
 // CAN
 void LPC17_Can_AddApi(const TinyCLR_Api_Manager* apiManager);
@@ -85,6 +88,10 @@ uint32_t LPC17_Dac_GetChannelCount(const TinyCLR_Dac_Controller* self);
 uint32_t LPC17_Dac_GetResolutionInBits(const TinyCLR_Dac_Controller* self);
 int32_t LPC17_Dac_GetMinValue(const TinyCLR_Dac_Controller* self);
 int32_t LPC17_Dac_GetMaxValue(const TinyCLR_Dac_Controller* self);
+TinyCLR_Result LPC17_Dac_StartStream(const TinyCLR_Dac_Controller* self, uint32_t channel, uint32_t frequency, const uint32_t* buffer, size_t length, void(*handler)(const TinyCLR_Dac_Controller* self, uint32_t channel, uint64_t played, uint64_t timestamp));
+uint64_t LPC17_Dac_GetStreamPlayed(const TinyCLR_Dac_Controller* self, uint32_t channel);
+TinyCLR_Result LPC17_Dac_StopStream(const TinyCLR_Dac_Controller* self, uint32_t channel);
+void LPC17_Dac_EncodeStream(const TinyCLR_Dac_Controller* self, uint32_t channel, const int32_t* values, uint32_t* words, size_t count);
 
 // GPIO
 enum class LPC17_Gpio_Direction : uint8_t {
@@ -173,6 +180,8 @@ bool LPC17_Gpio_IsDriveModeSupported(const TinyCLR_Gpio_Controller* self, uint32
 TinyCLR_Gpio_PinDriveMode LPC17_Gpio_GetDriveMode(const TinyCLR_Gpio_Controller* self, uint32_t pin);
 uint64_t LPC17_Gpio_GetDebounceTimeout(const TinyCLR_Gpio_Controller* self, uint32_t pin);
 uint32_t LPC17_Gpio_GetPinCount(const TinyCLR_Gpio_Controller* self);
+TinyCLR_Result LPC17_Gpio_ReadPort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t& value);
+TinyCLR_Result LPC17_Gpio_WritePort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t value);
 TinyCLR_Result LPC17_Gpio_SetPinChangedHandler(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinChangeEdge edge, TinyCLR_Gpio_PinChangedHandler handler);
 TinyCLR_Result LPC17_Gpio_ClosePin(const TinyCLR_Gpio_Controller* self, uint32_t pin);
 
@@ -197,10 +206,20 @@ struct PwmState {
     TinyCLR_Pwm_PulsePolarity invert[MAX_PWM_PER_CONTROLLER];
     bool                            isOpened[MAX_PWM_PER_CONTROLLER];
 
-    double                          frequency;
-    double                          dutyCycle[MAX_PWM_PER_CONTROLLER];
+    uint64_t                        frequency; // millihertz
+    uint32_t                        period;
+    uint32_t                        dutyCycle[MAX_PWM_PER_CONTROLLER]; // parts per million
 
     uint16_t initializeCount;
+
+    bool                            burstActive;
+    bool                            burstLooped;
+    const uint32_t*                 burstPulses;
+    size_t                          burstSets;
+    size_t                          burstNext;
+    uint32_t                        burstFirstChannel;
+    uint32_t                        burstChannelCount;
+    void(*burstCompleted)(const TinyCLR_Pwm_Controller* self, uint64_t timestamp);
 };
 
 void LPC17_Pwm_AddApi(const TinyCLR_Api_Manager* apiManager);
@@ -215,6 +234,11 @@ TinyCLR_Result LPC17_Pwm_CloseChannel(const TinyCLR_Pwm_Controller* self, uint32
 TinyCLR_Result LPC17_Pwm_EnableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel);
 TinyCLR_Result LPC17_Pwm_DisableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel);
 TinyCLR_Result LPC17_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* self, uint32_t channel, double dutyCycle, TinyCLR_Pwm_PulsePolarity polarity);
+TinyCLR_Result LPC17_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Controller* self, const uint32_t* channels, const double* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count);
+TinyCLR_Result LPC17_Pwm_EncodeBurst(const TinyCLR_Pwm_Controller* self, uint32_t channel, const double* dutyCycles, uint32_t* pulses, size_t count, size_t stride);
+TinyCLR_Result LPC17_Pwm_StartBurst(const TinyCLR_Pwm_Controller* self, uint32_t firstChannel, uint32_t channelCount, const uint32_t* pulses, size_t sets, bool looped, void(*completed)(const TinyCLR_Pwm_Controller* self, uint64_t timestamp));
+bool LPC17_Pwm_IsBurstActive(const TinyCLR_Pwm_Controller* self);
+TinyCLR_Result LPC17_Pwm_StopBurst(const TinyCLR_Pwm_Controller* self);
 double LPC17_Pwm_GetMinFrequency(const TinyCLR_Pwm_Controller* self);
 double LPC17_Pwm_GetMaxFrequency(const TinyCLR_Pwm_Controller* self);
 double LPC17_Pwm_GetActualFrequency(const TinyCLR_Pwm_Controller* self);
@@ -248,6 +272,31 @@ TinyCLR_Result LPC17_SdCard_Close(const TinyCLR_Storage_Controller* self);
 
 TinyCLR_Result LPC17_SdCard_Reset();
 
+////////////////////////////////////////////////////////////////////////////////
+//Signals
+////////////////////////////////////////////////////////////////////////////////
+void LPC17_Signals_AddApi(const TinyCLR_Api_Manager* apiManager);
+TinyCLR_Result LPC17_Signals_StartCapture(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timeout, uint32_t* timestamps, size_t count, uint64_t& frequency, void(*completed)(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timestamp));
+size_t LPC17_Signals_GetCaptureCount(const TinyCLR_Gpio_Controller* self);
+size_t LPC17_Signals_StopCapture(const TinyCLR_Gpio_Controller* self);
+TinyCLR_Result LPC17_Signals_GetGeneratorTiming(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint32_t& clock, uint32_t& counterBits);
+TinyCLR_Result LPC17_Signals_StartGenerator(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinValue idleState, uint32_t divider, const uint32_t* edges, size_t count, void(*completed)(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timestamp));
+bool LPC17_Signals_IsGeneratorActive(const TinyCLR_Gpio_Controller* self);
+
+////////////////////////////////////////////////////////////////////////////////
+//Encoder
+////////////////////////////////////////////////////////////////////////////////
+struct TinyCLR_Encoder_Settings;
+struct TinyCLR_Encoder_Counter;
+
+void LPC17_Encoder_AddApi(const TinyCLR_Api_Manager* apiManager);
+uint32_t LPC17_Encoder_GetEncoderCount(const TinyCLR_Gpio_Controller* self);
+TinyCLR_Result LPC17_Encoder_Open(const TinyCLR_Gpio_Controller* self, uint32_t encoder, const TinyCLR_Encoder_Settings& settings);
+TinyCLR_Result LPC17_Encoder_Close(const TinyCLR_Gpio_Controller* self, uint32_t encoder);
+TinyCLR_Result LPC17_Encoder_Read(const TinyCLR_Gpio_Controller* self, uint32_t encoder, TinyCLR_Encoder_Counter& counter, uint64_t& timestamp);
+TinyCLR_Result LPC17_Encoder_SetPosition(const TinyCLR_Gpio_Controller* self, uint32_t encoder, int64_t position);
+void LPC17_Encoder_Reset();
+
 ////////////////////////////////////////////////////////////////////////////////
 //SPI
 ////////////////////////////////////////////////////////////////////////////////
@@ -347,6 +396,10 @@ public:
 #define DISABLE_INTERRUPTS_SCOPED(name) LPC17_DisableInterrupts_RaiiHelper name
 #define INTERRUPT_STARTED_SCOPED(name) LPC17_InterruptStarted_RaiiHelper name
 
+// Interrupt profiler: exception numbers from IPSR, DWT cycles
+#define INTERRUPT_PROFILER_VECTORS (16 + 64)
+#define INTERRUPT_PROFILER_COUNTS_PER_SECOND LPC17_SYSTEM_CLOCK_HZ
+
 bool LPC17_InterruptInternal_Activate(uint32_t index, uint32_t* isr, void* isrParam);
 bool LPC17_InterruptInternal_Deactivate(uint32_t index);
 
@@ -386,6 +439,8 @@ TinyCLR_Result LPC17_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Contr
 void LPC17_Time_Delay(const TinyCLR_NativeTime_Controller* self, uint64_t microseconds);
 void LPC17_Time_DelayNative(const TinyCLR_NativeTime_Controller* self, uint64_t nativeTime);
 uint64_t LPC17_Time_GetSystemTime(const TinyCLR_NativeTime_Controller* self);
+uint64_t LPC17_Time_GetNextTickCallbackTime();
+void LPC17_Time_ScheduleWakeup(uint64_t processorTicks);
 
 // Power
 void LPC17_Power_AddApi(const TinyCLR_Api_Manager* apiManager);
@@ -401,16 +456,17 @@ const TinyCLR_Api_Info* LPC17_UsbDevice_GetRequiredApi();
 void LPC17_UsbDevice_AddApi(const TinyCLR_Api_Manager* apiManager);
 void LPC17_UsbDevice_Reset();
 
-struct USB_PACKET64;
 struct UsbClientState;
 typedef void(*USB_NEXT_CALLBACK)(UsbClientState*);
 
 void TinyCLR_UsbClient_ClearEvent(UsbClientState *usbClientState, uint32_t event);
 void TinyCLR_UsbClient_ClearEndpoints(UsbClientState *usbClientState, int32_t endpoint);
-USB_PACKET64* TinyCLR_UsbClient_RxEnqueue(UsbClientState* usbClientState, int32_t endpoint, bool& disableRx);
-USB_PACKET64* TinyCLR_UsbClient_TxDequeue(UsbClientState* usbClientState, int32_t endpoint);
+uint8_t* TinyCLR_UsbClient_RxEnqueue(UsbClientState* usbClientState, int32_t endpoint, bool& disableRx);
+void TinyCLR_UsbClient_RxCommit(UsbClientState* usbClientState, int32_t endpoint, uint32_t size);
+uint8_t* TinyCLR_UsbClient_TxDequeue(UsbClientState* usbClientState, int32_t endpoint, uint32_t& size);
 void TinyCLR_UsbClient_StateCallback(UsbClientState* usbClientState);
 uint8_t TinyCLR_UsbClient_ControlCallback(UsbClientState* usbClientState);
+uint8_t TinyCLR_UsbClient_ControlOutCallback(UsbClientState* usbClientState);
 bool TinyCLR_UsbClient_Initialize(UsbClientState* usbClientState);
 bool TinyCLR_UsbClient_Uninitialize(UsbClientState* usbClientState);
 
@@ -504,6 +560,9 @@ extern const TinyCLR_Api_Manager* apiManager;
 #define PCONP_PCAN2_MASK 0x4000
 #define PCONP_PCAN2 0x4000
 #define PCONP_PCAN2_BIT 14
+#define PCONP_PCQEI_MASK 0x40000
+#define PCONP_PCQEI 0x40000
+#define PCONP_PCQEI_BIT 18
 #define PCONP_PCI2C1_MASK 0x80000
 #define PCONP_PCI2C1 0x80000
 #define PCONP_PCI2C1_BIT 19
@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include <LPC17.h>
+#include "../../Drivers/DevicesInterop/Adc/GHIElectronics_TinyCLR_Devices_Adc_Stream.h"
 
 
 #define AD0_BASE 0x40034000
@@ -230,6 +231,12 @@
 
 #define TOTAL_ADC_CONTROLLERS 1
 
+#define ADC_PERIPHERAL_CLOCK_HZ (LPC17_SYSTEM_CLOCK_HZ / 2)
+#define ADC_MAX_CLOCK_HZ 12400000
+#define ADC_CONVERSION_CLOCKS 31
+
+#define ADC_STREAM_EVENT_POST_DEBOUNCE_TICKS (10 * 10000) // 10ms between each events
+
 static const LPC17_Gpio_Pin adcPins[] = LPC17_ADC_PINS;
 
 static TinyCLR_Adc_Controller adcControllers[TOTAL_ADC_CONTROLLERS];
@@ -245,6 +252,36 @@ struct AdcState {
 
 static AdcState adcStates[TOTAL_ADC_CONTROLLERS];
 
+// Burst mode can't be paced by a timer, it sweeps the selected channels back to back at the slowest
+// clock that keeps up and the interrupt keeps a sweep whenever the phase crosses the requested rate.
+struct AdcStreamState {
+    bool isActive;
+
+    const TinyCLR_Adc_Controller* controller;
+    uint32_t control;
+
+    uint32_t channels[TINYCLR_ADC_STREAM_MAX_CHANNELS];
+    size_t channelCount;
+
+    uint32_t frequency;
+    uint32_t sweepFrequency;
+    uint32_t phase;
+
+    uint16_t* buffer;
+    size_t length;
+    size_t position;
+    volatile uint64_t written;
+    uint64_t reported;
+
+    TinyCLR_Adc_StreamHandler handler;
+    const TinyCLR_Task_Manager* taskManager;
+    TinyCLR_Task_Reference taskReference;
+};
+
+static AdcStreamState adcStreamState;
+
+static const TinyCLR_Adc_StreamApi adcStreamApi = { &LPC17_Adc_StartStream, &LPC17_Adc_GetStreamWritten, &LPC17_Adc_StopStream };
+
 void LPC17_Adc_AddApi(const TinyCLR_Api_Manager* apiManager) {
     for (int32_t i = 0; i < TOTAL_ADC_CONTROLLERS; i++) {
         adcControllers[i].ApiInfo = &adcApi[i];
@@ -272,6 +309,8 @@ void LPC17_Adc_AddApi(const TinyCLR_Api_Manager* apiManager) {
     }
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::AdcController, adcApi[0].Name);
+
+    TinyCLR_Adc_SetStreamApi(&adcControllers[0], &adcStreamApi);
 }
 
 TinyCLR_Result LPC17_Adc_Acquire(const TinyCLR_Adc_Controller* self) {
@@ -292,6 +331,9 @@ TinyCLR_Result LPC17_Adc_OpenChannel(const TinyCLR_Adc_Controller* self, uint32_
     if (channel >= SIZEOF_ARRAY(adcPins))
         return TinyCLR_Result::ArgumentOutOfRange;
 
+    if (adcStreamState.isActive)
+        return TinyCLR_Result::Busy;
+
     if (!LPC17_GpioInternal_OpenPin(adcPins[channel].number))
         return  TinyCLR_Result::SharingViolation;
 
@@ -314,6 +356,9 @@ TinyCLR_Result LPC17_Adc_OpenChannel(const TinyCLR_Adc_Controller* self, uint32_
 TinyCLR_Result LPC17_Adc_CloseChannel(const TinyCLR_Adc_Controller* self, uint32_t channel) {
     auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
 
+    if (adcStreamState.isActive)
+        return TinyCLR_Result::Busy;
+
     if (state->isOpen[channel]) {
         AD0CR &= ~((1 << AD0CR_BURST_BIT) | (1 << AD0CR_PDN_BIT) | (0x7 << 24));
         LPC17_GpioInternal_ClosePin(adcPins[channel].number);
@@ -332,6 +377,9 @@ TinyCLR_Result LPC17_Adc_ReadChannel(const TinyCLR_Adc_Controller* self, uint32_
 
     value = 0;
 
+    if (adcStreamState.isActive)
+        return TinyCLR_Result::Busy;
+
     // get the values
     for (auto i = 0; i < 5; i++) {
         LPC17_Time_Delay(nullptr, 5);
@@ -375,7 +423,155 @@ bool LPC17_Adc_IsChannelModeSupported(const TinyCLR_Adc_Controller* self, TinyCL
     return mode == TinyCLR_Adc_ChannelMode::SingleEnded;
 }
 
+static void LPC17_Adc_StreamInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& stream = adcStreamState;
+    uint16_t values[TINYCLR_ADC_STREAM_MAX_CHANNELS];
+
+    // reading the data registers clears DONE and with it the interrupt of the last channel swept
+    for (auto i = 0; i < stream.channelCount; i++)
+        values[i] = ((*((uint32_t*)(LPC17_ADC_BASE)+stream.channels[i])) >> LPC17xx_ADC_DataRegisterShiftBits) & LPC17xx_ADC_BitRegisterMask;
+
+    stream.phase += stream.frequency;
+
+    if (stream.phase < stream.sweepFrequency)
+        return;
+
+    stream.phase -= stream.sweepFrequency;
+
+    for (auto i = 0; i < stream.channelCount; i++)
+        stream.buffer[stream.position++] = values[i];
+
+    if (stream.position == stream.length)
+        stream.position = 0;
+
+    if (stream.position % (stream.length / 2) == 0)
+        stream.written += stream.length / 2;
+}
+
+static void LPC17_Adc_StreamCallback(const TinyCLR_Task_Manager* self, const TinyCLR_Api_Manager* apiManager, TinyCLR_Task_Reference task, void* arg) {
+    auto state = reinterpret_cast<AdcStreamState*>(arg);
+    uint64_t written = 0;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+        written = state->written;
+    }
+
+    if (written != state->reported) {
+        state->reported = written;
+        state->handler(state->controller, written, LPC17_Time_GetSystemTime(nullptr));
+    }
+
+    state->taskManager->Enqueue(state->taskManager, task, LPC17_Time_GetProcessorTicksForTime(nullptr, ADC_STREAM_EVENT_POST_DEBOUNCE_TICKS));
+}
+
+TinyCLR_Result LPC17_Adc_StartStream(const TinyCLR_Adc_Controller* self, const uint32_t* channels, size_t channelCount, uint32_t frequency, uint16_t* buffer, size_t length, TinyCLR_Adc_StreamHandler handler) {
+    auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
+    auto& stream = adcStreamState;
+
+    if (stream.isActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (channelCount == 0 || channelCount > TINYCLR_ADC_STREAM_MAX_CHANNELS || length == 0 || length % (2 * channelCount) != 0 || frequency == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    uint32_t selection = 0;
+    uint32_t last = 0;
+
+    for (auto i = 0; i < channelCount; i++) {
+        if (channels[i] >= SIZEOF_ARRAY(adcPins) || !state->isOpen[channels[i]])
+            return TinyCLR_Result::ArgumentInvalid;
+
+        selection |= 1 << channels[i];
+
+        if (channels[i] > last)
+            last = channels[i];
+    }
+
+    uint32_t conversions = 0;
+
+    for (auto sel = selection; sel != 0; sel &= sel - 1)
+        conversions++;
+
+    uint32_t minimumDivider = (ADC_PERIPHERAL_CLOCK_HZ + ADC_MAX_CLOCK_HZ - 1) / ADC_MAX_CLOCK_HZ;
+    uint32_t divider = ADC_PERIPHERAL_CLOCK_HZ / (frequency * conversions * ADC_CONVERSION_CLOCKS);
+
+    if (divider < minimumDivider)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (divider > 256)
+        divider = 256;
+
+    stream.controller = self;
+    stream.control = AD0CR;
+    stream.channelCount = channelCount;
+
+    for (auto i = 0; i < channelCount; i++)
+        stream.channels[i] = channels[i];
+
+    stream.frequency = frequency;
+    stream.sweepFrequency = ADC_PERIPHERAL_CLOCK_HZ / (divider * conversions * ADC_CONVERSION_CLOCKS);
+    stream.phase = 0;
+    stream.buffer = buffer;
+    stream.length = length;
+    stream.position = 0;
+    stream.written = 0;
+    stream.reported = 0;
+    stream.handler = handler;
+    stream.isActive = true;
+
+    if (handler != nullptr) {
+        stream.taskManager = (const TinyCLR_Task_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::TaskManager);
+        stream.taskManager->Create(stream.taskManager, LPC17_Adc_StreamCallback, (void*)&stream, false, stream.taskReference);
+        stream.taskManager->Enqueue(stream.taskManager, stream.taskReference, LPC17_Time_GetProcessorTicksForTime(nullptr, ADC_STREAM_EVENT_POST_DEBOUNCE_TICKS));
+    }
+
+    AD0INTEN = 0;
+    AD0CR = selection | ((divider - 1) << AD0CR_CLKDIV_BIT) | AD0CR_BURST | AD0CR_PDN;
+
+    LPC17_InterruptInternal_Activate(ADC_IRQn, (uint32_t*)&LPC17_Adc_StreamInterrupt, 0);
+
+    AD0INTEN = 1 << last; // burst sweeps upwards, the highest channel ends a sweep
+
+    return TinyCLR_Result::Success;
+}
+
+uint64_t LPC17_Adc_GetStreamWritten(const TinyCLR_Adc_Controller* self) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    return adcStreamState.isActive ? adcStreamState.written : 0;
+}
+
+TinyCLR_Result LPC17_Adc_StopStream(const TinyCLR_Adc_Controller* self) {
+    auto& stream = adcStreamState;
+
+    if (!stream.isActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    AD0INTEN = AD0INTEN_ADGINTEN;
+
+    LPC17_InterruptInternal_Deactivate(ADC_IRQn);
+
+    AD0CR = stream.control;
+
+    if (stream.handler != nullptr && stream.taskManager != nullptr && stream.taskReference != nullptr) {
+        stream.taskManager->Free(stream.taskManager, stream.taskReference);
+
+        stream.taskReference = nullptr;
+    }
+
+    stream.handler = nullptr;
+    stream.isActive = false;
+
+    return TinyCLR_Result::Success;
+}
+
 void LPC17_Adc_Reset() {
+    if (adcStreamState.isActive)
+        TinyCLR_Adc_StopStream(&adcControllers[0]);
+
     LPC_SC->PCONP &= ~PCONP_PCAD;
 
     for (auto c = 0; c < TOTAL_ADC_CONTROLLERS; c++) {
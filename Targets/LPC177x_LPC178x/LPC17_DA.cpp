@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include "LPC17.h"
+#include "../../Drivers/DevicesInterop/Dac/GHIElectronics_TinyCLR_Devices_Dac_Stream.h"
 
 #define DAC_BASE 0x4008C000
 
@@ -25,8 +26,23 @@
 #define DACR_BIAS 0x10000
 #define DACR_BIAS_BIT 16
 
+#define DACCTRL (*(volatile unsigned long *)0x4008C004)
+#define DACCTRL_DBLBUF_ENA 0x2
+#define DACCTRL_CNT_ENA 0x4
+#define DACCTRL_DMA_ENA 0x8
+
+#define DACCNTVAL (*(volatile unsigned long *)0x4008C008)
+
 #define LPC17_DAC_PRECISION_BITS 	10	// Number of Bits in the DAC Convertion
 #define LPC17_DAC_MAX_VALUE 	(1<<LPC17_DAC_PRECISION_BITS)
+#define LPC17_DAC_MAX_FREQUENCY 1000000
+#define LPC17_DAC_PERIPHERAL_CLOCK_HZ (LPC17_SYSTEM_CLOCK_HZ / 2)
+
+#define LPC17_DAC_DMA_REQUEST 9
+#define LPC17_DAC_DMA_CHANNEL 7
+#define LPC17_DAC_DMA_MAX_TRANSFER 0xFFF
+
+#define DAC_STREAM_EVENT_POST_DEBOUNCE_TICKS (10 * 10000) // 10ms between each events
 
 ///////////////////////////////////////////////////////////////////////////////
 #define TOTAL_DAC_CONTROLLERS 1
@@ -42,6 +58,39 @@ struct DacState {
 
 static DacState dacStates[TOTAL_DAC_CONTROLLERS];
 
+// One GPDMA linked list item per half of the ring, each loading the other, so the channel never stops
+struct DacStreamLinkedListItem {
+    uint32_t source;
+    uint32_t destination;
+    uint32_t next;
+    uint32_t control;
+};
+
+// The channel raises no interrupt, DMA_IRQn belongs to the SD card driver. Progress is read from the
+// channel's source address often enough that the ring never laps between two reads.
+struct DacStreamState {
+    bool isActive;
+
+    const TinyCLR_Dac_Controller* controller;
+    const uint32_t* buffer;
+    size_t length;
+    size_t half;
+
+    size_t index;
+    uint64_t position;
+    uint64_t reported;
+
+    DacStreamLinkedListItem items[2];
+
+    TinyCLR_Dac_StreamHandler handler;
+    const TinyCLR_Task_Manager* taskManager;
+    TinyCLR_Task_Reference taskReference;
+};
+
+static DacStreamState dacStreamState;
+
+static const TinyCLR_Dac_StreamApi dacStreamApi = { &LPC17_Dac_StartStream, &LPC17_Dac_GetStreamPlayed, &LPC17_Dac_StopStream, &LPC17_Dac_EncodeStream };
+
 const char* dacApiNames[TOTAL_DAC_CONTROLLERS] = {
     "GHIElectronics.TinyCLR.NativeApis.LPC17.DacController\\0"
 };
@@ -70,6 +119,8 @@ void LPC17_Dac_AddApi(const TinyCLR_Api_Manager* apiManager) {
     }
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::DacController, dacApi[0].Name);
+
+    TinyCLR_Dac_SetStreamApi(&dacControllers[0], &dacStreamApi);
 }
 
 TinyCLR_Result LPC17_Dac_Acquire(const TinyCLR_Dac_Controller* self) {
@@ -108,6 +159,9 @@ TinyCLR_Result LPC17_Dac_CloseChannel(const TinyCLR_Dac_Controller* self, uint32
     if (channel >= SIZEOF_ARRAY(dacPins))
         return TinyCLR_Result::ArgumentOutOfRange;
 
+    if (dacStreamState.isActive)
+        return TinyCLR_Result::Busy;
+
     auto state = reinterpret_cast<DacState*>(self->ApiInfo->State);
 
     if (state->isOpened[channel]) {
@@ -125,6 +179,9 @@ TinyCLR_Result LPC17_Dac_WriteValue(const TinyCLR_Dac_Controller* self, uint32_t
     if (channel >= SIZEOF_ARRAY(dacPins))
         return TinyCLR_Result::ArgumentOutOfRange;
 
+    if (dacStreamState.isActive)
+        return TinyCLR_Result::Busy;
+
     if (value > LPC17_DAC_MAX_VALUE) {
         value = LPC17_DAC_MAX_VALUE;
     }
@@ -154,7 +211,140 @@ int32_t LPC17_Dac_GetMaxValue(const TinyCLR_Dac_Controller* self) {
     return ((1 << LPC17_DAC_PRECISION_BITS) - 1);
 }
 
+static LPC_GPDMACH_TypeDef* LPC17_Dac_GetStreamChannel() {
+    return reinterpret_cast<LPC_GPDMACH_TypeDef*>(LPC_GPDMACH0_BASE + 0x20 * LPC17_DAC_DMA_CHANNEL);
+}
+
+static uint64_t LPC17_Dac_UpdateStreamPosition(DacStreamState& stream) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    // the source address moves on as each word is read, it points past the ring as a wrap reloads
+    auto index = ((LPC17_Dac_GetStreamChannel()->CSrcAddr - reinterpret_cast<uint32_t>(stream.buffer)) / sizeof(uint32_t)) % stream.length;
+
+    stream.position += (index + stream.length - stream.index) % stream.length;
+    stream.index = index;
+
+    return stream.position / stream.half * stream.half;
+}
+
+static void LPC17_Dac_StreamCallback(const TinyCLR_Task_Manager* self, const TinyCLR_Api_Manager* apiManager, TinyCLR_Task_Reference task, void* arg) {
+    auto state = reinterpret_cast<DacStreamState*>(arg);
+    auto played = LPC17_Dac_UpdateStreamPosition(*state);
+
+    if (played != state->reported) {
+        state->reported = played;
+        state->handler(state->controller, 0, played, LPC17_Time_GetSystemTime(nullptr));
+    }
+
+    state->taskManager->Enqueue(state->taskManager, task, LPC17_Time_GetProcessorTicksForTime(nullptr, DAC_STREAM_EVENT_POST_DEBOUNCE_TICKS));
+}
+
+TinyCLR_Result LPC17_Dac_StartStream(const TinyCLR_Dac_Controller* self, uint32_t channel, uint32_t frequency, const uint32_t* buffer, size_t length, TinyCLR_Dac_StreamHandler handler) {
+    auto state = reinterpret_cast<DacState*>(self->ApiInfo->State);
+    auto& stream = dacStreamState;
+
+    if (channel >= SIZEOF_ARRAY(dacPins) || length < 2 || length % 2 != 0 || length / 2 > LPC17_DAC_DMA_MAX_TRANSFER || frequency == 0 || frequency > LPC17_DAC_MAX_FREQUENCY)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    uint32_t ticks = (LPC17_DAC_PERIPHERAL_CLOCK_HZ + frequency / 2) / frequency;
+
+    // DACCNTVAL is 16 bits, and a ring played faster than two task periods could lap unseen
+    if (ticks > 0x10000 || (handler != nullptr && static_cast<uint64_t>(length) * 10000000 / frequency <= 2 * DAC_STREAM_EVENT_POST_DEBOUNCE_TICKS))
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (!state->isOpened[channel] || stream.isActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto dmaChannel = LPC17_Dac_GetStreamChannel();
+
+    LPC_SC->PCONP |= PCONP_PCGPDMA;
+
+    if (LPC_GPDMA->EnbldChns & (1 << LPC17_DAC_DMA_CHANNEL))
+        return TinyCLR_Result::NotAvailable;
+
+    LPC_GPDMA->Config = 0x01;
+
+    while (!(LPC_GPDMA->Config & 0x01));
+
+    LPC_SC->DMAREQSEL &= ~(1 << LPC17_DAC_DMA_REQUEST);
+
+    stream.controller = self;
+    stream.buffer = buffer;
+    stream.length = length;
+    stream.half = length / 2;
+    stream.index = 0;
+    stream.position = 0;
+    stream.reported = 0;
+    stream.handler = handler;
+    stream.isActive = true;
+
+    // length / 2 words per item, word source and destination, source increments
+    uint32_t control = stream.half | (0x02 << 18) | (0x02 << 21) | (0x01 << 26);
+
+    for (auto i = 0; i < 2; i++) {
+        stream.items[i].source = reinterpret_cast<uint32_t>(buffer + i * stream.half);
+        stream.items[i].destination = reinterpret_cast<uint32_t>(&DACR);
+        stream.items[i].next = reinterpret_cast<uint32_t>(&stream.items[i ^ 1]);
+        stream.items[i].control = control;
+    }
+
+    LPC_GPDMA->IntTCClear = 1 << LPC17_DAC_DMA_CHANNEL;
+    LPC_GPDMA->IntErrClr = 1 << LPC17_DAC_DMA_CHANNEL;
+
+    dmaChannel->CSrcAddr = stream.items[0].source;
+    dmaChannel->CDestAddr = stream.items[0].destination;
+    dmaChannel->CLLI = stream.items[0].next;
+    dmaChannel->CControl = control;
+    dmaChannel->CConfig = (LPC17_DAC_DMA_REQUEST << 6) | (0x01 << 11) | 0x01; // memory to peripheral, enabled
+
+    // each counter timeout moves the pre-buffer to the output and requests the next word
+    DACCNTVAL = ticks - 1;
+    DACCTRL = DACCTRL_DBLBUF_ENA | DACCTRL_CNT_ENA | DACCTRL_DMA_ENA;
+
+    if (handler != nullptr) {
+        stream.taskManager = (const TinyCLR_Task_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::TaskManager);
+        stream.taskManager->Create(stream.taskManager, LPC17_Dac_StreamCallback, (void*)&stream, false, stream.taskReference);
+        stream.taskManager->Enqueue(stream.taskManager, stream.taskReference, LPC17_Time_GetProcessorTicksForTime(nullptr, DAC_STREAM_EVENT_POST_DEBOUNCE_TICKS));
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+uint64_t LPC17_Dac_GetStreamPlayed(const TinyCLR_Dac_Controller* self, uint32_t channel) {
+    return channel < SIZEOF_ARRAY(dacPins) && dacStreamState.isActive ? LPC17_Dac_UpdateStreamPosition(dacStreamState) : 0;
+}
+
+TinyCLR_Result LPC17_Dac_StopStream(const TinyCLR_Dac_Controller* self, uint32_t channel) {
+    auto& stream = dacStreamState;
+
+    if (channel >= SIZEOF_ARRAY(dacPins) || !stream.isActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    DACCTRL = 0;
+
+    LPC17_Dac_GetStreamChannel()->CConfig = 0;
+
+    if (stream.handler != nullptr && stream.taskManager != nullptr && stream.taskReference != nullptr) {
+        stream.taskManager->Free(stream.taskManager, stream.taskReference);
+
+        stream.taskReference = nullptr;
+    }
+
+    stream.handler = nullptr;
+    stream.isActive = false;
+
+    return TinyCLR_Result::Success;
+}
+
+void LPC17_Dac_EncodeStream(const TinyCLR_Dac_Controller* self, uint32_t channel, const int32_t* values, uint32_t* words, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        words[i] = (values[i] < 0 ? 0 : (values[i] >= LPC17_DAC_MAX_VALUE ? LPC17_DAC_MAX_VALUE - 1 : values[i])) << DACR_VALUE_BIT;
+}
+
 void LPC17_Dac_Reset() {
+    if (dacStreamState.isActive)
+        TinyCLR_Dac_StopStream(&dacControllers[0], 0);
+
     for (auto c = 0; c < TOTAL_DAC_CONTROLLERS; c++) {
         for (auto ch = 0; ch < LPC17_Dac_GetChannelCount(&dacControllers[c]); ch++) {
             LPC17_Dac_CloseChannel(&dacControllers[c], ch);
@@ -17,6 +17,7 @@
 #include <string.h>
 
 #include "LPC17.h"
+#include "../../Drivers/Display/Display.h"
 
 #define LCD_MAX_ROW	                32
 #define LCD_MAX_COLUMN              70
@@ -297,6 +298,9 @@ const uint8_t characters[129][5] = {
 /* LCD control watermark level is 8 or more words free bit */
 #define CLCDC_LCDCTRL_WATERMARK _BIT(16)
 
+/* LCD interrupt base address update bit */
+#define CLCDC_LCDINT_LNBU       _BIT(2)
+
 /* PINSEL11 selction for TFT 16 5:6:5 */
 #define TFT_16_565 0xB
 
@@ -376,6 +380,20 @@ uint8_t m_LPC17_Display_TextBuffer[LCD_MAX_COLUMN][LCD_MAX_ROW];
 
 LPC17xx_LCD_Rotation m_LPC17_Display_CurrentRotation = LPC17xx_LCD_Rotation::rotateNormal_0;
 
+#ifndef LPC17_DISPLAY_BUFFER_COUNT
+#define LPC17_DISPLAY_BUFFER_COUNT 1
+#endif
+
+#define LPC17_DISPLAY_FLIP_TIMEOUT_US 100000
+
+// With two buffers m_LPC17_Display_VituralRam is the one being scanned out. DrawBuffer renders into the back buffer
+// and the LCD controller picks it up from the upper panel base register at the start of the next frame.
+uint16_t* m_LPC17_Display_BackBuffer = nullptr;
+volatile bool m_LPC17_Display_FlipPending = false;
+
+// The back buffer holds updates drawn with the flip deferred on top of the front, the next flip shows them.
+bool m_LPC17_Display_BackBufferAhead = false;
+
 bool LPC17_Display_Initialize();
 bool LPC17_Display_Uninitialize();
 bool LPC17_Display_SetPinConfiguration(int32_t controllerIndex, bool enable);
@@ -398,6 +416,10 @@ uint32_t LPC17_Display_GetPixelClockDivider();
 int32_t LPC17_Display_GetOrientation();
 uint32_t* LPC17_Display_GetFrameBuffer();
 
+void LPC17_Display_CompleteFlip();
+void LPC17_Display_FlipInterrupt(void* param);
+bool LPC17_Display_WaitForFlip();
+
 #define TOTAL_DISPLAY_CONTROLLERS 1
 
 static TinyCLR_Display_Controller displayControllers[TOTAL_DISPLAY_CONTROLLERS];
@@ -455,6 +477,9 @@ bool LPC17_Display_Initialize() {
 
     LCDC.LCD_UPBASE = (uint32_t)&m_LPC17_Display_VituralRam[0];
 
+    if (m_LPC17_Display_BackBuffer != nullptr)
+        LPC17_InterruptInternal_Activate(LCD_IRQn, (uint32_t*)&LPC17_Display_FlipInterrupt, 0);
+
     LPC17_Time_Delay(nullptr, 1000 * 10);
 
     LCDC.LCD_CTRL |= 1;//enable ....also add power
@@ -474,6 +499,11 @@ bool LPC17_Display_Uninitialize() {
     if (m_LPC17_DisplayEnable == false)
         return true;
 
+    LPC17_InterruptInternal_Deactivate(LCD_IRQn);
+
+    LCDC.LCD_INTMSK = 0;
+    m_LPC17_Display_FlipPending = false;
+
     // powerdown
     LCDC.LCD_CTRL &= ~1;
     LPC17_Time_Delay(nullptr, 1000 * 10);
@@ -483,6 +513,64 @@ bool LPC17_Display_Uninitialize() {
     return true;
 }
 
+//====================================================
+// Double buffering. The upper panel base register is latched at the start of every frame, the base update interrupt
+// is only unmasked while a flip is pending and tells us the new buffer is being scanned out.
+void LPC17_Display_CompleteFlip() {
+    auto front = m_LPC17_Display_VituralRam;
+
+    m_LPC17_Display_VituralRam = m_LPC17_Display_BackBuffer;
+    m_LPC17_Display_BackBuffer = front;
+    m_LPC17_Display_FlipPending = false;
+}
+
+void LPC17_Display_FlipInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    LPC17xx_LCDC & LCDC = *(LPC17xx_LCDC *)LPC17xx_LCDC::c_LCDC_Base;
+
+    if (LCDC.LCD_INTSTAT & CLCDC_LCDINT_LNBU) {
+        LCDC.LCD_INTMSK &= ~CLCDC_LCDINT_LNBU;
+        LCDC.LCD_INTCLR = CLCDC_LCDINT_LNBU;
+
+        if (m_LPC17_Display_FlipPending) {
+            LPC17_Display_CompleteFlip();
+
+            Display_RaiseFrameComplete(&displayControllers[0], LPC17_Time_GetSystemTime(nullptr));
+        }
+    }
+}
+
+void LPC17_Display_RequestFlip() {
+    LPC17xx_LCDC & LCDC = *(LPC17xx_LCDC *)LPC17xx_LCDC::c_LCDC_Base;
+
+    m_LPC17_Display_FlipPending = true;
+
+    LCDC.LCD_UPBASE = (uint32_t)&m_LPC17_Display_BackBuffer[0];
+    LCDC.LCD_INTCLR = CLCDC_LCDINT_LNBU;
+    LCDC.LCD_INTMSK |= CLCDC_LCDINT_LNBU;
+}
+
+bool LPC17_Display_WaitForFlip() {
+    for (auto i = 0; m_LPC17_Display_FlipPending && i < LPC17_DISPLAY_FLIP_TIMEOUT_US / 100; i++)
+        LPC17_Time_Delay(nullptr, 100);
+
+    if (m_LPC17_Display_FlipPending) {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        LPC17xx_LCDC & LCDC = *(LPC17xx_LCDC *)LPC17xx_LCDC::c_LCDC_Base;
+
+        // No frame started, the base register already holds the back buffer so take the flip as done.
+        LCDC.LCD_INTMSK &= ~CLCDC_LCDINT_LNBU;
+
+        LPC17_Display_CompleteFlip();
+
+        return false;
+    }
+
+    return true;
+}
+
 //====================================================
 void LPC17_Display_WriteFormattedChar(uint8_t c) {
     if (m_LPC17_DisplayEnable == false)
@@ -749,16 +837,15 @@ int32_t LPC17_Display_GetOrientation() {
 }
 
 void LPC17_Display_BitBltEx(int32_t x, int32_t y, int32_t width, int32_t height, uint32_t data[]) {
-    int32_t xTo, yTo, xFrom, yFrom;
+    int32_t yTo;
     int32_t xOffset = x;
     int32_t yOffset = y;
     uint16_t *from = (uint16_t *)data;
-    uint16_t *to = (uint16_t *)m_LPC17_Display_VituralRam;
+    uint16_t *to = m_LPC17_Display_BackBuffer != nullptr ? m_LPC17_Display_BackBuffer : m_LPC17_Display_VituralRam;
 
 
     int32_t screenWidth = m_LPC17_DisplayWidth;
     int32_t screenHeight = m_LPC17_DisplayHeight;
-    int32_t startPx, toAddition;
 
     if (m_LPC17_DisplayEnable == false)
         return;
@@ -766,7 +853,10 @@ void LPC17_Display_BitBltEx(int32_t x, int32_t y, int32_t width, int32_t height,
     switch (m_LPC17_Display_CurrentRotation) {
     case LPC17xx_LCD_Rotation::rotateNormal_0:
 
-        if (xOffset == 0 && yOffset == 0 &&
+        if (Display_IsDamageTrackingEnabled()) {
+            Display_CopyChangedRgb565(from, width, to + yOffset * screenWidth + xOffset, screenWidth, width, height);
+        }
+        else if (xOffset == 0 && yOffset == 0 &&
             width == screenWidth && height == screenHeight) {
             memcpy(to, from, (screenWidth*screenHeight * 2));
         }
@@ -781,70 +871,19 @@ void LPC17_Display_BitBltEx(int32_t x, int32_t y, int32_t width, int32_t height,
 
     case LPC17xx_LCD_Rotation::rotateCCW_90:
 
-        startPx = yOffset * screenHeight;
-        xFrom = xOffset + width;
-        yTo = screenHeight - xOffset - width;
-        xTo = yOffset;
-        to += yTo * screenWidth + xTo;
-        toAddition = screenWidth - height;
-
-        for (; yTo < (screenHeight - xOffset); yTo++) {
-            xFrom--;
-            yFrom = startPx + xFrom;
-
-            for (xTo = yOffset; xTo < (yOffset + height); xTo++) {
-                *to++ = from[yFrom];
-                yFrom += screenHeight;
-            }
-
-            to += toAddition;
-        }
+        Display_RotateRgb565Ccw90(from + yOffset * screenHeight + xOffset, screenHeight, to + (screenHeight - xOffset - width) * screenWidth + yOffset, screenWidth, width, height);
 
         break;
 
     case LPC17xx_LCD_Rotation::rotateCW_90:
 
-        startPx = (yOffset + height - 1) * screenHeight;
-        xFrom = xOffset;
-
-        yTo = xOffset;
-        xTo = screenWidth - yOffset - height;
-        to += yTo * screenWidth + xTo;
-        toAddition = screenWidth - height;
-
-        for (; yTo < (xOffset + width); yTo++) {
-            yFrom = startPx + xFrom;
-
-            for (xTo = screenWidth - yOffset - height; xTo < (screenWidth - yOffset); xTo++) {
-                *to++ = from[yFrom];
-                yFrom -= screenHeight;
-            }
-
-            to += toAddition;
-            xFrom++;
-        }
+        Display_RotateRgb565Cw90(from + yOffset * screenHeight + xOffset, screenHeight, to + xOffset * screenWidth + (screenWidth - yOffset - height), screenWidth, width, height);
 
         break;
 
     case LPC17xx_LCD_Rotation::rotate_180:
 
-        xFrom = (yOffset + height - 1) * screenWidth + xOffset + width;
-
-        yTo = screenHeight - yOffset - height;
-        xTo = screenWidth - xOffset - width;
-        to += yTo * screenWidth + xTo;
-        toAddition = screenWidth - width;
-
-        for (; yTo < (screenHeight - yOffset); yTo++) {
-
-            for (xTo = screenWidth - xOffset - width; xTo < (screenWidth - xOffset); xTo++) {
-                xFrom--;
-                *to++ = from[xFrom];
-            }
-
-            to += toAddition;
-            xFrom -= toAddition;
-        }
+        Display_RotateRgb565180(from + yOffset * screenWidth + xOffset, screenWidth, to + (screenHeight - yOffset - height) * screenWidth + (screenWidth - xOffset - width), screenWidth, width, height);
 
         break;
     }
@@ -908,6 +947,7 @@ TinyCLR_Result LPC17_Display_Release(const TinyCLR_Display_Controller* self) {
             memoryProvider->Free(memoryProvider, m_LPC17_Display_buffer);
 
             m_LPC17_Display_buffer = nullptr;
+            m_LPC17_Display_BackBuffer = nullptr;
         }
     }
     return TinyCLR_Result::Success;
@@ -974,9 +1014,12 @@ TinyCLR_Result LPC17_Display_SetConfiguration(const TinyCLR_Display_Controller*
             memoryProvider->Free(memoryProvider, m_LPC17_Display_buffer);
 
             m_LPC17_Display_buffer = nullptr;
+            m_LPC17_Display_BackBuffer = nullptr;
         }
 
-        m_LPC17_Display_buffer = (uint32_t*)memoryProvider->Allocate(memoryProvider, m_LPC17_DisplayBufferSize + 8);
+        auto bufferStride = (m_LPC17_DisplayBufferSize + 7) & ~7;
+
+        m_LPC17_Display_buffer = (uint32_t*)memoryProvider->Allocate(memoryProvider, bufferStride * LPC17_DISPLAY_BUFFER_COUNT + 8);
 
         if (m_LPC17_Display_buffer == nullptr) {
             return TinyCLR_Result::OutOfMemory;
@@ -984,6 +1027,10 @@ TinyCLR_Result LPC17_Display_SetConfiguration(const TinyCLR_Display_Controller*
 
         m_LPC17_Display_VituralRam = (uint16_t*)((((uint32_t)m_LPC17_Display_buffer) + (7)) & (~((uint32_t)(7))));
 
+        if (LPC17_DISPLAY_BUFFER_COUNT > 1)
+            m_LPC17_Display_BackBuffer = (uint16_t*)(((uint32_t)m_LPC17_Display_VituralRam) + bufferStride);
+            m_LPC17_Display_BackBufferAhead = false;
+
         // Set displayPins.enable following m_LPC17_DisplayOutputEnableIsFixed
         if (displayPins.enable.number != PIN_NONE) {
             if (m_LPC17_DisplayOutputEnableIsFixed)
@@ -1029,7 +1076,27 @@ TinyCLR_Result LPC17_Display_GetConfiguration(const TinyCLR_Display_Controller*
 }
 
 TinyCLR_Result LPC17_Display_DrawBuffer(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* data) {
+    if (m_LPC17_Display_BackBuffer == nullptr || m_LPC17_DisplayEnable == false) {
+        LPC17_Display_BitBltEx(x, y, width, height, (uint32_t*)data);
+        return TinyCLR_Result::Success;
+    }
+
+    int32_t screenWidth, screenHeight;
+
+    LPC17_Display_WaitForFlip();
+    LPC17_Display_GetRotatedDimensions(&screenWidth, &screenHeight);
+
+    // The back buffer is one frame behind, a partial update has to start from what is on screen.
+    if (!m_LPC17_Display_BackBufferAhead && (x != 0 || y != 0 || width != screenWidth || height != screenHeight))
+        memcpy(m_LPC17_Display_BackBuffer, m_LPC17_Display_VituralRam, m_LPC17_DisplayBufferSize);
+
     LPC17_Display_BitBltEx(x, y, width, height, (uint32_t*)data);
+
+    m_LPC17_Display_BackBufferAhead = Display_IsFlipDeferred();
+
+    if (!m_LPC17_Display_BackBufferAhead)
+        LPC17_Display_RequestFlip();
+
     return TinyCLR_Result::Success;
 }
 
@@ -1039,6 +1106,8 @@ TinyCLR_Result LPC17_Display_DrawPixel(const TinyCLR_Display_Controller* self, u
     if (m_LPC17_DisplayEnable == false || x >= m_LPC17_DisplayWidth || y >= m_LPC17_DisplayHeight)
         return TinyCLR_Result::InvalidOperation;
 
+    LPC17_Display_WaitForFlip();
+
     loc = m_LPC17_Display_VituralRam + (y *m_LPC17_DisplayWidth) + (x);
 
     *loc = static_cast<uint16_t>(color & 0xFFFF);
@@ -1047,6 +1116,8 @@ TinyCLR_Result LPC17_Display_DrawPixel(const TinyCLR_Display_Controller* self, u
 }
 
 TinyCLR_Result LPC17_Display_DrawString(const TinyCLR_Display_Controller* self, const char* data, size_t length) {
+    LPC17_Display_WaitForFlip();
+
     for (size_t i = 0; i < length; i++)
         LPC17_Display_WriteFormattedChar(data[i]);
 
@@ -1093,6 +1164,7 @@ void LPC17_Display_AddApi(const TinyCLR_Api_Manager* apiManager) {
 
     displayInitializeCount = 0;
     m_LPC17_Display_buffer = nullptr;
+    m_LPC17_Display_BackBuffer = nullptr;
     m_LPC17_DisplayEnable = false;
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::DisplayController, displayApi[0].Name);
@@ -1107,6 +1179,7 @@ void LPC17_Display_Reset() {
     m_LPC17_DisplayEnable = false;
     displayInitializeCount = 0;
     m_LPC17_Display_buffer = nullptr;
+    m_LPC17_Display_BackBuffer = nullptr;
 
     m_LPC17_Display_TextRow = 0;
     m_LPC17_Display_TextColumn = 0;
@@ -0,0 +1,196 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LPC17.h"
+#include "../../Drivers/DevicesInterop/Encoder/GHIElectronics_TinyCLR_Devices_Encoder_Quadrature.h"
+
+#define ENCODER_CLOCK_HZ (LPC17_SYSTEM_CLOCK_HZ / 2)
+#define ENCODER_TOTAL_ENCODERS 1
+
+#define QEI_CON_RESP (1 << 0)
+#define QEI_CON_RESI (1 << 3)
+
+#define QEI_CONF_DIRINV (1 << 0)
+#define QEI_CONF_CAPMODE (1 << 2)
+
+#define QEI_INT_INX (1 << 0)
+#define QEI_INT_POS0 (1 << 6)
+#define QEI_INT_POINTS (0x7 << 6)
+#define QEI_INT_ALL 0xFFFF
+
+// The QEI counts PhA and PhB edges on its own. CMPOS0 to CMPOS2 hold the compare points and the index
+// interrupt latches the position.
+struct EncoderState {
+    bool isOpened;
+    bool useIndex;
+
+    TinyCLR_Encoder_Counter counter;
+};
+
+static EncoderState encoderState;
+
+static const TinyCLR_Encoder_ControllerApi encoderControllerApi = { &LPC17_Encoder_GetEncoderCount, &LPC17_Encoder_Open, &LPC17_Encoder_Close, &LPC17_Encoder_Read, &LPC17_Encoder_SetPosition };
+
+void LPC17_Encoder_AddApi(const TinyCLR_Api_Manager* apiManager) {
+#if defined(LPC17_ENCODER_PINS)
+    TinyCLR_Encoder_SetControllerApi(reinterpret_cast<const TinyCLR_Gpio_Controller*>(LPC17_Gpio_GetRequiredApi()->Implementation), &encoderControllerApi);
+#endif
+}
+
+void LPC17_Encoder_Interrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& state = encoderState;
+    auto status = LPC_QEI->INTSTAT & LPC_QEI->IE;
+
+    // flags of disarmed points are stale, they are cleared with the others
+    LPC_QEI->CLR = status | QEI_INT_POINTS;
+
+    auto raw = LPC_QEI->POS;
+
+    if (status & QEI_INT_INX)
+        TinyCLR_Encoder_Counter_LatchIndex(state.counter, raw, LPC17_Time_GetSystemTime(nullptr));
+
+    if (status & QEI_INT_POINTS) {
+        TinyCLR_Encoder_Counter_Update(state.counter, raw);
+
+        LPC_QEI->IEC = QEI_INT_POINTS;
+        LPC_QEI->IES = TinyCLR_Encoder_Counter_GetArmedPoints(state.counter, raw) * QEI_INT_POS0;
+    }
+}
+
+uint32_t LPC17_Encoder_GetEncoderCount(const TinyCLR_Gpio_Controller* self) {
+    return ENCODER_TOTAL_ENCODERS;
+}
+
+TinyCLR_Result LPC17_Encoder_Open(const TinyCLR_Gpio_Controller* self, uint32_t encoder, const TinyCLR_Encoder_Settings& settings) {
+#if defined(LPC17_ENCODER_PINS)
+    static const LPC17_Gpio_Pin encoderPins[] = LPC17_ENCODER_PINS; // PhA, PhB, index
+
+    auto& state = encoderState;
+
+    if (encoder >= ENCODER_TOTAL_ENCODERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (state.isOpened)
+        return TinyCLR_Result::SharingViolation;
+
+    state.useIndex = settings.IndexPin != TINYCLR_ENCODER_NO_INDEX;
+
+    // the index only reaches the QEI through its own pin
+    if (state.useIndex && settings.IndexPin != encoderPins[2].number)
+        return TinyCLR_Result::NotSupported;
+
+    if (!LPC17_GpioInternal_OpenMultiPins(encoderPins, state.useIndex ? 3 : 2))
+        return TinyCLR_Result::SharingViolation;
+
+    // open collector encoders only pull their outputs low
+    for (auto i = 0; i < (state.useIndex ? 3 : 2); i++)
+        LPC17_GpioInternal_ConfigurePin(encoderPins[i].number, LPC17_Gpio_Direction::Input, encoderPins[i].pinFunction, LPC17_Gpio_ResistorMode::PullUp, LPC17_Gpio_Hysteresis::Enable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+
+    TinyCLR_Encoder_Counter_Initialize(state.counter, 0xFFFFFFFF);
+
+    LPC_SC->PCONP |= PCONP_PCQEI;
+
+    LPC_QEI->IEC = QEI_INT_ALL;
+    LPC_QEI->CLR = QEI_INT_ALL;
+
+    // inputs must hold a level for FILTERx peripheral clocks
+    auto filter = static_cast<uint32_t>(static_cast<uint64_t>(settings.FilterTime) * ENCODER_CLOCK_HZ / 1000000000);
+
+    LPC_QEI->FILTERPHA = filter;
+    LPC_QEI->FILTERPHB = filter;
+    LPC_QEI->FILTERINX = filter;
+
+    LPC_QEI->CONF = QEI_CONF_CAPMODE | (settings.Reversed ? QEI_CONF_DIRINV : 0); // quadrature, edges of both phases
+    LPC_QEI->MAXPOS = state.counter.Mask;
+    LPC_QEI->CMPOS0 = TinyCLR_Encoder_Counter_GetPoint(state.counter, 0);
+    LPC_QEI->CMPOS1 = TinyCLR_Encoder_Counter_GetPoint(state.counter, 1);
+    LPC_QEI->CMPOS2 = TinyCLR_Encoder_Counter_GetPoint(state.counter, 2);
+    LPC_QEI->CON = QEI_CON_RESP | QEI_CON_RESI;
+    LPC_QEI->CLR = QEI_INT_ALL;
+
+    state.isOpened = true;
+
+    LPC17_InterruptInternal_Activate(QEI_IRQn, (uint32_t*)&LPC17_Encoder_Interrupt, 0);
+
+    LPC_QEI->IES = TinyCLR_Encoder_Counter_GetArmedPoints(state.counter, 0) * QEI_INT_POS0 | (state.useIndex ? QEI_INT_INX : 0);
+
+    return TinyCLR_Result::Success;
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+TinyCLR_Result LPC17_Encoder_Close(const TinyCLR_Gpio_Controller* self, uint32_t encoder) {
+#if defined(LPC17_ENCODER_PINS)
+    static const LPC17_Gpio_Pin encoderPins[] = LPC17_ENCODER_PINS;
+
+    auto& state = encoderState;
+
+    if (encoder >= ENCODER_TOTAL_ENCODERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (!state.isOpened)
+        return TinyCLR_Result::InvalidOperation;
+
+    LPC_QEI->IEC = QEI_INT_ALL;
+
+    LPC17_InterruptInternal_Deactivate(QEI_IRQn);
+
+    LPC_QEI->CLR = QEI_INT_ALL;
+
+    LPC_SC->PCONP &= ~PCONP_PCQEI;
+
+    for (auto i = 0; i < (state.useIndex ? 3 : 2); i++)
+        LPC17_GpioInternal_ClosePin(encoderPins[i].number);
+
+    state.isOpened = false;
+
+    return TinyCLR_Result::Success;
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+TinyCLR_Result LPC17_Encoder_Read(const TinyCLR_Gpio_Controller* self, uint32_t encoder, TinyCLR_Encoder_Counter& counter, uint64_t& timestamp) {
+    if (encoder >= ENCODER_TOTAL_ENCODERS || !encoderState.isOpened)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    counter = encoderState.counter;
+
+    TinyCLR_Encoder_Counter_Update(counter, LPC_QEI->POS);
+
+    timestamp = LPC17_Time_GetSystemTime(nullptr);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Encoder_SetPosition(const TinyCLR_Gpio_Controller* self, uint32_t encoder, int64_t position) {
+    if (encoder >= ENCODER_TOTAL_ENCODERS || !encoderState.isOpened)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    TinyCLR_Encoder_Counter_SetPosition(encoderState.counter, LPC_QEI->POS, position);
+
+    return TinyCLR_Result::Success;
+}
+
+void LPC17_Encoder_Reset() {
+    if (encoderState.isOpened)
+        LPC17_Encoder_Close(reinterpret_cast<const TinyCLR_Gpio_Controller*>(LPC17_Gpio_GetRequiredApi()->Implementation), 0);
+}
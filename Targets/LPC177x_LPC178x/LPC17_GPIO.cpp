@@ -14,6 +14,8 @@
 // limitations under the License.
 
 #include "LPC17.h"
+#include "../../Drivers/DevicesInterop/Gpio/GHIElectronics_TinyCLR_Devices_Gpio_PinGroup.h"
+#include "../../Drivers/Gpio/GpioDispatch.h"
 
 #define GET_PORT(x)                     (x / 32)
 #define GET_PIN(x)                      (x % 32)
@@ -24,6 +26,7 @@
 #define FIOSET(x)                   ((uint32_t*)(0x20098018 + (0x20 * GET_PORT(x))))
 #define FIOCLR(x)                   ((uint32_t*)(0x2009801C + (0x20 * GET_PORT(x))))
 #define FIOPIN(x)                   ((uint32_t*)(0x20098014 + (0x20 * GET_PORT(x))))
+#define FIOMASK(x)                  ((uint32_t*)(0x20098010 + (0x20 * GET_PORT(x))))
 
 #define GPIO_INT_RisingEdge(port)               ((uint32_t*)(0X40028090 + (0x10 * port)))
 #define GPIO_INT_FallingEdge(port)              ((uint32_t*)(0X40028094 + (0x10 * port)))
@@ -48,6 +51,8 @@ static const LPC17_Gpio_PinConfiguration gpioPins[] = LPC17_GPIO_PINS;
 
 #define TOTAL_GPIO_PINS SIZEOF_ARRAY(gpioPins)
 
+#define TOTAL_GPIO_PORTS ((TOTAL_GPIO_PINS + 31) / 32)
+
 #define TOTAL_GPIO_INTERRUPT_PINS TOTAL_GPIO_PINS
 
 #define DEBOUNCE_DEFAULT_TICKS     (20*10000) // 20ms in ticks
@@ -123,11 +128,15 @@ const TinyCLR_Api_Info* LPC17_Gpio_GetRequiredApi() {
     return &gpioApi[0];
 }
 
+static const TinyCLR_Gpio_PortApi gpioPortApi = { 32, TOTAL_GPIO_PORTS, &LPC17_Gpio_ReadPort, &LPC17_Gpio_WritePort };
+
 void LPC17_Gpio_AddApi(const TinyCLR_Api_Manager* apiManager) {
     LPC17_Gpio_EnsureTableInitialized();
 
     for (auto i = 0; i < TOTAL_GPIO_CONTROLLERS; i++) {
         apiManager->Add(apiManager, &gpioApi[i]);
+
+        TinyCLR_Gpio_SetPortApi(&gpioControllers[i], &gpioPortApi);
     }
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::GpioController, LPC17_Gpio_GetRequiredApi()->Name);
@@ -141,50 +150,43 @@ TinyCLR_Result LPC17_Gpio_Release(const TinyCLR_Gpio_Controller* self) {
     return TinyCLR_Result::Success;
 }
 
-void LPC17_Gpio_InterruptHandler(void* param) {
-    INTERRUPT_STARTED_SCOPED(isr);
-
-    DISABLE_INTERRUPTS_SCOPED(irq);
-
-    uint32_t* GPIO_INT_Overall_IO_Status_Register = GPIO_INT_Overall_IO_Status;
+static void LPC17_Gpio_PinChanged(GpioInterruptState* interruptState, uint64_t time, uint64_t systemTime) {
+    LPC17_Gpio_Read(interruptState->controller, interruptState->pin, interruptState->currentValue); // read value as soon as possible
 
-    bool executeIsr = false;
-
-    for (auto port = 0; port <= 2; port += 2) { // Only port 0 and port 2 support interrupts
-        auto status_mask_register = 1 << port;
+    auto edge = interruptState->currentValue == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinChangeEdge::RisingEdge : TinyCLR_Gpio_PinChangeEdge::FallingEdge;
+    auto expectedEdgeInterger = static_cast<uint32_t>(interruptState->edge);
+    auto currentEdgeInterger = static_cast<uint32_t>(edge);
 
-        uint32_t* GPIO_Port_Interrupt_ClearRegister = GPIO_INT_Clear(port);
-        uint32_t* GPIO_Port_INT_RisingEdge_Status_Register = GPIO_INT_RisingEdge_Status(port);
-        uint32_t* GPIO_Port_INT_FallingEdge_Status_Register = GPIO_INT_FallingEdge_Status(port);
+    if (interruptState->handler && ((expectedEdgeInterger & currentEdgeInterger) || (expectedEdgeInterger == 0))) {
+        auto executeIsr = (time - interruptState->lastDebounceTicks) >= gpioDebounceInTicks[interruptState->pin];
 
-        for (auto pin = 0; ((*GPIO_INT_Overall_IO_Status_Register) & status_mask_register) && (pin < 32); pin++) {
+        interruptState->lastDebounceTicks = time;
 
-            if (!(*GPIO_Port_INT_RisingEdge_Status_Register & (0x1 << pin)) && !(*GPIO_Port_INT_FallingEdge_Status_Register & (0x1 << pin))) // If this is not the Pin, skip to next pin
-                continue;
+        if (executeIsr)
+            interruptState->handler(interruptState->controller, interruptState->pin, edge, systemTime);
+    }
+}
 
-            GpioInterruptState* interruptState = &gpioInterruptState[pin + port * 32];
+void LPC17_Gpio_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
 
-            *GPIO_Port_Interrupt_ClearRegister |= (0x1 << pin); // Clear this pin's IRQ
+    DISABLE_INTERRUPTS_SCOPED(irq);
 
-            LPC17_Gpio_Read(interruptState->controller, interruptState->pin, interruptState->currentValue); // read value as soon as possible
+    // One timestamp for every edge handled by this entry
+    auto time = LPC17_Time_GetTimeForProcessorTicks(nullptr, LPC17_Time_GetCurrentProcessorTicks(nullptr));
+    auto systemTime = LPC17_Time_GetSystemTime(nullptr);
 
-            auto edge = interruptState->currentValue == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinChangeEdge::RisingEdge : TinyCLR_Gpio_PinChangeEdge::FallingEdge;
-            auto expectedEdgeInterger = static_cast<uint32_t>(interruptState->edge);
-            auto currentEdgeInterger = static_cast<uint32_t>(edge);
+    for (auto port = 0; port <= 2; port += 2) { // Only port 0 and port 2 support interrupts
+        if (!(*GPIO_INT_Overall_IO_Status & (1 << port)))
+            continue;
 
-            if (interruptState->handler && ((expectedEdgeInterger & currentEdgeInterger) || (expectedEdgeInterger == 0))) {
-                if (interruptState->debounce) {
-                    if ((LPC17_Time_GetTimeForProcessorTicks(nullptr, LPC17_Time_GetCurrentProcessorTicks(nullptr)) - interruptState->lastDebounceTicks) >= gpioDebounceInTicks[interruptState->pin]) {
-                        executeIsr = true;
-                    }
+        auto pending = *GPIO_INT_RisingEdge_Status(port) | *GPIO_INT_FallingEdge_Status(port);
 
-                    interruptState->lastDebounceTicks = LPC17_Time_GetTimeForProcessorTicks(nullptr, LPC17_Time_GetCurrentProcessorTicks(nullptr));
-                }
+        *GPIO_INT_Clear(port) = pending; // Clear all pending IRQs of this port at once
 
-                if (executeIsr)
-                    interruptState->handler(interruptState->controller, interruptState->pin, edge, LPC17_Time_GetSystemTime(nullptr));
-            }
-        }
+        GpioDispatch_Pending(pending, [&](uint32_t pin) {
+            LPC17_Gpio_PinChanged(&gpioInterruptState[pin + port * 32], time, systemTime);
+        });
     }
 }
 
@@ -249,6 +251,7 @@ bool LPC17_GpioInternal_ClosePin(int32_t pin) {
         return false;
 
     pinReserved[pin] = false;
+    pinDriveMode[pin] = TinyCLR_Gpio_PinDriveMode::Input;
 
     // reset to default interruptState
     return LPC17_GpioInternal_ConfigurePin(pin, LPC17_Gpio_Direction::Input, LPC17_Gpio_PinFunction::PinFunction0, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
@@ -402,6 +405,50 @@ TinyCLR_Result LPC17_Gpio_Write(const TinyCLR_Gpio_Controller* self, uint32_t pi
     return TinyCLR_Result::Success;
 }
 
+TinyCLR_Result LPC17_Gpio_ReadPort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t& value) {
+    if (port >= TOTAL_GPIO_PORTS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    value = *FIOPIN(port * 32) & mask;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Gpio_WritePort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t value) {
+    if (port >= TOTAL_GPIO_PORTS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    // Only pins opened and driven as outputs take part, anything else in the mask fails the whole write
+    for (auto pins = mask; pins; pins &= pins - 1) {
+        auto pin = port * 32 + __CLZ(__RBIT(pins));
+
+        if (pin >= TOTAL_GPIO_PINS || !pinReserved[pin] || pinDriveMode[pin] < TinyCLR_Gpio_PinDriveMode::Output)
+            return TinyCLR_Result::InvalidOperation;
+    }
+
+    volatile uint32_t* fioMask = FIOMASK(port * 32);
+    volatile uint32_t* fioPin = FIOPIN(port * 32);
+
+    // FIOMASK also gates FIOSET/FIOCLR, keep it masked only for the one FIOPIN store
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        *fioMask = ~mask;
+        *fioPin = value;
+        *fioMask = 0;
+    }
+
+    for (auto pins = mask; pins; pins &= pins - 1) {
+        auto bit = __CLZ(__RBIT(pins));
+        auto pin = port * 32 + bit;
+
+        if (pin < TOTAL_GPIO_PINS)
+            previousOutputValue[pin] = (value & (1u << bit)) ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
 TinyCLR_Result LPC17_Gpio_OpenPin(const TinyCLR_Gpio_Controller* self, uint32_t pin) {
     if (pin >= TOTAL_GPIO_PINS || pin < 0)
         return TinyCLR_Result::ArgumentOutOfRange;
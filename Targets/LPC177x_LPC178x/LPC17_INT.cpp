@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include "LPC17.h"
+#include "../../Drivers/InterruptProfiler/InterruptProfiler.h"
 
 #define DISABLED_MASK  0x00000001
 
@@ -108,6 +109,12 @@ TinyCLR_Result LPC17_Interrupt_Initialize(const TinyCLR_Interrupt_Controller* se
     LPC17_Interrupt_Started = onInterruptStart;
     LPC17_Interrupt_Ended = onInterruptEnd;
 
+#if defined(INTERRUPT_PROFILER)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
     return TinyCLR_Result::Success;
 }
 
@@ -137,18 +144,38 @@ bool LPC17_InterruptInternal_Deactivate(uint32_t index) {
 
     return true;
 }
+
+#if defined(INTERRUPT_PROFILER)
+uint32_t InterruptProfiler_ReadCounter() {
+    return DWT->CYCCNT;
+}
+#endif
+
+#if defined(INTERRUPT_PROFILER)
+LPC17_InterruptStarted_RaiiHelper::LPC17_InterruptStarted_RaiiHelper() { InterruptProfiler_Started(__get_IPSR()); LPC17_Interrupt_Started(); };
+LPC17_InterruptStarted_RaiiHelper::~LPC17_InterruptStarted_RaiiHelper() { LPC17_Interrupt_Ended(); InterruptProfiler_Ended(); };
+#else
 LPC17_InterruptStarted_RaiiHelper::LPC17_InterruptStarted_RaiiHelper() { LPC17_Interrupt_Started(); };
 LPC17_InterruptStarted_RaiiHelper::~LPC17_InterruptStarted_RaiiHelper() { LPC17_Interrupt_Ended(); };
+#endif
 
 LPC17_DisableInterrupts_RaiiHelper::LPC17_DisableInterrupts_RaiiHelper() {
     state = __get_PRIMASK();
 
     __disable_irq();
+
+#if defined(INTERRUPT_PROFILER)
+    if ((state & DISABLED_MASK) == 0)
+        InterruptProfiler_DisabledStarted();
+#endif
 }
 LPC17_DisableInterrupts_RaiiHelper::~LPC17_DisableInterrupts_RaiiHelper() {
     uint32_t Cp = state;
 
     if ((Cp & DISABLED_MASK) == 0) {
+#if defined(INTERRUPT_PROFILER)
+        InterruptProfiler_DisabledEnded();
+#endif
         __enable_irq();
     }
 }
@@ -164,6 +191,11 @@ void LPC17_DisableInterrupts_RaiiHelper::Acquire() {
         state = __get_PRIMASK();
 
         __disable_irq();
+
+#if defined(INTERRUPT_PROFILER)
+        if ((state & DISABLED_MASK) == 0)
+            InterruptProfiler_DisabledStarted();
+#endif
     }
 }
 
@@ -172,6 +204,9 @@ void LPC17_DisableInterrupts_RaiiHelper::Release() {
 
     if ((Cp & DISABLED_MASK) == 0) {
         state = __get_PRIMASK();
+#if defined(INTERRUPT_PROFILER)
+        InterruptProfiler_DisabledEnded();
+#endif
         __enable_irq();
     }
 }
@@ -184,22 +219,48 @@ bool LPC17_Interrupt_IsDisabled() {
 }
 
 void LPC17_Interrupt_Enable() {
+#if defined(INTERRUPT_PROFILER)
+    InterruptProfiler_DisabledEnded();
+#endif
     __enable_irq();
 }
 
 void LPC17_Interrupt_Disable() {
+#if defined(INTERRUPT_PROFILER)
+    auto state = __get_PRIMASK();
+
     __disable_irq();
+
+    if ((state & DISABLED_MASK) == 0)
+        InterruptProfiler_DisabledStarted();
+#else
+    __disable_irq();
+#endif
 }
 
 
 void LPC17_Interrupt_WaitForInterrupt() {
     register uint32_t state = __get_PRIMASK();
 
-    __enable_irq();
+#if defined(INTERRUPT_PROFILER)
+    // waiting is not time spent with interrupts disabled
+    if ((state & DISABLED_MASK) == DISABLED_MASK)
+        InterruptProfiler_DisabledEnded();
+#endif
 
-    // just to allow an interupt to an occur
+    // A pending interrupt wakes WFI with interrupts masked too, so one raised after the caller checked its flag with
+    // interrupts masked ends the sleep instead of running before it. It runs once interrupts are enabled.
+    __disable_irq();
     __WFI();
 
+    __enable_irq();
+    __ISB();
+
     // restore irq state
     __set_PRIMASK(state);
+
+#if defined(INTERRUPT_PROFILER)
+    if ((state & DISABLED_MASK) == DISABLED_MASK)
+        InterruptProfiler_DisabledStarted();
+#endif
 }
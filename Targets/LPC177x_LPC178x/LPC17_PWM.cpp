@@ -14,6 +14,8 @@
 // limitations under the License.
 
 #include "LPC17.h"
+#include "../../Drivers/DevicesInterop/Pwm/GHIElectronics_TinyCLR_Devices_Pwm_Burst.h"
+#include "../../Drivers/DevicesInterop/Pwm/GHIElectronics_TinyCLR_Devices_Pwm_Timing.h"
 
 #define PWM0_BASE 0x40014000
 
@@ -60,9 +62,15 @@
 #define PWM1LER (*(volatile unsigned long *)0x40018050)
 #define PWM1CTCR (*(volatile unsigned long *)0x40018070)
 
-#define PWM_MILLISECONDS  1000
-#define PWM_MICROSECONDS  1000000
-#define PWM_NANOSECONDS   1000000000
+#define PWM_TCR_COUNTER_ENABLE (1 << 0)
+#define PWM_TCR_COUNTER_RESET (1 << 1)
+#define PWM_TCR_PWM_ENABLE (1 << 3) // match registers are shadowed, LER latches them at the next match 0
+
+#define PWM_MCR_INTERRUPT_ON_MR0 (1 << 0)
+#define PWM_IR_MR0 (1 << 0)
+
+#define PWM_BURST_MAX_FREQUENCY 20000 // every period of a burst costs an interrupt
+
 
 const char* PwmApiNames[] = {
 #if TOTAL_PWM_CONTROLLERS > 0
@@ -78,6 +86,8 @@ static PwmState pwmStates[TOTAL_PWM_CONTROLLERS];
 static TinyCLR_Pwm_Controller pwmControllers[TOTAL_PWM_CONTROLLERS];
 static TinyCLR_Api_Info pwmApi[TOTAL_PWM_CONTROLLERS];
 
+static const TinyCLR_Pwm_BurstApi pwmBurstApi = { &LPC17_Pwm_SetPulseParametersBatch, &LPC17_Pwm_EncodeBurst, &LPC17_Pwm_StartBurst, &LPC17_Pwm_IsBurstActive, &LPC17_Pwm_StopBurst };
+
 void LPC17_Pwm_AddApi(const TinyCLR_Api_Manager* apiManager) {
     for (auto i = 0; i < TOTAL_PWM_CONTROLLERS; i++) {
         pwmControllers[i].ApiInfo = &pwmApi[i];
@@ -103,6 +113,8 @@ void LPC17_Pwm_AddApi(const TinyCLR_Api_Manager* apiManager) {
         pwmStates[i].controllerIndex = i;
 
         apiManager->Add(apiManager, &pwmApi[i]);
+
+        TinyCLR_Pwm_SetBurstApi(&pwmControllers[i], &pwmBurstApi);
     }
 }
 
@@ -121,10 +133,11 @@ TinyCLR_Result LPC17_Pwm_OpenChannel(const TinyCLR_Pwm_Controller* self, uint32_
         LPC_SC->PCONP |= PCONP_PCPWM0;
 
         // Reset Timer Counter
-        PWM0TCR |= (1 << 1);
+        PWM0TCR |= PWM_TCR_COUNTER_RESET;
         *state->matchAddress[channel] = 0;
+        PWM0LER = (1 << (state->match[channel] + 1));
         PWM0MCR = (1 << 1); // Reset on MAT0
-        PWM0TCR = 1; // Enable
+        PWM0TCR = PWM_TCR_COUNTER_ENABLE | PWM_TCR_PWM_ENABLE; // Enable
         PWM0PCR |= (1 << (9 + state->match[channel])); // To enable output on the proper channel
     }
     else if (state->channel[channel] == 1) {
@@ -133,10 +146,11 @@ TinyCLR_Result LPC17_Pwm_OpenChannel(const TinyCLR_Pwm_Controller* self, uint32_
         LPC_SC->PCONP |= PCONP_PCPWM1;
 
         // Reset Timer Counter
-        PWM1TCR |= (1 << 1);
+        PWM1TCR |= PWM_TCR_COUNTER_RESET;
         *state->matchAddress[channel] = 0;
+        PWM1LER = (1 << (state->match[channel] + 1));
         PWM1MCR = (1 << 1); // Reset on MAT0
-        PWM1TCR = 1; // Enable
+        PWM1TCR = PWM_TCR_COUNTER_ENABLE | PWM_TCR_PWM_ENABLE; // Enable
         PWM1PCR |= (1 << (9 + (state->match[channel]))); // To enable output on the proper channel
     }
 
@@ -157,83 +171,23 @@ TinyCLR_Result LPC17_Pwm_CloseChannel(const TinyCLR_Pwm_Controller* self, uint32
     return TinyCLR_Result::Success;
 }
 
-void LPC17_Pwm_GetScaleFactor(double frequency, uint32_t& period, uint32_t& scale) {
-    if (frequency >= 1000.0) {
-        period = (uint32_t)(((uint32_t)PWM_NANOSECONDS / frequency) + 0.5);
-        scale = PWM_NANOSECONDS;
-    }
-    else if (frequency >= 1.0) {
-        period = (uint32_t)(((uint32_t)PWM_MICROSECONDS / frequency) + 0.5);
-        scale = PWM_MICROSECONDS;
-    }
-    else {
-        period = (uint32_t)(((uint32_t)PWM_MILLISECONDS / frequency) + 0.5);
-        scale = PWM_MILLISECONDS;
-    }
-}
+// The counter runs at the peripheral clock without a prescaler, a period is match 0 + 1 counts
+static const TinyCLR_Pwm_Counter pwmCounter = { (LPC17_SYSTEM_CLOCK_HZ / 2), 1, false, 2, 0xFFFFFFFF };
 
 double LPC17_Pwm_GetActualFrequency(const TinyCLR_Pwm_Controller* self) {
-    uint32_t period = 0;
-    uint32_t scale = 0;
-
-    uint64_t periodInNanoSeconds = 0;
+    uint32_t prescaler;
 
     auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    double frequency = state->frequency;
-
-    LPC17_Pwm_GetScaleFactor(frequency, period, scale);
-
-    switch (scale) {
-    case PWM_MILLISECONDS:
-        periodInNanoSeconds = (period * 1000000);
-        break;
-
-    case PWM_MICROSECONDS:
-        periodInNanoSeconds = (period * 1000);
-        break;
-
-    case PWM_NANOSECONDS:
-        periodInNanoSeconds = period;
-        break;
+    if (state->frequency == 0) {
+        state->period = 0;
 
-    default:
         return 0;
     }
 
-    uint64_t periodTicks = (uint64_t)(((LPC17_SYSTEM_CLOCK_HZ / 2) / 1000000)) * periodInNanoSeconds / 1000;
-
-    // update actual period and duration, after few boudary changes base on current system clock
-    periodInNanoSeconds = ((uint64_t)(periodTicks * 1000)) / ((uint64_t)(((LPC17_SYSTEM_CLOCK_HZ / 2) / 1000000)));
-
-    // make sure out frequency <= in frequency
-    if (periodInNanoSeconds > 0) {
-        double freq_out = (double)(1000000000 / periodInNanoSeconds);
-
-        while (freq_out > frequency) {
-            periodInNanoSeconds++;
-            freq_out = (double)(1000000000 / periodInNanoSeconds);
-        }
-    }
-
-    switch (scale) {
-    case PWM_MILLISECONDS:
-        period = periodInNanoSeconds / 1000000;
-        break;
-
-    case PWM_MICROSECONDS:
-        period = periodInNanoSeconds / 1000;
-        break;
-
-    case PWM_NANOSECONDS:
-        period = periodInNanoSeconds;
-        break;
-    }
-
-    frequency = (double)(scale / period);
-
-    return frequency;
+    TinyCLR_Pwm_SolveTiming(pwmCounter, state->frequency, prescaler, state->period);
 
+    return TinyCLR_Pwm_ToFrequency(TinyCLR_Pwm_GetFrequency(pwmCounter, prescaler, state->period));
 }
 
 TinyCLR_Result LPC17_Pwm_EnableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel) {
@@ -272,116 +226,225 @@ double LPC17_Pwm_GetMinFrequency(const TinyCLR_Pwm_Controller* self) {
     return 1;
 }
 
-TinyCLR_Result LPC17_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* self, uint32_t channel, double dutyCycle, TinyCLR_Pwm_PulsePolarity polarity) {
+// Match values of a duty cycle in parts per million at the current period. A duty cycle the counter can't
+// time, or one that is always off or on, drives the pin at level instead.
+static void LPC17_Pwm_GetMatch(PwmState* state, uint32_t dutyCycle, TinyCLR_Pwm_PulsePolarity polarity, uint32_t& periodTicks, uint32_t& highTicks, bool& fixed, bool& level) {
+    auto duration = TinyCLR_Pwm_GetPulse(state->period, dutyCycle);
+
+    periodTicks = state->period > 0 ? state->period - 1 : 0;
+    highTicks = duration;
+
+    if (polarity == TinyCLR_Pwm_PulsePolarity::ActiveHigh)
+        highTicks = state->period - highTicks;
 
-    uint32_t period = 0;
-    uint32_t duration = 0;
-    uint32_t scale = 0;
+    fixed = state->period == 0 || duration == 0 || duration >= state->period;
+    level = !(state->period == 0 || duration == 0);
+}
 
-    uint32_t periodInNanoSeconds = 0;
-    uint32_t durationInNanoSeconds = 0;
+TinyCLR_Result LPC17_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* self, uint32_t channel, double dutyCycle, TinyCLR_Pwm_PulsePolarity polarity) {
+    return LPC17_Pwm_SetPulseParametersBatch(self, &channel, &dutyCycle, &polarity, 1);
+}
 
+static TinyCLR_Result LPC17_Pwm_SetPulses(const TinyCLR_Pwm_Controller* self, const uint32_t* channels, const uint32_t* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count) {
     auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    double frequency = state->frequency;
+    uint32_t periodTicks[MAX_PWM_PER_CONTROLLER];
+    uint32_t highTicks[MAX_PWM_PER_CONTROLLER];
+    bool fixed[MAX_PWM_PER_CONTROLLER];
+    bool level[MAX_PWM_PER_CONTROLLER];
 
-    LPC17_Pwm_GetScaleFactor(frequency, period, scale);
+    if (state->burstActive)
+        return TinyCLR_Result::Busy;
 
-    duration = (uint32_t)(dutyCycle * period);
+    if (count > MAX_PWM_PER_CONTROLLER)
+        return TinyCLR_Result::ArgumentOutOfRange;
 
-    // Work on actual period and duration after update.
-    // Repeat calculation again to genarate periodTicks and highTicks. LPC17 convert from period and duration to ticks.
-    switch (scale) {
-    case PWM_MILLISECONDS:
-        periodInNanoSeconds = (period * 1000000);
-        durationInNanoSeconds = (duration * 1000000);
-        break;
+    // everything is worked out before the first register changes
+    for (size_t i = 0; i < count; i++) {
+        if (channels[i] >= MAX_PWM_PER_CONTROLLER)
+            return TinyCLR_Result::ArgumentOutOfRange;
 
-    case PWM_MICROSECONDS:
-        periodInNanoSeconds = (period * 1000);
-        durationInNanoSeconds = (duration * 1000);
-        break;
+        LPC17_Pwm_GetMatch(state, dutyCycles[i], polarities[i], periodTicks[i], highTicks[i], fixed[i], level[i]);
+    }
 
-    case PWM_NANOSECONDS:
-        periodInNanoSeconds = period;
-        durationInNanoSeconds = duration;
-        break;
+    auto& matchZero = state->controllerIndex == 0 ? PWM0MR0 : PWM1MR0;
+    auto& latchEnable = state->controllerIndex == 0 ? PWM0LER : PWM1LER;
+    uint32_t latch = 0;
 
-    default:
-        return TinyCLR_Result::InvalidOperation;
+    for (size_t i = 0; i < count; i++) {
+        auto channel = channels[i];
+
+        if (fixed[i]) {
+            LPC17_GpioInternal_EnableOutputPin(state->gpioPin[channel].number, level[i]);
+            state->outputEnabled[channel] = true;
+        }
+        else {
+            // Re-scale with new frequency!
+            if (matchZero != periodTicks[i]) {
+                matchZero = periodTicks[i];
+                latch |= (1 << 0);
+            }
+
+            *state->matchAddress[channel] = highTicks[i];
+            latch |= (1 << (state->match[channel] + 1));
+        }
     }
 
-    // make sure out frequency <= in frequency
-    if (periodInNanoSeconds > 0) {
-        double freq_out = (double)(1000000000 / periodInNanoSeconds);
+    // the new period and every channel take effect together at the next match 0
+    latchEnable = latch;
+
+    for (size_t i = 0; i < count; i++) {
+        auto channel = channels[i];
+
+        if (!fixed[i] && state->outputEnabled[channel] == true) {
+            LPC17_Pwm_EnableChannel(self, channel);
 
-        while (freq_out > frequency) {
-            periodInNanoSeconds++;
-            freq_out = (double)(1000000000 / periodInNanoSeconds);
+            state->outputEnabled[channel] = false;
         }
+
+        state->invert[channel] = polarities[i];
+        state->dutyCycle[channel] = dutyCycles[i];
     }
 
-    uint32_t periodTicks = (uint64_t)(((LPC17_SYSTEM_CLOCK_HZ / 2) / 1000000)) * periodInNanoSeconds / 1000;
-    uint32_t highTicks = (uint64_t)(((LPC17_SYSTEM_CLOCK_HZ / 2) / 1000000)) * durationInNanoSeconds / 1000;
+    return TinyCLR_Result::Success;
+}
 
-    // A strange instance where if the periodInNanoSeconds would have ended in infinite 3 (calculated with float in NETMF), periodTicks are not computed correctly
-    if (0 == ((periodInNanoSeconds - 3) % 10))
-        periodTicks += 1;
+TinyCLR_Result LPC17_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Controller* self, const uint32_t* channels, const double* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count) {
+    uint32_t dutyCyclesPpm[MAX_PWM_PER_CONTROLLER];
 
-    if (0 == ((highTicks - 3) % 10))
-        highTicks += 1;
+    if (count > MAX_PWM_PER_CONTROLLER)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    for (size_t i = 0; i < count; i++)
+        dutyCyclesPpm[i] = TinyCLR_Pwm_FromDutyCycle(dutyCycles[i]);
+
+    return LPC17_Pwm_SetPulses(self, channels, dutyCyclesPpm, polarities, count);
+}
 
-    if ((int)periodTicks < 0)
-        periodTicks = 0;
+TinyCLR_Result LPC17_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Controller* self, double& frequency) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    if ((int)highTicks < 0)
-        highTicks = 0;
+    if (state->burstActive)
+        return TinyCLR_Result::Busy;
 
-    if (highTicks > periodTicks)
-        highTicks = periodTicks;
+    state->frequency = TinyCLR_Pwm_FromFrequency(frequency);
 
-    if (polarity == TinyCLR_Pwm_PulsePolarity::ActiveHigh)
-        highTicks = periodTicks - highTicks;
+    // Calculate actual frequency
+    frequency = LPC17_Pwm_GetActualFrequency(self);
 
-    if (periodInNanoSeconds == 0 || durationInNanoSeconds == 0) {
-        LPC17_GpioInternal_EnableOutputPin(state->gpioPin[channel].number, false);
-        state->outputEnabled[channel] = true;
+    uint32_t channels[MAX_PWM_PER_CONTROLLER];
+    uint32_t dutyCycles[MAX_PWM_PER_CONTROLLER];
+    TinyCLR_Pwm_PulsePolarity polarities[MAX_PWM_PER_CONTROLLER];
+    size_t count = 0;
 
-        return TinyCLR_Result::Success;
+    for (uint32_t p = 0; p < MAX_PWM_PER_CONTROLLER; p++) {
+        if (state->gpioPin[p].number != PIN_NONE) {
+            channels[count] = p;
+            dutyCycles[count] = state->dutyCycle[p];
+            polarities[count] = state->invert[p];
+            count++;
+        }
     }
-    else if (durationInNanoSeconds >= periodInNanoSeconds) {
-        LPC17_GpioInternal_EnableOutputPin(state->gpioPin[channel].number, true);
-        state->outputEnabled[channel] = true;
 
-        return TinyCLR_Result::Success;
+    if (LPC17_Pwm_SetPulses(self, channels, dutyCycles, polarities, count) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Pwm_EncodeBurst(const TinyCLR_Pwm_Controller* self, uint32_t channel, const double* dutyCycles, uint32_t* pulses, size_t count, size_t stride) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
+
+    if (channel >= MAX_PWM_PER_CONTROLLER)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t periodTicks, highTicks;
+        bool fixed, level;
+
+        LPC17_Pwm_GetMatch(state, TinyCLR_Pwm_FromDutyCycle(dutyCycles[i * stride]), state->invert[channel], periodTicks, highTicks, fixed, level);
+
+        // a match past match 0 never resets the output
+        if (fixed)
+            highTicks = level ? periodTicks + 1 : 0;
+
+        pulses[i * stride] = highTicks;
     }
-    else {
-        if (state->channel[channel] == 0) {
-            // Re-scale with new frequency!
-            if ((PWM0MR0 != periodTicks)) {
 
-                // Reset Timer Counter
-                PWM0TCR |= (1 << 1);
-                PWM0MR0 = periodTicks;
-                PWM0MCR = (1 << 1); // Reset on MAT0
-                PWM0TCR = 1; // Enable
-            }
+    return TinyCLR_Result::Success;
+}
 
-            *state->matchAddress[channel] = highTicks;
-        }
-        else if (state->channel[channel] == 1) {
-            // Re-scale with new frequency!
-            if ((PWM1MR0 != periodTicks)) {
-                // Reset Timer Counter
-                PWM1TCR |= (1 << 1);
-                PWM1MR0 = periodTicks;
-                PWM1MCR = (1 << 1); // Reset on MAT0
-                PWM1TCR = 1; // Enable
-            }
+static void LPC17_Pwm_EndBurst(PwmState* state) {
+    if (state->controllerIndex == 0)
+        PWM0MCR &= ~PWM_MCR_INTERRUPT_ON_MR0;
+    else
+        PWM1MCR &= ~PWM_MCR_INTERRUPT_ON_MR0;
+
+    LPC17_InterruptInternal_Deactivate(state->controllerIndex == 0 ? PWM0_IRQn : PWM1_IRQn);
+
+    state->burstActive = false;
+}
+
+// PWM has no DMA request, each match 0 loads the shadow registers with the next set for the period after
+static void LPC17_Pwm_BurstInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    for (auto i = 0; i < TOTAL_PWM_CONTROLLERS; i++) {
+        auto state = &pwmStates[i];
+        auto& interrupt = i == 0 ? PWM0IR : PWM1IR;
+
+        if (!state->burstActive || !(interrupt & PWM_IR_MR0))
+            continue;
+
+        interrupt = PWM_IR_MR0;
+
+        auto set = state->burstPulses + state->burstNext * state->burstChannelCount;
+        uint32_t latch = 0;
+
+        for (auto c = 0; c < state->burstChannelCount; c++) {
+            auto channel = state->burstFirstChannel + c;
 
-            *state->matchAddress[channel] = highTicks;
+            *state->matchAddress[channel] = set[c];
+            latch |= (1 << (state->match[channel] + 1));
         }
 
+        if (i == 0)
+            PWM0LER = latch;
+        else
+            PWM1LER = latch;
+
+        if (++state->burstNext < state->burstSets)
+            continue;
+
+        state->burstNext = 0;
+
+        if (state->burstLooped)
+            continue;
+
+        LPC17_Pwm_EndBurst(state);
+
+        if (state->burstCompleted != nullptr)
+            state->burstCompleted(&pwmControllers[i], LPC17_Time_GetSystemTime(nullptr));
+    }
+}
+
+TinyCLR_Result LPC17_Pwm_StartBurst(const TinyCLR_Pwm_Controller* self, uint32_t firstChannel, uint32_t channelCount, const uint32_t* pulses, size_t sets, bool looped, TinyCLR_Pwm_BurstCompletedHandler completed) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
+
+    if (channelCount == 0 || firstChannel + channelCount > MAX_PWM_PER_CONTROLLER || sets == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (state->frequency > PWM_BURST_MAX_FREQUENCY * TINYCLR_PWM_FREQUENCY_SCALE)
+        return TinyCLR_Result::NotSupported;
+
+    if (state->burstActive || state->frequency == 0)
+        return TinyCLR_Result::InvalidOperation;
+
+    // channels parked at a level go back to the PWM function
+    for (auto channel = firstChannel; channel < firstChannel + channelCount; channel++) {
+        if (state->gpioPin[channel].number == PIN_NONE || !state->isOpened[channel])
+            return TinyCLR_Result::InvalidOperation;
+
         if (state->outputEnabled[channel] == true) {
             LPC17_Pwm_EnableChannel(self, channel);
 
@@ -389,24 +452,42 @@ TinyCLR_Result LPC17_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* self,
         }
     }
 
-    state->invert[channel] = polarity;
-    state->dutyCycle[channel] = dutyCycle;
+    state->burstPulses = pulses;
+    state->burstSets = sets;
+    state->burstNext = 0;
+    state->burstFirstChannel = firstChannel;
+    state->burstChannelCount = channelCount;
+    state->burstLooped = looped;
+    state->burstCompleted = completed;
+    state->burstActive = true;
+
+    LPC17_InterruptInternal_Activate(state->controllerIndex == 0 ? PWM0_IRQn : PWM1_IRQn, (uint32_t*)&LPC17_Pwm_BurstInterrupt, 0);
+
+    if (state->controllerIndex == 0) {
+        PWM0IR = PWM_IR_MR0;
+        PWM0MCR |= PWM_MCR_INTERRUPT_ON_MR0;
+    }
+    else {
+        PWM1IR = PWM_IR_MR0;
+        PWM1MCR |= PWM_MCR_INTERRUPT_ON_MR0;
+    }
 
     return TinyCLR_Result::Success;
 }
 
-TinyCLR_Result LPC17_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Controller* self, double& frequency) {
+bool LPC17_Pwm_IsBurstActive(const TinyCLR_Pwm_Controller* self) {
     auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    state->frequency = frequency;
+    return state->burstActive;
+}
 
-    // Calculate actual frequency
-    frequency = LPC17_Pwm_GetActualFrequency(self);
+TinyCLR_Result LPC17_Pwm_StopBurst(const TinyCLR_Pwm_Controller* self) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-    for (int p = 0; p < MAX_PWM_PER_CONTROLLER; p++)
-        if (state->gpioPin[p].number != PIN_NONE)
-            if (LPC17_Pwm_SetPulseParameters(self, p, state->dutyCycle[p], state->invert[p]) != TinyCLR_Result::Success)
-                return TinyCLR_Result::InvalidOperation;
+    if (!state->burstActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    LPC17_Pwm_EndBurst(state);
 
     return TinyCLR_Result::Success;
 }
@@ -450,6 +531,9 @@ void LPC17_Pwm_Reset() {
 void LPC17_Pwm_ResetController(int32_t controllerIndex) {
     auto state = &pwmStates[controllerIndex];
 
+    if (state->burstActive)
+        LPC17_Pwm_EndBurst(state);
+
     for (int p = 0; p < MAX_PWM_PER_CONTROLLER; p++) {
         state->gpioPin[p] = LPC17_Pwm_GetPins(controllerIndex, p);
 
@@ -464,8 +548,9 @@ void LPC17_Pwm_ResetController(int32_t controllerIndex) {
 
             state->outputEnabled[p] = false;
             state->invert[p] = TinyCLR_Pwm_PulsePolarity::ActiveLow;
-            state->frequency = 0.0;
-            state->dutyCycle[p] = 0.0;
+            state->frequency = 0;
+            state->period = 0;
+            state->dutyCycle[p] = 0;
 
             if (state->isOpened[p] == true) {
                 if (controllerIndex == 0)
@@ -2389,7 +2389,8 @@ TinyCLR_Result LPC17_SdCard_Open(const TinyCLR_Storage_Controller* self) {
 TinyCLR_Result LPC17_SdCard_Close(const TinyCLR_Storage_Controller* self) {
     LPC_SC->PCONP &= ~(1 << 28); /* Disable clock to the Mci block */
 
-    LPC_SC->PCONP &= ~(1 << 29); /* Disable clock to the Dma block */
+    if (GPDMA_ENABLED_CHNS == 0) /* The DAC stream may still run on another channel */
+        LPC_SC->PCONP &= ~(1 << 29); /* Disable clock to the Dma block */
 
     LPC17_InterruptInternal_Deactivate(DMA_IRQn); /* Disable Interrupt */
 
@@ -0,0 +1,352 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LPC17.h"
+#include "../../Drivers/DevicesInterop/Signals/GHIElectronics_TinyCLR_Devices_Signals_Capture.h"
+#include "../../Drivers/DevicesInterop/Signals/GHIElectronics_TinyCLR_Devices_Signals_Generator.h"
+
+#define SIGNALS_TIMER_CLOCK_HZ (LPC17_SYSTEM_CLOCK_HZ / 2)
+#define SIGNALS_CHANNELS_PER_TIMER 2
+#define SIGNALS_TOTAL_TIMERS 4
+
+// Capture registers have no GPDMA request, each edge is stored by the timer interrupt instead
+struct SignalsCaptureState {
+    bool isActive;
+
+    const TinyCLR_Gpio_Controller* controller;
+    LPC_TIM_TypeDef* timer;
+    uint32_t timerIndex;
+    uint32_t channel;
+
+    uint32_t pin;
+    TinyCLR_Gpio_PinDriveMode driveMode;
+
+    uint32_t* timestamps;
+    size_t count;
+    volatile size_t captured;
+    TinyCLR_Signals_CaptureCompletedHandler completed;
+};
+
+// Each match toggles the MATn.x output in hardware, the match interrupt only loads the next edge
+struct SignalsGeneratorState {
+    bool isActive;
+
+    const TinyCLR_Gpio_Controller* controller;
+    LPC_TIM_TypeDef* timer;
+    uint32_t timerIndex;
+    uint32_t channel;
+
+    uint32_t pin;
+    TinyCLR_Gpio_PinValue idleState;
+    TinyCLR_Gpio_PinDriveMode driveMode;
+
+    const uint32_t* edges;
+    size_t count;
+    size_t next;
+    TinyCLR_Signals_GeneratorCompletedHandler completed;
+};
+
+static SignalsCaptureState signalsCaptureState;
+static SignalsGeneratorState signalsGeneratorState;
+
+static const uint32_t signalsTimerPowerBits[SIGNALS_TOTAL_TIMERS] = { PCONP_PCTIM0, PCONP_PCTIM1, PCONP_PCTIM2, PCONP_PCTIM3 };
+static const uint32_t signalsTimerIrqs[SIGNALS_TOTAL_TIMERS] = { TIMER0_IRQn, TIMER1_IRQn, TIMER2_IRQn, TIMER3_IRQn };
+
+static const TinyCLR_Signals_CaptureApi signalsCaptureApi = { &LPC17_Signals_StartCapture, &LPC17_Signals_GetCaptureCount, &LPC17_Signals_StopCapture };
+static const TinyCLR_Signals_GeneratorApi signalsGeneratorApi = { &LPC17_Signals_GetGeneratorTiming, &LPC17_Signals_StartGenerator, &LPC17_Signals_IsGeneratorActive };
+
+void LPC17_Signals_AddApi(const TinyCLR_Api_Manager* apiManager) {
+#if defined(LPC17_SIGNALS_CAPTURE_PINS)
+    TinyCLR_Signals_SetCaptureApi(reinterpret_cast<const TinyCLR_Gpio_Controller*>(LPC17_Gpio_GetRequiredApi()->Implementation), &signalsCaptureApi);
+#endif
+
+#if defined(LPC17_SIGNALS_GENERATOR_PINS)
+    TinyCLR_Signals_SetGeneratorApi(reinterpret_cast<const TinyCLR_Gpio_Controller*>(LPC17_Gpio_GetRequiredApi()->Implementation), &signalsGeneratorApi);
+#endif
+}
+
+static LPC_TIM_TypeDef* LPC17_Signals_GetTimer(uint32_t timerIndex) {
+    switch (timerIndex) {
+    case 0: return LPC_TIM0;
+    case 1: return LPC_TIM1;
+    case 2: return LPC_TIM2;
+    case 3: return LPC_TIM3;
+    }
+
+    return nullptr;
+}
+
+// TIMER0 and TIMER1 are powered out of reset, a running counter is what marks a timer as taken
+static bool LPC17_Signals_IsTimerInUse(uint32_t timerIndex) {
+    return (LPC_SC->PCONP & signalsTimerPowerBits[timerIndex]) && (LPC17_Signals_GetTimer(timerIndex)->TCR & 1);
+}
+
+void LPC17_Signals_CaptureInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& state = signalsCaptureState;
+    auto timer = state.timer;
+
+    timer->IR = 0x10 << state.channel; // CRx interrupt flag
+
+    auto value = state.channel == 0 ? timer->CR0 : timer->CR1;
+
+    if (state.captured < state.count)
+        state.timestamps[state.captured++] = value;
+
+    if (state.captured == state.count) {
+        timer->CCR = 0;
+
+        if (state.completed != nullptr)
+            state.completed(state.controller, state.pin, LPC17_Time_GetSystemTime(nullptr));
+    }
+}
+
+TinyCLR_Result LPC17_Signals_StartCapture(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timeout, uint32_t* timestamps, size_t count, uint64_t& frequency, TinyCLR_Signals_CaptureCompletedHandler completed) {
+#if defined(LPC17_SIGNALS_CAPTURE_PINS)
+    static const LPC17_Gpio_Pin capturePins[SIGNALS_TOTAL_TIMERS * SIGNALS_CHANNELS_PER_TIMER] = LPC17_SIGNALS_CAPTURE_PINS;
+
+    if (signalsCaptureState.isActive || count == 0)
+        return TinyCLR_Result::NotSupported;
+
+    for (auto i = 0; i < SIGNALS_TOTAL_TIMERS * SIGNALS_CHANNELS_PER_TIMER; i++) {
+        if (capturePins[i].number != pin)
+            continue;
+
+        auto timerIndex = i / SIGNALS_CHANNELS_PER_TIMER;
+        auto channel = i % SIGNALS_CHANNELS_PER_TIMER;
+
+        auto timer = LPC17_Signals_GetTimer(timerIndex);
+
+        if (LPC17_Signals_IsTimerInUse(timerIndex))
+            continue;
+
+        auto divider = TinyCLR_Signals_GetCaptureDivider(timeout, SIGNALS_TIMER_CLOCK_HZ, 32);
+
+        if (divider == 0)
+            return TinyCLR_Result::NotSupported;
+
+        auto& state = signalsCaptureState;
+
+        state.timer = timer;
+        state.timerIndex = timerIndex;
+        state.channel = channel;
+        state.controller = self;
+        state.pin = pin;
+        state.driveMode = LPC17_Gpio_GetDriveMode(self, pin);
+        state.timestamps = timestamps;
+        state.count = count;
+        state.captured = 0;
+        state.completed = completed;
+        state.isActive = true;
+
+        auto resistorMode = LPC17_Gpio_ResistorMode::Inactive;
+
+        if (state.driveMode == TinyCLR_Gpio_PinDriveMode::InputPullUp)
+            resistorMode = LPC17_Gpio_ResistorMode::PullUp;
+        else if (state.driveMode == TinyCLR_Gpio_PinDriveMode::InputPullDown)
+            resistorMode = LPC17_Gpio_ResistorMode::PullDown;
+
+        LPC17_GpioInternal_ConfigurePin(pin, LPC17_Gpio_Direction::Input, capturePins[i].pinFunction, resistorMode, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+
+        LPC_SC->PCONP |= signalsTimerPowerBits[timerIndex];
+
+        timer->TCR = 2; // hold in reset
+        timer->CTCR = 0; // count the peripheral clock
+        timer->PR = static_cast<uint32_t>(divider - 1);
+        timer->MCR = 0;
+        timer->IR = 0x3F;
+
+        LPC17_InterruptInternal_Activate(signalsTimerIrqs[timerIndex], (uint32_t*)&LPC17_Signals_CaptureInterrupt, 0);
+
+        timer->CCR = 0x7 << (3 * channel); // rising and falling edge, interrupt
+        timer->TCR = 1;
+
+        frequency = SIGNALS_TIMER_CLOCK_HZ / divider;
+
+        return TinyCLR_Result::Success;
+    }
+#endif
+
+    return TinyCLR_Result::NotSupported;
+}
+
+size_t LPC17_Signals_GetCaptureCount(const TinyCLR_Gpio_Controller* self) {
+    return signalsCaptureState.isActive ? signalsCaptureState.captured : 0;
+}
+
+size_t LPC17_Signals_StopCapture(const TinyCLR_Gpio_Controller* self) {
+    auto& state = signalsCaptureState;
+
+    if (!state.isActive)
+        return 0;
+
+    state.timer->CCR = 0;
+    state.timer->TCR = 0;
+
+    LPC17_InterruptInternal_Deactivate(signalsTimerIrqs[state.timerIndex]);
+
+    state.timer->IR = 0x3F;
+
+    LPC_SC->PCONP &= ~signalsTimerPowerBits[state.timerIndex];
+
+    LPC17_Gpio_SetDriveMode(self, state.pin, state.driveMode);
+
+    state.isActive = false;
+
+    return state.captured;
+}
+
+static bool LPC17_Signals_FindMatchChannel(uint32_t pin, uint32_t& index) {
+#if defined(LPC17_SIGNALS_GENERATOR_PINS)
+    static const LPC17_Gpio_Pin matchPins[SIGNALS_TOTAL_TIMERS * SIGNALS_CHANNELS_PER_TIMER] = LPC17_SIGNALS_GENERATOR_PINS;
+
+    for (auto i = 0; i < SIGNALS_TOTAL_TIMERS * SIGNALS_CHANNELS_PER_TIMER; i++) {
+        if (matchPins[i].number != pin || LPC17_Signals_IsTimerInUse(i / SIGNALS_CHANNELS_PER_TIMER))
+            continue;
+
+        index = i;
+
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+TinyCLR_Result LPC17_Signals_GetGeneratorTiming(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint32_t& clock, uint32_t& counterBits) {
+    uint32_t index;
+
+    if (signalsGeneratorState.isActive || !LPC17_Signals_FindMatchChannel(pin, index))
+        return TinyCLR_Result::NotSupported;
+
+    clock = SIGNALS_TIMER_CLOCK_HZ;
+    counterBits = 32;
+
+    return TinyCLR_Result::Success;
+}
+
+static void LPC17_Signals_StopGenerator() {
+    auto& state = signalsGeneratorState;
+    auto timer = state.timer;
+
+    timer->TCR = 0;
+    timer->MCR = 0;
+
+    LPC17_InterruptInternal_Deactivate(signalsTimerIrqs[state.timerIndex]);
+
+    timer->IR = 0x3F;
+
+    // back to GPIO at idle before the match output lets go of the pin
+    LPC17_Gpio_Write(state.controller, state.pin, state.idleState);
+    LPC17_Gpio_SetDriveMode(state.controller, state.pin, state.driveMode);
+
+    timer->EMR = 0;
+
+    LPC_SC->PCONP &= ~signalsTimerPowerBits[state.timerIndex];
+
+    state.isActive = false;
+}
+
+void LPC17_Signals_GeneratorInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& state = signalsGeneratorState;
+    auto timer = state.timer;
+    auto flag = 1 << state.channel; // MRx interrupt flag
+
+    timer->IR = flag;
+
+    while (state.next < state.count) {
+        auto edge = state.edges[state.next++];
+
+        if (state.channel == 0)
+            timer->MR0 = edge;
+        else
+            timer->MR1 = edge;
+
+        if (timer->TC < edge)
+            return;
+
+        // the counter passed the edge while it was being loaded, toggle late rather than after a wrap
+        if (timer->IR & flag)
+            timer->IR = flag;
+        else
+            timer->EMR ^= flag;
+    }
+
+    LPC17_Signals_StopGenerator();
+
+    if (state.completed != nullptr)
+        state.completed(state.controller, state.pin, LPC17_Time_GetSystemTime(nullptr));
+}
+
+TinyCLR_Result LPC17_Signals_StartGenerator(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinValue idleState, uint32_t divider, const uint32_t* edges, size_t count, TinyCLR_Signals_GeneratorCompletedHandler completed) {
+#if defined(LPC17_SIGNALS_GENERATOR_PINS)
+    static const LPC17_Gpio_Pin matchPins[SIGNALS_TOTAL_TIMERS * SIGNALS_CHANNELS_PER_TIMER] = LPC17_SIGNALS_GENERATOR_PINS;
+
+    uint32_t index;
+
+    if (signalsGeneratorState.isActive || count == 0 || divider == 0 || !LPC17_Signals_FindMatchChannel(pin, index))
+        return TinyCLR_Result::NotSupported;
+
+    auto& state = signalsGeneratorState;
+    auto timerIndex = index / SIGNALS_CHANNELS_PER_TIMER;
+    auto timer = LPC17_Signals_GetTimer(timerIndex);
+
+    state.controller = self;
+    state.timer = timer;
+    state.timerIndex = timerIndex;
+    state.channel = index % SIGNALS_CHANNELS_PER_TIMER;
+    state.pin = pin;
+    state.idleState = idleState;
+    state.driveMode = LPC17_Gpio_GetDriveMode(self, pin);
+    state.edges = edges;
+    state.count = count;
+    state.next = 1;
+    state.completed = completed;
+    state.isActive = true;
+
+    LPC_SC->PCONP |= signalsTimerPowerBits[timerIndex];
+
+    timer->TCR = 2; // hold in reset
+    timer->CTCR = 0; // count the peripheral clock
+    timer->PR = divider - 1;
+    timer->IR = 0x3F;
+
+    // EMx starts at idle, EMCx = 3 toggles it on every match
+    timer->EMR = (idleState == TinyCLR_Gpio_PinValue::High ? (1 << state.channel) : 0) | (0x3 << (4 + 2 * state.channel));
+
+    if (state.channel == 0)
+        timer->MR0 = edges[0];
+    else
+        timer->MR1 = edges[0];
+
+    timer->MCR = 0x1 << (3 * state.channel); // interrupt on match
+
+    LPC17_GpioInternal_ConfigurePin(pin, LPC17_Gpio_Direction::Output, matchPins[index].pinFunction, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+
+    LPC17_InterruptInternal_Activate(signalsTimerIrqs[timerIndex], (uint32_t*)&LPC17_Signals_GeneratorInterrupt, 0);
+
+    timer->TCR = 1;
+
+    return TinyCLR_Result::Success;
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+bool LPC17_Signals_IsGeneratorActive(const TinyCLR_Gpio_Controller* self) {
+    return signalsGeneratorState.isActive;
+}
@@ -30,6 +30,9 @@ void LPC17_Startup_OnSoftReset(const TinyCLR_Api_Manager* apiManager, const Tiny
 #ifdef INCLUDE_DISPLAY
     LPC17_Display_Reset();
 #endif
+#ifdef INCLUDE_ENCODER
+    LPC17_Encoder_Reset();
+#endif
 #ifdef INCLUDE_GPIO
     LPC17_Gpio_Reset();
 #endif
@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include "LPC17.h"
+#include "../../Drivers/Time/TimeDivider.h"
 
 #define TIMER_IDLE_VALUE  0x0000FFFFFFFFFFFFull
 
@@ -25,6 +26,9 @@
 #define CLOCK_COMMON_FACTOR               1000000   // GCD(SYSTEM_CLOCK_HZ, 1M)
 #define CORTEXM_SLEEP_USEC_FIXED_OVERHEAD_CLOCKS 3
 
+static constexpr TimeDivider timeTicksDivider = TimeDivider_Create(SLOW_CLOCKS_PER_SECOND / SLOW_CLOCKS_TEN_MHZ_GCD);
+static constexpr TimeDivider timeTenDivider = TimeDivider_Create(10);
+
 struct TimeState {
     int32_t controllerIndex;
     uint64_t m_lastRead;
@@ -93,10 +97,11 @@ void LPC17_Time_AddApi(const TinyCLR_Api_Manager* apiManager) {
 
 
 static uint64_t timerNextEvent;   // tick time of next event to be scheduled
+static uint64_t timerNextWakeup = TIMER_IDLE_VALUE; // tick time a driver waiting for an interrupt wakes up at
 
 uint64_t LPC17_Time_GetTimeForProcessorTicks(const TinyCLR_NativeTime_Controller* self, uint64_t ticks) {
     ticks *= (10000000 / SLOW_CLOCKS_TEN_MHZ_GCD);
-    ticks /= (SLOW_CLOCKS_PER_SECOND / SLOW_CLOCKS_TEN_MHZ_GCD);
+    ticks = TimeDivider_Divide(ticks, timeTicksDivider);
 
     return ticks;
 }
@@ -106,7 +111,7 @@ uint64_t LPC17_Time_GetCurrentProcessorTime() {
 }
 
 uint64_t LPC17_Time_GetProcessorTicksForTime(const TinyCLR_NativeTime_Controller* self, uint64_t time) {
-    time /= 10;
+    time = TimeDivider_Divide(time, timeTenDivider);
 
 #if 1000000 <= SLOW_CLOCKS_PER_SECOND
     return time * (SLOW_CLOCKS_PER_SECOND / 1000000);
@@ -154,9 +159,13 @@ TinyCLR_Result LPC17_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Contr
 
     timerNextEvent = processorTicks;
 
+    if (timerNextWakeup <= ticks)
+        timerNextWakeup = TIMER_IDLE_VALUE;
+
     if (timerNextEvent >= TIMER_IDLE_VALUE) {
         if (ticks >= TIMER_IDLE_VALUE) {
             timerNextEvent = timerNextEvent > ticks ? (timerNextEvent - ticks) : 0;
+            timerNextWakeup = TIMER_IDLE_VALUE;
 
             state->m_lastRead = 0;
 
@@ -168,6 +177,10 @@ TinyCLR_Result LPC17_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Contr
             state->Reload(state->m_periodTicks);
 
         }
+        else if (timerNextWakeup - ticks < SysTick_LOAD_RELOAD_Msk) {
+            state->m_periodTicks = (uint32_t)(timerNextWakeup - ticks);
+            state->Reload(state->m_periodTicks);
+        }
         else {
             state->m_periodTicks = SysTick_LOAD_RELOAD_Msk;
             state->Reload(SysTick_LOAD_RELOAD_Msk);
@@ -178,7 +191,7 @@ TinyCLR_Result LPC17_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Contr
             state->m_DequeuAndExecute();
         }
         else {
-            state->m_periodTicks = (timerNextEvent - ticks);
+            state->m_periodTicks = (LPC17_Time_GetNextTickCallbackTime() - ticks);
 
             if (state->m_periodTicks >= SysTick_LOAD_RELOAD_Msk) {
                 state->Reload(SysTick_LOAD_RELOAD_Msk);
@@ -192,6 +205,28 @@ TinyCLR_Result LPC17_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Contr
     return TinyCLR_Result::Success;
 }
 
+// SysTick is due at the next event or at an earlier wake up
+uint64_t LPC17_Time_GetNextTickCallbackTime() {
+    return timerNextWakeup < timerNextEvent ? timerNextWakeup : timerNextEvent;
+}
+
+// Raises the SysTick interrupt no later than processorTicks. Nothing runs then, the interrupt only wakes a driver that
+// waits for an interrupt with a deadline. Call it with interrupts masked before the wait.
+void LPC17_Time_ScheduleWakeup(uint64_t processorTicks) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto ticks = LPC17_Time_GetCurrentProcessorTicks(nullptr);
+
+    if (timerNextWakeup > ticks && timerNextWakeup <= processorTicks)
+        return;
+
+    timerNextWakeup = processorTicks;
+
+    // a missed event raises SysTick already and programs the wake up when it reschedules
+    if (ticks < timerNextEvent)
+        LPC17_Time_SetNextTickCallbackTime(nullptr, timerNextEvent);
+}
+
 extern "C" {
 
     void SysTick_Handler(void *param) {
@@ -275,7 +310,7 @@ void LPC17_Time_Delay(const TinyCLR_NativeTime_Controller* self, uint64_t micros
 void LPC17_Time_DelayNative(const TinyCLR_NativeTime_Controller* self, uint64_t nativeTime) {
     //TODO do inline later, don't call out to Delay
 
-    auto microseconds = LPC17_Time_GetTimeForProcessorTicks(self, nativeTime) / 10;
+    auto microseconds = TimeDivider_Divide(LPC17_Time_GetTimeForProcessorTicks(self, nativeTime), timeTenDivider);
 
     LPC17_Time_Delay(self, microseconds);
 }
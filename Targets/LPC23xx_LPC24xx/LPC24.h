@@ -167,6 +167,8 @@ bool LPC24_Gpio_IsDriveModeSupported(const TinyCLR_Gpio_Controller* self, uint32
 TinyCLR_Gpio_PinDriveMode LPC24_Gpio_GetDriveMode(const TinyCLR_Gpio_Controller* self, uint32_t pin);
 uint64_t LPC24_Gpio_GetDebounceTimeout(const TinyCLR_Gpio_Controller* self, uint32_t pin);
 uint32_t LPC24_Gpio_GetPinCount(const TinyCLR_Gpio_Controller* self);
+TinyCLR_Result LPC24_Gpio_ReadPort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t& value);
+TinyCLR_Result LPC24_Gpio_WritePort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t value);
 TinyCLR_Result LPC24_Gpio_SetPinChangedHandler(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinChangeEdge edge, TinyCLR_Gpio_PinChangedHandler handler);
 TinyCLR_Result LPC24_Gpio_ClosePin(const TinyCLR_Gpio_Controller* self, uint32_t pin);
 void LPC24_GpioInternal_EnableOutputPin(int32_t pin, bool initialState);
@@ -195,6 +197,9 @@ int32_t LPC24_Adc_GetMaxValue(const TinyCLR_Adc_Controller* self);
 TinyCLR_Adc_ChannelMode LPC24_Adc_GetChannelMode(const TinyCLR_Adc_Controller* self);
 TinyCLR_Result LPC24_Adc_SetChannelMode(const TinyCLR_Adc_Controller* self, TinyCLR_Adc_ChannelMode mode);
 bool LPC24_Adc_IsChannelModeSupported(const TinyCLR_Adc_Controller* self, TinyCLR_Adc_ChannelMode mode);
+TinyCLR_Result LPC24_Adc_StartStream(const TinyCLR_Adc_Controller* self, const uint32_t* channels, size_t channelCount, uint32_t frequency, uint16_t* buffer, size_t length, void(*handler)(const TinyCLR_Adc_Controller* self, uint64_t written, uint64_t timestamp));
+uint64_t LPC24_Adc_GetStreamWritten(const TinyCLR_Adc_Controller* self);
+TinyCLR_Result LPC24_Adc_StopStream(const TinyCLR_Adc_Controller* self);
 
 // CAN
 void LPC24_Can_AddApi(const TinyCLR_Api_Manager* apiManager);
@@ -237,6 +242,10 @@ uint32_t LPC24_Dac_GetChannelCount(const TinyCLR_Dac_Controller* self);
 uint32_t LPC24_Dac_GetResolutionInBits(const TinyCLR_Dac_Controller* self);
 int32_t LPC24_Dac_GetMinValue(const TinyCLR_Dac_Controller* self);
 int32_t LPC24_Dac_GetMaxValue(const TinyCLR_Dac_Controller* self);
+TinyCLR_Result LPC24_Dac_StartStream(const TinyCLR_Dac_Controller* self, uint32_t channel, uint32_t frequency, const uint32_t* buffer, size_t length, void(*handler)(const TinyCLR_Dac_Controller* self, uint32_t channel, uint64_t played, uint64_t timestamp));
+uint64_t LPC24_Dac_GetStreamPlayed(const TinyCLR_Dac_Controller* self, uint32_t channel);
+TinyCLR_Result LPC24_Dac_StopStream(const TinyCLR_Dac_Controller* self, uint32_t channel);
+void LPC24_Dac_EncodeStream(const TinyCLR_Dac_Controller* self, uint32_t channel, const int32_t* values, uint32_t* words, size_t count);
 
 //Emc
 bool LPC24_Emc_IsSelfRefreshMode();
@@ -256,10 +265,20 @@ struct PwmState {
     TinyCLR_Pwm_PulsePolarity invert[MAX_PWM_PER_CONTROLLER];
     bool                        isOpened[MAX_PWM_PER_CONTROLLER];
 
-    double                      frequency;
-    double                      dutyCycle[MAX_PWM_PER_CONTROLLER];
+    uint64_t                    frequency; // millihertz
+    uint32_t                    period;
+    uint32_t                    dutyCycle[MAX_PWM_PER_CONTROLLER]; // parts per million
 
     uint16_t initializeCount;
+
+    bool                        burstActive;
+    bool                        burstLooped;
+    const uint32_t*             burstPulses;
+    size_t                      burstSets;
+    size_t                      burstNext;
+    uint32_t                    burstFirstChannel;
+    uint32_t                    burstChannelCount;
+    void(*burstCompleted)(const TinyCLR_Pwm_Controller* self, uint64_t timestamp);
 };
 void LPC24_Pwm_AddApi(const TinyCLR_Api_Manager* apiManager);
 void LPC24_Pwm_Reset();
@@ -274,6 +293,11 @@ TinyCLR_Result LPC24_Pwm_CloseChannel(const TinyCLR_Pwm_Controller* self, uint32
 TinyCLR_Result LPC24_Pwm_EnableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel);
 TinyCLR_Result LPC24_Pwm_DisableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel);
 TinyCLR_Result LPC24_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* self, uint32_t channel, double dutyCycle, TinyCLR_Pwm_PulsePolarity polarity);
+TinyCLR_Result LPC24_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Controller* self, const uint32_t* channels, const double* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count);
+TinyCLR_Result LPC24_Pwm_EncodeBurst(const TinyCLR_Pwm_Controller* self, uint32_t channel, const double* dutyCycles, uint32_t* pulses, size_t count, size_t stride);
+TinyCLR_Result LPC24_Pwm_StartBurst(const TinyCLR_Pwm_Controller* self, uint32_t firstChannel, uint32_t channelCount, const uint32_t* pulses, size_t sets, bool looped, void(*completed)(const TinyCLR_Pwm_Controller* self, uint64_t timestamp));
+bool LPC24_Pwm_IsBurstActive(const TinyCLR_Pwm_Controller* self);
+TinyCLR_Result LPC24_Pwm_StopBurst(const TinyCLR_Pwm_Controller* self);
 double LPC24_Pwm_GetMinFrequency(const TinyCLR_Pwm_Controller* self);
 double LPC24_Pwm_GetMaxFrequency(const TinyCLR_Pwm_Controller* self);
 double LPC24_Pwm_GetActualFrequency(const TinyCLR_Pwm_Controller* self);
@@ -304,6 +328,17 @@ TinyCLR_Result LPC24_SdCard_Close(const TinyCLR_Storage_Controller* self);
 
 TinyCLR_Result LPC24_SdCard_Reset();
 
+////////////////////////////////////////////////////////////////////////////////
+//Signals
+////////////////////////////////////////////////////////////////////////////////
+void LPC24_Signals_AddApi(const TinyCLR_Api_Manager* apiManager);
+TinyCLR_Result LPC24_Signals_StartCapture(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timeout, uint32_t* timestamps, size_t count, uint64_t& frequency, void(*completed)(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timestamp));
+size_t LPC24_Signals_GetCaptureCount(const TinyCLR_Gpio_Controller* self);
+size_t LPC24_Signals_StopCapture(const TinyCLR_Gpio_Controller* self);
+TinyCLR_Result LPC24_Signals_GetGeneratorTiming(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint32_t& clock, uint32_t& counterBits);
+TinyCLR_Result LPC24_Signals_StartGenerator(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinValue idleState, uint32_t divider, const uint32_t* edges, size_t count, void(*completed)(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timestamp));
+bool LPC24_Signals_IsGeneratorActive(const TinyCLR_Gpio_Controller* self);
+
 //SPI
 void LPC24_Spi_AddApi(const TinyCLR_Api_Manager* apiManager);
 void LPC24_Spi_Reset();
@@ -400,6 +435,10 @@ public:
 #define DISABLE_INTERRUPTS_SCOPED(name) LPC24_DisableInterrupts_RaiiHelper name
 #define INTERRUPT_STARTED_SCOPED(name) LPC24_InterruptStarted_RaiiHelper name
 
+// Interrupt profiler: VIC channels, counts of the time base timer
+#define INTERRUPT_PROFILER_VECTORS 32
+#define INTERRUPT_PROFILER_COUNTS_PER_SECOND SYSTEM_CLOCK_HZ
+
 bool LPC24_InterruptInternal_Activate(uint32_t index, uint32_t* isr, void* isrParam);
 bool LPC24_InterruptInternal_Deactivate(uint32_t index);
 
@@ -488,16 +527,17 @@ void LPC24_UsbDevice_AddApi(const TinyCLR_Api_Manager* apiManager);
 void LPC24_UsbDevice_Reset();
 void LPC24_UsbDevice_PinConfiguration();
 
-struct USB_PACKET64;
 struct UsbClientState;
 typedef void(*USB_NEXT_CALLBACK)(UsbClientState*);
 
 void TinyCLR_UsbClient_ClearEvent(UsbClientState *usbClientState, uint32_t event);
 void TinyCLR_UsbClient_ClearEndpoints(UsbClientState *usbClientState, int32_t endpoint);
-USB_PACKET64* TinyCLR_UsbClient_RxEnqueue(UsbClientState* usbClientState, int32_t endpoint, bool& disableRx);
-USB_PACKET64* TinyCLR_UsbClient_TxDequeue(UsbClientState* usbClientState, int32_t endpoint);
+uint8_t* TinyCLR_UsbClient_RxEnqueue(UsbClientState* usbClientState, int32_t endpoint, bool& disableRx);
+void TinyCLR_UsbClient_RxCommit(UsbClientState* usbClientState, int32_t endpoint, uint32_t size);
+uint8_t* TinyCLR_UsbClient_TxDequeue(UsbClientState* usbClientState, int32_t endpoint, uint32_t& size);
 void TinyCLR_UsbClient_StateCallback(UsbClientState* usbClientState);
 uint8_t TinyCLR_UsbClient_ControlCallback(UsbClientState* usbClientState);
+uint8_t TinyCLR_UsbClient_ControlOutCallback(UsbClientState* usbClientState);
 bool TinyCLR_UsbClient_Initialize(UsbClientState* usbClientState);
 bool TinyCLR_UsbClient_Uninitialize(UsbClientState* usbClientState);
 
@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include "LPC24.h"
+#include "../../Drivers/DevicesInterop/Dac/GHIElectronics_TinyCLR_Devices_Dac_Stream.h"
 
 #define DACR (*(volatile unsigned long *)0xE006C000)
 
@@ -21,6 +22,13 @@
 #define LPC24_DAC_PRECISION_BITS 	10	// Number of Bits in the DAC Convertion
 #define LPC24_DAC_MAX_VALUE 	(1<<LPC24_DAC_PRECISION_BITS)
 
+// The DAC has no DMA request or timer of its own, a match interrupt writes every sample
+#define LPC24_DAC_MAX_FREQUENCY 50000
+#define LPC24_DAC_TIMER_CLOCK_HZ SYSTEM_CLOCK_HZ
+#define LPC24_DAC_TOTAL_TIMERS 4
+
+#define DAC_STREAM_EVENT_POST_DEBOUNCE_TICKS (10 * 10000) // 10ms between each events
+
 ///////////////////////////////////////////////////////////////////////////////
 #define TOTAL_DAC_CONTROLLERS 1
 
@@ -35,6 +43,30 @@ struct DacState {
 
 static DacState dacStates[TOTAL_DAC_CONTROLLERS];
 
+struct DacStreamState {
+    bool isActive;
+
+    const TinyCLR_Dac_Controller* controller;
+    uint32_t timerIndex;
+
+    const uint32_t* buffer;
+    size_t length;
+    size_t half;
+    size_t index;
+    volatile uint64_t played;
+    uint64_t reported;
+
+    TinyCLR_Dac_StreamHandler handler;
+    const TinyCLR_Task_Manager* taskManager;
+    TinyCLR_Task_Reference taskReference;
+};
+
+static DacStreamState dacStreamState;
+
+static const uint32_t dacTimerPowerBits[LPC24_DAC_TOTAL_TIMERS] = { PCONP_PCTIM0, PCONP_PCTIM1, PCONP_PCTIM2, PCONP_PCTIM3 };
+
+static const TinyCLR_Dac_StreamApi dacStreamApi = { &LPC24_Dac_StartStream, &LPC24_Dac_GetStreamPlayed, &LPC24_Dac_StopStream, &LPC24_Dac_EncodeStream };
+
 const char* dacApiNames[TOTAL_DAC_CONTROLLERS] = {
     "GHIElectronics.TinyCLR.NativeApis.LPC24.DacController\\0"
 };
@@ -63,6 +95,8 @@ void LPC24_Dac_AddApi(const TinyCLR_Api_Manager* apiManager) {
     }
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::DacController, dacApi[0].Name);
+
+    TinyCLR_Dac_SetStreamApi(&dacControllers[0], &dacStreamApi);
 }
 
 TinyCLR_Result LPC24_Dac_Acquire(const TinyCLR_Dac_Controller* self) {
@@ -101,6 +135,9 @@ TinyCLR_Result LPC24_Dac_CloseChannel(const TinyCLR_Dac_Controller* self, uint32
     if (channel >= LPC24_Dac_GetChannelCount(self))
         return TinyCLR_Result::ArgumentOutOfRange;
 
+    if (dacStreamState.isActive)
+        return TinyCLR_Result::Busy;
+
     auto state = reinterpret_cast<DacState*>(self->ApiInfo->State);
     if (state->isOpened[channel])
         LPC24_GpioInternal_ClosePin(dacPins[channel].number);
@@ -114,6 +151,9 @@ TinyCLR_Result LPC24_Dac_WriteValue(const TinyCLR_Dac_Controller* self, uint32_t
     if (channel >= LPC24_Dac_GetChannelCount(self))
         return TinyCLR_Result::ArgumentOutOfRange;
 
+    if (dacStreamState.isActive)
+        return TinyCLR_Result::Busy;
+
     if (value > LPC24_DAC_MAX_VALUE) {
         value = LPC24_DAC_MAX_VALUE;
     }
@@ -143,7 +183,144 @@ int32_t LPC24_Dac_GetMaxValue(const TinyCLR_Dac_Controller* self) {
     return ((1 << LPC24_DAC_PRECISION_BITS) - 1);
 }
 
+// The time driver's timer counts native time, a running counter marks the others as taken
+static bool LPC24_Dac_IsTimerInUse(uint32_t timerIndex) {
+    if (timerIndex == LPC24_TIME_DEFAULT_CONTROLLER_ID)
+        return true;
+
+    return (LPC24XX::SYSCON().PCONP & dacTimerPowerBits[timerIndex]) && (LPC24XX::TIMER(timerIndex).TCR & LPC24XX_TIMER::TCR_TEN);
+}
+
+static void LPC24_Dac_StreamInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& stream = dacStreamState;
+
+    LPC24XX::TIMER(stream.timerIndex).IR = 0x1; // MR0 interrupt flag
+
+    DACR = stream.buffer[stream.index++];
+
+    if (stream.index == stream.half || stream.index == stream.length)
+        stream.played += stream.half;
+
+    if (stream.index == stream.length)
+        stream.index = 0;
+}
+
+static void LPC24_Dac_StreamCallback(const TinyCLR_Task_Manager* self, const TinyCLR_Api_Manager* apiManager, TinyCLR_Task_Reference task, void* arg) {
+    auto state = reinterpret_cast<DacStreamState*>(arg);
+    uint64_t played = 0;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+        played = state->played;
+    }
+
+    if (played != state->reported) {
+        state->reported = played;
+        state->handler(state->controller, 0, played, LPC24_Time_GetSystemTime(nullptr));
+    }
+
+    state->taskManager->Enqueue(state->taskManager, task, LPC24_Time_GetProcessorTicksForTime(nullptr, DAC_STREAM_EVENT_POST_DEBOUNCE_TICKS));
+}
+
+TinyCLR_Result LPC24_Dac_StartStream(const TinyCLR_Dac_Controller* self, uint32_t channel, uint32_t frequency, const uint32_t* buffer, size_t length, TinyCLR_Dac_StreamHandler handler) {
+    auto state = reinterpret_cast<DacState*>(self->ApiInfo->State);
+    auto& stream = dacStreamState;
+
+    if (channel >= LPC24_Dac_GetChannelCount(self) || length < 2 || length % 2 != 0 || frequency == 0 || frequency > LPC24_DAC_MAX_FREQUENCY)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (!state->isOpened[channel] || stream.isActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto timerIndex = 0U;
+
+    while (timerIndex < LPC24_DAC_TOTAL_TIMERS && LPC24_Dac_IsTimerInUse(timerIndex))
+        timerIndex++;
+
+    if (timerIndex == LPC24_DAC_TOTAL_TIMERS)
+        return TinyCLR_Result::NotAvailable;
+
+    auto& TIMER = LPC24XX::TIMER(timerIndex);
+
+    stream.controller = self;
+    stream.timerIndex = timerIndex;
+    stream.buffer = buffer;
+    stream.length = length;
+    stream.half = length / 2;
+    stream.index = 0;
+    stream.played = 0;
+    stream.reported = 0;
+    stream.handler = handler;
+    stream.isActive = true;
+
+    LPC24XX::SYSCON().PCONP |= dacTimerPowerBits[timerIndex];
+
+    TIMER.TCR = 2; // hold in reset
+    TIMER.PR = 0;
+    TIMER.MR0 = (LPC24_DAC_TIMER_CLOCK_HZ + frequency / 2) / frequency - 1;
+    TIMER.MCR = 0x3; // interrupt and reset on MR0
+    TIMER.EMR = 0;
+    TIMER.IR = 0x3F;
+
+    LPC24_InterruptInternal_Activate(LPC24XX_TIMER::getIntNo(timerIndex), (uint32_t*)&LPC24_Dac_StreamInterrupt, 0);
+
+    if (handler != nullptr) {
+        stream.taskManager = (const TinyCLR_Task_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::TaskManager);
+        stream.taskManager->Create(stream.taskManager, LPC24_Dac_StreamCallback, (void*)&stream, false, stream.taskReference);
+        stream.taskManager->Enqueue(stream.taskManager, stream.taskReference, LPC24_Time_GetProcessorTicksForTime(nullptr, DAC_STREAM_EVENT_POST_DEBOUNCE_TICKS));
+    }
+
+    TIMER.TCR = LPC24XX_TIMER::TCR_TEN;
+
+    return TinyCLR_Result::Success;
+}
+
+uint64_t LPC24_Dac_GetStreamPlayed(const TinyCLR_Dac_Controller* self, uint32_t channel) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    return channel < LPC24_Dac_GetChannelCount(self) && dacStreamState.isActive ? dacStreamState.played : 0;
+}
+
+TinyCLR_Result LPC24_Dac_StopStream(const TinyCLR_Dac_Controller* self, uint32_t channel) {
+    auto& stream = dacStreamState;
+
+    if (channel >= LPC24_Dac_GetChannelCount(self) || !stream.isActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto& TIMER = LPC24XX::TIMER(stream.timerIndex);
+
+    TIMER.TCR = 0;
+    TIMER.MCR = 0;
+
+    LPC24_InterruptInternal_Deactivate(LPC24XX_TIMER::getIntNo(stream.timerIndex));
+
+    TIMER.IR = 0x3F;
+
+    LPC24XX::SYSCON().PCONP &= ~dacTimerPowerBits[stream.timerIndex];
+
+    if (stream.handler != nullptr && stream.taskManager != nullptr && stream.taskReference != nullptr) {
+        stream.taskManager->Free(stream.taskManager, stream.taskReference);
+
+        stream.taskReference = nullptr;
+    }
+
+    stream.handler = nullptr;
+    stream.isActive = false;
+
+    return TinyCLR_Result::Success;
+}
+
+void LPC24_Dac_EncodeStream(const TinyCLR_Dac_Controller* self, uint32_t channel, const int32_t* values, uint32_t* words, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        words[i] = (values[i] < 0 ? 0 : (values[i] >= LPC24_DAC_MAX_VALUE ? LPC24_DAC_MAX_VALUE - 1 : values[i])) << 6;
+}
+
 void LPC24_Dac_Reset() {
+    if (dacStreamState.isActive)
+        TinyCLR_Dac_StopStream(&dacControllers[0], 0);
+
     for (auto c = 0; c < TOTAL_DAC_CONTROLLERS; c++) {
         for (auto ch = 0; ch < LPC24_Dac_GetChannelCount(&dacControllers[c]); ch++) {
             LPC24_Dac_CloseChannel(&dacControllers[c], ch);
@@ -14,6 +14,8 @@
 // limitations under the License.
 
 #include "LPC24.h"
+#include "../../Drivers/DevicesInterop/Gpio/GHIElectronics_TinyCLR_Devices_Gpio_PinGroup.h"
+#include "../../Drivers/Gpio/GpioDispatch.h"
 
 #define SCS_BASE (*(volatile unsigned long *)0xE01FC1A0)
 
@@ -37,6 +39,9 @@
 #define FIO0DIR (*(volatile unsigned long *)0x3FFFC000)
 #define FIO0DIR_OFFSET 0x0
 
+#define FIO0MASK (*(volatile unsigned long *)0x3FFFC010)
+#define FIO0MASK_OFFSET 0x10
+
 #define FIO0PIN (*(volatile unsigned long *)0x3FFFC014)
 #define FIO0PIN_OFFSET 0x14
 
@@ -76,6 +81,10 @@
 
 #define GET_PIN_STATUS(port, pin)           ((*((volatile uint32_t *)(FIO_BASE+FIO0PIN_OFFSET + port*0x20))&(1u<<pin)) == (1u<<pin))
 
+#define GET_PORT_STATUS(port)               (*((volatile uint32_t *)(FIO_BASE+FIO0PIN_OFFSET + port*0x20)))
+#define SET_PORT_VALUE(port, value)         *((volatile uint32_t *)(FIO_BASE+FIO0PIN_OFFSET + port*0x20 )) =   (value)
+#define SET_PORT_MASK(port, mask)           *((volatile uint32_t *)(FIO_BASE+FIO0MASK_OFFSET + port*0x20 )) =  (mask)
+
 // Interrupt
 #define GPIO_INTERRUPT_STATUS_REG                           ((volatile uint32_t *)0xE0028080)
 
@@ -88,7 +97,11 @@
 #define GET_PIN_INTERRUPT_RISING_EDGE_STATUS(port, pin)	    ((*((volatile unsigned long *)(GPIO_BASE + IO0IntStatR_OFFSET + port*0x10 ))&(1u<<pin)) == (1u<<pin))
 #define GET_PIN_INTERRUPT_FALLING_EDGE_STATUS(port, pin)    ((*((volatile unsigned long *)(GPIO_BASE + IO0IntStatF_OFFSET + port*0x10 ))&(1u<<pin)) == (1u<<pin))
 
+#define GET_PORT_INTERRUPT_RISING_EDGE_STATUS(port)         (*((volatile unsigned long *)(GPIO_BASE + IO0IntStatR_OFFSET + port*0x10 )))
+#define GET_PORT_INTERRUPT_FALLING_EDGE_STATUS(port)        (*((volatile unsigned long *)(GPIO_BASE + IO0IntStatF_OFFSET + port*0x10 )))
+
 #define CLEAR_PIN_INTERRUPT(port, pin)                      *((volatile unsigned long *)(GPIO_BASE + IO0IntClr_OFFSET + port*0x10 )) =  (1u<<pin)
+#define CLEAR_PORT_INTERRUPT(port, mask)                    *((volatile unsigned long *)(GPIO_BASE + IO0IntClr_OFFSET + port*0x10 )) =  (mask)
 
 // Driver
 static const LPC24_Gpio_PinConfiguration gpioPins[] = LPC24_GPIO_PINS;
@@ -97,6 +110,8 @@ static const LPC24_Gpio_PinConfiguration gpioPins[] = LPC24_GPIO_PINS;
 
 #define TOTAL_GPIO_PINS SIZEOF_ARRAY(gpioPins)
 
+#define TOTAL_GPIO_PORTS ((TOTAL_GPIO_PINS + 31) / 32)
+
 #define TOTAL_GPIO_INTERRUPT_PINS TOTAL_GPIO_PINS
 
 #define DEBOUNCE_DEFAULT_TICKS     (20*10000) // 20ms in ticks
@@ -174,11 +189,15 @@ const TinyCLR_Api_Info* LPC24_Gpio_GetRequiredApi() {
     return &gpioApi[0];
 }
 
+static const TinyCLR_Gpio_PortApi gpioPortApi = { 32, TOTAL_GPIO_PORTS, &LPC24_Gpio_ReadPort, &LPC24_Gpio_WritePort };
+
 void LPC24_Gpio_AddApi(const TinyCLR_Api_Manager* apiManager) {
     LPC24_Gpio_EnsureTableInitialized();
 
     for (auto i = 0; i < TOTAL_GPIO_CONTROLLERS; i++) {
         apiManager->Add(apiManager, &gpioApi[i]);
+
+        TinyCLR_Gpio_SetPortApi(&gpioControllers[i], &gpioPortApi);
     }
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::GpioController, LPC24_Gpio_GetRequiredApi()->Name);
@@ -192,44 +211,43 @@ TinyCLR_Result LPC24_Gpio_Release(const TinyCLR_Gpio_Controller* self) {
     return TinyCLR_Result::Success;
 }
 
-void LPC24_Gpio_InterruptHandler(void* param) {
-    INTERRUPT_STARTED_SCOPED(isr);
-
-    DISABLE_INTERRUPTS_SCOPED(irq);
+static void LPC24_Gpio_PinChanged(GpioInterruptState* interruptState, uint64_t time, uint64_t systemTime) {
+    LPC24_Gpio_Read(interruptState->controller, interruptState->pin, interruptState->currentValue); // read value as soon as possible
 
-    bool executeIsr = false;
+    auto edge = interruptState->currentValue == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinChangeEdge::RisingEdge : TinyCLR_Gpio_PinChangeEdge::FallingEdge;
+    auto expectedEdgeInterger = static_cast<uint32_t>(interruptState->edge);
+    auto currentEdgeInterger = static_cast<uint32_t>(edge);
 
-    for (auto port = 0; port <= 2; port += 2) { // Only port 0 and port 2 support interrupts
-        auto status_mask_register = 1 << port;
+    if (interruptState->handler && ((expectedEdgeInterger & currentEdgeInterger) || (expectedEdgeInterger == 0))) {
+        auto executeIsr = (time - interruptState->lastDebounceTicks) >= gpioDebounceInTicks[interruptState->pin];
 
-        for (auto pin = 0; ((*GPIO_INTERRUPT_STATUS_REG) & status_mask_register) && (pin < 32); pin++) {
+        interruptState->lastDebounceTicks = time;
 
-            if (!(GET_PIN_INTERRUPT_RISING_EDGE_STATUS(port, pin)) && !(GET_PIN_INTERRUPT_FALLING_EDGE_STATUS(port, pin))) // If this is not the Pin, skip to next pin
-                continue;
+        if (executeIsr)
+            interruptState->handler(interruptState->controller, interruptState->pin, edge, systemTime);
+    }
+}
 
-            GpioInterruptState* interruptState = &gpioInterruptState[pin + port * 32];
+void LPC24_Gpio_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
 
-            CLEAR_PIN_INTERRUPT(port, pin); // Clear this pin's IRQ
+    DISABLE_INTERRUPTS_SCOPED(irq);
 
-            LPC24_Gpio_Read(interruptState->controller, interruptState->pin, interruptState->currentValue); // read value as soon as possible
+    // One timestamp for every edge handled by this entry
+    auto time = LPC24_Time_GetTimeForProcessorTicks(nullptr, LPC24_Time_GetCurrentProcessorTicks(nullptr));
+    auto systemTime = LPC24_Time_GetSystemTime(nullptr);
 
-            auto edge = interruptState->currentValue == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinChangeEdge::RisingEdge : TinyCLR_Gpio_PinChangeEdge::FallingEdge;
-            auto expectedEdgeInterger = static_cast<uint32_t>(interruptState->edge);
-            auto currentEdgeInterger = static_cast<uint32_t>(edge);
+    for (auto port = 0; port <= 2; port += 2) { // Only port 0 and port 2 support interrupts
+        if (!((*GPIO_INTERRUPT_STATUS_REG) & (1 << port)))
+            continue;
 
-            if (interruptState->handler && ((expectedEdgeInterger & currentEdgeInterger) || (expectedEdgeInterger == 0))) {
-                if (interruptState->debounce) {
-                    if ((LPC24_Time_GetTimeForProcessorTicks(nullptr, LPC24_Time_GetCurrentProcessorTicks(nullptr)) - interruptState->lastDebounceTicks) >= gpioDebounceInTicks[interruptState->pin]) {
-                        executeIsr = true;
-                    }
+        uint32_t pending = GET_PORT_INTERRUPT_RISING_EDGE_STATUS(port) | GET_PORT_INTERRUPT_FALLING_EDGE_STATUS(port);
 
-                    interruptState->lastDebounceTicks = LPC24_Time_GetTimeForProcessorTicks(nullptr, LPC24_Time_GetCurrentProcessorTicks(nullptr));
-                }
+        CLEAR_PORT_INTERRUPT(port, pending); // Clear all pending IRQs of this port at once
 
-                if (executeIsr)
-                    interruptState->handler(interruptState->controller, interruptState->pin, edge, LPC24_Time_GetSystemTime(nullptr));
-            }
-        }
+        GpioDispatch_Pending(pending, [&](uint32_t pin) {
+            LPC24_Gpio_PinChanged(&gpioInterruptState[pin + port * 32], time, systemTime);
+        });
     }
 }
 
@@ -293,6 +311,7 @@ bool LPC24_GpioInternal_ClosePin(int32_t pin) {
         return false;
 
     pinReserved[pin] = false;
+    pinDriveMode[pin] = TinyCLR_Gpio_PinDriveMode::Input;
 
     // reset to default interruptState
     return LPC24_GpioInternal_ConfigurePin(pin, LPC24_Gpio_Direction::Input, LPC24_Gpio_PinFunction::PinFunction0, LPC24_Gpio_PinMode::Inactive);
@@ -427,6 +446,47 @@ TinyCLR_Result LPC24_Gpio_Write(const TinyCLR_Gpio_Controller* self, uint32_t pi
     return TinyCLR_Result::Success;
 }
 
+TinyCLR_Result LPC24_Gpio_ReadPort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t& value) {
+    if (port >= TOTAL_GPIO_PORTS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    value = GET_PORT_STATUS(port) & mask;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC24_Gpio_WritePort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t value) {
+    if (port >= TOTAL_GPIO_PORTS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    // Only pins opened and driven as outputs take part, anything else in the mask fails the whole write
+    for (auto pins = mask; pins; pins &= pins - 1) {
+        auto pin = port * 32 + GpioDispatch_LowestSetBit(pins);
+
+        if (pin >= TOTAL_GPIO_PINS || !pinReserved[pin] || pinDriveMode[pin] < TinyCLR_Gpio_PinDriveMode::Output)
+            return TinyCLR_Result::InvalidOperation;
+    }
+
+    // FIOMASK also gates FIOSET/FIOCLR, keep it masked only for the one FIOPIN store
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        SET_PORT_MASK(port, ~mask);
+        SET_PORT_VALUE(port, value);
+        SET_PORT_MASK(port, 0);
+    }
+
+    for (auto pins = mask; pins; pins &= pins - 1) {
+        auto bit = GpioDispatch_LowestSetBit(pins);
+        auto pin = port * 32 + bit;
+
+        if (pin < TOTAL_GPIO_PINS)
+            previousOutputValue[pin] = (value & (1u << bit)) ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
 TinyCLR_Result LPC24_Gpio_OpenPin(const TinyCLR_Gpio_Controller* self, uint32_t pin) {
 
     DISABLE_INTERRUPTS_SCOPED(irq);
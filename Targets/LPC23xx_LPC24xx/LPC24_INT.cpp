@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include "LPC24.h"
+#include "../../Drivers/InterruptProfiler/InterruptProfiler.h"
 
 #define VECTORING_GUARD  32
 #define DEFINE_IRQ(index) { index, { NULL, (void*)(size_t)index } }
@@ -248,16 +249,30 @@ bool LPC24_InterruptInternal_Deactivate(uint32_t Irq_Index) {
     return true;
 }
 
+#if defined(INTERRUPT_PROFILER)
+uint32_t InterruptProfiler_ReadCounter() {
+    return LPC24XX::TIMER(LPC24_TIME_DEFAULT_CONTROLLER_ID).TC;
+}
+#endif
+
 LPC24_InterruptStarted_RaiiHelper::LPC24_InterruptStarted_RaiiHelper() { LPC24_Interrupt_Started(); };
 LPC24_InterruptStarted_RaiiHelper::~LPC24_InterruptStarted_RaiiHelper() { LPC24_Interrupt_Ended(); };
 
 LPC24_DisableInterrupts_RaiiHelper::LPC24_DisableInterrupts_RaiiHelper() {
     state = IRQ_LOCK_Disable_asm();
+
+#if defined(INTERRUPT_PROFILER)
+    if ((state & DISABLED_MASK) == 0)
+        InterruptProfiler_DisabledStarted();
+#endif
 }
 LPC24_DisableInterrupts_RaiiHelper::~LPC24_DisableInterrupts_RaiiHelper() {
     uint32_t Cp = state;
 
     if ((Cp & DISABLED_MASK) == 0) {
+#if defined(INTERRUPT_PROFILER)
+        InterruptProfiler_DisabledEnded();
+#endif
         state = IRQ_LOCK_Release_asm();
     }
 }
@@ -271,6 +286,11 @@ void LPC24_DisableInterrupts_RaiiHelper::Acquire() {
 
     if ((Cp & DISABLED_MASK) == DISABLED_MASK) {
         state = IRQ_LOCK_Disable_asm();
+
+#if defined(INTERRUPT_PROFILER)
+        if ((state & DISABLED_MASK) == 0)
+            InterruptProfiler_DisabledStarted();
+#endif
     }
 }
 
@@ -278,6 +298,9 @@ void LPC24_DisableInterrupts_RaiiHelper::Release() {
     uint32_t Cp = state;
 
     if ((Cp & DISABLED_MASK) == 0) {
+#if defined(INTERRUPT_PROFILER)
+        InterruptProfiler_DisabledEnded();
+#endif
         state = IRQ_LOCK_Release_asm();
     }
 }
@@ -290,11 +313,19 @@ bool LPC24_Interrupt_IsDisabled() {
 }
 
 void LPC24_Interrupt_Enable() {
+#if defined(INTERRUPT_PROFILER)
+    InterruptProfiler_DisabledEnded();
+#endif
     IRQ_LOCK_Release_asm();
 }
 
 void LPC24_Interrupt_Disable() {
+#if defined(INTERRUPT_PROFILER)
+    if ((IRQ_LOCK_Disable_asm() & DISABLED_MASK) == 0)
+        InterruptProfiler_DisabledStarted();
+#else
     IRQ_LOCK_Disable_asm();
+#endif
 }
 
 void LPC24_Interrupt_WaitForInterrupt() {
@@ -345,8 +376,16 @@ extern "C" {
         // In case the interrupt was forced, remove the flag.
         VIC.RemoveForcedInterrupt(index);
 
+#if defined(INTERRUPT_PROFILER)
+        InterruptProfiler_Started(index);
+#endif
+
         IsrVector->Handler.Execute();
 
+#if defined(INTERRUPT_PROFILER)
+        InterruptProfiler_Ended();
+#endif
+
         // Reset VIC priority hw logic.
         VIC.ADDRESS = 0xFF;
     }
@@ -0,0 +1,339 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LPC24.h"
+#include "../../Drivers/DevicesInterop/Signals/GHIElectronics_TinyCLR_Devices_Signals_Capture.h"
+#include "../../Drivers/DevicesInterop/Signals/GHIElectronics_TinyCLR_Devices_Signals_Generator.h"
+
+#define SIGNALS_TIMER_CLOCK_HZ SYSTEM_CLOCK_HZ
+#define SIGNALS_CHANNELS_PER_TIMER 2
+#define SIGNALS_TOTAL_TIMERS 4
+
+struct SignalsCaptureState {
+    bool isActive;
+
+    const TinyCLR_Gpio_Controller* controller;
+    uint32_t timerIndex;
+    uint32_t channel;
+
+    uint32_t pin;
+    TinyCLR_Gpio_PinDriveMode driveMode;
+
+    uint32_t* timestamps;
+    size_t count;
+    volatile size_t captured;
+    TinyCLR_Signals_CaptureCompletedHandler completed;
+};
+
+// Each match toggles the MATn.x output in hardware, the match interrupt only loads the next edge
+struct SignalsGeneratorState {
+    bool isActive;
+
+    const TinyCLR_Gpio_Controller* controller;
+    uint32_t timerIndex;
+    uint32_t channel;
+
+    uint32_t pin;
+    TinyCLR_Gpio_PinValue idleState;
+    TinyCLR_Gpio_PinDriveMode driveMode;
+
+    const uint32_t* edges;
+    size_t count;
+    size_t next;
+    TinyCLR_Signals_GeneratorCompletedHandler completed;
+};
+
+static SignalsCaptureState signalsCaptureState;
+static SignalsGeneratorState signalsGeneratorState;
+
+static const uint32_t signalsTimerPowerBits[SIGNALS_TOTAL_TIMERS] = { PCONP_PCTIM0, PCONP_PCTIM1, PCONP_PCTIM2, PCONP_PCTIM3 };
+
+static const TinyCLR_Signals_CaptureApi signalsCaptureApi = { &LPC24_Signals_StartCapture, &LPC24_Signals_GetCaptureCount, &LPC24_Signals_StopCapture };
+static const TinyCLR_Signals_GeneratorApi signalsGeneratorApi = { &LPC24_Signals_GetGeneratorTiming, &LPC24_Signals_StartGenerator, &LPC24_Signals_IsGeneratorActive };
+
+void LPC24_Signals_AddApi(const TinyCLR_Api_Manager* apiManager) {
+#if defined(LPC24_SIGNALS_CAPTURE_PINS)
+    TinyCLR_Signals_SetCaptureApi(reinterpret_cast<const TinyCLR_Gpio_Controller*>(LPC24_Gpio_GetRequiredApi()->Implementation), &signalsCaptureApi);
+#endif
+
+#if defined(LPC24_SIGNALS_GENERATOR_PINS)
+    TinyCLR_Signals_SetGeneratorApi(reinterpret_cast<const TinyCLR_Gpio_Controller*>(LPC24_Gpio_GetRequiredApi()->Implementation), &signalsGeneratorApi);
+#endif
+}
+
+// The time driver's timer counts native time. TIMER0 and TIMER1 are powered out of reset, a running
+// counter is what marks the others as taken.
+static bool LPC24_Signals_IsTimerInUse(uint32_t timerIndex) {
+    if (timerIndex == LPC24_TIME_DEFAULT_CONTROLLER_ID)
+        return true;
+
+    return (LPC24XX::SYSCON().PCONP & signalsTimerPowerBits[timerIndex]) && (LPC24XX::TIMER(timerIndex).TCR & LPC24XX_TIMER::TCR_TEN);
+}
+
+void LPC24_Signals_CaptureInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& state = signalsCaptureState;
+    auto& TIMER = LPC24XX::TIMER(state.timerIndex);
+
+    TIMER.IR = 0x10 << state.channel; // CRx interrupt flag
+
+    auto value = state.channel == 0 ? TIMER.CR0 : TIMER.CR1;
+
+    if (state.captured < state.count)
+        state.timestamps[state.captured++] = value;
+
+    if (state.captured == state.count) {
+        TIMER.CCR = 0;
+
+        if (state.completed != nullptr)
+            state.completed(state.controller, state.pin, LPC24_Time_GetSystemTime(nullptr));
+    }
+}
+
+TinyCLR_Result LPC24_Signals_StartCapture(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timeout, uint32_t* timestamps, size_t count, uint64_t& frequency, TinyCLR_Signals_CaptureCompletedHandler completed) {
+#if defined(LPC24_SIGNALS_CAPTURE_PINS)
+    static const LPC24_Gpio_Pin capturePins[SIGNALS_TOTAL_TIMERS * SIGNALS_CHANNELS_PER_TIMER] = LPC24_SIGNALS_CAPTURE_PINS;
+
+    if (signalsCaptureState.isActive || count == 0)
+        return TinyCLR_Result::NotSupported;
+
+    for (auto i = 0; i < SIGNALS_TOTAL_TIMERS * SIGNALS_CHANNELS_PER_TIMER; i++) {
+        if (capturePins[i].number != pin)
+            continue;
+
+        auto timerIndex = i / SIGNALS_CHANNELS_PER_TIMER;
+        auto channel = i % SIGNALS_CHANNELS_PER_TIMER;
+
+        auto& TIMER = LPC24XX::TIMER(timerIndex);
+
+        if (LPC24_Signals_IsTimerInUse(timerIndex))
+            continue;
+
+        auto divider = TinyCLR_Signals_GetCaptureDivider(timeout, SIGNALS_TIMER_CLOCK_HZ, 32);
+
+        if (divider == 0)
+            return TinyCLR_Result::NotSupported;
+
+        auto& state = signalsCaptureState;
+
+        state.timerIndex = timerIndex;
+        state.channel = channel;
+        state.controller = self;
+        state.pin = pin;
+        state.driveMode = LPC24_Gpio_GetDriveMode(self, pin);
+        state.timestamps = timestamps;
+        state.count = count;
+        state.captured = 0;
+        state.completed = completed;
+        state.isActive = true;
+
+        auto pinMode = LPC24_Gpio_PinMode::Inactive;
+
+        if (state.driveMode == TinyCLR_Gpio_PinDriveMode::InputPullUp)
+            pinMode = LPC24_Gpio_PinMode::PullUp;
+        else if (state.driveMode == TinyCLR_Gpio_PinDriveMode::InputPullDown)
+            pinMode = LPC24_Gpio_PinMode::PullDown;
+
+        LPC24_GpioInternal_ConfigurePin(pin, LPC24_Gpio_Direction::Input, capturePins[i].pinFunction, pinMode);
+
+        LPC24XX::SYSCON().PCONP |= signalsTimerPowerBits[timerIndex];
+
+        TIMER.TCR = 2; // hold in reset
+        TIMER.PR = static_cast<uint32_t>(divider - 1);
+        TIMER.MCR = 0;
+        TIMER.IR = 0x3F;
+
+        LPC24_InterruptInternal_Activate(LPC24XX_TIMER::getIntNo(timerIndex), (uint32_t*)&LPC24_Signals_CaptureInterrupt, 0);
+
+        TIMER.CCR = 0x7 << (3 * channel); // rising and falling edge, interrupt
+        TIMER.TCR = LPC24XX_TIMER::TCR_TEN;
+
+        frequency = SIGNALS_TIMER_CLOCK_HZ / divider;
+
+        return TinyCLR_Result::Success;
+    }
+#endif
+
+    return TinyCLR_Result::NotSupported;
+}
+
+size_t LPC24_Signals_GetCaptureCount(const TinyCLR_Gpio_Controller* self) {
+    return signalsCaptureState.isActive ? signalsCaptureState.captured : 0;
+}
+
+size_t LPC24_Signals_StopCapture(const TinyCLR_Gpio_Controller* self) {
+    auto& state = signalsCaptureState;
+
+    if (!state.isActive)
+        return 0;
+
+    auto& TIMER = LPC24XX::TIMER(state.timerIndex);
+
+    TIMER.CCR = 0;
+    TIMER.TCR = 0;
+
+    LPC24_InterruptInternal_Deactivate(LPC24XX_TIMER::getIntNo(state.timerIndex));
+
+    TIMER.IR = 0x3F;
+
+    LPC24XX::SYSCON().PCONP &= ~signalsTimerPowerBits[state.timerIndex];
+
+    LPC24_Gpio_SetDriveMode(self, state.pin, state.driveMode);
+
+    state.isActive = false;
+
+    return state.captured;
+}
+
+static bool LPC24_Signals_FindMatchChannel(uint32_t pin, uint32_t& index) {
+#if defined(LPC24_SIGNALS_GENERATOR_PINS)
+    static const LPC24_Gpio_Pin matchPins[SIGNALS_TOTAL_TIMERS * SIGNALS_CHANNELS_PER_TIMER] = LPC24_SIGNALS_GENERATOR_PINS;
+
+    for (auto i = 0; i < SIGNALS_TOTAL_TIMERS * SIGNALS_CHANNELS_PER_TIMER; i++) {
+        if (matchPins[i].number != pin || LPC24_Signals_IsTimerInUse(i / SIGNALS_CHANNELS_PER_TIMER))
+            continue;
+
+        index = i;
+
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+TinyCLR_Result LPC24_Signals_GetGeneratorTiming(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint32_t& clock, uint32_t& counterBits) {
+    uint32_t index;
+
+    if (signalsGeneratorState.isActive || !LPC24_Signals_FindMatchChannel(pin, index))
+        return TinyCLR_Result::NotSupported;
+
+    clock = SIGNALS_TIMER_CLOCK_HZ;
+    counterBits = 32;
+
+    return TinyCLR_Result::Success;
+}
+
+static void LPC24_Signals_StopGenerator() {
+    auto& state = signalsGeneratorState;
+    auto& TIMER = LPC24XX::TIMER(state.timerIndex);
+
+    TIMER.TCR = 0;
+    TIMER.MCR = 0;
+
+    LPC24_InterruptInternal_Deactivate(LPC24XX_TIMER::getIntNo(state.timerIndex));
+
+    TIMER.IR = 0x3F;
+
+    // back to GPIO at idle before the match output lets go of the pin
+    LPC24_Gpio_Write(state.controller, state.pin, state.idleState);
+    LPC24_Gpio_SetDriveMode(state.controller, state.pin, state.driveMode);
+
+    TIMER.EMR = 0;
+
+    LPC24XX::SYSCON().PCONP &= ~signalsTimerPowerBits[state.timerIndex];
+
+    state.isActive = false;
+}
+
+void LPC24_Signals_GeneratorInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& state = signalsGeneratorState;
+    auto& TIMER = LPC24XX::TIMER(state.timerIndex);
+    auto flag = 1 << state.channel; // MRx interrupt flag
+
+    TIMER.IR = flag;
+
+    while (state.next < state.count) {
+        auto edge = state.edges[state.next++];
+
+        if (state.channel == 0)
+            TIMER.MR0 = edge;
+        else
+            TIMER.MR1 = edge;
+
+        if (TIMER.TC < edge)
+            return;
+
+        // the counter passed the edge while it was being loaded, toggle late rather than after a wrap
+        if (TIMER.IR & flag)
+            TIMER.IR = flag;
+        else
+            TIMER.EMR ^= flag;
+    }
+
+    LPC24_Signals_StopGenerator();
+
+    if (state.completed != nullptr)
+        state.completed(state.controller, state.pin, LPC24_Time_GetSystemTime(nullptr));
+}
+
+TinyCLR_Result LPC24_Signals_StartGenerator(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinValue idleState, uint32_t divider, const uint32_t* edges, size_t count, TinyCLR_Signals_GeneratorCompletedHandler completed) {
+#if defined(LPC24_SIGNALS_GENERATOR_PINS)
+    static const LPC24_Gpio_Pin matchPins[SIGNALS_TOTAL_TIMERS * SIGNALS_CHANNELS_PER_TIMER] = LPC24_SIGNALS_GENERATOR_PINS;
+
+    uint32_t index;
+
+    if (signalsGeneratorState.isActive || count == 0 || divider == 0 || !LPC24_Signals_FindMatchChannel(pin, index))
+        return TinyCLR_Result::NotSupported;
+
+    auto& state = signalsGeneratorState;
+    auto timerIndex = index / SIGNALS_CHANNELS_PER_TIMER;
+    auto& TIMER = LPC24XX::TIMER(timerIndex);
+
+    state.controller = self;
+    state.timerIndex = timerIndex;
+    state.channel = index % SIGNALS_CHANNELS_PER_TIMER;
+    state.pin = pin;
+    state.idleState = idleState;
+    state.driveMode = LPC24_Gpio_GetDriveMode(self, pin);
+    state.edges = edges;
+    state.count = count;
+    state.next = 1;
+    state.completed = completed;
+    state.isActive = true;
+
+    LPC24XX::SYSCON().PCONP |= signalsTimerPowerBits[timerIndex];
+
+    TIMER.TCR = 2; // hold in reset
+    TIMER.PR = divider - 1;
+    TIMER.IR = 0x3F;
+
+    // EMx starts at idle, EMCx = 3 toggles it on every match
+    TIMER.EMR = (idleState == TinyCLR_Gpio_PinValue::High ? (1 << state.channel) : 0) | (0x3 << (4 + 2 * state.channel));
+
+    if (state.channel == 0)
+        TIMER.MR0 = edges[0];
+    else
+        TIMER.MR1 = edges[0];
+
+    TIMER.MCR = 0x1 << (3 * state.channel); // interrupt on match
+
+    LPC24_GpioInternal_ConfigurePin(pin, LPC24_Gpio_Direction::Output, matchPins[index].pinFunction, LPC24_Gpio_PinMode::Inactive);
+
+    LPC24_InterruptInternal_Activate(LPC24XX_TIMER::getIntNo(timerIndex), (uint32_t*)&LPC24_Signals_GeneratorInterrupt, 0);
+
+    TIMER.TCR = LPC24XX_TIMER::TCR_TEN;
+
+    return TinyCLR_Result::Success;
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+bool LPC24_Signals_IsGeneratorActive(const TinyCLR_Gpio_Controller* self) {
+    return signalsGeneratorState.isActive;
+}
@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include "LPC24.h"
+#include "../../Drivers/Time/TimeDivider.h"
 
 #define TIMER_IDLE_VALUE  0x0000FFFFFFFFFFFFull
 
@@ -27,6 +28,9 @@
 #define SLOW_CLOCKS_TEN_MHZ_GCD              1000000 // GCD(SLOW_CLOCKS_PER_SECOND, 10M)
 #define SLOW_CLOCKS_MILLISECOND_GCD          1000 // GCD(SLOW_CLOCKS_PER_SECOND, 1k)
 
+static constexpr TimeDivider timeTicksDivider = TimeDivider_Create(SLOW_CLOCKS_PER_SECOND / SLOW_CLOCKS_TEN_MHZ_GCD);
+static constexpr TimeDivider timeTenDivider = TimeDivider_Create(10);
+
 //////////////////////////////////////////////////////////////////////////////
 // LPC24 TIMER state
 //
@@ -248,13 +252,13 @@ uint32_t LPC24_Time_GetSystemCycleClock(const TinyCLR_NativeTime_Controller* sel
 
 uint64_t LPC24_Time_GetTimeForProcessorTicks(const TinyCLR_NativeTime_Controller* self, uint64_t ticks) {
     ticks *= (10000000 / SLOW_CLOCKS_TEN_MHZ_GCD);
-    ticks /= (SLOW_CLOCKS_PER_SECOND / SLOW_CLOCKS_TEN_MHZ_GCD);
+    ticks = TimeDivider_Divide(ticks, timeTicksDivider);
 
     return ticks;
 }
 
 uint64_t LPC24_Time_GetProcessorTicksForTime(const TinyCLR_NativeTime_Controller* self, uint64_t time) {
-    return LPC24_Time_MicrosecondsToTicks(self, time / 10);
+    return LPC24_Time_MicrosecondsToTicks(self, TimeDivider_Divide(time, timeTenDivider));
 }
 
 uint64_t LPC24_Time_GetCurrentProcessorTime() {
@@ -440,7 +444,7 @@ void LPC24_Time_Delay(const TinyCLR_NativeTime_Controller* self, uint64_t micros
 void LPC24_Time_DelayNative(const TinyCLR_NativeTime_Controller* self, uint64_t nativeTime) {
     //TODO do inline later, don't call out to Delay
 
-    auto microseconds = LPC24_Time_GetTimeForProcessorTicks(self, nativeTime) / 10;
+    auto microseconds = TimeDivider_Divide(LPC24_Time_GetTimeForProcessorTicks(self, nativeTime), timeTenDivider);
 
     LPC24_Time_Delay(self, microseconds);
 }
@@ -208,7 +208,7 @@ bool LPC24_UsbDevice_Initialize(UsbClientState *usbClientState) {
     for (int32_t i = 0; i < LPC24_USB_ENDPOINT_COUNT; i++)
         EndpointInit[i].word = 0;       // All useable endpoints initialize to unused
 
-    for (auto pipe = 0; pipe < LPC24_USB_ENDPOINT_COUNT; pipe++) {
+    for (auto pipe = 0; pipe < LPC24_USB_PIPE_COUNT; pipe++) {
         auto idx = 0;
         if (usbClientState->pipes[pipe].RxEP != USB_ENDPOINT_NULL) {
             idx = usbClientState->pipes[pipe].RxEP;
@@ -542,22 +542,23 @@ void LPC24_UsbDevice_TxPacket(UsbClientState* usbClientState, int32_t endpoint)
     DISABLE_INTERRUPTS_SCOPED(irq);
 
     // transmit a packet on UsbPortNum, if there are no more packets to transmit, then die
-    USB_PACKET64* Packet64;
+    uint8_t* packet;
+    uint32_t size;
 
     for (;;) {
-        Packet64 = TinyCLR_UsbClient_TxDequeue(usbClientState, endpoint);
+        packet = TinyCLR_UsbClient_TxDequeue(usbClientState, endpoint, size);
 
-        if (Packet64 == nullptr || Packet64->Size > 0) {
+        if (packet == nullptr || size > 0) {
             break;
         }
     }
 
-    if (Packet64) {
+    if (packet) {
 
-        USB_WriteEP(endpoint, Packet64->Buffer, Packet64->Size);
+        USB_WriteEP(endpoint, packet, size);
 
         usbDeviceControllers[usbClientState->controllerIndex].txNeedZLPS[endpoint] = false;
-        if (Packet64->Size == 64)
+        if (size == 64)
             usbDeviceControllers[usbClientState->controllerIndex].txNeedZLPS[endpoint] = true;
     }
     else {
@@ -752,6 +753,21 @@ void LPC24_UsbDevice_ProcessEP0(UsbClientState *usbClientState, int32_t in, int3
             LPC24_UsbDevice_SetAddress(LPC24_UsbDevice_DeviceAddress);
         }
     }
+    else {
+        // data stage of a control write, or the status stage of a control read when empty
+        usbClientState->ptrData = &usbClientState->controlEndpointBuffer[0];
+        usbClientState->dataSize = LPC24_UsbDevice_ReadEP(0x00, usbClientState->controlEndpointBuffer);
+
+        if (usbClientState->dataSize > 0) {
+            if (TinyCLR_UsbClient_ControlOutCallback(usbClientState) == USB_STATE_STALL) {
+                LPC24_UsbDevice_SetStallEP(0, 0);
+                LPC24_UsbDevice_SetStallEP(0, 1);
+            }
+            else {
+                LPC24_UsbDevice_ControlNext(usbClientState);
+            }
+        }
+    }
 }
 
 void LPC24_UsbDevice_Enpoint_TxInterruptHandler(UsbClientState *usbClientState, uint32_t endpoint) {
@@ -772,17 +788,16 @@ void LPC24_UsbDevice_Enpoint_TxInterruptHandler(UsbClientState *usbClientState,
 
 void LPC24_UsbDevice_Enpoint_RxInterruptHandler(UsbClientState *usbClientState, uint32_t endpoint) {
     bool          DisableRx;
-    USB_PACKET64* Packet64 = TinyCLR_UsbClient_RxEnqueue(usbClientState, endpoint, DisableRx);
+    uint8_t*      packet = TinyCLR_UsbClient_RxEnqueue(usbClientState, endpoint, DisableRx);
 
-    /* copy packet in, making sure that Packet64->Buffer is never overflowed */
-    if (Packet64) {
+    /* copy packet in, RxEnqueue always leaves room for a whole packet */
+    if (packet) {
         uint8_t   len = 0;//USB.UDCBCRx[EPno] & LPC24xx_USB::UDCBCR_mask;
-        uint32_t* packetBuffer = (uint32_t*)Packet64->Buffer;
-        len = LPC24_UsbDevice_ReadEP(endpoint, Packet64->Buffer);
+        len = LPC24_UsbDevice_ReadEP(endpoint, packet);
 
         // clear packet status
         nacking_rx_OUT_data[endpoint] = 0;
-        Packet64->Size = len;
+        TinyCLR_UsbClient_RxCommit(usbClientState, endpoint, len);
     }
     else {
         /* flow control should absolutely protect us from ever
@@ -878,6 +893,11 @@ uint64_t TinyCLR_UsbClient_Now() {
     return LPC24_Time_GetSystemTime(nullptr);
 }
 
+// WaitForInterrupt only lets pending interrupts run here, it doesn't sleep and the writer sees its deadline pass
+void TinyCLR_UsbClient_ScheduleWakeup(uint64_t time) {
+
+}
+
 void TinyCLR_UsbClient_InitializeConfiguration(UsbClientState *usbClientState) {
     LPC24_UsbDevice_InitializeConfiguration(usbClientState);
 }
@@ -64,6 +64,8 @@ TinyCLR_Result STM32F4_Power_Initialize(const TinyCLR_Power_Controller* self);
 TinyCLR_Result STM32F4_Power_Uninitialize(const TinyCLR_Power_Controller* self);
 TinyCLR_Result STM32F4_Power_Reset(const TinyCLR_Power_Controller* self, bool runCoreAfter);
 TinyCLR_Result STM32F4_Power_SetLevel(const TinyCLR_Power_Controller* self, TinyCLR_Power_Level level, TinyCLR_Power_WakeSource wakeSource, uint64_t data);
+bool STM32F4_Power_Stop();
+uint32_t STM32F4_Power_GetWakeupCounts(uint64_t idleTime);
 
 ////////////////////////////////////////////////////////////////////////////////
 //Time
@@ -81,6 +83,9 @@ TinyCLR_Result STM32F4_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Con
 void STM32F4_Time_Delay(const TinyCLR_NativeTime_Controller* self, uint64_t microseconds);
 void STM32F4_Time_DelayNative(const TinyCLR_NativeTime_Controller* self, uint64_t nativeTime);
 uint64_t STM32F4_Time_GetSystemTime(const TinyCLR_NativeTime_Controller* self);
+uint64_t STM32F4_Time_GetNextTickCallbackTime();
+void STM32F4_Time_AddProcessorTicks(uint64_t processorTicks);
+void STM32F4_Time_ScheduleWakeup(uint64_t processorTicks);
 
 ////////////////////////////////////////////////////////////////////////////////
 //Startup
@@ -94,6 +99,8 @@ void STM32F4_Startup_GetRunApp(bool& runApp);
 ////////////////////////////////////////////////////////////////////////////////
 //ADC
 ////////////////////////////////////////////////////////////////////////////////
+struct TinyCLR_Adc_SamplingPolicy;
+
 void STM32F4_Adc_AddApi(const TinyCLR_Api_Manager* apiManager);
 TinyCLR_Result STM32F4_Adc_Acquire(const TinyCLR_Adc_Controller* self);
 TinyCLR_Result STM32F4_Adc_Release(const TinyCLR_Adc_Controller* self);
@@ -107,6 +114,11 @@ int32_t STM32F4_Adc_GetMinValue(const TinyCLR_Adc_Controller* self);
 int32_t STM32F4_Adc_GetMaxValue(const TinyCLR_Adc_Controller* self);
 uint32_t STM32F4_Adc_GetResolutionInBits(const TinyCLR_Adc_Controller* self);
 uint32_t STM32F4_Adc_GetChannelCount(const TinyCLR_Adc_Controller* self);
+TinyCLR_Result STM32F4_Adc_StartStream(const TinyCLR_Adc_Controller* self, const uint32_t* channels, size_t channelCount, uint32_t frequency, uint16_t* buffer, size_t length, void(*handler)(const TinyCLR_Adc_Controller* self, uint64_t written, uint64_t timestamp));
+uint64_t STM32F4_Adc_GetStreamWritten(const TinyCLR_Adc_Controller* self);
+TinyCLR_Result STM32F4_Adc_StopStream(const TinyCLR_Adc_Controller* self);
+TinyCLR_Result STM32F4_Adc_SetSampling(const TinyCLR_Adc_Controller* self, uint32_t channel, const TinyCLR_Adc_SamplingPolicy& policy);
+TinyCLR_Result STM32F4_Adc_GetSampling(const TinyCLR_Adc_Controller* self, uint32_t channel, TinyCLR_Adc_SamplingPolicy& policy);
 void STM32F4_Adc_Reset();
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -153,6 +165,10 @@ int32_t STM32F4_Dac_GetMinValue(const TinyCLR_Dac_Controller* self);
 int32_t STM32F4_Dac_GetMaxValue(const TinyCLR_Dac_Controller* self);
 uint32_t STM32F4_Dac_GetResolutionInBits(const TinyCLR_Dac_Controller* self);
 uint32_t STM32F4_Dac_GetChannelCount(const TinyCLR_Dac_Controller* self);
+TinyCLR_Result STM32F4_Dac_StartStream(const TinyCLR_Dac_Controller* self, uint32_t channel, uint32_t frequency, const uint32_t* buffer, size_t length, void(*handler)(const TinyCLR_Dac_Controller* self, uint32_t channel, uint64_t played, uint64_t timestamp));
+uint64_t STM32F4_Dac_GetStreamPlayed(const TinyCLR_Dac_Controller* self, uint32_t channel);
+TinyCLR_Result STM32F4_Dac_StopStream(const TinyCLR_Dac_Controller* self, uint32_t channel);
+void STM32F4_Dac_EncodeStream(const TinyCLR_Dac_Controller* self, uint32_t channel, const int32_t* values, uint32_t* words, size_t count);
 void STM32F4_Dac_Reset();
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -173,6 +189,8 @@ uint64_t STM32F4_Gpio_GetDebounceTimeout(const TinyCLR_Gpio_Controller* self, ui
 TinyCLR_Result STM32F4_Gpio_SetDebounceTimeout(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t debounceTicks);
 TinyCLR_Result STM32F4_Gpio_SetPinChangedHandler(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinChangeEdge edge, TinyCLR_Gpio_PinChangedHandler handler);
 uint32_t STM32F4_Gpio_GetPinCount(const TinyCLR_Gpio_Controller* self);
+TinyCLR_Result STM32F4_Gpio_ReadPort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t& value);
+TinyCLR_Result STM32F4_Gpio_WritePort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t value);
 void STM32F4_Gpio_Reset();
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -197,6 +215,11 @@ TinyCLR_Result STM32F4_Pwm_EnableChannel(const TinyCLR_Pwm_Controller* self, uin
 TinyCLR_Result STM32F4_Pwm_DisableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel);
 TinyCLR_Result STM32F4_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* self, uint32_t channel, double dutyCycle, TinyCLR_Pwm_PulsePolarity polarity);
 TinyCLR_Result STM32F4_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Controller* self, double& frequency);
+TinyCLR_Result STM32F4_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Controller* self, const uint32_t* channels, const double* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count);
+TinyCLR_Result STM32F4_Pwm_EncodeBurst(const TinyCLR_Pwm_Controller* self, uint32_t channel, const double* dutyCycles, uint32_t* pulses, size_t count, size_t stride);
+TinyCLR_Result STM32F4_Pwm_StartBurst(const TinyCLR_Pwm_Controller* self, uint32_t firstChannel, uint32_t channelCount, const uint32_t* pulses, size_t sets, bool looped, void(*completed)(const TinyCLR_Pwm_Controller* self, uint64_t timestamp));
+bool STM32F4_Pwm_IsBurstActive(const TinyCLR_Pwm_Controller* self);
+TinyCLR_Result STM32F4_Pwm_StopBurst(const TinyCLR_Pwm_Controller* self);
 double STM32F4_Pwm_GetMinFrequency(const TinyCLR_Pwm_Controller* self);
 double STM32F4_Pwm_GetMaxFrequency(const TinyCLR_Pwm_Controller* self);
 double STM32F4_Pwm_GetActualFrequency(const TinyCLR_Pwm_Controller* self);
@@ -212,6 +235,12 @@ TinyCLR_Result STM32F4_Rtc_Release(const TinyCLR_Rtc_Controller* self);
 TinyCLR_Result STM32F4_Rtc_IsValid(const TinyCLR_Rtc_Controller* self, bool& value);
 TinyCLR_Result STM32F4_Rtc_GetTime(const TinyCLR_Rtc_Controller* self, TinyCLR_Rtc_DateTime& value);
 TinyCLR_Result STM32F4_Rtc_SetTime(const TinyCLR_Rtc_Controller* self, TinyCLR_Rtc_DateTime value);
+TinyCLR_Result STM32F4_Rtc_Configuration();
+TinyCLR_Result STM32F4_Rtc_Initialize();
+TinyCLR_Result STM32F4_Rtc_CheckPrescaler();
+TinyCLR_Result STM32F4_Rtc_WaitForSynchro();
+void STM32F4_Rtc_SetWriteProtection(bool set);
+uint8_t STM32F4_Rtc_Bcd2ToByte(uint8_t value);
 
 ////////////////////////////////////////////////////////////////////////////////
 //SD
@@ -230,6 +259,31 @@ TinyCLR_Result STM32F4_SdCard_Open(const TinyCLR_Storage_Controller* self);
 TinyCLR_Result STM32F4_SdCard_Close(const TinyCLR_Storage_Controller* self);
 TinyCLR_Result STM32F4_SdCard_Reset();
 
+////////////////////////////////////////////////////////////////////////////////
+//Signals
+////////////////////////////////////////////////////////////////////////////////
+void STM32F4_Signals_AddApi(const TinyCLR_Api_Manager* apiManager);
+TinyCLR_Result STM32F4_Signals_StartCapture(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timeout, uint32_t* timestamps, size_t count, uint64_t& frequency, void(*completed)(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timestamp));
+size_t STM32F4_Signals_GetCaptureCount(const TinyCLR_Gpio_Controller* self);
+size_t STM32F4_Signals_StopCapture(const TinyCLR_Gpio_Controller* self);
+TinyCLR_Result STM32F4_Signals_GetGeneratorTiming(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint32_t& clock, uint32_t& counterBits);
+TinyCLR_Result STM32F4_Signals_StartGenerator(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinValue idleState, uint32_t divider, const uint32_t* edges, size_t count, void(*completed)(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timestamp));
+bool STM32F4_Signals_IsGeneratorActive(const TinyCLR_Gpio_Controller* self);
+
+////////////////////////////////////////////////////////////////////////////////
+//Encoder
+////////////////////////////////////////////////////////////////////////////////
+struct TinyCLR_Encoder_Settings;
+struct TinyCLR_Encoder_Counter;
+
+void STM32F4_Encoder_AddApi(const TinyCLR_Api_Manager* apiManager);
+uint32_t STM32F4_Encoder_GetEncoderCount(const TinyCLR_Gpio_Controller* self);
+TinyCLR_Result STM32F4_Encoder_Open(const TinyCLR_Gpio_Controller* self, uint32_t encoder, const TinyCLR_Encoder_Settings& settings);
+TinyCLR_Result STM32F4_Encoder_Close(const TinyCLR_Gpio_Controller* self, uint32_t encoder);
+TinyCLR_Result STM32F4_Encoder_Read(const TinyCLR_Gpio_Controller* self, uint32_t encoder, TinyCLR_Encoder_Counter& counter, uint64_t& timestamp);
+TinyCLR_Result STM32F4_Encoder_SetPosition(const TinyCLR_Gpio_Controller* self, uint32_t encoder, int64_t position);
+void STM32F4_Encoder_Reset();
+
 ////////////////////////////////////////////////////////////////////////////////
 //SPI
 ////////////////////////////////////////////////////////////////////////////////
@@ -283,16 +337,19 @@ void STM32F4_UsbDevice_AddApi(const TinyCLR_Api_Manager* apiManager);
 const TinyCLR_Api_Info* STM32F4_UsbDevice_GetRequiredApi();
 void STM32F4_UsbDevice_Reset();
 
-struct USB_PACKET64;
 struct UsbClientState;
 typedef void(*USB_NEXT_CALLBACK)(UsbClientState*);
 
 void TinyCLR_UsbClient_ClearEvent(UsbClientState *usbClientState, uint32_t event);
 void TinyCLR_UsbClient_ClearEndpoints(UsbClientState *usbClientState, int32_t endpoint);
-USB_PACKET64* TinyCLR_UsbClient_RxEnqueue(UsbClientState* usbClientState, int32_t endpoint, bool& disableRx);
-USB_PACKET64* TinyCLR_UsbClient_TxDequeue(UsbClientState* usbClientState, int32_t endpoint);
+uint8_t* TinyCLR_UsbClient_RxEnqueue(UsbClientState* usbClientState, int32_t endpoint, bool& disableRx);
+void TinyCLR_UsbClient_RxCommit(UsbClientState* usbClientState, int32_t endpoint, uint32_t size);
+uint8_t* TinyCLR_UsbClient_TxDequeue(UsbClientState* usbClientState, int32_t endpoint, uint32_t& size);
+int32_t TinyCLR_UsbClient_TxPeek(UsbClientState* usbClientState, int32_t endpoint, int32_t index);
+uint32_t TinyCLR_UsbClient_GetTxPacketCount(UsbClientState* usbClientState, int32_t endpoint, uint32_t maxPackets, uint32_t& size);
 void TinyCLR_UsbClient_StateCallback(UsbClientState* usbClientState);
 uint8_t TinyCLR_UsbClient_ControlCallback(UsbClientState* usbClientState);
+uint8_t TinyCLR_UsbClient_ControlOutCallback(UsbClientState* usbClientState);
 bool TinyCLR_UsbClient_CanReceivePackage(UsbClientState* usbClientState, int32_t endpoint);
 bool TinyCLR_UsbClient_Initialize(UsbClientState* usbClientState);
 bool TinyCLR_UsbClient_Uninitialize(UsbClientState* usbClientState);
@@ -321,9 +378,38 @@ public:
 #define DISABLE_INTERRUPTS_SCOPED(name) STM32F4_DisableInterrupts_RaiiHelper name
 #define INTERRUPT_STARTED_SCOPED(name) STM32F4_InterruptStarted_RaiiHelper name
 
+// Interrupt profiler: exception numbers from IPSR, DWT cycles
+#define INTERRUPT_PROFILER_VECTORS (16 + 96)
+#define INTERRUPT_PROFILER_COUNTS_PER_SECOND STM32F4_AHB_CLOCK_HZ
+
 bool STM32F4_InterruptInternal_Activate(uint32_t index, uint32_t* isr, void* isrParam);
 bool STM32F4_InterruptInternal_Deactivate(uint32_t index);
 
+// Vectors more than one driver needs at a time, TIM1_UP_TIM10 serves the TIM1 and the TIM10 update. Each user
+// adds a handler rather than taking the vector over, the vector stays enabled while any handler is added. The
+// handlers run with the interrupt started and check their own flags.
+typedef void(*STM32F4_InterruptHandler)(void* param);
+
+bool STM32F4_InterruptInternal_AddShared(uint32_t index, STM32F4_InterruptHandler handler, void* param);
+bool STM32F4_InterruptInternal_RemoveShared(uint32_t index, STM32F4_InterruptHandler handler, void* param);
+
+////////////////////////////////////////////////////////////////////////////////
+//DMA Internal
+////////////////////////////////////////////////////////////////////////////////
+struct STM32F4_Dma_Request {
+    uint8_t controller;
+    uint8_t stream;
+    uint8_t channel;
+};
+
+bool STM32F4_DmaInternal_Acquire(const STM32F4_Dma_Request& request);
+void STM32F4_DmaInternal_Release(const STM32F4_Dma_Request& request);
+void STM32F4_DmaInternal_Start(const STM32F4_Dma_Request& request, uint32_t peripheralAddress, uint32_t memoryAddress, size_t count, uint32_t configuration);
+void STM32F4_DmaInternal_Stop(const STM32F4_Dma_Request& request);
+size_t STM32F4_DmaInternal_GetRemaining(const STM32F4_Dma_Request& request);
+uint32_t STM32F4_DmaInternal_GetInterrupt(const STM32F4_Dma_Request& request);
+uint32_t STM32F4_DmaInternal_ReadAndClearFlags(const STM32F4_Dma_Request& request);
+
 ////////////////////////////////////////////////////////////////////////////////
 //GPIO Internal
 ////////////////////////////////////////////////////////////////////////////////
@@ -15,14 +15,19 @@
 // limitations under the License.
 
 #include "STM32F4.h"
+#include "../../Drivers/DevicesInterop/Adc/GHIElectronics_TinyCLR_Devices_Adc_Stream.h"
+#include "../../Drivers/DevicesInterop/Adc/GHIElectronics_TinyCLR_Devices_Adc_Sampling.h"
 
 #define STM32F4_AD_SAMPLE_TIME 4   // sample time = 84 cycles
+#define STM32F4_AD_SAMPLE_COUNT 5
+#define STM32F4_AD_CONVERSION_CYCLES 12 // on top of the sample time
 
 #define STM32F4_ADC 1
 
 #if STM32F4_ADC == 1
 #define ADCx ADC1
 #define RCC_APB2ENR_ADCxEN RCC_APB2ENR_ADC1EN
+#define STM32F4_ADC_DMA { 2, 0, 0 }
 // ADC1 pins plus two internally connected channels thus the 0 for 'no pin'
 // Vsense for temperature sensor @ ADC1_IN16
 // Vrefubt for internal voltage reference (1.21V) @ ADC1_IN17
@@ -31,6 +36,7 @@
 #elif STM32F4_ADC == 3
 #define ADCx ADC3
 #define RCC_APB2ENR_ADCxEN RCC_APB2ENR_ADC3EN
+#define STM32F4_ADC_DMA { 2, 0, 2 }
 #define STM32F4_ADC_PINS {0,1,2,3,86,87,88,89,90,83,32,33,34,35,84,85,0,0} // ADC3 pins
 #else
 #error wrong STM32F4_ADC value (1 or 3)
@@ -43,8 +49,25 @@
 
 #define TOTAL_ADC_CONTROLLERS 1
 
+#if STM32F4_APB1_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define ADC_APB1_TIMER_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ)
+#else
+#define ADC_APB1_TIMER_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ * 2)
+#endif
+
+#if STM32F4_APB2_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define ADC_APB2_TIMER_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ)
+#else
+#define ADC_APB2_TIMER_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ * 2)
+#endif
+
+#define ADC_STREAM_EVENT_POST_DEBOUNCE_TICKS (10 * 10000) // 10ms between each events
+
 static const uint8_t adcPins[] = STM32F4_ADC_PINS;
 
+// ADCCLK cycles of each SMPR sample time selection
+static const uint16_t adcSampleCycles[] = { 3, 15, 28, 56, 84, 112, 144, 480 };
+
 static TinyCLR_Adc_Controller adcControllers[TOTAL_ADC_CONTROLLERS];
 static TinyCLR_Api_Info adcApi[TOTAL_ADC_CONTROLLERS];
 
@@ -54,10 +77,49 @@ const char* adcApiNames[TOTAL_ADC_CONTROLLERS] = {
 
 struct AdcState {
     bool isOpen[STM32F4_AD_NUM];
+
+    TinyCLR_Adc_SamplingPolicy sampling[STM32F4_AD_NUM];
+    uint16_t samples[TINYCLR_ADC_SAMPLING_MAX_COUNT];
 };
 
 static AdcState adcStates[TOTAL_ADC_CONTROLLERS];
 
+// Timers whose update can start the regular sequence through TRGO, as { timer, EXTSEL }
+struct AdcStreamTrigger {
+    uint8_t timer;
+    uint8_t externalSelection;
+};
+
+static const AdcStreamTrigger adcStreamTriggers[] = {
+    { 3, 8 },
+    { 2, 6 },
+#if !defined(STM32F401xE) && !defined(STM32F411xE)
+    { 8, 14 },
+#endif
+};
+
+static const STM32F4_Dma_Request adcStreamDma = STM32F4_ADC_DMA;
+
+struct AdcStreamState {
+    bool isActive;
+
+    const TinyCLR_Adc_Controller* controller;
+    TIM_TypeDef* timReg;
+
+    size_t half;
+    volatile uint64_t written;
+    uint64_t reported;
+
+    TinyCLR_Adc_StreamHandler handler;
+    const TinyCLR_Task_Manager* taskManager;
+    TinyCLR_Task_Reference taskReference;
+};
+
+static AdcStreamState adcStreamState;
+
+static const TinyCLR_Adc_StreamApi adcStreamApi = { &STM32F4_Adc_StartStream, &STM32F4_Adc_GetStreamWritten, &STM32F4_Adc_StopStream };
+static const TinyCLR_Adc_SamplingApi adcSamplingApi = { &STM32F4_Adc_SetSampling, &STM32F4_Adc_GetSampling };
+
 void STM32F4_Adc_AddApi(const TinyCLR_Api_Manager* apiManager) {
     for (int32_t i = 0; i < TOTAL_ADC_CONTROLLERS; i++) {
         adcControllers[i].ApiInfo = &adcApi[i];
@@ -81,10 +143,39 @@ void STM32F4_Adc_AddApi(const TinyCLR_Api_Manager* apiManager) {
         adcApi[i].Implementation = &adcControllers[i];
         adcApi[i].State = &adcStates[i];
 
+        for (auto ch = 0; ch < STM32F4_AD_NUM; ch++) {
+            adcStates[i].sampling[ch].SampleTime = STM32F4_AD_SAMPLE_TIME;
+            adcStates[i].sampling[ch].SampleCount = STM32F4_AD_SAMPLE_COUNT;
+            adcStates[i].sampling[ch].Filter = TinyCLR_Adc_SamplingFilter::Mean;
+        }
+
         apiManager->Add(apiManager, &adcApi[i]);
     }
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::AdcController, adcApi[0].Name);
+
+    TinyCLR_Adc_SetStreamApi(&adcControllers[0], &adcStreamApi);
+    TinyCLR_Adc_SetSamplingApi(&adcControllers[0], &adcSamplingApi);
+}
+
+static void STM32F4_Adc_SetSampleTime(uint32_t channel, uint32_t sampleTime) {
+    if (channel < 10)
+        ADCx->SMPR2 = (ADCx->SMPR2 & ~(7 << (3 * channel))) | (sampleTime << (3 * channel));
+    else
+        ADCx->SMPR1 = (ADCx->SMPR1 & ~(7 << (3 * (channel - 10)))) | (sampleTime << (3 * (channel - 10)));
+}
+
+static uint32_t STM32F4_Adc_GetExtraBits(const AdcState* state) {
+    uint32_t bits = 0;
+
+    for (auto ch = 0; ch < STM32F4_AD_NUM; ch++) {
+        auto channelBits = TinyCLR_Adc_GetSamplingExtraBits(state->sampling[ch]);
+
+        if (state->isOpen[ch] && channelBits > bits)
+            bits = channelBits;
+    }
+
+    return bits;
 }
 
 TinyCLR_Result STM32F4_Adc_Acquire(const TinyCLR_Adc_Controller* self) {
@@ -115,6 +206,8 @@ TinyCLR_Result STM32F4_Adc_OpenChannel(const TinyCLR_Adc_Controller* self, uint3
                 ADCx->SMPR2 = 0x09249249 * STM32F4_AD_SAMPLE_TIME;
             }
 
+            STM32F4_Adc_SetSampleTime(channel, state->sampling[channel].SampleTime);
+
             // set pin as analog input if channel is not one of the internally connected
             if (channel <= 15) {
                 STM32F4_GpioInternal_ConfigurePin(adcPins[channel], STM32F4_Gpio_PortMode::Analog, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, STM32F4_Gpio_PullDirection::None, STM32F4_Gpio_AlternateFunction::AF0);
@@ -134,6 +227,9 @@ TinyCLR_Result STM32F4_Adc_OpenChannel(const TinyCLR_Adc_Controller* self, uint3
 TinyCLR_Result STM32F4_Adc_CloseChannel(const TinyCLR_Adc_Controller* self, uint32_t channel) {
     auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
 
+    if (adcStreamState.isActive)
+        return TinyCLR_Result::Busy;
+
     // free GPIO pin if this channel is listed in the STM32F4_AD_CHANNELS array
     // and if it's not one of the internally connected ones as these channels don't take any GPIO pins
     if (channel <= 15 && channel < STM32F4_AD_NUM)
@@ -145,54 +241,117 @@ TinyCLR_Result STM32F4_Adc_CloseChannel(const TinyCLR_Adc_Controller* self, uint
     return TinyCLR_Result::Success;
 }
 
+// Converts channel count times. Beyond one sample a scan of up to 16 conversions of the channel runs per
+// trigger and DMA moves the results, the CPU only waits for the last one.
+static void STM32F4_Adc_Sample(uint32_t channel, uint16_t* samples, size_t count) {
+    if (count > 1 && STM32F4_DmaInternal_Acquire(adcStreamDma)) {
+        STM32F4_DmaInternal_Start(adcStreamDma, (uint32_t)&ADCx->DR, (uint32_t)samples, count, DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC);
+
+        ADCx->SQR3 = channel * 0x02108421; // SQ1 to SQ6
+        ADCx->SQR2 = channel * 0x02108421; // SQ7 to SQ12
+        ADCx->CR1 = ADC_CR1_SCAN;
+        ADCx->CR2 = ADC_CR2_ADON | ADC_CR2_DMA;
+
+        for (size_t done = 0; done < count;) {
+            auto batch = (count - done) > 16 ? 16 : (count - done);
+
+            ADCx->SQR1 = ((batch - 1) << ADC_SQR1_L_Pos) | (channel * 0x8421); // SQ13 to SQ16
+
+            ADCx->CR2 |= ADC_CR2_SWSTART;
+
+            done += batch;
+
+            while (STM32F4_DmaInternal_GetRemaining(adcStreamDma) > count - done);
+        }
+
+        ADCx->CR2 = ADC_CR2_ADON;
+        ADCx->CR1 = 0;
+        ADCx->SQR1 = 0;
+
+        STM32F4_DmaInternal_Release(adcStreamDma);
+
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        int x = ADCx->DR; // clear EOC flag
+
+        ADCx->SQR3 = channel; // select channel
+
+        ADCx->CR2 |= ADC_CR2_SWSTART; // start AD
+        while (!(ADCx->SR & ADC_SR_EOC)); // wait for completion
+
+        samples[i] = (ADCx->DR) & 0xFFF; // read result
+    }
+}
+
 TinyCLR_Result STM32F4_Adc_ReadChannel(const TinyCLR_Adc_Controller* self, uint32_t channel, int32_t& value) {
+    auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
+
+    value = 0;
+
+    if (adcStreamState.isActive)
+        return TinyCLR_Result::Busy;
+
     // check if this channel is listed in the STM32F4_AD_CHANNELS array
-    const int MAX_SAMPLE_TIMES = 5;
+    if (channel >= STM32F4_AD_NUM)
+        return TinyCLR_Result::ArgumentOutOfRange;
 
-    int samples = MAX_SAMPLE_TIMES;
+    auto& policy = state->sampling[channel];
 
-    value = 0;
+    // need to enable internal reference at ADC->CCR register to work with internally connected channels
+    if (channel == 16 || channel == 17) {
+        ADC->CCR |= ADC_CCR_TSVREFE; // Enable internal reference to work with temperature sensor and VREFINT channels
+    }
 
-    for (int i = 0; i < STM32F4_AD_NUM; i++) {
-        if (i == channel) { // valid channel
-            while (samples-- > 0) {
+    STM32F4_Adc_Sample(channel, state->samples, policy.SampleCount);
 
-                int x = ADCx->DR; // clear EOC flag
+    // disable internally reference
+    if (channel == 16 || channel == 17) {
+        ADC->CCR &= ~ADC_CCR_TSVREFE;
+    }
 
-                ADCx->SQR3 = channel; // select channel
+    // every channel reads at the controller's resolution
+    value = TinyCLR_Adc_FilterSamples(policy, state->samples, policy.SampleCount) << (STM32F4_Adc_GetExtraBits(state) - TinyCLR_Adc_GetSamplingExtraBits(policy));
 
-                // need to enable internal reference at ADC->CCR register to work with internally connected channels
-                if (channel == 16 || channel == 17) {
-                    ADC->CCR |= ADC_CCR_TSVREFE; // Enable internal reference to work with temperature sensor and VREFINT channels
-                }
+    return TinyCLR_Result::Success;
+}
 
-                ADCx->CR2 |= ADC_CR2_SWSTART; // start AD
-                while (!(ADCx->SR & ADC_SR_EOC)); // wait for completion
+TinyCLR_Result STM32F4_Adc_SetSampling(const TinyCLR_Adc_Controller* self, uint32_t channel, const TinyCLR_Adc_SamplingPolicy& policy) {
+    auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
 
-                // disable internally reference
-                if (channel == 16 || channel == 17) {
-                    ADC->CCR &= ~ADC_CCR_TSVREFE;
-                }
+    if (channel >= STM32F4_AD_NUM || policy.SampleTime >= SIZEOF_ARRAY(adcSampleCycles) || !TinyCLR_Adc_IsSamplingValid(policy))
+        return TinyCLR_Result::ArgumentOutOfRange;
 
-                value += (ADCx->DR) & 0xFFF; // read result
-            }
+    if (adcStreamState.isActive)
+        return TinyCLR_Result::Busy;
 
-            value /= MAX_SAMPLE_TIMES;
+    state->sampling[channel] = policy;
 
-            return TinyCLR_Result::Success;
-        }
-    }
+    if (RCC->APB2ENR & RCC_APB2ENR_ADCxEN)
+        STM32F4_Adc_SetSampleTime(channel, policy.SampleTime);
 
-    // channel not available
-    return TinyCLR_Result::ArgumentOutOfRange;
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Adc_GetSampling(const TinyCLR_Adc_Controller* self, uint32_t channel, TinyCLR_Adc_SamplingPolicy& policy) {
+    auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
+
+    if (channel >= STM32F4_AD_NUM)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    policy = state->sampling[channel];
+
+    return TinyCLR_Result::Success;
 }
 
 uint32_t STM32F4_Adc_GetChannelCount(const TinyCLR_Adc_Controller* self) {
     return STM32F4_AD_NUM;
 }
 
+// Not fixed: a decimating policy on an open channel adds its extra bits, see TinyCLR_Adc_SamplingApi
 uint32_t STM32F4_Adc_GetResolutionInBits(const TinyCLR_Adc_Controller* self) {
-    return 12;
+    return 12 + STM32F4_Adc_GetExtraBits(reinterpret_cast<AdcState*>(self->ApiInfo->State));
 }
 
 int32_t STM32F4_Adc_GetMinValue(const TinyCLR_Adc_Controller* self) {
@@ -215,7 +374,202 @@ bool STM32F4_Adc_IsChannelModeSupported(const TinyCLR_Adc_Controller* self, Tiny
     return mode == TinyCLR_Adc_ChannelMode::SingleEnded;
 }
 
+static TIM_TypeDef* STM32F4_Adc_GetTriggerTimer(uint32_t timer) {
+    switch (timer) {
+    case 2: return TIM2;
+    case 3: return TIM3;
+#if !defined(STM32F401xE) && !defined(STM32F411xE)
+    case 8: return TIM8;
+#endif
+    }
+
+    return nullptr;
+}
+
+static __IO uint32_t* STM32F4_Adc_GetTimerClockEnable(TIM_TypeDef* treg, uint32_t& enBit) {
+    enBit = 1 << (((uint32_t)treg >> 10) & 0x1F);
+
+    return ((uint32_t)treg & 0x10000) ? &RCC->APB2ENR : &RCC->APB1ENR;
+}
+
+static void STM32F4_Adc_StreamInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto flags = STM32F4_DmaInternal_ReadAndClearFlags(adcStreamDma);
+
+    // both halves may have filled by the time this runs
+    if (flags & DMA_LISR_HTIF0)
+        adcStreamState.written += adcStreamState.half;
+
+    if (flags & DMA_LISR_TCIF0)
+        adcStreamState.written += adcStreamState.half;
+}
+
+static void STM32F4_Adc_StreamCallback(const TinyCLR_Task_Manager* self, const TinyCLR_Api_Manager* apiManager, TinyCLR_Task_Reference task, void* arg) {
+    auto state = reinterpret_cast<AdcStreamState*>(arg);
+    uint64_t written = 0;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+        written = state->written;
+    }
+
+    if (written != state->reported) {
+        state->reported = written;
+        state->handler(state->controller, written, STM32F4_Time_GetSystemTime(nullptr));
+    }
+
+    state->taskManager->Enqueue(state->taskManager, task, STM32F4_Time_GetProcessorTicksForTime(nullptr, ADC_STREAM_EVENT_POST_DEBOUNCE_TICKS));
+}
+
+TinyCLR_Result STM32F4_Adc_StartStream(const TinyCLR_Adc_Controller* self, const uint32_t* channels, size_t channelCount, uint32_t frequency, uint16_t* buffer, size_t length, TinyCLR_Adc_StreamHandler handler) {
+    auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
+    auto& stream = adcStreamState;
+
+    if (stream.isActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (channelCount == 0 || channelCount > 16 || length == 0 || length % (2 * channelCount) != 0 || length > 0xFFFF || frequency == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    uint32_t cycles = 0;
+
+    for (auto i = 0; i < channelCount; i++) {
+        if (channels[i] >= STM32F4_AD_NUM || !state->isOpen[channels[i]])
+            return TinyCLR_Result::ArgumentInvalid;
+
+        cycles += adcSampleCycles[state->sampling[channels[i]].SampleTime] + STM32F4_AD_CONVERSION_CYCLES;
+    }
+
+    // the whole sequence has to convert within one trigger period, ADCCLK is PCLK2 / 2
+    if (frequency > (STM32F4_APB2_CLOCK_HZ / 2) / cycles)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    TIM_TypeDef* treg = nullptr;
+    uint32_t externalSelection = 0;
+
+    for (auto i = 0; i < SIZEOF_ARRAY(adcStreamTriggers) && treg == nullptr; i++) {
+        auto candidate = STM32F4_Adc_GetTriggerTimer(adcStreamTriggers[i].timer);
+        uint32_t enBit;
+
+#if defined(STM32F4_TIME_TIMER)
+        // the timer counts native time
+        if (adcStreamTriggers[i].timer == STM32F4_TIME_TIMER)
+            continue;
+#endif
+
+        if (candidate == nullptr || (*STM32F4_Adc_GetTimerClockEnable(candidate, enBit) & enBit)) // in use as PWM or by Signals
+            continue;
+
+        treg = candidate;
+        externalSelection = adcStreamTriggers[i].externalSelection;
+    }
+
+    if (treg == nullptr || !STM32F4_DmaInternal_Acquire(adcStreamDma))
+        return TinyCLR_Result::NotAvailable;
+
+    uint32_t clock = ((uint32_t)treg & 0x10000) ? ADC_APB2_TIMER_CLOCK_HZ : ADC_APB1_TIMER_CLOCK_HZ;
+    uint32_t ticks = (clock + frequency / 2) / frequency;
+    uint32_t prescaler = treg == TIM2 ? 1 : (ticks - 1) / 0x10000 + 1;
+    uint32_t period = (ticks + prescaler / 2) / prescaler;
+
+    stream.controller = self;
+    stream.timReg = treg;
+    stream.half = length / 2;
+    stream.written = 0;
+    stream.reported = 0;
+    stream.handler = handler;
+    stream.isActive = true;
+
+    ADCx->CR2 = ADC_CR2_ADON;
+    ADCx->SQR1 = (channelCount - 1) << ADC_SQR1_L_Pos;
+    ADCx->SQR2 = 0;
+    ADCx->SQR3 = 0;
+
+    for (auto i = 0; i < channelCount; i++) {
+        if (i < 6)
+            ADCx->SQR3 |= channels[i] << (5 * i);
+        else if (i < 12)
+            ADCx->SQR2 |= channels[i] << (5 * (i - 6));
+        else
+            ADCx->SQR1 |= channels[i] << (5 * (i - 12));
+
+        if (channels[i] == 16 || channels[i] == 17)
+            ADC->CCR |= ADC_CCR_TSVREFE;
+    }
+
+    ADCx->CR1 = ADC_CR1_SCAN;
+
+    STM32F4_InterruptInternal_Activate(STM32F4_DmaInternal_GetInterrupt(adcStreamDma), (uint32_t*)&STM32F4_Adc_StreamInterrupt, 0);
+
+    STM32F4_DmaInternal_Start(adcStreamDma, (uint32_t)&ADCx->DR, (uint32_t)buffer, length, DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_HTIE | DMA_SxCR_TCIE);
+
+    // DDS keeps the requests going past the first length conversions, each TRGO rising edge starts a sequence
+    ADCx->CR2 = ADC_CR2_ADON | ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_EXTEN_0 | (externalSelection << ADC_CR2_EXTSEL_Pos);
+
+    if (handler != nullptr) {
+        stream.taskManager = (const TinyCLR_Task_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::TaskManager);
+        stream.taskManager->Create(stream.taskManager, STM32F4_Adc_StreamCallback, (void*)&stream, false, stream.taskReference);
+        stream.taskManager->Enqueue(stream.taskManager, stream.taskReference, STM32F4_Time_GetProcessorTicksForTime(nullptr, ADC_STREAM_EVENT_POST_DEBOUNCE_TICKS));
+    }
+
+    uint32_t enBit;
+
+    *STM32F4_Adc_GetTimerClockEnable(treg, enBit) |= enBit;
+
+    treg->CR1 = 0;
+    treg->PSC = prescaler - 1;
+    treg->ARR = period - 1;
+    treg->CR2 = TIM_CR2_MMS_1; // update event is TRGO
+    treg->EGR = TIM_EGR_UG;
+    treg->SR = 0;
+    treg->CR1 = TIM_CR1_CEN;
+
+    return TinyCLR_Result::Success;
+}
+
+uint64_t STM32F4_Adc_GetStreamWritten(const TinyCLR_Adc_Controller* self) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    return adcStreamState.isActive ? adcStreamState.written : 0;
+}
+
+TinyCLR_Result STM32F4_Adc_StopStream(const TinyCLR_Adc_Controller* self) {
+    auto& stream = adcStreamState;
+
+    if (!stream.isActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    uint32_t enBit;
+
+    stream.timReg->CR1 = 0;
+    stream.timReg->CR2 = 0;
+    *STM32F4_Adc_GetTimerClockEnable(stream.timReg, enBit) &= ~enBit;
+
+    ADCx->CR2 = ADC_CR2_ADON;
+    ADCx->CR1 = 0;
+    ADCx->SQR1 = 0;
+    ADC->CCR &= ~ADC_CCR_TSVREFE;
+
+    STM32F4_DmaInternal_Release(adcStreamDma);
+    STM32F4_InterruptInternal_Deactivate(STM32F4_DmaInternal_GetInterrupt(adcStreamDma));
+
+    if (stream.handler != nullptr && stream.taskManager != nullptr && stream.taskReference != nullptr) {
+        stream.taskManager->Free(stream.taskManager, stream.taskReference);
+
+        stream.taskReference = nullptr;
+    }
+
+    stream.handler = nullptr;
+    stream.isActive = false;
+
+    return TinyCLR_Result::Success;
+}
+
 void STM32F4_Adc_Reset() {
+    if (adcStreamState.isActive)
+        TinyCLR_Adc_StopStream(&adcControllers[0]);
+
     for (auto c = 0; c < TOTAL_ADC_CONTROLLERS; c++) {
         for (auto i = 0; i < STM32F4_AD_NUM; i++) {
             STM32F4_Adc_CloseChannel(&adcControllers[c], i);
@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include "STM32F4.h"
+#include "../../Drivers/DevicesInterop/Dac/GHIElectronics_TinyCLR_Devices_Dac_Stream.h"
 
 #ifdef INCLUDE_DAC
 ///////////////////////////////////////////////////////////////////////////////
@@ -23,6 +24,15 @@
 #define STM32F4_DAC_CHANNEL_NUMS 2
 #define STM32F4_DAC_FIRST_PIN 4
 #define STM32F4_DAC_RESOLUTION_INT_BIT 12
+#define STM32F4_DAC_MAX_FREQUENCY 1000000
+
+#if STM32F4_APB1_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define DAC_APB1_TIMER_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ)
+#else
+#define DAC_APB1_TIMER_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ * 2)
+#endif
+
+#define DAC_STREAM_EVENT_POST_DEBOUNCE_TICKS (10 * 10000) // 10ms between each events
 
 static TinyCLR_Dac_Controller dacControllers[TOTAL_DAC_CONTROLLERS];
 static TinyCLR_Api_Info dacApi[TOTAL_DAC_CONTROLLERS];
@@ -33,6 +43,38 @@ struct DacState {
 
 static DacState dacStates[TOTAL_DAC_CONTROLLERS];
 
+// Basic timers whose update can trigger a conversion through TRGO, as { timer, TSEL }
+struct DacStreamTrigger {
+    uint8_t timer;
+    uint8_t triggerSelection;
+};
+
+static const DacStreamTrigger dacStreamTriggers[] = {
+    { 6, 0 },
+    { 7, 2 },
+};
+
+static const STM32F4_Dma_Request dacStreamDma[STM32F4_DAC_CHANNEL_NUMS] = { { 1, 5, 7 }, { 1, 6, 7 } };
+
+struct DacStreamState {
+    bool isActive;
+
+    const TinyCLR_Dac_Controller* controller;
+    TIM_TypeDef* timReg;
+
+    size_t half;
+    volatile uint64_t played;
+    uint64_t reported;
+
+    TinyCLR_Dac_StreamHandler handler;
+    const TinyCLR_Task_Manager* taskManager;
+    TinyCLR_Task_Reference taskReference;
+};
+
+static DacStreamState dacStreamStates[STM32F4_DAC_CHANNEL_NUMS];
+
+static const TinyCLR_Dac_StreamApi dacStreamApi = { &STM32F4_Dac_StartStream, &STM32F4_Dac_GetStreamPlayed, &STM32F4_Dac_StopStream, &STM32F4_Dac_EncodeStream };
+
 const char* dacApiNames[TOTAL_DAC_CONTROLLERS] = {
     "GHIElectronics.TinyCLR.NativeApis.STM32F4.DacController\\0"
 };
@@ -61,6 +103,8 @@ void STM32F4_Dac_AddApi(const TinyCLR_Api_Manager* apiManager) {
     }
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::DacController, dacApi[0].Name);
+
+    TinyCLR_Dac_SetStreamApi(&dacControllers[0], &dacStreamApi);
 }
 
 TinyCLR_Result STM32F4_Dac_Acquire(const TinyCLR_Dac_Controller* self) {
@@ -104,6 +148,9 @@ TinyCLR_Result STM32F4_Dac_OpenChannel(const TinyCLR_Dac_Controller* self, uint3
 TinyCLR_Result STM32F4_Dac_CloseChannel(const TinyCLR_Dac_Controller* self, uint32_t channel) {
     auto state = reinterpret_cast<DacState*>(self->ApiInfo->State);
 
+    if (channel < STM32F4_DAC_CHANNEL_NUMS && dacStreamStates[channel].isActive)
+        return TinyCLR_Result::Busy;
+
     if (channel) {
         DAC->CR &= ~DAC_CR_EN2; // disable channel 2
     }
@@ -125,6 +172,9 @@ TinyCLR_Result STM32F4_Dac_CloseChannel(const TinyCLR_Dac_Controller* self, uint
 }
 
 TinyCLR_Result STM32F4_Dac_WriteValue(const TinyCLR_Dac_Controller* self, uint32_t channel, int32_t value) {
+    if (channel < STM32F4_DAC_CHANNEL_NUMS && dacStreamStates[channel].isActive)
+        return TinyCLR_Result::Busy;
+
     value &= 0x00000FFF;
 
     if (channel)
@@ -151,7 +201,181 @@ int32_t STM32F4_Dac_GetMaxValue(const TinyCLR_Dac_Controller* self) {
     return ((1 << STM32F4_DAC_RESOLUTION_INT_BIT) - 1);
 }
 
+static TIM_TypeDef* STM32F4_Dac_GetTriggerTimer(uint32_t timer) {
+    switch (timer) {
+    case 6: return TIM6;
+    case 7: return TIM7;
+    }
+
+    return nullptr;
+}
+
+static __IO uint32_t* STM32F4_Dac_GetTimerClockEnable(TIM_TypeDef* treg, uint32_t& enBit) {
+    enBit = 1 << (((uint32_t)treg >> 10) & 0x1F);
+
+    return ((uint32_t)treg & 0x10000) ? &RCC->APB2ENR : &RCC->APB1ENR;
+}
+
+static void STM32F4_Dac_StreamInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    // both channels' vectors share the handler, each channel on its own stream
+    for (auto channel = 0; channel < STM32F4_DAC_CHANNEL_NUMS; channel++) {
+        auto& stream = dacStreamStates[channel];
+
+        if (!stream.isActive)
+            continue;
+
+        auto flags = STM32F4_DmaInternal_ReadAndClearFlags(dacStreamDma[channel]);
+
+        if (flags & DMA_LISR_HTIF0)
+            stream.played += stream.half;
+
+        if (flags & DMA_LISR_TCIF0)
+            stream.played += stream.half;
+    }
+}
+
+static void STM32F4_Dac_StreamCallback(const TinyCLR_Task_Manager* self, const TinyCLR_Api_Manager* apiManager, TinyCLR_Task_Reference task, void* arg) {
+    auto state = reinterpret_cast<DacStreamState*>(arg);
+    uint64_t played = 0;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+        played = state->played;
+    }
+
+    if (played != state->reported) {
+        state->reported = played;
+        state->handler(state->controller, static_cast<uint32_t>(state - dacStreamStates), played, STM32F4_Time_GetSystemTime(nullptr));
+    }
+
+    state->taskManager->Enqueue(state->taskManager, task, STM32F4_Time_GetProcessorTicksForTime(nullptr, DAC_STREAM_EVENT_POST_DEBOUNCE_TICKS));
+}
+
+TinyCLR_Result STM32F4_Dac_StartStream(const TinyCLR_Dac_Controller* self, uint32_t channel, uint32_t frequency, const uint32_t* buffer, size_t length, TinyCLR_Dac_StreamHandler handler) {
+    auto state = reinterpret_cast<DacState*>(self->ApiInfo->State);
+
+    if (channel >= STM32F4_DAC_CHANNEL_NUMS || length < 2 || length % 2 != 0 || length > 0xFFFF || frequency == 0 || frequency > STM32F4_DAC_MAX_FREQUENCY)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& stream = dacStreamStates[channel];
+
+    if (!state->isOpened[channel] || stream.isActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    TIM_TypeDef* treg = nullptr;
+    uint32_t triggerSelection = 0;
+
+    for (auto i = 0; i < SIZEOF_ARRAY(dacStreamTriggers) && treg == nullptr; i++) {
+        auto candidate = STM32F4_Dac_GetTriggerTimer(dacStreamTriggers[i].timer);
+        uint32_t enBit;
+
+#if defined(STM32F4_TIME_TIMER)
+        // the timer counts native time
+        if (dacStreamTriggers[i].timer == STM32F4_TIME_TIMER)
+            continue;
+#endif
+
+        if (candidate == nullptr || (*STM32F4_Dac_GetTimerClockEnable(candidate, enBit) & enBit)) // in use by the other channel or by Signals
+            continue;
+
+        treg = candidate;
+        triggerSelection = dacStreamTriggers[i].triggerSelection;
+    }
+
+    if (treg == nullptr || !STM32F4_DmaInternal_Acquire(dacStreamDma[channel]))
+        return TinyCLR_Result::NotAvailable;
+
+    uint32_t ticks = (DAC_APB1_TIMER_CLOCK_HZ + frequency / 2) / frequency;
+    uint32_t prescaler = (ticks - 1) / 0x10000 + 1;
+    uint32_t period = (ticks + prescaler / 2) / prescaler;
+    uint32_t shift = channel ? 16 : 0;
+
+    stream.controller = self;
+    stream.timReg = treg;
+    stream.half = length / 2;
+    stream.played = 0;
+    stream.reported = 0;
+    stream.handler = handler;
+    stream.isActive = true;
+
+    STM32F4_InterruptInternal_Activate(STM32F4_DmaInternal_GetInterrupt(dacStreamDma[channel]), (uint32_t*)&STM32F4_Dac_StreamInterrupt, 0);
+
+    STM32F4_DmaInternal_Start(dacStreamDma[channel], channel ? (uint32_t)&DAC->DHR12R2 : (uint32_t)&DAC->DHR12R1, (uint32_t)buffer, length, DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_DIR_0 | DMA_SxCR_HTIE | DMA_SxCR_TCIE);
+
+    // each trigger moves DHR to the output and requests the next word
+    DAC->SR = DAC_SR_DMAUDR1 << shift;
+    DAC->CR = (DAC->CR & ~((DAC_CR_TEN1 | DAC_CR_TSEL1 | DAC_CR_WAVE1 | DAC_CR_MAMP1 | DAC_CR_DMAEN1) << shift)) | ((DAC_CR_TEN1 | (triggerSelection << DAC_CR_TSEL1_Pos) | DAC_CR_DMAEN1) << shift);
+
+    if (handler != nullptr) {
+        stream.taskManager = (const TinyCLR_Task_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::TaskManager);
+        stream.taskManager->Create(stream.taskManager, STM32F4_Dac_StreamCallback, (void*)&stream, false, stream.taskReference);
+        stream.taskManager->Enqueue(stream.taskManager, stream.taskReference, STM32F4_Time_GetProcessorTicksForTime(nullptr, DAC_STREAM_EVENT_POST_DEBOUNCE_TICKS));
+    }
+
+    uint32_t enBit;
+
+    *STM32F4_Dac_GetTimerClockEnable(treg, enBit) |= enBit;
+
+    treg->CR1 = 0;
+    treg->PSC = prescaler - 1;
+    treg->ARR = period - 1;
+    treg->EGR = TIM_EGR_UG; // loads PSC before TRGO follows the update
+    treg->SR = 0;
+    treg->CR2 = TIM_CR2_MMS_1; // update event is TRGO
+    treg->CR1 = TIM_CR1_CEN;
+
+    return TinyCLR_Result::Success;
+}
+
+uint64_t STM32F4_Dac_GetStreamPlayed(const TinyCLR_Dac_Controller* self, uint32_t channel) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    return channel < STM32F4_DAC_CHANNEL_NUMS && dacStreamStates[channel].isActive ? dacStreamStates[channel].played : 0;
+}
+
+TinyCLR_Result STM32F4_Dac_StopStream(const TinyCLR_Dac_Controller* self, uint32_t channel) {
+    if (channel >= STM32F4_DAC_CHANNEL_NUMS || !dacStreamStates[channel].isActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto& stream = dacStreamStates[channel];
+    uint32_t shift = channel ? 16 : 0;
+    uint32_t enBit;
+
+    stream.timReg->CR1 = 0;
+    stream.timReg->CR2 = 0;
+    *STM32F4_Dac_GetTimerClockEnable(stream.timReg, enBit) &= ~enBit;
+
+    DAC->CR &= ~((DAC_CR_TEN1 | DAC_CR_TSEL1 | DAC_CR_DMAEN1) << shift);
+
+    STM32F4_DmaInternal_Release(dacStreamDma[channel]);
+
+    // each channel's DMA stream has its own vector, the other channel's keeps running
+    STM32F4_InterruptInternal_Deactivate(STM32F4_DmaInternal_GetInterrupt(dacStreamDma[channel]));
+
+    if (stream.handler != nullptr && stream.taskManager != nullptr && stream.taskReference != nullptr) {
+        stream.taskManager->Free(stream.taskManager, stream.taskReference);
+
+        stream.taskReference = nullptr;
+    }
+
+    stream.handler = nullptr;
+    stream.isActive = false;
+
+    return TinyCLR_Result::Success;
+}
+
+void STM32F4_Dac_EncodeStream(const TinyCLR_Dac_Controller* self, uint32_t channel, const int32_t* values, uint32_t* words, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        words[i] = values[i] < 0 ? 0 : (values[i] > 0xFFF ? 0xFFF : values[i]);
+}
+
 void STM32F4_Dac_Reset() {
+    for (auto i = 0; i < STM32F4_DAC_CHANNEL_NUMS; i++)
+        if (dacStreamStates[i].isActive)
+            TinyCLR_Dac_StopStream(&dacControllers[0], i);
+
     for (auto c = 0; c < TOTAL_DAC_CONTROLLERS; c++) {
         for (uint32_t i = 0; i < STM32F4_Dac_GetChannelCount(&dacControllers[c]); i++) {
             STM32F4_Dac_CloseChannel(&dacControllers[c], i);
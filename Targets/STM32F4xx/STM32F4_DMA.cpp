@@ -0,0 +1,113 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "STM32F4.h"
+
+#define TOTAL_DMA_CONTROLLERS 2
+#define TOTAL_DMA_STREAMS 8
+
+// Stream flags: FEIF, DMEIF, TEIF, HTIF and TCIF
+#define DMA_STREAM_FLAGS 0x3D
+
+static const uint8_t dmaFlagShift[] = { 0, 6, 16, 22 };
+
+static const uint8_t dmaInterrupts[TOTAL_DMA_CONTROLLERS][TOTAL_DMA_STREAMS] = {
+    { DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn, DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn },
+    { DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn, DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn },
+};
+
+static bool dmaStreamAcquired[TOTAL_DMA_CONTROLLERS][TOTAL_DMA_STREAMS];
+
+static DMA_TypeDef* STM32F4_DmaInternal_GetController(const STM32F4_Dma_Request& request) {
+    return request.controller == 1 ? DMA1 : DMA2;
+}
+
+static DMA_Stream_TypeDef* STM32F4_DmaInternal_GetStream(const STM32F4_Dma_Request& request) {
+    return reinterpret_cast<DMA_Stream_TypeDef*>(reinterpret_cast<uint32_t>(STM32F4_DmaInternal_GetController(request)) + 0x10 + 0x18 * request.stream);
+}
+
+static void STM32F4_DmaInternal_ClearFlags(const STM32F4_Dma_Request& request) {
+    auto dma = STM32F4_DmaInternal_GetController(request);
+    auto flags = DMA_STREAM_FLAGS << dmaFlagShift[request.stream & 3];
+
+    if (request.stream < 4)
+        dma->LIFCR = flags;
+    else
+        dma->HIFCR = flags;
+}
+
+bool STM32F4_DmaInternal_Acquire(const STM32F4_Dma_Request& request) {
+    if (request.controller < 1 || request.controller > TOTAL_DMA_CONTROLLERS || request.stream >= TOTAL_DMA_STREAMS)
+        return false;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (dmaStreamAcquired[request.controller - 1][request.stream])
+        return false;
+
+    dmaStreamAcquired[request.controller - 1][request.stream] = true;
+
+    RCC->AHB1ENR |= request.controller == 1 ? RCC_AHB1ENR_DMA1EN : RCC_AHB1ENR_DMA2EN;
+
+    return true;
+}
+
+void STM32F4_DmaInternal_Release(const STM32F4_Dma_Request& request) {
+    STM32F4_DmaInternal_Stop(request);
+
+    dmaStreamAcquired[request.controller - 1][request.stream] = false;
+}
+
+void STM32F4_DmaInternal_Start(const STM32F4_Dma_Request& request, uint32_t peripheralAddress, uint32_t memoryAddress, size_t count, uint32_t configuration) {
+    auto stream = STM32F4_DmaInternal_GetStream(request);
+
+    STM32F4_DmaInternal_Stop(request);
+
+    stream->PAR = peripheralAddress;
+    stream->M0AR = memoryAddress;
+    stream->NDTR = count;
+    stream->FCR = 0; // direct mode
+    stream->CR = configuration | (request.channel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_EN;
+}
+
+void STM32F4_DmaInternal_Stop(const STM32F4_Dma_Request& request) {
+    auto stream = STM32F4_DmaInternal_GetStream(request);
+
+    stream->CR &= ~DMA_SxCR_EN;
+
+    while (stream->CR & DMA_SxCR_EN); // the current beat finishes first
+
+    STM32F4_DmaInternal_ClearFlags(request);
+}
+
+size_t STM32F4_DmaInternal_GetRemaining(const STM32F4_Dma_Request& request) {
+    return STM32F4_DmaInternal_GetStream(request)->NDTR;
+}
+
+uint32_t STM32F4_DmaInternal_GetInterrupt(const STM32F4_Dma_Request& request) {
+    return dmaInterrupts[request.controller - 1][request.stream];
+}
+
+uint32_t STM32F4_DmaInternal_ReadAndClearFlags(const STM32F4_Dma_Request& request) {
+    auto dma = STM32F4_DmaInternal_GetController(request);
+    auto shift = dmaFlagShift[request.stream & 3];
+    auto flags = ((request.stream < 4 ? dma->LISR : dma->HISR) >> shift) & DMA_STREAM_FLAGS;
+
+    if (request.stream < 4)
+        dma->LIFCR = flags << shift;
+    else
+        dma->HIFCR = flags << shift;
+
+    return flags;
+}
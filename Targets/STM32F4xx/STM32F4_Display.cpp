@@ -16,6 +16,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "STM32F4.h"
+#include "../../Drivers/Display/Display.h"
 
 #ifdef INCLUDE_DISPLAY
 
@@ -177,6 +178,30 @@ typedef struct {
 
 #define LTDC_LAYER(__HANDLE__, __LAYER__)         ((LTDC_Layer_TypeDef *)((uint32_t)(((uint32_t)((__HANDLE__)->Instance)) + 0x84 + (0x80*(__LAYER__)))))
 
+/** @defgroup DMA2D_Mode DMA2D Mode
+  * @{
+  */
+#define DMA2D_MODE_M2M                    ((uint32_t)0x00000000)                /*!< Memory to memory, no pixel format conversion. */
+#define DMA2D_MODE_M2M_PFC                ((uint32_t)0x00010000)                /*!< Memory to memory with pixel format conversion. */
+#define DMA2D_MODE_M2M_BLEND              ((uint32_t)0x00020000)                /*!< Memory to memory with blending.               */
+#define DMA2D_MODE_R2M                    ((uint32_t)0x00030000)                /*!< Register to memory (fill).                    */
+/**
+  * @}
+  */
+
+/** @defgroup DMA2D_Alpha_Mode DMA2D Alpha Mode
+  * @{
+  */
+#define DMA2D_NO_MODIF_ALPHA              ((uint32_t)0x00000000)                /*!< No modification of the alpha channel value.              */
+#define DMA2D_COMBINE_ALPHA               ((uint32_t)0x00020000)                /*!< Original alpha channel value multiplied by ALPHA[7:0]. */
+/**
+  * @}
+  */
+
+#define DMA2D_MAX_PIXELS_PER_LINE         0x3FFF
+#define DMA2D_MAX_LINES                   0xFFFF
+#define DMA2D_MAX_LINE_OFFSET             0x3FFF
+
 const uint8_t characters[129][5] = {
 0x00,0x00,0x00,0x00,0x00,
 0x00,0x00,0x00,0x00,0x00,
@@ -349,6 +374,32 @@ uint8_t m_STM32F4_Display_TextBuffer[LCD_MAX_COLUMN][LCD_MAX_ROW];
 
 STM32F4xx_LCD_Rotation m_STM32F4_Display_CurrentRotation = STM32F4xx_LCD_Rotation::rotateNormal_0;
 
+#ifndef STM32F4_DISPLAY_BUFFER_COUNT
+#define STM32F4_DISPLAY_BUFFER_COUNT 1
+#endif
+
+#define STM32F4_DISPLAY_FLIP_TIMEOUT_US 100000
+#define STM32F4_DMA2D_TIMEOUT_US 100000
+
+// With two buffers m_STM32F4_Display_VituralRam is the one being scanned out. DrawBuffer renders into the back buffer
+// and the LTDC swaps them at the next vertical blank.
+uint16_t* m_STM32F4_Display_BackBuffer = nullptr;
+volatile bool m_STM32F4_Display_FlipPending = false;
+
+// Part of the front buffer the back buffer is missing, in framebuffer pixels: the update flipped last and whatever
+// was drawn straight on the front since. Empty when x0 >= x1.
+struct STM32F4_Display_Rectangle {
+    int32_t x0;
+    int32_t y0;
+    int32_t x1;
+    int32_t y1;
+};
+
+STM32F4_Display_Rectangle m_STM32F4_Display_FlipDamage = { 0, 0, 0, 0 };
+
+// Updates drawn into the back buffer with the flip deferred, the front buffer lacks them until the next flip.
+STM32F4_Display_Rectangle m_STM32F4_Display_DeferredDamage = { 0, 0, 0, 0 };
+
 bool STM32F4_Display_Initialize();
 bool STM32F4_Display_Uninitialize();
 bool STM32F4_Display_SetPinConfiguration(int32_t controllerIndex, bool enable);
@@ -371,6 +422,16 @@ uint32_t STM32F4_Display_GetPixelClockDivider();
 int32_t STM32F4_Display_GetOrientation();
 uint32_t* STM32F4_Display_GetFrameBuffer();
 
+void STM32F4_Display_CompleteFlip();
+void STM32F4_Display_FlipInterrupt(void* param);
+bool STM32F4_Display_WaitForFlip();
+void STM32F4_Display_AddFlipDamage(int32_t x, int32_t y, int32_t width, int32_t height);
+
+void STM32F4_Display_CopyRectangle(const void* source, void* destination, uint32_t width, uint32_t height, uint32_t sourceOffset, uint32_t destinationOffset, uint32_t colorMode);
+void STM32F4_Display_FillRectangle(void* destination, uint32_t width, uint32_t height, uint32_t destinationOffset, uint32_t colorMode, uint32_t color);
+void STM32F4_Display_ConvertRectangle(const void* source, void* destination, uint32_t width, uint32_t height, uint32_t sourceOffset, uint32_t destinationOffset, uint32_t sourceColorMode, uint32_t destinationColorMode);
+void STM32F4_Display_BlendRectangle(const void* foreground, void* destination, uint32_t width, uint32_t height, uint32_t foregroundOffset, uint32_t destinationOffset, uint32_t destinationColorMode, uint8_t alpha);
+
 #define TOTAL_DISPLAY_CONTROLLERS 1
 
 static TinyCLR_Display_Controller displayControllers[TOTAL_DISPLAY_CONTROLLERS];
@@ -506,6 +567,157 @@ void STM32F4_Ltdc_LayerConfiguration(LTDC_HandleTypeDef *hltdc, LTDC_LayerCfgTyp
 
 }
 
+//====================================================
+// Rectangle primitives. Color modes use the LTDC_PIXEL_FORMAT_xxx encoding, which is the same as the DMA2D CM field.
+// Offsets are the number of pixels skipped at the end of each line. DMA2D is used when the part has one and the
+// transfer fits its limits, otherwise the Display_xxx CPU kernels produce the same output.
+#if defined(DMA2D)
+static bool STM32F4_Dma2d_CanTransfer(const void* address, uint32_t width, uint32_t height, uint32_t offset, uint32_t colorMode) {
+    auto bytesPerPixel = Display_GetColorModeBytesPerPixel(colorMode);
+
+    if (!Display_IsDirectColorMode(colorMode))
+        return false;
+
+    if (width == 0 || width > DMA2D_MAX_PIXELS_PER_LINE || height == 0 || height > DMA2D_MAX_LINES || offset > DMA2D_MAX_LINE_OFFSET)
+        return false;
+
+    // DMA2D needs the buffers aligned on the pixel size, managed arrays can start at any offset.
+    if ((bytesPerPixel == 4 && (((uint32_t)address) & 3)) || (bytesPerPixel == 2 && (((uint32_t)address) & 1)))
+        return false;
+
+    return true;
+}
+
+void STM32F4_Dma2d_Interrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    // the flags stay for the waiting thread, masking the sources releases the line
+    DMA2D->CR &= ~(DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE);
+}
+
+// The thread sleeps until the transfer complete or error interrupt. A transfer still running at the timeout is aborted
+// and fails, the caller draws on the CPU then.
+static bool STM32F4_Dma2d_Transfer(uint32_t mode, uint32_t width, uint32_t height) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    DMA2D->IFCR = DMA2D_IFCR_CTEIF | DMA2D_IFCR_CTCIF | DMA2D_IFCR_CTWIF | DMA2D_IFCR_CAECIF | DMA2D_IFCR_CCTCIF | DMA2D_IFCR_CCEIF;
+    DMA2D->NLR = (width << DMA2D_NLR_PL_Pos) | height;
+    DMA2D->CR = mode | DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE | DMA2D_CR_START;
+
+    auto timeout = STM32F4_Time_GetCurrentProcessorTicks(nullptr) + STM32F4_Time_GetProcessorTicksForTime(nullptr, STM32F4_DMA2D_TIMEOUT_US * 10);
+    auto completed = true;
+
+    STM32F4_Time_ScheduleWakeup(timeout);
+
+    // interrupts stay masked between the check and the sleep, the completion cannot slip in between
+    while (DMA2D->CR & DMA2D_CR_START) {
+        if (STM32F4_Time_GetCurrentProcessorTicks(nullptr) >= timeout) {
+            DMA2D->CR |= DMA2D_CR_ABORT;
+
+            while (DMA2D->CR & DMA2D_CR_START);
+
+            DMA2D->CR &= ~(DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE);
+
+            completed = false;
+
+            break;
+        }
+
+        STM32F4_Interrupt_WaitForInterrupt();
+    }
+
+    irq.Release();
+
+    return completed && (DMA2D->ISR & (DMA2D_ISR_TEIF | DMA2D_ISR_CEIF)) == 0;
+}
+#endif
+
+void STM32F4_Display_CopyRectangle(const void* source, void* destination, uint32_t width, uint32_t height, uint32_t sourceOffset, uint32_t destinationOffset, uint32_t colorMode) {
+#if defined(DMA2D)
+    if (STM32F4_Dma2d_CanTransfer(source, width, height, sourceOffset, colorMode) && STM32F4_Dma2d_CanTransfer(destination, width, height, destinationOffset, colorMode)) {
+        DMA2D->FGMAR = (uint32_t)source;
+        DMA2D->FGOR = sourceOffset;
+        DMA2D->FGPFCCR = colorMode;
+        DMA2D->OMAR = (uint32_t)destination;
+        DMA2D->OOR = destinationOffset;
+        DMA2D->OPFCCR = colorMode;
+
+        if (STM32F4_Dma2d_Transfer(DMA2D_MODE_M2M, width, height))
+            return;
+    }
+#endif
+
+    Display_CopyRectangle(source, destination, width, height, sourceOffset, destinationOffset, colorMode);
+}
+
+void STM32F4_Display_FillRectangle(void* destination, uint32_t width, uint32_t height, uint32_t destinationOffset, uint32_t colorMode, uint32_t color) {
+#if defined(DMA2D)
+    if (STM32F4_Dma2d_CanTransfer(destination, width, height, destinationOffset, colorMode)) {
+        DMA2D->OMAR = (uint32_t)destination;
+        DMA2D->OOR = destinationOffset;
+        DMA2D->OPFCCR = colorMode;
+        DMA2D->OCOLR = color;
+
+        if (STM32F4_Dma2d_Transfer(DMA2D_MODE_R2M, width, height))
+            return;
+    }
+#endif
+
+    Display_FillRectangle(destination, width, height, destinationOffset, colorMode, color);
+}
+
+void STM32F4_Display_ConvertRectangle(const void* source, void* destination, uint32_t width, uint32_t height, uint32_t sourceOffset, uint32_t destinationOffset, uint32_t sourceColorMode, uint32_t destinationColorMode) {
+    if (sourceColorMode == destinationColorMode) {
+        STM32F4_Display_CopyRectangle(source, destination, width, height, sourceOffset, destinationOffset, sourceColorMode);
+
+        return;
+    }
+
+    if (!Display_IsDirectColorMode(sourceColorMode) || !Display_IsDirectColorMode(destinationColorMode))
+        return;
+
+#if defined(DMA2D)
+    if (STM32F4_Dma2d_CanTransfer(source, width, height, sourceOffset, sourceColorMode) && STM32F4_Dma2d_CanTransfer(destination, width, height, destinationOffset, destinationColorMode)) {
+        DMA2D->FGMAR = (uint32_t)source;
+        DMA2D->FGOR = sourceOffset;
+        DMA2D->FGPFCCR = sourceColorMode | DMA2D_NO_MODIF_ALPHA;
+        DMA2D->OMAR = (uint32_t)destination;
+        DMA2D->OOR = destinationOffset;
+        DMA2D->OPFCCR = destinationColorMode;
+
+        if (STM32F4_Dma2d_Transfer(DMA2D_MODE_M2M_PFC, width, height))
+            return;
+    }
+#endif
+
+    Display_ConvertRectangle(source, destination, width, height, sourceOffset, destinationOffset, sourceColorMode, destinationColorMode);
+}
+
+// Blends an ARGB8888 foreground over the destination in place. alpha scales the foreground pixel alpha, 255 leaves it untouched.
+void STM32F4_Display_BlendRectangle(const void* foreground, void* destination, uint32_t width, uint32_t height, uint32_t foregroundOffset, uint32_t destinationOffset, uint32_t destinationColorMode, uint8_t alpha) {
+    if (!Display_IsDirectColorMode(destinationColorMode))
+        return;
+
+#if defined(DMA2D)
+    if (STM32F4_Dma2d_CanTransfer(foreground, width, height, foregroundOffset, LTDC_PIXEL_FORMAT_ARGB8888) && STM32F4_Dma2d_CanTransfer(destination, width, height, destinationOffset, destinationColorMode)) {
+        DMA2D->FGMAR = (uint32_t)foreground;
+        DMA2D->FGOR = foregroundOffset;
+        DMA2D->FGPFCCR = LTDC_PIXEL_FORMAT_ARGB8888 | (alpha == 0xFF ? DMA2D_NO_MODIF_ALPHA : (DMA2D_COMBINE_ALPHA | (alpha << DMA2D_FGPFCCR_ALPHA_Pos)));
+        DMA2D->BGMAR = (uint32_t)destination;
+        DMA2D->BGOR = destinationOffset;
+        DMA2D->BGPFCCR = destinationColorMode;
+        DMA2D->OMAR = (uint32_t)destination;
+        DMA2D->OOR = destinationOffset;
+        DMA2D->OPFCCR = destinationColorMode;
+
+        if (STM32F4_Dma2d_Transfer(DMA2D_MODE_M2M_BLEND, width, height))
+            return;
+    }
+#endif
+
+    Display_BlendRectangle(foreground, destination, width, height, foregroundOffset, destinationOffset, destinationColorMode, alpha);
+}
+
 bool STM32F4_Display_Initialize() {
     // InitializeConfiguration
     static LTDC_HandleTypeDef hltdc_F;
@@ -569,6 +781,12 @@ bool STM32F4_Display_Initialize() {
 
     RCC->APB2ENR |= RCC_APB2ENR_LTDCEN;
 
+#if defined(DMA2D)
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2DEN;
+
+    STM32F4_InterruptInternal_Activate(DMA2D_IRQn, (uint32_t*)&STM32F4_Dma2d_Interrupt, 0);
+#endif
+
     //HorizontalSyncPolarity
     if (m_STM32F4_DisplayHorizontalSyncPolarity == false)
         hltdc_F.Init.HSPolarity = LTDC_HSPOLARITY_AL;
@@ -656,15 +874,136 @@ bool STM32F4_Display_Initialize() {
     /* Configure the Layer*/
     STM32F4_Ltdc_LayerConfiguration(&hltdc_F, &pLayerCfg, 1);
 
+    if (m_STM32F4_Display_BackBuffer != nullptr) {
+        hltdc_F.Instance->IER |= LTDC_IER_RRIE;
+
+        STM32F4_InterruptInternal_Activate(LTDC_IRQn, (uint32_t*)&STM32F4_Display_FlipInterrupt, 0);
+    }
+
     return true;
 }
 
 bool STM32F4_Display_Uninitialize() {
+    STM32F4_InterruptInternal_Deactivate(LTDC_IRQn);
+
+    m_STM32F4_Display_FlipPending = false;
+
     RCC->APB2ENR &= ~RCC_APB2ENR_LTDCEN;
 
+#if defined(DMA2D)
+    STM32F4_InterruptInternal_Deactivate(DMA2D_IRQn);
+
+    RCC->AHB1ENR &= ~RCC_AHB1ENR_DMA2DEN;
+#endif
+
+    return true;
+}
+
+//====================================================
+// Double buffering. The back buffer address is written to the layer shadow register and reloaded by the LTDC during
+// vertical blanking, the register reload interrupt then tells us the swap has happened.
+void STM32F4_Display_CompleteFlip() {
+    auto front = m_STM32F4_Display_VituralRam;
+
+    m_STM32F4_Display_VituralRam = m_STM32F4_Display_BackBuffer;
+    m_STM32F4_Display_BackBuffer = front;
+    m_STM32F4_Display_FlipPending = false;
+}
+
+void STM32F4_Display_FlipInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto status = LTDC->ISR;
+
+    LTDC->ICR = status;
+
+    if ((status & LTDC_ISR_RRIF) && m_STM32F4_Display_FlipPending) {
+        STM32F4_Display_CompleteFlip();
+
+        Display_RaiseFrameComplete(&displayControllers[0], STM32F4_Time_GetSystemTime(nullptr));
+    }
+}
+
+void STM32F4_Display_RequestFlip() {
+    m_STM32F4_Display_FlipPending = true;
+
+    LTDC_Layer2->CFBAR = reinterpret_cast<uint32_t>(m_STM32F4_Display_BackBuffer);
+    LTDC->SRCR = LTDC_SRCR_VBR;
+}
+
+bool STM32F4_Display_WaitForFlip() {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto timeout = STM32F4_Time_GetCurrentProcessorTicks(nullptr) + STM32F4_Time_GetProcessorTicksForTime(nullptr, STM32F4_DISPLAY_FLIP_TIMEOUT_US * 10);
+
+    STM32F4_Time_ScheduleWakeup(timeout);
+
+    // The register reload interrupt ends the wait, other interrupts only wake it to check the time. The flag is
+    // checked with interrupts masked, a reload between the check and the sleep still ends the sleep.
+    while (m_STM32F4_Display_FlipPending && STM32F4_Time_GetCurrentProcessorTicks(nullptr) < timeout)
+        STM32F4_Interrupt_WaitForInterrupt();
+
+    if (m_STM32F4_Display_FlipPending) {
+        // No vertical blank came, reload immediately so the registers and buffers stay in step.
+        LTDC->SRCR = LTDC_SRCR_IMR;
+
+        STM32F4_Display_CompleteFlip();
+
+        return false;
+    }
+
     return true;
 }
 
+static void STM32F4_Display_AddDamage(STM32F4_Display_Rectangle& damage, int32_t x, int32_t y, int32_t width, int32_t height) {
+    if (damage.x0 >= damage.x1) {
+        damage = { x, y, x + width, y + height };
+
+        return;
+    }
+
+    damage.x0 = x < damage.x0 ? x : damage.x0;
+    damage.y0 = y < damage.y0 ? y : damage.y0;
+    damage.x1 = x + width > damage.x1 ? x + width : damage.x1;
+    damage.y1 = y + height > damage.y1 ? y + height : damage.y1;
+}
+
+void STM32F4_Display_AddFlipDamage(int32_t x, int32_t y, int32_t width, int32_t height) {
+    STM32F4_Display_AddDamage(m_STM32F4_Display_FlipDamage, x, y, width, height);
+}
+
+// Framebuffer rectangle a BitBltEx of the rotated rectangle writes
+static void STM32F4_Display_GetFramebufferRectangle(int32_t& x, int32_t& y, int32_t& width, int32_t& height) {
+    int32_t screenWidth = m_STM32F4_DisplayWidth;
+    int32_t screenHeight = m_STM32F4_DisplayHeight;
+    auto rotatedX = x;
+    auto rotatedWidth = width;
+
+    switch (m_STM32F4_Display_CurrentRotation) {
+    case STM32F4xx_LCD_Rotation::rotateCCW_90:
+        x = y;
+        y = screenHeight - rotatedX - rotatedWidth;
+        width = height;
+        height = rotatedWidth;
+        break;
+
+    case STM32F4xx_LCD_Rotation::rotateCW_90:
+        x = screenWidth - y - height;
+        y = rotatedX;
+        width = height;
+        height = rotatedWidth;
+        break;
+
+    case STM32F4xx_LCD_Rotation::rotate_180:
+        x = screenWidth - x - width;
+        y = screenHeight - y - height;
+        break;
+
+    default:
+        break;
+    }
+}
+
 //====================================================
 void STM32F4_Display_WriteFormattedChar(uint8_t c) {
     if (m_STM32F4_DisplayEnable == false)
@@ -780,27 +1119,40 @@ void STM32F4_Display_PrintChracter(uint32_t x, uint32_t y, uint8_t c) {
 void STM32F4_Display_TextShiftColUp() {
     uint32_t r, c;
 
-    if (m_STM32F4_DisplayEnable == false)
+    if (m_STM32F4_DisplayEnable == false || m_STM32F4_Display_VituralRam == nullptr)
         return;
 
-    // refresh with new data
-    STM32F4_Display_Clear();
-    m_STM32F4_Display_TextRow = 0;
-    m_STM32F4_Display_TextColumn = 0;
-
     for (r = 0; r < (LCD_MAX_ROW - 1); r++) {
-        for (c = 0; c < LCD_MAX_COLUMN - 1; c++) {
+        for (c = 0; c < LCD_MAX_COLUMN; c++) {
             m_STM32F4_Display_TextBuffer[c][r] = m_STM32F4_Display_TextBuffer[c][r + 1];
-            STM32F4_Display_WriteFormattedChar(m_STM32F4_Display_TextBuffer[c][r]);
         }
     }
+
+    for (c = 0; c < LCD_MAX_COLUMN; c++) {
+        m_STM32F4_Display_TextBuffer[c][LCD_MAX_ROW - 1] = ' ';
+    }
+
+    // Scroll the text area up one line instead of repainting every character
+    auto lines = (LCD_MAX_ROW * 8) < m_STM32F4_DisplayHeight ? (LCD_MAX_ROW * 8) : m_STM32F4_DisplayHeight;
+
+    if (lines > 8)
+        STM32F4_Display_CopyRectangle(m_STM32F4_Display_VituralRam + (8 * m_STM32F4_DisplayWidth), m_STM32F4_Display_VituralRam, m_STM32F4_DisplayWidth, lines - 8, 0, 0, LTDC_PIXEL_FORMAT_RGB565);
+
+    if (lines >= 8)
+        STM32F4_Display_FillRectangle(m_STM32F4_Display_VituralRam + ((lines - 8) * m_STM32F4_DisplayWidth), m_STM32F4_DisplayWidth, 8, 0, LTDC_PIXEL_FORMAT_RGB565, 0);
+
+    m_STM32F4_Display_TextRow = LCD_MAX_ROW - 1;
+    m_STM32F4_Display_TextColumn = 0;
 }
 
 void STM32F4_Display_Clear() {
     if (m_STM32F4_DisplayEnable == false || m_STM32F4_Display_VituralRam == nullptr)
         return;
 
-    memset((uint32_t*)m_STM32F4_Display_VituralRam, 0, m_STM32F4_DisplayBufferSize);
+    STM32F4_Display_FillRectangle(m_STM32F4_Display_VituralRam, m_STM32F4_DisplayWidth, m_STM32F4_DisplayHeight, 0, LTDC_PIXEL_FORMAT_RGB565, 0);
+
+    if (m_STM32F4_Display_BackBuffer != nullptr)
+        STM32F4_Display_AddFlipDamage(0, 0, m_STM32F4_DisplayWidth, m_STM32F4_DisplayHeight);
 }
 
 struct DisplayPins {
@@ -931,16 +1283,14 @@ int32_t STM32F4_Display_GetOrientation() {
 }
 
 void STM32F4_Display_BitBltEx(int32_t x, int32_t y, int32_t width, int32_t height, uint32_t data[]) {
-    int32_t xTo, yTo, xFrom, yFrom;
     int32_t xOffset = x;
     int32_t yOffset = y;
     uint16_t *from = (uint16_t *)data;
-    uint16_t *to = (uint16_t *)m_STM32F4_Display_VituralRam;
+    uint16_t *to = m_STM32F4_Display_BackBuffer != nullptr ? m_STM32F4_Display_BackBuffer : m_STM32F4_Display_VituralRam;
 
 
     int32_t screenWidth = m_STM32F4_DisplayWidth;
     int32_t screenHeight = m_STM32F4_DisplayHeight;
-    int32_t startPx, toAddition;
 
     if (m_STM32F4_DisplayEnable == false)
         return;
@@ -948,85 +1298,28 @@ void STM32F4_Display_BitBltEx(int32_t x, int32_t y, int32_t width, int32_t heigh
     switch (m_STM32F4_Display_CurrentRotation) {
     case STM32F4xx_LCD_Rotation::rotateNormal_0:
 
-        if (xOffset == 0 && yOffset == 0 &&
-            width == screenWidth && height == screenHeight) {
-            memcpy(to, from, (screenWidth*screenHeight * 2));
-        }
-        else {
-            for (yTo = yOffset; yTo < (yOffset + height); yTo++) {
-                memcpy((void*)(to + yTo * screenWidth + xOffset), (void*)(from), (width * 2));
-                from += width;
-            }
-        }
+        if (Display_IsDamageTrackingEnabled())
+            Display_CopyChangedRgb565(from, width, to + yOffset * screenWidth + xOffset, screenWidth, width, height);
+        else
+            STM32F4_Display_CopyRectangle(from, to + yOffset * screenWidth + xOffset, width, height, 0, screenWidth - width, LTDC_PIXEL_FORMAT_RGB565);
 
         break;
 
     case STM32F4xx_LCD_Rotation::rotateCCW_90:
 
-        startPx = yOffset * screenHeight;
-        xFrom = xOffset + width;
-        yTo = screenHeight - xOffset - width;
-        xTo = yOffset;
-        to += yTo * screenWidth + xTo;
-        toAddition = screenWidth - height;
-
-        for (; yTo < (screenHeight - xOffset); yTo++) {
-            xFrom--;
-            yFrom = startPx + xFrom;
-
-            for (xTo = yOffset; xTo < (yOffset + height); xTo++) {
-                *to++ = from[yFrom];
-                yFrom += screenHeight;
-            }
-
-            to += toAddition;
-        }
+        Display_RotateRgb565Ccw90(from + yOffset * screenHeight + xOffset, screenHeight, to + (screenHeight - xOffset - width) * screenWidth + yOffset, screenWidth, width, height);
 
         break;
 
     case STM32F4xx_LCD_Rotation::rotateCW_90:
 
-        startPx = (yOffset + height - 1) * screenHeight;
-        xFrom = xOffset;
-
-        yTo = xOffset;
-        xTo = screenWidth - yOffset - height;
-        to += yTo * screenWidth + xTo;
-        toAddition = screenWidth - height;
-
-        for (; yTo < (xOffset + width); yTo++) {
-            yFrom = startPx + xFrom;
-
-            for (xTo = screenWidth - yOffset - height; xTo < (screenWidth - yOffset); xTo++) {
-                *to++ = from[yFrom];
-                yFrom -= screenHeight;
-            }
-
-            to += toAddition;
-            xFrom++;
-        }
+        Display_RotateRgb565Cw90(from + yOffset * screenHeight + xOffset, screenHeight, to + xOffset * screenWidth + (screenWidth - yOffset - height), screenWidth, width, height);
 
         break;
 
     case STM32F4xx_LCD_Rotation::rotate_180:
 
-        xFrom = (yOffset + height - 1) * screenWidth + xOffset + width;
-
-        yTo = screenHeight - yOffset - height;
-        xTo = screenWidth - xOffset - width;
-        to += yTo * screenWidth + xTo;
-        toAddition = screenWidth - width;
-
-        for (; yTo < (screenHeight - yOffset); yTo++) {
-
-            for (xTo = screenWidth - xOffset - width; xTo < (screenWidth - xOffset); xTo++) {
-                xFrom--;
-                *to++ = from[xFrom];
-            }
-
-            to += toAddition;
-            xFrom -= toAddition;
-        }
+        Display_RotateRgb565180(from + yOffset * screenWidth + xOffset, screenWidth, to + (screenHeight - yOffset - height) * screenWidth + (screenWidth - xOffset - width), screenWidth, width, height);
 
         break;
     }
@@ -1091,6 +1384,7 @@ TinyCLR_Result STM32F4_Display_Release(const TinyCLR_Display_Controller* self) {
             memoryProvider->Free(memoryProvider, m_STM32F4_Display_buffer);
 
             m_STM32F4_Display_buffer = nullptr;
+            m_STM32F4_Display_BackBuffer = nullptr;
         }
     }
 
@@ -1158,9 +1452,12 @@ TinyCLR_Result STM32F4_Display_SetConfiguration(const TinyCLR_Display_Controller
             memoryProvider->Free(memoryProvider, m_STM32F4_Display_buffer);
 
             m_STM32F4_Display_buffer = nullptr;
+            m_STM32F4_Display_BackBuffer = nullptr;
         }
 
-        m_STM32F4_Display_buffer = (uint32_t*)memoryProvider->Allocate(memoryProvider, m_STM32F4_DisplayBufferSize + 8);
+        auto bufferStride = (m_STM32F4_DisplayBufferSize + 7) & ~7;
+
+        m_STM32F4_Display_buffer = (uint32_t*)memoryProvider->Allocate(memoryProvider, bufferStride * STM32F4_DISPLAY_BUFFER_COUNT + 8);
 
         if (m_STM32F4_Display_buffer == nullptr) {
             return TinyCLR_Result::OutOfMemory;
@@ -1168,6 +1465,14 @@ TinyCLR_Result STM32F4_Display_SetConfiguration(const TinyCLR_Display_Controller
 
         m_STM32F4_Display_VituralRam = (uint16_t*)((((uint32_t)m_STM32F4_Display_buffer) + (7)) & (~((uint32_t)(7))));
 
+        if (STM32F4_DISPLAY_BUFFER_COUNT > 1) {
+            m_STM32F4_Display_BackBuffer = (uint16_t*)(((uint32_t)m_STM32F4_Display_VituralRam) + bufferStride);
+
+            // nothing is known about the new back buffer
+            m_STM32F4_Display_FlipDamage = { 0, 0, (int32_t)m_STM32F4_DisplayWidth, (int32_t)m_STM32F4_DisplayHeight };
+            m_STM32F4_Display_DeferredDamage = { 0, 0, 0, 0 };
+        }
+
         // Set displayPins.enable following m_STM32F4_DisplayOutputEnableIsFixed
         if (displayPins.enable.number != PIN_NONE) {
             if (m_STM32F4_DisplayOutputEnableIsFixed) {
@@ -1216,7 +1521,44 @@ TinyCLR_Result STM32F4_Display_GetConfiguration(const TinyCLR_Display_Controller
 }
 
 TinyCLR_Result STM32F4_Display_DrawBuffer(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* data) {
+    if (m_STM32F4_Display_BackBuffer == nullptr || m_STM32F4_DisplayEnable == false) {
+        STM32F4_Display_BitBltEx(x, y, width, height, (uint32_t*)data);
+        return TinyCLR_Result::Success;
+    }
+
+    int32_t updateX = x, updateY = y, updateWidth = width, updateHeight = height;
+    auto& damage = m_STM32F4_Display_FlipDamage;
+
+    STM32F4_Display_WaitForFlip();
+    STM32F4_Display_GetFramebufferRectangle(updateX, updateY, updateWidth, updateHeight);
+
+    // The back buffer is one frame behind, it takes what it misses from the front unless this update covers it.
+    if (damage.x0 < damage.x1 && (damage.x0 < updateX || damage.y0 < updateY || damage.x1 > updateX + updateWidth || damage.y1 > updateY + updateHeight)) {
+        auto offset = damage.y0 * m_STM32F4_DisplayWidth + damage.x0;
+        auto damageWidth = damage.x1 - damage.x0;
+
+        STM32F4_Display_CopyRectangle(m_STM32F4_Display_VituralRam + offset, m_STM32F4_Display_BackBuffer + offset, damageWidth, damage.y1 - damage.y0, m_STM32F4_DisplayWidth - damageWidth, m_STM32F4_DisplayWidth - damageWidth, LTDC_PIXEL_FORMAT_RGB565);
+    }
+
     STM32F4_Display_BitBltEx(x, y, width, height, (uint32_t*)data);
+
+    if (Display_IsFlipDeferred()) {
+        // the back buffer holds all of the front now and runs ahead of it by the deferred updates
+        damage = { 0, 0, 0, 0 };
+
+        STM32F4_Display_AddDamage(m_STM32F4_Display_DeferredDamage, updateX, updateY, updateWidth, updateHeight);
+
+        return TinyCLR_Result::Success;
+    }
+
+    STM32F4_Display_RequestFlip();
+
+    // after the flip the new back buffer is the old front, which lacks this update and the deferred ones only
+    damage = m_STM32F4_Display_DeferredDamage;
+    m_STM32F4_Display_DeferredDamage = { 0, 0, 0, 0 };
+
+    STM32F4_Display_AddDamage(damage, updateX, updateY, updateWidth, updateHeight);
+
     return TinyCLR_Result::Success;
 }
 
@@ -1226,17 +1568,28 @@ TinyCLR_Result STM32F4_Display_DrawPixel(const TinyCLR_Display_Controller* self,
     if (m_STM32F4_DisplayEnable == false || x >= m_STM32F4_DisplayWidth || y >= m_STM32F4_DisplayHeight)
         return TinyCLR_Result::InvalidOperation;
 
+    STM32F4_Display_WaitForFlip();
+
     loc = m_STM32F4_Display_VituralRam + (y *m_STM32F4_DisplayWidth) + (x);
 
     *loc = static_cast<uint16_t>(color & 0xFFFF);
 
+    if (m_STM32F4_Display_BackBuffer != nullptr)
+        STM32F4_Display_AddFlipDamage(x, y, 1, 1);
+
     return TinyCLR_Result::Success;
 }
 
 TinyCLR_Result STM32F4_Display_DrawString(const TinyCLR_Display_Controller* self, const char* data, size_t length) {
+    STM32F4_Display_WaitForFlip();
+
     for (size_t i = 0; i < length; i++)
         STM32F4_Display_WriteFormattedChar(data[i]);
 
+    // text may scroll the whole front buffer
+    if (m_STM32F4_Display_BackBuffer != nullptr)
+        STM32F4_Display_AddFlipDamage(0, 0, m_STM32F4_DisplayWidth, m_STM32F4_DisplayHeight);
+
     return TinyCLR_Result::Success;
 }
 
@@ -1280,6 +1633,7 @@ void STM32F4_Display_AddApi(const TinyCLR_Api_Manager* apiManager) {
 
     displayInitializeCount = 0;
     m_STM32F4_Display_buffer = nullptr;
+    m_STM32F4_Display_BackBuffer = nullptr;
     m_STM32F4_DisplayEnable = false;
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::DisplayController, displayApi[0].Name);
@@ -1294,6 +1648,7 @@ void STM32F4_Display_Reset() {
     m_STM32F4_DisplayEnable = false;
     displayInitializeCount = 0;
     m_STM32F4_Display_buffer = nullptr;
+    m_STM32F4_Display_BackBuffer = nullptr;
 
     m_STM32F4_Display_TextRow = 0;
     m_STM32F4_Display_TextColumn = 0;
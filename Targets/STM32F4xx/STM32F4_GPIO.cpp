@@ -15,11 +15,14 @@
 // limitations under the License.
 
 #include "STM32F4.h"
+#include "../../Drivers/DevicesInterop/Gpio/GHIElectronics_TinyCLR_Devices_Gpio_PinGroup.h"
 
 #define TOTAL_GPIO_CONTROLLERS 1
 
 #define TOTAL_GPIO_PINS SIZEOF_ARRAY(gpioPins)
 
+#define TOTAL_GPIO_PORTS ((TOTAL_GPIO_PINS + 15) / 16)
+
 static const STM32F4_Gpio_PinConfiguration gpioPins[] = STM32F4_GPIO_PINS;
 
 #define TOTAL_GPIO_INTERRUPT_PINS 16
@@ -99,11 +102,15 @@ const TinyCLR_Api_Info* STM32F4_Gpio_GetRequiredApi() {
     return &gpioApi[0];
 }
 
+static const TinyCLR_Gpio_PortApi gpioPortApi = { 16, TOTAL_GPIO_PORTS, &STM32F4_Gpio_ReadPort, &STM32F4_Gpio_WritePort };
+
 void STM32F4_Gpio_AddApi(const TinyCLR_Api_Manager* apiManager) {
     STM32F4_Gpio_EnsureTableInitialized();
 
     for (auto i = 0; i < TOTAL_GPIO_CONTROLLERS; i++) {
         apiManager->Add(apiManager, &gpioApi[i]);
+
+        TinyCLR_Gpio_SetPortApi(&gpioControllers[i], &gpioPortApi);
     }
 
     apiManager->SetDefaultName(apiManager, TinyCLR_Api_Type::GpioController, STM32F4_Gpio_GetRequiredApi()->Name);
@@ -274,6 +281,7 @@ bool STM32F4_GpioInternal_ClosePin(int32_t pin) {
         return false;
 
     pinReserved[pin] = false;
+    pinDriveMode[pin] = TinyCLR_Gpio_PinDriveMode::Input;
 
     // reset to default state
     return STM32F4_GpioInternal_ConfigurePin(pin, STM32F4_Gpio_PortMode::Input, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, STM32F4_Gpio_PullDirection::None, STM32F4_Gpio_AlternateFunction::AF0);
@@ -367,6 +375,41 @@ TinyCLR_Result STM32F4_Gpio_Write(const TinyCLR_Gpio_Controller* self, uint32_t
     return TinyCLR_Result::Success;
 }
 
+TinyCLR_Result STM32F4_Gpio_ReadPort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t& value) {
+    if (port >= TOTAL_GPIO_PORTS || (mask & ~0xFFFF))
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    value = Port(port)->IDR & mask;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Gpio_WritePort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t value) {
+    if (port >= TOTAL_GPIO_PORTS || (mask & ~0xFFFF))
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    // Only pins opened and driven as outputs take part, anything else in the mask fails the whole write
+    for (auto pins = mask; pins; pins &= pins - 1) {
+        auto pin = port * 16 + __CLZ(__RBIT(pins));
+
+        if (pin >= TOTAL_GPIO_PINS || !pinReserved[pin] || pinDriveMode[pin] < TinyCLR_Gpio_PinDriveMode::Output)
+            return TinyCLR_Result::InvalidOperation;
+    }
+
+    // Set and reset halves go out in one store, so all pins of the mask change together
+    Port(port)->BSRR = (value & mask) | ((~value & mask) << 16);
+
+    for (auto pins = mask; pins; pins &= pins - 1) {
+        auto bit = __CLZ(__RBIT(pins));
+        auto pin = port * 16 + bit;
+
+        if (pin < TOTAL_GPIO_PINS)
+            previousOutputValue[pin] = (value & (1u << bit)) ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
 TinyCLR_Result STM32F4_Gpio_OpenPin(const TinyCLR_Gpio_Controller* self, uint32_t pin) {
     if (pin >= TOTAL_GPIO_PINS || pin == PIN_NONE)
         return TinyCLR_Result::ArgumentOutOfRange;
@@ -15,34 +15,30 @@
 // limitations under the License.
 
 #include "STM32F4.h"
+#include "../../Drivers/DevicesInterop/Pwm/GHIElectronics_TinyCLR_Devices_Pwm_Burst.h"
+#include "../../Drivers/DevicesInterop/Pwm/GHIElectronics_TinyCLR_Devices_Pwm_Timing.h"
 
 #if STM32F4_APB1_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
 #define PWM1_CLK_HZ (STM32F4_APB1_CLOCK_HZ)
 #else
 #define PWM1_CLK_HZ (STM32F4_APB1_CLOCK_HZ * 2)
 #endif
-#define PWM1_CLK_MHZ (PWM1_CLK_HZ / 1000000)
 
 #if STM32F4_APB2_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
 #define PWM2_CLK_HZ (STM32F4_APB2_CLOCK_HZ)
 #else
 #define PWM2_CLK_HZ (STM32F4_APB2_CLOCK_HZ * 2)
 #endif
-#define PWM2_CLK_MHZ (PWM2_CLK_HZ / 1000000)
 
-#if PWM2_CLK_MHZ > PWM1_CLK_MHZ
-#define PWM_MAX_CLK_MHZ PWM2_CLK_MHZ
-#else
-#define PWM_MAX_CLK_MHZ PWM1_CLK_MHZ
-#endif
-
-#define PWM_MILLISECONDS  1000
-#define PWM_MICROSECONDS  1000000
-#define PWM_NANOSECONDS   1000000000
 #define PWM_PER_CONTROLLER 4
 
 #define STM32F4_MIN_PWM_FREQUENCY 1
 
+#define PWM_BURST_DMA_TIMERS 8
+#define PWM_BURST_CCR1_OFFSET 13 // CCR1 in words from the timer base, the first register a DMA burst writes
+
+#define PWM_POLARITY_BITS (TIM_CCER_CC1P | TIM_CCER_CC2P | TIM_CCER_CC3P | TIM_CCER_CC4P)
+
 typedef  TIM_TypeDef* ptr_TIM_TypeDef;
 
 struct PwmState {
@@ -54,9 +50,8 @@ struct PwmState {
     TinyCLR_Pwm_PulsePolarity invert[PWM_PER_CONTROLLER];
     bool                isOpened[PWM_PER_CONTROLLER];
 
-    double              actualFreq;
-    double              theoryFreq;
-    double              dutyCycle[PWM_PER_CONTROLLER];
+    uint64_t            frequency; // millihertz
+    uint32_t            dutyCycle[PWM_PER_CONTROLLER]; // parts per million
 
     uint32_t            period;
     uint32_t            presc;
@@ -65,13 +60,33 @@ struct PwmState {
     uint16_t            initializeCount;
     bool                forceUpdate;
 
+    uint32_t            polarity; // CCxP bits the next update applies
+    bool                polarityPending;
+
+    bool                burstActive;
+    bool                burstLooped;
+    TinyCLR_Pwm_BurstCompletedHandler burstCompleted;
 };
 
 void STM32F4_Pwm_ResetController(int32_t controllerIndex);
 STM32F4_Gpio_Pin* STM32F4_Pwm_GetGpioPinForChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel);
+static void STM32F4_Pwm_ApplyPolarity(PwmState* state);
+static void STM32F4_Pwm_UpdateInterrupt(void* param);
 
 static const STM32F4_Gpio_Pin pwmPins[][PWM_PER_CONTROLLER] = STM32F4_PWM_PINS;
 
+// Update DMA request of each timer as { controller, stream, channel }, no controller when there is none
+static const STM32F4_Dma_Request pwmBurstDma[PWM_BURST_DMA_TIMERS] = {
+    /* TIM1 */ { 2, 5, 6 },
+    /* TIM2 */ { 1, 1, 3 },
+    /* TIM3 */ { 1, 2, 5 },
+    /* TIM4 */ { 1, 6, 2 },
+    /* TIM5 */ { 1, 0, 6 },
+    /* TIM6 */ { 0, 0, 0 },
+    /* TIM7 */ { 0, 0, 0 },
+    /* TIM8 */ { 2, 1, 7 },
+};
+
 const char* PwmApiNames[] = {
 #if TOTAL_PWM_CONTROLLERS > 0
 "GHIElectronics.TinyCLR.NativeApis.STM32F4.PwmController\\0",
@@ -122,6 +137,8 @@ static PwmState pwmStates[TOTAL_PWM_CONTROLLERS];
 static TinyCLR_Pwm_Controller pwmControllers[TOTAL_PWM_CONTROLLERS];
 static TinyCLR_Api_Info pwmApi[TOTAL_PWM_CONTROLLERS];
 
+static const TinyCLR_Pwm_BurstApi pwmBurstApi = { &STM32F4_Pwm_SetPulseParametersBatch, &STM32F4_Pwm_EncodeBurst, &STM32F4_Pwm_StartBurst, &STM32F4_Pwm_IsBurstActive, &STM32F4_Pwm_StopBurst };
+
 void STM32F4_Pwm_AddApi(const TinyCLR_Api_Manager* apiManager) {
     for (auto i = 0; i < TOTAL_PWM_CONTROLLERS; i++) {
         pwmControllers[i].ApiInfo = &pwmApi[i];
@@ -147,6 +164,8 @@ void STM32F4_Pwm_AddApi(const TinyCLR_Api_Manager* apiManager) {
         pwmStates[i].controllerIndex = i;
 
         apiManager->Add(apiManager, &pwmApi[i]);
+
+        TinyCLR_Pwm_SetBurstApi(&pwmControllers[i], &pwmBurstApi);
     }
 }
 
@@ -216,101 +235,31 @@ TinyCLR_Result STM32F4_Pwm_CloseChannel(const TinyCLR_Pwm_Controller* self, uint
     return TinyCLR_Result::Success;
 }
 
-void STM32F4_Pwm_GetScaleFactor(double frequency, uint32_t& period, uint32_t& scale) {
-    if (frequency >= 1000.0) {
-        period = (uint32_t)(((uint32_t)PWM_NANOSECONDS / frequency) + 0.5);
-        scale = PWM_NANOSECONDS;
-    }
-    else if (frequency >= 1.0) {
-        period = (uint32_t)(((uint32_t)PWM_MICROSECONDS / frequency) + 0.5);
-        scale = PWM_MICROSECONDS;
-    }
-    else {
-        period = (uint32_t)(((uint32_t)PWM_MILLISECONDS / frequency) + 0.5);
-        scale = PWM_MILLISECONDS;
-    }
-}
-
-double STM32F4_Pwm_GetActualFrequency(const TinyCLR_Pwm_Controller* self) {
-    uint32_t period = 0;
-    uint32_t scale = 0;
-
-    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
-
-    double freq = state->theoryFreq;
-
-    ptr_TIM_TypeDef treg = state->timReg;
-
-    STM32F4_Pwm_GetScaleFactor(freq, period, scale);
-
-    uint32_t p = period, s = scale;
-
-    // set pre, p, & d such that:
-    // pre * p = PWM_CLK * period / scale
-    // pre * d = PWM_CLK * duration / scale
-
+static TinyCLR_Pwm_Counter STM32F4_Pwm_GetCounter(PwmState* state) {
     uint32_t clk = PWM1_CLK_HZ;
 
-    if ((uint32_t)treg & 0x10000) clk = PWM2_CLK_HZ; // APB2
-
-    uint32_t pre = clk / s; // prescaler
-
-    if (pre == 0) { // s > PWM_CLK
-        uint32_t sm = s / 1000000; // scale in MHz
-        clk = PWM1_CLK_MHZ;      // clock in MHz
-        if ((uint32_t)treg & 0x10000) clk = PWM2_CLK_MHZ; // APB2
-        if (p > 0xFFFFFFFF / PWM_MAX_CLK_MHZ) { // avoid overflow
-            pre = clk;
-            p /= sm;
-        }
-        else {
-            pre = 1;
-            p = p * clk / sm;
-        }
-    }
-    else {
-        while (pre > 0x10000) { // prescaler too large
-            if (p >= 0x80000000) return 0;
-            pre >>= 1;
-            p <<= 1;
-        }
-    }
-
-    if (state->timer != 2 && state->timer != 5) { // 16 bit timer
-        while (p >= 0x10000) { // period too large
-            if (pre > 0x8000) return 0;
-            pre <<= 1;
-            p >>= 1;
-        }
-    }
-
-    clk = PWM1_CLK_HZ;
-
-    if ((uint32_t)treg & 0x10000)
+    if ((uint32_t)state->timReg & 0x10000)
         clk = PWM2_CLK_HZ; // APB2
 
-    if (p == 0 || pre == 0)
-        return 0;
-
-    uint32_t period2 = scale / ((clk / pre) / p);
-    double actualFreq = (double)(scale / period2);
-
-    while (period2 < period || actualFreq > freq) {
-        p++;
+    // A period is ARR + 1 counts, 16 bit timers stop one short of 0x10000 so a full duty cycle still fits CCRx
+    return { clk, 0x10000, false, 2, (state->timer == 2 || state->timer == 5) ? 0xFFFFFFFF : 0xFFFF };
+}
 
-        period2 = scale / ((clk / pre) / p);
+double STM32F4_Pwm_GetActualFrequency(const TinyCLR_Pwm_Controller* self) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
-        if (period2 == 0)
-            return 0;
+    if (state->frequency == 0) {
+        state->period = 0;
+        state->presc = 0;
 
-        actualFreq = (double)(scale / period2);
+        return 0;
     }
 
-    state->actualFreq = actualFreq;
-    state->period = p;
-    state->presc = pre;
+    auto counter = STM32F4_Pwm_GetCounter(state);
 
-    return actualFreq;
+    TinyCLR_Pwm_SolveTiming(counter, state->frequency, state->presc, state->period);
+
+    return TinyCLR_Pwm_ToFrequency(TinyCLR_Pwm_GetFrequency(counter, state->presc, state->period));
 }
 
 TinyCLR_Result STM32F4_Pwm_EnableChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel) {
@@ -352,6 +301,9 @@ TinyCLR_Result STM32F4_Pwm_DisableChannel(const TinyCLR_Pwm_Controller* self, ui
 
     if ((ccer & (TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC3E | TIM_CCER_CC4E)) == 0) { // idle
         treg->CR1 &= ~TIM_CR1_CEN; // stop timer
+
+        if (state->polarityPending)
+            STM32F4_Pwm_ApplyPolarity(state); // a stopped timer has no update left to wait for
     }
 
     return TinyCLR_Result::Success;
@@ -383,41 +335,131 @@ double STM32F4_Pwm_GetMinFrequency(const TinyCLR_Pwm_Controller* self) {
 }
 
 TinyCLR_Result STM32F4_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* self, uint32_t channel, double dutyCycle, TinyCLR_Pwm_PulsePolarity polarity) {
+    return STM32F4_Pwm_SetPulseParametersBatch(self, &channel, &dutyCycle, &polarity, 1);
+}
+
+// TIM9 to TIM14 share their vectors with TIM1 and TIM8, the update handler is added next to the other users'
+static uint32_t STM32F4_Pwm_GetUpdateIrq(uint32_t timer) {
+    switch (timer) {
+    case 1: return TIM1_UP_TIM10_IRQn;
+    case 2: return TIM2_IRQn;
+    case 3: return TIM3_IRQn;
+    case 4: return TIM4_IRQn;
+    case 9: return TIM1_BRK_TIM9_IRQn;
+    case 11: return TIM1_TRG_COM_TIM11_IRQn;
+#if !defined(STM32F401xE) && !defined(STM32F411xE)
+    case 5: return TIM5_IRQn;
+    case 8: return TIM8_UP_TIM13_IRQn;
+    case 12: return TIM8_BRK_TIM12_IRQn;
+    case 14: return TIM8_TRG_COM_TIM14_IRQn;
+#endif
+    }
+
+    return 0;
+}
+
+static void STM32F4_Pwm_ApplyPolarity(PwmState* state) {
+    ptr_TIM_TypeDef treg = state->timReg;
+
+    treg->CCER = (treg->CCER & ~PWM_POLARITY_BITS) | state->polarity;
+    treg->DIER &= ~TIM_DIER_UIE;
+
+    STM32F4_InterruptInternal_RemoveShared(STM32F4_Pwm_GetUpdateIrq(state->timer), &STM32F4_Pwm_UpdateInterrupt, state);
+
+    state->polarityPending = false;
+}
+
+static void STM32F4_Pwm_UpdateInterrupt(void* param) {
+    auto state = reinterpret_cast<PwmState*>(param);
+
+    // runs on the update that loaded the batch, the polarity trails the new period by the interrupt latency
+    if (!state->polarityPending || !(state->timReg->SR & TIM_SR_UIF))
+        return;
+
+    state->timReg->SR = ~TIM_SR_UIF;
+
+    STM32F4_Pwm_ApplyPolarity(state);
+}
+
+static TinyCLR_Result STM32F4_Pwm_SetPulses(const TinyCLR_Pwm_Controller* self, const uint32_t* channels, const uint32_t* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count) {
     auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
     ptr_TIM_TypeDef treg = state->timReg;
 
-    uint32_t duration = (uint32_t)(dutyCycle * state->period);
+    if (state->burstActive)
+        return TinyCLR_Result::Busy;
 
-    if (duration > state->period)
-        duration = state->period;
+    for (size_t i = 0; i < count; i++)
+        if (channels[i] >= PWM_PER_CONTROLLER)
+            return TinyCLR_Result::ArgumentOutOfRange;
 
-    treg->PSC = (state->presc > 0) ? (state->presc - 1) : 0; // Make sure smallest is zero
-    treg->ARR = state->period; // User manual, ARR has no plus 1
-
-    if (state->timer == 2 || state->timer == 5) {
-        if (channel == 0)
-            treg->CCR1 = duration;
-        else if (channel == 1)
-            treg->CCR2 = duration;
-        else if (channel == 2)
-            treg->CCR3 = duration;
-        else if (channel == 3)
-            treg->CCR4 = duration;
+    uint32_t ccer = treg->CCER;
+
+    if (state->polarityPending)
+        ccer = (ccer & ~PWM_POLARITY_BITS) | state->polarity;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t invBit = TIM_CCER_CC1P << (4 * channels[i]);
+
+        if (polarities[i] == TinyCLR_Pwm_PulsePolarity::ActiveLow) {
+            ccer |= invBit;
+        }
+        else {
+            ccer &= ~invBit;
+        }
     }
-    else {
-        *(__IO uint16_t*)&((uint32_t*)&treg->CCR1)[channel] = duration;
+
+    auto updateIrq = STM32F4_Pwm_GetUpdateIrq(state->timer);
+
+    // CCER isn't preloaded, a running timer takes the new polarity from the update interrupt
+    // instead of flipping the outputs in the middle of the current period
+    auto deferPolarity = (ccer & PWM_POLARITY_BITS) != (treg->CCER & PWM_POLARITY_BITS) && updateIrq != 0 && !state->forceUpdate && (treg->CR1 & TIM_CR1_CEN);
+
+    // with no room left for the handler the polarity changes right away, as on a timer without an update vector
+    if (deferPolarity && !state->polarityPending && !STM32F4_InterruptInternal_AddShared(updateIrq, &STM32F4_Pwm_UpdateInterrupt, state))
+        deferPolarity = false;
+
+    // PSC, ARR and CCRx are preloaded, holding the update off while they change makes
+    // every channel and the period switch together at the end of the current period
+    treg->CR1 |= TIM_CR1_UDIS;
+
+    if (deferPolarity)
+        treg->SR = ~TIM_SR_UIF; // no update happens while UDIS is set, a raised flag is from an earlier period
+
+    treg->PSC = (state->presc > 0) ? (state->presc - 1) : 0; // Make sure smallest is zero
+    treg->ARR = (state->period > 0) ? (state->period - 1) : 0; // The counter runs from 0 to ARR
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t duration = TinyCLR_Pwm_GetPulse(state->period, dutyCycles[i]);
+
+        if (state->timer == 2 || state->timer == 5) {
+            (&treg->CCR1)[channels[i]] = duration;
+        }
+        else {
+            *(__IO uint16_t*)&((uint32_t*)&treg->CCR1)[channels[i]] = duration;
+        }
     }
 
-    uint32_t invBit = TIM_CCER_CC1P << (4 * channel);
+    if (deferPolarity) {
+        state->polarity = ccer & PWM_POLARITY_BITS;
+
+        if (!state->polarityPending) {
+            state->polarityPending = true;
 
-    if (polarity == TinyCLR_Pwm_PulsePolarity::ActiveLow) {
-        treg->CCER |= invBit;
+            treg->DIER |= TIM_DIER_UIE;
+        }
+    }
+    else if (state->polarityPending) {
+        state->polarity = ccer & PWM_POLARITY_BITS;
+
+        STM32F4_Pwm_ApplyPolarity(state);
     }
     else {
-        treg->CCER &= ~invBit;
+        treg->CCER = ccer;
     }
 
+    treg->CR1 &= ~TIM_CR1_UDIS;
+
     if (state->forceUpdate) {
         treg->EGR = TIM_EGR_UG; // enforce register update
 
@@ -426,27 +468,156 @@ TinyCLR_Result STM32F4_Pwm_SetPulseParameters(const TinyCLR_Pwm_Controller* self
         state->forceUpdate = (state->period == 0) ? true : false;
     }
 
-    state->invert[channel] = polarity;
-    state->dutyCycle[channel] = dutyCycle;
+    for (size_t i = 0; i < count; i++) {
+        state->invert[channels[i]] = polarities[i];
+        state->dutyCycle[channels[i]] = dutyCycles[i];
+    }
 
     return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Controller* self, const uint32_t* channels, const double* dutyCycles, const TinyCLR_Pwm_PulsePolarity* polarities, size_t count) {
+    uint32_t dutyCyclesPpm[PWM_PER_CONTROLLER];
+
+    if (count > PWM_PER_CONTROLLER)
+        return TinyCLR_Result::ArgumentOutOfRange;
 
+    for (size_t i = 0; i < count; i++)
+        dutyCyclesPpm[i] = TinyCLR_Pwm_FromDutyCycle(dutyCycles[i]);
+
+    return STM32F4_Pwm_SetPulses(self, channels, dutyCyclesPpm, polarities, count);
 }
 
 TinyCLR_Result STM32F4_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Controller* self, double& frequency) {
     auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
+    if (state->burstActive)
+        return TinyCLR_Result::Busy;
+
     // If detected a different, save desired frequency
-    state->theoryFreq = frequency;
+    state->frequency = TinyCLR_Pwm_FromFrequency(frequency);
 
     // Calculate actual frequency base on desired frequency
     frequency = STM32F4_Pwm_GetActualFrequency(self);
 
-    // Update channel if frequency had different
-    for (int p = 0; p < PWM_PER_CONTROLLER; p++)
+    uint32_t channels[PWM_PER_CONTROLLER];
+    size_t count = 0;
+
+    for (uint32_t p = 0; p < PWM_PER_CONTROLLER; p++)
         if (state->gpioPin[p].number != PIN_NONE)
-            if (STM32F4_Pwm_SetPulseParameters(self, p, state->dutyCycle[p], state->invert[p]) != TinyCLR_Result::Success)
-                return TinyCLR_Result::InvalidOperation;
+            channels[count++] = p;
+
+    uint32_t dutyCycles[PWM_PER_CONTROLLER];
+    TinyCLR_Pwm_PulsePolarity polarities[PWM_PER_CONTROLLER];
+
+    for (size_t i = 0; i < count; i++) {
+        dutyCycles[i] = state->dutyCycle[channels[i]];
+        polarities[i] = state->invert[channels[i]];
+    }
+
+    // Update channel if frequency had different, all in the same period
+    if (STM32F4_Pwm_SetPulses(self, channels, dutyCycles, polarities, count) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Pwm_EncodeBurst(const TinyCLR_Pwm_Controller* self, uint32_t channel, const double* dutyCycles, uint32_t* pulses, size_t count, size_t stride) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
+
+    if (channel >= PWM_PER_CONTROLLER)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    for (size_t i = 0; i < count; i++)
+        pulses[i * stride] = TinyCLR_Pwm_GetPulse(state->period, TinyCLR_Pwm_FromDutyCycle(dutyCycles[i * stride]));
+
+    return TinyCLR_Result::Success;
+}
+
+static void STM32F4_Pwm_EndBurst(PwmState* state) {
+    auto& dma = pwmBurstDma[state->timer - 1];
+
+    state->timReg->DIER &= ~TIM_DIER_UDE;
+
+    STM32F4_DmaInternal_Release(dma);
+
+    if (!state->burstLooped)
+        STM32F4_InterruptInternal_Deactivate(STM32F4_DmaInternal_GetInterrupt(dma));
+
+    state->burstActive = false;
+}
+
+static void STM32F4_Pwm_BurstInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    // every timer bursts on its own stream, the handler finds which one completed
+    for (auto i = 0; i < TOTAL_PWM_CONTROLLERS; i++) {
+        auto state = &pwmStates[i];
+
+        if (!state->burstActive || state->burstLooped)
+            continue;
+
+        if (!(STM32F4_DmaInternal_ReadAndClearFlags(pwmBurstDma[state->timer - 1]) & DMA_LISR_TCIF0))
+            continue;
+
+        STM32F4_Pwm_EndBurst(state);
+
+        if (state->burstCompleted != nullptr)
+            state->burstCompleted(&pwmControllers[i], STM32F4_Time_GetSystemTime(nullptr));
+    }
+}
+
+TinyCLR_Result STM32F4_Pwm_StartBurst(const TinyCLR_Pwm_Controller* self, uint32_t firstChannel, uint32_t channelCount, const uint32_t* pulses, size_t sets, bool looped, TinyCLR_Pwm_BurstCompletedHandler completed) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
+
+    ptr_TIM_TypeDef treg = state->timReg;
+
+    if (channelCount == 0 || firstChannel + channelCount > PWM_PER_CONTROLLER || sets == 0 || sets * channelCount > 0xFFFF)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (state->timer > PWM_BURST_DMA_TIMERS || pwmBurstDma[state->timer - 1].controller == 0)
+        return TinyCLR_Result::NotSupported;
+
+    // the update events pace the burst, a stopped timer never asks for the next set
+    if (state->burstActive || !(treg->CR1 & TIM_CR1_CEN))
+        return TinyCLR_Result::InvalidOperation;
+
+    auto& dma = pwmBurstDma[state->timer - 1];
+
+    if (!STM32F4_DmaInternal_Acquire(dma))
+        return TinyCLR_Result::NotAvailable;
+
+    state->burstLooped = looped;
+    state->burstCompleted = completed;
+    state->burstActive = true;
+
+    // each update writes channelCount words through DMAR into the preloaded CCRx from firstChannel,
+    // they are output from the update after
+    treg->DCR = ((channelCount - 1) << TIM_DCR_DBL_Pos) | ((PWM_BURST_CCR1_OFFSET + firstChannel) << TIM_DCR_DBA_Pos);
+
+    if (!looped)
+        STM32F4_InterruptInternal_Activate(STM32F4_DmaInternal_GetInterrupt(dma), (uint32_t*)&STM32F4_Pwm_BurstInterrupt, 0);
+
+    STM32F4_DmaInternal_Start(dma, (uint32_t)&treg->DMAR, (uint32_t)pulses, sets * channelCount, DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | (looped ? DMA_SxCR_CIRC : DMA_SxCR_TCIE));
+
+    treg->DIER |= TIM_DIER_UDE;
+
+    return TinyCLR_Result::Success;
+}
+
+bool STM32F4_Pwm_IsBurstActive(const TinyCLR_Pwm_Controller* self) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
+
+    return state->burstActive;
+}
+
+TinyCLR_Result STM32F4_Pwm_StopBurst(const TinyCLR_Pwm_Controller* self) {
+    auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
+
+    if (!state->burstActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    STM32F4_Pwm_EndBurst(state);
 
     return TinyCLR_Result::Success;
 }
@@ -454,6 +625,12 @@ TinyCLR_Result STM32F4_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Controller* sel
 TinyCLR_Result STM32F4_Pwm_Acquire(const TinyCLR_Pwm_Controller* self) {
     auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
+#if defined(STM32F4_TIME_TIMER)
+    // the timer counts native time
+    if (state->controllerIndex + 1 == STM32F4_TIME_TIMER)
+        return TinyCLR_Result::SharingViolation;
+#endif
+
     if (state->initializeCount == 0)
         STM32F4_Pwm_ResetController(state->controllerIndex);
 
@@ -502,6 +679,12 @@ void STM32F4_Pwm_Reset() {
 void STM32F4_Pwm_ResetController(int32_t controllerIndex) {
     auto state = &pwmStates[controllerIndex];
 
+    if (state->burstActive)
+        STM32F4_Pwm_EndBurst(state);
+
+    if (state->polarityPending)
+        STM32F4_Pwm_ApplyPolarity(state);
+
     for (int p = 0; p < PWM_PER_CONTROLLER; p++) {
         state->gpioPin[p].number = pwmPins[controllerIndex][p].number;
         state->gpioPin[p].alternateFunction = pwmPins[controllerIndex][p].alternateFunction;
@@ -519,8 +702,7 @@ void STM32F4_Pwm_ResetController(int32_t controllerIndex) {
         state->isOpened[p] = false;
     }
 
-    state->theoryFreq = 0.0;
-    state->actualFreq = 0.0;
+    state->frequency = 0;
     state->period = 0;
     state->presc = 0;
     state->timer = controllerIndex + 1;
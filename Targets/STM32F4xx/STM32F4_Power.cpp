@@ -15,17 +15,38 @@
 // limitations under the License.
 
 #include "STM32F4.h"
+#include "../../Drivers/Time/TicklessIdle.h"
 
 #define TOTAL_POWER_CONTROLLERS 1
 /* CR register bit mask */
 #define CR_DS_MASK               ((uint32_t)0xFFFFFFFC)
 #define CR_PLS_MASK              ((uint32_t)0xFFFFFF1F)
 
+// With STM32F4_TICKLESS_IDLE defined in Device.h the Idle level, which the task manager sets when it has nothing to
+// run, enters STOP when the next native time event is far enough away. Drivers waiting for an interrupt only sleep. The RTC wakeup timer ends STOP shortly before the event, any EXTI line
+// earlier. Peripherals that need their clock to receive, UART or SPI slave, lose data while the core is stopped, so a
+// board only enables this when its wake sources are pins and timed events. STOP is skipped while USB is on.
+#define TICKLESS_WAKEUP_CLOCK_HZ (32768 / 16)
+#define TICKLESS_WAKEUP_MAX_COUNTS 0x10000
+
+// Time in 100ns ticks the clocks take to restart after STOP, the wakeup timer ends STOP that much before the next event
+#ifndef STM32F4_TICKLESS_WAKEUP_LATENCY
+#define STM32F4_TICKLESS_WAKEUP_LATENCY (2 * 10000)
+#endif
+
+// Shorter idle periods only sleep, STOP would cost more than it saves
+#ifndef STM32F4_TICKLESS_MINIMUM_IDLE
+#define STM32F4_TICKLESS_MINIMUM_IDLE (5 * 10000)
+#endif
+
 extern "C" void SystemInit();
 
 struct PowerState {
     uint32_t controllerIndex;
     bool tableInitialized;
+
+    bool stopInitialized;
+    bool stopUnavailable;
 };
 
 const char* powerApiNames[TOTAL_POWER_CONTROLLERS] = {
@@ -122,6 +143,11 @@ TinyCLR_Result STM32F4_Power_SetLevel(const TinyCLR_Power_Controller* self, Tiny
         break;
 
     case TinyCLR_Power_Level::Idle:   // Idle
+#if defined(STM32F4_TICKLESS_IDLE)
+        if (STM32F4_Power_Stop())
+            return TinyCLR_Result::Success;
+
+#endif
         PWR->CR |= PWR_CR_CWUF;
 
         __WFI();
@@ -139,6 +165,147 @@ TinyCLR_Result STM32F4_Power_SetLevel(const TinyCLR_Power_Controller* self, Tiny
     return TinyCLR_Result::Success;
 }
 
+// Wakeup timer counts for an idle period in 100ns ticks, zero when STOP does not pay off. Longer periods are cut to
+// the longest the timer counts, the core then stops again.
+uint32_t STM32F4_Power_GetWakeupCounts(uint64_t idleTime) {
+    return TicklessIdle_GetWakeupCounts(idleTime, TICKLESS_WAKEUP_CLOCK_HZ, TICKLESS_WAKEUP_MAX_COUNTS, STM32F4_TICKLESS_WAKEUP_LATENCY, STM32F4_TICKLESS_MINIMUM_IDLE);
+}
+
+#if defined(STM32F4_TICKLESS_IDLE)
+static void STM32F4_Power_WakeupInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    // STOP is over, the wakeup flags were cleared when the clocks came back
+    EXTI->PR = EXTI_PR_PR22;
+}
+
+static bool STM32F4_Power_InitializeStop(PowerState* state) {
+    if (state->stopInitialized)
+        return true;
+
+    if (state->stopUnavailable)
+        return false;
+
+    auto result = (RCC->BDCR & RCC_BDCR_RTCEN) == 0 ?
+        (STM32F4_Rtc_Configuration() == TinyCLR_Result::Success ? STM32F4_Rtc_Initialize() : TinyCLR_Result::InvalidOperation) :
+        STM32F4_Rtc_CheckPrescaler();
+
+    if (result != TinyCLR_Result::Success) {
+        state->stopUnavailable = true;
+
+        return false;
+    }
+
+    // the wakeup timer reaches the core through EXTI line 22
+    EXTI->IMR |= EXTI_IMR_MR22;
+    EXTI->RTSR |= EXTI_RTSR_TR22;
+
+    STM32F4_InterruptInternal_Activate(RTC_WKUP_IRQn, (uint32_t*)&STM32F4_Power_WakeupInterrupt, 0);
+
+    state->stopInitialized = true;
+
+    return true;
+}
+
+static void STM32F4_Power_SetWakeup(uint32_t counts) {
+    STM32F4_Rtc_SetWriteProtection(false);
+
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+
+    if (counts > 0) {
+        while ((RTC->ISR & RTC_ISR_WUTWF) == 0);
+
+        RTC->WUTR = counts - 1;
+        RTC->CR = (RTC->CR & ~RTC_CR_WUCKSEL) | RTC_CR_WUTIE | RTC_CR_WUTE; // RTCCLK / 16
+    }
+
+    RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+
+    STM32F4_Rtc_SetWriteProtection(true);
+
+    EXTI->PR = EXTI_PR_PR22;
+}
+
+// time of day in subseconds, reading SSR first holds TR until DR is read
+static uint32_t STM32F4_Power_GetRtcSubseconds(uint32_t subsecondsPerSecond) {
+    auto subseconds = RTC->SSR & RTC_SSR_SS;
+    auto time = RTC->TR;
+
+    (void)RTC->DR;
+
+    auto hour = STM32F4_Rtc_Bcd2ToByte(static_cast<uint8_t>((time & (RTC_TR_HT | RTC_TR_HU)) >> 16));
+    auto minute = STM32F4_Rtc_Bcd2ToByte(static_cast<uint8_t>((time & (RTC_TR_MNT | RTC_TR_MNU)) >> 8));
+    auto second = STM32F4_Rtc_Bcd2ToByte(static_cast<uint8_t>(time & (RTC_TR_ST | RTC_TR_SU)));
+
+    return ((hour * 60 + minute) * 60 + second) * subsecondsPerSecond + (subsecondsPerSecond - 1 - subseconds);
+}
+
+bool STM32F4_Power_Stop() {
+    auto state = &powerStates[0];
+
+#ifdef RCC_AHB2ENR_OTGFSEN
+    if (RCC->AHB2ENR & RCC_AHB2ENR_OTGFSEN)
+        return false;
+#endif
+
+#ifdef RCC_AHB1ENR_OTGHSEN
+    if (RCC->AHB1ENR & RCC_AHB1ENR_OTGHSEN)
+        return false;
+#endif
+
+    if (!STM32F4_Power_InitializeStop(state))
+        return false;
+
+    register uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    auto now = STM32F4_Time_GetCurrentProcessorTicks(nullptr);
+    auto next = STM32F4_Time_GetNextTickCallbackTime();
+    auto idleTime = next > now ? STM32F4_Time_GetTimeForProcessorTicks(nullptr, next - now) : 0;
+    auto counts = STM32F4_Power_GetWakeupCounts(idleTime);
+
+    if (counts == 0) {
+        __set_PRIMASK(primask);
+
+        return false;
+    }
+
+    auto subsecondsPerSecond = (RTC->PRER & RTC_PRER_PREDIV_S) + 1;
+
+    STM32F4_Power_SetWakeup(counts);
+
+    auto start = STM32F4_Power_GetRtcSubseconds(subsecondsPerSecond);
+
+    PWR->CR = (PWR->CR & CR_DS_MASK) | PWR_CR_LPDS;
+
+    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+
+    // with interrupts masked the pending interrupt only ends STOP, it runs once clocks and time are back
+    __DSB();
+    __WFI();
+
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+    // the core comes out of STOP on HSI, an interrupt already pending did not stop it
+    if ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL)
+        SystemInit();
+
+    STM32F4_Power_SetWakeup(0);
+    STM32F4_Rtc_WaitForSynchro();
+
+    auto end = STM32F4_Power_GetRtcSubseconds(subsecondsPerSecond);
+
+    STM32F4_Time_AddProcessorTicks(STM32F4_Time_GetProcessorTicksForTime(nullptr, TicklessIdle_GetElapsedTime(start, end, subsecondsPerSecond)));
+
+    __enable_irq();
+
+    __set_PRIMASK(primask);
+
+    return true;
+}
+#endif
+
 TinyCLR_Result STM32F4_Power_Reset(const TinyCLR_Power_Controller* self, bool runCoreAfter) {
 #if defined BOOTLOADER_HOLD_VALUE && defined BOOTLOADER_HOLD_ADDRESS && BOOTLOADER_HOLD_ADDRESS > 0
     if (!runCoreAfter)
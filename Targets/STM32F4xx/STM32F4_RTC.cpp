@@ -73,6 +73,16 @@
 
 #define RTC_TIMEOUT 0xFFFFFF
 
+#if defined(STM32F4_TICKLESS_IDLE)
+// 32768Hz / 8 / 4096, the 4096Hz subseconds measure the time spent in STOP
+#define RTC_PRESCALER_SYNCHRONOUS  0xFFF
+#define RTC_PRESCALER_ASYNCHRONOUS 0x07
+#else
+// 32768Hz / 128 / 256, the lower asynchronous clock draws less current
+#define RTC_PRESCALER_SYNCHRONOUS  0xFF
+#define RTC_PRESCALER_ASYNCHRONOUS 0x7F
+#endif
+
 #define TOTAL_RTC_CONTROLLERS 1
 
 static TinyCLR_Rtc_Controller rtcControllers[TOTAL_RTC_CONTROLLERS];
@@ -219,8 +229,8 @@ TinyCLR_Result STM32F4_Rtc_Initialize() {
     RTC->CR |= RTC_HourFormat_24;
 
     /* Configure the RTC PRER */
-    RTC->PRER = 0xFF;
-    RTC->PRER |= 0x7F << 16;
+    RTC->PRER = RTC_PRESCALER_SYNCHRONOUS;
+    RTC->PRER |= RTC_PRESCALER_ASYNCHRONOUS << 16;
 
     /* Exit Initialization mode */
     STM32F4_Rtc_SetInitializeMode(false);
@@ -231,6 +241,21 @@ TinyCLR_Result STM32F4_Rtc_Initialize() {
     return TinyCLR_Result::Success;
 }
 
+// An RTC kept running across a reset keeps the prescaler of the firmware that started it, and its registers are write
+// protected again by the reset. Reprogramming the prescaler restarts the current second, so it is only done when it differs.
+TinyCLR_Result STM32F4_Rtc_CheckPrescaler() {
+    /* Enable the PWR clock */
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+
+    /* Allow access to RTC */
+    *(reinterpret_cast<uint32_t *>(CR_DBP_BB)) = 1;
+
+    if ((RTC->PRER & (RTC_PRER_PREDIV_A | RTC_PRER_PREDIV_S)) == (RTC_PRESCALER_SYNCHRONOUS | (RTC_PRESCALER_ASYNCHRONOUS << 16)))
+        return TinyCLR_Result::Success;
+
+    return STM32F4_Rtc_Initialize();
+}
+
 void STM32F4_Rtc_WriteBackupRegister() {
     *(reinterpret_cast<uint32_t *>(RTC_BASE + 0x50)) = (uint32_t)0x32F2;
 }
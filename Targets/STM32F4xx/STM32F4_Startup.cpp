@@ -30,6 +30,9 @@ void STM32F4_Startup_OnSoftReset(const TinyCLR_Api_Manager* apiManager, const Ti
 #ifdef INCLUDE_DISPLAY
     STM32F4_Display_Reset();
 #endif
+#ifdef INCLUDE_ENCODER
+    STM32F4_Encoder_Reset();
+#endif
 #ifdef INCLUDE_GPIO
     STM32F4_Gpio_Reset();
 #endif
@@ -15,22 +15,56 @@
 // limitations under the License.
 
 #include "STM32F4.h"
+#include "../../Drivers/Time/TimeDivider.h"
 
 #define TIMER_IDLE_VALUE  0x0000FFFFFFFFFFFFull
 
 #define TOTAL_TIME_CONTROLLERS 1
+
+// A board that defines STM32F4_TIME_TIMER as 2 or 5 counts native time with that free running 32 bit timer, extended
+// to 64 bits by its overflow interrupt, instead of adding up SysTick reloads. Reading the time then masks no interrupts
+// and SysTick only raises the next event. The PWM controller of that timer is no longer available.
+#if defined(STM32F4_TIME_TIMER)
+#if STM32F4_TIME_TIMER == 2
+#define TIME_TIMER TIM2
+#define TIME_TIMER_IRQn TIM2_IRQn
+#define TIME_TIMER_CLOCK_ENABLE RCC_APB1ENR_TIM2EN
+#elif STM32F4_TIME_TIMER == 5
+#define TIME_TIMER TIM5
+#define TIME_TIMER_IRQn TIM5_IRQn
+#define TIME_TIMER_CLOCK_ENABLE RCC_APB1ENR_TIM5EN
+#else
+#error "STM32F4_TIME_TIMER must be 2 or 5"
+#endif
+
+#if STM32F4_APB1_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define TIME_TIMER_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ)
+#else
+#define TIME_TIMER_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ * 2)
+#endif
+
+#define SYSTICK_CLOCKS_PER_TICK (STM32F4_AHB_CLOCK_HZ / TIME_TIMER_CLOCK_HZ)
+
+#define SLOW_CLOCKS_PER_SECOND TIME_TIMER_CLOCK_HZ
+#else
 #define SLOW_CLOCKS_PER_SECOND STM32F4_AHB_CLOCK_HZ
+#endif
 #define SLOW_CLOCKS_TEN_MHZ_GCD           1000000   // GCD(SLOW_CLOCKS_PER_SECOND, 10M)
 #define SLOW_CLOCKS_MILLISECOND_GCD          1000   // GCD(SLOW_CLOCKS_PER_SECOND, 1k)
 #define CLOCK_COMMON_FACTOR               1000000   // GCD(STM32F4_SYSTEM_CLOCK_HZ, 1M)
 #define CORTEXM_SLEEP_USEC_FIXED_OVERHEAD_CLOCKS 3
 
+static constexpr TimeDivider timeTicksDivider = TimeDivider_Create(SLOW_CLOCKS_PER_SECOND / SLOW_CLOCKS_TEN_MHZ_GCD);
+static constexpr TimeDivider timeTenDivider = TimeDivider_Create(10);
+
 struct TimeState {
     int32_t controllerIndex;
     uint64_t m_lastRead;
     uint32_t m_currentTick;
     uint32_t m_periodTicks;
 
+    volatile uint32_t m_timerHigh;
+
     TinyCLR_NativeTime_Callback m_DequeuAndExecute;
     const TinyCLR_SystemTime_Manager* systemTime;
 
@@ -93,16 +127,17 @@ void STM32F4_Time_AddApi(const TinyCLR_Api_Manager* apiManager) {
 }
 
 static uint64_t timerNextEvent;   // tick time of next event to be scheduled
+static uint64_t timerNextWakeup = TIMER_IDLE_VALUE; // tick time a driver waiting for an interrupt wakes up at
 
 uint64_t STM32F4_Time_GetTimeForProcessorTicks(const TinyCLR_NativeTime_Controller* self, uint64_t ticks) {
     ticks *= (10000000 / SLOW_CLOCKS_TEN_MHZ_GCD);
-    ticks /= (SLOW_CLOCKS_PER_SECOND / SLOW_CLOCKS_TEN_MHZ_GCD);
+    ticks = TimeDivider_Divide(ticks, timeTicksDivider);
 
     return ticks;
 }
 
 uint64_t STM32F4_Time_GetProcessorTicksForTime(const TinyCLR_NativeTime_Controller* self, uint64_t time) {
-    time /= 10;
+    time = TimeDivider_Divide(time, timeTenDivider);
 
 #if 1000000 <= SLOW_CLOCKS_PER_SECOND
     return time * (SLOW_CLOCKS_PER_SECOND / 1000000);
@@ -115,6 +150,98 @@ uint64_t STM32F4_Time_GetCurrentProcessorTime() {
     return STM32F4_Time_GetTimeForProcessorTicks(nullptr, STM32F4_Time_GetCurrentProcessorTicks(nullptr));
 }
 
+#if defined(STM32F4_TIME_TIMER)
+uint64_t STM32F4_Time_GetCurrentProcessorTicks(const TinyCLR_NativeTime_Controller* self) {
+    TimeState* state = ((self == nullptr) ? &timeStates[0] : reinterpret_cast<TimeState*>(self->ApiInfo->State));
+
+    // Read high, low and high again: when the overflow interrupt ran in between the read is done again. An overflow
+    // the interrupt did not handle yet, because the caller masks interrupts or runs at a higher priority, shows as a
+    // pending update with the counter already wrapped.
+    while (true) {
+        auto high = state->m_timerHigh;
+        auto low = TIME_TIMER->CNT;
+        auto pending = (TIME_TIMER->SR & TIM_SR_UIF) != 0;
+
+        if (high != state->m_timerHigh)
+            continue;
+
+        if (pending && low < 0x80000000)
+            high++;
+
+        return ((uint64_t)high << 32) | low;
+    }
+}
+
+static void STM32F4_Time_TimerInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    // a reader preempting this must never see the update cleared with the old high word
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (TIME_TIMER->SR & TIM_SR_UIF) {
+        TIME_TIMER->SR = ~TIM_SR_UIF;
+
+        timeStates[0].m_timerHigh++;
+    }
+}
+
+// SysTick counts down from the next event so the count never stops, events further than a SysTick period away
+// take more than one interrupt.
+TinyCLR_Result STM32F4_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Controller* self, uint64_t processorTicks) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    TimeState* state = ((self == nullptr) ? &timeStates[0] : reinterpret_cast<TimeState*>(self->ApiInfo->State));
+
+    auto ticks = STM32F4_Time_GetCurrentProcessorTicks(self);
+
+    timerNextEvent = processorTicks;
+
+    if (timerNextWakeup <= ticks)
+        timerNextWakeup = TIMER_IDLE_VALUE;
+
+    if (timerNextEvent >= TIMER_IDLE_VALUE) {
+        if (ticks < TIMER_IDLE_VALUE) {
+            if (timerNextWakeup >= TIMER_IDLE_VALUE) {
+                SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+
+                return TinyCLR_Result::Success;
+            }
+        }
+        else {
+            // the count restarts from zero as it does with SysTick as time base
+            timerNextEvent = timerNextEvent > ticks ? (timerNextEvent - ticks) : 0;
+            timerNextWakeup = TIMER_IDLE_VALUE;
+
+            TIME_TIMER->CNT = 0;
+            TIME_TIMER->SR = ~TIM_SR_UIF;
+
+            state->m_timerHigh = 0;
+
+            ticks = 0;
+        }
+    }
+
+    if (ticks >= timerNextEvent) { // missed event
+        state->m_DequeuAndExecute();
+    }
+    else {
+        auto delta = STM32F4_Time_GetNextTickCallbackTime() - ticks;
+        uint32_t clocks = SysTick_LOAD_RELOAD_Msk;
+
+        if (delta < SysTick_LOAD_RELOAD_Msk / SYSTICK_CLOCKS_PER_TICK)
+            clocks = (uint32_t)delta * SYSTICK_CLOCKS_PER_TICK;
+
+        if (clocks < 2) // a reload value of zero stops SysTick
+            clocks = 2;
+
+        state->Reload(clocks);
+
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    }
+
+    return TinyCLR_Result::Success;
+}
+#else
 uint64_t STM32F4_Time_GetCurrentProcessorTicks(const TinyCLR_NativeTime_Controller* self) {
     DISABLE_INTERRUPTS_SCOPED(irq);
 
@@ -154,9 +281,13 @@ TinyCLR_Result STM32F4_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Con
 
     timerNextEvent = processorTicks;
 
+    if (timerNextWakeup <= ticks)
+        timerNextWakeup = TIMER_IDLE_VALUE;
+
     if (timerNextEvent >= TIMER_IDLE_VALUE) {
         if (ticks >= TIMER_IDLE_VALUE) {
             timerNextEvent = timerNextEvent > ticks ? (timerNextEvent - ticks) : 0;
+            timerNextWakeup = TIMER_IDLE_VALUE;
 
             state->m_lastRead = 0;
 
@@ -168,6 +299,10 @@ TinyCLR_Result STM32F4_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Con
             state->Reload(state->m_periodTicks);
 
         }
+        else if (timerNextWakeup - ticks < SysTick_LOAD_RELOAD_Msk) {
+            state->m_periodTicks = (uint32_t)(timerNextWakeup - ticks);
+            state->Reload(state->m_periodTicks);
+        }
         else {
             state->m_periodTicks = SysTick_LOAD_RELOAD_Msk;
             state->Reload(SysTick_LOAD_RELOAD_Msk);
@@ -178,7 +313,7 @@ TinyCLR_Result STM32F4_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Con
             state->m_DequeuAndExecute();
         }
         else {
-            state->m_periodTicks = (timerNextEvent - ticks);
+            state->m_periodTicks = (STM32F4_Time_GetNextTickCallbackTime() - ticks);
 
             if (state->m_periodTicks >= SysTick_LOAD_RELOAD_Msk) {
                 state->Reload(SysTick_LOAD_RELOAD_Msk);
@@ -192,6 +327,49 @@ TinyCLR_Result STM32F4_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Con
     return TinyCLR_Result::Success;
 }
 
+#endif
+
+// SysTick is due at the next event or at an earlier wake up
+uint64_t STM32F4_Time_GetNextTickCallbackTime() {
+    return timerNextWakeup < timerNextEvent ? timerNextWakeup : timerNextEvent;
+}
+
+// Raises the SysTick interrupt no later than processorTicks. Nothing runs then, the interrupt only wakes a driver that
+// waits for an interrupt with a deadline. Call it with interrupts masked before the wait.
+void STM32F4_Time_ScheduleWakeup(uint64_t processorTicks) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto ticks = STM32F4_Time_GetCurrentProcessorTicks(nullptr);
+
+    if (timerNextWakeup > ticks && timerNextWakeup <= processorTicks)
+        return;
+
+    timerNextWakeup = processorTicks;
+
+    // a missed event raises SysTick already and programs the wake up when it reschedules
+    if (ticks < timerNextEvent)
+        STM32F4_Time_SetNextTickCallbackTime(nullptr, timerNextEvent);
+}
+
+// Native time stands still while the core is stopped, it moves on by the time the RTC measured meanwhile.
+void STM32F4_Time_AddProcessorTicks(uint64_t processorTicks) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto state = &timeStates[0];
+    auto ticks = STM32F4_Time_GetCurrentProcessorTicks(nullptr) + processorTicks;
+
+#if defined(STM32F4_TIME_TIMER)
+    TIME_TIMER->CNT = (uint32_t)ticks;
+    TIME_TIMER->SR = ~TIM_SR_UIF;
+
+    state->m_timerHigh = (uint32_t)(ticks >> 32);
+#else
+    state->m_lastRead = ticks;
+#endif
+
+    STM32F4_Time_SetNextTickCallbackTime(nullptr, timerNextEvent);
+}
+
 extern "C" {
 
     void SysTick_Handler(void *param) {
@@ -216,6 +394,31 @@ TinyCLR_Result STM32F4_Time_Initialize(const TinyCLR_NativeTime_Controller* self
 
     TimeState* state = ((self == nullptr) ? &timeStates[0] : reinterpret_cast<TimeState*>(self->ApiInfo->State));
 
+#if defined(STM32F4_TIME_TIMER)
+    RCC->APB1ENR |= TIME_TIMER_CLOCK_ENABLE;
+
+    TIME_TIMER->CR1 = TIM_CR1_URS; // only overflows raise the update interrupt
+    TIME_TIMER->PSC = 0;
+    TIME_TIMER->ARR = 0xFFFFFFFF;
+    TIME_TIMER->EGR = TIM_EGR_UG;
+    TIME_TIMER->CNT = 0;
+    TIME_TIMER->SR = 0;
+    TIME_TIMER->DIER = TIM_DIER_UIE;
+
+    state->m_timerHigh = 0;
+
+    STM32F4_InterruptInternal_Activate(TIME_TIMER_IRQn, (uint32_t*)&STM32F4_Time_TimerInterrupt, 0);
+
+    TIME_TIMER->CR1 |= TIM_CR1_CEN;
+
+    state->m_currentTick = SysTick_LOAD_RELOAD_Msk;
+    state->m_periodTicks = SysTick_LOAD_RELOAD_Msk;
+
+    SysTick_Config(state->m_periodTicks);
+
+    // nothing is scheduled yet
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+#else
     state->m_lastRead = 0;
 
     state->m_currentTick = SysTick_LOAD_RELOAD_Msk;
@@ -224,6 +427,7 @@ TinyCLR_Result STM32F4_Time_Initialize(const TinyCLR_NativeTime_Controller* self
     SysTick_Config(state->m_periodTicks);
 
     state->Reload(state->m_periodTicks);
+#endif
 
     return TinyCLR_Result::Success;
 }
@@ -231,6 +435,15 @@ TinyCLR_Result STM32F4_Time_Initialize(const TinyCLR_NativeTime_Controller* self
 TinyCLR_Result STM32F4_Time_Uninitialize(const TinyCLR_NativeTime_Controller* self) {
     SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
 
+#if defined(STM32F4_TIME_TIMER)
+    TIME_TIMER->CR1 &= ~TIM_CR1_CEN;
+    TIME_TIMER->DIER = 0;
+
+    STM32F4_InterruptInternal_Deactivate(TIME_TIMER_IRQn);
+
+    RCC->APB1ENR &= ~TIME_TIMER_CLOCK_ENABLE;
+#endif
+
     return TinyCLR_Result::Success;
 }
 
@@ -276,7 +489,7 @@ void STM32F4_Time_Delay(const TinyCLR_NativeTime_Controller* self, uint64_t micr
 void STM32F4_Time_DelayNative(const TinyCLR_NativeTime_Controller* self, uint64_t nativeTime) {
     //TODO do inline later, don't call out to Delay
 
-    auto microseconds = STM32F4_Time_GetTimeForProcessorTicks(self, nativeTime) / 10;
+    auto microseconds = TimeDivider_Divide(STM32F4_Time_GetTimeForProcessorTicks(self, nativeTime), timeTenDivider);
 
     STM32F4_Time_Delay(self, microseconds);
 }
@@ -113,6 +113,7 @@
 
 #define OTG_DIEPTSIZ_PKTCNT   (3<<19)
 #define OTG_DIEPTSIZ_PKTCNT_1 (1<<19)
+#define OTG_DIEPTSIZ_PKTCNT_Pos 19
 
 #define OTG_DOEPTSIZ_PKTCNT   (3<<19)
 #define OTG_DOEPTSIZ_PKTCNT_1 (1<<19)
@@ -235,6 +236,8 @@ typedef struct {
     uint8_t     previousDeviceState;
     uint16_t    endpointType;
 
+    bool        controlOutData;
+
 } UsbDeviceController;
 
 #define USB_DEVICE_DM_PIN 0
@@ -274,12 +277,16 @@ void STM32F4_UsbDevice_InitializeConfiguration(UsbClientState *usbClientState) {
         usbDeviceControllers[controllerIndex].usbClientState = usbClientState;
 
         usbDeviceControllers[controllerIndex].endpointType = 0;
-        for (auto i = 0; i < usbDeviceControllers[controllerIndex].usbClientState->deviceDescriptor.Configurations->Interfaces->EndpointCount; i++) {
-            TinyCLR_UsbClient_EndpointDescriptor  *ep = (TinyCLR_UsbClient_EndpointDescriptor*)&usbDeviceControllers[controllerIndex].usbClientState->deviceDescriptor.Configurations->Interfaces->Endpoints[i];
+        for (auto ifc = 0; ifc < usbClientState->deviceDescriptor.Configurations->InterfaceCount; ifc++) {
+            auto interface = &usbClientState->deviceDescriptor.Configurations->Interfaces[ifc];
+
+            for (auto i = 0; i < interface->EndpointCount; i++) {
+                TinyCLR_UsbClient_EndpointDescriptor  *ep = (TinyCLR_UsbClient_EndpointDescriptor*)&interface->Endpoints[i];
 
-            auto idx = ep->Address & 0x0F;
+                auto idx = ep->Address & 0x0F;
 
-            usbDeviceControllers[controllerIndex].endpointType |= (ep->Attributes & 3) << (idx * 2);
+                usbDeviceControllers[controllerIndex].endpointType |= (ep->Attributes & 3) << (idx * 2);
+            }
         }
     }
 }
@@ -441,7 +448,7 @@ void STM32F4_UsbDevice_ResetEvent(OTG_TypeDef* OTG, UsbClientState* usbClientSta
     TinyCLR_UsbClient_StateCallback(usbClientState);
 }
 
-void STM32F4_UsbDevice_EndpointRxInterrupt(OTG_TypeDef* OTG, UsbClientState* usbClientState, uint32_t ep, uint32_t count) {
+void STM32F4_UsbDevice_EndpointRxInterrupt(OTG_TypeDef* OTG, UsbClientState* usbClientState, uint32_t ep, uint32_t count, bool setup) {
     uint32_t* pd;
 
     bool disableRx = false;
@@ -450,14 +457,14 @@ void STM32F4_UsbDevice_EndpointRxInterrupt(OTG_TypeDef* OTG, UsbClientState* usb
         pd = (uint32_t*)usbClientState->controlEndpointBuffer;
         usbClientState->ptrData = (uint8_t*)pd;
         usbClientState->dataSize = count;
+
+        // data stage of a control write, handled when the transfer completes
+        usbDeviceControllers[usbClientState->controllerIndex].controlOutData = !setup && count > 0;
     }
     else { // data endpoint
-        USB_PACKET64* Packet64 = TinyCLR_UsbClient_RxEnqueue(usbClientState, ep, disableRx);
+        pd = (uint32_t*)TinyCLR_UsbClient_RxEnqueue(usbClientState, ep, disableRx);
 
         if (disableRx) return;
-
-        pd = (uint32_t*)Packet64->Buffer;
-        Packet64->Size = count;
     }
 
     // read data
@@ -465,6 +472,16 @@ void STM32F4_UsbDevice_EndpointRxInterrupt(OTG_TypeDef* OTG, UsbClientState* usb
     for (int32_t c = count; c > 0; c -= 4) {
         *pd++ = *ps;
     }
+
+    if (ep != 0)
+        TinyCLR_UsbClient_RxCommit(usbClientState, ep, count);
+}
+
+// Full size packets are a multiple of 4 bytes so they pack back to back in the Tx FIFO, several fit in one transfer.
+static uint32_t STM32F4_UsbDevice_GetTxMaxPackets(UsbClientState* usbClientState, uint32_t ep) {
+    auto maxPacketSize = usbClientState->maxEndpointsPacketSize[ep];
+
+    return (maxPacketSize & 3) == 0 ? (USB_TXnFIFO_SIZE * 4) / maxPacketSize : 1;
 }
 
 void STM32F4_UsbDevice_EndpointInInterrupt(OTG_TypeDef* OTG, UsbClientState* usbClientState, uint32_t ep) {
@@ -485,12 +502,27 @@ void STM32F4_UsbDevice_EndpointInInterrupt(OTG_TypeDef* OTG, UsbClientState* usb
             }
         }
         else if (usbClientState->queues[ep] != 0 && usbClientState->isTxQueue[ep]) { // Tx data endpoint
+            auto packets = TinyCLR_UsbClient_GetTxPacketCount(usbClientState, ep, STM32F4_UsbDevice_GetTxMaxPackets(usbClientState, ep), count);
+
+            if (packets > 0) {
+                // enable endpoint for the whole transfer, the FIFO holds all of it
+                OTG->DIEP[ep].TSIZ = (packets << OTG_DIEPTSIZ_PKTCNT_Pos) | count;
+                OTG->DIEP[ep].CTL |= OTG_DIEPCTL_EPENA | OTG_DIEPCTL_CNAK;
+
+                // write data, full size packets are a multiple of 4 bytes so they pack back to back
+                uint32_t volatile* pd = OTG->DFIFO[ep];
+
+                while (packets-- > 0) {
+                    uint32_t size;
 
-            USB_PACKET64* Packet64 = TinyCLR_UsbClient_TxDequeue(usbClientState, ep);
+                    ps = (uint32_t*)TinyCLR_UsbClient_TxDequeue(usbClientState, ep, size);
 
-            if (Packet64) {  // data to send
-                ps = (uint32_t*)Packet64->Buffer;
-                count = Packet64->Size;
+                    for (int32_t c = size; c > 0; c -= 4) {
+                        *pd = *ps++;
+                    }
+                }
+
+                return;
             }
         }
 
@@ -550,6 +582,20 @@ void STM32F4_UsbDevice_HandleSetup(OTG_TypeDef* OTG, UsbClientState* usbClientSt
     }
 }
 
+void STM32F4_UsbDevice_HandleControlOut(OTG_TypeDef* OTG, UsbClientState* usbClientState) {
+    uint8_t result = TinyCLR_UsbClient_ControlOutCallback(usbClientState);
+
+    if (result == USB_STATE_STALL) {
+        OTG->DIEP[0].CTL |= OTG_DIEPCTL_STALL;
+        OTG->DOEP[0].CTL |= OTG_DOEPCTL_STALL;
+
+        return;
+    }
+
+    // send the status stage once all data arrived
+    STM32F4_UsbDevice_EndpointInInterrupt(OTG, usbClientState, 0);
+}
+
 void STM32F4_UsbDevice_EndpointOutInterrupt(OTG_TypeDef* OTG, UsbClientState* usbClientState, uint32_t ep) {
     uint32_t bits = OTG->DOEP[ep].INT;
     if (bits & OTG_DOEPINT_XFRC) { // transfer completed
@@ -564,8 +610,15 @@ void STM32F4_UsbDevice_EndpointOutInterrupt(OTG_TypeDef* OTG, UsbClientState* us
         // enable endpoint
         OTG->DOEP[0].TSIZ = OTG_DOEPTSIZ_STUPCNT | OTG_DOEPTSIZ_PKTCNT_1 | usbClientState->maxEndpointsPacketSize[0];
         OTG->DOEP[0].CTL |= OTG_DOEPCTL_EPENA | OTG_DOEPCTL_CNAK;
-        // Handle Setup data in upper layer
-        STM32F4_UsbDevice_HandleSetup(OTG, usbClientState);
+        if (usbDeviceControllers[usbClientState->controllerIndex].controlOutData) {
+            usbDeviceControllers[usbClientState->controllerIndex].controlOutData = false;
+
+            STM32F4_UsbDevice_HandleControlOut(OTG, usbClientState);
+        }
+        else {
+            // Handle Setup data in upper layer
+            STM32F4_UsbDevice_HandleSetup(OTG, usbClientState);
+        }
     }
     else if (TinyCLR_UsbClient_CanReceivePackage(usbClientState, ep)) {
         // enable endpoint
@@ -599,7 +652,7 @@ void STM32F4_UsbDevice_Interrupt(void* param) {
         if (status == OTG_GRXSTSP_PKTSTS_PR // data received
             || status == OTG_GRXSTSP_PKTSTS_SR // setup received
             ) {
-            STM32F4_UsbDevice_EndpointRxInterrupt(OTG, usbClientState, ep, count);
+            STM32F4_UsbDevice_EndpointRxInterrupt(OTG, usbClientState, ep, count, status == OTG_GRXSTSP_PKTSTS_SR);
         }
         else {
             // others: nothing to do
@@ -773,6 +826,14 @@ uint64_t TinyCLR_UsbClient_Now() {
     return STM32F4_Time_GetSystemTime(nullptr);
 }
 
+// system time isn't native time, the wake up is as far from now in both
+void TinyCLR_UsbClient_ScheduleWakeup(uint64_t time) {
+    auto now = STM32F4_Time_GetSystemTime(nullptr);
+    auto ticks = STM32F4_Time_GetProcessorTicksForTime(nullptr, time > now ? time - now : 0);
+
+    STM32F4_Time_ScheduleWakeup(STM32F4_Time_GetCurrentProcessorTicks(nullptr) + ticks + 1);
+}
+
 void TinyCLR_UsbClient_InitializeConfiguration(UsbClientState *usbClientState) {
     STM32F4_UsbDevice_InitializeConfiguration(usbClientState);
 }
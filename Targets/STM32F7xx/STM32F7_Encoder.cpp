@@ -0,0 +1,326 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "STM32F7.h"
+#include "../../Drivers/DevicesInterop/Encoder/GHIElectronics_TinyCLR_Devices_Encoder_Quadrature.h"
+
+#if STM32F7_APB1_CLOCK_HZ == STM32F7_AHB_CLOCK_HZ
+#define ENCODER_APB1_TIMER_CLOCK_HZ (STM32F7_APB1_CLOCK_HZ)
+#else
+#define ENCODER_APB1_TIMER_CLOCK_HZ (STM32F7_APB1_CLOCK_HZ * 2)
+#endif
+
+#if STM32F7_APB2_CLOCK_HZ == STM32F7_AHB_CLOCK_HZ
+#define ENCODER_APB2_TIMER_CLOCK_HZ (STM32F7_APB2_CLOCK_HZ)
+#else
+#define ENCODER_APB2_TIMER_CLOCK_HZ (STM32F7_APB2_CLOCK_HZ * 2)
+#endif
+
+#define ENCODER_CHANNELS_PER_TIMER 4
+#define ENCODER_TOTAL_ENCODERS 6
+
+// Timers with an encoder mode, encoder n counts on timer encoderTimers[n]
+static const uint32_t encoderTimers[ENCODER_TOTAL_ENCODERS] = { 1, 2, 3, 4, 5, 8 };
+
+// Input filter length in timer clocks of each ICxF, from the fifth on in units of the CKD division
+static const uint32_t encoderFilterClocks[16] = { 0, 2, 4, 8, 12, 16, 24, 32, 48, 64, 80, 96, 128, 160, 192, 256 };
+
+#if defined(INCLUDE_PWM)
+static const STM32F7_Gpio_Pin encoderTimerPins[][ENCODER_CHANNELS_PER_TIMER] = STM32F7_PWM_PINS;
+#endif
+
+// CH1 and CH2 clock the counter in encoder mode 3. The update event of the wrap is compare point 0, CC3 and
+// CC4 compare on points 1 and 2 and have no pin.
+struct EncoderState {
+    bool isOpened;
+    bool useIndex;
+
+    TIM_TypeDef* timReg;
+    uint32_t timer;
+
+    uint32_t pins[3]; // PhA, PhB, index
+
+    TinyCLR_Encoder_Counter counter;
+};
+
+static EncoderState encoderStates[ENCODER_TOTAL_ENCODERS];
+
+static const TinyCLR_Encoder_ControllerApi encoderControllerApi = { &STM32F7_Encoder_GetEncoderCount, &STM32F7_Encoder_Open, &STM32F7_Encoder_Close, &STM32F7_Encoder_Read, &STM32F7_Encoder_SetPosition };
+
+void STM32F7_Encoder_AddApi(const TinyCLR_Api_Manager* apiManager) {
+    TinyCLR_Encoder_SetControllerApi(reinterpret_cast<const TinyCLR_Gpio_Controller*>(STM32F7_Gpio_GetRequiredApi()->Implementation), &encoderControllerApi);
+}
+
+static TIM_TypeDef* STM32F7_Encoder_GetTimer(uint32_t timer) {
+    switch (timer) {
+    case 1: return TIM1;
+    case 2: return TIM2;
+    case 3: return TIM3;
+    case 4: return TIM4;
+    case 5: return TIM5;
+    case 8: return TIM8;
+    }
+
+    return nullptr;
+}
+
+static void STM32F7_Encoder_GetIrqs(uint32_t timer, uint32_t& updateIrq, uint32_t& compareIrq) {
+    switch (timer) {
+    case 1: updateIrq = TIM1_UP_TIM10_IRQn; compareIrq = TIM1_CC_IRQn; break;
+    case 2: updateIrq = compareIrq = TIM2_IRQn; break;
+    case 3: updateIrq = compareIrq = TIM3_IRQn; break;
+    case 4: updateIrq = compareIrq = TIM4_IRQn; break;
+    case 5: updateIrq = compareIrq = TIM5_IRQn; break;
+    case 8: updateIrq = TIM8_UP_TIM13_IRQn; compareIrq = TIM8_CC_IRQn; break;
+    }
+}
+
+static __IO uint32_t* STM32F7_Encoder_GetClockEnable(TIM_TypeDef* treg, uint32_t& enBit) {
+    enBit = 1 << (((uint32_t)treg >> 10) & 0x1F);
+
+    return ((uint32_t)treg & 0x10000) ? &RCC->APB2ENR : &RCC->APB1ENR;
+}
+
+// Interrupt enables of the compare points in armed, bit n for point n
+static uint32_t STM32F7_Encoder_GetPointInterrupts(uint32_t armed) {
+    return ((armed & 1) ? TIM_DIER_UIE : 0) | ((armed & 2) ? TIM_DIER_CC3IE : 0) | ((armed & 4) ? TIM_DIER_CC4IE : 0);
+}
+
+// CKD in CR1 and ICxF of the longest filter within clocks timer clocks
+static void STM32F7_Encoder_GetFilter(uint64_t clocks, uint32_t& division, uint32_t& filter) {
+    uint32_t longest = 0;
+
+    division = 0;
+    filter = 0;
+
+    for (uint32_t d = 0; d < 3; d++) {
+        for (uint32_t f = 1; f < 16; f++) {
+            auto length = f < 4 ? encoderFilterClocks[f] : (encoderFilterClocks[f] << d);
+
+            if (length <= clocks && length > longest) {
+                longest = length;
+                division = d;
+                filter = f;
+            }
+        }
+    }
+}
+
+static void STM32F7_Encoder_Interrupt(void* param) {
+    auto& state = *reinterpret_cast<EncoderState*>(param);
+    auto treg = state.timReg;
+
+    // flags of disarmed points are stale, they are cleared with the others
+    treg->SR = ~(TIM_SR_UIF | TIM_SR_CC3IF | TIM_SR_CC4IF);
+
+    auto raw = treg->CNT;
+
+    TinyCLR_Encoder_Counter_Update(state.counter, raw);
+
+    treg->DIER = STM32F7_Encoder_GetPointInterrupts(TinyCLR_Encoder_Counter_GetArmedPoints(state.counter, raw));
+}
+
+// Called from the EXTI interrupt with interrupts disabled
+static void STM32F7_Encoder_IndexChanged(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinChangeEdge edge, uint64_t timestamp) {
+    for (auto i = 0; i < ENCODER_TOTAL_ENCODERS; i++) {
+        auto& state = encoderStates[i];
+
+        if (state.isOpened && state.useIndex && state.pins[2] == pin)
+            TinyCLR_Encoder_Counter_LatchIndex(state.counter, state.timReg->CNT, timestamp);
+    }
+}
+
+uint32_t STM32F7_Encoder_GetEncoderCount(const TinyCLR_Gpio_Controller* self) {
+    return ENCODER_TOTAL_ENCODERS;
+}
+
+TinyCLR_Result STM32F7_Encoder_Open(const TinyCLR_Gpio_Controller* self, uint32_t encoder, const TinyCLR_Encoder_Settings& settings) {
+#if defined(INCLUDE_PWM)
+    if (encoder >= ENCODER_TOTAL_ENCODERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = encoderStates[encoder];
+    auto timer = encoderTimers[encoder];
+    auto treg = STM32F7_Encoder_GetTimer(timer);
+
+    if (state.isOpened)
+        return TinyCLR_Result::SharingViolation;
+
+    if (treg == nullptr || timer > SIZEOF_ARRAY(encoderTimerPins) || encoderTimerPins[timer - 1][0].number == PIN_NONE || encoderTimerPins[timer - 1][1].number == PIN_NONE)
+        return TinyCLR_Result::NotSupported;
+
+#if defined(STM32F7_TIME_TIMER)
+    // the timer counts native time
+    if (timer == STM32F7_TIME_TIMER)
+        return TinyCLR_Result::NotSupported;
+#endif
+
+    uint32_t enBit;
+
+    auto enReg = STM32F7_Encoder_GetClockEnable(treg, enBit);
+
+    if (*enReg & enBit) // in use as PWM or by Signals
+        return TinyCLR_Result::SharingViolation;
+
+    const STM32F7_Gpio_Pin encoderPins[] = { encoderTimerPins[timer - 1][0], encoderTimerPins[timer - 1][1], { settings.IndexPin, STM32F7_Gpio_AlternateFunction::AF0 } }; // PhA, PhB, index
+
+    auto useIndex = settings.IndexPin != TINYCLR_ENCODER_NO_INDEX;
+
+    if (!STM32F7_GpioInternal_OpenMultiPins(encoderPins, useIndex ? 3 : 2))
+        return TinyCLR_Result::SharingViolation;
+
+    uint32_t clock = ((uint32_t)treg & 0x10000) ? ENCODER_APB2_TIMER_CLOCK_HZ : ENCODER_APB1_TIMER_CLOCK_HZ;
+    uint32_t division, filter;
+
+    STM32F7_Encoder_GetFilter(static_cast<uint64_t>(settings.FilterTime) * clock / 1000000000, division, filter);
+
+    state.timReg = treg;
+    state.timer = timer;
+    state.useIndex = useIndex;
+
+    for (auto i = 0; i < 3; i++)
+        state.pins[i] = encoderPins[i].number;
+
+    TinyCLR_Encoder_Counter_Initialize(state.counter, (timer == 2 || timer == 5) ? 0xFFFFFFFF : 0xFFFF);
+
+    // open collector encoders only pull their outputs low
+    for (auto i = 0; i < 2; i++)
+        STM32F7_GpioInternal_ConfigurePin(encoderTimerPins[timer - 1][i].number, STM32F7_Gpio_PortMode::AlternateFunction, STM32F7_Gpio_OutputType::PushPull, STM32F7_Gpio_OutputSpeed::VeryHigh, STM32F7_Gpio_PullDirection::PullUp, encoderTimerPins[timer - 1][i].alternateFunction);
+
+    *enReg |= enBit; // enable timer clock
+
+    treg->CR1 = TIM_CR1_URS | (division << 8); // only counter wraps raise the update interrupt
+    treg->SMCR = TIM_SMCR_SMS_1 | TIM_SMCR_SMS_0; // encoder mode 3, both inputs count on both edges
+    treg->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_CC2S_0 | (filter << 4) | (filter << 12); // IC1 on TI1, IC2 on TI2
+    treg->CCMR2 = 0; // CC3 and CC4 frozen compares
+    treg->CCER = settings.Reversed ? TIM_CCER_CC1P : 0; // inverting TI1 swaps the direction
+    treg->PSC = 0;
+    treg->ARR = state.counter.Mask;
+    treg->CCR3 = TinyCLR_Encoder_Counter_GetPoint(state.counter, 1);
+    treg->CCR4 = TinyCLR_Encoder_Counter_GetPoint(state.counter, 2);
+    treg->EGR = TIM_EGR_UG;
+    treg->CNT = 0;
+    treg->SR = 0;
+
+    uint32_t updateIrq, compareIrq;
+
+    STM32F7_Encoder_GetIrqs(timer, updateIrq, compareIrq);
+
+    state.isOpened = true;
+
+    // the TIM1 and TIM8 update vectors also serve TIM10 and TIM13, the handler goes next to the other users'
+    if (!STM32F7_InterruptInternal_AddShared(updateIrq, &STM32F7_Encoder_Interrupt, &state) || !STM32F7_InterruptInternal_AddShared(compareIrq, &STM32F7_Encoder_Interrupt, &state)) {
+        STM32F7_Encoder_Close(self, encoder);
+
+        return TinyCLR_Result::NotAvailable;
+    }
+
+    treg->DIER = STM32F7_Encoder_GetPointInterrupts(TinyCLR_Encoder_Counter_GetArmedPoints(state.counter, 0));
+    treg->CR1 |= TIM_CR1_CEN;
+
+    if (useIndex) {
+        STM32F7_GpioInternal_ConfigurePin(settings.IndexPin, STM32F7_Gpio_PortMode::Input, STM32F7_Gpio_OutputType::PushPull, STM32F7_Gpio_OutputSpeed::VeryHigh, STM32F7_Gpio_PullDirection::PullUp, STM32F7_Gpio_AlternateFunction::AF0);
+        STM32F7_Gpio_SetDebounceTimeout(self, settings.IndexPin, 0);
+
+        if (STM32F7_Gpio_SetPinChangedHandler(self, settings.IndexPin, TinyCLR_Gpio_PinChangeEdge::RisingEdge, &STM32F7_Encoder_IndexChanged) != TinyCLR_Result::Success) {
+            STM32F7_Encoder_Close(self, encoder);
+
+            return TinyCLR_Result::SharingViolation;
+        }
+    }
+
+    return TinyCLR_Result::Success;
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+TinyCLR_Result STM32F7_Encoder_Close(const TinyCLR_Gpio_Controller* self, uint32_t encoder) {
+    if (encoder >= ENCODER_TOTAL_ENCODERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = encoderStates[encoder];
+    auto treg = state.timReg;
+
+    if (!state.isOpened)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (state.useIndex)
+        STM32F7_Gpio_SetPinChangedHandler(self, state.pins[2], TinyCLR_Gpio_PinChangeEdge::RisingEdge, nullptr);
+
+    treg->CR1 = 0;
+    treg->DIER = 0;
+
+    uint32_t updateIrq, compareIrq;
+
+    STM32F7_Encoder_GetIrqs(state.timer, updateIrq, compareIrq);
+
+    STM32F7_InterruptInternal_RemoveShared(updateIrq, &STM32F7_Encoder_Interrupt, &state);
+    STM32F7_InterruptInternal_RemoveShared(compareIrq, &STM32F7_Encoder_Interrupt, &state);
+
+    treg->SMCR = 0;
+    treg->CCER = 0;
+    treg->CCMR1 = 0;
+    treg->CCMR2 = 0;
+    treg->SR = 0;
+
+    uint32_t enBit;
+
+    *STM32F7_Encoder_GetClockEnable(treg, enBit) &= ~enBit; // disable timer clock
+
+    for (auto i = 0; i < (state.useIndex ? 3 : 2); i++)
+        STM32F7_GpioInternal_ClosePin(state.pins[i]);
+
+    state.isOpened = false;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F7_Encoder_Read(const TinyCLR_Gpio_Controller* self, uint32_t encoder, TinyCLR_Encoder_Counter& counter, uint64_t& timestamp) {
+    if (encoder >= ENCODER_TOTAL_ENCODERS || !encoderStates[encoder].isOpened)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto& state = encoderStates[encoder];
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    counter = state.counter;
+
+    TinyCLR_Encoder_Counter_Update(counter, state.timReg->CNT);
+
+    timestamp = STM32F7_Time_GetSystemTime(nullptr);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F7_Encoder_SetPosition(const TinyCLR_Gpio_Controller* self, uint32_t encoder, int64_t position) {
+    if (encoder >= ENCODER_TOTAL_ENCODERS || !encoderStates[encoder].isOpened)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto& state = encoderStates[encoder];
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    TinyCLR_Encoder_Counter_SetPosition(state.counter, state.timReg->CNT, position);
+
+    return TinyCLR_Result::Success;
+}
+
+void STM32F7_Encoder_Reset() {
+    auto controller = reinterpret_cast<const TinyCLR_Gpio_Controller*>(STM32F7_Gpio_GetRequiredApi()->Implementation);
+
+    for (auto i = 0; i < ENCODER_TOTAL_ENCODERS; i++)
+        if (encoderStates[i].isOpened)
+            STM32F7_Encoder_Close(controller, i);
+}
@@ -15,11 +15,15 @@
 // limitations under the License.
 
 #include "STM32F7.h"
+#include "../../Drivers/InterruptProfiler/InterruptProfiler.h"
 
 #define DISABLED_MASK  0x00000001
 
 #define TOTAL_INTERRUPT_CONTROLLERS 1
 
+// Two for each timer with an update vector, an encoder adds its update and compare vectors
+#define INTERRUPT_SHARED_HANDLERS 24
+
 TinyCLR_Interrupt_StartStopHandler STM32F7_Interrupt_Started;
 TinyCLR_Interrupt_StartStopHandler STM32F7_Interrupt_Ended;
 
@@ -28,6 +32,12 @@ struct InterruptState {
     bool tableInitialized;
 };
 
+struct InterruptSharedHandler {
+    uint32_t index;
+    STM32F7_InterruptHandler handler;
+    void* param;
+};
+
 const char* interruptApiNames[TOTAL_INTERRUPT_CONTROLLERS] = {
     "GHIElectronics.TinyCLR.NativeApis.STM32F7.InterruptController\\0"
 };
@@ -35,6 +45,7 @@ const char* interruptApiNames[TOTAL_INTERRUPT_CONTROLLERS] = {
 static TinyCLR_Interrupt_Controller interruptControllers[TOTAL_INTERRUPT_CONTROLLERS];
 static TinyCLR_Api_Info interruptApi[TOTAL_INTERRUPT_CONTROLLERS];
 static InterruptState interruptStates[TOTAL_INTERRUPT_CONTROLLERS];
+static InterruptSharedHandler interruptSharedHandlers[INTERRUPT_SHARED_HANDLERS];
 
 void STM32F7_Interrupt_EnsureTableInitialized() {
     for (auto i = 0; i < TOTAL_INTERRUPT_CONTROLLERS; i++) {
@@ -109,6 +120,13 @@ TinyCLR_Result STM32F7_Interrupt_Initialize(const TinyCLR_Interrupt_Controller*
     STM32F7_Interrupt_Started = onInterruptStart;
     STM32F7_Interrupt_Ended = onInterruptEnd;
 
+#if defined(INTERRUPT_PROFILER)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55; // unlock the DWT
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
     return TinyCLR_Result::Success;
 }
 
@@ -138,18 +156,111 @@ bool STM32F7_InterruptInternal_Deactivate(uint32_t index) {
 
     return true;
 }
+
+static void STM32F7_Interrupt_SharedInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    uint32_t index = __get_IPSR() - 16; // exception = irq + 16
+
+    for (auto i = 0; i < INTERRUPT_SHARED_HANDLERS; i++)
+        if (interruptSharedHandlers[i].handler != nullptr && interruptSharedHandlers[i].index == index)
+            interruptSharedHandlers[i].handler(interruptSharedHandlers[i].param);
+}
+
+bool STM32F7_InterruptInternal_AddShared(uint32_t index, STM32F7_InterruptHandler handler, void* param) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    InterruptSharedHandler* free = nullptr;
+    auto active = false;
+
+    for (auto i = 0; i < INTERRUPT_SHARED_HANDLERS; i++) {
+        auto& entry = interruptSharedHandlers[i];
+
+        if (entry.handler == nullptr) {
+            if (free == nullptr)
+                free = &entry;
+        }
+        else if (entry.index == index) {
+            if (entry.handler == handler && entry.param == param)
+                return true;
+
+            active = true;
+        }
+    }
+
+    if (free == nullptr)
+        return false;
+
+    free->index = index;
+    free->param = param;
+    free->handler = handler;
+
+    // a pending request of the vector belongs to the handlers already added
+    if (!active)
+        STM32F7_InterruptInternal_Activate(index, (uint32_t*)&STM32F7_Interrupt_SharedInterrupt, nullptr);
+
+    return true;
+}
+
+bool STM32F7_InterruptInternal_RemoveShared(uint32_t index, STM32F7_InterruptHandler handler, void* param) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto removed = false;
+    auto active = false;
+
+    for (auto i = 0; i < INTERRUPT_SHARED_HANDLERS; i++) {
+        auto& entry = interruptSharedHandlers[i];
+
+        if (entry.handler == nullptr || entry.index != index)
+            continue;
+
+        if (entry.handler == handler && entry.param == param) {
+            entry.handler = nullptr;
+
+            removed = true;
+        }
+        else {
+            active = true;
+        }
+    }
+
+    if (removed && !active)
+        STM32F7_InterruptInternal_Deactivate(index);
+
+    return removed;
+}
+
+#if defined(INTERRUPT_PROFILER)
+uint32_t InterruptProfiler_ReadCounter() {
+    return DWT->CYCCNT;
+}
+#endif
+
+#if defined(INTERRUPT_PROFILER)
+STM32F7_InterruptStarted_RaiiHelper::STM32F7_InterruptStarted_RaiiHelper() { InterruptProfiler_Started(__get_IPSR()); STM32F7_Interrupt_Started(); };
+STM32F7_InterruptStarted_RaiiHelper::~STM32F7_InterruptStarted_RaiiHelper() { STM32F7_Interrupt_Ended(); InterruptProfiler_Ended(); };
+#else
 STM32F7_InterruptStarted_RaiiHelper::STM32F7_InterruptStarted_RaiiHelper() { STM32F7_Interrupt_Started(); };
 STM32F7_InterruptStarted_RaiiHelper::~STM32F7_InterruptStarted_RaiiHelper() { STM32F7_Interrupt_Ended(); };
+#endif
 
 STM32F7_DisableInterrupts_RaiiHelper::STM32F7_DisableInterrupts_RaiiHelper() {
     state = __get_PRIMASK();
 
     __disable_irq();
+
+#if defined(INTERRUPT_PROFILER)
+    if ((state & DISABLED_MASK) == 0)
+        InterruptProfiler_DisabledStarted();
+#endif
 }
 STM32F7_DisableInterrupts_RaiiHelper::~STM32F7_DisableInterrupts_RaiiHelper() {
     uint32_t Cp = state;
 
     if ((Cp & DISABLED_MASK) == 0) {
+#if defined(INTERRUPT_PROFILER)
+        InterruptProfiler_DisabledEnded();
+#endif
         __enable_irq();
     }
 }
@@ -165,6 +276,11 @@ void STM32F7_DisableInterrupts_RaiiHelper::Acquire() {
         state = __get_PRIMASK();
 
         __disable_irq();
+
+#if defined(INTERRUPT_PROFILER)
+        if ((state & DISABLED_MASK) == 0)
+            InterruptProfiler_DisabledStarted();
+#endif
     }
 }
 
@@ -173,6 +289,9 @@ void STM32F7_DisableInterrupts_RaiiHelper::Release() {
 
     if ((Cp & DISABLED_MASK) == 0) {
         state = __get_PRIMASK();
+#if defined(INTERRUPT_PROFILER)
+        InterruptProfiler_DisabledEnded();
+#endif
         __enable_irq();
     }
 }
@@ -185,22 +304,48 @@ bool STM32F7_Interrupt_IsDisabled() {
 }
 
 void STM32F7_Interrupt_Enable() {
+#if defined(INTERRUPT_PROFILER)
+    InterruptProfiler_DisabledEnded();
+#endif
     __enable_irq();
 }
 
 void STM32F7_Interrupt_Disable() {
+#if defined(INTERRUPT_PROFILER)
+    auto state = __get_PRIMASK();
+
+    __disable_irq();
+
+    if ((state & DISABLED_MASK) == 0)
+        InterruptProfiler_DisabledStarted();
+#else
     __disable_irq();
+#endif
 }
 
 
 void STM32F7_Interrupt_WaitForInterrupt() {
     register uint32_t state = __get_PRIMASK();
 
-    __enable_irq();
+#if defined(INTERRUPT_PROFILER)
+    // waiting is not time spent with interrupts disabled
+    if ((state & DISABLED_MASK) == DISABLED_MASK)
+        InterruptProfiler_DisabledEnded();
+#endif
 
-    // just to allow an interupt to an occur
+    // A pending interrupt wakes WFI with interrupts masked too, so one raised after the caller checked its flag with
+    // interrupts masked ends the sleep instead of running before it. It runs once interrupts are enabled.
+    __disable_irq();
     __WFI();
 
+    __enable_irq();
+    __ISB();
+
     // restore irq state
     __set_PRIMASK(state);
+
+#if defined(INTERRUPT_PROFILER)
+    if ((state & DISABLED_MASK) == DISABLED_MASK)
+        InterruptProfiler_DisabledStarted();
+#endif
 }
@@ -0,0 +1,435 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "STM32F7.h"
+#include "../../Drivers/DevicesInterop/Signals/GHIElectronics_TinyCLR_Devices_Signals_Capture.h"
+#include "../../Drivers/DevicesInterop/Signals/GHIElectronics_TinyCLR_Devices_Signals_Generator.h"
+
+#if STM32F7_APB1_CLOCK_HZ == STM32F7_AHB_CLOCK_HZ
+#define SIGNALS_APB1_TIMER_CLOCK_HZ (STM32F7_APB1_CLOCK_HZ)
+#else
+#define SIGNALS_APB1_TIMER_CLOCK_HZ (STM32F7_APB1_CLOCK_HZ * 2)
+#endif
+
+#if STM32F7_APB2_CLOCK_HZ == STM32F7_AHB_CLOCK_HZ
+#define SIGNALS_APB2_TIMER_CLOCK_HZ (STM32F7_APB2_CLOCK_HZ)
+#else
+#define SIGNALS_APB2_TIMER_CLOCK_HZ (STM32F7_APB2_CLOCK_HZ * 2)
+#endif
+
+#define SIGNALS_CHANNELS_PER_TIMER 4
+#define SIGNALS_DMA_TIMERS 8
+
+#if defined(INCLUDE_PWM)
+static const STM32F7_Gpio_Pin signalsTimerPins[][SIGNALS_CHANNELS_PER_TIMER] = STM32F7_PWM_PINS;
+#endif
+
+// Capture/compare DMA request of each timer channel as { controller, stream, channel }, no controller when there is none
+static const STM32F7_Dma_Request signalsChannelDma[SIGNALS_DMA_TIMERS][SIGNALS_CHANNELS_PER_TIMER] = {
+    /* TIM1 */ { { 2, 1, 6 }, { 2, 2, 6 }, { 2, 6, 6 }, { 2, 4, 6 } },
+    /* TIM2 */ { { 1, 5, 3 }, { 1, 6, 3 }, { 1, 1, 3 }, { 1, 7, 3 } },
+    /* TIM3 */ { { 1, 4, 5 }, { 1, 5, 5 }, { 1, 7, 5 }, { 1, 2, 5 } },
+    /* TIM4 */ { { 1, 0, 2 }, { 1, 3, 2 }, { 1, 7, 2 }, { 0, 0, 0 } },
+    /* TIM5 */ { { 1, 2, 6 }, { 1, 4, 6 }, { 1, 0, 6 }, { 1, 1, 6 } },
+    /* TIM6 */ { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } },
+    /* TIM7 */ { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } },
+    /* TIM8 */ { { 2, 2, 7 }, { 2, 3, 7 }, { 2, 4, 7 }, { 2, 7, 7 } },
+};
+
+// The stream's transfer complete interrupt reports the last edge
+struct SignalsCaptureState {
+    bool isActive;
+
+    const TinyCLR_Gpio_Controller* controller;
+    TIM_TypeDef* timReg;
+    STM32F7_Dma_Request dma;
+
+    uint32_t pin;
+    TinyCLR_Gpio_PinDriveMode driveMode;
+
+    uint32_t* timestamps;
+    size_t count;
+    TinyCLR_Signals_CaptureCompletedHandler completed;
+};
+
+// The channel toggles its output on each compare match while DMA reloads CCRx with the next edge,
+// the counter stops in one pulse mode at the last edge and the update interrupt ends the waveform
+struct SignalsGeneratorState {
+    bool isActive;
+
+    const TinyCLR_Gpio_Controller* controller;
+    TIM_TypeDef* timReg;
+    uint32_t timer;
+    STM32F7_Dma_Request dma;
+
+    uint32_t pin;
+    TinyCLR_Gpio_PinValue idleState;
+    TinyCLR_Gpio_PinDriveMode driveMode;
+
+    size_t count;
+    TinyCLR_Signals_GeneratorCompletedHandler completed;
+};
+
+static SignalsCaptureState signalsCaptureState;
+static SignalsGeneratorState signalsGeneratorState;
+
+static const TinyCLR_Signals_CaptureApi signalsCaptureApi = { &STM32F7_Signals_StartCapture, &STM32F7_Signals_GetCaptureCount, &STM32F7_Signals_StopCapture };
+static const TinyCLR_Signals_GeneratorApi signalsGeneratorApi = { &STM32F7_Signals_GetGeneratorTiming, &STM32F7_Signals_StartGenerator, &STM32F7_Signals_IsGeneratorActive };
+
+void STM32F7_Signals_AddApi(const TinyCLR_Api_Manager* apiManager) {
+    auto controller = reinterpret_cast<const TinyCLR_Gpio_Controller*>(STM32F7_Gpio_GetRequiredApi()->Implementation);
+
+    TinyCLR_Signals_SetCaptureApi(controller, &signalsCaptureApi);
+    TinyCLR_Signals_SetGeneratorApi(controller, &signalsGeneratorApi);
+}
+
+static TIM_TypeDef* STM32F7_Signals_GetTimer(uint32_t timer) {
+    switch (timer) {
+    case 1: return TIM1;
+    case 2: return TIM2;
+    case 3: return TIM3;
+    case 4: return TIM4;
+    case 5: return TIM5;
+    case 8: return TIM8;
+    }
+
+    return nullptr;
+}
+
+static uint32_t STM32F7_Signals_GetUpdateIrq(uint32_t timer) {
+    switch (timer) {
+    case 1: return TIM1_UP_TIM10_IRQn;
+    case 2: return TIM2_IRQn;
+    case 3: return TIM3_IRQn;
+    case 4: return TIM4_IRQn;
+    case 5: return TIM5_IRQn;
+    case 8: return TIM8_UP_TIM13_IRQn;
+    }
+
+    return 0;
+}
+
+static __IO uint32_t* STM32F7_Signals_GetClockEnable(TIM_TypeDef* treg, uint32_t& enBit) {
+    enBit = 1 << (((uint32_t)treg >> 10) & 0x1F);
+
+    return ((uint32_t)treg & 0x10000) ? &RCC->APB2ENR : &RCC->APB1ENR;
+}
+
+// First timer channel with a DMA request routed to pin whose timer is free
+static bool STM32F7_Signals_FindChannel(uint32_t pin, uint32_t& timer, uint32_t& channel) {
+#if defined(INCLUDE_PWM)
+    auto timers = sizeof(signalsTimerPins) / sizeof(signalsTimerPins[0]);
+
+    for (auto t = 0; t < timers && t < SIGNALS_DMA_TIMERS; t++) {
+        for (auto c = 0; c < SIGNALS_CHANNELS_PER_TIMER; c++) {
+            if (signalsTimerPins[t][c].number != pin)
+                continue;
+
+            auto treg = STM32F7_Signals_GetTimer(t + 1);
+
+#if defined(STM32F7_TIME_TIMER)
+            // the timer counts native time
+            if (t + 1 == STM32F7_TIME_TIMER)
+                continue;
+#endif
+
+            if (treg == nullptr || signalsChannelDma[t][c].controller == 0)
+                continue;
+
+            uint32_t enBit;
+
+            if (*STM32F7_Signals_GetClockEnable(treg, enBit) & enBit) // in use as PWM
+                continue;
+
+            timer = t + 1;
+            channel = c;
+
+            return true;
+        }
+    }
+#endif
+
+    return false;
+}
+
+static uint32_t STM32F7_Signals_GetTimerClock(TIM_TypeDef* treg) {
+    return ((uint32_t)treg & 0x10000) ? SIGNALS_APB2_TIMER_CLOCK_HZ : SIGNALS_APB1_TIMER_CLOCK_HZ;
+}
+
+static uint32_t STM32F7_Signals_GetCounterBits(uint32_t timer) {
+    return (timer == 2 || timer == 5) ? 32 : 16;
+}
+
+static void STM32F7_Signals_ConfigureChannel(uint32_t pin, uint32_t timer, uint32_t channel, STM32F7_Gpio_PullDirection pull) {
+#if defined(INCLUDE_PWM)
+    STM32F7_GpioInternal_ConfigurePin(pin, STM32F7_Gpio_PortMode::AlternateFunction, STM32F7_Gpio_OutputType::PushPull, STM32F7_Gpio_OutputSpeed::VeryHigh, pull, signalsTimerPins[timer - 1][channel].alternateFunction);
+#endif
+}
+
+static void STM32F7_Signals_ReleaseTimer(TIM_TypeDef* treg) {
+    treg->CCER = 0;
+    treg->CCMR1 = 0;
+    treg->CCMR2 = 0;
+
+    uint32_t enBit;
+
+    *STM32F7_Signals_GetClockEnable(treg, enBit) &= ~enBit; // disable timer clock
+}
+
+static void STM32F7_Signals_CaptureInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& state = signalsCaptureState;
+
+    if (!state.isActive || !(STM32F7_DmaInternal_ReadAndClearFlags(state.dma) & DMA_LISR_TCIF0))
+        return;
+
+    // every edge is stored, the channel stops asking for transfers until StopCapture
+    state.timReg->DIER = 0;
+
+    if (state.completed != nullptr)
+        state.completed(state.controller, state.pin, STM32F7_Time_GetSystemTime(nullptr));
+}
+
+TinyCLR_Result STM32F7_Signals_StartCapture(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t timeout, uint32_t* timestamps, size_t count, uint64_t& frequency, TinyCLR_Signals_CaptureCompletedHandler completed) {
+    uint32_t timer, channel;
+
+    // NDTR counts 16 bits, longer captures are left to the polling loop
+    if (signalsCaptureState.isActive || count == 0 || count > 0xFFFF || !STM32F7_Signals_FindChannel(pin, timer, channel))
+        return TinyCLR_Result::NotSupported;
+
+    auto treg = STM32F7_Signals_GetTimer(timer);
+    auto& dma = signalsChannelDma[timer - 1][channel];
+
+    uint32_t clock = STM32F7_Signals_GetTimerClock(treg);
+    uint32_t bits = STM32F7_Signals_GetCounterBits(timer);
+
+    auto divider = TinyCLR_Signals_GetCaptureDivider(timeout, clock, bits);
+
+    if (divider == 0 || divider > 0x10000 || !STM32F7_DmaInternal_Acquire(dma))
+        return TinyCLR_Result::NotSupported;
+
+    signalsCaptureState.controller = self;
+    signalsCaptureState.timReg = treg;
+    signalsCaptureState.dma = dma;
+    signalsCaptureState.pin = pin;
+    signalsCaptureState.driveMode = STM32F7_Gpio_GetDriveMode(self, pin);
+    signalsCaptureState.count = count;
+    signalsCaptureState.completed = completed;
+    signalsCaptureState.isActive = true;
+
+    auto pull = STM32F7_Gpio_PullDirection::None;
+
+    if (signalsCaptureState.driveMode == TinyCLR_Gpio_PinDriveMode::InputPullUp)
+        pull = STM32F7_Gpio_PullDirection::PullUp;
+    else if (signalsCaptureState.driveMode == TinyCLR_Gpio_PinDriveMode::InputPullDown)
+        pull = STM32F7_Gpio_PullDirection::PullDown;
+
+    STM32F7_Signals_ConfigureChannel(pin, timer, channel, pull);
+
+    uint32_t enBit;
+
+    *STM32F7_Signals_GetClockEnable(treg, enBit) |= enBit; // enable timer clock
+
+    treg->CR1 = 0;
+    treg->PSC = divider - 1;
+    treg->ARR = bits == 32 ? 0xFFFFFFFF : 0xFFFF;
+
+    // CCxS = 01, the channel captures its own input on both edges
+    uint32_t mode = TIM_CCMR1_CC1S_0;
+    if (channel & 1) mode <<= 8; // 1 or 3
+    __IO uint32_t* reg = &treg->CCMR1;
+    if (channel & 2) reg = &treg->CCMR2; // 2 or 3
+    *reg = mode;
+
+    treg->CCER = (TIM_CCER_CC1E | TIM_CCER_CC1P | TIM_CCER_CC1NP) << (4 * channel);
+    treg->EGR = TIM_EGR_UG; // load the prescaler
+    treg->SR = 0;
+    treg->CNT = 0;
+
+    signalsCaptureState.timestamps = timestamps;
+
+    // the data cache mustn't write stale lines over the buffer while the stream fills it
+    SCB_CleanInvalidateDCache_by_Addr(timestamps, count * sizeof(uint32_t));
+
+    STM32F7_InterruptInternal_Activate(STM32F7_DmaInternal_GetInterrupt(dma), (uint32_t*)&STM32F7_Signals_CaptureInterrupt, 0);
+
+    STM32F7_DmaInternal_Start(dma, (uint32_t)(&treg->CCR1 + channel), (uint32_t)timestamps, count, DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_TCIE);
+
+    treg->DIER = TIM_DIER_CC1DE << channel;
+    treg->CR1 = TIM_CR1_CEN;
+
+    frequency = clock / divider;
+
+    return TinyCLR_Result::Success;
+}
+
+size_t STM32F7_Signals_GetCaptureCount(const TinyCLR_Gpio_Controller* self) {
+    if (!signalsCaptureState.isActive)
+        return 0;
+
+    return signalsCaptureState.count - STM32F7_DmaInternal_GetRemaining(signalsCaptureState.dma);
+}
+
+size_t STM32F7_Signals_StopCapture(const TinyCLR_Gpio_Controller* self) {
+    if (!signalsCaptureState.isActive)
+        return 0;
+
+    auto treg = signalsCaptureState.timReg;
+
+    treg->CR1 = 0;
+    treg->DIER = 0;
+
+    auto count = STM32F7_Signals_GetCaptureCount(self);
+
+    STM32F7_InterruptInternal_Deactivate(STM32F7_DmaInternal_GetInterrupt(signalsCaptureState.dma));
+    STM32F7_DmaInternal_Release(signalsCaptureState.dma);
+
+    SCB_InvalidateDCache_by_Addr(signalsCaptureState.timestamps, signalsCaptureState.count * sizeof(uint32_t));
+
+    STM32F7_Signals_ReleaseTimer(treg);
+
+    STM32F7_Gpio_SetDriveMode(self, signalsCaptureState.pin, signalsCaptureState.driveMode);
+
+    signalsCaptureState.isActive = false;
+
+    return count;
+}
+
+TinyCLR_Result STM32F7_Signals_GetGeneratorTiming(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint32_t& clock, uint32_t& counterBits) {
+    uint32_t timer, channel;
+
+    if (signalsGeneratorState.isActive || !STM32F7_Signals_FindChannel(pin, timer, channel))
+        return TinyCLR_Result::NotSupported;
+
+    clock = STM32F7_Signals_GetTimerClock(STM32F7_Signals_GetTimer(timer));
+    counterBits = STM32F7_Signals_GetCounterBits(timer);
+
+    return TinyCLR_Result::Success;
+}
+
+static void STM32F7_Signals_GeneratorInterrupt(void* param) {
+    auto& state = signalsGeneratorState;
+    auto treg = state.timReg;
+
+    if (!state.isActive || !(treg->SR & TIM_SR_UIF))
+        return;
+
+    treg->SR = 0;
+    treg->DIER = 0;
+    treg->CR1 = 0;
+
+    if (state.count > 1)
+        STM32F7_DmaInternal_Release(state.dma);
+
+    STM32F7_InterruptInternal_RemoveShared(STM32F7_Signals_GetUpdateIrq(state.timer), &STM32F7_Signals_GeneratorInterrupt, nullptr);
+
+    // back to GPIO at idle before the channel lets go of the pin
+    STM32F7_Gpio_Write(state.controller, state.pin, state.idleState);
+    STM32F7_Gpio_SetDriveMode(state.controller, state.pin, state.driveMode);
+
+    STM32F7_Signals_ReleaseTimer(treg);
+
+    state.isActive = false;
+
+    if (state.completed != nullptr)
+        state.completed(state.controller, state.pin, STM32F7_Time_GetSystemTime(nullptr));
+}
+
+TinyCLR_Result STM32F7_Signals_StartGenerator(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinValue idleState, uint32_t divider, const uint32_t* edges, size_t count, TinyCLR_Signals_GeneratorCompletedHandler completed) {
+    uint32_t timer, channel;
+
+    // the first edge is loaded directly, NDTR counts the other ones in 16 bits; longer waveforms are left to the loop
+    if (signalsGeneratorState.isActive || count == 0 || count - 1 > 0xFFFF || divider == 0 || divider > 0x10000 || !STM32F7_Signals_FindChannel(pin, timer, channel))
+        return TinyCLR_Result::NotSupported;
+
+    auto treg = STM32F7_Signals_GetTimer(timer);
+    auto& dma = signalsChannelDma[timer - 1][channel];
+
+    if (count > 1 && !STM32F7_DmaInternal_Acquire(dma))
+        return TinyCLR_Result::NotSupported;
+
+    auto& state = signalsGeneratorState;
+
+    state.controller = self;
+    state.timReg = treg;
+    state.timer = timer;
+    state.dma = dma;
+    state.pin = pin;
+    state.idleState = idleState;
+    state.driveMode = STM32F7_Gpio_GetDriveMode(self, pin);
+    state.count = count;
+    state.completed = completed;
+    state.isActive = true;
+
+    uint32_t enBit;
+
+    *STM32F7_Signals_GetClockEnable(treg, enBit) |= enBit; // enable timer clock
+
+    treg->CR1 = TIM_CR1_URS; // only the counter stopping raises the update interrupt
+    treg->PSC = divider - 1;
+    treg->ARR = edges[count - 1];
+    (&treg->CCR1)[channel] = edges[0];
+
+    if (timer == 1 || timer == 8)
+        treg->BDTR |= TIM_BDTR_MOE; // main output enable (timer 1 & 8 only)
+
+    // force the reference to idle, then toggle it on every match from there
+    uint32_t force = idleState == TinyCLR_Gpio_PinValue::High ? (TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_0) : TIM_CCMR1_OC1M_2;
+    uint32_t toggle = TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1M_0;
+    if (channel & 1) { force <<= 8; toggle <<= 8; } // 1 or 3
+    __IO uint32_t* reg = &treg->CCMR1;
+    if (channel & 2) reg = &treg->CCMR2; // 2 or 3
+
+    *reg = force;
+    treg->CCER = TIM_CCER_CC1E << (4 * channel);
+
+    STM32F7_Signals_ConfigureChannel(pin, timer, channel, STM32F7_Gpio_PullDirection::None);
+
+    *reg = toggle;
+
+    treg->EGR = TIM_EGR_UG; // load the prescaler
+    treg->SR = 0;
+
+    // the update vector of TIM1 and TIM8 also serves TIM9 to TIM14, the handler goes next to theirs
+    if (!STM32F7_InterruptInternal_AddShared(STM32F7_Signals_GetUpdateIrq(timer), &STM32F7_Signals_GeneratorInterrupt, nullptr)) {
+        if (count > 1)
+            STM32F7_DmaInternal_Release(dma);
+
+        STM32F7_Gpio_Write(self, pin, idleState);
+        STM32F7_Gpio_SetDriveMode(self, pin, state.driveMode);
+
+        STM32F7_Signals_ReleaseTimer(treg);
+
+        state.isActive = false;
+
+        return TinyCLR_Result::NotSupported;
+    }
+
+    if (count > 1) {
+        // the stream reads memory, the edges must be out of the data cache first
+        SCB_CleanDCache_by_Addr(const_cast<uint32_t*>(edges), count * sizeof(uint32_t));
+
+        STM32F7_DmaInternal_Start(dma, (uint32_t)(&treg->CCR1 + channel), (uint32_t)(edges + 1), count - 1, DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_DIR_0);
+    }
+
+    treg->DIER = TIM_DIER_UIE | (count > 1 ? (TIM_DIER_CC1DE << channel) : 0);
+    treg->CR1 = TIM_CR1_URS | TIM_CR1_OPM | TIM_CR1_CEN;
+
+    return TinyCLR_Result::Success;
+}
+
+bool STM32F7_Signals_IsGeneratorActive(const TinyCLR_Gpio_Controller* self) {
+    return signalsGeneratorState.isActive;
+}
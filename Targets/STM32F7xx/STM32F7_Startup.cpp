@@ -30,6 +30,9 @@ void STM32F7_Startup_OnSoftReset(const TinyCLR_Api_Manager* apiManager, const Ti
 #ifdef INCLUDE_DISPLAY
     STM32F7_Display_Reset();
 #endif
+#ifdef INCLUDE_ENCODER
+    STM32F7_Encoder_Reset();
+#endif
 #ifdef INCLUDE_GPIO
     STM32F7_Gpio_Reset();
 #endif
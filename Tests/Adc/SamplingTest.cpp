@@ -0,0 +1,127 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "../Host/Host.h"
+#include "../../Drivers/DevicesInterop/Adc/GHIElectronics_TinyCLR_Devices_Adc_Sampling.h"
+
+static TinyCLR_Adc_SamplingPolicy Policy(uint32_t count, TinyCLR_Adc_SamplingFilter filter) {
+    TinyCLR_Adc_SamplingPolicy policy = { 0, count, filter };
+
+    return policy;
+}
+
+static double Distance(double a, double b) {
+    return a > b ? a - b : b - a;
+}
+
+// One extra bit per factor of four samples, and only when decimating
+static void TestExtraBits() {
+    static const uint32_t expected[] = { 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2 };
+
+    for (uint32_t count = 1; count <= 16; count++)
+        HOST_CHECK(TinyCLR_Adc_GetSamplingExtraBits(Policy(count, TinyCLR_Adc_SamplingFilter::Decimate)) == expected[count - 1]);
+
+    HOST_CHECK(TinyCLR_Adc_GetSamplingExtraBits(Policy(63, TinyCLR_Adc_SamplingFilter::Decimate)) == 2);
+    HOST_CHECK(TinyCLR_Adc_GetSamplingExtraBits(Policy(64, TinyCLR_Adc_SamplingFilter::Decimate)) == 3);
+    HOST_CHECK(TinyCLR_Adc_GetSamplingExtraBits(Policy(256, TinyCLR_Adc_SamplingFilter::Decimate)) == 4);
+    HOST_CHECK(TinyCLR_Adc_GetSamplingExtraBits(Policy(256, TinyCLR_Adc_SamplingFilter::Mean)) == 0);
+    HOST_CHECK(TinyCLR_Adc_GetSamplingExtraBits(Policy(256, TinyCLR_Adc_SamplingFilter::Median)) == 0);
+}
+
+static void TestValid() {
+    HOST_CHECK(!TinyCLR_Adc_IsSamplingValid(Policy(0, TinyCLR_Adc_SamplingFilter::Mean)));
+    HOST_CHECK(!TinyCLR_Adc_IsSamplingValid(Policy(TINYCLR_ADC_SAMPLING_MAX_COUNT + 1, TinyCLR_Adc_SamplingFilter::Mean)));
+    HOST_CHECK(TinyCLR_Adc_IsSamplingValid(Policy(TINYCLR_ADC_SAMPLING_MAX_COUNT, TinyCLR_Adc_SamplingFilter::Decimate)));
+    HOST_CHECK(!TinyCLR_Adc_IsSamplingValid(Policy(1, static_cast<TinyCLR_Adc_SamplingFilter>(3))));
+}
+
+// Every filter against a double reference on random 12 bit samples
+static void TestFilters() {
+    srand(1);
+
+    for (auto t = 0; t < 20000; t++) {
+        size_t count = 1 + rand() % TINYCLR_ADC_SAMPLING_MAX_COUNT;
+        std::vector<uint16_t> samples(count);
+
+        for (auto& sample : samples)
+            sample = rand() % 4096;
+
+        double mean = 0;
+
+        for (auto sample : samples)
+            mean += sample;
+
+        mean /= count;
+
+        auto policy = Policy(count, TinyCLR_Adc_SamplingFilter::Mean);
+        auto work = samples;
+
+        HOST_CHECK(Distance(TinyCLR_Adc_FilterSamples(policy, work.data(), count), mean) <= 0.5 + 1e-9);
+
+        policy.Filter = TinyCLR_Adc_SamplingFilter::Decimate;
+        work = samples;
+
+        auto decimated = TinyCLR_Adc_FilterSamples(policy, work.data(), count);
+        auto scale = 1 << TinyCLR_Adc_GetSamplingExtraBits(policy);
+
+        HOST_CHECK(Distance(decimated, mean * scale) <= 0.5 + 1e-9);
+        HOST_CHECK(decimated < 4096 * scale);
+
+        policy.Filter = TinyCLR_Adc_SamplingFilter::Median;
+        work = samples;
+
+        auto median = TinyCLR_Adc_FilterSamples(policy, work.data(), count);
+        auto sorted = samples;
+
+        std::sort(sorted.begin(), sorted.end());
+
+        auto expected = (count & 1) ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2.0;
+
+        HOST_CHECK(std::is_sorted(work.begin(), work.end()));
+        HOST_CHECK(Distance(median, expected) <= 0.5);
+    }
+
+    // full scale decimates to exactly the extra bits
+    std::vector<uint16_t> full(256, 4095);
+
+    HOST_CHECK(TinyCLR_Adc_FilterSamples(Policy(256, TinyCLR_Adc_SamplingFilter::Decimate), full.data(), 256) == 4095 * 16);
+}
+
+static void TestRegistry() {
+    static const TinyCLR_Adc_SamplingApi samplingApi = { nullptr, nullptr };
+
+    TinyCLR_Adc_Controller controllers[TINYCLR_ADC_SAMPLING_API_MAX_CONTROLLERS + 1];
+
+    HOST_CHECK(TinyCLR_Adc_GetSamplingApi(&controllers[0]) == nullptr);
+
+    for (auto i = 0; i < TINYCLR_ADC_SAMPLING_API_MAX_CONTROLLERS; i++)
+        HOST_CHECK(TinyCLR_Adc_SetSamplingApi(&controllers[i], &samplingApi));
+
+    HOST_CHECK(TinyCLR_Adc_SetSamplingApi(&controllers[0], &samplingApi));
+    HOST_CHECK(!TinyCLR_Adc_SetSamplingApi(&controllers[TINYCLR_ADC_SAMPLING_API_MAX_CONTROLLERS], &samplingApi));
+    HOST_CHECK(TinyCLR_Adc_GetSamplingApi(&controllers[1]) == &samplingApi);
+}
+
+int main() {
+    TestExtraBits();
+    TestValid();
+    TestFilters();
+    TestRegistry();
+
+    return Host_Finish("Adc/SamplingTest");
+}
@@ -0,0 +1,300 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <vector>
+
+#include "../Host/Host.h"
+#include "../../Drivers/DevicesInterop/Adc/GHIElectronics_TinyCLR_Devices_Adc_Stream.h"
+
+// A stream backend playing the DMA: it writes sets into the ring one sample at a time and, like the half-transfer
+// and transfer-complete interrupts, moves written on only when a half is full.
+static TinyCLR_Adc_Controller controller;
+static TinyCLR_Adc_Controller otherController;
+
+static uint16_t* ring;
+static size_t ringLength;
+static size_t ringChannels;
+static uint64_t produced;
+static uint64_t written;
+static TinyCLR_Adc_StreamHandler ringHandler;
+static bool running;
+
+// Produces this many samples when the reader asks for written the second time, after its copy.
+static size_t racing;
+
+// Sample value at a stream position, 12 bits and different for every channel.
+static uint16_t Sample(uint64_t position) {
+    return static_cast<uint16_t>((position * 2654435761u >> 7) & 0xFFF);
+}
+
+static void Produce(size_t samples) {
+    for (size_t i = 0; i < samples; i++, produced++) {
+        ring[produced % ringLength] = Sample(produced);
+
+        if ((produced + 1) % (ringLength / 2) == 0)
+            written = produced + 1;
+    }
+}
+
+static TinyCLR_Result Stream_Start(const TinyCLR_Adc_Controller* self, const uint32_t* channels, size_t channelCount, uint32_t frequency, uint16_t* buffer, size_t length, TinyCLR_Adc_StreamHandler handler) {
+    ring = buffer;
+    ringLength = length;
+    ringChannels = channelCount;
+    ringHandler = handler;
+    produced = 0;
+    written = 0;
+    running = true;
+
+    return TinyCLR_Result::Success;
+}
+
+static uint64_t Stream_GetWritten(const TinyCLR_Adc_Controller* self) {
+    static bool copied = false;
+
+    if (racing > 0 && (copied = !copied) == false) {
+        Produce(racing);
+
+        racing = 0;
+    }
+
+    return written;
+}
+
+static TinyCLR_Result Stream_Stop(const TinyCLR_Adc_Controller* self) {
+    running = false;
+
+    return TinyCLR_Result::Success;
+}
+
+static const TinyCLR_Adc_StreamApi streamApi = { &Stream_Start, &Stream_GetWritten, &Stream_Stop };
+static const uint32_t channels[] = { 4, 0, 7, 1, 3, 2, 6, 5 };
+
+static void Handler(const TinyCLR_Adc_Controller* self, uint64_t written, uint64_t timestamp) {
+}
+
+// The rounded mean of the decimation sets from set on, for a channel
+static int32_t Expected(uint64_t set, size_t channelCount, size_t channel, uint32_t decimation) {
+    uint32_t sum = 0;
+
+    for (uint32_t d = 0; d < decimation; d++)
+        sum += Sample((set + d) * channelCount + channel);
+
+    return static_cast<int32_t>((sum + decimation / 2) / decimation);
+}
+
+// Start and stop check their arguments and state, the handler of the native caller reaches the backend as given.
+static void TestStartStop() {
+    size_t read;
+    bool overrun;
+    int32_t values[8];
+
+    HOST_CHECK(TinyCLR_Adc_StartStream(&otherController, channels, 1, 1000, 16, nullptr) == TinyCLR_Result::NotSupported);
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, nullptr, 1, 1000, 16, nullptr) == TinyCLR_Result::ArgumentNull);
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, 0, 1000, 16, nullptr) == TinyCLR_Result::ArgumentOutOfRange);
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, TINYCLR_ADC_STREAM_MAX_CHANNELS + 1, 1000, 16, nullptr) == TinyCLR_Result::ArgumentOutOfRange);
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, 1, 1000, 0, nullptr) == TinyCLR_Result::ArgumentOutOfRange);
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, 1, 0, 16, nullptr) == TinyCLR_Result::ArgumentOutOfRange);
+    HOST_CHECK(TinyCLR_Adc_ReadStream(&controller, 1, values, 1, read, overrun) == TinyCLR_Result::InvalidOperation);
+    HOST_CHECK(TinyCLR_Adc_StopStream(&controller) == TinyCLR_Result::InvalidOperation);
+
+    Host_SetAllocationEnabled(false);
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, 1, 1000, 16, nullptr) == TinyCLR_Result::OutOfMemory);
+    HOST_CHECK(!running);
+    Host_SetAllocationEnabled(true);
+
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, 3, 1000, 16, &Handler) == TinyCLR_Result::Success);
+    HOST_CHECK(running && ringHandler == &Handler && ringLength == 2 * 16 * 3 && ringChannels == 3);
+    HOST_CHECK(reinterpret_cast<size_t>(ring) % 32 == 0);
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, 3, 1000, 16, nullptr) == TinyCLR_Result::InvalidOperation);
+    HOST_CHECK(TinyCLR_Adc_ReadStream(&controller, 1, nullptr, 1, read, overrun) == TinyCLR_Result::ArgumentNull);
+    HOST_CHECK(TinyCLR_Adc_StopStream(&controller) == TinyCLR_Result::Success);
+    HOST_CHECK(!running);
+
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, 1, 1000, 16, nullptr) == TinyCLR_Result::Success);
+    HOST_CHECK(ringHandler == nullptr);
+    HOST_CHECK(TinyCLR_Adc_StopStream(&controller) == TinyCLR_Result::Success);
+}
+
+// A reader keeping up gets every set exactly once and in order across many wraps of the ring, whatever the sizes of
+// its reads and however the halves arrive in between.
+static void TestRead() {
+    for (auto t = 0; t < 2000; t++) {
+        auto channelCount = 1 + static_cast<size_t>(rand()) % 8;
+        auto setsPerHalf = 1 + static_cast<size_t>(rand()) % 40;
+        auto decimation = 1 + static_cast<uint32_t>(rand()) % 6;
+        auto half = setsPerHalf * channelCount;
+
+        while (setsPerHalf % decimation != 0)
+            decimation--;
+
+        HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, channelCount, 1000, setsPerHalf, nullptr) == TinyCLR_Result::Success);
+
+        uint64_t set = 0;
+        std::vector<int32_t> values(64 * TINYCLR_ADC_STREAM_MAX_CHANNELS);
+
+        for (auto i = 0; i < 200; i++) {
+            // at most one more half since the reader last caught up
+            Produce(static_cast<size_t>(rand()) % (half + 1));
+
+            size_t read;
+
+            do {
+                bool overrun;
+                auto sets = 1 + static_cast<size_t>(rand()) % 64;
+                auto available = (written / channelCount - set) / decimation;
+
+                HOST_CHECK(TinyCLR_Adc_ReadStream(&controller, decimation, values.data(), sets, read, overrun) == TinyCLR_Result::Success);
+                HOST_CHECK(!overrun);
+                HOST_CHECK(read == (available < sets ? available : sets));
+
+                for (size_t s = 0; s < read; s++, set += decimation)
+                    for (size_t c = 0; c < channelCount; c++)
+                        HOST_CHECK(values[s * channelCount + c] == Expected(set, channelCount, c, decimation));
+            } while (read > 0);
+
+            HOST_CHECK(set * channelCount == written);
+        }
+
+        HOST_CHECK(TinyCLR_Adc_StopStream(&controller) == TinyCLR_Result::Success);
+    }
+}
+
+// A decimation that doesn't divide a half leaves a partial group for the next read rather than averaging it early,
+// but the hardware rewrites it with the next half: that read reports the overrun and starts on the stable half.
+static void TestPartialGroup() {
+    int32_t values[4];
+    size_t read;
+    bool overrun;
+
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, 1, 1000, 5, nullptr) == TinyCLR_Result::Success);
+
+    Produce(5);
+
+    HOST_CHECK(TinyCLR_Adc_ReadStream(&controller, 3, values, 4, read, overrun) == TinyCLR_Result::Success);
+    HOST_CHECK(read == 1 && !overrun && values[0] == Expected(0, 1, 0, 3));
+
+    Produce(5);
+
+    HOST_CHECK(TinyCLR_Adc_ReadStream(&controller, 3, values, 4, read, overrun) == TinyCLR_Result::Success);
+    HOST_CHECK(read == 1 && overrun && values[0] == Expected(5, 1, 0, 3));
+    HOST_CHECK(TinyCLR_Adc_StopStream(&controller) == TinyCLR_Result::Success);
+}
+
+// Averages round to nearest, the largest 12 bit sums don't overflow.
+static void TestDecimation() {
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, 2, 1000, 4, nullptr) == TinyCLR_Result::Success);
+
+    const uint16_t samples[] = { 1, 0xFFF, 2, 0xFFF, 2, 0xFFE, 2, 0xFFF };
+
+    for (auto sample : samples)
+        ring[produced++ % ringLength] = sample;
+
+    written = produced;
+
+    size_t read;
+    bool overrun;
+    int32_t values[2];
+
+    HOST_CHECK(TinyCLR_Adc_ReadStream(&controller, 4, values, 1, read, overrun) == TinyCLR_Result::Success);
+    HOST_CHECK(read == 1 && !overrun);
+    HOST_CHECK(values[0] == 2 && values[1] == 0xFFF);
+
+    // decimation 0 reads like 1
+    HOST_CHECK(TinyCLR_Adc_StopStream(&controller) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, 2, 1000, 4, nullptr) == TinyCLR_Result::Success);
+
+    Produce(8);
+
+    HOST_CHECK(TinyCLR_Adc_ReadStream(&controller, 0, values, 1, read, overrun) == TinyCLR_Result::Success);
+    HOST_CHECK(read == 1 && values[0] == Sample(0) && values[1] == Sample(1));
+    HOST_CHECK(TinyCLR_Adc_StopStream(&controller) == TinyCLR_Result::Success);
+}
+
+// A reader more than a half behind lost samples: the read says so and goes on from the half the hardware finished
+// last, which the next halves don't touch until the one after.
+static void TestOverrun() {
+    for (auto t = 0; t < 1000; t++) {
+        auto channelCount = 1 + static_cast<size_t>(rand()) % 8;
+        auto setsPerHalf = 1 + static_cast<size_t>(rand()) % 40;
+        auto half = setsPerHalf * channelCount;
+
+        HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, channelCount, 1000, setsPerHalf, nullptr) == TinyCLR_Result::Success);
+
+        Produce(half * (2 + rand() % 10) + static_cast<size_t>(rand()) % half);
+
+        std::vector<int32_t> values(2 * half);
+        size_t read;
+        bool overrun;
+
+        HOST_CHECK(TinyCLR_Adc_ReadStream(&controller, 1, values.data(), 2 * setsPerHalf, read, overrun) == TinyCLR_Result::Success);
+        HOST_CHECK(overrun);
+        HOST_CHECK(read == setsPerHalf);
+
+        for (size_t i = 0; i < read * channelCount; i++)
+            HOST_CHECK(values[i] == Sample(written - half + i));
+
+        // caught up again
+        Produce(half);
+
+        HOST_CHECK(TinyCLR_Adc_ReadStream(&controller, 1, values.data(), 2 * setsPerHalf, read, overrun) == TinyCLR_Result::Success);
+        HOST_CHECK(!overrun && read == setsPerHalf);
+        HOST_CHECK(values[0] == Sample(written - half));
+        HOST_CHECK(TinyCLR_Adc_StopStream(&controller) == TinyCLR_Result::Success);
+    }
+}
+
+// The hardware moving on while the sets are copied: into the half being copied only once it fills the other half
+// too, then the copy can't be trusted.
+static void TestRace() {
+    const size_t setsPerHalf = 8;
+
+    int32_t values[2 * setsPerHalf];
+    size_t read;
+    bool overrun;
+
+    HOST_CHECK(TinyCLR_Adc_StartStream(&controller, channels, 1, 1000, setsPerHalf, nullptr) == TinyCLR_Result::Success);
+
+    // copying the first half while the hardware fills all but the last sample of the second one is fine
+    Produce(setsPerHalf);
+    racing = setsPerHalf - 1;
+
+    HOST_CHECK(TinyCLR_Adc_ReadStream(&controller, 1, values, setsPerHalf, read, overrun) == TinyCLR_Result::Success);
+    HOST_CHECK(read == setsPerHalf && !overrun);
+
+    // the second half while the hardware finishes it and fills the first one again, it goes on into the second
+    Produce(1);
+    racing = setsPerHalf;
+
+    HOST_CHECK(TinyCLR_Adc_ReadStream(&controller, 1, values, setsPerHalf, read, overrun) == TinyCLR_Result::Success);
+    HOST_CHECK(read == setsPerHalf && overrun);
+    HOST_CHECK(TinyCLR_Adc_StopStream(&controller) == TinyCLR_Result::Success);
+}
+
+int main() {
+    srand(1);
+
+    HOST_CHECK(TinyCLR_Adc_SetStreamApi(&controller, &streamApi));
+    HOST_CHECK(TinyCLR_Adc_GetStreamApi(&controller) == &streamApi);
+    HOST_CHECK(TinyCLR_Adc_GetStreamApi(&otherController) == nullptr);
+
+    TestStartStop();
+    TestRead();
+    TestPartialGroup();
+    TestDecimation();
+    TestOverrun();
+    TestRace();
+
+    return Host_Finish("Adc/StreamTest");
+}
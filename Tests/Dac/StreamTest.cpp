@@ -0,0 +1,332 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <vector>
+
+#include "../Host/Host.h"
+#include "../../Drivers/DevicesInterop/Dac/GHIElectronics_TinyCLR_Devices_Dac_Stream.h"
+
+#define IDLE 0
+
+// A stream backend playing the DMA: it takes the words out of the ring one at a time when they play and, like the
+// half-transfer and transfer-complete interrupts, moves played on only when a half is done. The words encode a value
+// plus a marker, so a word stored without Encode shows up.
+#define ENCODED 0x10000
+
+static TinyCLR_Api_Info controllerApi = { "", "Dac", TinyCLR_Api_Type::DacController, 0, nullptr, nullptr };
+static TinyCLR_Dac_Controller controller = { &controllerApi };
+static TinyCLR_Dac_Controller otherController;
+
+struct Player {
+    const uint32_t* buffer;
+    size_t length;
+    uint64_t position;
+    uint64_t played;
+    TinyCLR_Dac_StreamHandler handler;
+    bool running;
+
+    std::vector<int32_t> output;
+};
+
+static Player players[TINYCLR_DAC_STREAM_MAX_CHANNELS];
+
+// The free count the last Dac.StreamBufferEmpty carried
+static uint64_t eventFree;
+static uint32_t events;
+
+static TinyCLR_Result Stream_Start(const TinyCLR_Dac_Controller* self, uint32_t channel, uint32_t frequency, const uint32_t* buffer, size_t length, TinyCLR_Dac_StreamHandler handler) {
+    auto& player = players[channel];
+
+    player.buffer = buffer;
+    player.length = length;
+    player.position = 0;
+    player.played = 0;
+    player.handler = handler;
+    player.running = true;
+    player.output.clear();
+
+    return TinyCLR_Result::Success;
+}
+
+static uint64_t Stream_GetPlayed(const TinyCLR_Dac_Controller* self, uint32_t channel) {
+    return players[channel].played;
+}
+
+static TinyCLR_Result Stream_Stop(const TinyCLR_Dac_Controller* self, uint32_t channel) {
+    players[channel].running = false;
+
+    return TinyCLR_Result::Success;
+}
+
+static void Stream_Encode(const TinyCLR_Dac_Controller* self, uint32_t channel, const int32_t* values, uint32_t* words, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        words[i] = static_cast<uint32_t>(values[i]) + ENCODED;
+}
+
+static TinyCLR_Result Interop_RaiseEvent(const TinyCLR_Interop_Manager* self, const char* name, const char* controllerName, uint64_t channel, uint64_t free, uint64_t d2, int64_t d3, uint64_t timestamp) {
+    eventFree = free;
+    events++;
+
+    return TinyCLR_Result::Success;
+}
+
+static const TinyCLR_Dac_StreamApi streamApi = { &Stream_Start, &Stream_GetPlayed, &Stream_Stop, &Stream_Encode };
+static const TinyCLR_Interop_Manager interopManager = { &Interop_RaiseEvent };
+
+// Plays count words. The task the target posts on a half runs some time later, when the test calls Notify.
+static void Play(uint32_t channel, size_t count) {
+    auto& player = players[channel];
+
+    for (size_t i = 0; i < count; i++) {
+        auto word = player.buffer[player.position % player.length];
+
+        HOST_CHECK(word >= ENCODED);
+
+        player.output.push_back(static_cast<int32_t>(word - ENCODED));
+        player.position++;
+
+        if (player.position % (player.length / 2) == 0)
+            player.played = player.position;
+    }
+}
+
+static void Notify(uint32_t channel) {
+    auto& player = players[channel];
+
+    if (player.handler != nullptr)
+        player.handler(&controller, channel, player.played, 0);
+}
+
+static std::vector<int32_t> Values(int32_t first, size_t count) {
+    std::vector<int32_t> values(count);
+
+    for (size_t i = 0; i < count; i++)
+        values[i] = first + static_cast<int32_t>(i);
+
+    return values;
+}
+
+static void TestStartStop() {
+    size_t written;
+    int32_t values[4] = { 1, 2, 3, 4 };
+
+    HOST_CHECK(TinyCLR_Dac_StartStream(&otherController, 0, 1000, values, 4, 4, IDLE, false, written) == TinyCLR_Result::NotSupported);
+    HOST_CHECK(TinyCLR_Dac_StartStream(&controller, 0, 1000, nullptr, 4, 4, IDLE, false, written) == TinyCLR_Result::ArgumentNull);
+    HOST_CHECK(TinyCLR_Dac_StartStream(&controller, TINYCLR_DAC_STREAM_MAX_CHANNELS, 1000, values, 4, 4, IDLE, false, written) == TinyCLR_Result::ArgumentOutOfRange);
+    HOST_CHECK(TinyCLR_Dac_StartStream(&controller, 0, 0, values, 4, 4, IDLE, false, written) == TinyCLR_Result::ArgumentOutOfRange);
+    HOST_CHECK(TinyCLR_Dac_StartStream(&controller, 0, 1000, values, 4, 0, IDLE, false, written) == TinyCLR_Result::ArgumentOutOfRange);
+    HOST_CHECK(TinyCLR_Dac_StartStream(&controller, 0, 1000, values, 0, 0, IDLE, true, written) == TinyCLR_Result::ArgumentOutOfRange);
+    HOST_CHECK(TinyCLR_Dac_WriteStream(&controller, 0, values, 4, written) == TinyCLR_Result::InvalidOperation);
+    HOST_CHECK(TinyCLR_Dac_StopStream(&controller, 0) == TinyCLR_Result::InvalidOperation);
+
+    Host_SetAllocationEnabled(false);
+    HOST_CHECK(TinyCLR_Dac_StartStream(&controller, 0, 1000, values, 4, 4, IDLE, false, written) == TinyCLR_Result::OutOfMemory);
+    HOST_CHECK(written == 0 && !players[0].running);
+    Host_SetAllocationEnabled(true);
+
+    // the two channels stream on their own, stopping one leaves the other
+    HOST_CHECK(TinyCLR_Dac_StartStream(&controller, 0, 1000, values, 4, 4, IDLE, false, written) == TinyCLR_Result::Success);
+    HOST_CHECK(written == 4 && players[0].length == 8 && players[0].handler != nullptr);
+    HOST_CHECK(reinterpret_cast<size_t>(players[0].buffer) % 32 == 0);
+    HOST_CHECK(TinyCLR_Dac_StartStream(&controller, 0, 1000, values, 4, 4, IDLE, false, written) == TinyCLR_Result::InvalidOperation);
+    HOST_CHECK(TinyCLR_Dac_StartStream(&controller, 1, 1000, values, 3, 4, IDLE, false, written) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_Dac_WriteStream(&controller, 0, nullptr, 4, written) == TinyCLR_Result::ArgumentNull);
+    HOST_CHECK(TinyCLR_Dac_StopStream(&controller, 0) == TinyCLR_Result::Success);
+    HOST_CHECK(!players[0].running && players[1].running);
+
+    Play(1, 8);
+
+    HOST_CHECK(players[1].output == std::vector<int32_t>({ 1, 2, 3, IDLE, IDLE, IDLE, IDLE, IDLE }));
+    HOST_CHECK(TinyCLR_Dac_StopStream(&controller, 1) == TinyCLR_Result::Success);
+}
+
+// The values written at the start fill the ring from its beginning, the rest of it plays idle. Each half that plays
+// frees its values for writing, the event reports them.
+static void TestPrime() {
+    size_t written;
+    size_t free;
+    uint64_t underruns;
+    auto values = Values(1, 20);
+
+    HOST_CHECK(TinyCLR_Dac_StartStream(&controller, 0, 1000, values.data(), 20, 8, IDLE, false, written) == TinyCLR_Result::Success);
+    HOST_CHECK(written == 16);
+    HOST_CHECK(TinyCLR_Dac_GetStreamState(&controller, 0, free, underruns) == TinyCLR_Result::Success);
+    HOST_CHECK(free == 0 && underruns == 0);
+
+    events = 0;
+    Play(0, 8);
+    Notify(0);
+
+    HOST_CHECK(events == 1 && eventFree == 8);
+
+    HOST_CHECK(TinyCLR_Dac_WriteStream(&controller, 0, values.data() + 16, 4, written) == TinyCLR_Result::Success);
+    HOST_CHECK(written == 4);
+    HOST_CHECK(TinyCLR_Dac_GetStreamState(&controller, 0, free, underruns) == TinyCLR_Result::Success);
+    HOST_CHECK(free == 4 && underruns == 0);
+
+    Play(0, 16);
+
+    auto expected = Values(1, 20);
+
+    expected.insert(expected.end(), 4, IDLE);
+
+    HOST_CHECK(players[0].output == expected);
+    HOST_CHECK(TinyCLR_Dac_StopStream(&controller, 0) == TinyCLR_Result::Success);
+}
+
+// A refill after its half started to play is an underrun: the half plays idle rather than the values it held a ring
+// ago, and the values go into the half after it.
+static void TestUnderrun() {
+    size_t written;
+    size_t free;
+    uint64_t underruns;
+    auto values = Values(1, 12);
+
+    HOST_CHECK(TinyCLR_Dac_StartStream(&controller, 0, 1000, values.data(), 8, 4, IDLE, false, written) == TinyCLR_Result::Success);
+    HOST_CHECK(written == 8);
+
+    Play(0, 4);
+    Notify(0);
+    Play(0, 5);
+
+    HOST_CHECK(TinyCLR_Dac_WriteStream(&controller, 0, values.data() + 8, 4, written) == TinyCLR_Result::Success);
+    HOST_CHECK(written == 4);
+    HOST_CHECK(TinyCLR_Dac_GetStreamState(&controller, 0, free, underruns) == TinyCLR_Result::Success);
+    HOST_CHECK(underruns == 1 && free == 0);
+
+    Play(0, 7);
+
+    HOST_CHECK(players[0].output == std::vector<int32_t>({ 1, 2, 3, 4, 5, 6, 7, 8, IDLE, IDLE, IDLE, IDLE, 9, 10, 11, 12 }));
+
+    // nothing more written, the halves coming around again don't replay old values
+    Notify(0);
+
+    HOST_CHECK(TinyCLR_Dac_GetStreamState(&controller, 0, free, underruns) == TinyCLR_Result::Success);
+    HOST_CHECK(underruns == 2);
+
+    Play(0, 8);
+
+    HOST_CHECK(std::vector<int32_t>(players[0].output.end() - 8, players[0].output.end()) == std::vector<int32_t>(8, IDLE));
+    HOST_CHECK(TinyCLR_Dac_StopStream(&controller, 0) == TinyCLR_Result::Success);
+}
+
+// A looped pattern replays as given, an odd one is stored twice so the ring still has two equal halves. There is
+// nothing to write and no event.
+static void TestLooped() {
+    size_t written;
+    size_t free;
+    uint64_t underruns;
+
+    for (size_t count = 1; count <= 9; count++) {
+        auto values = Values(100, count);
+
+        HOST_CHECK(TinyCLR_Dac_StartStream(&controller, 1, 1000, values.data(), count, 0, IDLE, true, written) == TinyCLR_Result::Success);
+        HOST_CHECK(written == count);
+        HOST_CHECK(players[1].length == (count % 2 != 0 ? 2 * count : count));
+        HOST_CHECK(players[1].handler == nullptr);
+        HOST_CHECK(TinyCLR_Dac_WriteStream(&controller, 1, values.data(), count, written) == TinyCLR_Result::InvalidOperation);
+        HOST_CHECK(TinyCLR_Dac_GetStreamState(&controller, 1, free, underruns) == TinyCLR_Result::Success);
+
+        Play(1, 5 * count + 3);
+
+        HOST_CHECK(TinyCLR_Dac_GetStreamState(&controller, 1, free, underruns) == TinyCLR_Result::Success);
+        HOST_CHECK(free == 0 && underruns == 0);
+
+        for (size_t i = 0; i < players[1].output.size(); i++)
+            HOST_CHECK(players[1].output[i] == values[i % count]);
+
+        HOST_CHECK(TinyCLR_Dac_StopStream(&controller, 1) == TinyCLR_Result::Success);
+    }
+}
+
+// Writers of any pace against a player of any pace, the queue caught up at least once per half by the task or a
+// write: the output is every value written, each once and in order, with only idle between them. Free never
+// promises room in the half playing.
+static void TestSchedule() {
+    for (auto t = 0; t < 500; t++) {
+        auto channel = static_cast<uint32_t>(rand()) % TINYCLR_DAC_STREAM_MAX_CHANNELS;
+        auto samplesPerHalf = 1 + static_cast<size_t>(rand()) % 32;
+        auto length = 2 * samplesPerHalf;
+        auto next = 1;
+        size_t written;
+
+        auto values = Values(next, static_cast<size_t>(rand()) % (3 * samplesPerHalf));
+
+        HOST_CHECK(TinyCLR_Dac_StartStream(&controller, channel, 1000, values.data(), values.size(), samplesPerHalf, IDLE, false, written) == TinyCLR_Result::Success);
+
+        next += static_cast<int32_t>(written);
+
+        for (auto i = 0; i < 300; i++) {
+            Play(channel, static_cast<size_t>(rand()) % (samplesPerHalf + 1));
+
+            if (rand() % 3 == 0)
+                Notify(channel);
+
+            size_t free;
+            uint64_t underruns;
+
+            HOST_CHECK(TinyCLR_Dac_GetStreamState(&controller, channel, free, underruns) == TinyCLR_Result::Success);
+
+            HOST_CHECK(free <= samplesPerHalf);
+
+            if (rand() % 2 == 0) {
+                values = Values(next, 1 + static_cast<size_t>(rand()) % (length + 4));
+
+                HOST_CHECK(TinyCLR_Dac_WriteStream(&controller, channel, values.data(), values.size(), written) == TinyCLR_Result::Success);
+                HOST_CHECK(written == (values.size() < free ? values.size() : free));
+
+                next += static_cast<int32_t>(written);
+            }
+        }
+
+        // what is queued plays out within the ring and the half playing
+        for (auto i = 0; i < 6; i++) {
+            Play(channel, samplesPerHalf);
+            Notify(channel);
+        }
+
+        auto expected = 1;
+
+        for (auto value : players[channel].output) {
+            if (value == IDLE)
+                continue;
+
+            HOST_CHECK(value == expected);
+
+            expected++;
+        }
+
+        HOST_CHECK(expected == next);
+        HOST_CHECK(TinyCLR_Dac_StopStream(&controller, channel) == TinyCLR_Result::Success);
+    }
+}
+
+int main() {
+    srand(1);
+
+    Host_SetApi(TinyCLR_Api_Type::InteropManager, &interopManager);
+
+    HOST_CHECK(TinyCLR_Dac_SetStreamApi(&controller, &streamApi));
+    HOST_CHECK(TinyCLR_Dac_GetStreamApi(&controller) == &streamApi);
+    HOST_CHECK(TinyCLR_Dac_GetStreamApi(&otherController) == nullptr);
+
+    TestStartStop();
+    TestPrime();
+    TestUnderrun();
+    TestLooped();
+    TestSchedule();
+
+    return Host_Finish("Dac/StreamTest");
+}
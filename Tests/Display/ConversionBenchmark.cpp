@@ -0,0 +1,105 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <chrono>
+#include "../Host/Host.h"
+#include "../../Drivers/Display/Display.h"
+
+#define FRAME_WIDTH 800
+#define FRAME_HEIGHT 480
+#define FRAME_PIXELS (FRAME_WIDTH * FRAME_HEIGHT)
+#define FRAMES 20
+#define ROUNDS 5
+
+static uint8_t source[FRAME_PIXELS * 4];
+static uint16_t destination[FRAME_PIXELS];
+static uint8_t destination888[FRAME_PIXELS * 3];
+static uint16_t palette[256];
+
+// One pixel per load and store loops, as the baseline for the kernels. Kept out of line like the kernels
+// so both pay the same call per row.
+static __attribute__((noinline)) void Baseline_Rgb888ToRgb565(const uint8_t* in, uint16_t* out, int32_t count) {
+    for (auto i = 0; i < count; i++)
+        out[i] = static_cast<uint16_t>(((in[i * 3 + 2] >> 3) << 11) | ((in[i * 3 + 1] >> 2) << 5) | (in[i * 3] >> 3));
+}
+
+static __attribute__((noinline)) void Baseline_Argb8888ToRgb565(const uint32_t* in, uint16_t* out, int32_t count) {
+    for (auto i = 0; i < count; i++)
+        out[i] = static_cast<uint16_t>(((in[i] >> 8) & 0xF800) | ((in[i] >> 5) & 0x07E0) | ((in[i] >> 3) & 0x001F));
+}
+
+static __attribute__((noinline)) void Baseline_Rgb565ToRgb888(const uint16_t* in, uint8_t* out, int32_t count) {
+    for (auto i = 0; i < count; i++) {
+        auto r = in[i] >> 11;
+        auto g = (in[i] >> 5) & 0x3F;
+        auto b = in[i] & 0x1F;
+
+        out[i * 3 + 0] = static_cast<uint8_t>((b << 3) | (b >> 2));
+        out[i * 3 + 1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+        out[i * 3 + 2] = static_cast<uint8_t>((r << 3) | (r >> 2));
+    }
+}
+
+// Best of a few rounds, the slower ones are the host doing something else.
+template<typename T> static void Measure(const char* name, T convert) {
+    auto seconds = 0.0;
+
+    for (auto round = 0; round < ROUNDS; round++) {
+        auto start = std::chrono::steady_clock::now();
+
+        for (auto frame = 0; frame < FRAMES; frame++)
+            for (auto row = 0; row < FRAME_HEIGHT; row++)
+                convert(row);
+
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (round == 0 || elapsed < seconds)
+            seconds = elapsed;
+    }
+
+    printf("%-36s %8.1f Mpixel/s\n", name, static_cast<double>(FRAME_PIXELS) * FRAMES / seconds / 1e6);
+}
+
+int main() {
+    for (auto i = 0U; i < sizeof(source); i++)
+        source[i] = static_cast<uint8_t>(rand());
+
+    for (auto i = 0; i < 256; i++)
+        palette[i] = static_cast<uint16_t>(rand());
+
+    auto source565 = reinterpret_cast<const uint16_t*>(source);
+    auto source8888 = reinterpret_cast<const uint32_t*>(source);
+
+    printf("%dx%d frames, best of %d rounds of %d\n", FRAME_WIDTH, FRAME_HEIGHT, ROUNDS, FRAMES);
+
+    Measure("Rgb888ToRgb565 baseline", [=](int32_t row) { Baseline_Rgb888ToRgb565(source + row * FRAME_WIDTH * 3, destination + row * FRAME_WIDTH, FRAME_WIDTH); });
+    Measure("Rgb888ToRgb565", [=](int32_t row) { Display_ConvertRgb888ToRgb565(source + row * FRAME_WIDTH * 3, destination + row * FRAME_WIDTH, FRAME_WIDTH); });
+    Measure("Argb8888ToRgb565 baseline", [=](int32_t row) { Baseline_Argb8888ToRgb565(source8888 + row * FRAME_WIDTH, destination + row * FRAME_WIDTH, FRAME_WIDTH); });
+    Measure("Argb8888ToRgb565", [=](int32_t row) { Display_ConvertArgb8888ToRgb565(source8888 + row * FRAME_WIDTH, destination + row * FRAME_WIDTH, FRAME_WIDTH, false, 0, row); });
+    Measure("Argb8888ToRgb565 dithered", [=](int32_t row) { Display_ConvertArgb8888ToRgb565(source8888 + row * FRAME_WIDTH, destination + row * FRAME_WIDTH, FRAME_WIDTH, true, 0, row); });
+    Measure("L8ToRgb565", [=](int32_t row) { Display_ConvertL8ToRgb565(source + row * FRAME_WIDTH, destination + row * FRAME_WIDTH, FRAME_WIDTH, palette); });
+    Measure("Rgb565ToRgb888 baseline", [=](int32_t row) { Baseline_Rgb565ToRgb888(source565 + row * FRAME_WIDTH, destination888 + row * FRAME_WIDTH * 3, FRAME_WIDTH); });
+    Measure("Rgb565ToRgb888", [=](int32_t row) { Display_ConvertRgb565ToRgb888(source565 + row * FRAME_WIDTH, destination888 + row * FRAME_WIDTH * 3, FRAME_WIDTH); });
+
+    // keeps the stores from being optimised away
+    auto sum = 0U;
+
+    for (auto i = 0; i < FRAME_PIXELS; i++)
+        sum += destination[i] + destination888[i];
+
+    printf("checksum %08x\n", sum);
+
+    return 0;
+}
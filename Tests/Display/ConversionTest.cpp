@@ -0,0 +1,218 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include "../Host/Host.h"
+#include "../../Drivers/Display/Display.h"
+
+#define SCREEN_WIDTH 320
+#define SCREEN_HEIGHT 240
+
+static const uint8_t bayer[4][4] = { { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+
+static uint16_t screen[SCREEN_WIDTH * SCREEN_HEIGHT];
+static int32_t screenDraws;
+static int32_t screenFlips;
+
+// Per pixel references the kernels must match bit for bit.
+static uint16_t Reference_ToRgb565(uint32_t r, uint32_t g, uint32_t b) {
+    return static_cast<uint16_t>(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+static uint16_t Reference_Argb8888ToRgb565(uint32_t p, bool dither, int32_t x, int32_t y) {
+    auto d = dither ? bayer[y & 3][x & 3] : 0;
+    uint32_t channels[3] = { ((p >> 16) & 0xFF) + (d >> 1), ((p >> 8) & 0xFF) + (d >> 2), (p & 0xFF) + (d >> 1) };
+
+    for (auto& c : channels)
+        if (c > 0xFF)
+            c = 0xFF;
+
+    return Reference_ToRgb565(channels[0], channels[1], channels[2]);
+}
+
+static void Reference_Rgb565ToRgb888(uint16_t p, uint8_t* rgb) {
+    auto r = p >> 11;
+    auto g = (p >> 5) & 0x3F;
+    auto b = p & 0x1F;
+
+    rgb[0] = static_cast<uint8_t>((b << 3) | (b >> 2));
+    rgb[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+    rgb[2] = static_cast<uint8_t>((r << 3) | (r >> 2));
+}
+
+static void Fill(uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++)
+        data[i] = static_cast<uint8_t>(rand());
+}
+
+static TinyCLR_Result Screen_DrawBuffer(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* data) {
+    for (auto row = 0U; row < height; row++)
+        memcpy(screen + (y + row) * SCREEN_WIDTH + x, data + row * width * sizeof(uint16_t), width * sizeof(uint16_t));
+
+    screenDraws++;
+
+    if (!Display_IsFlipDeferred())
+        screenFlips++;
+
+    return TinyCLR_Result::Success;
+}
+
+// Every source and destination alignment and every length up to a few words, so the paired and
+// word at a time paths and their head and tail pixels are all covered.
+static void TestRowKernels() {
+    static uint8_t source[4 * 64 + 4];
+    static uint16_t destination[64 + 2];
+    static uint8_t destination888[3 * 64 + 4];
+    static uint16_t palette[256];
+
+    Fill(reinterpret_cast<uint8_t*>(palette), sizeof(palette));
+
+    for (auto iteration = 0; iteration < 200; iteration++) {
+        Fill(source, sizeof(source));
+
+        for (auto count = 0; count <= 64; count++) {
+            for (auto sourceOffset = 0; sourceOffset < 4; sourceOffset++) {
+                for (auto destinationOffset = 0; destinationOffset < 2; destinationOffset++) {
+                    auto in = source + sourceOffset;
+                    auto out = destination + destinationOffset;
+
+                    Display_ConvertRgb888ToRgb565(in, out, count);
+
+                    for (auto i = 0; i < count; i++)
+                        HOST_CHECK(out[i] == Reference_ToRgb565(in[i * 3 + 2], in[i * 3 + 1], in[i * 3]));
+
+                    Display_ConvertL8ToRgb565(in, out, count, palette);
+
+                    for (auto i = 0; i < count; i++)
+                        HOST_CHECK(out[i] == palette[in[i]]);
+
+                    auto in565 = reinterpret_cast<const uint16_t*>(source) + destinationOffset;
+                    auto out888 = destination888 + sourceOffset;
+                    uint8_t rgb[3];
+
+                    Display_ConvertRgb565ToRgb888(in565, out888, count);
+
+                    for (auto i = 0; i < count; i++) {
+                        Reference_Rgb565ToRgb888(in565[i], rgb);
+
+                        HOST_CHECK(memcmp(out888 + i * 3, rgb, 3) == 0);
+                    }
+
+                    // RGB565 survives the round trip through RGB888 unchanged
+                    Display_ConvertRgb888ToRgb565(out888, out, count);
+
+                    HOST_CHECK(memcmp(out, in565, count * sizeof(uint16_t)) == 0);
+                }
+            }
+
+            auto in32 = reinterpret_cast<const uint32_t*>(source);
+            auto x = rand() % 64;
+            auto y = rand() % 64;
+
+            for (auto destinationOffset = 0; destinationOffset < 2; destinationOffset++) {
+                auto out = destination + destinationOffset;
+
+                for (auto dither = 0; dither < 2; dither++) {
+                    Display_ConvertArgb8888ToRgb565(in32, out, count, dither != 0, x, y);
+
+                    for (auto i = 0; i < count; i++)
+                        HOST_CHECK(out[i] == Reference_Argb8888ToRgb565(in32[i], dither != 0, x + i, y));
+                }
+            }
+        }
+    }
+}
+
+static void TestRectangle() {
+    static uint8_t source[3 * 40 * 10];
+    static uint16_t destination[48 * 10];
+
+    Fill(source, sizeof(source));
+    memset(destination, 0, sizeof(destination));
+
+    HOST_CHECK(Display_ConvertToRgb565(Display_PixelFormat::Rgb888, source, 3 * 40, nullptr, false, destination, 48, 40, 10));
+
+    for (auto row = 0; row < 10; row++) {
+        for (auto i = 0; i < 40; i++) {
+            auto p = source + row * 3 * 40 + i * 3;
+
+            HOST_CHECK(destination[row * 48 + i] == Reference_ToRgb565(p[2], p[1], p[0]));
+        }
+
+        // the destination stride is honoured, the padding isn't touched
+        for (auto i = 40; i < 48; i++)
+            HOST_CHECK(destination[row * 48 + i] == 0);
+    }
+
+    HOST_CHECK(!Display_ConvertToRgb565(Display_PixelFormat::L8, source, 40, nullptr, false, destination, 48, 40, 10));
+}
+
+// Both the one piece conversion and the banded one when the heap is empty, with the dither anchored
+// to the screen so separately drawn bands line up.
+static void TestDrawConvertedBuffer() {
+    static uint32_t source[200 * 24];
+    static uint16_t palette[256];
+
+    TinyCLR_Display_Controller controller = {};
+
+    controller.DrawBuffer = &Screen_DrawBuffer;
+
+    Fill(reinterpret_cast<uint8_t*>(palette), sizeof(palette));
+
+    for (auto iteration = 0; iteration < 2000; iteration++) {
+        auto width = 1 + rand() % 200;
+        auto height = 1 + rand() % 24;
+        auto x = rand() % (SCREEN_WIDTH - width);
+        auto y = rand() % (SCREEN_HEIGHT - height);
+        auto format = rand() % 2 == 0 ? Display_PixelFormat::Argb8888 : Display_PixelFormat::L8;
+        auto dither = rand() % 2 == 0;
+
+        Fill(reinterpret_cast<uint8_t*>(source), sizeof(source));
+        memset(screen, 0, sizeof(screen));
+
+        Host_SetAllocationEnabled(rand() % 2 == 0);
+
+        screenDraws = 0;
+        screenFlips = 0;
+
+        HOST_CHECK(Display_DrawConvertedBuffer(&controller, x, y, width, height, format, reinterpret_cast<const uint8_t*>(source), palette, dither) == TinyCLR_Result::Success);
+
+        // however many bands it takes, a double buffered display flips once after the last
+        HOST_CHECK(screenFlips == 1 && !Display_IsFlipDeferred());
+        HOST_CHECK(screenDraws == 1 || width * height > 1024);
+
+        for (auto row = 0; row < height; row++) {
+            for (auto i = 0; i < width; i++) {
+                auto expected = format == Display_PixelFormat::L8 ? palette[reinterpret_cast<const uint8_t*>(source)[row * width + i]] : Reference_Argb8888ToRgb565(source[row * width + i], dither, x + i, y + row);
+
+                HOST_CHECK(screen[(y + row) * SCREEN_WIDTH + x + i] == expected);
+            }
+        }
+    }
+
+    Host_SetAllocationEnabled(true);
+
+    HOST_CHECK(Display_DrawConvertedBuffer(&controller, 0, 0, 8, 8, Display_PixelFormat::L8, reinterpret_cast<const uint8_t*>(source), nullptr, false) == TinyCLR_Result::ArgumentInvalid);
+}
+
+int main() {
+    srand(1);
+
+    TestRowKernels();
+    TestRectangle();
+    TestDrawConvertedBuffer();
+
+    return Host_Finish("Display/ConversionTest");
+}
@@ -0,0 +1,114 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include "../Host/Host.h"
+#include "../../Drivers/Display/Display.h"
+
+#define WIDTH 48
+#define HEIGHT 64
+
+static uint16_t framebuffer[WIDTH * HEIGHT];
+static uint16_t frame[WIDTH * HEIGHT];
+
+static void Change(int32_t x, int32_t y) {
+    frame[y * WIDTH + x] ^= 0x8001;
+}
+
+static void TestUnchanged() {
+    Display_DamageStatistics statistics;
+    Display_DirtyBand bands[4];
+
+    for (auto i = 0; i < WIDTH * HEIGHT; i++)
+        framebuffer[i] = frame[i] = static_cast<uint16_t>(rand());
+
+    HOST_CHECK(!Display_CopyChangedRgb565(frame, WIDTH, framebuffer, WIDTH, WIDTH, HEIGHT));
+
+    Display_GetDamageStatistics(statistics);
+
+    HOST_CHECK(statistics.Frames == 1);
+    HOST_CHECK(statistics.UnchangedPixels == WIDTH * HEIGHT && statistics.CopiedPixels == 0);
+    HOST_CHECK(statistics.ChangedRows == 0 && statistics.Bands == 0);
+    HOST_CHECK(statistics.DirtyLeft == 0 && statistics.DirtyTop == 0 && statistics.DirtyRight == 0 && statistics.DirtyBottom == 0);
+    HOST_CHECK(Display_GetDirtyBands(bands, 4) == 0);
+}
+
+// Two separate runs of rows give two bands, each with the columns changed within it.
+static void TestBands() {
+    Display_DamageStatistics statistics;
+    Display_DirtyBand bands[4] = {};
+
+    Change(5, 3);
+    Change(9, 4);
+    Change(7, 5);
+    Change(20, 10);
+    Change(31, 10);
+
+    HOST_CHECK(Display_CopyChangedRgb565(frame, WIDTH, framebuffer, WIDTH, WIDTH, HEIGHT));
+    HOST_CHECK(memcmp(frame, framebuffer, sizeof(frame)) == 0);
+
+    Display_GetDamageStatistics(statistics);
+
+    HOST_CHECK(statistics.Frames == 2);
+    HOST_CHECK(statistics.ChangedRows == 4 && statistics.Bands == 2);
+    HOST_CHECK(statistics.CopiedPixels == 1 + 1 + 1 + 12);
+    HOST_CHECK(statistics.UnchangedPixels == WIDTH * HEIGHT - 15);
+    HOST_CHECK(statistics.DirtyLeft == 5 && statistics.DirtyTop == 3 && statistics.DirtyRight == 32 && statistics.DirtyBottom == 11);
+
+    HOST_CHECK(Display_GetDirtyBands(bands, 1) == 2);
+    HOST_CHECK(bands[0].Left == 5 && bands[0].Top == 3 && bands[0].Right == 10 && bands[0].Bottom == 6);
+    HOST_CHECK(bands[1].Bottom == 0);
+
+    HOST_CHECK(Display_GetDirtyBands(bands, 4) == 2);
+    HOST_CHECK(bands[1].Left == 20 && bands[1].Top == 10 && bands[1].Right == 32 && bands[1].Bottom == 11);
+}
+
+// Every other row changed makes more bands than are kept, the last one stored covers the rest.
+static void TestBandLimit() {
+    Display_DamageStatistics statistics;
+    Display_DirtyBand bands[HEIGHT];
+
+    for (auto y = 0; y < HEIGHT; y += 2)
+        Change(y % WIDTH, y);
+
+    HOST_CHECK(Display_CopyChangedRgb565(frame, WIDTH, framebuffer, WIDTH, WIDTH, HEIGHT));
+
+    Display_GetDamageStatistics(statistics);
+
+    auto count = Display_GetDirtyBands(bands, HEIGHT);
+
+    HOST_CHECK(statistics.Bands == HEIGHT / 2);
+    HOST_CHECK(count == 16);
+
+    for (auto i = 0; i < count - 1; i++)
+        HOST_CHECK(bands[i].Left == i * 2 && bands[i].Top == i * 2 && bands[i].Right == i * 2 + 1 && bands[i].Bottom == i * 2 + 1);
+
+    HOST_CHECK(bands[count - 1].Top == (count - 1) * 2 && bands[count - 1].Bottom == HEIGHT - 1);
+    HOST_CHECK(bands[count - 1].Left == 0 && bands[count - 1].Right == WIDTH - 1);
+
+    Display_SetDamageTracking(true);
+
+    HOST_CHECK(Display_GetDirtyBands(bands, HEIGHT) == 0);
+}
+
+int main() {
+    srand(1);
+
+    TestUnchanged();
+    TestBands();
+    TestBandLimit();
+
+    return Host_Finish("Display/DamageTest");
+}
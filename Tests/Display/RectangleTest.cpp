@@ -0,0 +1,165 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include "../Host/Host.h"
+#include "../../Drivers/Display/Display.h"
+
+// The CPU kernels stand in for the DMA2D, the expected values are what its pixel format converter and blender give
+// for the same transfer: expansion repeats the high bits in the low ones, reduction truncates and the blender works
+// on 8 bit channels with a truncating divide.
+static uint32_t ConvertPixel(uint32_t pixel, uint32_t from, uint32_t to) {
+    uint8_t source[4] = { static_cast<uint8_t>(pixel), static_cast<uint8_t>(pixel >> 8), static_cast<uint8_t>(pixel >> 16), static_cast<uint8_t>(pixel >> 24) };
+    uint8_t destination[4] = {};
+
+    Display_ConvertRectangle(source, destination, 1, 1, 0, 0, from, to);
+
+    return destination[0] | (destination[1] << 8) | (destination[2] << 16) | (static_cast<uint32_t>(destination[3]) << 24);
+}
+
+static uint32_t BlendPixel(uint32_t foreground, uint32_t background, uint32_t colorMode, uint8_t alpha) {
+    uint8_t destination[4] = { static_cast<uint8_t>(background), static_cast<uint8_t>(background >> 8), static_cast<uint8_t>(background >> 16), static_cast<uint8_t>(background >> 24) };
+
+    Display_BlendRectangle(&foreground, destination, 1, 1, 0, 0, colorMode, alpha);
+
+    return destination[0] | (destination[1] << 8) | (destination[2] << 16) | (static_cast<uint32_t>(destination[3]) << 24);
+}
+
+static void TestConvertPixels() {
+    HOST_CHECK(ConvertPixel(0xF800, DISPLAY_COLOR_MODE_RGB565, DISPLAY_COLOR_MODE_ARGB8888) == 0xFFFF0000);
+    HOST_CHECK(ConvertPixel(0x07E0, DISPLAY_COLOR_MODE_RGB565, DISPLAY_COLOR_MODE_ARGB8888) == 0xFF00FF00);
+    HOST_CHECK(ConvertPixel(0x001F, DISPLAY_COLOR_MODE_RGB565, DISPLAY_COLOR_MODE_ARGB8888) == 0xFF0000FF);
+    HOST_CHECK(ConvertPixel(0x8410, DISPLAY_COLOR_MODE_RGB565, DISPLAY_COLOR_MODE_ARGB8888) == 0xFF848284);
+    HOST_CHECK(ConvertPixel(0x7FFF, DISPLAY_COLOR_MODE_ARGB1555, DISPLAY_COLOR_MODE_ARGB8888) == 0x00FFFFFF);
+    HOST_CHECK(ConvertPixel(0x8000, DISPLAY_COLOR_MODE_ARGB1555, DISPLAY_COLOR_MODE_ARGB8888) == 0xFF000000);
+    HOST_CHECK(ConvertPixel(0x1234, DISPLAY_COLOR_MODE_ARGB4444, DISPLAY_COLOR_MODE_ARGB8888) == 0x11223344);
+    HOST_CHECK(ConvertPixel(0x030201, DISPLAY_COLOR_MODE_RGB888, DISPLAY_COLOR_MODE_ARGB8888) == 0xFF030201);
+
+    HOST_CHECK(ConvertPixel(0xFF848284, DISPLAY_COLOR_MODE_ARGB8888, DISPLAY_COLOR_MODE_RGB565) == 0x8410);
+    HOST_CHECK(ConvertPixel(0xFF87878F, DISPLAY_COLOR_MODE_ARGB8888, DISPLAY_COLOR_MODE_RGB565) == 0x8431);
+    HOST_CHECK(ConvertPixel(0x80FFFFFF, DISPLAY_COLOR_MODE_ARGB8888, DISPLAY_COLOR_MODE_ARGB1555) == 0xFFFF);
+    HOST_CHECK(ConvertPixel(0x7FFFFFFF, DISPLAY_COLOR_MODE_ARGB8888, DISPLAY_COLOR_MODE_ARGB1555) == 0x7FFF);
+    HOST_CHECK(ConvertPixel(0x1F2E3D4C, DISPLAY_COLOR_MODE_ARGB8888, DISPLAY_COLOR_MODE_ARGB4444) == 0x1234);
+    HOST_CHECK(ConvertPixel(0x12030201, DISPLAY_COLOR_MODE_ARGB8888, DISPLAY_COLOR_MODE_RGB888) == 0x030201);
+
+    // indirect modes are left to the caller
+    HOST_CHECK(ConvertPixel(0x12, DISPLAY_COLOR_MODE_L8, DISPLAY_COLOR_MODE_ARGB8888) == 0);
+}
+
+// Every 16 bit pixel survives expansion to ARGB8888 and back.
+static void TestRoundTrip() {
+    const uint32_t modes[] = { DISPLAY_COLOR_MODE_RGB565, DISPLAY_COLOR_MODE_ARGB1555, DISPLAY_COLOR_MODE_ARGB4444 };
+
+    for (auto mode : modes)
+        for (uint32_t pixel = 0; pixel <= 0xFFFF; pixel++)
+            HOST_CHECK(ConvertPixel(ConvertPixel(pixel, mode, DISPLAY_COLOR_MODE_ARGB8888), DISPLAY_COLOR_MODE_ARGB8888, mode) == pixel);
+}
+
+static void TestBlend() {
+    // half transparent red over opaque blue
+    HOST_CHECK(BlendPixel(0x80FF0000, 0xFF0000FF, DISPLAY_COLOR_MODE_ARGB8888, 0xFF) == 0xFF80007F);
+    HOST_CHECK(BlendPixel(0xFFFF0000, 0xFF0000FF, DISPLAY_COLOR_MODE_ARGB8888, 0x80) == 0xFF80007F);
+    HOST_CHECK(BlendPixel(0x80FF0000, 0x001F, DISPLAY_COLOR_MODE_RGB565, 0xFF) == 0x800F);
+
+    // both half transparent: Mult = 0x40, alpha out = 0xC0
+    HOST_CHECK(BlendPixel(0x80FF0000, 0x800000FF, DISPLAY_COLOR_MODE_ARGB8888, 0xFF) == 0xC0AA0055);
+
+    // opaque replaces, transparent leaves the destination alone
+    HOST_CHECK(BlendPixel(0xFF123456, 0x80ABCDEF, DISPLAY_COLOR_MODE_ARGB8888, 0xFF) == 0xFF123456);
+    HOST_CHECK(BlendPixel(0x00123456, 0x80ABCDEF, DISPLAY_COLOR_MODE_ARGB8888, 0xFF) == 0x80ABCDEF);
+    HOST_CHECK(BlendPixel(0xFF123456, 0x80ABCDEF, DISPLAY_COLOR_MODE_ARGB8888, 0x00) == 0x80ABCDEF);
+
+    // the blender formula on 8 bit channels
+    for (auto i = 0; i < 100000; i++) {
+        auto fg = static_cast<uint32_t>(rand()) ^ (static_cast<uint32_t>(rand()) << 16);
+        auto bg = static_cast<uint32_t>(rand()) ^ (static_cast<uint32_t>(rand()) << 16);
+        auto alpha = static_cast<uint8_t>(rand());
+        auto fa = ((fg >> 24) * alpha) / 255;
+        auto ba = bg >> 24;
+        auto mult = fa * ba / 255;
+        auto oa = fa + ba - mult;
+        auto expected = bg;
+
+        if (fa == 0xFF) {
+            expected = fg;
+        }
+        else if (fa != 0) {
+            expected = oa << 24;
+
+            for (auto shift = 0; shift < 24; shift += 8)
+                expected |= ((((fg >> shift) & 0xFF) * fa + ((bg >> shift) & 0xFF) * (ba - mult)) / oa) << shift;
+        }
+
+        HOST_CHECK(BlendPixel(fg, bg, DISPLAY_COLOR_MODE_ARGB8888, alpha) == expected);
+    }
+}
+
+// Offsets skip pixels at the end of each line, they are never written.
+static void TestOffsets() {
+    uint16_t source[6 * 4];
+    uint16_t destination[8 * 4];
+    uint8_t rgb[5 * 3 * 2];
+
+    for (auto i = 0; i < 6 * 4; i++)
+        source[i] = static_cast<uint16_t>(0x1000 + i);
+
+    memset(destination, 0xAA, sizeof(destination));
+
+    Display_CopyRectangle(source, destination, 4, 3, 2, 4, DISPLAY_COLOR_MODE_RGB565);
+
+    for (auto y = 0; y < 4; y++)
+        for (auto x = 0; x < 8; x++)
+            HOST_CHECK(destination[y * 8 + x] == (y < 3 && x < 4 ? source[y * 6 + x] : 0xAAAA));
+
+    memset(destination, 0xAA, sizeof(destination));
+
+    Display_FillRectangle(destination, 5, 2, 3, DISPLAY_COLOR_MODE_RGB565, 0x1234);
+
+    for (auto y = 0; y < 4; y++)
+        for (auto x = 0; x < 8; x++)
+            HOST_CHECK(destination[y * 8 + x] == (y < 2 && x < 5 ? 0x1234 : 0xAAAA));
+
+    memset(rgb, 0xAA, sizeof(rgb));
+
+    Display_FillRectangle(rgb, 3, 2, 2, DISPLAY_COLOR_MODE_RGB888, 0x00563412);
+
+    for (auto y = 0; y < 2; y++) {
+        for (auto x = 0; x < 5; x++) {
+            auto p = rgb + (y * 5 + x) * 3;
+
+            if (x < 3)
+                HOST_CHECK(p[0] == 0x12 && p[1] == 0x34 && p[2] == 0x56);
+            else
+                HOST_CHECK(p[0] == 0xAA && p[1] == 0xAA && p[2] == 0xAA);
+        }
+    }
+
+    Display_ConvertRectangle(source, rgb, 2, 2, 4, 3, DISPLAY_COLOR_MODE_RGB565, DISPLAY_COLOR_MODE_RGB888);
+
+    for (auto y = 0; y < 2; y++)
+        for (auto x = 0; x < 2; x++)
+            HOST_CHECK(ConvertPixel(rgb[(y * 5 + x) * 3] | (rgb[(y * 5 + x) * 3 + 1] << 8) | (rgb[(y * 5 + x) * 3 + 2] << 16), DISPLAY_COLOR_MODE_RGB888, DISPLAY_COLOR_MODE_RGB565) == source[y * 6 + x]);
+}
+
+int main() {
+    srand(1);
+
+    TestConvertPixels();
+    TestRoundTrip();
+    TestBlend();
+    TestOffsets();
+
+    return Host_Finish("Display/RectangleTest");
+}
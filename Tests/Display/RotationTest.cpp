@@ -0,0 +1,134 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include "../Host/Host.h"
+#include "../../Drivers/Display/Display.h"
+
+#define MAX_SIZE 40
+#define PADDING 3
+#define GUARD 0xDEAD
+
+enum class Rotation { Cw90, Ccw90, Rotate180 };
+
+// Screen pixel a rotated source pixel lands on, the plain per pixel mapping the tiled kernels must reproduce.
+static void Reference_Map(Rotation rotation, int32_t x, int32_t y, int32_t width, int32_t height, int32_t& column, int32_t& row) {
+    switch (rotation) {
+    case Rotation::Cw90:
+        column = height - 1 - y;
+        row = x;
+        break;
+
+    case Rotation::Ccw90:
+        column = y;
+        row = width - 1 - x;
+        break;
+
+    case Rotation::Rotate180:
+        column = width - 1 - x;
+        row = height - 1 - y;
+        break;
+    }
+}
+
+static void Rotate(Rotation rotation, const uint16_t* source, int32_t sourceStride, uint16_t* destination, int32_t destinationStride, int32_t width, int32_t height) {
+    switch (rotation) {
+    case Rotation::Cw90: Display_RotateRgb565Cw90(source, sourceStride, destination, destinationStride, width, height); break;
+    case Rotation::Ccw90: Display_RotateRgb565Ccw90(source, sourceStride, destination, destinationStride, width, height); break;
+    case Rotation::Rotate180: Display_RotateRgb565180(source, sourceStride, destination, destinationStride, width, height); break;
+    }
+}
+
+// Every size up to a few tiles, odd ones included, from and to both word and half word aligned rows with padding
+// at the end of each row. The padding and the pixels around the rectangle keep their guard value.
+static void TestMapping(Rotation rotation) {
+    static uint16_t source[(MAX_SIZE + PADDING) * MAX_SIZE + 2];
+    static uint16_t destination[(MAX_SIZE + PADDING) * (MAX_SIZE + 1) + 2];
+
+    for (auto i = 0U; i < sizeof(source) / sizeof(source[0]); i++)
+        source[i] = static_cast<uint16_t>(i * 2654435761U >> 8);
+
+    for (auto width = 1; width <= MAX_SIZE; width++) {
+        for (auto height = 1; height <= MAX_SIZE; height++) {
+            auto quarter = rotation != Rotation::Rotate180;
+            auto destinationWidth = quarter ? height : width;
+            auto destinationHeight = quarter ? width : height;
+
+            for (auto alignment = 0; alignment < 4; alignment++) {
+                auto sourceStride = width + (alignment & 1);
+                auto destinationStride = destinationWidth + PADDING;
+                auto from = source + (alignment & 1);
+                auto to = destination + 1 + (alignment >> 1);
+
+                for (auto& p : destination)
+                    p = GUARD;
+
+                Rotate(rotation, from, sourceStride, to, destinationStride, width, height);
+
+                for (auto y = 0; y < height; y++) {
+                    for (auto x = 0; x < width; x++) {
+                        int32_t column, row;
+
+                        Reference_Map(rotation, x, y, width, height, column, row);
+
+                        HOST_CHECK(to[row * destinationStride + column] == from[y * sourceStride + x]);
+                    }
+                }
+
+                for (auto i = 0U; i < sizeof(destination) / sizeof(destination[0]); i++) {
+                    auto offset = static_cast<int32_t>(i) - static_cast<int32_t>(to - destination);
+                    auto inside = offset >= 0 && offset / destinationStride < destinationHeight && offset % destinationStride < destinationWidth;
+
+                    if (!inside)
+                        HOST_CHECK(destination[i] == GUARD);
+                }
+            }
+        }
+    }
+}
+
+// Rotating by 90 degrees four times, or 180 twice, or one way and back gives the source again.
+static void TestComposition() {
+    static uint16_t source[17 * 23];
+    static uint16_t a[17 * 23];
+    static uint16_t b[17 * 23];
+
+    for (auto i = 0; i < 17 * 23; i++)
+        source[i] = static_cast<uint16_t>(rand());
+
+    Display_RotateRgb565Cw90(source, 17, a, 23, 17, 23);
+    Display_RotateRgb565Ccw90(a, 23, b, 17, 23, 17);
+    HOST_CHECK(memcmp(source, b, sizeof(source)) == 0);
+
+    Display_RotateRgb565180(source, 17, a, 17, 17, 23);
+    Display_RotateRgb565180(a, 17, b, 17, 17, 23);
+    HOST_CHECK(memcmp(source, b, sizeof(source)) == 0);
+
+    Display_RotateRgb565Cw90(source, 17, a, 23, 17, 23);
+    Display_RotateRgb565Cw90(a, 23, b, 17, 23, 17);
+    Display_RotateRgb565180(b, 17, a, 17, 17, 23);
+    HOST_CHECK(memcmp(source, a, sizeof(source)) == 0);
+}
+
+int main() {
+    srand(1);
+
+    TestMapping(Rotation::Cw90);
+    TestMapping(Rotation::Ccw90);
+    TestMapping(Rotation::Rotate180);
+    TestComposition();
+
+    return Host_Finish("Display/RotationTest");
+}
@@ -0,0 +1,251 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <vector>
+#include "../Host/Host.h"
+#include "../../Drivers/Gpio/GpioDispatch.h"
+
+#define PORTS 3
+#define PINS 32
+
+// Register model of the LPC17/LPC24 GPIO interrupt block: ports 0 and 2 have rising and falling edge status, an
+// overall status with a bit per port, and a clear register. Every register access takes a tick of simulated time,
+// the latency of an edge is the time from the handler's entry to its pin being handled.
+struct Port {
+    uint32_t rising;
+    uint32_t falling;
+    uint32_t level;
+};
+
+struct Dispatched {
+    uint32_t port;
+    uint32_t pin;
+    uint64_t time;
+    uint64_t latency;
+};
+
+static Port ports[PORTS];
+static std::vector<Dispatched> dispatched;
+static void(*pinHook)(uint32_t port, uint32_t pin);
+
+static uint32_t Access(uint32_t value) {
+    Host_AdvanceSystemTime(1);
+
+    return value;
+}
+
+static uint32_t ReadOverallStatus() {
+    return Access(((ports[0].rising | ports[0].falling) != 0 ? 1 : 0) | ((ports[2].rising | ports[2].falling) != 0 ? 4 : 0));
+}
+
+static uint32_t ReadRisingStatus(uint32_t port) { return Access(ports[port].rising); }
+static uint32_t ReadFallingStatus(uint32_t port) { return Access(ports[port].falling); }
+static uint32_t ReadLevel(uint32_t port) { return Access(ports[port].level); }
+
+static void WriteClear(uint32_t port, uint32_t mask) {
+    Access(0);
+
+    ports[port].rising &= ~mask;
+    ports[port].falling &= ~mask;
+}
+
+static void Edge(uint32_t port, uint32_t pin, bool rising) {
+    if (rising) {
+        ports[port].rising |= 1u << pin;
+        ports[port].level |= 1u << pin;
+    }
+    else {
+        ports[port].falling |= 1u << pin;
+        ports[port].level &= ~(1u << pin);
+    }
+}
+
+static void PinChanged(uint32_t port, uint32_t pin, uint64_t entry, uint64_t time) {
+    ReadLevel(port); // read value as soon as possible
+
+    dispatched.push_back({ port, pin, time, Host_GetSystemTime() - entry });
+
+    if (pinHook != nullptr)
+        pinHook(port, pin);
+}
+
+// LPC24_Gpio_InterruptHandler on the model
+static void InterruptHandler() {
+    auto entry = Host_GetSystemTime();
+    auto time = entry;
+
+    for (auto port = 0U; port <= 2; port += 2) {
+        if (!(ReadOverallStatus() & (1 << port)))
+            continue;
+
+        auto pending = ReadRisingStatus(port) | ReadFallingStatus(port);
+
+        WriteClear(port, pending);
+
+        GpioDispatch_Pending(pending, [&](uint32_t pin) {
+            PinChanged(port, pin, entry, time);
+        });
+    }
+}
+
+// The handler before the bit scan: every pin tested against both status registers while the port has any pending.
+static void Reference_InterruptHandler() {
+    auto entry = Host_GetSystemTime();
+
+    for (auto port = 0U; port <= 2; port += 2) {
+        for (auto pin = 0U; (ReadOverallStatus() & (1 << port)) && pin < PINS; pin++) {
+            if (!(ReadRisingStatus(port) & (1u << pin)) && !(ReadFallingStatus(port) & (1u << pin)))
+                continue;
+
+            WriteClear(port, 1u << pin);
+
+            PinChanged(port, pin, entry, Host_GetSystemTime());
+        }
+    }
+}
+
+static void Reset() {
+    for (auto& port : ports)
+        port = Port{};
+
+    dispatched.clear();
+    pinHook = nullptr;
+}
+
+static void TestLowestSetBit() {
+    for (auto bit = 0U; bit < 32; bit++) {
+        HOST_CHECK(GpioDispatch_LowestSetBitDeBruijn(1u << bit) == bit);
+        HOST_CHECK(GpioDispatch_LowestSetBitDeBruijn(0xFFFFFFFFu << bit) == bit);
+        HOST_CHECK(GpioDispatch_LowestSetBit(1u << bit) == bit);
+    }
+
+    for (auto i = 0; i < 100000; i++) {
+        auto value = static_cast<uint32_t>(rand()) ^ (static_cast<uint32_t>(rand()) << 16);
+
+        if (value != 0)
+            HOST_CHECK(GpioDispatch_LowestSetBitDeBruijn(value) == static_cast<uint32_t>(__builtin_ctz(value)));
+    }
+}
+
+// Every pending edge once, port 0 first and lowest pin first, with the one timestamp of the handler's entry. The
+// status is clear afterwards.
+static void TestOrder() {
+    for (auto i = 0; i < 1000; i++) {
+        Reset();
+
+        std::vector<Dispatched> expected;
+
+        for (auto port = 0U; port <= 2; port += 2) {
+            for (auto pin = 0U; pin < PINS; pin++) {
+                if (rand() % 4 == 0) {
+                    Edge(port, pin, rand() % 2 == 0);
+                    expected.push_back({ port, pin, 0, 0 });
+                }
+            }
+        }
+
+        auto entry = Host_GetSystemTime();
+
+        InterruptHandler();
+
+        HOST_CHECK(dispatched.size() == expected.size());
+
+        for (auto j = 0U; j < dispatched.size() && j < expected.size(); j++) {
+            HOST_CHECK(dispatched[j].port == expected[j].port && dispatched[j].pin == expected[j].pin);
+            HOST_CHECK(dispatched[j].time == entry);
+        }
+
+        HOST_CHECK(ReadOverallStatus() == 0);
+    }
+}
+
+// All 64 edges at once, the last one waits for the status reads of both ports and the level reads of the edges
+// before it. A single edge on the highest pin no longer waits for the 31 pins below it to be tested.
+static void TestWorstCaseLatency() {
+    Reset();
+
+    for (auto port = 0U; port <= 2; port += 2)
+        for (auto pin = 0U; pin < PINS; pin++)
+            Edge(port, pin, true);
+
+    InterruptHandler();
+
+    HOST_CHECK(dispatched.size() == 2 * PINS);
+
+    for (auto i = 0U; i < dispatched.size(); i++)
+        HOST_CHECK(dispatched[i].latency == 4 * (i / PINS + 1) + i + 1);
+
+    HOST_CHECK(dispatched.back().latency == 2 * 4 + 2 * PINS);
+
+    Reset();
+    Edge(2, PINS - 1, false);
+
+    InterruptHandler();
+
+    HOST_CHECK(dispatched.size() == 1 && dispatched[0].latency == 1 + 4 + 1);
+
+    auto latency = dispatched[0].latency;
+
+    Reset();
+    Edge(2, PINS - 1, false);
+
+    Reference_InterruptHandler();
+
+    HOST_CHECK(dispatched.size() == 1 && dispatched[0].latency > 15 * latency);
+}
+
+// Edges that come while the handler runs stay pending for its next entry, on a pin already handled or one not
+// pending when the port was read.
+static void TestEdgeDuringDispatch() {
+    Reset();
+
+    pinHook = [](uint32_t port, uint32_t pin) {
+        if (port == 0 && pin == 4) {
+            Edge(0, 2, false);
+            Edge(0, 9, true);
+            Edge(2, 1, true);
+        }
+    };
+
+    Edge(0, 2, true);
+    Edge(0, 4, true);
+
+    InterruptHandler();
+
+    HOST_CHECK(dispatched.size() == 3);
+    HOST_CHECK(dispatched[0].pin == 2 && dispatched[1].pin == 4);
+    HOST_CHECK(dispatched[2].port == 2 && dispatched[2].pin == 1);
+    HOST_CHECK(ports[0].falling == (1u << 2) && ports[0].rising == (1u << 9));
+
+    pinHook = nullptr;
+    dispatched.clear();
+
+    InterruptHandler();
+
+    HOST_CHECK(dispatched.size() == 2);
+    HOST_CHECK(dispatched[0].pin == 2 && dispatched[1].pin == 9);
+    HOST_CHECK(ReadOverallStatus() == 0);
+}
+
+int main() {
+    srand(1);
+
+    TestLowestSetBit();
+    TestOrder();
+    TestWorstCaseLatency();
+    TestEdgeDuringDispatch();
+
+    return Host_Finish("Gpio/DispatchTest");
+}
@@ -0,0 +1,218 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "../Host/Host.h"
+#include "../../Drivers/DevicesInterop/Gpio/GHIElectronics_TinyCLR_Devices_Gpio_PinGroup.h"
+
+// Three ports of 16 pins. Pin 40 can't be an output, the way a target's input only pins refuse.
+#define HOST_GPIO_PINS 48
+#define HOST_GPIO_INPUT_ONLY_PIN 40
+
+static bool pinOpened[HOST_GPIO_PINS];
+static TinyCLR_Gpio_PinDriveMode pinDriveMode[HOST_GPIO_PINS];
+static uint32_t portLevels[3];
+static uint32_t portWrites;
+
+static TinyCLR_Result OpenPin(const TinyCLR_Gpio_Controller* self, uint32_t pin) {
+    if (pin >= HOST_GPIO_PINS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (pinOpened[pin])
+        return TinyCLR_Result::SharingViolation;
+
+    pinOpened[pin] = true;
+
+    return TinyCLR_Result::Success;
+}
+
+static TinyCLR_Result ClosePin(const TinyCLR_Gpio_Controller* self, uint32_t pin) {
+    pinOpened[pin] = false;
+    pinDriveMode[pin] = TinyCLR_Gpio_PinDriveMode::Input;
+
+    return TinyCLR_Result::Success;
+}
+
+static TinyCLR_Result Read(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinValue& value) {
+    value = (portLevels[pin / 16] & (1u << (pin % 16))) ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low;
+
+    return TinyCLR_Result::Success;
+}
+
+static TinyCLR_Result Write(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinValue value) {
+    if (value == TinyCLR_Gpio_PinValue::High)
+        portLevels[pin / 16] |= 1u << (pin % 16);
+    else
+        portLevels[pin / 16] &= ~(1u << (pin % 16));
+
+    return TinyCLR_Result::Success;
+}
+
+static bool IsDriveModeSupported(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinDriveMode mode) {
+    return pin != HOST_GPIO_INPUT_ONLY_PIN || mode < TinyCLR_Gpio_PinDriveMode::Output;
+}
+
+static TinyCLR_Gpio_PinDriveMode GetDriveMode(const TinyCLR_Gpio_Controller* self, uint32_t pin) {
+    return pinDriveMode[pin];
+}
+
+static TinyCLR_Result SetDriveMode(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinDriveMode mode) {
+    pinDriveMode[pin] = mode;
+
+    return TinyCLR_Result::Success;
+}
+
+static TinyCLR_Result ReadPort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t& value) {
+    value = portLevels[port] & mask;
+
+    return TinyCLR_Result::Success;
+}
+
+// The same check the targets make: every masked pin is open and an output
+static TinyCLR_Result WritePort(const TinyCLR_Gpio_Controller* self, uint32_t port, uint32_t mask, uint32_t value) {
+    for (auto bit = 0; bit < 16; bit++) {
+        auto pin = port * 16 + bit;
+
+        if ((mask & (1u << bit)) && (!pinOpened[pin] || pinDriveMode[pin] < TinyCLR_Gpio_PinDriveMode::Output))
+            return TinyCLR_Result::InvalidOperation;
+    }
+
+    portLevels[port] = (portLevels[port] & ~mask) | (value & mask);
+    portWrites++;
+
+    return TinyCLR_Result::Success;
+}
+
+static const TinyCLR_Gpio_PortApi portApi = { 16, 3, &ReadPort, &WritePort };
+
+static TinyCLR_Gpio_Controller portController;
+static TinyCLR_Gpio_Controller pinController;
+
+static void Reset() {
+    for (auto i = 0; i < HOST_GPIO_PINS; i++)
+        ClosePin(nullptr, i);
+
+    portLevels[0] = portLevels[1] = portLevels[2] = 0;
+    portWrites = 0;
+}
+
+static uint32_t OpenedCount() {
+    auto count = 0U;
+
+    for (auto i = 0; i < HOST_GPIO_PINS; i++)
+        if (pinOpened[i])
+            count++;
+
+    return count;
+}
+
+// A bus on pins 4 to 7 of the first port and two pins of the second
+static void TestWrite(const TinyCLR_Gpio_Controller* controller) {
+    static const uint32_t pins[] = { 4, 5, 6, 7, 20, 18 };
+
+    TinyCLR_Gpio_PinGroup group;
+
+    Reset();
+
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Initialize(group, controller, pins, 6, TinyCLR_Gpio_PinDriveMode::Output) == TinyCLR_Result::Success);
+    HOST_CHECK(OpenedCount() == 6);
+
+    for (auto pin : pins)
+        HOST_CHECK(pinDriveMode[pin] == TinyCLR_Gpio_PinDriveMode::Output);
+
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Write(group, 0x2B) == TinyCLR_Result::Success);
+    HOST_CHECK(portLevels[0] == 0xB0 && portLevels[1] == 0x04);
+
+    if (controller == &portController)
+        HOST_CHECK(portWrites == 2);
+
+    uint32_t value;
+
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Read(group, value) == TinyCLR_Result::Success && value == 0x2B);
+
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Uninitialize(group) == TinyCLR_Result::Success);
+    HOST_CHECK(OpenedCount() == 0);
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Write(group, 0) == TinyCLR_Result::InvalidOperation);
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Uninitialize(group) == TinyCLR_Result::InvalidOperation);
+}
+
+// Any pin that can't be opened or made an output rejects the group and leaves nothing open
+static void TestRejected() {
+    static const uint32_t pins[] = { 1, 2, 3, HOST_GPIO_INPUT_ONLY_PIN, 9 };
+
+    TinyCLR_Gpio_PinGroup group;
+
+    Reset();
+
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Initialize(group, &portController, pins, 5, TinyCLR_Gpio_PinDriveMode::Output) == TinyCLR_Result::NotSupported);
+    HOST_CHECK(OpenedCount() == 0);
+    HOST_CHECK(pinDriveMode[1] == TinyCLR_Gpio_PinDriveMode::Input);
+
+    pinOpened[3] = true;
+
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Initialize(group, &portController, pins + 2, 1, TinyCLR_Gpio_PinDriveMode::Output) == TinyCLR_Result::SharingViolation);
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Initialize(group, &portController, pins, 2, TinyCLR_Gpio_PinDriveMode::Output) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Initialize(group, &portController, pins + 1, 1, TinyCLR_Gpio_PinDriveMode::Output) == TinyCLR_Result::SharingViolation);
+
+    Reset();
+
+    pinOpened[3] = true;
+
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Initialize(group, &portController, pins, 5, TinyCLR_Gpio_PinDriveMode::OutputOpenDrain) == TinyCLR_Result::SharingViolation);
+    HOST_CHECK(OpenedCount() == 1);
+
+    Reset();
+
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Initialize(group, &portController, pins, 3, TinyCLR_Gpio_PinDriveMode::InputPullUp) == TinyCLR_Result::ArgumentInvalid);
+    HOST_CHECK(OpenedCount() == 0);
+
+    static const uint32_t twice[] = { 1, 2, 1 };
+
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Initialize(group, &portController, twice, 3, TinyCLR_Gpio_PinDriveMode::Output) == TinyCLR_Result::ArgumentInvalid);
+    HOST_CHECK(OpenedCount() == 0);
+}
+
+// A pin the group no longer drives as an output fails the port write instead of being driven
+static void TestChangedUnderneath() {
+    static const uint32_t pins[] = { 0, 1 };
+
+    TinyCLR_Gpio_PinGroup group;
+
+    Reset();
+
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Initialize(group, &portController, pins, 2, TinyCLR_Gpio_PinDriveMode::Output) == TinyCLR_Result::Success);
+
+    pinDriveMode[1] = TinyCLR_Gpio_PinDriveMode::Input;
+
+    HOST_CHECK(TinyCLR_Gpio_PinGroup_Write(group, 3) == TinyCLR_Result::InvalidOperation);
+    HOST_CHECK(portLevels[0] == 0);
+}
+
+int main() {
+    portController.OpenPin = pinController.OpenPin = &OpenPin;
+    portController.ClosePin = pinController.ClosePin = &ClosePin;
+    portController.Read = pinController.Read = &Read;
+    portController.Write = pinController.Write = &Write;
+    portController.IsDriveModeSupported = pinController.IsDriveModeSupported = &IsDriveModeSupported;
+    portController.GetDriveMode = pinController.GetDriveMode = &GetDriveMode;
+    portController.SetDriveMode = pinController.SetDriveMode = &SetDriveMode;
+
+    TinyCLR_Gpio_SetPortApi(&portController, &portApi);
+
+    TestWrite(&portController);
+    TestWrite(&pinController);
+    TestRejected();
+    TestChangedUnderneath();
+
+    return Host_Finish("Gpio/PinGroupTest");
+}
@@ -0,0 +1,71 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Stand-in for a device header on the host: the parts of a target header the shared drivers rely on.
+
+#include <TinyCLR.h>
+
+#define DEVICE_TARGET HOST
+#define DEVICE_NAME "Host"
+#define DEVICE_MEMORY_PROFILE_FACTOR 9
+
+// The interrupt profiler counts simulated system time, 16 bits wide so its test sees the counter wrap
+#define INTERRUPT_PROFILER
+#define INTERRUPT_PROFILER_VECTORS 32
+#define INTERRUPT_PROFILER_COUNTS_PER_SECOND 10000000
+#define INTERRUPT_PROFILER_COUNTER_MASK 0xFFFF
+
+struct UsbClientState;
+typedef void(*USB_NEXT_CALLBACK)(UsbClientState*);
+
+void TinyCLR_UsbClient_ClearEvent(UsbClientState *usbClientState, uint32_t event);
+void TinyCLR_UsbClient_ClearEndpoints(UsbClientState *usbClientState, int32_t endpoint);
+uint8_t* TinyCLR_UsbClient_RxEnqueue(UsbClientState* usbClientState, int32_t endpoint, bool& disableRx);
+void TinyCLR_UsbClient_RxCommit(UsbClientState* usbClientState, int32_t endpoint, uint32_t size);
+uint8_t* TinyCLR_UsbClient_TxDequeue(UsbClientState* usbClientState, int32_t endpoint, uint32_t& size);
+int32_t TinyCLR_UsbClient_TxPeek(UsbClientState* usbClientState, int32_t endpoint, int32_t index);
+uint32_t TinyCLR_UsbClient_GetTxPacketCount(UsbClientState* usbClientState, int32_t endpoint, uint32_t maxPackets, uint32_t& size);
+void TinyCLR_UsbClient_StateCallback(UsbClientState* usbClientState);
+uint8_t TinyCLR_UsbClient_ControlCallback(UsbClientState* usbClientState);
+uint8_t TinyCLR_UsbClient_ControlOutCallback(UsbClientState* usbClientState);
+bool TinyCLR_UsbClient_CanReceivePackage(UsbClientState* usbClientState, int32_t endpoint);
+bool TinyCLR_UsbClient_Initialize(UsbClientState* usbClientState);
+bool TinyCLR_UsbClient_Uninitialize(UsbClientState* usbClientState);
+
+// Interrupts are a nesting count. Each time the last scope turns them back on, the pending host
+// interrupt runs, so a test can land an ISR at every point where real hardware could take one.
+class Host_DisableInterrupts_RaiiHelper {
+    bool state;
+
+public:
+    Host_DisableInterrupts_RaiiHelper();
+    ~Host_DisableInterrupts_RaiiHelper();
+
+    bool IsDisabled();
+    void Acquire();
+    void Release();
+};
+
+class Host_InterruptStarted_RaiiHelper {
+public:
+    Host_InterruptStarted_RaiiHelper();
+    ~Host_InterruptStarted_RaiiHelper();
+};
+
+#define DISABLE_INTERRUPTS_SCOPED(name) Host_DisableInterrupts_RaiiHelper name
+#define INTERRUPT_STARTED_SCOPED(name) Host_InterruptStarted_RaiiHelper name
+
+extern const TinyCLR_Api_Manager* apiManager;
@@ -0,0 +1,170 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include "Host.h"
+
+#define HOST_MAX_APIS 8
+#define HOST_IDLE_WAIT_TICKS 10000
+
+struct Host_Api {
+    TinyCLR_Api_Type Type;
+    const void* Implementation;
+};
+
+int host_Failures;
+
+static Host_Api host_Apis[HOST_MAX_APIS];
+static bool host_AllocationEnabled = true;
+static uint64_t host_SystemTime;
+static Host_InterruptHandler host_InterruptHandler;
+static bool host_InterruptDisabled;
+static bool host_InterruptRunning;
+static bool host_Waiting;
+static bool host_WaitMasked;
+
+static void* Host_Memory_Allocate(const TinyCLR_Memory_Manager* self, size_t length) {
+    return host_AllocationEnabled ? malloc(length) : nullptr;
+}
+
+static void Host_Memory_Free(const TinyCLR_Memory_Manager* self, void* ptr) {
+    free(ptr);
+}
+
+static void Host_RunInterrupt() {
+    if (host_InterruptHandler == nullptr || host_InterruptRunning)
+        return;
+
+    auto disabled = host_InterruptDisabled;
+
+    host_InterruptRunning = true;
+    host_InterruptDisabled = true;
+
+    host_InterruptHandler();
+
+    host_InterruptDisabled = disabled;
+    host_InterruptRunning = false;
+}
+
+static void Host_Interrupt_WaitForInterrupt() {
+    if (host_InterruptHandler == nullptr)
+        host_SystemTime += HOST_IDLE_WAIT_TICKS;
+
+    host_Waiting = true;
+    host_WaitMasked = host_InterruptDisabled;
+
+    Host_RunInterrupt();
+
+    host_Waiting = false;
+}
+
+static const TinyCLR_Memory_Manager host_MemoryManager = { &Host_Memory_Allocate, &Host_Memory_Free };
+static const TinyCLR_Interrupt_Controller host_InterruptController = { nullptr, &Host_Interrupt_WaitForInterrupt };
+
+static const void* Host_Api_FindDefault(const TinyCLR_Api_Manager* self, TinyCLR_Api_Type type) {
+    for (auto i = 0; i < HOST_MAX_APIS; i++)
+        if (host_Apis[i].Implementation != nullptr && host_Apis[i].Type == type)
+            return host_Apis[i].Implementation;
+
+    switch (type) {
+    case TinyCLR_Api_Type::MemoryManager: return &host_MemoryManager;
+    case TinyCLR_Api_Type::InterruptController: return &host_InterruptController;
+    default: return nullptr;
+    }
+}
+
+static TinyCLR_Api_Manager host_ApiManager = { Host_Function(), &Host_Api_FindDefault };
+
+const TinyCLR_Api_Manager* apiManager = &host_ApiManager;
+
+int Host_Finish(const char* name) {
+    printf("%s: %s (%d failed checks)\n", name, host_Failures == 0 ? "passed" : "FAILED", host_Failures);
+
+    return host_Failures == 0 ? 0 : 1;
+}
+
+void Host_SetApi(TinyCLR_Api_Type type, const void* implementation) {
+    for (auto i = 0; i < HOST_MAX_APIS; i++) {
+        if (host_Apis[i].Implementation == nullptr || host_Apis[i].Type == type) {
+            host_Apis[i].Type = type;
+            host_Apis[i].Implementation = implementation;
+
+            return;
+        }
+    }
+}
+
+void Host_SetAllocationEnabled(bool enable) {
+    host_AllocationEnabled = enable;
+}
+
+uint64_t Host_GetSystemTime() {
+    return host_SystemTime;
+}
+
+void Host_AdvanceSystemTime(uint64_t ticks) {
+    host_SystemTime += ticks;
+}
+
+Host_InterruptHandler Host_SetInterruptHandler(Host_InterruptHandler handler) {
+    auto previous = host_InterruptHandler;
+
+    host_InterruptHandler = handler;
+
+    return previous;
+}
+
+bool Host_IsInterruptDisabled() {
+    return host_InterruptDisabled;
+}
+
+bool Host_IsWaitingForInterrupt() {
+    return host_Waiting;
+}
+
+bool Host_IsWaitMasked() {
+    return host_WaitMasked;
+}
+
+Host_DisableInterrupts_RaiiHelper::Host_DisableInterrupts_RaiiHelper() {
+    state = host_InterruptDisabled;
+    host_InterruptDisabled = true;
+}
+
+Host_DisableInterrupts_RaiiHelper::~Host_DisableInterrupts_RaiiHelper() {
+    Release();
+}
+
+bool Host_DisableInterrupts_RaiiHelper::IsDisabled() {
+    return state;
+}
+
+void Host_DisableInterrupts_RaiiHelper::Acquire() {
+    if (state) {
+        state = host_InterruptDisabled;
+        host_InterruptDisabled = true;
+    }
+}
+
+void Host_DisableInterrupts_RaiiHelper::Release() {
+    if (!state) {
+        state = true;
+        host_InterruptDisabled = false;
+
+        Host_RunInterrupt();
+    }
+}
+
+Host_InterruptStarted_RaiiHelper::Host_InterruptStarted_RaiiHelper() {}
+Host_InterruptStarted_RaiiHelper::~Host_InterruptStarted_RaiiHelper() {}
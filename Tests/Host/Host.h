@@ -0,0 +1,50 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdio.h>
+#include <TinyCLR.h>
+#include <Device.h>
+
+// Counts the failed checks of a test program, Host_Finish reports them and gives its exit code.
+extern int host_Failures;
+
+#define HOST_CHECK(condition) do { if (!(condition)) { host_Failures++; printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); } } while (0)
+
+int Host_Finish(const char* name);
+
+// apiManager finds the host memory manager and interrupt controller, plus whatever a test sets here.
+void Host_SetApi(TinyCLR_Api_Type type, const void* implementation);
+
+// Lets a test starve the drivers of heap.
+void Host_SetAllocationEnabled(bool enable);
+
+// Simulated system time, in 100 ns ticks. It only moves when a test advances it or a driver waits for
+// an interrupt with no handler set.
+uint64_t Host_GetSystemTime();
+void Host_AdvanceSystemTime(uint64_t ticks);
+
+// The handler plays the hardware: it runs with interrupts disabled each time the code under test turns
+// interrupts back on and each time it waits for an interrupt. Returns the previous handler.
+typedef void(*Host_InterruptHandler)();
+
+Host_InterruptHandler Host_SetInterruptHandler(Host_InterruptHandler handler);
+bool Host_IsInterruptDisabled();
+
+// True while the handler runs for a wait for an interrupt rather than for interrupts turned back on. A handler
+// modelling a sleep moves time on to the interrupt that ends it. Host_IsWaitMasked tells whether the code under
+// test waited with interrupts disabled, as it must to check its flag and sleep without missing the interrupt.
+bool Host_IsWaitingForInterrupt();
+bool Host_IsWaitMasked();
@@ -0,0 +1,141 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Stand-in for the TinyCLR OS core header, which ships with the core libraries rather than this
+// repository, so the shared drivers can be built for the host. It declares what the tested drivers
+// use with the SDK's layout; controller members the tests never call are Host_Function slots that
+// accept any function and do nothing when called.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define __section(x)
+
+struct Host_FunctionResult {
+    template<class T> operator T() const { return T(); }
+};
+
+struct Host_Function {
+    Host_Function() {}
+    template<class T> Host_Function(T) {}
+    template<class T> Host_Function& operator=(T) { return *this; }
+    template<class... A> Host_FunctionResult operator()(A...) const { return Host_FunctionResult(); }
+    explicit operator bool() const { return true; }
+    bool operator==(decltype(nullptr)) const { return false; }
+    bool operator!=(decltype(nullptr)) const { return true; }
+};
+
+enum class TinyCLR_Result : uint32_t { Success, ArgumentInvalid, ArgumentNull, ArgumentOutOfRange, Busy, IndexOutOfRange, InvalidOperation, NotAvailable, NotSupported, NullReference, OutOfMemory, SharingViolation, TimedOut, WrongType, NotImplemented };
+enum class TinyCLR_Api_Type : uint32_t { AdcController, CanController, DacController, DisplayController, GpioController, I2cController, InteropManager, InterruptController, MemoryManager, NativeTimeController, PowerController, PwmController, RtcController, SpiController, StorageController, SystemTimeManager, TaskManager, UartController, UsbClientController, DebuggerManager, Custom };
+enum class TinyCLR_Gpio_PinValue : uint32_t { Low, High };
+enum class TinyCLR_Gpio_PinDriveMode : uint32_t { Input, InputPullDown, InputPullUp, Output, OutputOpenDrain, OutputOpenDrainPullUp, OutputOpenSource, OutputOpenSourcePullDown };
+enum class TinyCLR_Gpio_PinChangeEdge : uint32_t { FallingEdge = 1, RisingEdge = 2 };
+enum class TinyCLR_Spi_ChipSelectType : uint32_t { None, Gpio };
+enum class TinyCLR_Spi_Mode : uint32_t { Mode0, Mode1, Mode2, Mode3 };
+enum class TinyCLR_Can_Error : uint32_t { Overrun, BufferFull, BusOff, Passive };
+enum class TinyCLR_Uart_StopBitCount : uint32_t { None, One, OnePointFive, Two };
+enum class TinyCLR_Uart_Parity : uint32_t { None, Odd, Even, Mark, Space };
+enum class TinyCLR_Uart_Handshake : uint32_t { None, RequestToSend, XOnXOff, RequestToSendXOnXOff };
+enum class TinyCLR_Uart_Error : uint32_t { Frame, Overrun, BufferFull, ReceiveParity };
+enum class TinyCLR_Pwm_PulsePolarity : uint32_t { ActiveHigh, ActiveLow };
+enum class TinyCLR_Power_Level : uint32_t { Active, Idle, Off, Sleep1, Sleep2, Sleep3, Custom };
+enum class TinyCLR_Power_WakeSource : uint64_t { Gpio = 1, Rtc = 2, SystemTimer = 4, Usb = 8 };
+enum class TinyCLR_Display_DataFormat : uint32_t { Rgb565, Rgb444, Rgb888, Argb8888, Indexed8, Gray8, Gray4, VerticalByteStrip1Bpp };
+enum class TinyCLR_Display_InterfaceType : uint32_t { Parallel, Spi, I2c };
+enum class TinyCLR_Adc_ChannelMode : uint32_t { SingleEnded, Differential };
+enum class TinyCLR_UsbClient_DeviceState : uint32_t { Detached, Attached, Powered, Default, Address, Configured, Suspended };
+
+struct TinyCLR_Api_Info { const char* Author; const char* Name; TinyCLR_Api_Type Type; uint64_t Version; const void* Implementation; void* State; };
+struct TinyCLR_Api_Manager { Host_Function Add; const void* (*FindDefault)(const TinyCLR_Api_Manager*, TinyCLR_Api_Type); };
+struct TinyCLR_Memory_Manager { void* (*Allocate)(const TinyCLR_Memory_Manager*, size_t); void (*Free)(const TinyCLR_Memory_Manager*, void*); };
+struct TinyCLR_Task_Reference;
+struct TinyCLR_Task_Manager { Host_Function CreateTask, FreeTask, Enqueue, Cancel, IsQueued; };
+struct TinyCLR_Interrupt_Controller { const TinyCLR_Api_Info* ApiInfo; void (*WaitForInterrupt)(); };
+struct TinyCLR_NativeTime_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Initialize, Uninitialize, GetNativeTime, ConvertNativeTimeToSystemTime, ConvertSystemTimeToNativeTime, SetCallback, ScheduleCallback, Wait, GetCurrentProcessorTicks, GetTimeForProcessorTicks, GetProcessorTicksForTime, SetTickCallback, SetNextTickCallbackTime, Delay, DelayNative, GetSystemTime; };
+typedef void(*TinyCLR_NativeTime_Callback)();
+typedef void(*TinyCLR_Interrupt_StartStopHandler)();
+struct TinyCLR_Power_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Initialize, Uninitialize, Reset, SetLevel, IsLevelSupported; };
+struct TinyCLR_Gpio_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Acquire, Release;
+    TinyCLR_Result (*OpenPin)(const TinyCLR_Gpio_Controller*, uint32_t);
+    TinyCLR_Result (*ClosePin)(const TinyCLR_Gpio_Controller*, uint32_t);
+    TinyCLR_Result (*Read)(const TinyCLR_Gpio_Controller*, uint32_t, TinyCLR_Gpio_PinValue&);
+    TinyCLR_Result (*Write)(const TinyCLR_Gpio_Controller*, uint32_t, TinyCLR_Gpio_PinValue);
+    bool (*IsDriveModeSupported)(const TinyCLR_Gpio_Controller*, uint32_t, TinyCLR_Gpio_PinDriveMode);
+    TinyCLR_Gpio_PinDriveMode (*GetDriveMode)(const TinyCLR_Gpio_Controller*, uint32_t);
+    TinyCLR_Result (*SetDriveMode)(const TinyCLR_Gpio_Controller*, uint32_t, TinyCLR_Gpio_PinDriveMode);
+    Host_Function GetDebounceTimeout, SetDebounceTimeout, SetPinChangedHandler, GetPinCount, TransferFeature; };
+typedef void(*TinyCLR_Gpio_PinChangedHandler)(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinChangeEdge edge, uint64_t timestamp);
+struct TinyCLR_Display_ParallelConfiguration { bool DataEnableIsFixed, DataEnablePolarity, PixelPolarity; uint32_t PixelClockRate; bool HorizontalSyncPolarity; uint32_t HorizontalSyncPulseWidth, HorizontalFrontPorch, HorizontalBackPorch; bool VerticalSyncPolarity; uint32_t VerticalSyncPulseWidth, VerticalFrontPorch, VerticalBackPorch; };
+struct TinyCLR_Display_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Acquire, Release, Enable, Disable, SetConfiguration, GetConfiguration, GetCapabilities;
+    TinyCLR_Result (*DrawBuffer)(const TinyCLR_Display_Controller*, uint32_t, uint32_t, uint32_t, uint32_t, const uint8_t*);
+    Host_Function DrawPixel, DrawString; };
+struct TinyCLR_Storage_Descriptor { bool CanReadDirect, CanWriteDirect, CanExecuteDirect, EraseBeforeWrite, Removable, RegionsContiguous, RegionsEqualSized; size_t RegionCount; const uint64_t* RegionAddresses; const size_t* RegionSizes; };
+struct TinyCLR_Storage_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Acquire, Release, Open, Close;
+    TinyCLR_Result (*Read)(const TinyCLR_Storage_Controller*, uint64_t, size_t&, uint8_t*, uint64_t);
+    TinyCLR_Result (*Write)(const TinyCLR_Storage_Controller*, uint64_t, size_t&, const uint8_t*, uint64_t);
+    Host_Function Erase, IsErased;
+    TinyCLR_Result (*GetDescriptor)(const TinyCLR_Storage_Controller*, const TinyCLR_Storage_Descriptor*&);
+    Host_Function IsPresent, SetPresenceChangedHandler; };
+struct TinyCLR_Startup_DeploymentConfiguration { size_t RegionCount; const uint64_t* RegionAddresses; const size_t* RegionSizes; };
+struct TinyCLR_Adc_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Acquire, Release, OpenChannel, CloseChannel, ReadChannel, SetChannelMode, GetChannelMode, IsChannelModeSupported, GetMinValue, GetMaxValue, GetResolutionInBits, GetChannelCount; };
+struct TinyCLR_Dac_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Acquire, Release, OpenChannel, CloseChannel, WriteValue, GetMinValue, GetMaxValue, GetResolutionInBits, GetChannelCount; };
+struct TinyCLR_Pwm_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Acquire, Release, OpenChannel, CloseChannel, EnableChannel, DisableChannel, SetPulseParameters, SetDesiredFrequency, GetMinFrequency, GetMaxFrequency, GetActualFrequency, GetChannelCount; };
+struct TinyCLR_Interop_Manager { TinyCLR_Result (*RaiseEvent)(const TinyCLR_Interop_Manager*, const char*, const char*, uint64_t, uint64_t, uint64_t, int64_t, uint64_t); };
+struct TinyCLR_Interop_ClrObjectReference { uint64_t b; }; // inline TimeSpan and DateTime ticks
+struct TinyCLR_Can_Message { uint32_t ArbitrationId; bool IsExtendedId, IsRemoteTransmissionRequest; size_t Length; uint8_t Data[8]; uint64_t Timestamp; };
+struct TinyCLR_Can_BitTiming { int32_t Propagation, Phase1, Phase2, BaudratePrescaler, SynchronizationJumpWidth; bool UseMultiBitSampling; };
+struct TinyCLR_Can_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Acquire, Release, SoftReset, WriteMessage, ReadMessage, SetBitTiming, GetMessagesToRead, GetMessagesToWrite, SetMessageReceivedHandler, SetErrorReceivedHandler, SetExplicitFilters, SetGroupFilters, ClearReadBuffer, ClearWriteBuffer, IsWritingAllowed, GetWriteErrorCount, GetReadErrorCount, GetSourceClock, GetReadBufferSize, SetReadBufferSize, GetWriteBufferSize, SetWriteBufferSize, Enable, Disable, CanWriteMessage, CanReadMessage; };
+typedef void(*TinyCLR_Can_MessageReceivedHandler)(const TinyCLR_Can_Controller* self, size_t count);
+typedef void(*TinyCLR_Can_ErrorReceivedHandler)(const TinyCLR_Can_Controller* self, TinyCLR_Can_Error error);
+struct TinyCLR_I2c_Settings;
+enum class TinyCLR_I2c_TransferStatus : uint32_t { FullTransfer, PartialTransfer, SlaveAddressNotAcknowledged, ClockStretchTimeout };
+enum class TinyCLR_I2c_AddressFormat : uint32_t { SevenBit, TenBit };
+enum class TinyCLR_I2c_BusSpeed : uint32_t { StandardMode, FastMode };
+struct TinyCLR_I2c_Settings { uint32_t SlaveAddress; TinyCLR_I2c_AddressFormat AddressFormat; TinyCLR_I2c_BusSpeed BusSpeed; };
+struct TinyCLR_I2c_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Acquire, Release, SetActiveSettings, WriteRead; };
+struct TinyCLR_Rtc_DateTime { uint32_t Year, Month, Week, DayOfYear, DayOfMonth, DayOfWeek, Hour, Minute, Second, Millisecond, Microsecond, Nanosecond; };
+struct TinyCLR_Rtc_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Acquire, Release, IsValid, GetTime, SetTime; };
+struct TinyCLR_Spi_Settings { TinyCLR_Spi_Mode Mode; uint32_t ClockFrequency, DataBitLength; TinyCLR_Spi_ChipSelectType ChipSelectType; uint32_t ChipSelectLine; uint64_t ChipSelectSetupTime, ChipSelectHoldTime; bool ChipSelectActiveState; };
+struct TinyCLR_Spi_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Acquire, Release, SetActiveSettings, Read, Write, WriteRead, TransferSequential, GetChipSelectLineCount, GetMinClockFrequency, GetMaxClockFrequency, GetSupportedDataBitLengths; };
+struct TinyCLR_Uart_Settings { uint32_t BaudRate, DataBitCount; TinyCLR_Uart_Parity Parity; TinyCLR_Uart_StopBitCount StopBitCount; TinyCLR_Uart_Handshake Handshaking; };
+struct TinyCLR_Uart_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Acquire, Release, Enable, Disable, SetActiveSettings, Flush, Read, Write, SetErrorReceivedHandler, SetDataReceivedHandler, GetClearToSendState, SetClearToSendChangedHandler, GetIsRequestToSendEnabled, SetIsRequestToSendEnabled, GetReadBufferSize, SetReadBufferSize, GetWriteBufferSize, SetWriteBufferSize, GetBytesToRead, GetBytesToWrite, ClearReadBuffer, ClearWriteBuffer; };
+typedef void(*TinyCLR_Uart_ErrorReceivedHandler)(const TinyCLR_Uart_Controller* self, TinyCLR_Uart_Error error);
+typedef void(*TinyCLR_Uart_DataReceivedHandler)(const TinyCLR_Uart_Controller* self, size_t count);
+typedef void(*TinyCLR_Uart_ClearToSendChangedHandler)(const TinyCLR_Uart_Controller* self, bool state);
+struct TinyCLR_Display_SpiConfiguration { const char* ApiName; const TinyCLR_Spi_Settings* Settings; };
+struct TinyCLR_Display_I2cConfiguration { const char* ApiName; const TinyCLR_I2c_Settings* Settings; };
+struct TinyCLR_UsbClient_Controller { const TinyCLR_Api_Info* ApiInfo; Host_Function Acquire, Release, Open, Close, Write, Read, Flush, SetDataReceivedHandler, SetDeviceStateChangedHandler, GetDeviceState, SetDeviceDescriptor, SetVendorClassRequestHandler, SetGetDescriptorHandler, GetControllerCount, GetBytesToWrite, GetBytesToRead, ClearWriteBuffer, ClearReadBuffer, SetWriteBufferSize, SetReadBufferSize, GetWriteBufferSize, GetReadBufferSize, OpenPipe, ClosePipe, WritePipe, ReadPipe, FlushPipe; };
+struct TinyCLR_Startup_UsbDebuggerConfiguration { uint16_t VendorId, ProductId; const wchar_t* Manufacturer; const wchar_t* Product; const wchar_t* SerialNumber; uint16_t Version; };
+void TinyCLR_Startup_AddHeapRegion(uint8_t*, size_t);
+void TinyCLR_Startup_SetMemoryProfile(size_t);
+void TinyCLR_Startup_SetDebuggerTransportApi(const TinyCLR_Api_Info*, const void*);
+void TinyCLR_Startup_AddDeploymentRegion(const TinyCLR_Api_Info*, const TinyCLR_Startup_DeploymentConfiguration*);
+void TinyCLR_Startup_SetDeviceInformation(const char*, const char*, uint64_t);
+void TinyCLR_Startup_SetRequiredApis(const TinyCLR_Api_Info*, const TinyCLR_Api_Info*, const TinyCLR_Api_Info*);
+void TinyCLR_Startup_Start(void(*)(const TinyCLR_Api_Manager*), bool);
+struct TinyCLR_SystemTime_Manager { Host_Function GetTime, SetTime; };
+
+struct TinyCLR_UsbClient_SetupPacket { uint8_t RequestType; uint8_t Request; uint16_t Value; uint16_t Index; uint16_t Length; };
+struct TinyCLR_UsbClient_VendorClassDescriptor { uint8_t Length; uint8_t Type; const uint8_t* Payload; };
+struct TinyCLR_UsbClient_EndpointDescriptor { uint8_t Address; uint8_t Attributes; uint16_t MaxPacketSize; uint8_t Interval; size_t VendorClassDescriptorCount; const TinyCLR_UsbClient_VendorClassDescriptor* VendorClassDescriptors; };
+struct TinyCLR_UsbClient_InterfaceDescriptor { uint8_t Number, AlternateSetting, EndpointCount, InterfaceClass, InterfaceSubClass, InterfaceProtocol, NameIndex; size_t VendorClassDescriptorCount; const TinyCLR_UsbClient_VendorClassDescriptor* VendorClassDescriptors; const TinyCLR_UsbClient_EndpointDescriptor* Endpoints; };
+struct TinyCLR_UsbClient_ConfigurationDescriptor { uint16_t TotalLength; uint8_t InterfaceCount, Number, NameIndex, Attributes, MaxPower; size_t VendorClassDescriptorCount; const TinyCLR_UsbClient_VendorClassDescriptor* VendorClassDescriptors; const TinyCLR_UsbClient_InterfaceDescriptor* Interfaces; };
+struct TinyCLR_UsbClient_StringDescriptor { uint8_t Index; uint8_t Length; const wchar_t* Data; };
+struct TinyCLR_UsbClient_DeviceDescriptor { uint16_t UsbVersion; uint8_t ClassCode, SubClassCode, ProtocolCode, MaxPacketSizeEp0; uint16_t VendorId, ProductId, DeviceVersion; uint8_t ManufacturerIndex, ProductIndex, SerialNumberIndex, ConfigurationCount; const TinyCLR_UsbClient_ConfigurationDescriptor* Configurations; size_t StringCount; const TinyCLR_UsbClient_StringDescriptor* Strings; };
+typedef void(*TinyCLR_UsbClient_DataReceivedHandler)(const TinyCLR_UsbClient_Controller* self, uint64_t timestamp);
+typedef void(*TinyCLR_UsbClient_DeviceStateChangedHandler)(const TinyCLR_UsbClient_Controller* self, TinyCLR_UsbClient_DeviceState state, uint64_t timestamp);
+typedef TinyCLR_Result(*TinyCLR_UsbClient_RequestHandler)(const TinyCLR_UsbClient_Controller* self, const TinyCLR_UsbClient_SetupPacket* setupPacket, const uint8_t*& responsePayload, size_t& responsePayloadLength, uint64_t timestamp);
@@ -0,0 +1,209 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include "../Host/Host.h"
+#include "../../Drivers/InterruptProfiler/InterruptProfiler.h"
+
+// The target hook: simulated time stands in for the cycle counter.
+uint32_t InterruptProfiler_ReadCounter() {
+    return static_cast<uint32_t>(Host_GetSystemTime());
+}
+
+static InterruptProfiler_Record Record(uint32_t vector) {
+    InterruptProfiler_Record record = {};
+
+    HOST_CHECK(InterruptProfiler_GetRecord(vector, record));
+
+    return record;
+}
+
+static void Handler(uint32_t vector, uint64_t duration) {
+    InterruptProfiler_Started(vector);
+    Host_AdvanceSystemTime(duration);
+    InterruptProfiler_Ended();
+}
+
+static void TestSingle() {
+    InterruptProfiler_Reset();
+
+    Handler(5, 100);
+    Handler(5, 40);
+
+    auto record = Record(5);
+
+    HOST_CHECK(record.Count == 2 && record.TotalDuration == 140 && record.MaxDuration == 100);
+    HOST_CHECK(Record(4).Count == 0);
+}
+
+// A preempting interrupt is charged to itself only, however deep.
+static void TestNested() {
+    InterruptProfiler_Reset();
+
+    InterruptProfiler_Started(3);
+    Host_AdvanceSystemTime(10);
+
+    InterruptProfiler_Started(7);
+    Host_AdvanceSystemTime(50);
+    Handler(9, 5);
+    InterruptProfiler_Ended();
+
+    Host_AdvanceSystemTime(20);
+    InterruptProfiler_Ended();
+
+    HOST_CHECK(Record(3).TotalDuration == 30);
+    HOST_CHECK(Record(7).TotalDuration == 50);
+    HOST_CHECK(Record(9).TotalDuration == 5);
+}
+
+// A handler that starts its own interrupt again, as a forced interrupt does, is one interrupt.
+static void TestReentered() {
+    InterruptProfiler_Reset();
+
+    InterruptProfiler_Started(4);
+    Host_AdvanceSystemTime(10);
+    InterruptProfiler_Started(4);
+    Host_AdvanceSystemTime(10);
+    InterruptProfiler_Ended();
+    Host_AdvanceSystemTime(10);
+    InterruptProfiler_Ended();
+
+    auto record = Record(4);
+
+    HOST_CHECK(record.Count == 1 && record.TotalDuration == 30);
+}
+
+static void TestCounterWrap() {
+    InterruptProfiler_Reset();
+
+    Host_AdvanceSystemTime(INTERRUPT_PROFILER_COUNTER_MASK - (Host_GetSystemTime() & INTERRUPT_PROFILER_COUNTER_MASK) - 5);
+
+    Handler(6, 32);
+
+    HOST_CHECK(Record(6).MaxDuration == 32);
+}
+
+// Past the frame stack nothing is timed, and what is timed stays paired up.
+static void TestTooDeep() {
+    InterruptProfiler_Reset();
+
+    for (auto i = 0; i < INTERRUPT_PROFILER_DEPTH + 2; i++) {
+        InterruptProfiler_Started(10 + i);
+        Host_AdvanceSystemTime(1);
+    }
+
+    for (auto i = 0; i < INTERRUPT_PROFILER_DEPTH + 2; i++)
+        InterruptProfiler_Ended();
+
+    for (auto i = 0; i < INTERRUPT_PROFILER_DEPTH; i++)
+        HOST_CHECK(Record(10 + i).Count == 1);
+
+    HOST_CHECK(Record(10 + INTERRUPT_PROFILER_DEPTH).Count == 0);
+    HOST_CHECK(Record(10).TotalDuration == 1);
+    HOST_CHECK(Record(10 + INTERRUPT_PROFILER_DEPTH - 1).TotalDuration == 3);
+
+    Handler(10, 7);
+
+    HOST_CHECK(Record(10).Count == 2 && Record(10).MaxDuration == 7);
+}
+
+// A vector past the records isn't kept, but its time still comes off the one it preempted.
+static void TestUnknownVector() {
+    InterruptProfiler_Reset();
+
+    InterruptProfiler_Started(2);
+    Handler(INTERRUPT_PROFILER_VECTORS + 1, 100);
+    Host_AdvanceSystemTime(1);
+    InterruptProfiler_Ended();
+
+    InterruptProfiler_Record record;
+
+    HOST_CHECK(!InterruptProfiler_GetRecord(INTERRUPT_PROFILER_VECTORS + 1, record));
+    HOST_CHECK(Record(2).TotalDuration == 1);
+}
+
+static void TestDisabled() {
+    InterruptProfiler_Reset();
+
+    InterruptProfiler_DisabledStarted();
+    Host_AdvanceSystemTime(100);
+    InterruptProfiler_DisabledStarted();
+    Host_AdvanceSystemTime(200);
+    InterruptProfiler_DisabledEnded();
+    InterruptProfiler_DisabledEnded();
+
+    HOST_CHECK(InterruptProfiler_GetMaxDisabledDuration() == 300);
+
+    InterruptProfiler_DisabledStarted();
+    Host_AdvanceSystemTime(50);
+    InterruptProfiler_DisabledEnded();
+
+    HOST_CHECK(InterruptProfiler_GetMaxDisabledDuration() == 300);
+
+    InterruptProfiler_Reset();
+
+    HOST_CHECK(InterruptProfiler_GetMaxDisabledDuration() == 0);
+}
+
+// Only vectors that ran get a line, times in microseconds and nanoseconds of the 100ns host counter.
+static void TestFormat() {
+    static const char report[] =
+        "vector      calls    total us  average ns      max ns\n"
+        "     3          3           7        2400        3000\n"
+        "    12          1           1        1000        1000\n"
+        "disabled max ns 4000\n";
+
+    char buffer[256];
+
+    InterruptProfiler_Reset();
+
+    Handler(3, 30);
+    Handler(12, 10);
+    Handler(3, 20);
+    Handler(3, 22);
+
+    InterruptProfiler_DisabledStarted();
+    Host_AdvanceSystemTime(40);
+    InterruptProfiler_DisabledEnded();
+
+    HOST_CHECK(InterruptProfiler_Format(buffer, sizeof(buffer)) == strlen(report));
+    HOST_CHECK(strcmp(buffer, report) == 0);
+
+    // a short buffer gets what fits, the length is still the whole report's
+    memset(buffer, 'x', sizeof(buffer));
+
+    HOST_CHECK(InterruptProfiler_Format(buffer, 10) == strlen(report));
+    HOST_CHECK(strncmp(buffer, report, 9) == 0 && buffer[9] == 0 && buffer[10] == 'x');
+    HOST_CHECK(InterruptProfiler_Format(nullptr, 0) == strlen(report));
+
+    InterruptProfiler_Reset();
+
+    HOST_CHECK(InterruptProfiler_Format(buffer, sizeof(buffer)) == strlen("vector      calls    total us  average ns      max ns\ndisabled max ns 0\n"));
+}
+
+int main() {
+    HOST_CHECK(InterruptProfiler_GetVectorCount() == INTERRUPT_PROFILER_VECTORS);
+    HOST_CHECK(InterruptProfiler_GetCountsPerSecond() == INTERRUPT_PROFILER_COUNTS_PER_SECOND);
+
+    TestSingle();
+    TestNested();
+    TestReentered();
+    TestCounterWrap();
+    TestTooDeep();
+    TestUnknownVector();
+    TestDisabled();
+    TestFormat();
+
+    return Host_Finish("InterruptProfiler/InterruptProfilerTest");
+}
@@ -0,0 +1,138 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include "../Host/Host.h"
+#include "../../Drivers/DevicesInterop/Pwm/GHIElectronics_TinyCLR_Devices_Pwm_Timing.h"
+
+#define CALLS 3000000
+#define ROUNDS 5
+
+#define PWM_MICROSECONDS 1000000
+#define PWM_NANOSECONDS 1000000000
+
+#define CLOCK_HZ 90000000
+
+// STM32F4_Pwm_GetActualFrequency before the solver, for the 1 Hz and up frequencies the benchmark asks for
+static __attribute__((noinline)) bool Baseline_Frequency(double frequency, uint32_t clock, uint32_t& prescaler, uint32_t& arr) {
+    auto scale = frequency >= 1000.0 ? PWM_NANOSECONDS : PWM_MICROSECONDS;
+    auto period = static_cast<uint32_t>((scale / frequency) + 0.5);
+    auto p = period;
+    auto pre = clock / scale;
+
+    if (pre == 0) {
+        auto mhz = clock / 1000000;
+        auto scaleMhz = scale / 1000000;
+
+        if (p > 0xFFFFFFFF / mhz) {
+            pre = mhz;
+            p /= scaleMhz;
+        }
+        else {
+            pre = 1;
+            p = p * mhz / scaleMhz;
+        }
+    }
+
+    while (p >= 0x10000) {
+        if (pre > 0x8000)
+            return false;
+
+        pre <<= 1;
+        p >>= 1;
+    }
+
+    if (p == 0 || pre == 0)
+        return false;
+
+    auto actualPeriod = scale / ((clock / pre) / p);
+    auto actual = static_cast<double>(scale / actualPeriod);
+
+    while (actualPeriod < period || actual > frequency) {
+        p++;
+        actualPeriod = scale / ((clock / pre) / p);
+
+        if (actualPeriod == 0)
+            return false;
+
+        actual = static_cast<double>(scale / actualPeriod);
+    }
+
+    prescaler = pre;
+    arr = p;
+
+    return true;
+}
+
+static __attribute__((noinline)) uint32_t Baseline_Pulse(uint32_t period, double dutyCycle) {
+    auto pulse = static_cast<uint32_t>(dutyCycle * period);
+
+    return pulse > period ? period : pulse;
+}
+
+// Best of a few rounds, the slower ones are the host doing something else.
+template<typename T> static void Measure(const char* name, T run) {
+    auto seconds = 0.0;
+
+    for (auto round = 0; round < ROUNDS; round++) {
+        auto start = std::chrono::steady_clock::now();
+
+        for (auto i = 0; i < CALLS; i++)
+            run(i);
+
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (round == 0 || elapsed < seconds)
+            seconds = elapsed;
+    }
+
+    printf("%-36s %8.1f ns/call\n", name, seconds / CALLS * 1e9);
+}
+
+int main() {
+    TinyCLR_Pwm_Counter counter = { CLOCK_HZ, 0x10000, false, 2, 0xFFFF };
+
+    // keeps the results from being optimised away
+    volatile uint32_t sum = 0;
+
+    printf("16 bit timer at %u Hz, best of %d rounds of %d calls\n", CLOCK_HZ, ROUNDS, CALLS);
+
+    Measure("Frequency and pulse baseline", [&](int32_t i) {
+        uint32_t prescaler = 0, arr = 0;
+
+        Baseline_Frequency(1 + (i * 7919U) % 1000000, CLOCK_HZ, prescaler, arr);
+
+        sum += prescaler + Baseline_Pulse(arr, 0.37 + (i & 255) / 1024.0);
+    });
+
+    Measure("Frequency and pulse", [&](int32_t i) {
+        uint32_t prescaler, period;
+
+        TinyCLR_Pwm_SolveTiming(counter, TinyCLR_Pwm_FromFrequency(1 + (i * 7919U) % 1000000), prescaler, period);
+
+        sum += prescaler + TinyCLR_Pwm_GetPulse(period, TinyCLR_Pwm_FromDutyCycle(0.37 + (i & 255) / 1024.0));
+    });
+
+    Measure("Pulse baseline", [&](int32_t i) {
+        sum += Baseline_Pulse(40000 + (i & 1023), ((i * 7919U) % 1000001) / 1e6);
+    });
+
+    Measure("Pulse", [&](int32_t i) {
+        sum += TinyCLR_Pwm_GetPulse(40000 + (i & 1023), (i * 7919U) % 1000001);
+    });
+
+    printf("checksum %08x\n", sum);
+
+    return 0;
+}
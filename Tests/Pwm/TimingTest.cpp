@@ -0,0 +1,404 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "../Host/Host.h"
+#include "../../Drivers/DevicesInterop/Pwm/GHIElectronics_TinyCLR_Devices_Pwm_Timing.h"
+
+#define PWM_MILLISECONDS 1000
+#define PWM_MICROSECONDS 1000000
+#define PWM_NANOSECONDS 1000000000
+
+#define SWEEP_MAX_HZ 2000000
+#define RANDOM_FREQUENCIES 200000
+#define RANDOM_PULSES 2000000
+
+// The double code the targets ran before the solver, kept as the reference the solver must not fall behind
+
+static void GetScaleFactor(double frequency, uint32_t& period, uint32_t& scale) {
+    if (frequency >= 1000.0) {
+        period = static_cast<uint32_t>((PWM_NANOSECONDS / frequency) + 0.5);
+        scale = PWM_NANOSECONDS;
+    }
+    else if (frequency >= 1.0) {
+        period = static_cast<uint32_t>((PWM_MICROSECONDS / frequency) + 0.5);
+        scale = PWM_MICROSECONDS;
+    }
+    else {
+        period = static_cast<uint32_t>((PWM_MILLISECONDS / frequency) + 0.5);
+        scale = PWM_MILLISECONDS;
+    }
+}
+
+// STM32F4_Pwm_GetActualFrequency, false where it gave up
+static bool OldStm32(double frequency, uint32_t clock, bool bits32, uint32_t& prescaler, uint32_t& arr) {
+    uint32_t period, scale;
+
+    GetScaleFactor(frequency, period, scale);
+
+    auto p = period;
+    auto pre = clock / scale;
+
+    if (pre == 0) {
+        auto mhz = clock / 1000000;
+        auto scaleMhz = scale / 1000000;
+
+        if (p > 0xFFFFFFFF / mhz) {
+            pre = mhz;
+            p /= scaleMhz;
+        }
+        else {
+            pre = 1;
+            p = p * mhz / scaleMhz;
+        }
+    }
+    else {
+        while (pre > 0x10000) {
+            if (p >= 0x80000000)
+                return false;
+
+            pre >>= 1;
+            p <<= 1;
+        }
+    }
+
+    if (!bits32) {
+        while (p >= 0x10000) {
+            if (pre > 0x8000)
+                return false;
+
+            pre <<= 1;
+            p >>= 1;
+        }
+    }
+
+    if (p == 0 || pre == 0)
+        return false;
+
+    auto actualPeriod = scale / ((clock / pre) / p);
+    auto actual = static_cast<double>(scale / actualPeriod);
+
+    while (actualPeriod < period || actual > frequency) {
+        p++;
+        actualPeriod = scale / ((clock / pre) / p);
+
+        if (actualPeriod == 0)
+            return false;
+
+        actual = static_cast<double>(scale / actualPeriod);
+    }
+
+    prescaler = pre;
+    arr = p;
+
+    return true;
+}
+
+// LPC17_Pwm_GetMatch and LPC24_Pwm_GetMatch, the match register ends the period at ticks + 1 counts
+static uint32_t OldLpc(double frequency, uint32_t clock) {
+    uint32_t period, scale, ns;
+
+    GetScaleFactor(frequency, period, scale);
+
+    switch (scale) {
+    case PWM_MILLISECONDS: ns = period * 1000000; break;
+    case PWM_MICROSECONDS: ns = period * 1000; break;
+    default: ns = period; break;
+    }
+
+    if (ns > 0) {
+        auto actual = static_cast<double>(1000000000 / ns);
+
+        while (actual > frequency) {
+            ns++;
+            actual = static_cast<double>(1000000000 / ns);
+        }
+    }
+
+    uint32_t ticks = static_cast<uint64_t>(clock / 1000000) * ns / 1000;
+
+    if ((ns - 3) % 10 == 0)
+        ticks++;
+
+    return ticks;
+}
+
+// AT91SAM9X35_Pwm_GetRegisters, which counted in 7.5 ns steps whatever MCK was
+static const uint32_t oldAt91Limits[] = { 503308801, 251654401, 125827200, 62913600, 31456800, 15728400, 7864200, 3932100, 1966050, 983025, 491513 };
+
+static uint32_t OldAt91Divider(uint32_t period) {
+    if (period > oldAt91Limits[0])
+        return 0;
+
+    for (auto i = 1; i < 11; i++)
+        if (period > oldAt91Limits[i])
+            return 1024 >> (i - 1);
+
+    return period >= 40 ? 1 : 0;
+}
+
+static double OldAt91MaxPeriod(uint32_t divider) {
+    for (auto i = 0; i < 11; i++)
+        if (divider == 1024U >> i)
+            return oldAt91Limits[i];
+
+    return oldAt91Limits[10];
+}
+
+static bool OldAt91(double frequency, uint32_t mck, uint32_t& divider, uint32_t& cprd) {
+    uint32_t period, scale, cp;
+
+    GetScaleFactor(frequency, period, scale);
+
+    switch (scale) {
+    case PWM_MILLISECONDS: cp = period * 1000000; break;
+    case PWM_MICROSECONDS: cp = period * 1000; break;
+    default: cp = period; break;
+    }
+
+    divider = OldAt91Divider(cp);
+
+    if (divider == 0)
+        return false;
+
+    auto step = divider * 7.6;
+    auto p = static_cast<double>(cp);
+    auto actual = mck / (p / step);
+
+    if (p > 0 && actual > frequency) {
+        while (actual > frequency) {
+            p += step;
+
+            if (p >= OldAt91MaxPeriod(divider))
+                break;
+
+            actual = mck / (p / step);
+        }
+
+        cp = static_cast<uint32_t>(p);
+    }
+
+    cprd = static_cast<uint32_t>(cp / (divider * 7.5));
+
+    return cprd > 0;
+}
+
+// Where the reference made a frequency, the solver's must be at least as near the request
+struct Comparison {
+    const char* Name;
+    long Worse;
+    long OutOfRange;
+};
+
+static void Compare(Comparison& comparison, double requested, bool oldMade, double oldActual, double newActual) {
+    if (!oldMade)
+        return;
+
+    auto oldError = fabs(oldActual - requested);
+    auto newError = fabs(newActual - requested);
+
+    if (newError > oldError * (1 + 1e-12) + requested * 1e-15) {
+        if (comparison.Worse++ < 5)
+            printf("%s: %.3f Hz made %.6f Hz, was %.6f Hz\n", comparison.Name, requested, newActual, oldActual);
+    }
+}
+
+static double Solve(const TinyCLR_Pwm_Counter& counter, double frequency, uint32_t& prescaler, uint32_t& period) {
+    TinyCLR_Pwm_SolveTiming(counter, TinyCLR_Pwm_FromFrequency(frequency), prescaler, period);
+
+    return static_cast<double>(counter.ClockHz) / (static_cast<double>(prescaler) * period);
+}
+
+static bool InRange(const TinyCLR_Pwm_Counter& counter, uint32_t prescaler, uint32_t period) {
+    if (prescaler < 1 || prescaler > counter.MaxPrescaler || period < counter.MinPeriod || period > counter.MaxPeriod)
+        return false;
+
+    return !counter.PowerOfTwoPrescaler || (prescaler & (prescaler - 1)) == 0;
+}
+
+// Every whole frequency up to SWEEP_MAX_HZ, then random ones in millihertz up to maxHz
+template<typename T> static void Sweep(uint32_t maxHz, T check) {
+    auto top = maxHz < SWEEP_MAX_HZ ? maxHz : SWEEP_MAX_HZ;
+
+    for (auto f = 1U; f <= top; f++)
+        check(static_cast<double>(f));
+
+    srand(1);
+
+    for (auto i = 0; i < RANDOM_FREQUENCIES; i++)
+        check(floor((1.0 + static_cast<double>(rand()) / RAND_MAX * (maxHz - 1.0)) * 1000) / 1000);
+}
+
+static void Finish(const Comparison& comparison) {
+    HOST_CHECK(comparison.Worse == 0);
+    HOST_CHECK(comparison.OutOfRange == 0);
+}
+
+// Any prescaler up to 65536, 16 bit ARR or 32 bit on TIM2 and TIM5
+static void TestStm32() {
+    static const uint32_t clocks[] = { 84000000, 90000000, 108000000, 180000000, 216000000 };
+
+    for (auto clock : clocks) {
+        for (auto bits32 = 0; bits32 < 2; bits32++) {
+            TinyCLR_Pwm_Counter counter = { clock, 0x10000, false, 2, bits32 ? 0xFFFFFFFF : 0xFFFF };
+            Comparison comparison = { "STM32", 0, 0 };
+
+            Sweep(clock / 2, [&](double f) {
+                uint32_t oldPrescaler, oldArr, prescaler, period;
+
+                auto oldMade = OldStm32(f, clock, bits32, oldPrescaler, oldArr);
+                auto actual = Solve(counter, f, prescaler, period);
+
+                if (!InRange(counter, prescaler, period))
+                    comparison.OutOfRange++;
+
+                // the old code wrote the period itself to ARR, the output ran one count longer
+                Compare(comparison, f, oldMade, oldMade ? clock / (static_cast<double>(oldPrescaler) * (oldArr + 1.0)) : 0, actual);
+            });
+
+            Finish(comparison);
+        }
+    }
+}
+
+// No prescaler and a 32 bit match register
+static void TestLpc() {
+    static const uint32_t clocks[] = { 18000000, 60000000 };
+
+    for (auto clock : clocks) {
+        TinyCLR_Pwm_Counter counter = { clock, 1, false, 2, 0xFFFFFFFF };
+        Comparison comparison = { "LPC", 0, 0 };
+
+        Sweep(clock / 4, [&](double f) {
+            uint32_t prescaler, period;
+
+            auto ticks = OldLpc(f, clock);
+            auto actual = Solve(counter, f, prescaler, period);
+
+            if (!InRange(counter, prescaler, period))
+                comparison.OutOfRange++;
+
+            Compare(comparison, f, ticks > 0, clock / (ticks + 1.0), actual);
+        });
+
+        Finish(comparison);
+    }
+}
+
+// Power of two dividers up to 1024 and a 16 bit CPRD
+static void TestAt91() {
+    static const uint32_t clocks[] = { 100000000, 133333333 };
+
+    for (auto mck : clocks) {
+        TinyCLR_Pwm_Counter counter = { mck, 1024, true, 5, 0xFFFF };
+        Comparison comparison = { "AT91", 0, 0 };
+
+        Sweep(25000000, [&](double f) {
+            uint32_t divider, cprd, prescaler, period;
+
+            auto oldMade = OldAt91(f, mck, divider, cprd) && cprd <= 0xFFFF;
+            auto actual = Solve(counter, f, prescaler, period);
+
+            if (!InRange(counter, prescaler, period))
+                comparison.OutOfRange++;
+
+            Compare(comparison, f, oldMade, oldMade ? mck / (static_cast<double>(divider) * cprd) : 0, actual);
+        });
+
+        Finish(comparison);
+    }
+}
+
+// Every duty cycle on periods at the edges of the arithmetic, then random pairs, against the exact product.
+// Through FromDutyCycle a double duty cycle lands at most one count from the old double product.
+static void TestPulse() {
+    static const uint32_t periods[] = { 1, 2, 3, 5, 7, 10, 99, 100, 255, 256, 999, 1000, 4095, 4096, 65535, 65536, 99999, 1000000, 1000001, 16777215, 123456789, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFE, 0xFFFFFFFF };
+
+    long wrong = 0;
+    long apart = 0;
+
+    for (auto period : periods) {
+        for (auto ppm = 0U; ppm <= TINYCLR_PWM_DUTY_CYCLE_SCALE; ppm++) {
+            if (TinyCLR_Pwm_GetPulse(period, ppm) != static_cast<uint64_t>(period) * ppm / TINYCLR_PWM_DUTY_CYCLE_SCALE)
+                wrong++;
+
+            auto dutyCycle = ppm / 1e6;
+            auto old = static_cast<uint32_t>(dutyCycle * period);
+
+            if (old > period)
+                old = period;
+
+            auto pulse = TinyCLR_Pwm_GetPulse(period, TinyCLR_Pwm_FromDutyCycle(dutyCycle));
+
+            if (llabs(static_cast<int64_t>(pulse) - old) > 1)
+                apart++;
+        }
+    }
+
+    srand(2);
+
+    for (auto i = 0; i < RANDOM_PULSES; i++) {
+        auto period = (static_cast<uint32_t>(rand()) << 16) ^ static_cast<uint32_t>(rand());
+        auto ppm = static_cast<uint32_t>(rand()) % (TINYCLR_PWM_DUTY_CYCLE_SCALE + 1);
+
+        if (TinyCLR_Pwm_GetPulse(period, ppm) != static_cast<uint64_t>(period) * ppm / TINYCLR_PWM_DUTY_CYCLE_SCALE)
+            wrong++;
+    }
+
+    HOST_CHECK(wrong == 0);
+    HOST_CHECK(apart == 0);
+}
+
+// Requests beyond the counter get its shortest or longest period
+static void TestLimits() {
+    TinyCLR_Pwm_Counter counter = { 90000000, 0x10000, false, 2, 0xFFFF };
+    uint32_t prescaler, period;
+
+    TinyCLR_Pwm_SolveTiming(counter, TinyCLR_Pwm_FromFrequency(90000000.0), prescaler, period);
+
+    HOST_CHECK(prescaler == 1 && period == 2);
+
+    TinyCLR_Pwm_SolveTiming(counter, TinyCLR_Pwm_FromFrequency(0.001), prescaler, period);
+
+    HOST_CHECK(prescaler == 0x10000 && period == 0xFFFF);
+
+    TinyCLR_Pwm_SolveTiming(counter, 0, prescaler, period);
+
+    HOST_CHECK(prescaler == 0x10000 && period == 0xFFFF);
+
+    // 1 kHz divides the clock, the smallest prescaler with the period in range is exact
+    TinyCLR_Pwm_SolveTiming(counter, TinyCLR_Pwm_FromFrequency(1000.0), prescaler, period);
+
+    HOST_CHECK(prescaler == 2 && period == 45000);
+    HOST_CHECK(TinyCLR_Pwm_GetFrequency(counter, prescaler, period) == 1000000);
+
+    // AT91 dividers stay powers of two
+    TinyCLR_Pwm_Counter at91 = { 100000000, 1000, true, 5, 0xFFFF };
+
+    TinyCLR_Pwm_SolveTiming(at91, TinyCLR_Pwm_FromFrequency(0.001), prescaler, period);
+
+    HOST_CHECK(prescaler == 512 && period == 0xFFFF);
+}
+
+int main() {
+    TestLimits();
+    TestPulse();
+    TestStm32();
+    TestLpc();
+    TestAt91();
+
+    return Host_Finish("Pwm/TimingTest");
+}
@@ -0,0 +1,111 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../Host/Host.h"
+#include "../../Drivers/DevicesInterop/Signals/GHIElectronics_TinyCLR_Devices_Signals_Capture.h"
+
+// Timer clocks of the targets with a capture backend
+static const uint32_t clocks[] = { 1000000, 18000000, 30000000, 60000000, 84000000, 90000000, 108000000, 120000000, 132000000, 180000000, 216000000 };
+
+// The counter, at clock / divider, doesn't wrap within the timeout and a smaller divider would let it.
+static void TestDivider() {
+    static const uint64_t timeouts[] = { 0, 1, 9, 10, 10000, 655350, 655360, 10000000, 600000000, 36000000000ULL, 0xFFFFFFFFULL * 10 - 10 };
+
+    for (auto clock : clocks) {
+        for (auto bits : { 16U, 24U, 32U }) {
+            for (auto timeout : timeouts) {
+                auto divider = TinyCLR_Signals_GetCaptureDivider(timeout, clock, bits);
+                auto ticks = (timeout / 10 + 1) * clock / 1000000;
+
+                HOST_CHECK(divider >= 1);
+                HOST_CHECK(ticks / divider < (1ULL << bits));
+                HOST_CHECK(divider == 1 || ticks / (divider - 1) >= (1ULL << bits));
+            }
+        }
+    }
+
+    // a second at 180 MHz: 2747 wraps of a 16 bit counter, none of a 32 bit one
+    HOST_CHECK(TinyCLR_Signals_GetCaptureDivider(10000000, 180000000, 16) == 2747);
+    HOST_CHECK(TinyCLR_Signals_GetCaptureDivider(10000000, 180000000, 32) == 1);
+
+    // timeouts past what the microsecond count holds, and counters no timer has
+    HOST_CHECK(TinyCLR_Signals_GetCaptureDivider(0xFFFFFFFFULL * 10, 180000000, 16) == 0);
+    HOST_CHECK(TinyCLR_Signals_GetCaptureDivider(0xFFFFFFFFFFFFFFFFULL, 180000000, 32) == 0);
+    HOST_CHECK(TinyCLR_Signals_GetCaptureDivider(10000000, 180000000, 0) == 0);
+    HOST_CHECK(TinyCLR_Signals_GetCaptureDivider(10000000, 180000000, 33) == 0);
+}
+
+// Timestamps stored the way Start leaves them, 32 bit words at the front of the TimeSpan array, come out as the
+// durations between them in 100ns units, the skipped edges starting the first one.
+static void Widen(const std::vector<uint32_t>& timestamps, int32_t skip, uint64_t frequency) {
+    std::vector<TinyCLR_Interop_ClrObjectReference> arr(timestamps.size() + 4);
+
+    for (auto& entry : arr)
+        entry.b = 0xA5A5A5A5A5A5A5A5ULL;
+
+    memcpy(arr.data(), timestamps.data(), timestamps.size() * sizeof(uint32_t));
+
+    auto count = static_cast<int32_t>(timestamps.size()) - skip;
+
+    TinyCLR_Signals_WidenCaptureTimestamps(arr.data(), count, skip, frequency);
+
+    for (auto i = 0; i < count; i++) {
+        uint32_t start = i + skip > 0 ? timestamps[i + skip - 1] : 0;
+
+        HOST_CHECK(arr[i].b == static_cast<uint64_t>(timestamps[i + skip] - start) * 10000000 / frequency);
+    }
+
+    for (auto i = timestamps.size(); i < arr.size(); i++)
+        HOST_CHECK(arr[i].b == 0xA5A5A5A5A5A5A5A5ULL);
+}
+
+static void TestWiden() {
+    Widen({ 100, 250, 251, 1000 }, 0, 10000000);
+    Widen({ 100, 250, 251, 1000 }, 1, 10000000);
+
+    // the entry at count - 1 overlaps the timestamps of entries 2 * count - 2 and 2 * count - 1, the back ones first
+    Widen({ 7 }, 0, 180000000);
+    Widen({ 7, 9 }, 1, 180000000);
+
+    // a 32 bit counter running past zero between two edges
+    Widen({ 0xFFFFFF00, 0x00000010, 0x00000100 }, 0, 90000000);
+
+    for (auto i = 0; i < 1000; i++) {
+        std::vector<uint32_t> timestamps(1 + rand() % 200);
+        uint32_t counter = static_cast<uint32_t>(rand()) * 2;
+
+        for (auto& timestamp : timestamps)
+            timestamp = counter += static_cast<uint32_t>(rand()) % 100000;
+
+        auto skip = timestamps.size() > 1 ? rand() % 2 : 0;
+
+        Widen(timestamps, skip, clocks[rand() % (sizeof(clocks) / sizeof(clocks[0]))] / (1 + rand() % 3000));
+    }
+
+    // nothing captured leaves the array alone
+    Widen({ 42 }, 1, 1000000);
+}
+
+int main() {
+    srand(1);
+
+    TestDivider();
+    TestWiden();
+
+    return Host_Finish("Signals/CaptureTest");
+}
@@ -0,0 +1,167 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <vector>
+
+#include "../Host/Host.h"
+#include "../../Drivers/DevicesInterop/Signals/GHIElectronics_TinyCLR_Devices_Signals_Generator.h"
+
+// Compiles durations in system time units twice, counting then filling, and checks both passes agree
+static std::vector<uint32_t> Compile(const std::vector<uint64_t>& durations, TinyCLR_Gpio_PinValue idleState, uint32_t carrierFrequency, uint32_t clock, uint32_t counterBits, uint32_t& divider) {
+    std::vector<TinyCLR_Interop_ClrObjectReference> arr;
+
+    for (auto duration : durations)
+        arr.push_back({ duration });
+
+    auto count = TinyCLR_Signals_CompileEdges(arr.data(), arr.size(), idleState, carrierFrequency, clock, counterBits, divider, nullptr);
+
+    std::vector<uint32_t> edges(count);
+
+    if (count > 0) {
+        uint32_t fillDivider;
+
+        HOST_CHECK(TinyCLR_Signals_CompileEdges(arr.data(), arr.size(), idleState, carrierFrequency, clock, counterBits, fillDivider, edges.data()) == count);
+        HOST_CHECK(fillDivider == divider);
+    }
+
+    return edges;
+}
+
+static bool IsIncreasing(const std::vector<uint32_t>& edges) {
+    for (size_t i = 1; i < edges.size(); i++)
+        if (edges[i] <= edges[i - 1])
+            return false;
+
+    return true;
+}
+
+static void TestPlain() {
+    uint32_t divider;
+
+    // 1 MHz counter: each edge one tick after its boundary, the last one back to idle
+    auto edges = Compile({ 100, 200, 300 }, TinyCLR_Gpio_PinValue::Low, 0, 1000000, 32, divider);
+
+    HOST_CHECK(divider == 1 && edges.size() == 4);
+    HOST_CHECK(edges.size() == 4 && edges[0] == 1 && edges[1] == 11 && edges[2] == 31 && edges[3] == 61);
+
+    // an even count already ends at idle, there is no closing edge
+    edges = Compile({ 100, 200 }, TinyCLR_Gpio_PinValue::High, 0, 1000000, 32, divider);
+
+    HOST_CHECK(edges.size() == 2 && edges[0] == 1 && edges[1] == 11);
+
+    // a second at 84 MHz needs a divider on a 16 bit counter
+    edges = Compile({ 5000000, 5000000 }, TinyCLR_Gpio_PinValue::Low, 0, 84000000, 16, divider);
+
+    HOST_CHECK(divider == 84000000 / 65535 + 1);
+    HOST_CHECK(!edges.empty() && edges.back() < 65536 && IsIncreasing(edges));
+
+    // two edges in one tick can't be timed, the software loop takes those
+    edges = Compile({ 1, 1, 1 }, TinyCLR_Gpio_PinValue::Low, 0, 1000000, 32, divider);
+
+    HOST_CHECK(edges.empty());
+}
+
+// Random tables stay increasing, within the counter and end where the durations add up to
+static void TestRandom() {
+    uint32_t divider;
+
+    srand(1);
+
+    for (auto t = 0; t < 2000; t++) {
+        std::vector<uint64_t> durations;
+
+        auto count = 1 + rand() % 40;
+
+        for (auto i = 0; i < count; i++)
+            durations.push_back(1 + rand() % 200000);
+
+        auto counterBits = (rand() & 1) ? 16U : 32U;
+        auto clock = 1000000U + rand() % 200000000;
+        auto edges = Compile(durations, (rand() & 1) ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low, 0, clock, counterBits, divider);
+
+        if (edges.empty())
+            continue;
+
+        HOST_CHECK(edges.size() == static_cast<size_t>(count + (count & 1)));
+        HOST_CHECK(IsIncreasing(edges));
+        HOST_CHECK(edges.back() <= (counterBits == 32 ? 0xFFFFFFFFULL : 0xFFFFULL));
+
+        uint64_t total = 0;
+
+        for (auto duration : durations)
+            total += duration;
+
+        if (!(count & 1))
+            total -= durations.back();
+
+        auto expected = static_cast<double>(total) * clock / divider / 1e7 + 1;
+
+        HOST_CHECK(edges.back() >= expected - 1 && edges.back() <= expected + 1);
+    }
+}
+
+static void TestCarrier() {
+    uint32_t divider;
+
+    // a 560 us mark at 38 kHz holds 42 whole half periods, each placed from the start of the mark
+    auto edges = Compile({ 5600, 5600 }, TinyCLR_Gpio_PinValue::Low, 38000, 1000000, 32, divider);
+
+    HOST_CHECK(edges.size() == 42);
+
+    for (size_t k = 1; k < edges.size(); k++) {
+        auto expected = 1 + k * 1e6 / 76000.0;
+
+        HOST_CHECK(edges[k] >= expected - 1 && edges[k] <= expected + 1);
+    }
+
+    // idle High starts the mark High too, so the first edge is the carrier's first fall
+    edges = Compile({ 5600, 5600 }, TinyCLR_Gpio_PinValue::High, 38000, 1000000, 32, divider);
+
+    HOST_CHECK(!edges.empty() && edges[0] == static_cast<uint32_t>(1 + (1e6 / 76000.0 + 0.5)));
+}
+
+static void TestEdgeTable() {
+    static TinyCLR_Signals_GeneratorApi generatorApi;
+
+    auto controller = reinterpret_cast<const TinyCLR_Gpio_Controller*>(0x1000);
+    auto other = reinterpret_cast<const TinyCLR_Gpio_Controller*>(0x2000);
+
+    HOST_CHECK(TinyCLR_Signals_SetGeneratorApi(controller, &generatorApi));
+    HOST_CHECK(TinyCLR_Signals_GetGeneratorApi(controller) == &generatorApi);
+
+    // the table is kept while it is big enough and grown when it isn't
+    auto edges = TinyCLR_Signals_GetGeneratorEdges(controller, 10);
+
+    HOST_CHECK(edges != nullptr && TinyCLR_Signals_GetGeneratorEdges(controller, 5) == edges);
+    HOST_CHECK(TinyCLR_Signals_GetGeneratorEdges(controller, 100) != nullptr);
+
+    Host_SetAllocationEnabled(false);
+
+    HOST_CHECK(TinyCLR_Signals_GetGeneratorEdges(controller, 1000) == nullptr);
+    HOST_CHECK(TinyCLR_Signals_GetGeneratorEdges(controller, 1) == nullptr);
+
+    Host_SetAllocationEnabled(true);
+
+    HOST_CHECK(TinyCLR_Signals_GetGeneratorEdges(other, 1) == nullptr);
+}
+
+int main() {
+    TestPlain();
+    TestRandom();
+    TestCarrier();
+    TestEdgeTable();
+
+    return Host_Finish("Signals/GeneratorTest");
+}
@@ -0,0 +1,135 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include "../Host/Host.h"
+#include "../../Drivers/Time/TicklessIdle.h"
+
+// STM32F4_Power_GetWakeupCounts: RTCCLK / 16 wakeup timer with a 16 bit reload, 2ms latency, 5ms minimum idle
+#define WAKEUP_CLOCK_HZ (32768 / 16)
+#define WAKEUP_MAX_COUNTS 0x10000
+#define WAKEUP_LATENCY (2 * 10000)
+#define MINIMUM_IDLE (5 * 10000)
+
+// 4096Hz RTC subseconds, as STM32F4_Rtc_Initialize sets them for a tickless idle
+#define SUBSECONDS_PER_SECOND 4096
+#define SUBSECOND_TICKS (TICKLESS_IDLE_TICKS_PER_SECOND / SUBSECONDS_PER_SECOND)
+#define TICKS_PER_DAY (static_cast<uint64_t>(TICKLESS_IDLE_SECONDS_PER_DAY) * TICKLESS_IDLE_TICKS_PER_SECOND)
+
+static uint32_t GetWakeupCounts(uint64_t idleTime) {
+    return TicklessIdle_GetWakeupCounts(idleTime, WAKEUP_CLOCK_HZ, WAKEUP_MAX_COUNTS, WAKEUP_LATENCY, MINIMUM_IDLE);
+}
+
+// The time of day the RTC shows at a real time, in subseconds.
+static uint32_t ReadRtc(uint64_t time) {
+    return static_cast<uint32_t>(time % TICKS_PER_DAY * SUBSECONDS_PER_SECOND / TICKLESS_IDLE_TICKS_PER_SECOND);
+}
+
+static void TestWakeupCounts() {
+    HOST_CHECK(GetWakeupCounts(0) == 0);
+    HOST_CHECK(GetWakeupCounts(WAKEUP_LATENCY) == 0);
+    HOST_CHECK(GetWakeupCounts(MINIMUM_IDLE - 1) == 0);
+
+    // the shortest period that stops leaves at least a count after the latency
+    HOST_CHECK(GetWakeupCounts(MINIMUM_IDLE) == (MINIMUM_IDLE - WAKEUP_LATENCY) * WAKEUP_CLOCK_HZ / TICKLESS_IDLE_TICKS_PER_SECOND);
+    HOST_CHECK(GetWakeupCounts(MINIMUM_IDLE) > 0);
+
+    // the longest the reload counts, and no more however long the idle period
+    auto longest = static_cast<uint64_t>(WAKEUP_MAX_COUNTS) * TICKLESS_IDLE_TICKS_PER_SECOND / WAKEUP_CLOCK_HZ + WAKEUP_LATENCY;
+
+    HOST_CHECK(GetWakeupCounts(longest) == WAKEUP_MAX_COUNTS);
+    HOST_CHECK(GetWakeupCounts(longest - 1) == WAKEUP_MAX_COUNTS - 1);
+    HOST_CHECK(GetWakeupCounts(longest * 1000) == WAKEUP_MAX_COUNTS);
+    HOST_CHECK(GetWakeupCounts(0xFFFFFFFFFFFFFFFFull) == WAKEUP_MAX_COUNTS);
+
+    // the timer never runs into the latency
+    for (auto i = 0; i < 100000; i++) {
+        auto idleTime = static_cast<uint64_t>(rand()) % (longest * 2);
+        auto counts = GetWakeupCounts(idleTime);
+
+        HOST_CHECK(counts <= WAKEUP_MAX_COUNTS);
+        HOST_CHECK(static_cast<uint64_t>(counts) * TICKLESS_IDLE_TICKS_PER_SECOND / WAKEUP_CLOCK_HZ + WAKEUP_LATENCY <= idleTime || counts == 0);
+        HOST_CHECK((counts == 0) == (idleTime < MINIMUM_IDLE));
+    }
+}
+
+static void TestElapsedTime() {
+    auto lastSubsecond = TICKLESS_IDLE_SECONDS_PER_DAY * SUBSECONDS_PER_SECOND - 1;
+
+    HOST_CHECK(TicklessIdle_GetElapsedTime(100, 100, SUBSECONDS_PER_SECOND) == 0);
+    HOST_CHECK(TicklessIdle_GetElapsedTime(100, 100 + SUBSECONDS_PER_SECOND, SUBSECONDS_PER_SECOND) == TICKLESS_IDLE_TICKS_PER_SECOND);
+    HOST_CHECK(TicklessIdle_GetElapsedTime(lastSubsecond, 0, SUBSECONDS_PER_SECOND) == TICKLESS_IDLE_TICKS_PER_SECOND / SUBSECONDS_PER_SECOND);
+    HOST_CHECK(TicklessIdle_GetElapsedTime(lastSubsecond - 1, 3, SUBSECONDS_PER_SECOND) == 5ull * TICKLESS_IDLE_TICKS_PER_SECOND / SUBSECONDS_PER_SECOND);
+
+    // the prescaler without a tickless idle, 256Hz subseconds
+    HOST_CHECK(TicklessIdle_GetElapsedTime(TICKLESS_IDLE_SECONDS_PER_DAY * 256 - 256, 256, 256) == 2ull * TICKLESS_IDLE_TICKS_PER_SECOND);
+}
+
+// Idle periods of every length, stopped one after the other from shortly before midnight. The timer wakes the core
+// within its last count, the RTC readings before and after move native time forward. Each stop moves native time
+// less than a subsecond away from the time that passed, and the core is up again before the next event.
+static void TestIdle() {
+    auto time = TICKS_PER_DAY - 30ull * TICKLESS_IDLE_TICKS_PER_SECOND + 12345;
+    auto nativeTime = time;
+    auto period = TICKLESS_IDLE_TICKS_PER_SECOND / WAKEUP_CLOCK_HZ;
+    auto stops = 0;
+    auto wrapped = false;
+
+    for (auto i = 0; i < 20000; i++) {
+        auto next = nativeTime + static_cast<uint64_t>(rand()) % (45ull * TICKLESS_IDLE_TICKS_PER_SECOND);
+
+        while (true) {
+            auto counts = GetWakeupCounts(next > nativeTime ? next - nativeTime : 0);
+
+            if (counts == 0)
+                break;
+
+            auto slept = counts * period - static_cast<uint64_t>(rand()) % period;
+            auto start = ReadRtc(time);
+            auto before = nativeTime;
+
+            wrapped |= (time % TICKS_PER_DAY) + slept >= TICKS_PER_DAY;
+            time += slept;
+            nativeTime += TicklessIdle_GetElapsedTime(start, ReadRtc(time), SUBSECONDS_PER_SECOND);
+            stops++;
+
+            HOST_CHECK(nativeTime - before + SUBSECOND_TICKS > slept && nativeTime - before < slept + SUBSECOND_TICKS);
+
+            // the clocks take the latency to come back
+            HOST_CHECK(before + slept + WAKEUP_LATENCY <= next);
+
+            time += WAKEUP_LATENCY;
+            nativeTime += WAKEUP_LATENCY;
+        }
+
+        // the rest of the period only sleeps
+        if (next > nativeTime) {
+            time += next - nativeTime;
+            nativeTime = next;
+        }
+    }
+
+    HOST_CHECK(stops > 10000);
+    HOST_CHECK(wrapped);
+}
+
+int main() {
+    srand(1);
+
+    TestWakeupCounts();
+    TestElapsedTime();
+    TestIdle();
+
+    return Host_Finish("Time/TicklessIdleTest");
+}
@@ -0,0 +1,94 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include "../Host/Host.h"
+#include "../../Drivers/Time/TimeDivider.h"
+
+#define CALLS 3000000
+#define ROUNDS 5
+
+// Ticks to time divisors of the targets: 180 MHz STM32F4, 216 MHz STM32F7, 120 MHz LPC17 against 10 MHz time
+static constexpr TimeDivider dividers[] = { TimeDivider_Create(18), TimeDivider_Create(27), TimeDivider_Create(12) };
+
+// What a 32 bit ARM without a 64 bit divider calls for a division: a library routine that shifts and subtracts
+// one quotient bit at a time. The host has a hardware divider, so its own division is shown for reference only.
+static __attribute__((noinline)) uint64_t Baseline_ShiftSubtract(uint64_t value, uint64_t divisor) {
+    uint64_t quotient = 0;
+    uint64_t remainder = 0;
+
+    for (auto bit = 63; bit >= 0; bit--) {
+        remainder = (remainder << 1) | ((value >> bit) & 1);
+
+        if (remainder >= divisor) {
+            remainder -= divisor;
+            quotient |= 1ull << bit;
+        }
+    }
+
+    return quotient;
+}
+
+static __attribute__((noinline)) uint64_t Baseline_Host(uint64_t value, uint64_t divisor) {
+    return value / divisor;
+}
+
+static __attribute__((noinline)) uint64_t Divide(uint64_t value, const TimeDivider& divider) {
+    return TimeDivider_Divide(value, divider);
+}
+
+// Best of a few rounds, the slower ones are the host doing something else.
+template<typename T> static void Measure(const char* name, T run) {
+    auto seconds = 0.0;
+
+    for (auto round = 0; round < ROUNDS; round++) {
+        auto start = std::chrono::steady_clock::now();
+
+        for (auto i = 0; i < CALLS; i++)
+            run(i);
+
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (round == 0 || elapsed < seconds)
+            seconds = elapsed;
+    }
+
+    printf("%-36s %8.1f ns/call\n", name, seconds / CALLS * 1e9);
+}
+
+int main() {
+    // keeps the results from being optimised away
+    volatile uint64_t sum = 0;
+
+    // tick counts some minutes after start
+    auto Dividend = [](int32_t i) { return 0x2540BE4000ull + i * 7919ull; };
+
+    printf("64 bit ticks to time, divisors 18, 27 and 12, best of %d rounds of %d calls\n", ROUNDS, CALLS);
+
+    Measure("Shift and subtract baseline", [&](int32_t i) {
+        sum += Baseline_ShiftSubtract(Dividend(i), dividers[i % 3].divisor);
+    });
+
+    Measure("Host division (reference)", [&](int32_t i) {
+        sum += Baseline_Host(Dividend(i), dividers[i % 3].divisor);
+    });
+
+    Measure("Time divider", [&](int32_t i) {
+        sum += Divide(Dividend(i), dividers[i % 3]);
+    });
+
+    printf("checksum %016llx\n", static_cast<unsigned long long>(sum));
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include "../Host/Host.h"
+#include "../../Drivers/Time/TimeDivider.h"
+
+// The clock ratios the targets divide by, the power of two and 65 bit multiplier cases among them, and the
+// largest divisor allowed.
+static const uint64_t divisors[] = { 1, 2, 3, 7, 10, 60, 64, 125, 500, 1000, 3125, 500000, 1000000, 1875000, 3000000, 3750000, 0xFFFFFFFF };
+
+static uint64_t Random64() {
+    return (static_cast<uint64_t>(rand()) << 62) ^ (static_cast<uint64_t>(rand()) << 31) ^ static_cast<uint64_t>(rand());
+}
+
+static void TestDivisor(const TimeDivider& divider) {
+    auto d = divider.divisor;
+    const uint64_t edges[] = { 0, 1, d - 1, d, d + 1, 0xFFFFFFFF, 0x100000000ull, 0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFFFFFFFFFFull - d, 0xFFFFFFFFFFFFFFFFull / d * d, 0xFFFFFFFFFFFFFFFFull / d * d - 1 };
+
+    for (auto value : edges)
+        HOST_CHECK(TimeDivider_Divide(value, divider) == value / d);
+
+    // around multiples of the divisor, where a reciprocal that is a little off shows first
+    for (auto i = 0; i < 100000; i++) {
+        auto value = Random64() / d * d;
+
+        HOST_CHECK(TimeDivider_Divide(value, divider) == value / d);
+        HOST_CHECK(value == 0 || TimeDivider_Divide(value - 1, divider) == (value - 1) / d);
+
+        value = Random64() >> (rand() % 64);
+
+        HOST_CHECK(TimeDivider_Divide(value, divider) == value / d);
+    }
+}
+
+int main() {
+    for (auto d : divisors)
+        TestDivisor(TimeDivider_Create(d));
+
+    // the factors come out of the compiler
+    static constexpr TimeDivider ten = TimeDivider_Create(10);
+
+    TestDivisor(ten);
+
+    return Host_Finish("Time/TimeDividerTest");
+}
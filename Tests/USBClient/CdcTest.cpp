@@ -0,0 +1,452 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include <vector>
+#include "UsbClientHost.h"
+#include "../../Drivers/USBClient/USBCdc.h"
+
+#define PACKET_SIZE 64
+#define CONTROL_PACKET_SIZE 8
+
+static const TinyCLR_UsbClient_Controller* usbClientController;
+static UsbClientState* usbClientState;
+
+static uint32_t lineStateChanges;
+
+static uint32_t vendorRequests;
+static TinyCLR_UsbClient_SetupPacket vendorSetup;
+static std::vector<uint8_t> vendorData;
+static const uint8_t vendorPayload[] = { 'v', 'e', 'n', 'd', 'o', 'r' };
+
+static void LineStateChanged(const TinyCLR_UsbClient_Controller* self, uint64_t timestamp) {
+    lineStateChanges++;
+}
+
+// The managed handler: takes every request that reaches it and answers IN requests with vendorPayload.
+static TinyCLR_Result VendorRequest(const TinyCLR_UsbClient_Controller* self, const TinyCLR_UsbClient_SetupPacket* setupPacket, const uint8_t*& responsePayload, size_t& responsePayloadLength, uint64_t timestamp) {
+    vendorRequests++;
+    vendorSetup = *setupPacket;
+    vendorData.assign(usbClientState->controlOutData, usbClientState->controlOutData + ((setupPacket->RequestType & USB_REQUEST_TYPE_IN) ? 0 : setupPacket->Length));
+
+    responsePayload = vendorPayload;
+    responsePayloadLength = sizeof(vendorPayload);
+
+    return TinyCLR_Result::Success;
+}
+
+// A setup packet on endpoint 0, returning the state the control callback left and any data stage for the host.
+static uint8_t Control(const uint8_t (&setup)[8], std::vector<uint8_t>& data) {
+    uint8_t packet[PACKET_SIZE];
+
+    memcpy(usbClientState->controlEndpointBuffer, setup, sizeof(setup));
+
+    usbClientState->ptrData = usbClientState->controlEndpointBuffer;
+    usbClientState->dataSize = sizeof(setup);
+
+    auto result = TinyCLR_UsbClient_ControlCallback(usbClientState);
+
+    data.clear();
+
+    for (auto packets = 0; result == USB_STATE_DATA && usbClientState->dataCallback != nullptr && packets < 64; packets++) {
+        usbClientState->ptrData = packet;
+        usbClientState->dataCallback(usbClientState);
+
+        data.insert(data.end(), packet, packet + usbClientState->dataSize);
+    }
+
+    return result;
+}
+
+// A control write: the setup packet, then the data stage in packets of the given sizes. Returns the state the
+// last callback left.
+static uint8_t ControlOut(const uint8_t (&setup)[8], const uint8_t* data, const std::vector<size_t>& packets) {
+    std::vector<uint8_t> none;
+    uint8_t packet[PACKET_SIZE];
+
+    auto result = Control(setup, none);
+
+    for (auto size : packets) {
+        if (result != USB_STATE_DONE)
+            break;
+
+        memcpy(packet, data, size);
+
+        usbClientState->ptrData = packet;
+        usbClientState->dataSize = size;
+
+        result = TinyCLR_UsbClient_ControlOutCallback(usbClientState);
+
+        data += size;
+    }
+
+    return result;
+}
+
+// Acquire through SET_CONFIGURATION: the descriptor chain a host needs to bind its serial driver.
+static void TestDescriptors() {
+    static const TinyCLR_UsbCdc_DeviceInfo deviceInfo = { 0x1B9F, 0x5002, 0x0102, L"GHI Electronics", L"Telemetry", nullptr };
+
+    std::vector<uint8_t> data;
+
+    HOST_CHECK(TinyCLR_UsbCdc_Acquire(usbClientController, &deviceInfo) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_UsbCdc_Acquire(usbClientController, &deviceInfo) == TinyCLR_Result::SharingViolation);
+
+    usbClientState->deviceState = USB_DEVICE_STATE_ADDRESS;
+
+    const uint8_t getDevice[8] = { 0x80, 6, 0, 1, 0, 0, 0xFF, 0 };
+
+    HOST_CHECK(Control(getDevice, data) == USB_STATE_DATA && data.size() == 18);
+
+    if (data.size() == 18) {
+        HOST_CHECK(data[0] == 18 && data[1] == USB_DEVICE_DESCRIPTOR_TYPE && data[2] == 0x00 && data[3] == 0x02);
+        HOST_CHECK(data[4] == USB_CDC_COMMUNICATION_INTERFACE_CLASS && data[5] == 0 && data[6] == 0 && data[7] == PACKET_SIZE);
+        HOST_CHECK(data[8] == 0x9F && data[9] == 0x1B && data[10] == 0x02 && data[11] == 0x50 && data[12] == 0x02 && data[13] == 0x01);
+        HOST_CHECK(data[14] == 1 && data[15] == 2 && data[16] == 0 && data[17] == 1);
+    }
+
+    const uint8_t getConfiguration[8] = { 0x80, 6, 0, 2, 0, 0, 0xFF, 0 };
+
+    HOST_CHECK(Control(getConfiguration, data) == USB_STATE_DATA);
+
+    // length, type and subtype of each descriptor in the order the host walks them
+    const uint8_t chain[][3] = {
+        { 9, USB_CONFIGURATION_DESCRIPTOR_TYPE, 0 },
+        { 9, USB_INTERFACE_DESCRIPTOR_TYPE, 0 },
+        { 5, USB_CDC_CS_INTERFACE_DESCRIPTOR_TYPE, USB_CDC_HEADER_FUNCTIONAL_DESCRIPTOR },
+        { 5, USB_CDC_CS_INTERFACE_DESCRIPTOR_TYPE, USB_CDC_CALL_MANAGEMENT_FUNCTIONAL_DESCRIPTOR },
+        { 4, USB_CDC_CS_INTERFACE_DESCRIPTOR_TYPE, USB_CDC_ACM_FUNCTIONAL_DESCRIPTOR },
+        { 5, USB_CDC_CS_INTERFACE_DESCRIPTOR_TYPE, USB_CDC_UNION_FUNCTIONAL_DESCRIPTOR },
+        { 7, USB_ENDPOINT_DESCRIPTOR_TYPE, 0 },
+        { 9, USB_INTERFACE_DESCRIPTOR_TYPE, 0 },
+        { 7, USB_ENDPOINT_DESCRIPTOR_TYPE, 0 },
+        { 7, USB_ENDPOINT_DESCRIPTOR_TYPE, 0 },
+    };
+
+    size_t offsets[sizeof(chain) / sizeof(chain[0])];
+    size_t offset = 0;
+
+    for (auto i = 0U; i < sizeof(chain) / sizeof(chain[0]); i++) {
+        offsets[i] = offset;
+
+        HOST_CHECK(offset + chain[i][0] <= data.size());
+
+        if (offset + chain[i][0] > data.size())
+            return;
+
+        HOST_CHECK(data[offset] == chain[i][0] && data[offset + 1] == chain[i][1]);
+
+        if (chain[i][1] == USB_CDC_CS_INTERFACE_DESCRIPTOR_TYPE)
+            HOST_CHECK(data[offset + 2] == chain[i][2]);
+
+        offset += data[offset];
+    }
+
+    HOST_CHECK(offset == data.size() && data[2] == offset && data[3] == 0);
+
+    auto configuration = &data[offsets[0]];
+    auto communication = &data[offsets[1]];
+    auto header = &data[offsets[2]];
+    auto callManagement = &data[offsets[3]];
+    auto acm = &data[offsets[4]];
+    auto unionDescriptor = &data[offsets[5]];
+    auto notification = &data[offsets[6]];
+    auto dataInterface = &data[offsets[7]];
+    auto dataIn = &data[offsets[8]];
+    auto dataOut = &data[offsets[9]];
+
+    HOST_CHECK(configuration[4] == 2 && configuration[5] == 1);
+    HOST_CHECK(communication[2] == 0 && communication[4] == 1);
+    HOST_CHECK(communication[5] == USB_CDC_COMMUNICATION_INTERFACE_CLASS && communication[6] == USB_CDC_ABSTRACT_CONTROL_MODEL);
+    HOST_CHECK(header[3] == 0x10 && header[4] == 0x01);
+    HOST_CHECK(callManagement[4] == 1);
+    HOST_CHECK(acm[3] == 0x02);
+    HOST_CHECK(unionDescriptor[3] == 0 && unionDescriptor[4] == 1);
+    HOST_CHECK(notification[2] == (0x80 | USB_CDC_NOTIFICATION_ENDPOINT) && notification[3] == 3 && notification[6] == 16);
+    HOST_CHECK(dataInterface[2] == 1 && dataInterface[4] == 2 && dataInterface[5] == USB_CDC_DATA_INTERFACE_CLASS);
+    HOST_CHECK(dataIn[2] == (0x80 | USB_CDC_DATA_IN_ENDPOINT) && dataIn[3] == 2 && dataIn[4] == PACKET_SIZE);
+    HOST_CHECK(dataOut[2] == USB_CDC_DATA_OUT_ENDPOINT && dataOut[3] == 2 && dataOut[4] == PACKET_SIZE);
+
+    // the host reads the first nine bytes for the total length first
+    const uint8_t getConfigurationHeader[8] = { 0x80, 6, 0, 2, 0, 0, 9, 0 };
+
+    HOST_CHECK(Control(getConfigurationHeader, data) == USB_STATE_DATA && data.size() == 9 && data[2] == offset);
+
+    // no serial number string, the product string is there
+    const uint8_t getProduct[8] = { 0x80, 6, 2, 3, 0x09, 0x04, 0xFF, 0 };
+    const uint8_t getSerial[8] = { 0x80, 6, 3, 3, 0x09, 0x04, 0xFF, 0 };
+
+    HOST_CHECK(Control(getProduct, data) == USB_STATE_DATA && data.size() == 2 + 9 * 2 && data[0] == data.size() && data[1] == USB_STRING_DESCRIPTOR_TYPE);
+    HOST_CHECK(Control(getSerial, data) == USB_STATE_STALL);
+
+    const uint8_t setConfiguration[8] = { 0x00, 9, 1, 0, 0, 0, 0, 0 };
+
+    HOST_CHECK(Control(setConfiguration, data) == USB_STATE_CONFIGURATION);
+    HOST_CHECK(usbClientState->deviceState == USB_DEVICE_STATE_CONFIGURED);
+}
+
+static void TestLineCoding() {
+    TinyCLR_UsbCdc_LineCoding lineCoding;
+    std::vector<uint8_t> data;
+
+    HOST_CHECK(TinyCLR_UsbCdc_SetLineStateChangedHandler(usbClientController, &LineStateChanged) == TinyCLR_Result::Success);
+
+    // 115200 8N1 until the host sets something else
+    HOST_CHECK(TinyCLR_UsbCdc_GetLineCoding(usbClientController, lineCoding) == TinyCLR_Result::Success);
+    HOST_CHECK(lineCoding.BaudRate == 115200 && lineCoding.StopBits == 0 && lineCoding.Parity == 0 && lineCoding.DataBits == 8);
+
+    const uint8_t getLineCoding[8] = { 0xA1, USB_CDC_GET_LINE_CODING, 0, 0, 0, 0, USB_CDC_LINE_CODING_SIZE, 0 };
+
+    HOST_CHECK(Control(getLineCoding, data) == USB_STATE_DATA);
+    HOST_CHECK(data == std::vector<uint8_t>({ 0x00, 0xC2, 0x01, 0x00, 0x00, 0x00, 0x08 }));
+
+    // 3 Mbaud, 2 stop bits, even parity, 7 data bits
+    const uint8_t setLineCoding[8] = { 0x21, USB_CDC_SET_LINE_CODING, 0, 0, 0, 0, USB_CDC_LINE_CODING_SIZE, 0 };
+    const uint8_t coding[USB_CDC_LINE_CODING_SIZE] = { 0xC0, 0xC6, 0x2D, 0x00, 0x02, 0x02, 0x07 };
+
+    HOST_CHECK(ControlOut(setLineCoding, coding, { USB_CDC_LINE_CODING_SIZE }) == USB_STATE_DATA);
+    HOST_CHECK(usbClientState->residualCount == 0 && usbClientState->expected == 0);
+    HOST_CHECK(lineStateChanges == 1);
+
+    HOST_CHECK(TinyCLR_UsbCdc_GetLineCoding(usbClientController, lineCoding) == TinyCLR_Result::Success);
+    HOST_CHECK(lineCoding.BaudRate == 3000000 && lineCoding.StopBits == 2 && lineCoding.Parity == 2 && lineCoding.DataBits == 7);
+
+    HOST_CHECK(Control(getLineCoding, data) == USB_STATE_DATA && data == std::vector<uint8_t>(coding, coding + USB_CDC_LINE_CODING_SIZE));
+    HOST_CHECK(lineStateChanges == 1);
+
+    // a short data stage is not a line coding
+    HOST_CHECK(ControlOut(setLineCoding, coding, { 4 }) == USB_STATE_STALL);
+    HOST_CHECK(lineStateChanges == 1);
+
+    // only DTR and RTS are kept
+    const uint8_t setControlLineState[8] = { 0x21, USB_CDC_SET_CONTROL_LINE_STATE, 0xFF, 0xFF, 0, 0, 0, 0 };
+    const uint8_t clearControlLineState[8] = { 0x21, USB_CDC_SET_CONTROL_LINE_STATE, 0, 0, 0, 0, 0, 0 };
+
+    HOST_CHECK(Control(setControlLineState, data) == USB_STATE_DATA && data.empty());
+    HOST_CHECK(TinyCLR_UsbCdc_GetControlLineState(usbClientController) == (USB_CDC_CONTROL_LINE_DTR | USB_CDC_CONTROL_LINE_RTS));
+    HOST_CHECK(lineStateChanges == 2);
+
+    HOST_CHECK(Control(clearControlLineState, data) == USB_STATE_DATA);
+    HOST_CHECK(TinyCLR_UsbCdc_GetControlLineState(usbClientController) == 0);
+    HOST_CHECK(lineStateChanges == 3);
+
+    const uint8_t sendBreak[8] = { 0x21, USB_CDC_SEND_BREAK, 0xFF, 0xFF, 0, 0, 0, 0 };
+
+    HOST_CHECK(Control(sendBreak, data) == USB_STATE_DATA);
+    HOST_CHECK(lineStateChanges == 3 && vendorRequests == 0);
+}
+
+// With 8 byte control packets a data stage takes several, the request is handled once the last one arrived.
+static void TestControlOutData() {
+    uint8_t payload[USB_CONTROL_OUT_DATA_SIZE + 1];
+    std::vector<uint8_t> data;
+
+    for (auto i = 0U; i < sizeof(payload); i++)
+        payload[i] = static_cast<uint8_t>(i * 13 + 1);
+
+    usbClientState->maxEndpointsPacketSize[0] = CONTROL_PACKET_SIZE;
+
+    const uint8_t vendorOut[8] = { 0x40, 0x55, 0x34, 0x12, 0, 0, 20, 0 };
+
+    vendorRequests = 0;
+
+    HOST_CHECK(ControlOut(vendorOut, payload, { 8, 8 }) == USB_STATE_DONE);
+    HOST_CHECK(vendorRequests == 0);
+
+    HOST_CHECK(ControlOut(vendorOut, payload, { 8, 8, 4 }) == USB_STATE_DATA);
+    HOST_CHECK(vendorRequests == 1 && vendorSetup.Request == 0x55 && vendorSetup.Value == 0x1234 && vendorSetup.Length == 20);
+    HOST_CHECK(vendorData == std::vector<uint8_t>(payload, payload + 20));
+
+    // exactly as long as the buffer, in full packets only
+    const uint8_t vendorOutLargest[8] = { 0x40, 0x56, 0, 0, 0, 0, USB_CONTROL_OUT_DATA_SIZE, 0 };
+
+    HOST_CHECK(ControlOut(vendorOutLargest, payload, std::vector<size_t>(USB_CONTROL_OUT_DATA_SIZE / CONTROL_PACKET_SIZE, CONTROL_PACKET_SIZE)) == USB_STATE_DATA);
+    HOST_CHECK(vendorRequests == 2 && vendorData == std::vector<uint8_t>(payload, payload + USB_CONTROL_OUT_DATA_SIZE));
+
+    // a short packet before the end, a stage larger than the buffer and data without a setup packet are stalled
+    HOST_CHECK(ControlOut(vendorOut, payload, { 8, 4 }) == USB_STATE_STALL);
+
+    const uint8_t vendorOutTooLong[8] = { 0x40, 0x57, 0, 0, 0, 0, USB_CONTROL_OUT_DATA_SIZE + 1, 0 };
+
+    HOST_CHECK(Control(vendorOutTooLong, data) == USB_STATE_STALL);
+
+    usbClientState->ptrData = payload;
+    usbClientState->dataSize = CONTROL_PACKET_SIZE;
+
+    HOST_CHECK(TinyCLR_UsbClient_ControlOutCallback(usbClientState) == USB_STATE_STALL);
+    HOST_CHECK(vendorRequests == 2);
+
+    // a new setup packet drops a data stage the host gave up on
+    const uint8_t getLineCoding[8] = { 0xA1, USB_CDC_GET_LINE_CODING, 0, 0, 0, 0, USB_CDC_LINE_CODING_SIZE, 0 };
+
+    HOST_CHECK(ControlOut(vendorOut, payload, { 8 }) == USB_STATE_DONE);
+    HOST_CHECK(Control(getLineCoding, data) == USB_STATE_DATA && data.size() == USB_CDC_LINE_CODING_SIZE);
+    HOST_CHECK(TinyCLR_UsbClient_ControlOutCallback(usbClientState) == USB_STATE_STALL);
+
+    // the line coding in one short packet of an 8 byte endpoint
+    const uint8_t setLineCoding[8] = { 0x21, USB_CDC_SET_LINE_CODING, 0, 0, 0, 0, USB_CDC_LINE_CODING_SIZE, 0 };
+    const uint8_t coding[USB_CDC_LINE_CODING_SIZE] = { 0x80, 0x25, 0x00, 0x00, 0x00, 0x00, 0x08 };
+    TinyCLR_UsbCdc_LineCoding lineCoding;
+
+    HOST_CHECK(ControlOut(setLineCoding, coding, { USB_CDC_LINE_CODING_SIZE }) == USB_STATE_DATA);
+    HOST_CHECK(TinyCLR_UsbCdc_GetLineCoding(usbClientController, lineCoding) == TinyCLR_Result::Success && lineCoding.BaudRate == 9600);
+    HOST_CHECK(vendorRequests == 2);
+
+    usbClientState->maxEndpointsPacketSize[0] = PACKET_SIZE;
+}
+
+// The request type decides who answers: class requests to the communication interface go to the function, vendor
+// requests and class requests it doesn't know go on to the managed handler, whatever their request code.
+static void TestRouting() {
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> vendor(vendorPayload, vendorPayload + sizeof(vendorPayload));
+
+    const uint8_t getLineCoding[8] = { 0xA1, USB_CDC_GET_LINE_CODING, 0, 0, 0, 0, USB_CDC_LINE_CODING_SIZE, 0 };
+    const uint8_t vendorGetLineCoding[8] = { 0xC1, USB_CDC_GET_LINE_CODING, 0, 0, 0, 0, USB_CDC_LINE_CODING_SIZE, 0 };
+    const uint8_t vendorDevice[8] = { 0xC0, USB_CDC_GET_LINE_CODING, 0, 0, 0, 0, 0x40, 0 };
+    const uint8_t dataInterface[8] = { 0xA1, USB_CDC_GET_LINE_CODING, 0, 0, 1, 0, USB_CDC_LINE_CODING_SIZE, 0 };
+    const uint8_t unknownClass[8] = { 0xA1, 0x30, 0, 0, 0, 0, 0x40, 0 };
+    const uint8_t vendorNoData[8] = { 0x41, USB_CDC_SET_CONTROL_LINE_STATE, 3, 0, 0, 0, 0, 0 };
+
+    vendorRequests = 0;
+
+    HOST_CHECK(Control(getLineCoding, data) == USB_STATE_DATA && data.size() == USB_CDC_LINE_CODING_SIZE && data != vendor);
+    HOST_CHECK(vendorRequests == 0);
+
+    HOST_CHECK(Control(vendorGetLineCoding, data) == USB_STATE_DATA && data == std::vector<uint8_t>(vendor.begin(), vendor.end()));
+    HOST_CHECK(vendorRequests == 1 && vendorSetup.RequestType == 0xC1);
+
+    HOST_CHECK(Control(vendorDevice, data) == USB_STATE_DATA && data == vendor);
+    HOST_CHECK(Control(dataInterface, data) == USB_STATE_DATA && data == vendor);
+    HOST_CHECK(Control(unknownClass, data) == USB_STATE_DATA && data == vendor);
+    HOST_CHECK(vendorRequests == 4);
+
+    // a vendor request with the SET_CONTROL_LINE_STATE code leaves the lines alone
+    HOST_CHECK(Control(vendorNoData, data) == USB_STATE_DATA && data.empty());
+    HOST_CHECK(vendorRequests == 5 && TinyCLR_UsbCdc_GetControlLineState(usbClientController) == 0);
+
+    // nobody else to ask: requests for data are stalled, requests without any are acknowledged
+    TinyCLR_UsbClient_SetVendorClassRequestHandler(usbClientController, nullptr);
+
+    HOST_CHECK(Control(vendorGetLineCoding, data) == USB_STATE_STALL);
+    HOST_CHECK(Control(unknownClass, data) == USB_STATE_STALL);
+    HOST_CHECK(Control(vendorNoData, data) == USB_STATE_DATA);
+    HOST_CHECK(Control(getLineCoding, data) == USB_STATE_DATA && data.size() == USB_CDC_LINE_CODING_SIZE);
+    HOST_CHECK(vendorRequests == 5);
+
+    TinyCLR_UsbClient_SetVendorClassRequestHandler(usbClientController, &VendorRequest);
+}
+
+static void TestSerialState() {
+    uint32_t size;
+
+    HOST_CHECK(TinyCLR_UsbCdc_SetSerialState(usbClientController, USB_CDC_SERIAL_STATE_DCD | USB_CDC_SERIAL_STATE_DSR) == TinyCLR_Result::Success);
+
+    auto packet = TinyCLR_UsbClient_TxDequeue(usbClientState, USB_CDC_NOTIFICATION_ENDPOINT, size);
+
+    HOST_CHECK(packet != nullptr && size == 10);
+
+    if (packet != nullptr && size == 10) {
+        const uint8_t expected[10] = { 0xA1, USB_CDC_SERIAL_STATE_NOTIFICATION, 0, 0, 0, 0, 2, 0, 0x03, 0x00 };
+
+        HOST_CHECK(memcmp(packet, expected, sizeof(expected)) == 0);
+    }
+
+    HOST_CHECK(TinyCLR_UsbClient_TxDequeue(usbClientState, USB_CDC_NOTIFICATION_ENDPOINT, size) == nullptr);
+
+    // one notification per packet; once the ring can't take another whole one the change is refused, not cut
+    auto queued = 0;
+
+    while (TinyCLR_UsbCdc_SetSerialState(usbClientController, USB_CDC_SERIAL_STATE_OVERRUN | queued) == TinyCLR_Result::Success && queued < 100)
+        queued++;
+
+    HOST_CHECK(queued == PACKET_SIZE / 10);
+
+    for (auto i = 0; i < queued; i++) {
+        packet = TinyCLR_UsbClient_TxDequeue(usbClientState, USB_CDC_NOTIFICATION_ENDPOINT, size);
+
+        HOST_CHECK(packet != nullptr && size == 10 && packet[8] == (USB_CDC_SERIAL_STATE_OVERRUN | i) && packet[9] == 0);
+    }
+
+    HOST_CHECK(TinyCLR_UsbClient_TxDequeue(usbClientState, USB_CDC_NOTIFICATION_ENDPOINT, size) == nullptr);
+
+    // before the host configured the device there is nobody to tell
+    usbClientState->deviceState = USB_DEVICE_STATE_ADDRESS;
+
+    HOST_CHECK(TinyCLR_UsbCdc_SetSerialState(usbClientController, USB_CDC_SERIAL_STATE_RING) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_UsbClient_TxDequeue(usbClientState, USB_CDC_NOTIFICATION_ENDPOINT, size) == nullptr);
+
+    usbClientState->deviceState = USB_DEVICE_STATE_CONFIGURED;
+}
+
+// The bulk pipe carries the serial data both ways.
+static void TestData() {
+    uint8_t written[100];
+    uint8_t read[100];
+    uint32_t size;
+
+    for (auto i = 0U; i < sizeof(written); i++)
+        written[i] = static_cast<uint8_t>(i * 7 + 3);
+
+    size_t length = sizeof(written);
+
+    HOST_CHECK(TinyCLR_UsbCdc_Write(usbClientController, written, length) == TinyCLR_Result::Success && length == sizeof(written));
+
+    auto packet = TinyCLR_UsbClient_TxDequeue(usbClientState, USB_CDC_DATA_IN_ENDPOINT, size);
+
+    HOST_CHECK(packet != nullptr && size == PACKET_SIZE && memcmp(packet, written, PACKET_SIZE) == 0);
+
+    packet = TinyCLR_UsbClient_TxDequeue(usbClientState, USB_CDC_DATA_IN_ENDPOINT, size);
+
+    HOST_CHECK(packet != nullptr && size == sizeof(written) - PACKET_SIZE && memcmp(packet, written + PACKET_SIZE, size) == 0);
+
+    bool disableRx;
+    auto received = TinyCLR_UsbClient_RxEnqueue(usbClientState, USB_CDC_DATA_OUT_ENDPOINT, disableRx);
+
+    HOST_CHECK(received != nullptr);
+
+    if (received != nullptr) {
+        memcpy(received, written, 40);
+
+        TinyCLR_UsbClient_RxCommit(usbClientState, USB_CDC_DATA_OUT_ENDPOINT, 40);
+    }
+
+    length = sizeof(read);
+
+    HOST_CHECK(TinyCLR_UsbCdc_Read(usbClientController, read, length) == TinyCLR_Result::Success && length == 40 && memcmp(read, written, 40) == 0);
+}
+
+static void TestRelease() {
+    HOST_CHECK(TinyCLR_UsbCdc_Release(usbClientController) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_UsbCdc_Release(usbClientController) == TinyCLR_Result::InvalidOperation);
+    HOST_CHECK(TinyCLR_UsbCdc_SetSerialState(usbClientController, 0) == TinyCLR_Result::InvalidOperation);
+    HOST_CHECK(usbClientState->classRequestHandler == nullptr);
+}
+
+int main() {
+    usbClientController = reinterpret_cast<const TinyCLR_UsbClient_Controller*>(TinyCLR_UsbClient_GetRequiredApi()->Implementation);
+    usbClientState = reinterpret_cast<UsbClientState*>(usbClientController->ApiInfo->State);
+
+    TinyCLR_UsbClient_SetVendorClassRequestHandler(usbClientController, &VendorRequest);
+
+    TestDescriptors();
+    TestLineCoding();
+    TestControlOutData();
+    TestRouting();
+    TestSerialState();
+    TestData();
+    TestRelease();
+
+    return Host_Finish("USBClient/CdcTest");
+}
@@ -0,0 +1,261 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include <vector>
+#include "UsbClientHost.h"
+
+#define PACKET_SIZE 64
+
+static const TinyCLR_UsbClient_Controller* usbClientController;
+static UsbClientState* usbClientState;
+
+// GET_DESCRIPTOR as it was answered before the descriptors were serialized at acquire: each request built its
+// descriptor field by field and looked strings up in order, the first with the index won. Returns false where the
+// request was stalled.
+static bool Reference_GetDescriptor(const TinyCLR_UsbClient_DeviceDescriptor* device, uint8_t type, uint8_t index, uint16_t expected, std::vector<uint8_t>& data) {
+    uint8_t buffer[USB_ENDPOINT_CONTROL_BUFFER_SIZE];
+    size_t size = 0;
+
+    data.clear();
+
+    switch (type) {
+    case USB_DEVICE_DESCRIPTOR_TYPE:
+        buffer[0] = 2 + USB_DEVICE_DESCRIPTOR_STRUCTURE_SIZE;
+        buffer[1] = USB_DEVICE_DESCRIPTOR_TYPE;
+
+        memcpy(&buffer[2], device, USB_DEVICE_DESCRIPTOR_STRUCTURE_SIZE);
+
+        size = 2 + USB_DEVICE_DESCRIPTOR_STRUCTURE_SIZE;
+
+        break;
+
+    case USB_CONFIGURATION_DESCRIPTOR_TYPE: {
+        auto configuration = device->Configurations;
+
+        if (configuration == nullptr)
+            return false;
+
+        auto vendors = [&](const TinyCLR_UsbClient_VendorClassDescriptor* vendor, size_t count) {
+            for (auto i = 0U; i < count; i++, vendor++) {
+                buffer[size + 0] = 2 + vendor->Length;
+                buffer[size + 1] = vendor->Type;
+
+                memcpy(&buffer[size + 2], vendor->Payload, vendor->Length);
+
+                size += 2 + vendor->Length;
+            }
+        };
+
+        buffer[0] = 2 + USB_CONFIGURATION_DESCRIPTOR_STRUCTURE_SIZE;
+        buffer[1] = USB_CONFIGURATION_DESCRIPTOR_TYPE;
+
+        memcpy(&buffer[2], configuration, USB_CONFIGURATION_DESCRIPTOR_STRUCTURE_SIZE);
+
+        size = 2 + USB_CONFIGURATION_DESCRIPTOR_STRUCTURE_SIZE;
+
+        vendors(configuration->VendorClassDescriptors, configuration->VendorClassDescriptorCount);
+
+        for (auto i = 0; i < configuration->InterfaceCount; i++) {
+            auto ifc = &configuration->Interfaces[i];
+
+            buffer[size + 0] = 2 + USB_INTERFACE_DESCRIPTOR_STRUCTURE_SIZE;
+            buffer[size + 1] = USB_INTERFACE_DESCRIPTOR_TYPE;
+
+            memcpy(&buffer[size + 2], ifc, USB_INTERFACE_DESCRIPTOR_STRUCTURE_SIZE);
+
+            size += 2 + USB_INTERFACE_DESCRIPTOR_STRUCTURE_SIZE;
+
+            vendors(ifc->VendorClassDescriptors, ifc->VendorClassDescriptorCount);
+
+            for (auto endpoint = 0; endpoint < ifc->EndpointCount; endpoint++) {
+                auto ep = &ifc->Endpoints[endpoint];
+
+                buffer[size + 0] = 2 + USB_ENDPOINT_DESCRIPTOR_STRUCTURE_SIZE;
+                buffer[size + 1] = USB_ENDPOINT_DESCRIPTOR_TYPE;
+
+                memcpy(&buffer[size + 2], ep, USB_ENDPOINT_DESCRIPTOR_STRUCTURE_SIZE);
+
+                size += 2 + USB_ENDPOINT_DESCRIPTOR_STRUCTURE_SIZE;
+
+                vendors(ep->VendorClassDescriptors, ep->VendorClassDescriptorCount);
+            }
+        }
+
+        buffer[2] = (size >> 0) & 0xFF;
+        buffer[3] = (size >> 8) & 0xFF;
+
+        break;
+    }
+
+    case USB_STRING_DESCRIPTOR_TYPE: {
+        const TinyCLR_UsbClient_StringDescriptor* str = nullptr;
+
+        for (auto i = 0U; i < device->StringCount && str == nullptr; i++)
+            if (device->Strings[i].Index == index)
+                str = &device->Strings[i];
+
+        if (str == nullptr)
+            return false;
+
+        buffer[0] = 2 + str->Length * 2;
+        buffer[1] = USB_STRING_DESCRIPTOR_TYPE;
+
+        memcpy(&buffer[2], str->Data, str->Length * 2);
+
+        size = 2 + str->Length * 2;
+
+        break;
+    }
+
+    default:
+        return false;
+    }
+
+    data.assign(buffer, buffer + (expected < size ? expected : size));
+
+    return true;
+}
+
+// GET_DESCRIPTOR on endpoint 0, the data stage collected from the data callback. Returns false when stalled.
+static bool GetDescriptor(uint8_t type, uint8_t index, uint16_t length, std::vector<uint8_t>& data) {
+    const uint8_t setup[8] = { 0x80, USB_GET_DESCRIPTOR, index, type, 0x09, 0x04, static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8) };
+    uint8_t packet[PACKET_SIZE];
+
+    memcpy(usbClientState->controlEndpointBuffer, setup, sizeof(setup));
+
+    usbClientState->ptrData = usbClientState->controlEndpointBuffer;
+    usbClientState->dataSize = sizeof(setup);
+
+    auto result = TinyCLR_UsbClient_ControlCallback(usbClientState);
+
+    data.clear();
+
+    for (auto packets = 0; result != USB_STATE_STALL && usbClientState->dataCallback != nullptr && packets < 1100; packets++) {
+        usbClientState->ptrData = packet;
+        usbClientState->dataCallback(usbClientState);
+
+        data.insert(data.end(), packet, packet + usbClientState->dataSize);
+
+        if (usbClientState->dataSize < PACKET_SIZE)
+            break;
+    }
+
+    return result != USB_STATE_STALL;
+}
+
+static void Acquire(const TinyCLR_UsbClient_DeviceDescriptor* descriptor) {
+    HOST_CHECK(TinyCLR_UsbClient_SetDeviceDescriptor(usbClientController, descriptor) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_UsbClient_Acquire(usbClientController) == TinyCLR_Result::Success);
+
+    usbClientState->deviceState = USB_DEVICE_STATE_ADDRESS;
+}
+
+// Every descriptor type and index the set could answer, for host lengths around every size that matters.
+static void CheckAll() {
+    static const uint8_t types[] = { USB_DEVICE_DESCRIPTOR_TYPE, USB_CONFIGURATION_DESCRIPTOR_TYPE, USB_STRING_DESCRIPTOR_TYPE };
+
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> actual;
+
+    for (auto type : types) {
+        for (auto index = 0; index < 8; index++) {
+            for (uint32_t length = 1; length <= 0xFFFF; length = length < 300 ? length + 1 : length * 2 + 1) {
+                auto answered = Reference_GetDescriptor(&usbClientState->deviceDescriptor, type, index, length, expected);
+
+                HOST_CHECK(GetDescriptor(type, index, length, actual) == answered);
+                HOST_CHECK(actual == expected);
+            }
+        }
+    }
+
+    // the first request out of reset gets one packet at most, as before
+    usbClientState->deviceState = USB_DEVICE_STATE_DEFAULT;
+    usbClientState->firstGetDescriptor = true;
+
+    Reference_GetDescriptor(&usbClientState->deviceDescriptor, USB_CONFIGURATION_DESCRIPTOR_TYPE, 0, usbClientState->maxEndpointsPacketSize[0], expected);
+
+    HOST_CHECK(GetDescriptor(USB_CONFIGURATION_DESCRIPTOR_TYPE, 0, 0xFF, actual) && actual == expected);
+    HOST_CHECK(actual.size() <= usbClientState->maxEndpointsPacketSize[0]);
+
+    usbClientState->deviceState = USB_DEVICE_STATE_ADDRESS;
+}
+
+// Class descriptors on every level, several interfaces, strings out of order with a gap and a duplicate index.
+static void TestFullSet() {
+    static const uint8_t payloadA[] = { 0x01, 0x02, 0x03 };
+    static const uint8_t payloadB[] = { 0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70 };
+    static const uint8_t payloadC[] = { 0xAA };
+
+    static const TinyCLR_UsbClient_VendorClassDescriptor configurationVendors[] = { { sizeof(payloadA), 0x21, payloadA } };
+    static const TinyCLR_UsbClient_VendorClassDescriptor interfaceVendors[] = { { sizeof(payloadB), 0x24, payloadB }, { sizeof(payloadC), 0x24, payloadC } };
+    static const TinyCLR_UsbClient_VendorClassDescriptor endpointVendors[] = { { sizeof(payloadC), 0x25, payloadC } };
+
+    static const TinyCLR_UsbClient_EndpointDescriptor endpoints0[] = {
+        { 0x81, 3, 16, 10, 0, nullptr },
+    };
+
+    static const TinyCLR_UsbClient_EndpointDescriptor endpoints1[] = {
+        { 0x82, 2, 64, 0, 1, endpointVendors },
+        { 0x03, 2, 64, 0, 0, nullptr },
+    };
+
+    static const TinyCLR_UsbClient_InterfaceDescriptor interfaces[] = {
+        { 0, 0, 1, 0x02, 0x02, 0x01, 4, 2, interfaceVendors, endpoints0 },
+        { 1, 0, 2, 0x0A, 0x00, 0x00, 0, 0, nullptr, endpoints1 },
+        { 2, 0, 0, 0xFF, 0x00, 0x00, 7, 1, interfaceVendors, nullptr },
+    };
+
+    static const TinyCLR_UsbClient_ConfigurationDescriptor configuration = { 0, 3, 1, 5, 0xC0, 50, 1, configurationVendors, interfaces };
+
+    static const wchar_t language[] = { 0x0409 };
+    static const TinyCLR_UsbClient_StringDescriptor strings[] = {
+        { 2, 9, L"Telemetry" },
+        { 0, 1, language },
+        { 1, 15, L"GHI Electronics" },
+        { 2, 5, L"Other" },
+        { 5, 6, L"Config" },
+        { 4, 11, L"Serial Port" },
+    };
+
+    static const TinyCLR_UsbClient_DeviceDescriptor device = {
+        0x0200, 0xEF, 0x02, 0x01, PACKET_SIZE, 0x1B9F, 0x5003, 0x0100, 1, 2, 3, 1, &configuration, sizeof(strings) / sizeof(strings[0]), strings
+    };
+
+    Acquire(&device);
+    CheckAll();
+    TinyCLR_UsbClient_Release(usbClientController);
+}
+
+// No class descriptors, no interfaces, no strings.
+static void TestEmptySet() {
+    static const TinyCLR_UsbClient_ConfigurationDescriptor configuration = { 0, 0, 1, 0, 0x80, 250, 0, nullptr, nullptr };
+    static const TinyCLR_UsbClient_DeviceDescriptor device = {
+        0x0110, 0, 0, 0, PACKET_SIZE, 0x1234, 0x5678, 0x9ABC, 0, 0, 0, 1, &configuration, 0, nullptr
+    };
+
+    Acquire(&device);
+    CheckAll();
+    TinyCLR_UsbClient_Release(usbClientController);
+}
+
+int main() {
+    usbClientController = reinterpret_cast<const TinyCLR_UsbClient_Controller*>(TinyCLR_UsbClient_GetRequiredApi()->Implementation);
+    usbClientState = reinterpret_cast<UsbClientState*>(usbClientController->ApiInfo->State);
+
+    TestFullSet();
+    TestEmptySet();
+
+    return Host_Finish("USBClient/DescriptorTest");
+}
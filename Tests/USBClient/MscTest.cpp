@@ -0,0 +1,611 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include <vector>
+#include "UsbClientHost.h"
+#include "../../Drivers/USBClient/USBMsc.h"
+
+#define PACKET_SIZE 64
+#define SPIN_LIMIT 100000
+
+#define RAM_BLOCK_SIZE 512
+#define RAM_BLOCKS 2048
+
+// A RAM disk of equal sized blocks, with a block that can be made to fail and a medium that can be taken out.
+static std::vector<uint8_t> ramDisk(RAM_BLOCKS * RAM_BLOCK_SIZE);
+static const uint64_t ramAddress = 0;
+static const size_t ramRegionSize = RAM_BLOCK_SIZE;
+static TinyCLR_Storage_Descriptor ramDescriptor;
+static int64_t ramFailAddress = -1;
+static bool ramPresent = true;
+static size_t ramLargestCall;
+static size_t ramCalls;
+
+static TinyCLR_Result RamAccess(uint64_t address, size_t count) {
+    ramCalls++;
+
+    if (count > ramLargestCall)
+        ramLargestCall = count;
+
+    if (ramFailAddress >= 0 && static_cast<int64_t>(address) <= ramFailAddress && ramFailAddress < static_cast<int64_t>(address + count))
+        return TinyCLR_Result::InvalidOperation;
+
+    return address + count > ramDisk.size() ? TinyCLR_Result::ArgumentOutOfRange : TinyCLR_Result::Success;
+}
+
+static TinyCLR_Result RamRead(const TinyCLR_Storage_Controller* self, uint64_t address, size_t& count, uint8_t* data, uint64_t timeout) {
+    auto result = RamAccess(address, count);
+
+    if (result == TinyCLR_Result::Success)
+        memcpy(data, &ramDisk[address], count);
+
+    return result;
+}
+
+static TinyCLR_Result RamWrite(const TinyCLR_Storage_Controller* self, uint64_t address, size_t& count, const uint8_t* data, uint64_t timeout) {
+    auto result = RamAccess(address, count);
+
+    if (result == TinyCLR_Result::Success)
+        memcpy(&ramDisk[address], data, count);
+
+    return result;
+}
+
+static TinyCLR_Result RamGetDescriptor(const TinyCLR_Storage_Controller* self, const TinyCLR_Storage_Descriptor*& descriptor) {
+    if (!ramPresent)
+        return TinyCLR_Result::NotAvailable;
+
+    ramDescriptor.Removable = true;
+    ramDescriptor.RegionsContiguous = true;
+    ramDescriptor.RegionsEqualSized = true;
+    ramDescriptor.RegionCount = ramDisk.size() / ramRegionSize;
+    ramDescriptor.RegionAddresses = &ramAddress;
+    ramDescriptor.RegionSizes = &ramRegionSize;
+
+    descriptor = &ramDescriptor;
+
+    return TinyCLR_Result::Success;
+}
+
+// Flash like storage: unequal regions that must be erased before a write, so it is exposed read only.
+static const uint64_t flashAddresses[] = { 0x08010000, 0x08014000, 0x08020000 };
+static const size_t flashSizes[] = { 0x4000, 0xC000, 0x20000 };
+static TinyCLR_Storage_Descriptor flashDescriptor;
+static uint64_t flashLastAddress;
+
+static TinyCLR_Result FlashRead(const TinyCLR_Storage_Controller* self, uint64_t address, size_t& count, uint8_t* data, uint64_t timeout) {
+    flashLastAddress = address;
+
+    memset(data, 0xA5, count);
+
+    return TinyCLR_Result::Success;
+}
+
+static TinyCLR_Result FlashGetDescriptor(const TinyCLR_Storage_Controller* self, const TinyCLR_Storage_Descriptor*& descriptor) {
+    flashDescriptor.EraseBeforeWrite = true;
+    flashDescriptor.RegionsContiguous = true;
+    flashDescriptor.RegionsEqualSized = false;
+    flashDescriptor.RegionCount = 3;
+    flashDescriptor.RegionAddresses = flashAddresses;
+    flashDescriptor.RegionSizes = flashSizes;
+
+    descriptor = &flashDescriptor;
+
+    return TinyCLR_Result::Success;
+}
+
+static TinyCLR_Storage_Controller ramStorage;
+static TinyCLR_Storage_Controller flashStorage;
+
+static const TinyCLR_UsbClient_Controller* usbClientController;
+static UsbClientState* usbClientState;
+static std::vector<std::vector<uint8_t>> packetsIn;
+static uint32_t nextTag = 1;
+
+struct Csw {
+    bool valid;
+    uint32_t signature;
+    uint32_t tag;
+    uint32_t residue;
+    uint8_t status;
+};
+
+// A setup packet on endpoint 0, returning the state the control callback left and any data stage.
+static uint8_t Control(const uint8_t (&setup)[8], std::vector<uint8_t>& data) {
+    uint8_t packet[PACKET_SIZE];
+
+    memcpy(usbClientState->controlEndpointBuffer, setup, sizeof(setup));
+
+    usbClientState->ptrData = usbClientState->controlEndpointBuffer;
+    usbClientState->dataSize = sizeof(setup);
+
+    auto result = TinyCLR_UsbClient_ControlCallback(usbClientState);
+
+    data.clear();
+
+    for (auto packets = 0; result == USB_STATE_DATA && usbClientState->dataCallback != nullptr && packets < 64; packets++) {
+        usbClientState->ptrData = packet;
+        usbClientState->dataCallback(usbClientState);
+
+        data.insert(data.end(), packet, packet + usbClientState->dataSize);
+    }
+
+    return result;
+}
+
+// Runs the function once, then takes whatever it queued for the host off the IN endpoint.
+static void Pump() {
+    TinyCLR_UsbMsc_Process(usbClientController);
+
+    uint32_t size;
+    uint8_t* data;
+
+    while ((data = TinyCLR_UsbClient_TxDequeue(usbClientState, USB_MSC_DATA_IN_ENDPOINT, size)) != nullptr)
+        packetsIn.push_back(std::vector<uint8_t>(data, data + size));
+}
+
+static void SendOut(const uint8_t* data, size_t size) {
+    size_t sent = 0;
+
+    for (auto spins = 0; sent < size && spins < SPIN_LIMIT; ) {
+        bool disableRx;
+        auto packet = TinyCLR_UsbClient_RxEnqueue(usbClientState, USB_MSC_DATA_OUT_ENDPOINT, disableRx);
+
+        if (packet == nullptr) {
+            Pump();
+            spins++;
+
+            continue;
+        }
+
+        auto length = size - sent < PACKET_SIZE ? size - sent : PACKET_SIZE;
+
+        memcpy(packet, data + sent, length);
+
+        TinyCLR_UsbClient_RxCommit(usbClientState, USB_MSC_DATA_OUT_ENDPOINT, length);
+
+        sent += length;
+    }
+
+    HOST_CHECK(sent == size);
+}
+
+// IN packets up to a short one, or up to length bytes when they are all full.
+static std::vector<uint8_t> ReceiveIn(size_t length) {
+    std::vector<uint8_t> data;
+
+    for (auto spins = 0; spins < SPIN_LIMIT; ) {
+        for (; packetsIn.empty() && spins < SPIN_LIMIT; spins++)
+            Pump();
+
+        if (packetsIn.empty())
+            break;
+
+        auto packet = packetsIn.front();
+
+        packetsIn.erase(packetsIn.begin());
+        data.insert(data.end(), packet.begin(), packet.end());
+
+        if (packet.size() < PACKET_SIZE || data.size() >= length)
+            break;
+    }
+
+    return data;
+}
+
+static std::vector<uint8_t> Cbw(uint32_t tag, uint32_t length, bool in, const std::vector<uint8_t>& command) {
+    std::vector<uint8_t> cbw(USB_MSC_CBW_SIZE, 0);
+    auto signature = USB_MSC_CBW_SIGNATURE;
+
+    memcpy(&cbw[0], &signature, 4);
+    memcpy(&cbw[4], &tag, 4);
+    memcpy(&cbw[8], &length, 4);
+
+    cbw[12] = in ? USB_MSC_CBW_FLAG_IN : 0;
+    cbw[14] = command.size();
+
+    memcpy(&cbw[15], command.data(), command.size());
+
+    return cbw;
+}
+
+static Csw ReadCsw() {
+    Csw csw = {};
+    auto data = ReceiveIn(USB_MSC_CSW_SIZE);
+
+    csw.valid = data.size() == USB_MSC_CSW_SIZE;
+
+    if (csw.valid) {
+        memcpy(&csw.signature, &data[0], 4);
+        memcpy(&csw.tag, &data[4], 4);
+        memcpy(&csw.residue, &data[8], 4);
+
+        csw.status = data[12];
+    }
+
+    return csw;
+}
+
+// One command through all three stages: data is sent for OUT and filled in for IN.
+static Csw Run(const std::vector<uint8_t>& command, uint32_t length, bool in, std::vector<uint8_t>& data) {
+    auto tag = nextTag++;
+    auto cbw = Cbw(tag, length, in, command);
+
+    SendOut(cbw.data(), cbw.size());
+
+    if (length > 0 && in) {
+        data = ReceiveIn(length);
+
+        HOST_CHECK(data.size() == length);
+
+        data.resize(length);
+    }
+    else if (length > 0) {
+        SendOut(data.data(), length);
+    }
+
+    auto csw = ReadCsw();
+
+    HOST_CHECK(csw.valid && csw.signature == USB_MSC_CSW_SIGNATURE && csw.tag == tag);
+    HOST_CHECK(packetsIn.empty());
+
+    return csw;
+}
+
+static std::vector<uint8_t> ReadWrite10(uint8_t operation, uint32_t block, uint16_t blocks) {
+    return { operation, 0, static_cast<uint8_t>(block >> 24), static_cast<uint8_t>(block >> 16), static_cast<uint8_t>(block >> 8), static_cast<uint8_t>(block), 0, static_cast<uint8_t>(blocks >> 8), static_cast<uint8_t>(blocks), 0 };
+}
+
+static std::vector<uint8_t> RequestSense() {
+    std::vector<uint8_t> data;
+    auto csw = Run({ 0x03, 0, 0, 0, 18, 0 }, 18, true, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED && csw.residue == 0);
+
+    return data;
+}
+
+// The SCSI layer straight on the storage, without USB in between.
+static void TestScsi() {
+    UsbMscScsiState scsi;
+    uint8_t buffer[USB_MSC_BUFFER_SIZE];
+
+    TinyCLR_UsbMsc_ScsiInitialize(&scsi, &ramStorage);
+
+    HOST_CHECK(scsi.present && scsi.blockSize == RAM_BLOCK_SIZE && scsi.blockCount == RAM_BLOCKS && !scsi.writeProtected && scsi.removable);
+
+    const uint8_t readCapacity[10] = { 0x25 };
+
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, readCapacity, sizeof(readCapacity), buffer, sizeof(buffer)) == 0);
+    HOST_CHECK(scsi.direction == USB_MSC_DIRECTION_IN && scsi.length == 8);
+    HOST_CHECK(buffer[0] == 0 && buffer[1] == 0 && buffer[2] == 0x07 && buffer[3] == 0xFF && buffer[6] == 0x02 && buffer[7] == 0);
+
+    auto command = ReadWrite10(0x28, 10, 4);
+
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, command.data(), command.size(), buffer, sizeof(buffer)) == 0);
+    HOST_CHECK(scsi.blockTransfer && scsi.length == 4 * RAM_BLOCK_SIZE && scsi.address == 10 * RAM_BLOCK_SIZE);
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiRead(&scsi, buffer, 4 * RAM_BLOCK_SIZE) && scsi.length == 0);
+    HOST_CHECK(memcmp(buffer, &ramDisk[10 * RAM_BLOCK_SIZE], 4 * RAM_BLOCK_SIZE) == 0);
+
+    // out of range, a block number that wraps included, and nothing to do for no blocks
+    command = ReadWrite10(0x28, RAM_BLOCKS - 1, 2);
+
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, command.data(), command.size(), buffer, sizeof(buffer)) == 1);
+    HOST_CHECK(scsi.senseKey == 5 && scsi.additionalSenseCode == 0x21);
+
+    command = ReadWrite10(0x28, 0xFFFFFFFF, 2);
+
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, command.data(), command.size(), buffer, sizeof(buffer)) == 1 && scsi.additionalSenseCode == 0x21);
+
+    command = ReadWrite10(0x28, RAM_BLOCKS, 0);
+
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, command.data(), command.size(), buffer, sizeof(buffer)) == 0 && scsi.direction == USB_MSC_DIRECTION_NONE);
+
+    const uint8_t unknown[6] = { 0xC7 };
+
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, unknown, sizeof(unknown), buffer, sizeof(buffer)) == 1);
+    HOST_CHECK(scsi.senseKey == 5 && scsi.additionalSenseCode == 0x20);
+
+    // inquiry strings are cut or padded with spaces, anything outside ASCII becomes '?'
+    TinyCLR_UsbMsc_ScsiSetInquiry(&scsi, L"GHI Electronics", L"DataéLogger", 0x0102);
+
+    const uint8_t inquiry[6] = { 0x12, 0, 0, 0, 36, 0 };
+
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, inquiry, sizeof(inquiry), buffer, sizeof(buffer)) == 0 && scsi.length == 36);
+    HOST_CHECK(buffer[1] == 0x80);
+    HOST_CHECK(memcmp(&buffer[8], "GHI Elec", 8) == 0);
+    HOST_CHECK(memcmp(&buffer[16], "Data?Logger     ", 16) == 0);
+    HOST_CHECK(memcmp(&buffer[32], "0102", 4) == 0);
+
+    const uint8_t shortInquiry[6] = { 0x12, 0, 0, 0, 5, 0 };
+
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, shortInquiry, sizeof(shortInquiry), buffer, sizeof(buffer)) == 0 && scsi.length == 5);
+
+    // flash is cut into default sized blocks addressed from its first region, and can't be written
+    TinyCLR_UsbMsc_ScsiInitialize(&scsi, &flashStorage);
+
+    HOST_CHECK(scsi.present && scsi.blockSize == USB_MSC_DEFAULT_BLOCK_SIZE && scsi.writeProtected);
+    HOST_CHECK(scsi.blockCount == (0x4000 + 0xC000 + 0x20000) / USB_MSC_DEFAULT_BLOCK_SIZE);
+
+    command = ReadWrite10(0x2A, 0, 1);
+
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, command.data(), command.size(), buffer, sizeof(buffer)) == 1);
+    HOST_CHECK(scsi.senseKey == 7 && scsi.additionalSenseCode == 0x27);
+
+    command = ReadWrite10(0x28, 40, 1);
+
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, command.data(), command.size(), buffer, sizeof(buffer)) == 0);
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiRead(&scsi, buffer, USB_MSC_DEFAULT_BLOCK_SIZE) && flashLastAddress == flashAddresses[0] + 40 * USB_MSC_DEFAULT_BLOCK_SIZE);
+
+    const uint8_t modeSense[6] = { 0x1A, 0, 0x3F, 0, 192, 0 };
+
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, modeSense, sizeof(modeSense), buffer, sizeof(buffer)) == 0);
+    HOST_CHECK(scsi.length == 4 && buffer[2] == 0x80);
+
+    // a medium that comes back is picked up by the next command
+    const uint8_t testUnitReady[6] = { USB_MSC_SCSI_TEST_UNIT_READY };
+
+    ramPresent = false;
+
+    TinyCLR_UsbMsc_ScsiInitialize(&scsi, &ramStorage);
+
+    HOST_CHECK(!scsi.present);
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, testUnitReady, sizeof(testUnitReady), buffer, sizeof(buffer)) == 1);
+    HOST_CHECK(scsi.senseKey == 2 && scsi.additionalSenseCode == 0x3A);
+
+    ramPresent = true;
+
+    HOST_CHECK(TinyCLR_UsbMsc_ScsiCommand(&scsi, testUnitReady, sizeof(testUnitReady), buffer, sizeof(buffer)) == 0 && scsi.present);
+}
+
+// Acquire through SET_CONFIGURATION: one mass storage interface, SCSI over bulk only, two bulk endpoints.
+static void TestEnumeration() {
+    static const TinyCLR_UsbMsc_DeviceInfo deviceInfo = { 0x1B9F, 0x5001, 0x0100, L"GHI Electronics", L"Logger", L"0123456789AB" };
+
+    std::vector<uint8_t> data;
+
+    HOST_CHECK(TinyCLR_UsbMsc_Acquire(usbClientController, &ramStorage, &deviceInfo) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_UsbMsc_Acquire(usbClientController, &ramStorage, &deviceInfo) == TinyCLR_Result::SharingViolation);
+
+    usbClientState->deviceState = USB_DEVICE_STATE_ADDRESS;
+
+    const uint8_t getConfiguration[8] = { 0x80, 6, 0, 2, 0, 0, 0xFF, 0 };
+
+    HOST_CHECK(Control(getConfiguration, data) == USB_STATE_DATA);
+    HOST_CHECK(data.size() == 9 + 9 + 7 + 7);
+
+    if (data.size() == 9 + 9 + 7 + 7) {
+        HOST_CHECK(data[4] == 1);
+        HOST_CHECK(data[9 + 4] == 2 && data[9 + 5] == USB_MSC_INTERFACE_CLASS && data[9 + 6] == USB_MSC_SCSI_TRANSPARENT && data[9 + 7] == USB_MSC_BULK_ONLY_TRANSPORT);
+        HOST_CHECK(data[18 + 2] == (0x80 | USB_MSC_DATA_IN_ENDPOINT) && data[18 + 3] == 2);
+        HOST_CHECK(data[25 + 2] == USB_MSC_DATA_OUT_ENDPOINT && data[25 + 3] == 2);
+    }
+
+    const uint8_t setConfiguration[8] = { 0x00, 9, 1, 0, 0, 0, 0, 0 };
+
+    HOST_CHECK(Control(setConfiguration, data) == USB_STATE_CONFIGURATION);
+
+    const uint8_t getMaxLun[8] = { 0xA1, USB_MSC_GET_MAX_LUN, 0, 0, 0, 0, 1, 0 };
+
+    HOST_CHECK(Control(getMaxLun, data) == USB_STATE_DATA && data.size() == 1 && data[0] == 0);
+}
+
+static void TestCommands() {
+    std::vector<uint8_t> data;
+
+    // INQUIRY ends in a short packet, the status follows in its own
+    auto csw = Run({ 0x12, 0, 0, 0, 36, 0 }, 36, true, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED && csw.residue == 0);
+    HOST_CHECK(memcmp(&data[8], "GHI Elec", 8) == 0 && memcmp(&data[16], "Logger", 6) == 0);
+
+    // the host asks for more than there is: padded, and the rest reported as residue
+    csw = Run({ 0x12, 0, 0, 0, 0xFF, 0 }, 0xFF, true, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED && csw.residue == 0xFF - 36 && data[40] == 0);
+
+    csw = Run({ USB_MSC_SCSI_TEST_UNIT_READY, 0, 0, 0, 0, 0 }, 0, false, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED);
+
+    csw = Run({ 0x25, 0, 0, 0, 0, 0, 0, 0, 0, 0 }, 8, true, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED && data[2] == 0x07 && data[3] == 0xFF && data[6] == 0x02);
+
+    // full packets only and no zero length packet before the status, one storage call per buffer
+    ramLargestCall = 0;
+    ramCalls = 0;
+
+    csw = Run(ReadWrite10(0x28, 100, 64), 64 * RAM_BLOCK_SIZE, true, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED && csw.residue == 0);
+    HOST_CHECK(memcmp(data.data(), &ramDisk[100 * RAM_BLOCK_SIZE], 64 * RAM_BLOCK_SIZE) == 0);
+    HOST_CHECK(ramLargestCall == USB_MSC_BUFFER_SIZE && ramCalls == 64 * RAM_BLOCK_SIZE / USB_MSC_BUFFER_SIZE);
+
+    std::vector<uint8_t> written(17 * RAM_BLOCK_SIZE);
+
+    for (size_t i = 0; i < written.size(); i++)
+        written[i] = static_cast<uint8_t>(i * 31 + 5);
+
+    data = written;
+    csw = Run(ReadWrite10(0x2A, 500, 17), written.size(), false, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED && csw.residue == 0);
+    HOST_CHECK(memcmp(&ramDisk[500 * RAM_BLOCK_SIZE], written.data(), written.size()) == 0);
+
+    csw = Run(ReadWrite10(0x28, 500, 17), written.size(), true, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED && data == written);
+
+    // a length that ends in a short packet leaves the next command lined up
+    csw = Run({ 0x12, 0, 0, 0, 100, 0 }, 100, true, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED && data.size() == 100);
+
+    csw = Run(ReadWrite10(0x28, 1, 1), RAM_BLOCK_SIZE, true, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED && memcmp(data.data(), &ramDisk[RAM_BLOCK_SIZE], RAM_BLOCK_SIZE) == 0);
+}
+
+// The thirteen cases of the bulk only transport that matter here: the status and residue say what happened and
+// REQUEST SENSE says why.
+static void TestErrors() {
+    std::vector<uint8_t> data;
+
+    // out of range: the data stage is padded and the command fails
+    auto csw = Run(ReadWrite10(0x28, RAM_BLOCKS - 1, 2), 2 * RAM_BLOCK_SIZE, true, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_FAILED && csw.residue == 2 * RAM_BLOCK_SIZE);
+
+    data = RequestSense();
+
+    HOST_CHECK(data[2] == 5 && data[12] == 0x21);
+
+    // the device would send more than the host asked for
+    csw = Run(ReadWrite10(0x28, 0, 4), RAM_BLOCK_SIZE, true, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PHASE);
+
+    // the host sends where the device reads
+    data.assign(RAM_BLOCK_SIZE, 0);
+    csw = Run(ReadWrite10(0x28, 0, 1), RAM_BLOCK_SIZE, false, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PHASE);
+
+    // the host sends more than the write takes, the rest is thrown away
+    data.assign(4 * RAM_BLOCK_SIZE, 0x5A);
+    csw = Run(ReadWrite10(0x2A, 7, 2), 4 * RAM_BLOCK_SIZE, false, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED && csw.residue == 2 * RAM_BLOCK_SIZE);
+    HOST_CHECK(ramDisk[7 * RAM_BLOCK_SIZE] == 0x5A && ramDisk[9 * RAM_BLOCK_SIZE] != 0x5A);
+
+    // the storage fails in the middle of a read: the buffers before it were sent
+    ramFailAddress = 300 * RAM_BLOCK_SIZE + 5000;
+    csw = Run(ReadWrite10(0x28, 300, 32), 32 * RAM_BLOCK_SIZE, true, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_FAILED && csw.residue == 32 * RAM_BLOCK_SIZE - USB_MSC_BUFFER_SIZE * (5000 / USB_MSC_BUFFER_SIZE));
+    HOST_CHECK(memcmp(data.data(), &ramDisk[300 * RAM_BLOCK_SIZE], USB_MSC_BUFFER_SIZE * (5000 / USB_MSC_BUFFER_SIZE)) == 0);
+
+    ramFailAddress = -1;
+    data = RequestSense();
+
+    HOST_CHECK(data[2] == 3 && data[12] == 0x11);
+
+    csw = Run({ 0xC7, 0, 0, 0, 0, 0 }, 0, false, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_FAILED);
+
+    data = RequestSense();
+
+    HOST_CHECK(data[2] == 5 && data[12] == 0x20);
+
+    // a medium change is reported once
+    HOST_CHECK(TinyCLR_UsbMsc_MediumChanged(usbClientController) == TinyCLR_Result::Success);
+
+    csw = Run({ USB_MSC_SCSI_TEST_UNIT_READY, 0, 0, 0, 0, 0 }, 0, false, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_FAILED);
+
+    data = RequestSense();
+
+    HOST_CHECK(data[2] == 6 && data[12] == 0x28);
+
+    csw = Run({ USB_MSC_SCSI_TEST_UNIT_READY, 0, 0, 0, 0, 0 }, 0, false, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED);
+}
+
+// A CBW with a bad signature is dropped, and a bulk only reset in the middle of a read brings the pipe back.
+static void TestReset() {
+    std::vector<uint8_t> data;
+
+    auto cbw = Cbw(nextTag++, 0, false, { USB_MSC_SCSI_TEST_UNIT_READY, 0, 0, 0, 0, 0 });
+
+    cbw[0] = 'X';
+
+    SendOut(cbw.data(), cbw.size());
+
+    for (auto i = 0; i < 10; i++)
+        Pump();
+
+    HOST_CHECK(packetsIn.empty());
+
+    cbw = Cbw(nextTag++, 64 * RAM_BLOCK_SIZE, true, ReadWrite10(0x28, 0, 64));
+
+    SendOut(cbw.data(), cbw.size());
+
+    for (auto i = 0; i < 3; i++)
+        Pump();
+
+    HOST_CHECK(!packetsIn.empty());
+
+    packetsIn.clear();
+
+    const uint8_t reset[8] = { 0x21, USB_MSC_BULK_ONLY_RESET, 0, 0, 0, 0, 0, 0 };
+
+    HOST_CHECK(Control(reset, data) == USB_STATE_DATA);
+
+    Pump();
+
+    packetsIn.clear();
+
+    auto csw = Run({ USB_MSC_SCSI_TEST_UNIT_READY, 0, 0, 0, 0, 0 }, 0, false, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED);
+
+    // leaving the configured state starts over at a command
+    usbClientState->deviceState = USB_DEVICE_STATE_ADDRESS;
+
+    TinyCLR_UsbClient_StateCallback(usbClientState);
+
+    Pump();
+
+    usbClientState->deviceState = USB_DEVICE_STATE_CONFIGURED;
+
+    TinyCLR_UsbClient_StateCallback(usbClientState);
+
+    csw = Run({ USB_MSC_SCSI_TEST_UNIT_READY, 0, 0, 0, 0, 0 }, 0, false, data);
+
+    HOST_CHECK(csw.status == USB_MSC_CSW_STATUS_PASSED);
+}
+
+static void TestRelease() {
+    HOST_CHECK(TinyCLR_UsbMsc_Release(usbClientController) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_UsbMsc_Process(usbClientController) == TinyCLR_Result::InvalidOperation);
+}
+
+int main() {
+    for (size_t i = 0; i < ramDisk.size(); i++)
+        ramDisk[i] = static_cast<uint8_t>(i * 7 + i / RAM_BLOCK_SIZE);
+
+    ramStorage.Read = &RamRead;
+    ramStorage.Write = &RamWrite;
+    ramStorage.GetDescriptor = &RamGetDescriptor;
+
+    flashStorage.Read = &FlashRead;
+    flashStorage.GetDescriptor = &FlashGetDescriptor;
+
+    usbClientController = reinterpret_cast<const TinyCLR_UsbClient_Controller*>(TinyCLR_UsbClient_GetRequiredApi()->Implementation);
+    usbClientState = reinterpret_cast<UsbClientState*>(usbClientController->ApiInfo->State);
+
+    TestScsi();
+    TestEnumeration();
+    TestCommands();
+    TestErrors();
+    TestReset();
+    TestRelease();
+
+    return Host_Finish("USBClient/MscTest");
+}
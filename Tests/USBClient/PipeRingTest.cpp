@@ -0,0 +1,262 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <vector>
+#include "UsbClientHost.h"
+
+#define PACKET_SIZE 64
+
+static UsbClientState* usbClientState;
+static std::vector<std::vector<uint8_t>> wire;
+static std::vector<uint8_t> hostData;
+static size_t hostSent;
+static bool rxEnabled;
+static bool clearOnInterrupt;
+
+// The controller side: one IN packet out of the Tx ring to the host.
+static void SendPacket() {
+    auto expected = TinyCLR_UsbClient_TxPeek(usbClientState, USBCLIENTHOST_TX_ENDPOINT, 0);
+    uint32_t size;
+    auto data = TinyCLR_UsbClient_TxDequeue(usbClientState, USBCLIENTHOST_TX_ENDPOINT, size);
+
+    if (data == nullptr) {
+        HOST_CHECK(expected < 0);
+
+        return;
+    }
+
+    HOST_CHECK(static_cast<int32_t>(size) == expected);
+    HOST_CHECK((reinterpret_cast<uintptr_t>(data) & 3) == 0);
+
+    wire.push_back(std::vector<uint8_t>(data, data + size));
+}
+
+// One OUT packet from the host into the Rx ring, read word wise like a FIFO so the bytes after it get scribbled.
+static void ReceivePacket() {
+    if (hostSent >= hostData.size() || !rxEnabled)
+        return;
+
+    bool disableRx;
+    auto data = TinyCLR_UsbClient_RxEnqueue(usbClientState, USBCLIENTHOST_RX_ENDPOINT, disableRx);
+
+    if (disableRx) {
+        HOST_CHECK(data == nullptr);
+
+        rxEnabled = false;
+
+        return;
+    }
+
+    HOST_CHECK(data != nullptr && (reinterpret_cast<uintptr_t>(data) & 3) == 0);
+
+    size_t size = 1 + rand() % PACKET_SIZE;
+
+    if (size > hostData.size() - hostSent)
+        size = hostData.size() - hostSent;
+
+    memcpy(data, &hostData[hostSent], size);
+    memset(data + size, 0xEE, PACKET_SIZE - size);
+
+    hostSent += size;
+
+    TinyCLR_UsbClient_RxCommit(usbClientState, USBCLIENTHOST_RX_ENDPOINT, size);
+}
+
+static void Controller_Interrupt() {
+    if (clearOnInterrupt) {
+        clearOnInterrupt = false;
+
+        TinyCLR_UsbClient_ClearEndpoints(usbClientState, USBCLIENTHOST_RX_ENDPOINT);
+
+        return;
+    }
+
+    for (auto i = rand() % 4; i > 0; i--) {
+        SendPacket();
+        ReceivePacket();
+    }
+}
+
+static bool Controller_StartOutput(UsbClientState* state, int32_t endpoint) {
+    if (rand() % 2 == 0)
+        SendPacket();
+
+    return true;
+}
+
+static bool Controller_RxEnable(UsbClientState* state, int32_t endpoint) {
+    if (TinyCLR_UsbClient_CanReceivePackage(state, endpoint))
+        rxEnabled = true;
+
+    return true;
+}
+
+static const TinyCLR_UsbClient_Controller* Open(uint32_t txSize, uint32_t rxSize) {
+    auto self = UsbClientHost_Open(PACKET_SIZE, txSize, rxSize);
+
+    usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+    usbClientState->pipes[0].WriteTimeout = USB_WRITE_TIMEOUT_INFINITE;
+
+    wire.clear();
+    hostData.clear();
+    hostSent = 0;
+    rxEnabled = true;
+
+    return self;
+}
+
+// Writes come out whole as full packets ended by one short or zero length packet, and reads get the
+// received byte stream back whole, whatever the ring, packet and read sizes and wherever the interrupts land.
+static void TestStreams(uint32_t txSize, uint32_t rxSize) {
+    auto self = Open(txSize, rxSize);
+    auto txBuffer = usbClientState->queues[USBCLIENTHOST_TX_ENDPOINT];
+    std::vector<std::vector<uint8_t>> writes;
+
+    Host_SetInterruptHandler(&Controller_Interrupt);
+
+    for (auto i = 0; i < 300; i++) {
+        size_t length = rand() % 3 == 0 ? PACKET_SIZE * (1 + rand() % 4) : 1 + rand() % 400;
+        std::vector<uint8_t> data(length);
+
+        for (auto& b : data)
+            b = static_cast<uint8_t>(rand());
+
+        HOST_CHECK(TinyCLR_UsbClient_WritePipe(self, 0, data.data(), length) == TinyCLR_Result::Success);
+        HOST_CHECK(length == data.size());
+
+        writes.push_back(data);
+    }
+
+    for (auto i = 0; i < 100000 && txBuffer->TransferCount > 0; i++)
+        SendPacket();
+
+    HOST_CHECK(txBuffer->Count == 0);
+
+    size_t packet = 0;
+
+    for (auto& write : writes) {
+        std::vector<uint8_t> received;
+
+        while (packet < wire.size()) {
+            auto& data = wire[packet++];
+
+            received.insert(received.end(), data.begin(), data.end());
+
+            if (data.size() < PACKET_SIZE)
+                break;
+        }
+
+        HOST_CHECK(received == write);
+    }
+
+    HOST_CHECK(packet == wire.size());
+
+    hostData.resize(20000);
+
+    for (auto& b : hostData)
+        b = static_cast<uint8_t>(rand());
+
+    std::vector<uint8_t> read;
+
+    for (auto i = 0; i < 200000 && read.size() < hostData.size(); i++) {
+        ReceivePacket();
+
+        if (rand() % 3 == 0) {
+            uint8_t data[300];
+            size_t length = 1 + rand() % sizeof(data);
+
+            HOST_CHECK(TinyCLR_UsbClient_ReadPipe(self, 0, data, length) == TinyCLR_Result::Success);
+
+            read.insert(read.end(), data, data + length);
+        }
+    }
+
+    HOST_CHECK(read == hostData);
+    HOST_CHECK(TinyCLR_UsbClient_GetBytesToRead(self, 0) == 0);
+
+    Host_SetInterruptHandler(nullptr);
+
+    HOST_CHECK(TinyCLR_UsbClient_SetWriteBufferSize(self, 0, 10) == TinyCLR_Result::ArgumentOutOfRange);
+    HOST_CHECK(TinyCLR_UsbClient_SetWriteBufferSize(self, 0, 1000) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_UsbClient_GetWriteBufferSize(self, 0) == 1000);
+    HOST_CHECK(usbClientState->queues[USBCLIENTHOST_TX_ENDPOINT]->Size == 1000 && usbClientState->queues[USBCLIENTHOST_TX_ENDPOINT]->Count == 0);
+
+    UsbClientHost_Close(self);
+}
+
+// An endpoint cleared while ReadPipe copies with interrupts on: the read returns nothing and leaves
+// the cleared ring alone, and the ring keeps working afterwards.
+static void TestClearDuringRead() {
+    auto self = Open(256, 256);
+    auto rxBuffer = usbClientState->queues[USBCLIENTHOST_RX_ENDPOINT];
+
+    hostData.assign(150, 0x5A);
+
+    while (hostSent < hostData.size())
+        ReceivePacket();
+
+    // moves Out off the start of the ring, where a stale Out written back would go unnoticed
+    uint8_t data[100];
+    size_t length = 30;
+
+    HOST_CHECK(TinyCLR_UsbClient_ReadPipe(self, 0, data, length) == TinyCLR_Result::Success && length == 30);
+
+    Host_SetInterruptHandler(&Controller_Interrupt);
+
+    clearOnInterrupt = true;
+    length = sizeof(data);
+
+    HOST_CHECK(TinyCLR_UsbClient_ReadPipe(self, 0, data, length) == TinyCLR_Result::Success);
+    HOST_CHECK(length == 0);
+    HOST_CHECK(rxBuffer->In == 0 && rxBuffer->Out == 0 && rxBuffer->Count == 0);
+    HOST_CHECK(TinyCLR_UsbClient_GetBytesToRead(self, 0) == 0);
+
+    Host_SetInterruptHandler(nullptr);
+
+    for (auto i = 0U; i < hostData.size(); i++)
+        hostData[i] = static_cast<uint8_t>(i);
+
+    hostSent = 0;
+    rxEnabled = true;
+
+    while (hostSent < hostData.size())
+        ReceivePacket();
+
+    length = sizeof(data);
+
+    HOST_CHECK(TinyCLR_UsbClient_ReadPipe(self, 0, data, length) == TinyCLR_Result::Success);
+    HOST_CHECK(length == sizeof(data) && memcmp(data, hostData.data(), length) == 0);
+    HOST_CHECK(TinyCLR_UsbClient_GetBytesToRead(self, 0) == hostData.size() - sizeof(data));
+
+    UsbClientHost_Close(self);
+}
+
+int main() {
+    const uint32_t sizes[] = { 64, 65, 100, 127, 200, 256, 1000, 4096 };
+
+    UsbClientHost_SetHandlers(&Controller_StartOutput, &Controller_RxEnable);
+
+    for (auto txSize : sizes) {
+        for (auto rxSize : sizes) {
+            srand(txSize * 31 + rxSize);
+
+            TestStreams(txSize, rxSize);
+        }
+    }
+
+    TestClearDuringRead();
+
+    return Host_Finish("USBClient/PipeRingTest");
+}
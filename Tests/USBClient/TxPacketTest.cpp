@@ -0,0 +1,165 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <vector>
+#include "UsbClientHost.h"
+
+#define TX_RING_SIZE 4096
+#define WRITES_PER_BATCH 8
+
+static UsbClientState* usbClientState;
+static std::vector<std::vector<uint8_t>> wire;
+
+// Plays an OTG IN endpoint that takes up to maxPackets packets per transfer, as the STM32 drivers pick
+// them: every packet but the last of a transfer is full size, a zero length packet goes alone.
+static void Drain(uint32_t maxPackets) {
+    auto maxPacketSize = usbClientState->maxEndpointsPacketSize[USBCLIENTHOST_TX_ENDPOINT];
+
+    while (TinyCLR_UsbClient_TxPeek(usbClientState, USBCLIENTHOST_TX_ENDPOINT, 0) >= 0) {
+        uint32_t size;
+        auto packets = TinyCLR_UsbClient_GetTxPacketCount(usbClientState, USBCLIENTHOST_TX_ENDPOINT, maxPackets, size);
+
+        HOST_CHECK(packets >= 1 && packets <= maxPackets);
+        HOST_CHECK(size <= packets * maxPacketSize);
+        HOST_CHECK(size > (packets - 1) * maxPacketSize || (packets == 1 && size == 0));
+
+        if (packets == 0)
+            return;
+
+        uint32_t dequeued = 0;
+
+        for (auto i = 0U; i < packets; i++) {
+            uint32_t packetSize;
+            auto data = TinyCLR_UsbClient_TxDequeue(usbClientState, USBCLIENTHOST_TX_ENDPOINT, packetSize);
+
+            HOST_CHECK(data != nullptr);
+            HOST_CHECK(i + 1 == packets || packetSize == maxPacketSize);
+
+            if (data == nullptr)
+                return;
+
+            wire.push_back(std::vector<uint8_t>(data, data + packetSize));
+            dequeued += packetSize;
+        }
+
+        HOST_CHECK(dequeued == size);
+    }
+}
+
+// Splits what went on the wire back into writes, each ending at its first short or zero length packet.
+static void CheckWire(const std::vector<std::vector<uint8_t>>& writes) {
+    auto maxPacketSize = usbClientState->maxEndpointsPacketSize[USBCLIENTHOST_TX_ENDPOINT];
+    size_t packet = 0;
+
+    for (auto& write : writes) {
+        std::vector<uint8_t> received;
+
+        while (packet < wire.size()) {
+            auto& data = wire[packet++];
+
+            received.insert(received.end(), data.begin(), data.end());
+
+            if (data.size() < maxPacketSize)
+                break;
+        }
+
+        HOST_CHECK(received == write);
+    }
+
+    HOST_CHECK(packet == wire.size());
+}
+
+static void TestWrites(uint8_t maxPacketSize, uint32_t maxPackets) {
+    auto self = UsbClientHost_Open(maxPacketSize, TX_RING_SIZE, 256);
+
+    usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    HOST_CHECK(self != nullptr);
+
+    for (auto batch = 0; batch < 200; batch++) {
+        std::vector<std::vector<uint8_t>> writes;
+
+        wire.clear();
+
+        for (auto i = 0; i < WRITES_PER_BATCH; i++) {
+            // exact multiples of the packet size need the zero length packet
+            size_t length = rand() % 3 == 0 ? maxPacketSize * (1 + rand() % 6) : 1 + rand() % (TX_RING_SIZE / WRITES_PER_BATCH - 1);
+            std::vector<uint8_t> data(length);
+
+            for (auto& b : data)
+                b = static_cast<uint8_t>(rand());
+
+            HOST_CHECK(TinyCLR_UsbClient_WritePipe(self, 0, data.data(), length) == TinyCLR_Result::Success);
+            HOST_CHECK(length == data.size());
+
+            writes.push_back(data);
+        }
+
+        Drain(maxPackets);
+        CheckWire(writes);
+    }
+
+    UsbClientHost_Close(self);
+}
+
+// While a transfer is open only its full packets are offered, ending it releases the rest.
+static void TestOpenTransfer() {
+    auto self = UsbClientHost_Open(64, TX_RING_SIZE, 256);
+    uint8_t data[200] = { 0 };
+    size_t length = sizeof(data);
+    uint32_t size;
+
+    usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    HOST_CHECK(TinyCLR_UsbClient_WriteTransfer(self, 0, data, length, false) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_UsbClient_GetTxPacketCount(usbClientState, USBCLIENTHOST_TX_ENDPOINT, 8, size) == 3 && size == 192);
+    HOST_CHECK(TinyCLR_UsbClient_TxPeek(usbClientState, USBCLIENTHOST_TX_ENDPOINT, 3) < 0);
+
+    length = 56;
+
+    HOST_CHECK(TinyCLR_UsbClient_WriteTransfer(self, 0, data, length, true) == TinyCLR_Result::Success);
+
+    // 256 bytes, four full packets and the zero length packet as a transfer of its own
+    HOST_CHECK(TinyCLR_UsbClient_GetTxPacketCount(usbClientState, USBCLIENTHOST_TX_ENDPOINT, 8, size) == 4 && size == 256);
+    HOST_CHECK(TinyCLR_UsbClient_GetTxPacketCount(usbClientState, USBCLIENTHOST_TX_ENDPOINT, 2, size) == 2 && size == 128);
+    HOST_CHECK(TinyCLR_UsbClient_TxPeek(usbClientState, USBCLIENTHOST_TX_ENDPOINT, 4) == 0);
+
+    wire.clear();
+
+    Drain(8);
+
+    HOST_CHECK(wire.size() == 5 && wire.back().empty());
+
+    // ending a transfer with nothing queued since the last end sends nothing
+    length = 0;
+
+    HOST_CHECK(TinyCLR_UsbClient_WriteTransfer(self, 0, nullptr, length, true) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_UsbClient_GetTxPacketCount(usbClientState, USBCLIENTHOST_TX_ENDPOINT, 8, size) == 0 && size == 0);
+
+    UsbClientHost_Close(self);
+}
+
+int main() {
+    srand(1);
+
+    // the STM32 FIFO limit for 64 byte packets, one packet per transfer, and odd packet sizes
+    TestWrites(64, 4);
+    TestWrites(64, 1);
+    TestWrites(8, 32);
+    TestWrites(10, 1);
+    TestOpenTransfer();
+
+    return Host_Finish("USBClient/TxPacketTest");
+}
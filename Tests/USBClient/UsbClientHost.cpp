@@ -0,0 +1,135 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "UsbClientHost.h"
+
+static UsbClientHost_EndpointHandler usbClientHost_StartOutput;
+static UsbClientHost_EndpointHandler usbClientHost_RxEnable;
+
+static USB_ENDPOINT_BUFFER* usbClientHost_Queues[USBCLIENTHOST_ENDPOINT_COUNT];
+static uint32_t usbClientHost_QueueSizes[USBCLIENTHOST_ENDPOINT_COUNT];
+static bool usbClientHost_IsTxQueue[USBCLIENTHOST_ENDPOINT_COUNT];
+static uint8_t usbClientHost_MaxPacketSizes[USBCLIENTHOST_ENDPOINT_COUNT];
+static uint16_t usbClientHost_EndpointStatus[USBCLIENTHOST_ENDPOINT_COUNT];
+static USB_PIPE_MAP usbClientHost_Pipes[1];
+static uint64_t usbClientHost_Wakeup = USBCLIENTHOST_NO_WAKEUP;
+
+bool TinyCLR_UsbClient_StartOutput(UsbClientState* usbClientState, int32_t endpoint) {
+    return usbClientHost_StartOutput != nullptr ? usbClientHost_StartOutput(usbClientState, endpoint) : true;
+}
+
+bool TinyCLR_UsbClient_RxEnable(UsbClientState* usbClientState, int32_t endpoint) {
+    return usbClientHost_RxEnable != nullptr ? usbClientHost_RxEnable(usbClientState, endpoint) : true;
+}
+
+void TinyCLR_UsbClient_Delay(uint64_t microseconds) {
+    Host_AdvanceSystemTime(microseconds * 10);
+
+    reinterpret_cast<const TinyCLR_Interrupt_Controller*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::InterruptController))->WaitForInterrupt();
+}
+
+uint64_t TinyCLR_UsbClient_Now() {
+    return Host_GetSystemTime();
+}
+
+// like the target timer, one wake up is pending at a time and an earlier one stays
+void TinyCLR_UsbClient_ScheduleWakeup(uint64_t time) {
+    if (usbClientHost_Wakeup > Host_GetSystemTime() && usbClientHost_Wakeup <= time)
+        return;
+
+    usbClientHost_Wakeup = time;
+}
+
+// The host resets the bus as soon as the controller starts.
+bool TinyCLR_UsbClient_Initialize(UsbClientState* usbClientState) {
+    usbClientState->currentState = USB_DEVICE_STATE_DEFAULT;
+
+    return true;
+}
+
+bool TinyCLR_UsbClient_Uninitialize(UsbClientState* usbClientState) {
+    return true;
+}
+
+void TinyCLR_UsbClient_InitializeConfiguration(UsbClientState* usbClientState) {
+    usbClientState->totalEndpointsCount = USBCLIENTHOST_ENDPOINT_COUNT;
+    usbClientState->totalPipesCount = USBCLIENTHOST_ENDPOINT_COUNT;
+    usbClientState->maxFifoPacketCountDefault = 16;
+}
+
+uint32_t TinyCLR_UsbClient_GetEndpointSize(int32_t endpoint) {
+    return USB_MAX_PACKET_SIZE;
+}
+
+uint64_t UsbClientHost_GetWakeup() {
+    return usbClientHost_Wakeup;
+}
+
+void UsbClientHost_ClearWakeup() {
+    usbClientHost_Wakeup = USBCLIENTHOST_NO_WAKEUP;
+}
+
+void UsbClientHost_SetHandlers(UsbClientHost_EndpointHandler startOutput, UsbClientHost_EndpointHandler rxEnable) {
+    usbClientHost_StartOutput = startOutput;
+    usbClientHost_RxEnable = rxEnable;
+}
+
+const TinyCLR_UsbClient_Controller* UsbClientHost_Open(uint8_t maxPacketSize, uint32_t txSize, uint32_t rxSize) {
+    auto apiInfo = TinyCLR_UsbClient_GetRequiredApi();
+    auto self = reinterpret_cast<const TinyCLR_UsbClient_Controller*>(apiInfo->Implementation);
+    auto usbClientState = reinterpret_cast<UsbClientState*>(apiInfo->State);
+
+    for (auto i = 0; i < USBCLIENTHOST_ENDPOINT_COUNT; i++) {
+        usbClientHost_Queues[i] = nullptr;
+        usbClientHost_IsTxQueue[i] = false;
+        usbClientHost_MaxPacketSizes[i] = maxPacketSize;
+        usbClientHost_EndpointStatus[i] = 0;
+    }
+
+    usbClientHost_QueueSizes[USBCLIENTHOST_TX_ENDPOINT] = txSize;
+    usbClientHost_QueueSizes[USBCLIENTHOST_RX_ENDPOINT] = rxSize;
+
+    usbClientHost_Wakeup = USBCLIENTHOST_NO_WAKEUP;
+
+    usbClientHost_Pipes[0].RxEP = USB_ENDPOINT_NULL;
+    usbClientHost_Pipes[0].TxEP = USB_ENDPOINT_NULL;
+
+    usbClientState->queues = usbClientHost_Queues;
+    usbClientState->queueSize = usbClientHost_QueueSizes;
+    usbClientState->isTxQueue = usbClientHost_IsTxQueue;
+    usbClientState->maxEndpointsPacketSize = usbClientHost_MaxPacketSizes;
+    usbClientState->endpointStatus = usbClientHost_EndpointStatus;
+    usbClientState->totalEndpointsCount = USBCLIENTHOST_ENDPOINT_COUNT;
+    usbClientState->pipes = usbClientHost_Pipes;
+    usbClientState->totalPipesCount = 1;
+    usbClientState->initialized = true;
+    usbClientState->deviceState = USB_DEVICE_STATE_CONFIGURED;
+    usbClientState->currentState = USB_DEVICE_STATE_CONFIGURED;
+
+    uint32_t pipe;
+
+    if (TinyCLR_UsbClient_AllocatePipe(usbClientState, USBCLIENTHOST_TX_ENDPOINT, USBCLIENTHOST_RX_ENDPOINT, pipe) != TinyCLR_Result::Success || pipe != 0)
+        return nullptr;
+
+    return self;
+}
+
+void UsbClientHost_Close(const TinyCLR_UsbClient_Controller* self) {
+    auto usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    TinyCLR_UsbClient_ClosePipe(self, 0);
+
+    usbClientState->initialized = false;
+    usbClientState->deviceState = USB_DEVICE_STATE_DEFAULT;
+}
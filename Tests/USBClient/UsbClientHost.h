@@ -0,0 +1,40 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "../Host/Host.h"
+#include "../../Drivers/USBClient/USBClient.h"
+
+#define USBCLIENTHOST_TX_ENDPOINT 1
+#define USBCLIENTHOST_RX_ENDPOINT 2
+#define USBCLIENTHOST_ENDPOINT_COUNT 4
+#define USBCLIENTHOST_NO_WAKEUP 0xFFFFFFFFFFFFFFFFULL
+
+// Stands in for a controller driver: the hooks USBClient.cpp calls into a target for, and a configured
+// device without any enumeration for the tests that don't go through Acquire. StartOutput and RxEnable go to the handlers a test sets, which play the
+// controller; without one they do nothing.
+typedef bool(*UsbClientHost_EndpointHandler)(UsbClientState* usbClientState, int32_t endpoint);
+
+void UsbClientHost_SetHandlers(UsbClientHost_EndpointHandler startOutput, UsbClientHost_EndpointHandler rxEnable);
+
+// The system time of the timer interrupt the driver scheduled, USBCLIENTHOST_NO_WAKEUP when none is pending. The
+// test's interrupt handler raises it and clears it once the time has come.
+uint64_t UsbClientHost_GetWakeup();
+void UsbClientHost_ClearWakeup();
+
+// Opens pipe 0 writing USBCLIENTHOST_TX_ENDPOINT and reading USBCLIENTHOST_RX_ENDPOINT, with rings of the
+// given sizes. Returns the controller, whose ApiInfo->State is the UsbClientState.
+const TinyCLR_UsbClient_Controller* UsbClientHost_Open(uint8_t maxPacketSize, uint32_t txSize, uint32_t rxSize);
+void UsbClientHost_Close(const TinyCLR_UsbClient_Controller* self);
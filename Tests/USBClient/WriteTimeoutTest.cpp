@@ -0,0 +1,250 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "UsbClientHost.h"
+
+#define PACKET_SIZE 64
+#define RING_SIZE 256
+
+// Time only moves while the writer sleeps, on to the interrupt that ends the sleep: the host taking a packet or the
+// timer the driver scheduled. A sleep nothing would end gives up after HANG_TICKS and counts as a hang.
+#define FRAME_TICKS 1000
+#define HANG_TICKS 10000000
+#define TICKS_PER_MILLISECOND 10000
+
+static UsbClientState* usbClientState;
+static uint64_t hostPeriod;       // ticks between the packets the host takes, 0 when it takes none
+static uint64_t hostResume;       // the host takes nothing before this time
+static uint64_t hostNextPacket;
+static uint32_t interrupts;
+static uint32_t sleeps;
+static uint32_t wakeups;
+static uint32_t hangs;
+static uint32_t packetsTaken;
+static bool clearWhenFull;
+static bool detachWhenFull;
+
+static uint64_t Bus_NextPacket() {
+    if (hostPeriod == 0)
+        return USBCLIENTHOST_NO_WAKEUP;
+
+    return hostResume > hostNextPacket ? hostResume : hostNextPacket;
+}
+
+static void Bus_Interrupt() {
+    interrupts++;
+
+    // only once the writer is waiting for room
+    auto full = usbClientState->queues[USBCLIENTHOST_TX_ENDPOINT]->Count == RING_SIZE;
+    auto ended = false;
+
+    if (clearWhenFull && full) {
+        clearWhenFull = false;
+        ended = true;
+
+        TinyCLR_UsbClient_ClearEndpoints(usbClientState, USBCLIENTHOST_TX_ENDPOINT);
+    }
+
+    if (detachWhenFull && full) {
+        detachWhenFull = false;
+        ended = true;
+
+        usbClientState->deviceState = USB_DEVICE_STATE_DEFAULT;
+    }
+
+    auto now = Host_GetSystemTime();
+
+    if (Host_IsWaitingForInterrupt() && !ended) {
+        // the flag checks and the sleep are one step, or an interrupt between them is lost
+        HOST_CHECK(Host_IsWaitMasked());
+
+        auto next = Bus_NextPacket();
+
+        if (UsbClientHost_GetWakeup() < next)
+            next = UsbClientHost_GetWakeup();
+
+        if (next == USBCLIENTHOST_NO_WAKEUP) {
+            hangs++;
+            next = now + HANG_TICKS;
+        }
+
+        if (next > now)
+            Host_AdvanceSystemTime(next - now);
+
+        now = Host_GetSystemTime();
+        sleeps++;
+    }
+
+    if (UsbClientHost_GetWakeup() <= now) {
+        UsbClientHost_ClearWakeup();
+
+        wakeups++;
+    }
+
+    if (Bus_NextPacket() > now)
+        return;
+
+    uint32_t size;
+
+    if (TinyCLR_UsbClient_TxDequeue(usbClientState, USBCLIENTHOST_TX_ENDPOINT, size) != nullptr) {
+        packetsTaken++;
+        hostNextPacket = now + hostPeriod;
+    }
+}
+
+static const TinyCLR_UsbClient_Controller* Open(uint32_t timeout, uint64_t period) {
+    auto self = UsbClientHost_Open(PACKET_SIZE, RING_SIZE, PACKET_SIZE * 2);
+
+    usbClientState = reinterpret_cast<UsbClientState*>(self->ApiInfo->State);
+
+    HOST_CHECK(TinyCLR_UsbClient_SetWriteTimeout(self, 0, timeout) == TinyCLR_Result::Success);
+    HOST_CHECK(TinyCLR_UsbClient_GetWriteTimeout(self, 0) == timeout);
+
+    hostPeriod = period;
+    hostResume = 0;
+    hostNextPacket = 0;
+    interrupts = 0;
+    sleeps = 0;
+    wakeups = 0;
+    hangs = 0;
+    packetsTaken = 0;
+
+    Host_SetInterruptHandler(&Bus_Interrupt);
+
+    return self;
+}
+
+static void Close(const TinyCLR_UsbClient_Controller* self) {
+    Host_SetInterruptHandler(nullptr);
+
+    UsbClientHost_Close(self);
+}
+
+static size_t Write(const TinyCLR_UsbClient_Controller* self, size_t length, uint64_t& elapsed) {
+    static uint8_t data[4096];
+    auto start = Host_GetSystemTime();
+
+    HOST_CHECK(TinyCLR_UsbClient_WritePipe(self, 0, data, length) == TinyCLR_Result::Success);
+
+    elapsed = Host_GetSystemTime() - start;
+
+    return length;
+}
+
+// A non-blocking pipe queues what fits and returns without waiting; the only interrupts are the ones
+// taken while it copied with interrupts on and as it returned.
+static void TestNoTimeout() {
+    auto self = Open(USB_WRITE_TIMEOUT_NONE, 0);
+    uint64_t elapsed;
+
+    HOST_CHECK(Write(self, 1000, elapsed) == RING_SIZE);
+    HOST_CHECK(interrupts == 2);
+
+    Close(self);
+}
+
+// With the host gone nothing but the timer it scheduled wakes the write, once, when the timeout runs out.
+static void TestStalledHost() {
+    auto self = Open(5, 0);
+    uint64_t elapsed;
+
+    HOST_CHECK(Write(self, 1000, elapsed) == RING_SIZE);
+    HOST_CHECK(elapsed == 5 * TICKS_PER_MILLISECOND);
+    HOST_CHECK(sleeps == 1 && wakeups == 1 && hangs == 0);
+
+    Close(self);
+}
+
+// The timeout counts from the last progress: a host slower than the whole write but faster than the
+// timeout per packet still gets all of it.
+static void TestSlowHost() {
+    auto self = Open(5, 4 * TICKS_PER_MILLISECOND);
+    uint64_t elapsed;
+
+    HOST_CHECK(Write(self, 1000, elapsed) == 1000);
+    HOST_CHECK(elapsed > 5 * TICKS_PER_MILLISECOND);
+    HOST_CHECK(hangs == 0);
+
+    Close(self);
+
+    // one slower than the timeout gets what fit before the write gave up
+    self = Open(5, 6 * TICKS_PER_MILLISECOND);
+
+    auto written = Write(self, 1000, elapsed);
+
+    HOST_CHECK(written >= RING_SIZE && written < 1000);
+    HOST_CHECK(written <= RING_SIZE + packetsTaken * PACKET_SIZE);
+    HOST_CHECK(wakeups == 1 && hangs == 0);
+
+    Close(self);
+}
+
+static void TestInfiniteTimeout() {
+    auto self = Open(USB_WRITE_TIMEOUT_INFINITE, FRAME_TICKS);
+    uint64_t elapsed;
+
+    hostResume = Host_GetSystemTime() + 50 * TICKS_PER_MILLISECOND;
+
+    HOST_CHECK(Write(self, 4096, elapsed) == 4096);
+    HOST_CHECK(elapsed >= 50 * TICKS_PER_MILLISECOND);
+    HOST_CHECK(UsbClientHost_GetWakeup() == USBCLIENTHOST_NO_WAKEUP && hangs == 0);
+
+    Close(self);
+}
+
+// Without interrupts nothing can drain the ring, so the write can't wait for the host.
+static void TestInterruptsDisabled() {
+    auto self = Open(USB_WRITE_TIMEOUT_INFINITE, FRAME_TICKS);
+    uint64_t elapsed;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        HOST_CHECK(Write(self, 1000, elapsed) == RING_SIZE);
+        HOST_CHECK(elapsed == 0 && interrupts == 0);
+    }
+
+    Close(self);
+}
+
+// A write waiting for the host gives up when the endpoint is cleared or the device leaves the configured
+// state, and leaves no transfer open behind it.
+static void TestEndedWhileWaiting() {
+    auto self = Open(USB_WRITE_TIMEOUT_INFINITE, 0);
+    auto buffer = usbClientState->queues[USBCLIENTHOST_TX_ENDPOINT];
+    uint64_t elapsed;
+
+    clearWhenFull = true;
+
+    HOST_CHECK(Write(self, 1000, elapsed) == RING_SIZE);
+    HOST_CHECK(buffer->Count == 0 && buffer->TransferCount == 0 && !buffer->TransferOpen);
+
+    detachWhenFull = true;
+
+    HOST_CHECK(Write(self, 1000, elapsed) == RING_SIZE);
+    HOST_CHECK(!buffer->TransferOpen);
+
+    Close(self);
+}
+
+int main() {
+    TestNoTimeout();
+    TestStalledHost();
+    TestSlowHost();
+    TestInfiniteTimeout();
+    TestInterruptsDisabled();
+    TestEndedWhileWaiting();
+
+    return Host_Finish("USBClient/WriteTimeoutTest");
+}